@@ -0,0 +1,195 @@
+#include "AllocationTrace.h"
+#include "Allocator.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+static const uint32_t TRACE_FILE_MAGIC = 0x43525441; // "ATRC"
+static const uint32_t TRACE_FILE_VERSION = 1;
+static const size_t TRACE_PROBE_GRANULARITY = 16;     // How close the largest free block search gets
+
+static double percentile(std::vector<double>& samples, double fraction)
+{
+	if (samples.empty())
+		return 0.0;
+
+	size_t index = std::min(samples.size() - 1, (size_t)(samples.size() * fraction));
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+AllocationTrace::AllocationTrace()
+	: _next_id(0)
+{
+}
+
+void AllocationTrace::recordAllocate(const void* p, size_t size, uint8_t alignment)
+{
+	const uint32_t id = _next_id++;
+	_live_ids[p] = id;
+	_events.push_back({ id, (uint32_t)size, alignment });
+}
+
+void AllocationTrace::recordDeallocate(const void* p)
+{
+	// Memory allocated before recording started has nothing to pair with
+	auto it = _live_ids.find(p);
+	if (it == _live_ids.end())
+		return;
+
+	_events.push_back({ it->second, 0, 0 });
+	_live_ids.erase(it);
+}
+
+bool AllocationTrace::save(const std::string& filePath) const
+{
+	std::ofstream file(filePath.c_str(), std::ios::out | std::ios::binary);
+	if (!file.is_open())
+	{
+		Log::Error("[AllocationTrace] Failed to open %s for writing", filePath.c_str());
+		return false;
+	}
+
+	const uint32_t numEvents = (uint32_t)_events.size();
+	file.write((const char*)&TRACE_FILE_MAGIC, sizeof(uint32_t));
+	file.write((const char*)&TRACE_FILE_VERSION, sizeof(uint32_t));
+	file.write((const char*)&numEvents, sizeof(uint32_t));
+	for (const AllocationEvent& event : _events)
+	{
+		file.write((const char*)&event.id, sizeof(uint32_t));
+		file.write((const char*)&event.size, sizeof(uint32_t));
+		file.write((const char*)&event.alignment, sizeof(uint8_t));
+	}
+	return file.good();
+}
+
+bool AllocationTrace::load(const std::string& filePath)
+{
+	std::ifstream file(filePath.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		Log::Error("[AllocationTrace] Failed to open %s", filePath.c_str());
+		return false;
+	}
+
+	uint32_t magic = 0, version = 0, numEvents = 0;
+	file.read((char*)&magic, sizeof(uint32_t));
+	file.read((char*)&version, sizeof(uint32_t));
+	file.read((char*)&numEvents, sizeof(uint32_t));
+	if (!file.good() || magic != TRACE_FILE_MAGIC || version != TRACE_FILE_VERSION)
+	{
+		Log::Error("[AllocationTrace] %s is not an allocation trace", filePath.c_str());
+		return false;
+	}
+
+	_events.clear();
+	_live_ids.clear();
+	_next_id = 0;
+	_events.resize(numEvents);
+	for (AllocationEvent& event : _events)
+	{
+		file.read((char*)&event.id, sizeof(uint32_t));
+		file.read((char*)&event.size, sizeof(uint32_t));
+		file.read((char*)&event.alignment, sizeof(uint8_t));
+		_next_id = std::max(_next_id, event.id + 1);
+	}
+	if (!file.good())
+	{
+		Log::Error("[AllocationTrace] %s ends early", filePath.c_str());
+		_events.clear();
+		return false;
+	}
+	return true;
+}
+
+size_t AllocationTrace::getPeakRequestedSize() const
+{
+	std::unordered_map<uint32_t, uint32_t> liveSizes;
+	size_t requested = 0, peak = 0;
+	for (const AllocationEvent& event : _events)
+	{
+		if (event.size != 0)
+		{
+			liveSizes[event.id] = event.size;
+			requested += event.size;
+			peak = std::max(peak, requested);
+		}
+		else
+		{
+			requested -= liveSizes[event.id];
+			liveSizes.erase(event.id);
+		}
+	}
+	return peak;
+}
+
+AllocationReplayResult AllocationTrace::replay(Allocator& allocator) const
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	AllocationReplayResult result = {};
+	std::vector<void*> pointers(_next_id, nullptr);
+	std::vector<double> allocateTimes, deallocateTimes;
+
+	for (const AllocationEvent& event : _events)
+	{
+		if (event.size != 0)
+		{
+			const Clock::time_point start = Clock::now();
+			void* p = allocator.allocate(event.size, event.alignment);
+			allocateTimes.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+			pointers[event.id] = p;
+			result.numAllocations++;
+			if (p == nullptr)
+				result.numFailed++;
+
+			result.peakUsedMemory = std::max(result.peakUsedMemory, allocator.getUsedMemory());
+		}
+		else if (pointers[event.id] != nullptr)
+		{
+			const Clock::time_point start = Clock::now();
+			allocator.deallocate(pointers[event.id]);
+			deallocateTimes.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+			pointers[event.id] = nullptr;
+			result.numDeallocations++;
+		}
+	}
+
+	result.allocateMedianNs = percentile(allocateTimes, 0.5);
+	result.allocate99thNs = percentile(allocateTimes, 0.99);
+	result.allocateMaxNs = allocateTimes.empty() ? 0.0 : *std::max_element(allocateTimes.begin(), allocateTimes.end());
+	result.deallocateMedianNs = percentile(deallocateTimes, 0.5);
+	result.deallocate99thNs = percentile(deallocateTimes, 0.99);
+	result.deallocateMaxNs = deallocateTimes.empty() ? 0.0 : *std::max_element(deallocateTimes.begin(), deallocateTimes.end());
+
+	// Search for the largest allocation that still fits
+	result.freeMemory = allocator.getSize() - allocator.getUsedMemory();
+	size_t fits = 0, doesNotFit = result.freeMemory + 1;
+	while (doesNotFit - fits > TRACE_PROBE_GRANULARITY)
+	{
+		const size_t size = fits + (doesNotFit - fits) / 2;
+		void* p = allocator.allocate(size);
+		if (p != nullptr)
+		{
+			allocator.deallocate(p);
+			fits = size;
+		}
+		else
+		{
+			doesNotFit = size;
+		}
+	}
+	result.largestFreeBlock = fits;
+	result.fragmentation = result.freeMemory > 0 ? 1.f - (float)fits / (float)result.freeMemory : 0.f;
+
+	for (void* p : pointers)
+	{
+		if (p != nullptr)
+			allocator.deallocate(p);
+	}
+
+	return result;
+}
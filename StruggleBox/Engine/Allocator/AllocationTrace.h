@@ -0,0 +1,61 @@
+#pragma once
+
+// Recording of the allocations and deallocations an allocator served, in order.
+// Saved traces can be replayed against any allocator to compare how fast it serves
+// the same requests and how fragmented it leaves its memory.
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Allocator;
+
+struct AllocationEvent
+{
+	uint32_t id;            // Pairs a deallocation with its allocation
+	uint32_t size;          // Zero for deallocations
+	uint8_t alignment;
+};
+
+struct AllocationReplayResult
+{
+	size_t numAllocations;
+	size_t numDeallocations;
+	size_t numFailed;               // Allocations the allocator couldn't fit
+	size_t peakUsedMemory;
+	double allocateMedianNs;
+	double allocate99thNs;
+	double allocateMaxNs;
+	double deallocateMedianNs;
+	double deallocate99thNs;
+	double deallocateMaxNs;
+	size_t freeMemory;              // Left at the end of the trace, with its live allocations still held
+	size_t largestFreeBlock;
+	float fragmentation;            // 0 when all free memory is one block, towards 1 as it splinters
+};
+
+class AllocationTrace
+{
+public:
+	AllocationTrace();
+
+	// Called by the allocator being recorded, while it holds its lock
+	void recordAllocate(const void* p, size_t size, uint8_t alignment);
+	void recordDeallocate(const void* p);
+
+	bool save(const std::string& filePath) const;
+	bool load(const std::string& filePath);
+
+	// Largest sum of requested bytes alive at once
+	size_t getPeakRequestedSize() const;
+	size_t getNumEvents() const { return _events.size(); }
+
+	// Replays every event against the allocator, then frees whatever the trace left alive
+	AllocationReplayResult replay(Allocator& allocator) const;
+
+private:
+	std::vector<AllocationEvent> _events;
+	std::unordered_map<const void*, uint32_t> _live_ids;    // Only while recording
+	uint32_t _next_id;
+};
@@ -11,6 +11,7 @@
 
 #include "PointerMath.h"
 #include "Log.h"
+#include "MemoryTracker.h"
 #include <cstdint>
 #include <cassert>
 #include <new>
@@ -38,6 +39,12 @@ public:
 	virtual void* allocate(size_t size, uint8_t alignment = 4) = 0;
 	virtual void deallocate(void* p) = 0;
 
+	// Bytes the block at p takes up, 0 when the allocator can't tell
+	virtual size_t getAllocationSize(const void* p) const
+	{
+		return 0;
+	}
+
 	void* getStart() const
 	{
 		return _start;
@@ -61,9 +68,10 @@ public:
 #ifdef _DEBUG
 	void* allocateDebug(size_t size, const char* file, int line, uint8_t alignment = 4)
 	{
+		// Picked up by the memory tracker when the core allocator serves the request
+		MemoryTracker::SetCallSite(file, line);
 		void* result = allocate(size, alignment);
-		//Log::Info("[%s, line %i] Allocated %zub at: %p", file, line, size, result);
-		//printf("[%s, line %i] Allocated %zub at: %p\n", file, line, size, result);
+		MemoryTracker::SetCallSite(nullptr, 0);
 		return result;
 	}
 	void deallocateDebug(void* p, const char* file, int line)
@@ -0,0 +1,298 @@
+#include "MemoryTracker.h"
+
+const char* GetMemoryTagName(const MemoryTag tag)
+{
+	switch (tag)
+	{
+	case MemoryTag::General: return "General";
+	case MemoryTag::Renderer: return "Renderer";
+	case MemoryTag::Voxels: return "Voxels";
+	case MemoryTag::Physics: return "Physics";
+	case MemoryTag::Entities: return "Entities";
+	case MemoryTag::Particles: return "Particles";
+	case MemoryTag::GUI: return "GUI";
+	default: return "Unknown";
+	}
+}
+
+#ifdef MEMORY_TRACKING
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const size_t NUM_TAGS = (size_t)MemoryTag::Count;
+static const size_t NUM_LIVE_SHARDS = 16;           // Live allocations are split by address so threads rarely share a lock
+static const size_t MAX_LEAK_SITES_REPORTED = 32;
+
+struct AllocationRecord
+{
+	size_t size;
+	MemoryTag tag;
+	const char* file;           // Only with call site capture on
+	int line;
+};
+
+struct TagStats
+{
+	std::atomic<size_t> currentBytes;
+	std::atomic<size_t> peakBytes;
+	std::atomic<size_t> currentCount;
+	std::atomic<size_t> totalCount;
+	std::atomic<size_t> histogram[MemoryTracker::NUM_SIZE_BUCKETS];
+};
+
+struct LiveShard
+{
+	std::mutex mutex;
+	std::unordered_map<const void*, AllocationRecord> records;
+};
+
+// Zero initialized before any allocator can run, and never destroyed before the heap is
+static TagStats s_tagStats[NUM_TAGS];
+static LiveShard& getShard(const void* p)
+{
+	static LiveShard shards[NUM_LIVE_SHARDS];
+	return shards[((uintptr_t)p >> 4) % NUM_LIVE_SHARDS];
+}
+
+static std::atomic<bool> s_captureCallSites(false);
+static thread_local MemoryTag t_currentTag = MemoryTag::General;
+static thread_local bool t_allocatorTagClaimed = false;
+static thread_local const char* t_callSiteFile = nullptr;
+static thread_local int t_callSiteLine = 0;
+
+static size_t getSizeBucket(size_t size)
+{
+	size_t bucket = 0;
+	size_t bucketSize = 16;
+	while (size > bucketSize && bucket < MemoryTracker::NUM_SIZE_BUCKETS - 1)
+	{
+		bucketSize <<= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+static std::string formatBytes(size_t bytes)
+{
+	char buffer[32];
+	if (bytes >= 1024 * 1024)
+		snprintf(buffer, sizeof(buffer), "%.2fMB", bytes / (1024.0 * 1024.0));
+	else if (bytes >= 1024)
+		snprintf(buffer, sizeof(buffer), "%.2fKB", bytes / 1024.0);
+	else
+		snprintf(buffer, sizeof(buffer), "%zuB", bytes);
+	return buffer;
+}
+
+void MemoryTracker::OnAllocate(const void* p, const size_t size)
+{
+	const bool captureCallSite = s_captureCallSites.load(std::memory_order_relaxed);
+	const AllocationRecord record = {
+		size,
+		t_currentTag,
+		captureCallSite ? t_callSiteFile : nullptr,
+		captureCallSite ? t_callSiteLine : 0 };
+
+	LiveShard& shard = getShard(p);
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		shard.records[p] = record;
+	}
+
+	TagStats& stats = s_tagStats[(size_t)record.tag];
+	const size_t currentBytes = stats.currentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+	size_t peakBytes = stats.peakBytes.load(std::memory_order_relaxed);
+	while (currentBytes > peakBytes && !stats.peakBytes.compare_exchange_weak(peakBytes, currentBytes, std::memory_order_relaxed))
+	{
+	}
+	stats.currentCount.fetch_add(1, std::memory_order_relaxed);
+	stats.totalCount.fetch_add(1, std::memory_order_relaxed);
+	stats.histogram[getSizeBucket(size)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryTracker::OnDeallocate(const void* p)
+{
+	AllocationRecord record;
+	LiveShard& shard = getShard(p);
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto it = shard.records.find(p);
+		if (it == shard.records.end())
+		{
+			return;
+		}
+		record = it->second;
+		shard.records.erase(it);
+	}
+
+	TagStats& stats = s_tagStats[(size_t)record.tag];
+	stats.currentBytes.fetch_sub(record.size, std::memory_order_relaxed);
+	stats.currentCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+MemoryTag MemoryTracker::SetCurrentTag(const MemoryTag tag)
+{
+	const MemoryTag previous = t_currentTag;
+	t_currentTag = tag;
+	return previous;
+}
+
+bool MemoryTracker::ClaimAllocatorTag(const MemoryTag tag, MemoryTag& previous)
+{
+	previous = t_currentTag;
+	if (t_allocatorTagClaimed)
+	{
+		return false;
+	}
+	t_allocatorTagClaimed = true;
+	t_currentTag = tag;
+	return true;
+}
+
+void MemoryTracker::ReleaseAllocatorTag(const MemoryTag previous)
+{
+	t_currentTag = previous;
+	t_allocatorTagClaimed = false;
+}
+
+void MemoryTracker::SetCallSite(const char* file, const int line)
+{
+	t_callSiteFile = file;
+	t_callSiteLine = line;
+}
+
+void MemoryTracker::SetCaptureCallSites(const bool capture)
+{
+	s_captureCallSites.store(capture, std::memory_order_relaxed);
+	Log::Info("[MemoryTracker] Call site capture %s", capture ? "on" : "off");
+}
+
+MemoryTagStats MemoryTracker::GetTagStats(const MemoryTag tag)
+{
+	const TagStats& stats = s_tagStats[(size_t)tag];
+	MemoryTagStats result;
+	result.currentBytes = stats.currentBytes.load(std::memory_order_relaxed);
+	result.peakBytes = stats.peakBytes.load(std::memory_order_relaxed);
+	result.currentCount = stats.currentCount.load(std::memory_order_relaxed);
+	result.totalCount = stats.totalCount.load(std::memory_order_relaxed);
+	for (size_t bucket = 0; bucket < NUM_SIZE_BUCKETS; bucket++)
+	{
+		result.histogram[bucket] = stats.histogram[bucket].load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+void MemoryTracker::ResetPeak(const MemoryTag tag)
+{
+	TagStats& stats = s_tagStats[(size_t)tag];
+	stats.peakBytes.store(stats.currentBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void MemoryTracker::LogReport()
+{
+	Log::Info("[MemoryTracker] %-10s %12s %12s %10s %10s", "Tag", "Current", "Peak", "Live", "Total");
+	for (size_t tag = 0; tag < NUM_TAGS; tag++)
+	{
+		const TagStats& stats = s_tagStats[tag];
+		Log::Info("[MemoryTracker] %-10s %12s %12s %10zu %10zu",
+			GetMemoryTagName((MemoryTag)tag),
+			formatBytes(stats.currentBytes.load(std::memory_order_relaxed)).c_str(),
+			formatBytes(stats.peakBytes.load(std::memory_order_relaxed)).c_str(),
+			stats.currentCount.load(std::memory_order_relaxed),
+			stats.totalCount.load(std::memory_order_relaxed));
+	}
+
+	for (size_t tag = 0; tag < NUM_TAGS; tag++)
+	{
+		const TagStats& stats = s_tagStats[tag];
+		if (stats.totalCount.load(std::memory_order_relaxed) == 0)
+			continue;
+
+		std::string histogram;
+		for (size_t bucket = 0; bucket < NUM_SIZE_BUCKETS; bucket++)
+		{
+			const size_t count = stats.histogram[bucket].load(std::memory_order_relaxed);
+			if (count == 0)
+				continue;
+
+			// The last bucket holds everything bigger than the one before it
+			if (bucket == NUM_SIZE_BUCKETS - 1)
+				histogram += ">" + formatBytes((size_t)16 << (bucket - 1));
+			else
+				histogram += "<=" + formatBytes((size_t)16 << bucket);
+			histogram += ":" + std::to_string(count) + " ";
+		}
+		Log::Info("[MemoryTracker] %s sizes: %s", GetMemoryTagName((MemoryTag)tag), histogram.c_str());
+	}
+}
+
+void MemoryTracker::LogLeaks()
+{
+	struct LeakSite
+	{
+		size_t count;
+		size_t bytes;
+	};
+
+	size_t leakedCount[NUM_TAGS] = {};
+	size_t leakedBytes[NUM_TAGS] = {};
+	std::map<std::string, LeakSite> sites;
+
+	for (size_t i = 0; i < NUM_LIVE_SHARDS; i++)
+	{
+		// Every address in a shard maps back to it, so any pointer picks the right one
+		LiveShard& shard = getShard((const void*)(i << 4));
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (const auto& pair : shard.records)
+		{
+			const AllocationRecord& record = pair.second;
+			leakedCount[(size_t)record.tag]++;
+			leakedBytes[(size_t)record.tag] += record.size;
+
+			std::string site = std::string(GetMemoryTagName(record.tag)) + " ";
+			site += record.file ? std::string(record.file) + ":" + std::to_string(record.line) : "unknown call site";
+			LeakSite& leakSite = sites[site];
+			leakSite.count++;
+			leakSite.bytes += record.size;
+		}
+	}
+
+	size_t totalCount = 0;
+	for (size_t tag = 0; tag < NUM_TAGS; tag++)
+	{
+		totalCount += leakedCount[tag];
+	}
+	if (totalCount == 0)
+	{
+		Log::Info("[MemoryTracker] No leaks");
+		return;
+	}
+
+	for (size_t tag = 0; tag < NUM_TAGS; tag++)
+	{
+		if (leakedCount[tag] != 0)
+		{
+			Log::Error("[MemoryTracker] %s leaked %zu allocations, %s", GetMemoryTagName((MemoryTag)tag), leakedCount[tag], formatBytes(leakedBytes[tag]).c_str());
+		}
+	}
+
+	std::vector<std::pair<std::string, LeakSite>> sortedSites(sites.begin(), sites.end());
+	std::sort(sortedSites.begin(), sortedSites.end(), [](const std::pair<std::string, LeakSite>& a, const std::pair<std::string, LeakSite>& b) {
+		return a.second.bytes > b.second.bytes;
+	});
+	for (size_t i = 0; i < sortedSites.size() && i < MAX_LEAK_SITES_REPORTED; i++)
+	{
+		Log::Error("[MemoryTracker]   %s: %zu allocations, %s", sortedSites[i].first.c_str(), sortedSites[i].second.count, formatBytes(sortedSites[i].second.bytes).c_str());
+	}
+	if (!s_captureCallSites.load(std::memory_order_relaxed))
+	{
+		Log::Info("[MemoryTracker] Turn on call site capture with memcallsites 1 to see where leaks were allocated");
+	}
+}
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+
+// Tracks every live allocation made through the core allocator by the subsystem that owns it.
+// Keeps current use, high-water mark and a size histogram per memory tag, and on shutdown reports
+// whatever is still allocated, grouped by the CUSTOM_NEW call site when call site capture is on.
+// The owner is the first TaggedAllocator or ProxyAllocator a request passes through, or else the
+// innermost MemoryTagScope on the allocating thread.
+// Only compiled into debug builds, in release the scopes are empty and nothing is tracked.
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _DEBUG
+#define MEMORY_TRACKING
+#endif
+
+enum class MemoryTag : uint8_t
+{
+	General,
+	Renderer,
+	Voxels,
+	Physics,
+	Entities,
+	Particles,
+	GUI,
+	Count
+};
+
+#ifdef MEMORY_TRACKING
+struct MemoryTagStats;
+
+class MemoryTracker
+{
+public:
+	static const size_t NUM_SIZE_BUCKETS = 17;      // Powers of two from 16 bytes to 512KB, then everything larger
+
+	// Called by the core allocator for every allocation it serves
+	static void OnAllocate(const void* p, const size_t size);
+	static void OnDeallocate(const void* p);
+
+	// Return the previous value, so scopes can restore it
+	static MemoryTag SetCurrentTag(const MemoryTag tag);
+	// Only the first allocator in a chain gets to set the tag, returns false if another one already did
+	static bool ClaimAllocatorTag(const MemoryTag tag, MemoryTag& previous);
+	static void ReleaseAllocatorTag(const MemoryTag previous);
+	static void SetCallSite(const char* file, const int line);
+
+	// Off by default, only allocations made while it's on remember where they came from
+	static void SetCaptureCallSites(const bool capture);
+
+	static MemoryTagStats GetTagStats(const MemoryTag tag);
+	// Starts a new high-water mark from what the tag uses now
+	static void ResetPeak(const MemoryTag tag);
+
+	// Current use, high-water mark and size histogram of every tag
+	static void LogReport();
+	// Every allocation still alive, meant for shutdown once everything should be freed
+	static void LogLeaks();
+};
+
+struct MemoryTagStats
+{
+	size_t currentBytes;
+	size_t peakBytes;
+	size_t currentCount;
+	size_t totalCount;
+	size_t histogram[MemoryTracker::NUM_SIZE_BUCKETS];     // Allocations ever made in each size bucket
+};
+#endif
+
+class MemoryTagScope
+{
+public:
+#ifdef MEMORY_TRACKING
+	explicit MemoryTagScope(const MemoryTag tag) : _previous(MemoryTracker::SetCurrentTag(tag)) {}
+	~MemoryTagScope() { MemoryTracker::SetCurrentTag(_previous); }
+private:
+	MemoryTag _previous;
+#else
+	explicit MemoryTagScope(const MemoryTag) {}
+#endif
+};
+
+// Opened by allocators around everything they forward
+class AllocatorTagScope
+{
+public:
+#ifdef MEMORY_TRACKING
+	explicit AllocatorTagScope(const MemoryTag tag) : _claimed(MemoryTracker::ClaimAllocatorTag(tag, _previous)) {}
+	~AllocatorTagScope() { if (_claimed) MemoryTracker::ReleaseAllocatorTag(_previous); }
+private:
+	MemoryTag _previous;
+	bool _claimed;
+#else
+	explicit AllocatorTagScope(const MemoryTag) {}
+#endif
+};
+
+const char* GetMemoryTagName(const MemoryTag tag);
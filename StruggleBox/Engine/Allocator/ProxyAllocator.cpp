@@ -1,9 +1,10 @@
 #include "ProxyAllocator.h"
 
-ProxyAllocator::ProxyAllocator(Allocator& allocator)
+ProxyAllocator::ProxyAllocator(Allocator& allocator, MemoryTag tag)
 	: Allocator(allocator.getSize()
 	, allocator.getStart())
 	, _allocator(allocator)
+	, _tag(tag)
 {}
 
 ProxyAllocator::~ProxyAllocator()
@@ -18,9 +19,13 @@ void* ProxyAllocator::allocate(size_t size, uint8_t alignment)
 
 	const size_t mem = _allocator.getUsedMemory();
 
+	AllocatorTagScope tagScope(_tag);
 	void* p = _allocator.allocate(size, alignment);
 
-	_used_memory += _allocator.getUsedMemory() - mem;
+	// Allocators with per thread caches only update their used memory when stats are collected,
+	// so the block size is used when the parent can report it
+	const size_t blockSize = p != nullptr ? _allocator.getAllocationSize(p) : 0;
+	_used_memory += blockSize != 0 ? blockSize : _allocator.getUsedMemory() - mem;
 
 	return p;
 }
@@ -31,9 +36,15 @@ void ProxyAllocator::deallocate(void* p)
 
 	_num_allocations--;
 
+	const size_t blockSize = _allocator.getAllocationSize(p);
 	const size_t mem = _allocator.getUsedMemory();
 
 	_allocator.deallocate(p);
 
-	_used_memory -= mem - _allocator.getUsedMemory();
+	_used_memory -= blockSize != 0 ? blockSize : mem - _allocator.getUsedMemory();
+}
+
+size_t ProxyAllocator::getAllocationSize(const void* p) const
+{
+	return _allocator.getAllocationSize(p);
 }
\ No newline at end of file
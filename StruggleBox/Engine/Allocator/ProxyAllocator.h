@@ -11,31 +11,34 @@
 // If you want to show in the debugging user interface how much memory each subsystem is using you create a proxy allocator,
 // that redirects all allocations / deallocations to A in each subsystem and track their memory usage.
 // It will also help in memory leak tracking because the assert in the proxy allocator destructor of the subsystem that is leaking memory will fail.
+// Everything it forwards is attributed to its memory tag in debug builds.
 
 class ProxyAllocator : public Allocator
 {
 public:
-	ProxyAllocator(Allocator& allocator);
+	ProxyAllocator(Allocator& allocator, MemoryTag tag = MemoryTag::General);
 	~ProxyAllocator();
 
 	void* allocate(size_t size, uint8_t alignment = 4) override;
 		
 	void deallocate(void* p) override;
+	size_t getAllocationSize(const void* p) const override;
 
 private:
 	ProxyAllocator(const ProxyAllocator&); //Prevent copies because it might cause errors
 	ProxyAllocator& operator=(const ProxyAllocator&);
 
 	Allocator& _allocator;
+	const MemoryTag _tag;
 	std::mutex _mutex;
 };
 
 namespace allocator
 {
-	inline ProxyAllocator* newProxyAllocator(Allocator& allocator)
+	inline ProxyAllocator* newProxyAllocator(Allocator& allocator, MemoryTag tag = MemoryTag::General)
 	{
 		void* p = allocator.allocate(sizeof(ProxyAllocator), __alignof(ProxyAllocator));
-		return new (p) ProxyAllocator(allocator);
+		return new (p) ProxyAllocator(allocator, tag);
 	}
 
 	inline void deleteProxyAllocator(ProxyAllocator& proxyAllocator, Allocator& allocator)
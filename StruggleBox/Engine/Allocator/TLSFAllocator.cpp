@@ -0,0 +1,457 @@
+#include "TLSFAllocator.h"
+#include "AllocationTrace.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit, word must not be zero
+static size_t findFirstSet(uint32_t word)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, word);
+	return index;
+#else
+	return __builtin_ctz(word);
+#endif
+}
+
+// Index of the highest set bit, size must not be zero
+static size_t findLastSet(size_t size)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+#ifdef _WIN64
+	_BitScanReverse64(&index, size);
+#else
+	_BitScanReverse(&index, size);
+#endif
+	return index;
+#else
+	return 63 - __builtin_clzll(size);
+#endif
+}
+
+static size_t alignUp(size_t size, size_t alignment)
+{
+	return (size + (alignment - 1)) & ~(alignment - 1);
+}
+
+TLSFAllocator::TLSFAllocator(size_t size, void* start)
+	: TLSFAllocator(size, start, size)
+{
+}
+
+TLSFAllocator::TLSFAllocator(size_t size, void* start, size_t committed_size)
+	: Allocator(size, start)
+	, _fl_bitmap(0)
+	, _trace(nullptr)
+	, _sentinel(nullptr)
+	, _committed_end(pointer_math::add(start, committed_size))
+	, _reserved_end(pointer_math::add(start, size))
+	, _committed_size(committed_size)
+	, _growable(committed_size < size)
+	, _huge_pages(false)
+	, _num_contended_locks(0)
+{
+	for (size_t fl = 0; fl < FL_INDEX_COUNT; fl++)
+	{
+		_sl_bitmap[fl] = 0;
+		for (size_t sl = 0; sl < SL_INDEX_COUNT; sl++)
+			_free_blocks[fl][sl] = nullptr;
+	}
+
+	// One free block spanning the committed pool, followed by an empty used block
+	// so the last real block never has to check for the end of the pool
+	uint8_t adjustment = pointer_math::alignForwardAdjustment(start, ALIGN_SIZE);
+	assert(committed_size <= size && committed_size > adjustment + 2 * BLOCK_OVERHEAD + BLOCK_SIZE_MIN);
+	assert(size - adjustment < ((size_t)1 << FL_INDEX_MAX) && "TLSFAllocator pool too large");
+
+	size_t pool_size = (committed_size - adjustment - 2 * BLOCK_OVERHEAD) & ~(ALIGN_SIZE - 1);
+
+	BlockHeader* block = (BlockHeader*)pointer_math::add(start, adjustment);
+	block->prevPhysical = nullptr;
+	block->size = pool_size;
+
+	BlockHeader* sentinel = nextPhysical(block);
+	sentinel->prevPhysical = block;
+	sentinel->size = 0;
+	_sentinel = sentinel;
+
+	block->size |= BLOCK_FREE_BIT;
+	insertFreeBlock(block);
+}
+
+TLSFAllocator::~TLSFAllocator()
+{
+	_fl_bitmap = 0;
+}
+
+void* TLSFAllocator::allocate(size_t size, uint8_t alignment)
+{
+	std::unique_lock<std::mutex> lock = acquireLock();
+
+	return allocateLocked(size, alignment);
+}
+
+void TLSFAllocator::deallocate(void* p)
+{
+	std::unique_lock<std::mutex> lock = acquireLock();
+
+	deallocateLocked(p);
+}
+
+size_t TLSFAllocator::allocateBatch(size_t size, size_t count, void** blocks)
+{
+	std::unique_lock<std::mutex> lock = acquireLock();
+
+	size_t allocated = 0;
+	while (allocated < count)
+	{
+		void* p = allocateLocked(size, ALIGN_SIZE);
+		if (p == nullptr)
+			break;
+
+		blocks[allocated++] = p;
+	}
+	return allocated;
+}
+
+void TLSFAllocator::deallocateBatch(void** blocks, size_t count)
+{
+	std::unique_lock<std::mutex> lock = acquireLock();
+
+	for (size_t i = 0; i < count; i++)
+		deallocateLocked(blocks[i]);
+}
+
+std::unique_lock<std::mutex> TLSFAllocator::acquireLock()
+{
+	std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+	if (!lock.owns_lock())
+	{
+		_num_contended_locks.fetch_add(1, std::memory_order_relaxed);
+		lock.lock();
+	}
+	return lock;
+}
+
+void* TLSFAllocator::allocateLocked(size_t size, uint8_t alignment)
+{
+	assert(size != 0 && alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+	size_t adjusted_size = alignUp(size, ALIGN_SIZE);
+	if (adjusted_size < BLOCK_SIZE_MIN)
+		adjusted_size = BLOCK_SIZE_MIN;
+
+	BlockHeader* block = nullptr;
+
+	if (alignment <= ALIGN_SIZE)
+	{
+		block = locateFreeBlock(adjusted_size);
+		if (block == nullptr && growPool(adjusted_size))
+			block = locateFreeBlock(adjusted_size);
+		if (block == nullptr)
+			return nullptr;
+	}
+	else
+	{
+		// Ask for enough to skip ahead to the alignment, any gap in front
+		// has to be big enough to become a free block of its own
+		const size_t gap_minimum = sizeof(BlockHeader);
+		block = locateFreeBlock(adjusted_size + alignment + gap_minimum);
+		if (block == nullptr && growPool(adjusted_size + alignment + gap_minimum))
+			block = locateFreeBlock(adjusted_size + alignment + gap_minimum);
+		if (block == nullptr)
+			return nullptr;
+
+		uintptr_t payload = (uintptr_t)blockPayload(block);
+		uintptr_t aligned = alignUp(payload, alignment);
+		size_t gap = aligned - payload;
+		if (gap != 0 && gap < gap_minimum)
+		{
+			aligned = alignUp(payload + gap_minimum, alignment);
+			gap = aligned - payload;
+		}
+
+		if (gap != 0)
+		{
+			BlockHeader* aligned_block = splitBlock(block, gap - BLOCK_OVERHEAD);
+			block->size |= BLOCK_FREE_BIT;
+			insertFreeBlock(block);
+			block = aligned_block;
+		}
+	}
+
+	// Hand any remainder big enough for another allocation back to the free lists
+	if (blockSize(block) >= adjusted_size + sizeof(BlockHeader))
+	{
+		BlockHeader* remaining = splitBlock(block, adjusted_size);
+		remaining->size |= BLOCK_FREE_BIT;
+		insertFreeBlock(remaining);
+	}
+
+	_used_memory += blockSize(block) + BLOCK_OVERHEAD;
+	_num_allocations++;
+
+	void* p = blockPayload(block);
+
+	assert(pointer_math::alignForwardAdjustment(p, alignment) == 0);
+
+	if (_trace != nullptr)
+		_trace->recordAllocate(p, size, alignment);
+
+	return p;
+}
+
+void TLSFAllocator::deallocateLocked(void* p)
+{
+	assert(p != nullptr);
+
+	if (_trace != nullptr)
+		_trace->recordDeallocate(p);
+
+	BlockHeader* block = payloadBlock(p);
+	assert(!isFree(block) && "TLSFAllocator double free");
+
+	_num_allocations--;
+	_used_memory -= blockSize(block) + BLOCK_OVERHEAD;
+
+	block->size |= BLOCK_FREE_BIT;
+	block = mergeWithNeighbours(block);
+	if (nextPhysical(block) == _sentinel && blockSize(block) >= DECOMMIT_THRESHOLD)
+		trimPool(block);
+	insertFreeBlock(block);
+}
+
+void TLSFAllocator::setTrace(AllocationTrace* trace)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_trace = trace;
+}
+
+void TLSFAllocator::setHugePages(bool enabled)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_huge_pages = enabled;
+	if (enabled)
+		virtual_memory::adviseHugePages(_start, (uintptr_t)_committed_end - (uintptr_t)_start);
+}
+
+void TLSFAllocator::mappingInsert(size_t size, size_t& fl, size_t& sl)
+{
+	if (size < SMALL_BLOCK_SIZE)
+	{
+		fl = 0;
+		sl = size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+	}
+	else
+	{
+		size_t last_set = findLastSet(size);
+		sl = (size >> (last_set - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+		fl = last_set - (FL_INDEX_SHIFT - 1);
+	}
+}
+
+void TLSFAllocator::mappingSearch(size_t size, size_t& fl, size_t& sl)
+{
+	// Round up to the next list so every block found there is big enough
+	if (size >= SMALL_BLOCK_SIZE)
+		size += ((size_t)1 << (findLastSet(size) - SL_INDEX_COUNT_LOG2)) - 1;
+
+	mappingInsert(size, fl, sl);
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::searchSuitableBlock(size_t& fl, size_t& sl)
+{
+	uint32_t sl_map = _sl_bitmap[fl] & (~0U << sl);
+	if (sl_map == 0)
+	{
+		// Nothing left in this power of two, take the smallest list from the next one up
+		uint32_t fl_map = _fl_bitmap & (~0U << (fl + 1));
+		if (fl_map == 0)
+			return nullptr;
+
+		fl = findFirstSet(fl_map);
+		sl_map = _sl_bitmap[fl];
+	}
+
+	sl = findFirstSet(sl_map);
+
+	return _free_blocks[fl][sl];
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::locateFreeBlock(size_t size)
+{
+	size_t fl, sl;
+	mappingSearch(size, fl, sl);
+
+	if (fl >= FL_INDEX_COUNT)
+		return nullptr;
+
+	BlockHeader* block = searchSuitableBlock(fl, sl);
+	if (block == nullptr)
+	{
+		// Rounding up skipped the list this size belongs in, its first block may still be big enough
+		mappingInsert(size, fl, sl);
+		block = _free_blocks[fl][sl];
+		if (block != nullptr && blockSize(block) < size)
+			block = nullptr;
+	}
+	if (block == nullptr)
+	{
+		//ASSERT(false && "Couldn't find free block large enough!");
+		return nullptr;
+	}
+
+	assert(blockSize(block) >= size);
+
+	removeFreeBlock(block);
+	block->size &= ~BLOCK_FREE_BIT;
+
+	return block;
+}
+
+void TLSFAllocator::insertFreeBlock(BlockHeader* block)
+{
+	size_t fl, sl;
+	mappingInsert(blockSize(block), fl, sl);
+
+	BlockHeader* current = _free_blocks[fl][sl];
+	block->nextFree = current;
+	block->prevFree = nullptr;
+	if (current != nullptr)
+		current->prevFree = block;
+
+	_free_blocks[fl][sl] = block;
+	_fl_bitmap |= 1U << fl;
+	_sl_bitmap[fl] |= 1U << sl;
+}
+
+void TLSFAllocator::removeFreeBlock(BlockHeader* block)
+{
+	size_t fl, sl;
+	mappingInsert(blockSize(block), fl, sl);
+
+	if (block->nextFree != nullptr)
+		block->nextFree->prevFree = block->prevFree;
+
+	if (block->prevFree != nullptr)
+	{
+		block->prevFree->nextFree = block->nextFree;
+	}
+	else
+	{
+		_free_blocks[fl][sl] = block->nextFree;
+		if (block->nextFree == nullptr)
+		{
+			_sl_bitmap[fl] &= ~(1U << sl);
+			if (_sl_bitmap[fl] == 0)
+				_fl_bitmap &= ~(1U << fl);
+		}
+	}
+}
+
+// Shrinks a used block to size and returns a used block made from the rest
+TLSFAllocator::BlockHeader* TLSFAllocator::splitBlock(BlockHeader* block, size_t size)
+{
+	assert(!isFree(block) && blockSize(block) >= size + sizeof(BlockHeader));
+
+	BlockHeader* remaining = (BlockHeader*)pointer_math::add(blockPayload(block), size);
+	remaining->size = blockSize(block) - size - BLOCK_OVERHEAD;
+	remaining->prevPhysical = block;
+	nextPhysical(remaining)->prevPhysical = remaining;
+
+	block->size = size;
+
+	return remaining;
+}
+
+// Takes free neighbours out of their lists and absorbs them, the block passed in must be free
+TLSFAllocator::BlockHeader* TLSFAllocator::mergeWithNeighbours(BlockHeader* block)
+{
+	BlockHeader* prev = block->prevPhysical;
+	if (prev != nullptr && isFree(prev))
+	{
+		removeFreeBlock(prev);
+		prev->size += blockSize(block) + BLOCK_OVERHEAD;
+		block = prev;
+	}
+
+	BlockHeader* next = nextPhysical(block);
+	if (isFree(next))
+	{
+		removeFreeBlock(next);
+		block->size += blockSize(next) + BLOCK_OVERHEAD;
+	}
+
+	nextPhysical(block)->prevPhysical = block;
+
+	return block;
+}
+
+// Commits enough pages past the end of the pool for a free block of at least size
+bool TLSFAllocator::growPool(size_t size)
+{
+	const size_t available = (uintptr_t)_reserved_end - (uintptr_t)_committed_end;
+	if (available == 0)
+		return false;
+
+	// Rounding up to the next list asks for up to 1/32 more, plus the headers of the new block and sentinel
+	size_t grow_size = alignUp(size + size / 16 + 2 * BLOCK_OVERHEAD, COMMIT_GRANULARITY);
+	if (grow_size > available)
+	{
+		// Committing the rest of the reservation only helps if the request fits once it's merged with the free end
+		BlockHeader* last = _sentinel->prevPhysical;
+		const size_t tail = last != nullptr && isFree(last) ? blockSize(last) + BLOCK_OVERHEAD : 0;
+		if (available + tail < size + BLOCK_OVERHEAD)
+			return false;
+		grow_size = available;
+	}
+
+	if (!virtual_memory::commit(_committed_end, grow_size))
+		return false;
+
+	if (_huge_pages)
+		virtual_memory::adviseHugePages(_committed_end, grow_size);
+
+	_committed_end = pointer_math::add(_committed_end, grow_size);
+	_committed_size.fetch_add(grow_size, std::memory_order_relaxed);
+
+	// The old sentinel becomes a free block running up to the new one
+	BlockHeader* block = _sentinel;
+	BlockHeader* sentinel = (BlockHeader*)(((uintptr_t)_committed_end - BLOCK_OVERHEAD) & ~(ALIGN_SIZE - 1));
+	block->size = (uintptr_t)sentinel - (uintptr_t)blockPayload(block);
+	sentinel->prevPhysical = block;
+	sentinel->size = 0;
+	_sentinel = sentinel;
+
+	block->size |= BLOCK_FREE_BIT;
+	block = mergeWithNeighbours(block);
+	insertFreeBlock(block);
+
+	return true;
+}
+
+// Shrinks the free block at the end of the pool and decommits the pages after it, the block must not be in a list
+void TLSFAllocator::trimPool(BlockHeader* last)
+{
+	// Pools handed over fully committed aren't ours to decommit
+	const uintptr_t committed_end = alignUp((uintptr_t)blockPayload(last) + DECOMMIT_SLACK, COMMIT_GRANULARITY);
+	if (!_growable || committed_end >= (uintptr_t)_committed_end)
+		return;
+
+	BlockHeader* sentinel = (BlockHeader*)(committed_end - BLOCK_OVERHEAD);
+	last->size = ((uintptr_t)sentinel - (uintptr_t)blockPayload(last)) | BLOCK_FREE_BIT;
+	sentinel->prevPhysical = last;
+	sentinel->size = 0;
+	_sentinel = sentinel;
+
+	const size_t decommit_size = (uintptr_t)_committed_end - committed_end;
+	virtual_memory::decommit((void*)committed_end, decommit_size);
+	_committed_end = (void*)committed_end;
+	_committed_size.fetch_sub(decommit_size, std::memory_order_relaxed);
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+// Two-Level Segregated Fit allocator, allocations of any size and deallocations in any order like the FreeList allocator,
+// but both are O(1) no matter how fragmented the memory gets.
+// Free blocks are kept in segregated lists, the first level splits sizes by power of two and the second level
+// splits each power of two range into SL_INDEX_COUNT linear steps.
+// Two bitmaps record which lists are non-empty, so finding a free block big enough is a couple of bit scans
+// instead of walking a list.
+// Every block knows its physical neighbours, freed blocks are merged with free neighbours straight away.
+// The pool can be a reserved range of address space that's only partly committed, it then commits more at the end
+// when it runs out and decommits the end again once enough of it is free.
+// References:
+// http://www.gii.upv.es/tlsf/files/ecrts04_tlsf.pdf
+// http://www.gii.upv.es/tlsf/files/papers/jrts2008.pdf
+
+#include "Allocator.h"
+#include "VirtualMemory.h"
+#include <atomic>
+#include <mutex> // For std::mutex
+
+class AllocationTrace;
+
+class TLSFAllocator : public Allocator
+{
+public:
+	static const size_t COMMIT_GRANULARITY = 2 * 1024 * 1024;         // Matches huge pages, so advice covers whole ones
+	static const size_t DECOMMIT_THRESHOLD = 64 * 1024 * 1024;         // Free bytes at the end before any are decommitted
+	static const size_t DECOMMIT_SLACK = 16 * 1024 * 1024;             // Left committed past the last used block
+
+	// Only the first committed_size bytes need to be committed, the rest must be reserved with virtual_memory
+	TLSFAllocator(size_t size, void* start, size_t committed_size);
+	TLSFAllocator(size_t size, void* start);
+	~TLSFAllocator();
+
+	void* allocate(size_t size, uint8_t alignment = 4) override;
+	void deallocate(void* p) override;
+
+	// Allocates up to count blocks of the same size, 16 byte aligned, under a single lock
+	// Returns how many were allocated
+	size_t allocateBatch(size_t size, size_t count, void** blocks);
+	void deallocateBatch(void** blocks, size_t count);
+
+	// Usable bytes of a block returned by allocate, at least what was asked for
+	size_t getAllocationSize(const void* p) const override { return blockSize(payloadBlock(p)); }
+
+	// How many times a thread had to wait for another to release the lock
+	size_t getNumContendedLocks() const { return _num_contended_locks.load(std::memory_order_relaxed); }
+
+	// Records every allocation and deallocation into the trace until set back to nullptr
+	void setTrace(AllocationTrace* trace);
+
+	// Advises transparent huge pages on the committed pool and everything committed from now on
+	void setHugePages(bool enabled);
+
+	size_t getCommittedSize() const { return _committed_size.load(std::memory_order_relaxed); }
+
+private:
+	static const size_t ALIGN_SIZE_LOG2 = 4;
+	static const size_t ALIGN_SIZE = 1 << ALIGN_SIZE_LOG2;             // Every block payload is aligned to this
+	static const size_t SL_INDEX_COUNT_LOG2 = 5;
+	static const size_t SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;     // Second level lists per power of two
+	static const size_t FL_INDEX_MAX = sizeof(size_t) == 8 ? 38 : 30;   // Largest block is just under 256GB, 1GB on 32 bit
+	static const size_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+	static const size_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+	static const size_t SMALL_BLOCK_SIZE = 1 << FL_INDEX_SHIFT;         // Below this the first list is linear
+
+	struct BlockHeader
+	{
+		BlockHeader* prevPhysical;
+		size_t size;                    // Payload bytes, lowest bit set while the block is free
+		// Only valid while the block is free, they sit in the payload
+		BlockHeader* nextFree;
+		BlockHeader* prevFree;
+	};
+
+	static const size_t BLOCK_OVERHEAD = sizeof(BlockHeader*) + sizeof(size_t);
+	static const size_t BLOCK_SIZE_MIN = sizeof(BlockHeader) - BLOCK_OVERHEAD;
+	static const size_t BLOCK_FREE_BIT = 1;
+
+	TLSFAllocator(const TLSFAllocator&); //Prevent copies because it might cause errors
+	TLSFAllocator& operator=(const TLSFAllocator&);
+
+	static size_t blockSize(const BlockHeader* block) { return block->size & ~BLOCK_FREE_BIT; }
+	static bool isFree(const BlockHeader* block) { return (block->size & BLOCK_FREE_BIT) != 0; }
+	static void* blockPayload(const BlockHeader* block) { return pointer_math::add((void*)block, BLOCK_OVERHEAD); }
+	static BlockHeader* payloadBlock(const void* p) { return (BlockHeader*)pointer_math::subtract(p, BLOCK_OVERHEAD); }
+	static BlockHeader* nextPhysical(const BlockHeader* block) { return (BlockHeader*)pointer_math::add(blockPayload(block), blockSize(block)); }
+
+	std::unique_lock<std::mutex> acquireLock();
+	void* allocateLocked(size_t size, uint8_t alignment);
+	void deallocateLocked(void* p);
+
+	static void mappingInsert(size_t size, size_t& fl, size_t& sl);
+	static void mappingSearch(size_t size, size_t& fl, size_t& sl);
+
+	BlockHeader* searchSuitableBlock(size_t& fl, size_t& sl);
+	BlockHeader* locateFreeBlock(size_t size);
+	void insertFreeBlock(BlockHeader* block);
+	void removeFreeBlock(BlockHeader* block);
+	BlockHeader* splitBlock(BlockHeader* block, size_t size);
+	BlockHeader* mergeWithNeighbours(BlockHeader* block);
+	bool growPool(size_t size);
+	void trimPool(BlockHeader* last);
+
+	uint32_t _fl_bitmap;
+	uint32_t _sl_bitmap[FL_INDEX_COUNT];
+	BlockHeader* _free_blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+	AllocationTrace* _trace;
+	BlockHeader* _sentinel;             // Empty used block at the end of the committed pool
+	void* _committed_end;
+	void* _reserved_end;
+	std::atomic<size_t> _committed_size;
+	const bool _growable;               // Set when the pool was only partly committed
+	bool _huge_pages;
+	std::mutex _mutex;
+	std::atomic<size_t> _num_contended_locks;
+};
+
+namespace allocator
+{
+	inline TLSFAllocator* newTLSFAllocator(size_t size, Allocator& allocator)
+	{
+		void* p = allocator.allocate(size+sizeof(TLSFAllocator), __alignof(TLSFAllocator));
+		return new (p) TLSFAllocator(size, pointer_math::add(p, sizeof(TLSFAllocator)));
+	}
+
+	inline void deleteTLSFAllocator(TLSFAllocator& tlsfAllocator, Allocator& allocator)
+	{
+		tlsfAllocator.~TLSFAllocator();
+
+		allocator.deallocate(&tlsfAllocator);
+	}
+
+	// Reserves size bytes of address space and commits them as the allocator needs them
+	inline TLSFAllocator* newVirtualTLSFAllocator(size_t size)
+	{
+		size = (size + TLSFAllocator::COMMIT_GRANULARITY - 1) & ~(TLSFAllocator::COMMIT_GRANULARITY - 1);
+
+		void* p = virtual_memory::reserve(size);
+		if (p == nullptr)
+		{
+			Log::Error("[TLSFAllocator] Failed to reserve %zu bytes of address space", size);
+			return nullptr;
+		}
+		if (!virtual_memory::commit(p, TLSFAllocator::COMMIT_GRANULARITY))
+		{
+			virtual_memory::release(p, size);
+			return nullptr;
+		}
+
+		return new (p) TLSFAllocator(size - sizeof(TLSFAllocator), pointer_math::add(p, sizeof(TLSFAllocator)),
+			TLSFAllocator::COMMIT_GRANULARITY - sizeof(TLSFAllocator));
+	}
+
+	// Anything still allocated goes back to the OS with the rest of the range, so leaks don't trip the destructor's assert
+	inline void deleteVirtualTLSFAllocator(TLSFAllocator& tlsfAllocator)
+	{
+		void* p = &tlsfAllocator;
+		const size_t size = tlsfAllocator.getSize() + sizeof(TLSFAllocator);
+
+		virtual_memory::release(p, size);
+	}
+};
@@ -0,0 +1,26 @@
+#include "TaggedAllocator.h"
+
+TaggedAllocator::TaggedAllocator(Allocator& allocator, MemoryTag tag)
+	: Allocator(allocator.getSize(), allocator.getStart())
+	, _allocator(allocator)
+	, _tag(tag)
+{}
+
+TaggedAllocator::~TaggedAllocator()
+{}
+
+void* TaggedAllocator::allocate(size_t size, uint8_t alignment)
+{
+	AllocatorTagScope tagScope(_tag);
+	return _allocator.allocate(size, alignment);
+}
+
+void TaggedAllocator::deallocate(void* p)
+{
+	_allocator.deallocate(p);
+}
+
+size_t TaggedAllocator::getAllocationSize(const void* p) const
+{
+	return _allocator.getAllocationSize(p);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// A Tagged Allocator forwards everything to the allocator passed to the constructor, with its memory tag set,
+// so the memory tracker can tell which subsystem owns each allocation in debug builds.
+// When tagged allocators are chained the one a subsystem calls directly wins, so wrapping an allocator handed down
+// by another subsystem moves the memory over to the new tag.
+// Unlike the Proxy allocator it keeps no counters and takes no lock, so it costs nothing in release builds
+// and can sit in front of allocators used from several threads at once.
+
+#include "Allocator.h"
+
+class TaggedAllocator : public Allocator
+{
+public:
+	TaggedAllocator(Allocator& allocator, MemoryTag tag);
+	~TaggedAllocator();
+
+	void* allocate(size_t size, uint8_t alignment = 4) override;
+	void deallocate(void* p) override;
+	size_t getAllocationSize(const void* p) const override;
+
+	MemoryTag getTag() const { return _tag; }
+
+private:
+	TaggedAllocator(const TaggedAllocator&); //Prevent copies because it might cause errors
+	TaggedAllocator& operator=(const TaggedAllocator&);
+
+	Allocator& _allocator;
+	const MemoryTag _tag;
+};
@@ -0,0 +1,358 @@
+#include "ThreadCacheAllocator.h"
+#include "TLSFAllocator.h"
+#include "MemoryTracker.h"
+#include <algorithm>
+
+static const size_t MAX_THREAD_CACHES = 4;    // Allocators a single thread can keep a cache for
+
+struct ThreadAllocationCache
+{
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	FreeBlock* blocks[ThreadCacheAllocator::NUM_SIZE_CLASSES];
+	size_t numBlocks[ThreadCacheAllocator::NUM_SIZE_CLASSES];
+	// Only the owning thread writes these, freeing blocks from other threads can take them below zero
+	std::atomic<int64_t> usedMemory;
+	std::atomic<int64_t> numAllocations;
+
+	ThreadAllocationCache()
+		: usedMemory(0)
+		, numAllocations(0)
+	{
+		for (size_t i = 0; i < ThreadCacheAllocator::NUM_SIZE_CLASSES; i++)
+		{
+			blocks[i] = nullptr;
+			numBlocks[i] = 0;
+		}
+	}
+};
+
+// Allocators that haven't been destroyed yet, so an exiting thread knows which of its caches still need returning
+static std::mutex& liveAllocatorsMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+static std::vector<ThreadCacheAllocator*>& liveAllocators()
+{
+	static std::vector<ThreadCacheAllocator*> allocators;
+	return allocators;
+}
+
+static std::atomic<uint32_t> s_nextAllocatorID(1);
+
+// Each thread's caches, returned to their allocators when the thread exits
+struct ThreadCacheTable
+{
+	struct Slot
+	{
+		ThreadCacheAllocator* allocator;
+		uint32_t id;
+		ThreadAllocationCache* cache;
+	};
+
+	Slot slots[MAX_THREAD_CACHES];
+
+	ThreadCacheTable()
+	{
+		for (Slot& slot : slots)
+			slot = { nullptr, 0, nullptr };
+	}
+
+	~ThreadCacheTable()
+	{
+		std::lock_guard<std::mutex> lock(liveAllocatorsMutex());
+
+		for (Slot& slot : slots)
+		{
+			if (isLive(slot))
+				slot.allocator->releaseThreadCache(slot.cache);
+		}
+	}
+
+	// Only while holding liveAllocatorsMutex
+	static bool isLive(const Slot& slot)
+	{
+		if (slot.cache == nullptr)
+			return false;
+
+		const std::vector<ThreadCacheAllocator*>& allocators = liveAllocators();
+		return std::find(allocators.begin(), allocators.end(), slot.allocator) != allocators.end()
+			&& slot.allocator->_id == slot.id;
+	}
+};
+
+static thread_local ThreadCacheTable t_cacheTable;
+
+// Only the owning thread writes its counters, so a plain load and store is enough
+static void addOwned(std::atomic<int64_t>& counter, int64_t value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+ThreadCacheAllocator::ThreadCacheAllocator(TLSFAllocator& parent)
+	: Allocator(parent.getSize(), parent.getStart())
+	, _parent(parent)
+	, _id(s_nextAllocatorID.fetch_add(1, std::memory_order_relaxed))
+	, _released_used_memory(0)
+	, _released_allocations(0)
+	, _uncached_used_memory(0)
+	, _uncached_allocations(0)
+	, _num_refills(0)
+	, _num_returns(0)
+	, _last_contended_locks(parent.getNumContendedLocks())
+	, _bypass(false)
+{
+	std::lock_guard<std::mutex> lock(liveAllocatorsMutex());
+	liveAllocators().push_back(this);
+}
+
+ThreadCacheAllocator::~ThreadCacheAllocator()
+{
+	{
+		std::lock_guard<std::mutex> lock(liveAllocatorsMutex());
+		std::vector<ThreadCacheAllocator*>& allocators = liveAllocators();
+		allocators.erase(std::remove(allocators.begin(), allocators.end(), this), allocators.end());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_caches_mutex);
+		for (ThreadAllocationCache* cache : _caches)
+			destroyThreadCache(cache);
+		_caches.clear();
+	}
+
+	collectStats();
+
+	// Leaked blocks stay allocated in the parent, it's up to the parent to report them
+	if (_num_allocations != 0)
+		Log::Warn("[ThreadCacheAllocator] Destroyed with %zu allocations (%zu bytes) still alive", _num_allocations, _used_memory);
+
+	_num_allocations = 0;
+	_used_memory = 0;
+}
+
+void* ThreadCacheAllocator::allocate(size_t size, uint8_t alignment)
+{
+	assert(size != 0 && alignment != 0);
+
+	ThreadAllocationCache* cache = getThreadCache();
+	void* p = nullptr;
+
+	if (cache != nullptr && size <= MAX_CACHED_SIZE && alignment <= SIZE_CLASS_STEP && !_bypass.load(std::memory_order_relaxed))
+	{
+		const size_t sizeClass = (size - 1) / SIZE_CLASS_STEP;
+		if (cache->blocks[sizeClass] == nullptr && !refill(*cache, sizeClass))
+			return nullptr;
+
+		ThreadAllocationCache::FreeBlock* block = cache->blocks[sizeClass];
+		cache->blocks[sizeClass] = block->next;
+		cache->numBlocks[sizeClass]--;
+		p = block;
+	}
+	else
+	{
+		p = _parent.allocate(size, alignment);
+		if (p == nullptr)
+			return nullptr;
+	}
+
+	trackUsage(cache, (int64_t)_parent.getAllocationSize(p), 1);
+
+#ifdef MEMORY_TRACKING
+	MemoryTracker::OnAllocate(p, size);
+#endif
+
+	return p;
+}
+
+void ThreadCacheAllocator::deallocate(void* p)
+{
+	assert(p != nullptr);
+
+#ifdef MEMORY_TRACKING
+	MemoryTracker::OnDeallocate(p);
+#endif
+
+	const size_t size = _parent.getAllocationSize(p);
+	ThreadAllocationCache* cache = getThreadCache();
+
+	trackUsage(cache, -(int64_t)size, -1);
+
+	if (cache == nullptr || size > MAX_CACHED_SIZE || _bypass.load(std::memory_order_relaxed))
+	{
+		_parent.deallocate(p);
+		return;
+	}
+
+	// Blocks can be bigger than the class they were taken for, file them under the largest class they cover
+	const size_t sizeClass = size / SIZE_CLASS_STEP - 1;
+	ThreadAllocationCache::FreeBlock* block = (ThreadAllocationCache::FreeBlock*)p;
+	block->next = cache->blocks[sizeClass];
+	cache->blocks[sizeClass] = block;
+
+	if (++cache->numBlocks[sizeClass] > MAX_CACHED_BLOCKS)
+		returnBlocks(*cache, sizeClass, MAX_CACHED_BLOCKS / 2);
+}
+
+// Cached blocks are parent blocks, so the parent knows their size whichever thread holds them
+size_t ThreadCacheAllocator::getAllocationSize(const void* p) const
+{
+	return _parent.getAllocationSize(p);
+}
+
+ThreadCacheStats ThreadCacheAllocator::collectStats()
+{
+	std::lock_guard<std::mutex> lock(_caches_mutex);
+
+	int64_t used_memory = _released_used_memory + _uncached_used_memory.load(std::memory_order_relaxed);
+	int64_t num_allocations = _released_allocations + _uncached_allocations.load(std::memory_order_relaxed);
+	for (const ThreadAllocationCache* cache : _caches)
+	{
+		used_memory += cache->usedMemory.load(std::memory_order_relaxed);
+		num_allocations += cache->numAllocations.load(std::memory_order_relaxed);
+	}
+
+	// Threads are still running, so this is only a snapshot
+	_used_memory = (size_t)std::max<int64_t>(used_memory, 0);
+	_num_allocations = (size_t)std::max<int64_t>(num_allocations, 0);
+
+	ThreadCacheStats stats;
+	stats.numRefills = _num_refills.exchange(0, std::memory_order_relaxed);
+	stats.numReturns = _num_returns.exchange(0, std::memory_order_relaxed);
+	const size_t contended_locks = _parent.getNumContendedLocks();
+	stats.numContendedLocks = contended_locks - _last_contended_locks;
+	_last_contended_locks = contended_locks;
+
+	return stats;
+}
+
+void ThreadCacheAllocator::setTrace(AllocationTrace* trace)
+{
+	if (trace != nullptr)
+	{
+		_bypass.store(true, std::memory_order_relaxed);
+		_parent.setTrace(trace);
+	}
+	else
+	{
+		_parent.setTrace(nullptr);
+		_bypass.store(false, std::memory_order_relaxed);
+	}
+}
+
+ThreadAllocationCache* ThreadCacheAllocator::getThreadCache()
+{
+	for (const ThreadCacheTable::Slot& slot : t_cacheTable.slots)
+	{
+		if (slot.allocator == this && slot.id == _id)
+			return slot.cache;
+	}
+	return createThreadCache();
+}
+
+ThreadAllocationCache* ThreadCacheAllocator::createThreadCache()
+{
+	std::lock_guard<std::mutex> liveLock(liveAllocatorsMutex());
+
+	// Slots left behind by destroyed allocators can be reused
+	ThreadCacheTable::Slot* freeSlot = nullptr;
+	for (ThreadCacheTable::Slot& slot : t_cacheTable.slots)
+	{
+		if (!ThreadCacheTable::isLive(slot))
+		{
+			freeSlot = &slot;
+			break;
+		}
+	}
+	if (freeSlot == nullptr)
+		return nullptr;
+
+	void* memory = _parent.allocate(sizeof(ThreadAllocationCache), __alignof(ThreadAllocationCache));
+	if (memory == nullptr)
+		return nullptr;
+
+	ThreadAllocationCache* cache = new (memory) ThreadAllocationCache();
+	{
+		std::lock_guard<std::mutex> lock(_caches_mutex);
+		_caches.push_back(cache);
+	}
+	*freeSlot = { this, _id, cache };
+
+	return cache;
+}
+
+void ThreadCacheAllocator::releaseThreadCache(ThreadAllocationCache* cache)
+{
+	std::lock_guard<std::mutex> lock(_caches_mutex);
+
+	destroyThreadCache(cache);
+	_caches.erase(std::remove(_caches.begin(), _caches.end(), cache), _caches.end());
+}
+
+void ThreadCacheAllocator::destroyThreadCache(ThreadAllocationCache* cache)
+{
+	for (size_t sizeClass = 0; sizeClass < NUM_SIZE_CLASSES; sizeClass++)
+	{
+		if (cache->numBlocks[sizeClass] != 0)
+			returnBlocks(*cache, sizeClass, cache->numBlocks[sizeClass]);
+	}
+
+	_released_used_memory += cache->usedMemory.load(std::memory_order_relaxed);
+	_released_allocations += cache->numAllocations.load(std::memory_order_relaxed);
+
+	cache->~ThreadAllocationCache();
+	_parent.deallocate(cache);
+}
+
+bool ThreadCacheAllocator::refill(ThreadAllocationCache& cache, size_t sizeClass)
+{
+	void* blocks[REFILL_COUNT];
+	const size_t count = _parent.allocateBatch((sizeClass + 1) * SIZE_CLASS_STEP, REFILL_COUNT, blocks);
+	_num_refills.fetch_add(1, std::memory_order_relaxed);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		ThreadAllocationCache::FreeBlock* block = (ThreadAllocationCache::FreeBlock*)blocks[i];
+		block->next = cache.blocks[sizeClass];
+		cache.blocks[sizeClass] = block;
+	}
+	cache.numBlocks[sizeClass] += count;
+
+	return count != 0;
+}
+
+void ThreadCacheAllocator::returnBlocks(ThreadAllocationCache& cache, size_t sizeClass, size_t count)
+{
+	assert(count <= MAX_CACHED_BLOCKS + 1);
+
+	void* blocks[MAX_CACHED_BLOCKS + 1];
+	size_t returned = 0;
+	while (returned < count && cache.blocks[sizeClass] != nullptr)
+	{
+		blocks[returned++] = cache.blocks[sizeClass];
+		cache.blocks[sizeClass] = cache.blocks[sizeClass]->next;
+	}
+	cache.numBlocks[sizeClass] -= returned;
+
+	_parent.deallocateBatch(blocks, returned);
+	_num_returns.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ThreadCacheAllocator::trackUsage(ThreadAllocationCache* cache, int64_t bytes, int64_t allocations)
+{
+	if (cache != nullptr)
+	{
+		addOwned(cache->usedMemory, bytes);
+		addOwned(cache->numAllocations, allocations);
+	}
+	else
+	{
+		_uncached_used_memory.fetch_add(bytes, std::memory_order_relaxed);
+		_uncached_allocations.fetch_add(allocations, std::memory_order_relaxed);
+	}
+}
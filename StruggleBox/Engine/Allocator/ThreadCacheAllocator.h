@@ -0,0 +1,79 @@
+#pragma once
+
+// Per thread caches of small blocks in front of a TLSF allocator, so most allocations and deallocations
+// never take the parent's lock.
+// Small requests are rounded up to a size class, every class keeps a list of free blocks per thread.
+// An empty list is refilled with a batch of blocks taken from the parent under one lock, a list that grows too
+// long hands half of its blocks back in one batch.
+// Blocks are ordinary parent allocations, so a block freed on another thread than it was allocated on simply
+// joins the freeing thread's cache, and anything too large or too aligned goes straight to the parent.
+// A thread's cache is returned to the parent when the thread exits or the allocator is destroyed.
+
+#include "Allocator.h"
+#include <atomic>
+#include <mutex> // For std::mutex
+#include <vector>
+
+class AllocationTrace;
+class TLSFAllocator;
+struct ThreadAllocationCache;
+
+struct ThreadCacheStats
+{
+	size_t numRefills;              // Batches taken from the parent
+	size_t numReturns;              // Batches handed back to the parent
+	size_t numContendedLocks;       // Times a thread waited on the parent's lock
+};
+
+class ThreadCacheAllocator : public Allocator
+{
+public:
+	static const size_t SIZE_CLASS_STEP = 16;
+	static const size_t NUM_SIZE_CLASSES = 16;
+	static const size_t MAX_CACHED_SIZE = SIZE_CLASS_STEP * NUM_SIZE_CLASSES;
+	static const size_t REFILL_COUNT = 32;              // Blocks taken from the parent when a list runs dry
+	static const size_t MAX_CACHED_BLOCKS = 128;        // Per size class, half go back to the parent past this
+
+	ThreadCacheAllocator(TLSFAllocator& parent);
+	~ThreadCacheAllocator();
+
+	void* allocate(size_t size, uint8_t alignment = 4) override;
+	void deallocate(void* p) override;
+	size_t getAllocationSize(const void* p) const override;
+
+	// Sums every thread's counters into the used memory and allocation count
+	// Returns the parent traffic since the last call
+	ThreadCacheStats collectStats();
+
+	// Recording bypasses the caches, so the trace sees every allocation instead of the batches
+	void setTrace(AllocationTrace* trace);
+
+	TLSFAllocator& getParent() const { return _parent; }
+
+private:
+	ThreadCacheAllocator(const ThreadCacheAllocator&); //Prevent copies because it might cause errors
+	ThreadCacheAllocator& operator=(const ThreadCacheAllocator&);
+
+	friend struct ThreadCacheTable;
+
+	ThreadAllocationCache* getThreadCache();
+	ThreadAllocationCache* createThreadCache();
+	void releaseThreadCache(ThreadAllocationCache* cache);
+	void destroyThreadCache(ThreadAllocationCache* cache);
+	bool refill(ThreadAllocationCache& cache, size_t sizeClass);
+	void returnBlocks(ThreadAllocationCache& cache, size_t sizeClass, size_t count);
+	void trackUsage(ThreadAllocationCache* cache, int64_t bytes, int64_t allocations);
+
+	TLSFAllocator& _parent;
+	const uint32_t _id;                                 // Tells a new allocator apart from a destroyed one at the same address
+	std::vector<ThreadAllocationCache*> _caches;
+	std::mutex _caches_mutex;                           // Guards the cache list and the counters below
+	int64_t _released_used_memory;                      // Left over by threads that exited
+	int64_t _released_allocations;
+	std::atomic<int64_t> _uncached_used_memory;         // Threads without a cache slot
+	std::atomic<int64_t> _uncached_allocations;
+	std::atomic<size_t> _num_refills;
+	std::atomic<size_t> _num_returns;
+	size_t _last_contended_locks;
+	std::atomic<bool> _bypass;
+};
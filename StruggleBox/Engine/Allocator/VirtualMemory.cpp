@@ -0,0 +1,85 @@
+#include "VirtualMemory.h"
+#include "Log.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#if !defined(_WIN32) && !defined(MAP_NORESERVE)
+#define MAP_NORESERVE 0
+#endif
+
+namespace virtual_memory
+{
+	size_t getPageSize()
+	{
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+#else
+		return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}
+
+	void* reserve(size_t size)
+	{
+#ifdef _WIN32
+		return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+		void* address = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		return address == MAP_FAILED ? nullptr : address;
+#endif
+	}
+
+	void release(void* address, size_t size)
+	{
+#ifdef _WIN32
+		(void)size;
+		VirtualFree(address, 0, MEM_RELEASE);
+#else
+		munmap(address, size);
+#endif
+	}
+
+	bool commit(void* address, size_t size)
+	{
+#ifdef _WIN32
+		const bool committed = VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+		const bool committed = mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+		if (!committed)
+			Log::Error("[VirtualMemory] Failed to commit %zu bytes at %p", size, address);
+
+		return committed;
+	}
+
+	void decommit(void* address, size_t size)
+	{
+#ifdef _WIN32
+		VirtualFree(address, size, MEM_DECOMMIT);
+#else
+		// Mapping fresh inaccessible pages over the range drops both the pages and their commit charge
+		mmap(address, size, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+#endif
+	}
+
+	void adviseHugePages(void* address, size_t size)
+	{
+#ifdef MADV_HUGEPAGE
+		madvise(address, size, MADV_HUGEPAGE);
+#else
+		// Windows large pages need a privilege and have to be committed up front, so they're not used
+		(void)address;
+		(void)size;
+#endif
+	}
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+// Thin wrappers over the OS virtual memory calls, VirtualAlloc on Windows and mmap everywhere else.
+// Reserving only claims address space, nothing is backed by memory or counted against the commit limit
+// until it's committed, and decommitted pages go back to the OS while the range stays reserved.
+// Every address and size passed in has to be a multiple of the page size.
+
+#include <cstddef>
+
+namespace virtual_memory
+{
+	size_t getPageSize();
+
+	// Returns nullptr if the address space couldn't be reserved
+	void* reserve(size_t size);
+	void release(void* address, size_t size);
+
+	bool commit(void* address, size_t size);
+	void decommit(void* address, size_t size);
+
+	// Asks for transparent huge pages on the committed range, only does anything on Linux
+	void adviseHugePages(void* address, size_t size);
+};
@@ -2,4 +2,5 @@
 
 #define KILO 1024
 #define MEGA KILO*KILO
-#define HEAP_SIZE 1024*MEGA
\ No newline at end of file
+// Address space reserved for the heap, it only commits what it uses
+#define HEAP_SIZE (sizeof(void*) == 8 ? 32ull*1024*MEGA : 1024ull*MEGA)
\ No newline at end of file
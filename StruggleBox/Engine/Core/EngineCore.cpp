@@ -5,32 +5,48 @@
 #include "CoreDefines.h"
 #include "CoreIncludes.h"
 #include "ArenaOperators.h"
+#include "AllocationTrace.h"
 #include "FreeListAllocator.h"
+#include "TLSFAllocator.h"
+#include "ThreadCacheAllocator.h"
 #include "ProxyAllocator.h"
+#include "MemoryTracker.h"
 #include "Injector.h"
 #include "Options.h"
 #include "Input.h"
-#include "ThreadPool.h"
+#include "JobSystem.h"
 #include "Log.h"
 #include "LogOutputConsole.h"
 #include "LogOutputSTD.h"
 #include "CommandProcessor.h"
+#include "Profiler.h"
+#include "FileUtil.h"
 #include "Timer.h"
 
 // Engine
 #include "RenderCore.h"
+#include "GLRenderBackend.h"
+#include "NullRenderBackend.h"
 #include "SceneManager.h"
 #include "Scene.h"
 #include "StatTracker.h"
 
 constexpr bool USE_STD_OUTPUT = true;
 
-EngineCore& EngineCore::create(const int argc, const char* arg[], unsigned char* heap)
+EngineCore& EngineCore::create(const int argc, const char* arg[])
 {
 	Timer::StartRunTime();
 	Console::Initialize();
 
-	FreeListAllocator* coreAllocator = new (heap)FreeListAllocator(HEAP_SIZE - sizeof(FreeListAllocator), heap + sizeof(FreeListAllocator));
+	// The heap for the entire application, pages are committed as it grows
+	TLSFAllocator* heapAllocator = allocator::newVirtualTLSFAllocator(HEAP_SIZE);
+	if (heapAllocator == nullptr)
+	{
+		// There's no log output to report to yet
+		fprintf(stderr, "[EngineCore] Failed to reserve %zu bytes for the heap\n", (size_t)HEAP_SIZE);
+		abort();
+	}
+	ThreadCacheAllocator* coreAllocator = CUSTOM_NEW(ThreadCacheAllocator, (*heapAllocator))(*heapAllocator);
 	if (USE_STD_OUTPUT)
 	{
 		LogOutputSTD* outSTD = CUSTOM_NEW(LogOutputSTD, (*coreAllocator))();
@@ -50,8 +66,9 @@ EngineCore& EngineCore::create(const int argc, const char* arg[], unsigned char*
 	Injector& injector = *(CUSTOM_NEW(Injector, (*coreAllocator))(*coreAllocator));
 	injector.mapInstance<Injector>(injector);
 	injector.mapInstance<Allocator>(*coreAllocator);
+	injector.mapInstance<ThreadCacheAllocator>(*coreAllocator);
 
-	injector.mapSingleton<EngineCore, Injector, Allocator>();
+	injector.mapSingleton<EngineCore, Injector, ThreadCacheAllocator>();
 	EngineCore& core = injector.getInstance<EngineCore>();
 
 	return core;
@@ -60,8 +77,8 @@ EngineCore& EngineCore::create(const int argc, const char* arg[], unsigned char*
 void EngineCore::destroy(EngineCore& engineCore)
 {
 	Injector& injector = engineCore.m_coreInjector;
-	Allocator& allocator = engineCore.m_coreAllocator;
-	Allocator& rendererAllocator = engineCore.m_rendererAllocator;
+	ThreadCacheAllocator& allocator = engineCore.m_coreAllocator;
+	TLSFAllocator& heapAllocator = allocator.getParent();
 
 	const auto& logOutputs = Log::GetOutputs();
 	if (USE_STD_OUTPUT)
@@ -92,18 +109,31 @@ void EngineCore::destroy(EngineCore& engineCore)
 
 	injector.unmap<Injector>();
 	injector.unmap<Allocator>();
+	injector.unmap<ThreadCacheAllocator>();
 	injector.unmap<EngineCore>();
 
-	CUSTOM_DELETE(&rendererAllocator, allocator);
+	// The renderer allocator was already deleted in terminate
 	CUSTOM_DELETE(&injector, allocator);
-	//delete (&allocator);
+
+#ifdef MEMORY_TRACKING
+	// Everything should be freed by now, the log outputs are gone so report straight to std out
+	LogOutputSTD leakOutput;
+	Log::AttachOutput(&leakOutput);
+	MemoryTracker::LogLeaks();
+	Log::DetachOutput(&leakOutput);
+#endif
+
+	// Hands every thread's cached blocks back before the heap goes away
+	CUSTOM_DELETE(&allocator, heapAllocator);
+	allocator::deleteVirtualTLSFAllocator(heapAllocator);
 }
 
 void EngineCore::initialize()
 {
+	Profiler::setThreadName("Main");
 	initCommandProcessor();
 	initApplicationContext();
-	initThreadPool();
+	initJobSystem();
 	initRenderer();
 	initInjectorDependencies();
 
@@ -123,18 +153,25 @@ int EngineCore::terminate()
 	//Log::Debug("EngineCore shutting down...");
 	CommandProcessor::Terminate();
 
+	if (m_allocationTrace)
+	{
+		m_coreAllocator.setTrace(nullptr);
+		CUSTOM_DELETE(m_allocationTrace, m_coreAllocator);
+		m_allocationTrace = nullptr;
+	}
+
 	SceneManager& sceneManager = m_coreInjector.getInstance<SceneManager>();
 	sceneManager.terminate();
 
 	Input& input = m_coreInjector.getInstance<Input>();
 	input.Terminate();
 
-	ThreadPool& threadPool = m_coreInjector.getInstance<ThreadPool>();
-	CUSTOM_DELETE(&threadPool, m_coreAllocator);
+	JobSystem& jobSystem = m_coreInjector.getInstance<JobSystem>();
+	CUSTOM_DELETE(&jobSystem, m_coreAllocator);
 
 	m_coreInjector.unmap<SceneManager>();
 	m_coreInjector.unmap<StatTracker>();
-	m_coreInjector.unmap<ThreadPool>();
+	m_coreInjector.unmap<JobSystem>();
 	m_coreInjector.unmap<Input>();
 	m_coreInjector.unmap<OSWindow>();
 	m_coreInjector.unmap<AppContext>();
@@ -144,6 +181,8 @@ int EngineCore::terminate()
 	renderCore.terminate();
 	CUSTOM_DELETE(&renderCore, m_rendererAllocator);
 	m_coreInjector.unmap<RenderCore>();
+	CUSTOM_DELETE(m_renderBackend, m_rendererAllocator);
+	m_renderBackend = nullptr;
 
 	allocator::deleteProxyAllocator(m_rendererAllocator, m_coreAllocator);
 	// Output console to log file
@@ -152,23 +191,38 @@ int EngineCore::terminate()
 	return 0;
 }
 
-EngineCore::EngineCore(Injector& injector, Allocator& coreAllocator)
+EngineCore::EngineCore(Injector& injector, ThreadCacheAllocator& coreAllocator)
 	: m_coreInjector(injector)
 	, m_coreAllocator(coreAllocator)
-	, m_rendererAllocator(*allocator::newProxyAllocator(coreAllocator))
+	, m_rendererAllocator(*allocator::newProxyAllocator(coreAllocator, MemoryTag::Renderer))
+	, m_renderBackend(nullptr)
 	, m_quit(false)
 	, m_startTime(Timer::Seconds())
 	, m_lastFrameTime(0.0)
 	, m_lastUpdateTime(0.0)
+	, m_allocationTrace(nullptr)
 {
 	//Log::Debug("EngineCore constructed at %p", this);
 }
 
+Allocator& EngineCore::getGlobalAllocator() const
+{
+	return m_coreAllocator;
+}
+
 void EngineCore::initCommandProcessor()
 {
 	CommandProcessor::Initialize();
 	CommandProcessor::AddCommand("quit", Command<>([this]() { stop(); }));
 	CommandProcessor::AddCommand("exit", Command<>([this]() { stop(); }));
+	CommandProcessor::AddCommand("alloctrace", Command<>([this]() { startAllocationTrace(); }));
+	CommandProcessor::AddCommand("alloctracesave", Command<std::string>([this](std::string filePath) { saveAllocationTrace(filePath); }));
+	CommandProcessor::AddCommand("allocbench", Command<std::string>([this](std::string filePath) { benchmarkAllocationTrace(filePath); }));
+	CommandProcessor::AddCommand("profile", Command<int>([](int numFrames) { Profiler::startCapture(numFrames > 0 ? (uint32_t)numFrames : 0, FileUtil::GetPath() + "Profile.json"); }));
+#ifdef MEMORY_TRACKING
+	CommandProcessor::AddCommand("memreport", Command<>([]() { MemoryTracker::LogReport(); }));
+	CommandProcessor::AddCommand("memcallsites", Command<int>([](int capture) { MemoryTracker::SetCaptureCallSites(capture != 0); }));
+#endif
 	//CommandProcessor::AddCommand("stats", Command<>([&]() { m_globalInjector.getInstance<StatTracker>()->ToggleStats(); }));
 }
 
@@ -182,6 +236,8 @@ void EngineCore::initApplicationContext()
 	const int renderHeight = options.getOption<int>("r_resolutionY");
 	const bool renderFullScreen = options.getOption<bool>("r_fullScreen");
 
+	m_coreAllocator.getParent().setHugePages(options.getOption<bool>("h_hugePages"));
+
 	m_coreInjector.mapSingleton<AppContext>();
 	AppContext& context = m_coreInjector.getInstance<AppContext>();
 	context.InitApp(m_title + " - " + options.getOption<std::string>("version"),
@@ -194,28 +250,39 @@ void EngineCore::initApplicationContext()
 	m_coreInjector.mapSingleton<Input, OSWindow>();
 }
 
-void EngineCore::initThreadPool()
+void EngineCore::initJobSystem()
 {
 	Options& options = m_coreInjector.getInstance<Options>();
 
-	const unsigned int availableThreads = std::thread::hardware_concurrency() - 1;
+	const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	const unsigned int availableThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
 	const bool useMultipleThreads = options.getOption<bool>("h_multiThreading");
 	if (!useMultipleThreads || !availableThreads)
 	{
-		//ThreadPool& threadPool = *(CUSTOM_NEW(ThreadPool, m_coreAllocator)(0));
-		//m_coreInjector.mapInstance<ThreadPool>(threadPool);
 		options.getOption<bool>("h_multiThreading") = false;
-		return;
 	}
 
-	ThreadPool& threadPool = *(CUSTOM_NEW(ThreadPool, m_coreAllocator)(availableThreads));
-	m_coreInjector.mapInstance<ThreadPool>(threadPool);
+	// Without workers jobs run right away on the thread adding them
+	const size_t numWorkers = options.getOption<bool>("h_multiThreading") ? availableThreads : 0;
+	JobSystem& jobSystem = *(CUSTOM_NEW(JobSystem, m_coreAllocator)(numWorkers));
+	m_coreInjector.mapInstance<JobSystem>(jobSystem);
 }
 
 void EngineCore::initRenderer()
 {
-	ThreadPool& threadPool = m_coreInjector.getInstance<ThreadPool>();
-	RenderCore& renderCore = *(CUSTOM_NEW(RenderCore, m_rendererAllocator)(m_rendererAllocator, threadPool));
+	Options& options = m_coreInjector.getInstance<Options>();
+	JobSystem& jobSystem = m_coreInjector.getInstance<JobSystem>();
+
+	// The null backend only counts what RenderCore would have sent to GL
+	if (options.getOption<bool>("r_nullBackend"))
+	{
+		m_renderBackend = CUSTOM_NEW(NullRenderBackend, m_rendererAllocator)();
+	}
+	else
+	{
+		m_renderBackend = CUSTOM_NEW(GLRenderBackend, m_rendererAllocator)();
+	}
+	RenderCore& renderCore = *(CUSTOM_NEW(RenderCore, m_rendererAllocator)(m_rendererAllocator, jobSystem, *m_renderBackend));
 	m_coreInjector.mapInstance<RenderCore>(renderCore);
 }
 
@@ -230,36 +297,67 @@ void EngineCore::run()
 	SceneManager& sceneManager = m_coreInjector.getInstance<SceneManager>();
 	StatTracker& statTracker = m_coreInjector.getInstance<StatTracker>();
 	statTracker.setValueBuffered("Frame Time", 1000);
-	ThreadPool& threadPool = m_coreInjector.getInstance<ThreadPool>();
+	JobSystem& jobSystem = m_coreInjector.getInstance<JobSystem>();
 	OSWindow& window = m_coreInjector.getInstance<OSWindow>();
 	RenderCore& renderCore = m_coreInjector.getInstance<RenderCore>();
 	m_lastFrameTime = Timer::Seconds();
 
 	while (!m_quit)
 	{
-		const double timeNow = Timer::Seconds();
-		const double deltaTime = timeNow - m_lastFrameTime;
-		m_lastFrameTime = timeNow;
+		{
+			PROFILE_SCOPE("Frame");
+			const double timeNow = Timer::Seconds();
+			const double deltaTime = timeNow - m_lastFrameTime;
+			m_lastFrameTime = timeNow;
 
-		pollEvents();
+			{
+				PROFILE_SCOPE("Poll Events");
+				pollEvents();
+				CommandProcessor::Update(deltaTime);
+			}
 
-		CommandProcessor::Update(deltaTime);
+			renderCore.beginFrame();
 
-		renderCore.beginFrame();
+			if (!sceneManager.IsEmpty())
+			{
+				Scene* currentScene = sceneManager.GetActiveScene();
+				{
+					PROFILE_SCOPE("Scene Update");
+					currentScene->Update(deltaTime);
+				}
+				{
+					PROFILE_SCOPE("Scene Draw");
+					currentScene->Draw();
+				}
+			}
 
-		if (!sceneManager.IsEmpty())
-		{
-			Scene* currentScene = sceneManager.GetActiveScene();
-			currentScene->Update(deltaTime);
-			currentScene->Draw();
-		}
+			statTracker.trackFloatValue((float)deltaTime * 1000.f, "Frame Time");
+			statTracker.trackIntValue((int32_t)(1.f / (float)deltaTime), "FPS");
+			statTracker.trackIntValue((int32_t)jobSystem.numJobs(), "Job System Jobs");
+
+			const ThreadCacheStats heapStats = m_coreAllocator.collectStats();
+			statTracker.trackIntValue((int32_t)heapStats.numContendedLocks, "Heap Lock Contention");
+			statTracker.trackIntValue((int32_t)heapStats.numRefills, "Heap Cache Refills");
+			statTracker.trackIntValue((int32_t)heapStats.numReturns, "Heap Cache Returns");
+			statTracker.trackIntValue((int32_t)(m_coreAllocator.getParent().getCommittedSize() / (MEGA)), "Heap Committed MB");
 
-		statTracker.trackFloatValue((float)deltaTime * 1000.f, "Frame Time");
-		statTracker.trackIntValue((int32_t)(1.f / (float)deltaTime), "FPS");
-		statTracker.trackIntValue((int32_t)threadPool.numJobs(), "Threadpool Jobs");
+			const RenderFrameStats& renderStats = renderCore.getLastFrameStats();
+			statTracker.trackIntValue((int32_t)renderStats.drawCalls, "Render Draw Calls");
+			statTracker.trackIntValue((int32_t)renderStats.stateChanges, "Render State Changes");
+			statTracker.trackIntValue((int32_t)renderStats.redundantStateChanges, "Render Redundant State Changes");
+			statTracker.trackIntValue((int32_t)(renderStats.bytesUploaded / 1024), "Render Upload KB");
+			statTracker.trackIntValue((int32_t)(renderStats.bytesStreamed / 1024), "Render Streamed KB");
 
-		renderCore.endFrame();
-		window.SwapBuffers();
+			{
+				PROFILE_SCOPE("Render End Frame");
+				renderCore.endFrame();
+			}
+			{
+				PROFILE_SCOPE("Swap Buffers");
+				window.SwapBuffers();
+			}
+		}
+		Profiler::endFrame();
 	}
 }
 
@@ -286,3 +384,76 @@ void EngineCore::pollEvents()
 		input.ProcessInput(eventData);
 	}
 }
+
+void EngineCore::startAllocationTrace()
+{
+	if (m_allocationTrace)
+	{
+		Log::Warn("[EngineCore] Already recording allocations");
+		return;
+	}
+
+	// Created before the allocator starts recording, so the trace doesn't record itself
+	m_allocationTrace = CUSTOM_NEW(AllocationTrace, m_coreAllocator)();
+	m_coreAllocator.setTrace(m_allocationTrace);
+	Log::Info("[EngineCore] Recording allocations");
+}
+
+void EngineCore::saveAllocationTrace(const std::string& filePath)
+{
+	if (!m_allocationTrace)
+	{
+		Log::Warn("[EngineCore] Not recording allocations, start with alloctrace");
+		return;
+	}
+
+	m_coreAllocator.setTrace(nullptr);
+	if (m_allocationTrace->save(filePath))
+	{
+		Log::Info("[EngineCore] Saved %zu allocation events to %s", m_allocationTrace->getNumEvents(), filePath.c_str());
+	}
+	CUSTOM_DELETE(m_allocationTrace, m_coreAllocator);
+	m_allocationTrace = nullptr;
+}
+
+static void logAllocationReplay(const char* name, const AllocationReplayResult& result)
+{
+	Log::Info("[EngineCore] %s: %zu allocations (%zu failed), %zu deallocations, peak %zu bytes",
+		name, result.numAllocations, result.numFailed, result.numDeallocations, result.peakUsedMemory);
+	Log::Info("[EngineCore] %s: allocate median %.0fns, 99th %.0fns, max %.0fns",
+		name, result.allocateMedianNs, result.allocate99thNs, result.allocateMaxNs);
+	Log::Info("[EngineCore] %s: deallocate median %.0fns, 99th %.0fns, max %.0fns",
+		name, result.deallocateMedianNs, result.deallocate99thNs, result.deallocateMaxNs);
+	Log::Info("[EngineCore] %s: %zu bytes free, largest block %zu bytes, fragmentation %.1f%%",
+		name, result.freeMemory, result.largestFreeBlock, result.fragmentation * 100.f);
+}
+
+void EngineCore::benchmarkAllocationTrace(const std::string& filePath)
+{
+	AllocationTrace trace;
+	if (!trace.load(filePath))
+	{
+		return;
+	}
+
+	// Both allocators get the same scratch heap, sized so the trace always fits
+	const size_t heapSize = trace.getPeakRequestedSize() * 2 + 16 * MEGA;
+	unsigned char* heap = (unsigned char*)malloc(heapSize);
+	if (!heap)
+	{
+		Log::Error("[EngineCore] Failed to allocate %zu bytes for the allocator benchmark", heapSize);
+		return;
+	}
+
+	Log::Info("[EngineCore] Replaying %zu allocation events from %s", trace.getNumEvents(), filePath.c_str());
+	{
+		FreeListAllocator freeListAllocator(heapSize, heap);
+		logAllocationReplay("FreeListAllocator", trace.replay(freeListAllocator));
+	}
+	{
+		TLSFAllocator tlsfAllocator(heapSize, heap);
+		logAllocationReplay("TLSFAllocator", trace.replay(tlsfAllocator));
+	}
+
+	free(heap);
+}
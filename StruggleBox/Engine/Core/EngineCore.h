@@ -3,7 +3,10 @@
 #include <string>
 
 class Allocator;
+class AllocationTrace;
 class ProxyAllocator;
+class RenderBackend;
+class ThreadCacheAllocator;
 class Injector;
 class Scene;
 
@@ -11,8 +14,7 @@ class EngineCore
 {
 public:
 	static EngineCore& create(const int argc,
-							  const char* arg[],
-							  unsigned char* heap);
+							  const char* arg[]);
 	static void destroy(EngineCore& engineCore);
 
 	void initialize();
@@ -22,25 +24,27 @@ public:
 	void setTitle(const std::string& title) { m_title = title; }
 
 	Injector& getGlobalInjector() const { return m_coreInjector; }
-	Allocator& getGlobalAllocator() const { return m_coreAllocator; }
+	Allocator& getGlobalAllocator() const;
 	ProxyAllocator& getRendererAllocator() const { return m_rendererAllocator; }
 
 private:
 	Injector& m_coreInjector;
-	Allocator& m_coreAllocator;
+	ThreadCacheAllocator& m_coreAllocator;
 	ProxyAllocator& m_rendererAllocator;
+	RenderBackend* m_renderBackend;
 
 	bool m_quit;
 	double m_startTime;                       // Timestamp for the engine startup
 	double m_lastFrameTime, m_lastUpdateTime; // Temporary frame timestamps
 	std::string m_title;
+	AllocationTrace* m_allocationTrace;       // Set while the core allocator is being recorded
 
 	friend class Injector;
-	EngineCore(Injector& injector, Allocator& coreAllocator);
+	EngineCore(Injector& injector, ThreadCacheAllocator& coreAllocator);
 
 	void initCommandProcessor();
 	void initApplicationContext();
-	void initThreadPool();
+	void initJobSystem();
 	void initRenderer();
 	void initInjectorDependencies();
 
@@ -48,5 +52,9 @@ private:
 	void stop();
 
 	void pollEvents();
+
+	void startAllocationTrace();
+	void saveAllocationTrace(const std::string& filePath);
+	void benchmarkAllocationTrace(const std::string& filePath);
 };
 
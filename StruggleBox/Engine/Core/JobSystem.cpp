@@ -0,0 +1,177 @@
+#include "JobSystem.h"
+
+#include "Profiler.h"
+#include <string>
+
+// Lets a worker find its own queue when it adds jobs or helps out
+static thread_local const JobSystem* s_workerSystem = nullptr;
+static thread_local int s_workerIndex = -1;
+
+JobSystem::JobSystem(size_t numWorkers)
+    : m_pendingJobs(0)
+    , m_sleepingWorkers(0)
+    , m_isRunning(true)
+{
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        m_queues.emplace_back(new JobQueue());
+    }
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, (int)i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    // Workers finish whatever is still queued before they exit
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_isRunning = false;
+    }
+    m_wakeCondition.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::wait(const JobCounter& counter)
+{
+    while (!counter.isDone())
+    {
+        if (!runPendingJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::runPendingJob()
+{
+    Job job;
+    if (!popJob(job))
+    {
+        return false;
+    }
+    runJob(job);
+    return true;
+}
+
+void JobSystem::push(JobPriority priority, const Job& job)
+{
+    if (job.counter)
+    {
+        job.counter->m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (m_workers.empty())
+    {
+        Job inlineJob = job;
+        runJob(inlineJob);
+        return;
+    }
+
+    // Counted before it is published, a worker could otherwise pop and decrement first
+    m_pendingJobs.fetch_add(1);
+    JobQueue& queue = s_workerSystem == this ? *m_queues[s_workerIndex] : m_sharedQueue;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs[(size_t)priority].push_back(job);
+    }
+
+    // Only touch the sleep mutex when someone is actually asleep
+    if (m_sleepingWorkers.load() > 0)
+    {
+        { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+        m_wakeCondition.notify_one();
+    }
+}
+
+bool JobSystem::popJob(Job& job)
+{
+    if (m_pendingJobs.load(std::memory_order_relaxed) == 0)
+    {
+        return false;
+    }
+    const int self = s_workerSystem == this ? s_workerIndex : -1;
+    const int numQueues = (int)m_queues.size();
+    for (size_t priority = 0; priority < (size_t)JobPriority::Count; priority++)
+    {
+        // Own newest job first, it is the most likely to still be in cache
+        if (self >= 0)
+        {
+            JobQueue& queue = *m_queues[self];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            std::deque<Job>& jobs = queue.jobs[priority];
+            if (!jobs.empty())
+            {
+                job = jobs.back();
+                jobs.pop_back();
+                m_pendingJobs.fetch_sub(1);
+                return true;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_sharedQueue.mutex);
+            std::deque<Job>& jobs = m_sharedQueue.jobs[priority];
+            if (!jobs.empty())
+            {
+                job = jobs.front();
+                jobs.pop_front();
+                m_pendingJobs.fetch_sub(1);
+                return true;
+            }
+        }
+        // Steal the oldest job of another worker
+        for (int offset = 1; offset <= numQueues; offset++)
+        {
+            const int victim = (self + offset + numQueues) % numQueues;
+            if (victim == self)
+            {
+                continue;
+            }
+            JobQueue& queue = *m_queues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            std::deque<Job>& jobs = queue.jobs[priority];
+            if (!jobs.empty())
+            {
+                job = jobs.front();
+                jobs.pop_front();
+                m_pendingJobs.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void JobSystem::runJob(Job& job)
+{
+    job.invoke(job.storage);
+    if (job.counter)
+    {
+        job.counter->m_count.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void JobSystem::workerLoop(const int workerIndex)
+{
+    s_workerSystem = this;
+    s_workerIndex = workerIndex;
+    Profiler::setThreadName(("Worker " + std::to_string(workerIndex)).c_str());
+    while (true)
+    {
+        if (runPendingJob())
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepingWorkers.fetch_add(1);
+        m_wakeCondition.wait(lock, [this]() { return !m_isRunning || m_pendingJobs.load() > 0; });
+        m_sleepingWorkers.fetch_sub(1);
+        if (!m_isRunning && m_pendingJobs.load() == 0)
+        {
+            return;
+        }
+    }
+}
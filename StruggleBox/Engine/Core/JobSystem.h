@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+const size_t JOB_STORAGE_SIZE = 48; // Bytes available to the callable of a job
+
+enum class JobPriority : uint8_t {
+    High,
+    Normal,
+    Low,
+    Count
+};
+
+/// Counts unfinished jobs, every job added with a counter increments it
+/// and decrements it again once it has run
+class JobCounter
+{
+public:
+    JobCounter() : m_count(0) {}
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool isDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> m_count;
+};
+
+///  Runs jobs on a set of worker threads, each with its own queue
+///  Workers take their newest job first and steal the oldest jobs of
+///  others when they run dry, jobs added from outside the workers are
+///  taken in the order they were added
+///  With no workers jobs run right away on the thread adding them
+class JobSystem
+{
+public:
+    JobSystem(size_t numWorkers);
+    ~JobSystem();
+
+    /// Jobs are copied into fixed storage without allocating, so the callable
+    /// has to be small and trivially copyable - a lambda capturing pointers,
+    /// references and plain values
+    template<class F>
+    void addJob(JobPriority priority, JobCounter* counter, const F& func)
+    {
+        static_assert(sizeof(F) <= JOB_STORAGE_SIZE, "Job callable too large, capture a pointer to the data instead");
+        static_assert(std::is_trivially_copyable<F>::value, "Job callable must be trivially copyable");
+        static_assert(alignof(F) <= 16, "Job callable alignment too large");
+        Job job;
+        job.invoke = [](const void* storage) { (*(const F*)storage)(); };
+        job.counter = counter;
+        memcpy(job.storage, &func, sizeof(F));
+        push(priority, job);
+    }
+
+    /// Calls func(index) for every index in [begin, end), split into jobs of
+    /// grainSize indices, and helps run them until all are done
+    template<class F>
+    void parallelFor(size_t begin, size_t end, size_t grainSize, const F& func)
+    {
+        if (grainSize == 0) { grainSize = 1; }
+        JobCounter counter;
+        const F* funcPtr = &func;
+        for (size_t rangeBegin = begin; rangeBegin < end; rangeBegin += grainSize)
+        {
+            const size_t rangeEnd = rangeBegin + grainSize < end ? rangeBegin + grainSize : end;
+            addJob(JobPriority::High, &counter, [funcPtr, rangeBegin, rangeEnd]() {
+                for (size_t index = rangeBegin; index < rangeEnd; index++)
+                {
+                    (*funcPtr)(index);
+                }
+            });
+        }
+        wait(counter);
+    }
+
+    /// Runs queued jobs on the calling thread until the counter reaches zero
+    void wait(const JobCounter& counter);
+    /// Runs one queued job on the calling thread, returns false if none was found
+    bool runPendingJob();
+
+    size_t numJobs() const { return (size_t)m_pendingJobs.load(std::memory_order_relaxed); }
+    size_t numWorkers() const { return m_workers.size(); }
+
+private:
+    struct Job {
+        void (*invoke)(const void* storage);
+        JobCounter* counter;
+        alignas(16) unsigned char storage[JOB_STORAGE_SIZE];
+    };
+
+    struct JobQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs[(size_t)JobPriority::Count];
+    };
+
+    std::vector<std::thread> m_workers;
+    // One queue per worker plus one shared queue for jobs added from other threads
+    std::vector<std::unique_ptr<JobQueue>> m_queues;
+    JobQueue m_sharedQueue;
+
+    std::atomic<int> m_pendingJobs;
+    std::atomic<int> m_sleepingWorkers;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeCondition;
+    std::atomic<bool> m_isRunning;
+
+    void push(JobPriority priority, const Job& job);
+    bool popJob(Job& job);
+    void runJob(Job& job);
+    void workerLoop(const int workerIndex);
+};
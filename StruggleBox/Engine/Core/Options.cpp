@@ -131,6 +131,7 @@ void Options::setDefaults()
     
     addOption<std::string>("version", "0");
     addOption("h_multiThreading", true);
+    addOption("h_hugePages", false);
     
     addOption("r_resolutionX", 1920);
     addOption("r_resolutionY", 1080);
@@ -139,6 +140,7 @@ void Options::setDefaults()
     addOption("r_deferred", true);
     addOption("r_fullScreen", false);
     addOption("r_debug", false);
+    addOption("r_nullBackend", false);
     
     addOption("r_vSync", true);
     addOption("r_fsAA", false);
@@ -223,6 +225,8 @@ void Options::setDefaults()
     addOption("e_gridSize", 1.0f);
     addOption("e_gridSnap", false);
     
+    addOption("w_chunkCacheMB", 64);
+
     addOption("n_networkEnabled", false);
     addOption("d_physics", false);
 }
@@ -13,6 +13,7 @@
 //  e_ = editor options
 //  a_ = audio options
 //  n_ = network options
+//  w_ = world options
 //  d_ = debug options
 
 class Options
@@ -0,0 +1,339 @@
+#include "Profiler.h"
+
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+static const double SUMMARY_SMOOTHING = 0.05;   // Weight of the newest frame in the average
+static const uint32_t SUMMARY_KEEP_FRAMES = 60; // Scopes not seen for this long drop out of the summary
+
+/// Written by the owning thread, read by the main thread in endFrame,
+/// a slot that is being overwritten while it's read gets thrown away
+struct ProfileEvent
+{
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> start;
+    std::atomic<uint64_t> end;
+    std::atomic<uint32_t> depth;
+};
+
+struct ThreadProfile
+{
+    uint32_t id;
+    std::string name;                   // Guarded by the thread list mutex
+    uint32_t depth;                     // Owning thread only
+    std::atomic<uint64_t> writeIndex;   // Events ever recorded
+    uint64_t readIndex;                 // Main thread only
+    ProfileEvent events[Profiler::EVENTS_PER_THREAD];
+};
+
+struct CollectedEvent
+{
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    uint32_t depth;
+    uint32_t threadID;
+};
+
+struct ScopeStats
+{
+    ProfileScopeSummary summary;
+    uint64_t frameNs;
+    uint64_t firstStartOffset;          // When it first started in the last frame it was seen in, sorts the summary
+    uint32_t frameCalls;
+    uint32_t framesSinceSeen;
+};
+
+static std::mutex s_threadsMutex;
+static std::vector<std::unique_ptr<ThreadProfile>> s_threads;
+static thread_local ThreadProfile* t_profile = nullptr;
+
+// Main thread only
+static std::vector<CollectedEvent> s_frameEvents;
+static std::vector<ScopeStats> s_scopes;
+static std::vector<std::pair<const char*, size_t>> s_scopeLookup; // Name pointer to s_scopes index
+static std::vector<ProfileScopeSummary> s_summary;
+static uint64_t s_lastFrameEnd = 0;
+static uint64_t s_droppedEvents = 0;
+static uint32_t s_captureFramesLeft = 0;
+static std::string s_capturePath;
+static std::vector<CollectedEvent> s_captureEvents;
+
+static ThreadProfile& getThreadProfile()
+{
+    if (t_profile == nullptr)
+    {
+        std::unique_ptr<ThreadProfile> profile(new ThreadProfile());
+        profile->depth = 0;
+        profile->writeIndex.store(0, std::memory_order_relaxed);
+        profile->readIndex = 0;
+
+        std::lock_guard<std::mutex> lock(s_threadsMutex);
+        profile->id = (uint32_t)s_threads.size() + 1;
+        profile->name = "Thread " + std::to_string(profile->id);
+        t_profile = profile.get();
+        s_threads.push_back(std::move(profile));
+    }
+    return *t_profile;
+}
+
+static ScopeStats& getScopeStats(const char* name, const uint32_t threadID)
+{
+    for (const auto& pair : s_scopeLookup)
+    {
+        if (pair.first == name)
+        {
+            return s_scopes[pair.second];
+        }
+    }
+
+    // The same name can come from several string literals
+    size_t index = 0;
+    while (index < s_scopes.size() && strcmp(s_scopes[index].summary.name, name) != 0)
+    {
+        index++;
+    }
+    if (index == s_scopes.size())
+    {
+        ScopeStats stats = {};
+        stats.summary.name = name;
+        stats.summary.threadID = threadID;
+        stats.summary.depth = UINT32_MAX;
+        s_scopes.push_back(stats);
+    }
+    s_scopeLookup.emplace_back(name, index);
+    return s_scopes[index];
+}
+
+static void writeEscaped(std::ofstream& file, const char* text)
+{
+    for (const char* c = text; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            file << '\\';
+        }
+        file << *c;
+    }
+}
+
+void Profiler::setThreadName(const char* name)
+{
+    ThreadProfile& profile = getThreadProfile();
+    std::lock_guard<std::mutex> lock(s_threadsMutex);
+    profile.name = name;
+}
+
+void Profiler::endFrame()
+{
+    const uint64_t frameEnd = now();
+    s_frameEvents.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(s_threadsMutex);
+        for (const std::unique_ptr<ThreadProfile>& profile : s_threads)
+        {
+            const uint64_t writeIndex = profile->writeIndex.load(std::memory_order_acquire);
+            uint64_t first = profile->readIndex;
+            if (writeIndex - first > EVENTS_PER_THREAD)
+            {
+                s_droppedEvents += writeIndex - EVENTS_PER_THREAD - first;
+                first = writeIndex - EVENTS_PER_THREAD;
+            }
+
+            const size_t firstCollected = s_frameEvents.size();
+            for (uint64_t index = first; index < writeIndex; index++)
+            {
+                const ProfileEvent& event = profile->events[index % EVENTS_PER_THREAD];
+                CollectedEvent collected;
+                collected.name = event.name.load(std::memory_order_relaxed);
+                collected.start = event.start.load(std::memory_order_relaxed);
+                collected.end = event.end.load(std::memory_order_relaxed);
+                collected.depth = event.depth.load(std::memory_order_relaxed);
+                collected.threadID = profile->id;
+                s_frameEvents.push_back(collected);
+            }
+
+            // Anything the thread has wrapped around to since may have been half overwritten
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t latestIndex = profile->writeIndex.load(std::memory_order_relaxed);
+            if (latestIndex >= first + EVENTS_PER_THREAD)
+            {
+                const uint64_t torn = std::min<uint64_t>(latestIndex - EVENTS_PER_THREAD + 1 - first, writeIndex - first);
+                s_frameEvents.erase(s_frameEvents.begin() + firstCollected, s_frameEvents.begin() + firstCollected + (size_t)torn);
+                s_droppedEvents += torn;
+            }
+
+            profile->readIndex = writeIndex;
+        }
+    }
+
+    for (const CollectedEvent& event : s_frameEvents)
+    {
+        ScopeStats& stats = getScopeStats(event.name, event.threadID);
+        const uint64_t startOffset = event.start > s_lastFrameEnd ? event.start - s_lastFrameEnd : 0;
+        if (stats.frameCalls == 0 || startOffset < stats.firstStartOffset)
+        {
+            stats.firstStartOffset = startOffset;
+        }
+        stats.frameNs += event.end - event.start;
+        stats.frameCalls++;
+        stats.summary.depth = std::min(stats.summary.depth, event.depth);
+    }
+
+    std::vector<const ScopeStats*> visibleScopes;
+    for (ScopeStats& stats : s_scopes)
+    {
+        ProfileScopeSummary& summary = stats.summary;
+        summary.calls = stats.frameCalls;
+        summary.lastMs = stats.frameNs / 1000000.0;
+        summary.averageMs += (summary.lastMs - summary.averageMs) * SUMMARY_SMOOTHING;
+        summary.maxMs = std::max(summary.maxMs, summary.lastMs);
+        stats.framesSinceSeen = stats.frameCalls ? 0 : stats.framesSinceSeen + 1;
+        stats.frameNs = 0;
+        stats.frameCalls = 0;
+        if (stats.framesSinceSeen < SUMMARY_KEEP_FRAMES)
+        {
+            visibleScopes.push_back(&stats);
+        }
+    }
+    std::sort(visibleScopes.begin(), visibleScopes.end(), [](const ScopeStats* a, const ScopeStats* b) {
+        if (a->summary.threadID != b->summary.threadID) { return a->summary.threadID < b->summary.threadID; }
+        return a->firstStartOffset < b->firstStartOffset;
+    });
+    s_summary.clear();
+    for (const ScopeStats* stats : visibleScopes)
+    {
+        s_summary.push_back(stats->summary);
+    }
+    s_lastFrameEnd = frameEnd;
+
+    if (s_captureFramesLeft > 0)
+    {
+        s_captureEvents.insert(s_captureEvents.end(), s_frameEvents.begin(), s_frameEvents.end());
+        if (--s_captureFramesLeft == 0)
+        {
+            writeCapture();
+        }
+    }
+}
+
+void Profiler::startCapture(const uint32_t numFrames, const std::string& filePath)
+{
+    if (numFrames == 0)
+    {
+        Log::Warn("[Profiler] Nothing to capture in zero frames");
+        return;
+    }
+    if (s_captureFramesLeft > 0)
+    {
+        Log::Warn("[Profiler] Already capturing to %s", s_capturePath.c_str());
+        return;
+    }
+
+    s_captureFramesLeft = numFrames;
+    s_capturePath = filePath;
+    s_captureEvents.clear();
+    s_droppedEvents = 0;
+    Log::Info("[Profiler] Capturing %u frames", numFrames);
+}
+
+bool Profiler::isCapturing()
+{
+    return s_captureFramesLeft > 0;
+}
+
+const std::vector<ProfileScopeSummary>& Profiler::getSummary()
+{
+    return s_summary;
+}
+
+uint64_t Profiler::now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t Profiler::beginScope()
+{
+    getThreadProfile().depth++;
+    return now();
+}
+
+void Profiler::endScope(const char* name, const uint64_t start)
+{
+    const uint64_t end = now();
+    ThreadProfile& profile = *t_profile;
+    profile.depth--;
+
+    // Tells the reader a slot is being reused before any of it changes
+    const uint64_t index = profile.writeIndex.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    ProfileEvent& event = profile.events[index % EVENTS_PER_THREAD];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    event.depth.store(profile.depth, std::memory_order_relaxed);
+    profile.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::writeCapture()
+{
+    std::ofstream file(s_capturePath.c_str(), std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+    {
+        Log::Error("[Profiler] Failed to open %s for writing", s_capturePath.c_str());
+        s_captureEvents.clear();
+        return;
+    }
+
+    uint64_t captureStart = UINT64_MAX;
+    for (const CollectedEvent& event : s_captureEvents)
+    {
+        captureStart = std::min(captureStart, event.start);
+    }
+
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(s_threadsMutex);
+        for (const std::unique_ptr<ThreadProfile>& profile : s_threads)
+        {
+            file << (first ? "" : ",\n");
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << profile->id << ",\"args\":{\"name\":\"";
+            writeEscaped(file, profile->name.c_str());
+            file << "\"}},\n";
+            file << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << profile->id << ",\"args\":{\"sort_index\":" << profile->id << "}}";
+            first = false;
+        }
+    }
+
+    char timing[64];
+    for (const CollectedEvent& event : s_captureEvents)
+    {
+        file << (first ? "" : ",\n");
+        file << "{\"name\":\"";
+        writeEscaped(file, event.name);
+        snprintf(timing, sizeof(timing), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+            (event.start - captureStart) / 1000.0, (event.end - event.start) / 1000.0);
+        file << timing << ",\"pid\":1,\"tid\":" << event.threadID << "}";
+        first = false;
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    file.close();
+
+    Log::Info("[Profiler] Saved %zu scopes to %s", s_captureEvents.size(), s_capturePath.c_str());
+    if (s_droppedEvents > 0)
+    {
+        Log::Warn("[Profiler] Dropped %llu scopes, a thread recorded more than %zu in one frame",
+            (unsigned long long)s_droppedEvents, EVENTS_PER_THREAD);
+    }
+    s_captureEvents.clear();
+    s_captureEvents.shrink_to_fit();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compile with DISABLE_PROFILING to strip every scope out of the build
+#ifndef DISABLE_PROFILING
+#define PROFILING
+#endif
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef PROFILING
+/// Times the rest of the enclosing block, name has to outlive the program
+/// so string literals only
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#endif
+
+/// Time spent in one scope name over the last frames, summed across threads
+struct ProfileScopeSummary
+{
+    const char* name;
+    uint32_t threadID;      // Thread the scope was first seen on
+    uint32_t depth;         // Shallowest nesting the scope was seen at
+    uint32_t calls;         // Last frame
+    double lastMs;          // Last frame
+    double averageMs;       // Smoothed over the last frames
+    double maxMs;           // Longest frame total since the scope was first seen
+};
+
+///  Records nested timed scopes into a ring buffer per thread
+///  Recording a scope is two clock reads and a few stores, nothing
+///  is locked or allocated once a thread has its buffer
+///  Once a frame the main thread drains every buffer into the per-scope
+///  summary and, while capturing, into a trace that is written out as
+///  Chrome trace JSON (chrome://tracing or ui.perfetto.dev)
+class Profiler
+{
+public:
+    static const size_t EVENTS_PER_THREAD = 16384;  // Scopes a thread can record between two frames
+
+    /// Names the calling thread in captures, the first call on a thread
+    /// also sets up its buffer
+    static void setThreadName(const char* name);
+
+    /// Collects everything recorded since the last call, main thread only
+    static void endFrame();
+
+    /// Records the next numFrames frames and writes them to filePath
+    static void startCapture(const uint32_t numFrames, const std::string& filePath);
+    static bool isCapturing();
+
+    /// Sorted by thread, then by when the scope first started
+    static const std::vector<ProfileScopeSummary>& getSummary();
+
+    /// Nanoseconds on a steady clock
+    static uint64_t now();
+
+private:
+    friend class ProfileScope;
+
+    static uint64_t beginScope();
+    static void endScope(const char* name, const uint64_t start);
+
+    static void writeCapture();
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name) : m_name(name), m_start(Profiler::beginScope()) {}
+    ~ProfileScope() { Profiler::endScope(m_name, m_start); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_start;
+};
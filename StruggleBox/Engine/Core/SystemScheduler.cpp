@@ -0,0 +1,123 @@
+#include "SystemScheduler.h"
+#include "JobSystem.h"
+#include "Log.h"
+#include "Profiler.h"
+#include <algorithm>
+
+SystemScheduler::SystemScheduler(JobSystem& jobSystem)
+    : m_jobSystem(jobSystem)
+    , m_stagesDirty(false)
+{
+}
+
+void SystemScheduler::addSystem(
+    const std::string& name,
+    const SystemResources reads,
+    const SystemResources writes,
+    const UpdateFunc& update)
+{
+    if (!update)
+    {
+        Log::Error("[SystemScheduler] System %s has no update function", name.c_str());
+        return;
+    }
+    m_systems.push_back({ name, reads, writes, 0, update, nullptr, nullptr });
+    m_stagesDirty = true;
+}
+
+void SystemScheduler::addParallelSystem(
+    const std::string& name,
+    const SystemResources reads,
+    const SystemResources writes,
+    const size_t grainSize,
+    const CountFunc& count,
+    const UpdateIndexFunc& updateIndex)
+{
+    if (!count || !updateIndex)
+    {
+        Log::Error("[SystemScheduler] Parallel system %s has no count or update function", name.c_str());
+        return;
+    }
+    m_systems.push_back({ name, reads, writes, std::max<size_t>(grainSize, 1), nullptr, count, updateIndex });
+    m_stagesDirty = true;
+}
+
+void SystemScheduler::run()
+{
+    PROFILE_SCOPE("SystemScheduler::run");
+    if (m_stagesDirty)
+    {
+        buildStages();
+    }
+    for (const std::vector<size_t>& stage : m_stages)
+    {
+        // Queue the parallel systems first so workers get going while this thread runs the rest
+        JobCounter counter;
+        for (const size_t systemIndex : stage)
+        {
+            const System* system = &m_systems[systemIndex];
+            if (system->grainSize == 0)
+            {
+                continue;
+            }
+            const size_t count = system->count();
+            for (size_t begin = 0; begin < count; begin += system->grainSize)
+            {
+                const size_t end = std::min(begin + system->grainSize, count);
+                m_jobSystem.addJob(JobPriority::High, &counter, [system, begin, end]() {
+                    for (size_t index = begin; index < end; index++)
+                    {
+                        system->updateIndex(index);
+                    }
+                });
+            }
+        }
+        for (const size_t systemIndex : stage)
+        {
+            const System& system = m_systems[systemIndex];
+            if (system.grainSize == 0)
+            {
+                system.update();
+            }
+        }
+        m_jobSystem.wait(counter);
+    }
+}
+
+size_t SystemScheduler::getNumStages()
+{
+    if (m_stagesDirty)
+    {
+        buildStages();
+    }
+    return m_stages.size();
+}
+
+void SystemScheduler::buildStages()
+{
+    // Each system goes one stage after the latest earlier system it conflicts with
+    std::vector<size_t> systemStages(m_systems.size(), 0);
+    m_stages.clear();
+    for (size_t i = 0; i < m_systems.size(); i++)
+    {
+        const System& system = m_systems[i];
+        size_t stage = 0;
+        for (size_t j = 0; j < i; j++)
+        {
+            const System& earlier = m_systems[j];
+            const bool conflicts = (earlier.writes & (system.reads | system.writes)) != 0 ||
+                (earlier.reads & system.writes) != 0;
+            if (conflicts)
+            {
+                stage = std::max(stage, systemStages[j] + 1);
+            }
+        }
+        systemStages[i] = stage;
+        if (stage >= m_stages.size())
+        {
+            m_stages.resize(stage + 1);
+        }
+        m_stages[stage].push_back(i);
+    }
+    m_stagesDirty = false;
+}
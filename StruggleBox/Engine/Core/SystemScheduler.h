@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+typedef uint32_t SystemResources;   // One bit for every resource a system touches
+
+///  Runs a set of update systems once per frame
+///  Every system declares the resources it reads and writes. A system waits
+///  for each earlier system it conflicts with - one writing what it reads or
+///  writes, or reading what it writes - and systems that don't conflict share
+///  a stage and run side by side. Conflicting systems keep the order they were
+///  added in, so results are the same as running them one after another
+class SystemScheduler
+{
+public:
+    typedef std::function<void()> UpdateFunc;
+    typedef std::function<size_t()> CountFunc;
+    typedef std::function<void(size_t)> UpdateIndexFunc;
+
+    SystemScheduler(JobSystem& jobSystem);
+
+    /// Runs on the thread calling run(), for systems touching state that isn't thread safe
+    void addSystem(
+        const std::string& name,
+        const SystemResources reads,
+        const SystemResources writes,
+        const UpdateFunc& update);
+
+    /// Splits the indices [0, count()) into jobs of grainSize indices that may run
+    /// on any thread, updateIndex must only touch data belonging to its own index
+    void addParallelSystem(
+        const std::string& name,
+        const SystemResources reads,
+        const SystemResources writes,
+        const size_t grainSize,
+        const CountFunc& count,
+        const UpdateIndexFunc& updateIndex);
+
+    void run();
+
+    size_t getNumSystems() const { return m_systems.size(); }
+    size_t getNumStages();
+
+private:
+    struct System {
+        std::string name;
+        SystemResources reads;
+        SystemResources writes;
+        size_t grainSize;               // 0 for systems running on the calling thread
+        UpdateFunc update;
+        CountFunc count;
+        UpdateIndexFunc updateIndex;
+    };
+
+    JobSystem& m_jobSystem;
+    std::vector<System> m_systems;
+    std::vector<std::vector<size_t>> m_stages;   // System indices in the order they were added
+    bool m_stagesDirty;
+
+    void buildStages();
+};
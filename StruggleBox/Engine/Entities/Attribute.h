@@ -71,7 +71,8 @@ public:
             Log::Error("[Attribute] magic number mismatch, wrong data type");
             assert(false);
         }
-        return std::static_pointer_cast< AttributeValue<T_> >(_value)->value;
+        // Plain pointer cast, a shared_ptr cast would touch the reference count on every access
+        return static_cast<AttributeValue<T_>*>(_value.get())->value;
     }
     
     const int GetMagicNumber() const { return _value->magic_number; };
@@ -0,0 +1,64 @@
+#include "AttributeKey.h"
+#include "Log.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Function statics so keys defined at namespace scope in other files can intern safely
+static std::mutex& getRegistryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::unordered_map<std::string, AttributeID>& getRegistryIDs()
+{
+    static std::unordered_map<std::string, AttributeID> ids;
+    return ids;
+}
+
+// Names are never removed and each has its own allocation, so returned references stay valid
+static std::vector<std::string*>& getRegistryNames()
+{
+    static std::vector<std::string*> names;
+    return names;
+}
+
+AttributeID AttributeRegistry::intern(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(getRegistryMutex());
+    std::unordered_map<std::string, AttributeID>& ids = getRegistryIDs();
+    auto it = ids.find(name);
+    if (it != ids.end())
+    {
+        return it->second;
+    }
+    std::vector<std::string*>& names = getRegistryNames();
+    if (names.size() >= INVALID_ATTRIBUTE_ID)
+    {
+        Log::Error("[AttributeRegistry] Out of attribute IDs interning %s", name.c_str());
+        return INVALID_ATTRIBUTE_ID;
+    }
+    const AttributeID attributeID = (AttributeID)names.size();
+    names.push_back(new std::string(name));
+    ids[name] = attributeID;
+    return attributeID;
+}
+
+const std::string& AttributeRegistry::getName(const AttributeID attributeID)
+{
+    static const std::string invalidName;
+    std::lock_guard<std::mutex> lock(getRegistryMutex());
+    std::vector<std::string*>& names = getRegistryNames();
+    if (attributeID >= names.size())
+    {
+        return invalidName;
+    }
+    return *names[attributeID];
+}
+
+size_t AttributeRegistry::getCount()
+{
+    std::lock_guard<std::mutex> lock(getRegistryMutex());
+    return getRegistryNames().size();
+}
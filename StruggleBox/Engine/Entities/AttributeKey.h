@@ -0,0 +1,39 @@
+#ifndef ATTRIBUTE_KEY_H
+#define ATTRIBUTE_KEY_H
+
+#include <cstdint>
+#include <string>
+
+typedef uint16_t AttributeID;
+const AttributeID INVALID_ATTRIBUTE_ID = UINT16_MAX; // Handed out once every ID is taken, such keys use the name instead
+
+///  Interns attribute names, every name gets a small ID the first time
+///  it is seen and keeps it for the rest of the run
+class AttributeRegistry
+{
+public:
+    static AttributeID intern(const std::string& name);
+    static const std::string& getName(const AttributeID attributeID);
+    static size_t getCount();
+};
+
+///  Typed handle to an interned attribute name
+///  Resolve the name once, at startup or registration, and use the key
+///  for per frame access: Entity::GetAttributeData(key) is an array index
+///  instead of a string lookup
+template<typename T>
+class AttributeKey
+{
+public:
+    explicit AttributeKey(const char* name) : m_id(AttributeRegistry::intern(name)), m_name(name) {}
+
+    AttributeID getID() const { return m_id; }
+    bool isValid() const { return m_id != INVALID_ATTRIBUTE_ID; }
+    const std::string& getName() const { return m_name; }
+
+private:
+    AttributeID m_id;
+    std::string m_name;
+};
+
+#endif /* ATTRIBUTE_KEY_H */
@@ -71,13 +71,35 @@ void Entity::RemoveAttribute(const std::string& attrName)
     std::map<const std::string, Attribute*>::iterator it;
     it = m_Attributes.find( attrName );
     if ( it != m_Attributes.end() ) {
+        SetAttributeByID(attrName, NULL);
+        delete it->second;
         m_Attributes.erase( it );
     }
 }
 
 void Entity::ClearAttributes()
 {
+    for (auto& pair : m_Attributes) {
+        delete pair.second;
+    }
     m_Attributes.clear();
+    m_attributesByID.clear();
+}
+
+void Entity::SetAttributeByID(const std::string& attrName, Attribute* attribute)
+{
+    SetAttributeSlot(AttributeRegistry::intern(attrName), attribute);
+}
+
+void Entity::SetAttributeSlot(const AttributeID attributeID, Attribute* attribute)
+{
+    if (attributeID == INVALID_ATTRIBUTE_ID) {
+        return; // Only reachable by name
+    }
+    if (attributeID >= m_attributesByID.size()) {
+        m_attributesByID.resize(attributeID + 1, NULL);
+    }
+    m_attributesByID[attributeID] = attribute;
 }
 
 template<typename T> void Entity::AddAttribute(const std::string& attrName)
@@ -85,6 +107,7 @@ template<typename T> void Entity::AddAttribute(const std::string& attrName)
     if ( m_Attributes.find( attrName ) == m_Attributes.end() ) {
         Attribute* newAttrib = new Attribute(T());
         m_Attributes[attrName] = (Attribute*)newAttrib;
+        SetAttributeByID(attrName, newAttrib);
     } else {
         printf("[Entity] attrib %s already added \n", attrName.c_str());
     }
@@ -96,6 +119,7 @@ template<typename T> void Entity::AddAttribute(const std::string& attrName,
     if ( m_Attributes.find( attrName ) == m_Attributes.end() ) {
         Attribute* newAttrib = new Attribute(value);
         m_Attributes[attrName] = (Attribute*)newAttrib;
+        SetAttributeByID(attrName, newAttrib);
     } else {
         printf("[Entity] attrib %s already added \n", attrName.c_str());
     }
@@ -2,6 +2,7 @@
 #define ENTITY_H
 
 #include "Attribute.h"
+#include "AttributeKey.h"
 #include <string>
 #include <map>
 #include <vector>
@@ -62,12 +63,58 @@ class Entity
 public:
     Entity(const std::string& name);
     ~Entity();
+    // Entities own their attributes
+    Entity(const Entity&) = delete;
+    Entity& operator=(const Entity&) = delete;
 
     // Entity Interface
     const EntityID GetID() const;
 
     // Attribute Interface
     bool HasAttribute(const std::string& attrName) const;
+    template<typename T> bool HasAttribute(const AttributeKey<T>& key) const
+    {
+        if (!key.isValid())
+        {
+            return HasAttribute(key.getName());
+        }
+        return key.getID() < m_attributesByID.size() && m_attributesByID[key.getID()] != NULL;
+    }
+
+    // Same as GetAttributeDataPtr, but indexed by the interned key instead of looking up the name
+    // Keys that didn't get an ID go through the name
+    template<typename T> T& GetAttributeData(const AttributeKey<T>& key)
+    {
+        return GetAttributeData<T>(key.getID(), key.getName());
+    }
+
+    // For callers that interned the name themselves, the name is only used to add a missing attribute
+    template<typename T> T& GetAttributeData(const AttributeID attributeID, const std::string& attrName)
+    {
+        if (attributeID == INVALID_ATTRIBUTE_ID)
+        {
+            return GetAttributeDataPtr<T>(attrName);
+        }
+        Attribute* a = attributeID < m_attributesByID.size() ? m_attributesByID[attributeID] : NULL;
+        if (a != NULL)
+        {
+            if (a->GetMagicNumber() != Attribute::magic_number_for<T>())
+            {
+                return GetAttributeDataPtr<T>(attrName);
+            }
+            attributeUpdate = true;
+            return a->as<T>();
+        }
+        // The ID table mirrors the name map, so the attribute is missing and can be inserted without a lookup
+        Attribute* newAttrib = new Attribute(T());
+        if (!m_Attributes.emplace(attrName, newAttrib).second)
+        {
+            delete newAttrib;
+            return GetAttributeDataPtr<T>(attrName);
+        }
+        SetAttributeSlot(attributeID, newAttrib);
+        return newAttrib->as<T>();
+    }
     
     template<typename T> T& GetAttributeDataPtr(const std::string& attrName)
     {
@@ -105,6 +152,9 @@ private:
     EntityID m_ID;
     bool attributeUpdate;
     std::map<const std::string, Attribute*> m_Attributes;
+    std::vector<Attribute*> m_attributesByID;   // Same attributes indexed by AttributeID, NULL where missing
+    void SetAttributeByID(const std::string& attrName, Attribute* attribute);
+    void SetAttributeSlot(const AttributeID attributeID, Attribute* attribute);
     template<typename T> Attribute* GetAttribute(const std::string& attrName);
     template<typename T> const Attribute* GetAttribute(const std::string& attrName) const;
 };
@@ -1,6 +1,7 @@
 #include "GUI.h"
 
 #include "DefaultShaders.h"
+#include "GFXDefines.h"
 #include "RenderCore.h"
 #include "FileUtil.h"
 #include "OSWindow.h"
@@ -20,6 +21,7 @@
 #include "Log.h"
 #include "Input.h"
 #include "MathUtils.h"
+#include "Profiler.h"
 #include <algorithm>
 
 const std::string GUI::FONT_DEFAULT = "Aldrich-Regular.ttf";
@@ -53,7 +55,7 @@ const std::string GUI::DEFAULT_PLIST = "Data/GFX/DrudgeUI.plist";
 const float GUI::DEFAULT_SLIDER_HEIGHT = 24.f;
 
 GUI::GUI(Allocator& allocator, RenderCore& renderCore, Input& input, OSWindow& window)
-	: m_allocator(allocator)
+	: m_allocator(allocator, MemoryTag::GUI)
 	, m_renderCore(renderCore)
 	, m_input(input)
 	, m_window(window)
@@ -103,6 +105,7 @@ void GUI::terminate()
 
 void GUI::draw()
 {
+	PROFILE_SCOPE("GUI::draw");
 	static const glm::vec3 ROOT_POSITION = glm::vec3();
 	static const glm::vec2 ROOT_SCALE = glm::vec2(1.f, 1.f);
 	m_root.draw(*this, ROOT_POSITION, ROOT_SCALE);
@@ -110,23 +113,26 @@ void GUI::draw()
 	const glm::ivec2 windowSize = m_renderCore.getRenderResolution();
 	const glm::mat4 projection = glm::ortho<float>(0.f, windowSize.x, 0.f, windowSize.y, ORTHO_NEARDEPTH, ORTHO_FARDEPTH);
 
+	// Layers keep sprites under text and text under lines, draws within a layer are grouped by texture
+
 	for (const auto& pair : m_texturedTriVertsBuffers)
 	{
 		const TextureID textureID = pair.first;
 		const TempVertBuffer& buffer = pair.second;
-		m_renderCore.draw(m_texturedVertsShaderID, textureID, m_texturedVertsDrawDataID, projection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+		m_renderCore.queueDraw(RenderPass::GUI, 0, m_texturedVertsShaderID, textureID, m_texturedVertsDrawDataID, projection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
 	}
 	for (const auto& pair : m_textTriVertsBuffers)
 	{
 		const TextureID textureID = pair.first;
 		const TempVertBuffer& buffer = pair.second;
-		m_renderCore.draw(m_textVertsShaderID, textureID, m_textVertsDrawDataID, projection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+		m_renderCore.queueDraw(RenderPass::GUI, 1, m_textVertsShaderID, textureID, m_textVertsDrawDataID, projection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
 	}
 
 	if (m_lineVertsBuffer.count)
 	{
-		m_renderCore.draw(m_coloredLinesShaderID, 0, m_coloredLinesDrawDataID, projection, DrawMode::Lines, m_lineVertsBuffer.data, 0, m_lineVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+		m_renderCore.queueDraw(RenderPass::GUI, 2, m_coloredLinesShaderID, 0, m_coloredLinesDrawDataID, projection, DrawMode::Lines, m_lineVertsBuffer.data, 0, m_lineVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
 	}
+	m_renderCore.submitCommands();
 
 	m_texturedTriVertsBuffers.clear();
 	m_textTriVertsBuffers.clear();
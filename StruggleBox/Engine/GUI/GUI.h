@@ -5,6 +5,7 @@
 #include "Node.h"
 #include "InputListener.h"
 #include "RenderCore.h"
+#include "TaggedAllocator.h"
 #include <string>
 #include <vector>
 
@@ -103,7 +104,7 @@ public:
 	bool OnMouse(const glm::ivec2& coords);
 
 private:
-	Allocator& m_allocator;
+	mutable TaggedAllocator m_allocator;         // Node creation is const
 	RenderCore& m_renderCore;
 	Input& m_input;
 	OSWindow& m_window;
@@ -5,9 +5,12 @@
 #include "LabelNode.h"
 #include "LayoutNode.h"
 #include "Options.h"
+#include "Profiler.h"
 #include "StatTracker.h"
 #include "StringUtil.h"
 
+const size_t MAX_PROFILE_LINES = 24;
+
 StatsDisplay::StatsDisplay(GUI& gui, StatTracker& statTracker, Options& options)
 	: m_gui(gui)
 	, m_statTracker(statTracker)
@@ -56,6 +59,28 @@ void StatsDisplay::update()
 		labelIndex++;
 	}
 
+	// Profiler scopes indented by how deep they're nested, the rest of the labels are left empty
+	const std::vector<ProfileScopeSummary>& profileSummary = Profiler::getSummary();
+	for (size_t i = 0; i < MAX_PROFILE_LINES; i++)
+	{
+		if (i >= profileSummary.size() && i >= m_profileLabels.size())
+			break;
+
+		if (i >= m_profileLabels.size())
+		{
+			m_profileLabels.push_back(m_gui.createLabelNode("", GUI::FONT_MONOSPACE, 16));
+			m_layoutNode->addChild(m_profileLabels.back());
+		}
+
+		std::string text;
+		if (i < profileSummary.size())
+		{
+			const ProfileScopeSummary& scope = profileSummary[i];
+			text = StringUtil::Format("%*s%s: %.3f, Max: %.3f, Calls: %u", (int)scope.depth * 2, "", scope.name, scope.averageMs, scope.maxMs, scope.calls);
+		}
+		m_profileLabels[i]->setText(text);
+	}
+
 	m_layoutNode->refresh();
 
 	m_drawLinesNode->clear();
@@ -23,6 +23,7 @@ private:
 	LayoutNode* m_layoutNode;
 	DrawLinesNode* m_drawLinesNode;
 	std::vector<LabelNode*> m_textLabels;
+	std::vector<LabelNode*> m_profileLabels;
 
 	LabelNode* getLabelAtIndex(const size_t index, bool addToLayout);
 };
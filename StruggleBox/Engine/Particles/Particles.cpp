@@ -17,11 +17,12 @@
 #include "Log.h"
 #include "Random.h"
 #include "Timer.h"
+#include "Profiler.h"
 
 const size_t PARTICLE_POOL_SIZE = 16 * 1024 * 1024;
 
 Particles::Particles(Allocator& allocator, Injector& injector)
-	: m_allocator(allocator)
+	: m_allocator(allocator, MemoryTag::Particles)
 	, m_renderer2D(nullptr)
 	, m_renderer3D(nullptr)
 	, m_rendererPBR(nullptr)
@@ -57,6 +58,7 @@ Particles::~Particles()
 
 void Particles::update(double deltaTime)
 {
+	PROFILE_SCOPE("Particles::update");
 	for (const auto& pair : m_systems)
 	{
 		const ParticleSystemID systemID = pair.first;
@@ -109,6 +111,7 @@ void Particles::destroy(const ParticleSystemID systemID)
 
 void Particles::draw()
 {
+	PROFILE_SCOPE("Particles::draw");
 	for (const auto& pair : m_systems)
 	{
 		const ParticleSystemID systemID = pair.first;
@@ -4,6 +4,7 @@
 #include <map>
 
 #include "RendererDefines.h"
+#include "TaggedAllocator.h"
 
 class Allocator;
 class Injector;
@@ -30,7 +31,7 @@ public:
     void draw();
 
 private:
-    Allocator& m_allocator;
+    TaggedAllocator m_allocator;
 	Renderer2D* m_renderer2D;
     Renderer3D* m_renderer3D;
     Renderer3DDeferred* m_rendererPBR;
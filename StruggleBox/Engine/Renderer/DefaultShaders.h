@@ -1,11 +1,13 @@
 #pragma once
 
+#include "UniformBlocks.h"
+
 static const char* coloredVertexShaderSource =
 "#version 400\n"
 "layout (location = 0) in vec3 aPos;\n"
 "layout (location = 1) in vec4 aColor;\n"
 "out vec4 vFragColor;\n"
-"uniform mat4 viewProjection;\n"
+VIEW_CONSTANTS_GLSL
 "void main()\n"
 "{\n"
 "   gl_Position = viewProjection * vec4(aPos, 1.0);\n"
@@ -26,7 +28,7 @@ static const char* texturedVertexShaderSource =
 "layout (location = 0) in vec3 aPos;\n"
 "layout (location = 1) in vec2 aTexCoord;\n"
 "out vec2 texCoord;\n"
-"uniform mat4 viewProjection;\n"
+VIEW_CONSTANTS_GLSL
 "void main()\n"
 "{\n"
 "   gl_Position = viewProjection * vec4(aPos, 1.0);\n"
@@ -138,7 +140,7 @@ static const char* coloredInstanceVertexShaderSoure =
 "layout(location = 3) in float instance_size;\n"
 "layout(location = 4) in vec4 instance_rotation;\n"
 "layout(location = 5) in vec4 instance_color;\n"
-"uniform mat4 viewProjection;\n"
+VIEW_CONSTANTS_GLSL
 "out Fragment{\n"
 "    vec4 iColor;\n"
 "    smooth vec4 vColor;\n"
@@ -196,7 +198,7 @@ static const char* textured2DInstanceVertexShaderSoure =
 "layout(location = 2) in vec3 instance_position;\n"
 "layout(location = 3) in float instance_size;\n"
 "layout(location = 4) in vec4 instance_color;\n"
-"uniform mat4 viewProjection;\n"
+VIEW_CONSTANTS_GLSL
 "out vec2 texCoord;\n"
 "out vec4 color;\n"
 "void main()\n"
@@ -226,7 +228,7 @@ static const char* texturedPBRVertexShaderSource =
 "layout(location = 1) in vec3 v_normal;\n"
 "layout(location = 2) in vec3 v_tangent;\n"
 "layout(location = 3) in vec2 v_uv;\n"
-"uniform mat4 viewProjection;\n"
+VIEW_CONSTANTS_GLSL
 "out Fragment{\n"
 "    smooth vec2 uv;\n"
 "    smooth float depth;\n"
@@ -338,7 +340,7 @@ static const char* instancedPBRVertexShaderSoure =
 "layout(location = 4) in vec3 instance_position;\n"
 "layout(location = 5) in vec4 instance_rotation;\n"
 "layout(location = 6) in vec3 instance_scale;\n"
-"uniform mat4 viewProjection;\n"
+VIEW_CONSTANTS_GLSL
 "out Fragment{\n"
 "    smooth vec2 uv;\n"
 "    smooth float depth;\n"
@@ -405,24 +407,15 @@ static const char* lightPassFragmentShaderSource =
 "uniform sampler2D materialMap;\n"
 "uniform sampler2D normalMap;\n"
 "uniform sampler2D depthMap;\n"
-"uniform vec3 camPos;\n"
+VIEW_CONSTANTS_GLSL
 "uniform float reflectionSize;\n"
 "uniform vec3 reflectionPos;\n"
-"uniform vec2 depthParameter;\n"
 "uniform vec4 lightPosition;        // World X,Y,Z, Radius\n"
 "uniform vec4 lightColor;           // RGB and ambient\n"
 "uniform vec3 lightAttenuation;     // Constant, Linear, Quadratic\n"
 "uniform vec3 lightSpotDirection;   // Spot light direction\n"
 "uniform float lightSpotCutoff;		// For spot lights < 90.0\n"
 "uniform float lightSpotExponent;	// Spot light exponent\n"
-"uniform float nearDepth;\n"
-"uniform float farDepth;\n"
-"uniform bool renderFog;\n"
-"uniform float fogDensity = 1.0;         // Global fog density\n"
-"uniform float fogHeightFalloff = 0.5;   // Fog height falloff parameter\n"
-"uniform float fogExtinctionFalloff = 20.0;\n"
-"uniform float fogInscatteringFalloff = 20.0;\n"
-"uniform vec3 fogColor = vec3(0.5, 0.6, 0.8);\n"
 "in vec2 texCoord;\n"
 "in vec3 viewRay;\n"
 "float getLightAttenuation(vec3 lightDir, float dist)\n"
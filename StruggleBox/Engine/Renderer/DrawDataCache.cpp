@@ -1,11 +1,12 @@
 #include "DrawDataCache.h"
 
-#include "GLErrorUtil.h"
+#include "RenderBackend.h"
 #include "Log.h"
 
 static DrawData no_data = { 0, 0, 0, 0, 0, 0, 0 };
 
-DrawDataCache::DrawDataCache()
+DrawDataCache::DrawDataCache(RenderBackend& backend)
+    : m_backend(backend)
 {
 }
 
@@ -52,24 +53,15 @@ DrawDataID DrawDataCache::createDrawData(const VertexConfig& config)
         Log::Error("[DrawDataCache::createDrawData] No vertex data attributes, check config!");
         return 0;
     }
-    uint32_t VAO = 0;
-    uint32_t VBO = 0;
-    uint32_t vertexDataSize = 0;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    configureVBO(config, vertexDataSize);
-    glBindVertexArray(0);
-
     DrawData data;
-    data.handleVAO = VAO;
-    data.handleVBO = VBO;
+    data.handleVAO = 0;
+    data.handleVBO = 0;
     data.vertexCount = 0;
-    data.vertexDataSize = vertexDataSize;
+    data.vertexDataSize = getVertexDataSize(config);
     data.handleIBO = 0;
     data.instanceCount = 0;
     data.instanceDataSize = 0;
+    m_backend.createDrawData(data, config, nullptr);
 
     m_nextMeshDataID++;
     m_meshDataCache[m_nextMeshDataID] = data;
@@ -88,34 +80,15 @@ DrawDataID DrawDataCache::createInstancedDrawData(const VertexConfig& instanceCo
         Log::Error("[DrawDataCache::createInstancedDrawData] No instance data attributes, check config!");
         return 0;
     }
-    uint32_t VAO = 0;
-    uint32_t VBO = 0;
-    uint32_t vertexDataSize = 0;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    CHECK_GL_ERROR();
-    configureVBO(config, vertexDataSize);
-    CHECK_GL_ERROR();
-
-    uint32_t IBO = 0;
-    uint32_t instanceDataSize = 0;
-    glGenBuffers(1, &IBO);
-    glBindBuffer(GL_ARRAY_BUFFER, IBO);
-    CHECK_GL_ERROR();
-    configureIBO(instanceConfig, instanceDataSize, config.attributeCount);
-    CHECK_GL_ERROR();
-    glBindVertexArray(0);
-
     DrawData data;
-    data.handleVAO = VAO;
-    data.handleVBO = VBO;
+    data.handleVAO = 0;
+    data.handleVBO = 0;
     data.vertexCount = 0;
-    data.vertexDataSize = vertexDataSize;
-    data.handleIBO = IBO;
+    data.vertexDataSize = getVertexDataSize(config);
+    data.handleIBO = 0;
     data.instanceCount = 0;
-    data.instanceDataSize = instanceDataSize;
+    data.instanceDataSize = getVertexDataSize(instanceConfig);
+    m_backend.createDrawData(data, config, &instanceConfig);
 
     m_nextMeshDataID++;
     m_meshDataCache[m_nextMeshDataID] = data;
@@ -209,13 +182,7 @@ void DrawDataCache::destroyDrawData(const DrawDataID dataID)
     {
         return;
     }
-    DrawData& data = it->second;
-    if (data.handleIBO)
-    {
-        glDeleteBuffers(1, &data.handleIBO);
-    }
-    glDeleteBuffers(1, &data.handleVBO);
-    glDeleteVertexArrays(1, &data.handleVAO);
+    m_backend.destroyDrawData(it->second);
     m_meshDataCache.erase(it);
 }
 
@@ -287,35 +254,12 @@ bool DrawDataCache::isInstancedDrawData(const DrawData& data) const
 //    }
 //}
 
-void DrawDataCache::configureVBO(const VertexConfig& config, uint32_t& vertexDataSize)
-{
-    for (uint8_t i = 0; i < config.attributeCount; i++)
-    {
-        vertexDataSize += sizeof(GLfloat) * config.attributeSizes[i];
-    }
-    uint32_t attributeOffset = 0;
-    for (uint8_t i = 0; i < config.attributeCount; i++)
-    {
-        const uint32_t attributeSize = config.attributeSizes[i];
-        glVertexAttribPointer(i, attributeSize, GL_FLOAT, GL_FALSE, vertexDataSize, (void*)attributeOffset);
-        glEnableVertexAttribArray(i);
-        attributeOffset += sizeof(GLfloat) * attributeSize;
-    }
-}
-void DrawDataCache::configureIBO(const VertexConfig& config, uint32_t& instanceDataSize, uint8_t vertexAttributeCount)
+uint32_t DrawDataCache::getVertexDataSize(const VertexConfig& config)
 {
+    uint32_t vertexDataSize = 0;
     for (uint8_t i = 0; i < config.attributeCount; i++)
     {
-        instanceDataSize += sizeof(GLfloat) * config.attributeSizes[i];
-    }
-    uint32_t attributeOffset = 0;
-    for (uint8_t i = 0; i < config.attributeCount; i++)
-    {
-        const uint32_t j = i + vertexAttributeCount; // instanced attribute index
-        const uint32_t attributeSize = config.attributeSizes[i];
-        glVertexAttribPointer(j, config.attributeSizes[i], GL_FLOAT, GL_FALSE, instanceDataSize, (void*)attributeOffset);
-        glEnableVertexAttribArray(j);
-        glVertexAttribDivisor(j, 1);
-        attributeOffset += sizeof(GLfloat) * attributeSize;
+        vertexDataSize += sizeof(float) * config.attributeSizes[i];
     }
+    return vertexDataSize;
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "RendererDefines.h"
 #include <map>
 
+class RenderBackend;
+
 struct DrawData {
     uint32_t handleVAO;
     uint32_t handleVBO;
@@ -16,7 +18,7 @@ struct DrawData {
 class DrawDataCache
 {
 public:
-    DrawDataCache();
+    DrawDataCache(RenderBackend& backend);
     ~DrawDataCache();
 
     void terminate();
@@ -31,10 +33,10 @@ public:
 
     bool isInstancedDrawData(const DrawData& data) const;
 private:
+    RenderBackend& m_backend;
     DrawDataID m_nextMeshDataID = 0;
 
     std::map<DrawDataID, DrawData> m_meshDataCache;
     //void configureVBO(const DrawDataType type);
-    void configureVBO(const VertexConfig& config, uint32_t& vertexDataSize);
-    void configureIBO(const VertexConfig& config, uint32_t& instanceDataSize, uint8_t vertexAttributeCount);
+    static uint32_t getVertexDataSize(const VertexConfig& config);
 };
@@ -1,9 +1,8 @@
 #include "FrameBuffer.h"
 
 #include "ArenaOperators.h"
-#include "CoreIncludes.h"
+#include "RenderBackend.h"
 #include "RenderCore.h"
-#include "GLUtils.h"
 #include "Texture2D.h"
 
 FrameBuffer::FrameBuffer(RenderCore& renderCore, const std::string& name)
@@ -24,20 +23,19 @@ FrameBuffer::~FrameBuffer()
 void FrameBuffer::initialize(const uint32_t width, const uint32_t height)
 {
     setupTexture(width, height);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    m_fboHandle = m_renderCore.getBackend().createFrameBuffer(&m_textureHandle, 1, 0);
 }
 
 void FrameBuffer::initialize(const uint32_t width, const uint32_t height, const uint32_t depthTexture)
 {
     setupTexture(width, height);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, depthTexture, 0);  // Attach previous depth/stencil to it
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    m_fboHandle = m_renderCore.getBackend().createFrameBuffer(&m_textureHandle, 1, depthTexture);  // Shares a previous depth/stencil
 }
 
 void FrameBuffer::terminate()
 {
-    glDeleteTextures(1, &m_textureHandle);
-    glDeleteFramebuffers(1, &m_fboHandle);
+    m_renderCore.getBackend().destroyTexture(m_textureHandle);
+    m_renderCore.getBackend().destroyFrameBuffer(m_fboHandle);
 
     //m_renderCore.removeTexture(m_textureID);
     Texture2D* textureAlbedo = m_renderCore.getTextureCache().getTextureByID(m_textureID);
@@ -47,26 +45,23 @@ void FrameBuffer::terminate()
 
 void FrameBuffer::bind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fboHandle);
+    m_renderCore.getBackend().bindFrameBuffer(m_fboHandle);
 }
 
 void FrameBuffer::bindAndClear(const Color& clearColor) const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fboHandle);
-    glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
-    glClear(GL_COLOR_BUFFER_BIT);
+    RenderBackend& backend = m_renderCore.getBackend();
+    backend.bindFrameBuffer(m_fboHandle);
+    backend.clear(clearColor, false, false);
 }
 
 void FrameBuffer::setupTexture(const uint32_t width, const uint32_t height)
 {
     m_width = width;
     m_height = height;
-    m_textureHandle = GLUtils::createTexture(width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR);
-  
-    Texture2D* textureAlbedo = CUSTOM_NEW(Texture2D, m_renderCore.getAllocator())(m_textureHandle, m_width, m_height, GL_RGBA, GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, 0);
-    m_textureID = m_renderCore.getTextureCache().addTexture(textureAlbedo, m_textureName);
+    const TextureParams params = { TextureFormat::RGBA8, TextureWrap::ClampToEdge, TextureFilter::Linear, false };
+    m_textureHandle = m_renderCore.getBackend().createTexture(params, width, height, nullptr);
 
-    glGenFramebuffers(1, &m_fboHandle);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fboHandle);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_textureHandle, 0);
+    Texture2D* textureAlbedo = CUSTOM_NEW(Texture2D, m_renderCore.getAllocator())(m_textureHandle, m_width, m_height, params);
+    m_textureID = m_renderCore.getTextureCache().addTexture(textureAlbedo, m_textureName);
 }
@@ -1,6 +1,5 @@
 #pragma once
 
-#include "CoreIncludes.h"
 #include "RendererDefines.h"
 
 class RenderCore;
@@ -17,9 +16,6 @@ public:
 	void Clear();
 	void UnBind();
 
-	void BindDraw();
-	void BindRead();
-
 	//void Resize(uint32_t width, uint32_t height);
 
 	const uint32_t GetFBO() const { return m_fboHandle; };
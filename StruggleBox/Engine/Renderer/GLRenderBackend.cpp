@@ -0,0 +1,669 @@
+#include "GLRenderBackend.h"
+
+#include "GLErrorUtil.h"
+#include "GLUtils.h"
+#include "Log.h"
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+const size_t STREAM_BUFFER_SIZE = 32 * 1024 * 1024;
+const size_t STREAM_ALIGNMENT = 16;
+const GLuint VERTEX_BINDING = 0;
+const GLuint INSTANCE_BINDING = 1;
+const GLuint64 STREAM_FENCE_TIMEOUT = 1000000; // 1ms in nanoseconds, waited on repeatedly
+
+static uint32_t GL_DRAW_MODES[] = {
+    GL_POINTS, GL_LINES, GL_LINE_LOOP, GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_TRIANGLE_FAN
+};
+
+// Internal format, format and type of each TextureFormat
+static GLenum GL_TEXTURE_FORMATS[][3] = {
+    { GL_RED, GL_RED, GL_UNSIGNED_BYTE },
+    { GL_RGB, GL_RGB, GL_UNSIGNED_BYTE },
+    { GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE },
+    { GL_RGBA32F, GL_RGBA, GL_FLOAT },
+    { GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8 }
+};
+
+GLRenderBackend::GLRenderBackend()
+    : m_vertexAttribBinding(GLEW_ARB_vertex_attrib_binding != 0)
+    , m_streamBuffer(0)
+    , m_streamMapping(nullptr)
+    , m_streamRing(STREAM_BUFFER_SIZE)
+    , m_oldestStreamFence(0)
+{
+    for (uint32_t i = 0; i < StreamRing::MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        m_streamFences[i] = nullptr;
+    }
+    if (m_vertexAttribBinding)
+    {
+        createStreamBuffer();
+    }
+    else
+    {
+        Log::Warn("[GLRenderBackend] No vertex attribute binding support, per draw data won't be streamed");
+    }
+}
+
+GLRenderBackend::~GLRenderBackend()
+{
+    while (m_streamRing.getFramesInFlight())
+    {
+        retireStreamFrame(true);
+    }
+    if (m_streamMapping)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_streamBuffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    if (m_streamBuffer)
+    {
+        glDeleteBuffers(1, &m_streamBuffer);
+    }
+}
+
+void GLRenderBackend::createDrawData(DrawData& drawData, const VertexConfig& config, const VertexConfig* instanceConfig)
+{
+    glGenVertexArrays(1, &drawData.handleVAO);
+    glGenBuffers(1, &drawData.handleVBO);
+    glBindVertexArray(drawData.handleVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, drawData.handleVBO);
+    configureAttributes(config, drawData.handleVBO, drawData.vertexDataSize, 0, false);
+    CHECK_GL_ERROR();
+
+    if (instanceConfig)
+    {
+        glGenBuffers(1, &drawData.handleIBO);
+        glBindBuffer(GL_ARRAY_BUFFER, drawData.handleIBO);
+        configureAttributes(*instanceConfig, drawData.handleIBO, drawData.instanceDataSize, config.attributeCount, true);
+        CHECK_GL_ERROR();
+    }
+    glBindVertexArray(0);
+}
+
+void GLRenderBackend::destroyDrawData(const DrawData& drawData)
+{
+    if (drawData.handleIBO)
+    {
+        glDeleteBuffers(1, &drawData.handleIBO);
+    }
+    glDeleteBuffers(1, &drawData.handleVBO);
+    glDeleteVertexArrays(1, &drawData.handleVAO);
+}
+
+void GLRenderBackend::bufferData(const DrawData& drawData, const bool instanced, const void* data, const size_t size, const bool dynamic)
+{
+    glBufferData(GL_ARRAY_BUFFER, size, data, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    if (m_streamBuffer)
+    {
+        // The binding may still point into the streaming buffer from an earlier draw
+        if (instanced)
+        {
+            glBindVertexBuffer(INSTANCE_BINDING, drawData.handleIBO, 0, drawData.instanceDataSize);
+        }
+        else
+        {
+            glBindVertexBuffer(VERTEX_BINDING, drawData.handleVBO, 0, drawData.vertexDataSize);
+        }
+    }
+}
+
+bool GLRenderBackend::streamData(const DrawData& drawData, const bool instanced, const void* data, const size_t size)
+{
+    if (!m_streamBuffer)
+    {
+        return false;
+    }
+    const size_t offset = allocateStream(size);
+    if (offset == StreamRing::NO_SPACE)
+    {
+        return false;
+    }
+
+    if (m_streamMapping)
+    {
+        memcpy((uint8_t*)m_streamMapping + offset, data, size);
+    }
+    else
+    {
+        // Copy write target so the array buffer binding RenderCore keeps track of stays as it is
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_streamBuffer);
+        void* mapping = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size,
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (!mapping)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            return false;
+        }
+        memcpy(mapping, data, size);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    if (instanced)
+    {
+        glBindVertexBuffer(INSTANCE_BINDING, m_streamBuffer, offset, drawData.instanceDataSize);
+    }
+    else
+    {
+        glBindVertexBuffer(VERTEX_BINDING, m_streamBuffer, offset, drawData.vertexDataSize);
+    }
+    return true;
+}
+
+uint32_t GLRenderBackend::createUniformBuffer(const uint32_t binding, const size_t size)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+    CHECK_GL_ERROR();
+    return buffer;
+}
+
+void GLRenderBackend::destroyUniformBuffer(const uint32_t buffer)
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLRenderBackend::updateUniformBuffer(const uint32_t buffer, const void* data, const size_t size)
+{
+    // Respecified instead of updated in place so draws still reading the old contents don't stall this
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+uint32_t GLRenderBackend::createTexture(const TextureParams& params, const uint32_t width, const uint32_t height, const void* data)
+{
+    const GLenum* format = GL_TEXTURE_FORMATS[(uint32_t)params.format];
+    const GLint wrap = params.wrap == TextureWrap::Repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    const GLint filter = params.filter == TextureFilter::Linear ? GL_LINEAR : GL_NEAREST;
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    setUnpackAlignment(params.format);
+    glTexImage2D(GL_TEXTURE_2D, 0, format[0], width, height, 0, format[1], format[2], data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+    if (params.format == TextureFormat::Depth24Stencil8)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    }
+    if (params.mipmaps)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    CHECK_GL_ERROR();
+    return texture;
+}
+
+void GLRenderBackend::updateTexture(const uint32_t texture, const TextureFormat format, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const void* data)
+{
+    const GLenum* formatGL = GL_TEXTURE_FORMATS[(uint32_t)format];
+    glBindTexture(GL_TEXTURE_2D, texture);
+    setUnpackAlignment(format);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, formatGL[1], formatGL[2], data);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GLRenderBackend::destroyTexture(const uint32_t texture)
+{
+    glDeleteTextures(1, &texture);
+}
+
+uint32_t GLRenderBackend::createCubeMap(const uint32_t size)
+{
+    GLuint cubeMap = 0;
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    glGenTextures(1, &cubeMap);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubeMap);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LOD, 4);
+    for (GLenum side = 0; side < 6; side++)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + side, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_FLOAT, nullptr);
+    }
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    return cubeMap;
+}
+
+void GLRenderBackend::generateCubeMapMipmaps(const uint32_t cubeMap)
+{
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubeMap);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+uint32_t GLRenderBackend::createFrameBuffer(const uint32_t* colorTextures, const uint32_t colorCount, const uint32_t depthStencilTexture)
+{
+    GLuint frameBuffer = 0;
+    GLenum drawBuffers[8];
+    glGenFramebuffers(1, &frameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+    for (uint32_t i = 0; i < colorCount && i < 8; i++)
+    {
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, colorTextures[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    if (depthStencilTexture)
+    {
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, depthStencilTexture, 0);
+    }
+    if (colorCount > 1)
+    {
+        glDrawBuffers(colorCount < 8 ? colorCount : 8, drawBuffers);
+    }
+    // Cube map frame buffers only get their attachment once a side is picked
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (colorCount && status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        Log::Error("[GLRenderBackend] Frame buffer incomplete, status: %i", status);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return frameBuffer;
+}
+
+void GLRenderBackend::destroyFrameBuffer(const uint32_t frameBuffer)
+{
+    glDeleteFramebuffers(1, &frameBuffer);
+}
+
+void GLRenderBackend::attachCubeMapSide(const uint32_t frameBuffer, const uint32_t cubeMap, const uint32_t side)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + side, cubeMap, 0);
+}
+
+void GLRenderBackend::bindFrameBuffer(const uint32_t frameBuffer)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+}
+
+void GLRenderBackend::setViewport(const int32_t x, const int32_t y, const int32_t width, const int32_t height)
+{
+    glViewport(x, y, width, height);
+}
+
+void GLRenderBackend::clear(const Color& color, const bool clearDepth, const bool clearStencil)
+{
+    GLbitfield mask = GL_COLOR_BUFFER_BIT;
+    glClearColor(color.r, color.g, color.b, color.a);
+    if (clearDepth)
+    {
+        glClearDepth(1.0);
+        mask |= GL_DEPTH_BUFFER_BIT;
+    }
+    if (clearStencil)
+    {
+        glClearStencil(0);
+        mask |= GL_STENCIL_BUFFER_BIT;
+    }
+    glClear(mask);
+}
+
+void GLRenderBackend::blitToScreen(const uint32_t frameBuffer, const int32_t colorAttachment, const glm::ivec4& source, const glm::ivec4& destination)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    if (colorAttachment >= 0)
+    {
+        glReadBuffer(GL_COLOR_ATTACHMENT0 + colorAttachment);
+        glBlitFramebuffer(source.x, source.y, source.z, source.w,
+            destination.x, destination.y, destination.z, destination.w, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+    else
+    {
+        // Depth can only be copied unfiltered
+        glBlitFramebuffer(source.x, source.y, source.z, source.w,
+            destination.x, destination.y, destination.z, destination.w, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+float GLRenderBackend::readDepth(const int32_t x, const int32_t y)
+{
+    GLfloat depth = 0.f;
+    glReadPixels(x, y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth);
+    return depth;
+}
+
+void GLRenderBackend::useProgram(const uint32_t program)
+{
+    glUseProgram(program);
+}
+
+void GLRenderBackend::bindVertexArray(const uint32_t vao)
+{
+    glBindVertexArray(vao);
+}
+
+void GLRenderBackend::bindArrayBuffer(const uint32_t buffer)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+}
+
+void GLRenderBackend::setActiveTexture(const uint32_t unit)
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLRenderBackend::bindTexture(const uint32_t texture)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLRenderBackend::bindCubeMap(const uint32_t cubeMap)
+{
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubeMap);
+}
+
+void GLRenderBackend::setBlendEnabled(const bool enable)
+{
+    if (enable)
+    {
+        glEnable(GL_BLEND);
+    }
+    else
+    {
+        glDisable(GL_BLEND);
+    }
+}
+
+void GLRenderBackend::setBlendFunc(const BlendFunc srcFunc, const BlendFunc dstFunc)
+{
+    glBlendFunc(GLUtils::getGLBlendFunc(srcFunc), GLUtils::getGLBlendFunc(dstFunc));
+}
+
+void GLRenderBackend::setDepthTestEnabled(const bool enable)
+{
+    if (enable)
+    {
+        glEnable(GL_DEPTH_TEST);
+    }
+    else
+    {
+        glDisable(GL_DEPTH_TEST);
+    }
+}
+
+void GLRenderBackend::setDepthFunc(const DepthFunc func)
+{
+    glDepthFunc(GLUtils::getGLDepthFunc(func));
+}
+
+void GLRenderBackend::setDepthMask(const bool mask)
+{
+    glDepthMask(mask ? GL_TRUE : GL_FALSE);
+}
+
+void GLRenderBackend::setCullingEnabled(const bool enable)
+{
+    if (enable)
+    {
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+    }
+    else
+    {
+        glDisable(GL_CULL_FACE);
+    }
+}
+
+void GLRenderBackend::setStencilTestEnabled(const bool enable)
+{
+    if (enable)
+    {
+        glEnable(GL_STENCIL_TEST);
+    }
+    else
+    {
+        glDisable(GL_STENCIL_TEST);
+    }
+}
+
+void GLRenderBackend::setStencilFunc(const DepthFunc func, const uint8_t ref)
+{
+    // Stencil and depth tests compare with the same functions
+    glStencilFunc(GLUtils::getGLDepthFunc(func), ref, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+}
+
+void GLRenderBackend::setUniform1i(const int32_t location, const int value)
+{
+    if (location != -1)
+    {
+        glUniform1i(location, value);
+    }
+}
+
+void GLRenderBackend::setUniform1f(const int32_t location, const float value)
+{
+    if (location != -1)
+    {
+        glUniform1f(location, value);
+    }
+}
+
+void GLRenderBackend::setUniform2f(const int32_t location, const glm::vec2& value)
+{
+    if (location != -1)
+    {
+        glUniform2fv(location, 1, glm::value_ptr(value));
+    }
+}
+
+void GLRenderBackend::setUniform3f(const int32_t location, const glm::vec3& value)
+{
+    if (location != -1)
+    {
+        glUniform3fv(location, 1, glm::value_ptr(value));
+    }
+}
+
+void GLRenderBackend::setUniform4f(const int32_t location, const glm::vec4& value)
+{
+    if (location != -1)
+    {
+        glUniform4fv(location, 1, glm::value_ptr(value));
+    }
+}
+
+void GLRenderBackend::setUniformM3(const int32_t location, const glm::mat3& value)
+{
+    if (location != -1)
+    {
+        glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
+
+void GLRenderBackend::setUniformM4(const int32_t location, const glm::mat4& value)
+{
+    if (location != -1)
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
+
+void GLRenderBackend::drawArrays(const DrawMode mode, const uint32_t first, const uint32_t count)
+{
+    glDrawArrays(GL_DRAW_MODES[(uint32_t)mode], first, count);
+}
+
+void GLRenderBackend::drawArraysInstanced(const DrawMode mode, const uint32_t first, const uint32_t count, const uint32_t instanceCount)
+{
+    glDrawArraysInstanced(GL_DRAW_MODES[(uint32_t)mode], first, count, instanceCount);
+}
+
+void GLRenderBackend::beginFrame()
+{
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void GLRenderBackend::endFrame()
+{
+    // Orphaned buffers are never waited on, the ring just fills up until the next orphaning
+    if (!m_streamMapping)
+    {
+        return;
+    }
+    const uint32_t fence = (m_oldestStreamFence + m_streamRing.getFramesInFlight()) % StreamRing::MAX_FRAMES_IN_FLIGHT;
+    m_streamFences[fence] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_streamRing.endFrame();
+
+    // Give back whatever the GPU is done with, and keep at most two frames queued behind the one being written
+    while (m_streamRing.getFramesInFlight() && retireStreamFrame(false))
+    {
+    }
+    while (m_streamRing.getFramesInFlight() >= StreamRing::MAX_FRAMES_IN_FLIGHT)
+    {
+        retireStreamFrame(true);
+    }
+}
+
+void GLRenderBackend::setUnpackAlignment(const TextureFormat format)
+{
+    // Glyph bitmaps come tightly packed, every other upload has its rows padded to 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, format == TextureFormat::R8 ? 1 : 4);
+}
+
+void GLRenderBackend::configureAttributes(const VertexConfig& config, const GLuint buffer, const uint32_t stride, const uint8_t firstAttribute, const bool instanced)
+{
+    // Attributes read through one binding per buffer, so streaming can point it somewhere else
+    const GLuint binding = instanced ? INSTANCE_BINDING : VERTEX_BINDING;
+    if (m_vertexAttribBinding)
+    {
+        glBindVertexBuffer(binding, buffer, 0, stride);
+        if (instanced)
+        {
+            glVertexBindingDivisor(binding, 1);
+        }
+    }
+
+    uint32_t attributeOffset = 0;
+    for (uint8_t i = 0; i < config.attributeCount; i++)
+    {
+        const uint32_t attribute = firstAttribute + i;
+        const uint32_t attributeSize = config.attributeSizes[i];
+        const bool isInteger = config.attributeTypes[i] == VertexAttributeType::UnsignedInt;
+        if (m_vertexAttribBinding)
+        {
+            if (isInteger)
+            {
+                glVertexAttribIFormat(attribute, attributeSize, GL_UNSIGNED_INT, attributeOffset);
+            }
+            else
+            {
+                glVertexAttribFormat(attribute, attributeSize, GL_FLOAT, GL_FALSE, attributeOffset);
+            }
+            glVertexAttribBinding(attribute, binding);
+        }
+        else
+        {
+            if (isInteger)
+            {
+                glVertexAttribIPointer(attribute, attributeSize, GL_UNSIGNED_INT, stride, (void*)(uintptr_t)attributeOffset);
+            }
+            else
+            {
+                glVertexAttribPointer(attribute, attributeSize, GL_FLOAT, GL_FALSE, stride, (void*)(uintptr_t)attributeOffset);
+            }
+            if (instanced)
+            {
+                glVertexAttribDivisor(attribute, 1);
+            }
+        }
+        glEnableVertexAttribArray(attribute);
+        attributeOffset += sizeof(GLfloat) * attributeSize;
+    }
+}
+
+void GLRenderBackend::createStreamBuffer()
+{
+    glGenBuffers(1, &m_streamBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_streamBuffer);
+    if (GLEW_ARB_buffer_storage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, STREAM_BUFFER_SIZE, nullptr, flags);
+        m_streamMapping = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, STREAM_BUFFER_SIZE, flags);
+        if (!m_streamMapping)
+        {
+            // Immutable storage can't be orphaned, start over with a buffer that can
+            Log::Warn("[GLRenderBackend] Mapping the streaming buffer failed, orphaning it instead");
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            glDeleteBuffers(1, &m_streamBuffer);
+            glGenBuffers(1, &m_streamBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_streamBuffer);
+        }
+    }
+    if (!m_streamMapping)
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, STREAM_BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    CHECK_GL_ERROR();
+}
+
+size_t GLRenderBackend::allocateStream(const size_t size)
+{
+    size_t offset = m_streamRing.allocate(size, STREAM_ALIGNMENT);
+    if (offset != StreamRing::NO_SPACE)
+    {
+        return offset;
+    }
+    if (!m_streamMapping)
+    {
+        // Let the driver keep the old storage for the draws still using it and write into fresh storage
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_streamBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, STREAM_BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        m_streamRing.reset();
+        return m_streamRing.allocate(size, STREAM_ALIGNMENT);
+    }
+    // Wait for older frames one at a time until there's room, this frame alone may still not fit
+    while (offset == StreamRing::NO_SPACE && m_streamRing.getFramesInFlight())
+    {
+        retireStreamFrame(true);
+        offset = m_streamRing.allocate(size, STREAM_ALIGNMENT);
+    }
+    return offset;
+}
+
+bool GLRenderBackend::retireStreamFrame(const bool wait)
+{
+    GLsync fence = m_streamFences[m_oldestStreamFence];
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? STREAM_FENCE_TIMEOUT : 0);
+    while (wait && result == GL_TIMEOUT_EXPIRED)
+    {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_FENCE_TIMEOUT);
+    }
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        return false;
+    }
+    if (result == GL_WAIT_FAILED)
+    {
+        Log::Error("[GLRenderBackend] Waiting on a streaming fence failed");
+    }
+    glDeleteSync(fence);
+    m_streamFences[m_oldestStreamFence] = nullptr;
+    m_oldestStreamFence = (m_oldestStreamFence + 1) % StreamRing::MAX_FRAMES_IN_FLIGHT;
+    m_streamRing.retireFrame();
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include "StreamRing.h"
+#include <GL/glew.h>
+
+// Per draw data is streamed through one persistently mapped buffer, fenced per frame.
+// Without buffer storage it's written unsynchronized and the buffer is orphaned when it fills up,
+// without separate vertex bindings nothing is streamed and every draw re-specifies its own buffer.
+class GLRenderBackend : public RenderBackend
+{
+public:
+    GLRenderBackend();
+    ~GLRenderBackend();
+
+    bool compilesShaders() const override { return true; }
+
+    void createDrawData(DrawData& drawData, const VertexConfig& config, const VertexConfig* instanceConfig) override;
+    void destroyDrawData(const DrawData& drawData) override;
+    void bufferData(const DrawData& drawData, const bool instanced, const void* data, const size_t size, const bool dynamic) override;
+    bool streamData(const DrawData& drawData, const bool instanced, const void* data, const size_t size) override;
+
+    uint32_t createUniformBuffer(const uint32_t binding, const size_t size) override;
+    void destroyUniformBuffer(const uint32_t buffer) override;
+    void updateUniformBuffer(const uint32_t buffer, const void* data, const size_t size) override;
+
+    uint32_t createTexture(const TextureParams& params, const uint32_t width, const uint32_t height, const void* data) override;
+    void updateTexture(const uint32_t texture, const TextureFormat format, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const void* data) override;
+    void destroyTexture(const uint32_t texture) override;
+    uint32_t createCubeMap(const uint32_t size) override;
+    void generateCubeMapMipmaps(const uint32_t cubeMap) override;
+
+    uint32_t createFrameBuffer(const uint32_t* colorTextures, const uint32_t colorCount, const uint32_t depthStencilTexture) override;
+    void destroyFrameBuffer(const uint32_t frameBuffer) override;
+    void attachCubeMapSide(const uint32_t frameBuffer, const uint32_t cubeMap, const uint32_t side) override;
+    void bindFrameBuffer(const uint32_t frameBuffer) override;
+    void setViewport(const int32_t x, const int32_t y, const int32_t width, const int32_t height) override;
+    void clear(const Color& color, const bool clearDepth, const bool clearStencil) override;
+    void blitToScreen(const uint32_t frameBuffer, const int32_t colorAttachment, const glm::ivec4& source, const glm::ivec4& destination) override;
+    float readDepth(const int32_t x, const int32_t y) override;
+
+    void useProgram(const uint32_t program) override;
+    void bindVertexArray(const uint32_t vao) override;
+    void bindArrayBuffer(const uint32_t buffer) override;
+    void setActiveTexture(const uint32_t unit) override;
+    void bindTexture(const uint32_t texture) override;
+    void bindCubeMap(const uint32_t cubeMap) override;
+    void setBlendEnabled(const bool enable) override;
+    void setBlendFunc(const BlendFunc srcFunc, const BlendFunc dstFunc) override;
+    void setDepthTestEnabled(const bool enable) override;
+    void setDepthFunc(const DepthFunc func) override;
+    void setDepthMask(const bool mask) override;
+    void setCullingEnabled(const bool enable) override;
+    void setStencilTestEnabled(const bool enable) override;
+    void setStencilFunc(const DepthFunc func, const uint8_t ref) override;
+
+    void setUniform1i(const int32_t location, const int value) override;
+    void setUniform1f(const int32_t location, const float value) override;
+    void setUniform2f(const int32_t location, const glm::vec2& value) override;
+    void setUniform3f(const int32_t location, const glm::vec3& value) override;
+    void setUniform4f(const int32_t location, const glm::vec4& value) override;
+    void setUniformM3(const int32_t location, const glm::mat3& value) override;
+    void setUniformM4(const int32_t location, const glm::mat4& value) override;
+
+    void drawArrays(const DrawMode mode, const uint32_t first, const uint32_t count) override;
+    void drawArraysInstanced(const DrawMode mode, const uint32_t first, const uint32_t count, const uint32_t instanceCount) override;
+
+    void beginFrame() override;
+    void endFrame() override;
+
+private:
+    bool m_vertexAttribBinding;                 // Vertex arrays take their buffers through bindings that can be moved
+    GLuint m_streamBuffer;
+    void* m_streamMapping;                      // Persistent mapping, null when orphaning instead
+    StreamRing m_streamRing;
+    GLsync m_streamFences[StreamRing::MAX_FRAMES_IN_FLIGHT];
+    uint32_t m_oldestStreamFence;
+
+    void setUnpackAlignment(const TextureFormat format);
+    void configureAttributes(const VertexConfig& config, const GLuint buffer, const uint32_t stride, const uint8_t firstAttribute, const bool instanced);
+    void createStreamBuffer();
+    size_t allocateStream(const size_t size);
+    bool retireStreamFrame(const bool wait);
+};
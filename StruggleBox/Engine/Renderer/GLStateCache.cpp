@@ -0,0 +1,154 @@
+#include "GLStateCache.h"
+
+#include "RenderBackend.h"
+
+GLStateCache::GLStateCache(RenderBackend& backend)
+    : m_backend(backend)
+{
+    invalidate();
+    resetCounters();
+}
+
+void GLStateCache::invalidate()
+{
+    m_program = 0;
+    m_vao = 0;
+    m_arrayBuffer = 0;
+    m_activeTextureUnit = 0;
+    m_blendMode = BLEND_MODE_DISABLED;
+    m_depthMode = DEPTH_MODE_DISABLED;
+    m_programKnown = false;
+    m_vaoKnown = false;
+    m_arrayBufferKnown = false;
+    m_activeTextureUnitKnown = false;
+    for (uint32_t unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+    {
+        m_textures[unit] = 0;
+        m_texturesKnown[unit] = false;
+    }
+    m_blendEnableKnown = false;
+    m_blendFuncKnown = false;
+    m_depthEnableKnown = false;
+    m_depthFuncKnown = false;
+    m_depthMaskKnown = false;
+}
+
+bool GLStateCache::useProgram(const uint32_t program)
+{
+    if (!changed(m_programKnown, m_program == program))
+    {
+        return false;
+    }
+    m_backend.useProgram(program);
+    m_program = program;
+    m_programKnown = true;
+    return true;
+}
+
+bool GLStateCache::bindVertexArray(const uint32_t vao)
+{
+    if (!changed(m_vaoKnown, m_vao == vao))
+    {
+        return false;
+    }
+    m_backend.bindVertexArray(vao);
+    m_vao = vao;
+    m_vaoKnown = true;
+    return true;
+}
+
+bool GLStateCache::bindArrayBuffer(const uint32_t buffer)
+{
+    if (!changed(m_arrayBufferKnown, m_arrayBuffer == buffer))
+    {
+        return false;
+    }
+    m_backend.bindArrayBuffer(buffer);
+    m_arrayBuffer = buffer;
+    m_arrayBufferKnown = true;
+    return true;
+}
+
+bool GLStateCache::bindTexture(const uint32_t unit, const uint32_t texture)
+{
+    if (unit >= MAX_TEXTURE_UNITS)
+    {
+        m_backend.setActiveTexture(unit);
+        m_backend.bindTexture(texture);
+        m_activeTextureUnitKnown = false;
+        m_counters.stateChanges += 2;
+        return true;
+    }
+    if (!changed(m_texturesKnown[unit], m_textures[unit] == texture))
+    {
+        return false;
+    }
+    if (changed(m_activeTextureUnitKnown, m_activeTextureUnit == unit))
+    {
+        m_backend.setActiveTexture(unit);
+        m_activeTextureUnit = unit;
+        m_activeTextureUnitKnown = true;
+    }
+    m_backend.bindTexture(texture);
+    m_textures[unit] = texture;
+    m_texturesKnown[unit] = true;
+    return true;
+}
+
+void GLStateCache::setBlendMode(const BlendMode& mode)
+{
+    if (changed(m_blendEnableKnown, m_blendMode.enable == mode.enable))
+    {
+        m_backend.setBlendEnabled(mode.enable);
+        m_blendMode.enable = mode.enable;
+        m_blendEnableKnown = true;
+    }
+    // The function doesn't matter while blending is off, it's set once it's turned on
+    if (mode.enable &&
+        changed(m_blendFuncKnown, m_blendMode.srcFunc == mode.srcFunc && m_blendMode.dstFunc == mode.dstFunc))
+    {
+        m_backend.setBlendFunc(mode.srcFunc, mode.dstFunc);
+        m_blendMode.srcFunc = mode.srcFunc;
+        m_blendMode.dstFunc = mode.dstFunc;
+        m_blendFuncKnown = true;
+    }
+}
+
+void GLStateCache::setDepthMode(const DepthMode& mode)
+{
+    if (changed(m_depthEnableKnown, m_depthMode.enable == mode.enable))
+    {
+        m_backend.setDepthTestEnabled(mode.enable);
+        m_depthMode.enable = mode.enable;
+        m_depthEnableKnown = true;
+    }
+    if (changed(m_depthFuncKnown, m_depthMode.func == mode.func))
+    {
+        m_backend.setDepthFunc(mode.func);
+        m_depthMode.func = mode.func;
+        m_depthFuncKnown = true;
+    }
+    if (changed(m_depthMaskKnown, m_depthMode.mask == mode.mask))
+    {
+        m_backend.setDepthMask(mode.mask);
+        m_depthMode.mask = mode.mask;
+        m_depthMaskKnown = true;
+    }
+}
+
+void GLStateCache::resetCounters()
+{
+    m_counters.stateChanges = 0;
+    m_counters.redundantStateChanges = 0;
+}
+
+bool GLStateCache::changed(const bool known, const bool same)
+{
+    if (known && same)
+    {
+        m_counters.redundantStateChanges++;
+        return false;
+    }
+    m_counters.stateChanges++;
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "RendererDefines.h"
+
+class RenderBackend;
+
+// Mirrors the GL state RenderCore sets for its draws, so setting what is
+// already bound is skipped instead of reaching the backend.
+// Code outside RenderCore still talks to GL directly, so the cache is only
+// trusted between invalidate() and the end of one submission.
+
+struct GLStateCounters
+{
+    uint32_t stateChanges;              // Calls that reached the backend
+    uint32_t redundantStateChanges;     // Calls skipped because the state was already set
+};
+
+class GLStateCache
+{
+public:
+    static const uint32_t MAX_TEXTURE_UNITS = 8;
+
+    GLStateCache(RenderBackend& backend);
+
+    // Forget everything, the next call of each kind always reaches the backend
+    void invalidate();
+
+    // Return true when the state actually changed
+    bool useProgram(const uint32_t program);
+    bool bindVertexArray(const uint32_t vao);
+    bool bindArrayBuffer(const uint32_t buffer);
+    bool bindTexture(const uint32_t unit, const uint32_t texture);
+    void setBlendMode(const BlendMode& mode);
+    void setDepthMode(const DepthMode& mode);
+
+    const GLStateCounters& getCounters() const { return m_counters; }
+    void resetCounters();
+
+private:
+    bool changed(const bool known, const bool same);
+
+    RenderBackend& m_backend;
+    uint32_t m_program;
+    uint32_t m_vao;
+    uint32_t m_arrayBuffer;
+    uint32_t m_activeTextureUnit;
+    uint32_t m_textures[MAX_TEXTURE_UNITS];
+    BlendMode m_blendMode;
+    DepthMode m_depthMode;
+
+    bool m_programKnown;
+    bool m_vaoKnown;
+    bool m_arrayBufferKnown;
+    bool m_activeTextureUnitKnown;
+    bool m_texturesKnown[MAX_TEXTURE_UNITS];
+    bool m_blendEnableKnown;
+    bool m_blendFuncKnown;
+    bool m_depthEnableKnown;
+    bool m_depthFuncKnown;
+    bool m_depthMaskKnown;
+
+    GLStateCounters m_counters;
+};
@@ -1,7 +1,7 @@
 #include "Lighting2DDeferred.h"
 
 #include "Renderer2DDeferred.h"
-#include "GFXDefines.h"
+#include "RenderBackend.h"
 #include "DefaultShaders.h"
 
 const int32_t LIGHT_FBO_SIZE = 1024;
@@ -127,10 +127,9 @@ void Lighting2DDeferred::renderLights(const std::vector<Light2DID>& lights, cons
         const float lightRadiusPX = lightRadius * camScale * renderScale;
         const float lightDiameter = lightRadiusPX * 2.f;
 
-        m_tempFrameBuffer.bind();
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glViewport(0, 0, lightDiameter, lightDiameter);
+        RenderBackend& backend = m_renderer.getRenderCore().getBackend();
+        m_tempFrameBuffer.bindAndClear(COLOR_NONE);
+        backend.setViewport(0, 0, (int32_t)lightDiameter, (int32_t)lightDiameter);
 
         // Render light circle or beam
         const glm::mat4 projection = glm::ortho<float>(0.f, lightDiameter, 0.f, lightDiameter, -1.f, 1.f);
@@ -156,7 +155,7 @@ void Lighting2DDeferred::renderLights(const std::vector<Light2DID>& lights, cons
         //glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer.getFBOHandle());
         const glm::ivec2 renderSize = m_renderer.getRenderCore().getRenderResolution();
         const glm::mat4 projection2D = glm::ortho<float>(0.f, renderSize.x, 0.f, renderSize.y, -1.f, 1.f);
-        glViewport(0, 0, renderSize.x, renderSize.y);
+        backend.setViewport(0, 0, renderSize.x, renderSize.y);
 
         // FBO texture coordinates range 0.0 to 1.0
         const float texCoordBottom = 0.0f;
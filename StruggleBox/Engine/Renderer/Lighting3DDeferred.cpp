@@ -2,6 +2,7 @@
 
 #include "FrameBuffer.h"
 #include "GBuffer.h"
+#include "RenderBackend.h"
 #include "RenderCore.h"
 #include "Shader.h"
 #include "Timer.h"
@@ -67,7 +68,7 @@ void Lighting3DDeferred::renderLighting(
 	const GBuffer& gBuffer,
 	const glm::vec3& reflectionPos,
 	const float reflectionSize,
-	const GLuint reflectionCubeMap)
+	const uint32_t reflectionCubeMap)
 {
 	const glm::vec2 texCoords[] = {
 		glm::vec2(0.0, 0.0),
@@ -96,25 +97,21 @@ void Lighting3DDeferred::renderLighting(
 
 	m_renderCore.upload(m_drawDataID, dataPtr, 4);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gBuffer.GetAlbedo());
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, gBuffer.GetMaterial());
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, gBuffer.GetNormal());
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, gBuffer.GetDepth());
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, reflectionCubeMap);
-
-	// Ready stencil to draw lighting only over solid geometry
-	glEnable(GL_STENCIL_TEST);
-	glStencilFunc(GL_LEQUAL, Stencil_Solid, 0xFF);        // Only draw on solid layer
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE);
-
-	// Parameters for linearizing depth value
-	const glm::vec2 depthParameter = glm::vec2(farDepth / (farDepth - nearDepth), farDepth * nearDepth / (nearDepth - farDepth));
+	RenderBackend& backend = m_renderCore.getBackend();
+	const uint32_t gBufferTextures[4] = { gBuffer.GetAlbedo(), gBuffer.GetMaterial(), gBuffer.GetNormal(), gBuffer.GetDepth() };
+	for (uint32_t unit = 0; unit < 4; unit++)
+	{
+		backend.setActiveTexture(unit);
+		backend.bindTexture(gBufferTextures[unit]);
+	}
+	backend.setActiveTexture(4);
+	backend.bindCubeMap(reflectionCubeMap);
+
+	// Ready stencil to draw lighting only over solid geometry, the draws blend additively themselves
+	backend.setStencilTestEnabled(true);
+	backend.setStencilFunc(DepthFunc::LessOrEqual, Stencil_Solid);        // Only draw on solid layer
+
+	// Camera position and depth parameters come from the ViewConstants block
 	const Shader* shader = m_renderCore.getShaderByID(m_lightPassShaderID);
 	shader->begin();
 	shader->setUniform1iv("albedoMap", 0);
@@ -122,12 +119,8 @@ void Lighting3DDeferred::renderLighting(
 	shader->setUniform1iv("normalMap", 2);
 	shader->setUniform1iv("depthMap", 3);
 	//shader->setUniform1iv("cubeMap", 4);
-	shader->setUniform3fv("camPos", position);
 	//shader->setUniform1fv("reflectionSize", reflectionSize);
 	//shader->setUniform3fv("reflectionPos", reflectionPos);
-	shader->setUniform2fv("depthParameter", depthParameter);
-	shader->setUniform1fv("farDepth", farDepth);
-	shader->setUniform1fv("nearDepth", nearDepth);
 	//shader->setUniform1fv("fogDensity", m_fogDensity);
 	//shader->setUniform1fv("fogHeightFalloff", m_fogHeightFalloff);
 	//shader->setUniform1fv("fogExtinctionFalloff", m_fogExtinctionFalloff);
@@ -141,16 +134,22 @@ void Lighting3DDeferred::renderLighting(
 	}
 
 	// Render all lights
+	const GLint lightPositionLocation = shader->getUniform("lightPosition");
+	const GLint lightColorLocation = shader->getUniform("lightColor");
+	const GLint lightAttenuationLocation = shader->getUniform("lightAttenuation");
+	const GLint lightSpotDirectionLocation = shader->getUniform("lightSpotDirection");
+	const GLint lightSpotCutoffLocation = shader->getUniform("lightSpotCutoff");
+	const GLint lightSpotExponentLocation = shader->getUniform("lightSpotExponent");
 	for (int i = 0; i < lights.size(); i++)
 	{
 		const LightInstance& light = lights[i];
 		if (!light.active) continue;
-		shader->setUniform4fv("lightPosition", light.position);
-		shader->setUniform4fv("lightColor", light.color);
-		shader->setUniform3fv("lightAttenuation", light.attenuation);
-		shader->setUniform3fv("lightSpotDirection", light.direction);
-		shader->setUniform1fv("lightSpotCutoff", light.spotCutoff);
-		shader->setUniform1fv("lightSpotExponent", light.spotExponent);
+		shader->setUniform4fv(lightPositionLocation, light.position);
+		shader->setUniform4fv(lightColorLocation, light.color);
+		shader->setUniform3fv(lightAttenuationLocation, light.attenuation);
+		shader->setUniform3fv(lightSpotDirectionLocation, light.direction);
+		shader->setUniform1fv(lightSpotCutoffLocation, light.spotCutoff);
+		shader->setUniform1fv(lightSpotExponentLocation, light.spotExponent);
 		m_renderCore.draw(m_lightPassShaderID, 0, m_drawDataID, projection, DrawMode::TriangleFan, nullptr, 0, 4, BLEND_MODE_ADDITIVE, DEPTH_MODE_DISABLED);
 	}
 	shader->end();
@@ -174,12 +173,12 @@ void Lighting3DDeferred::renderLighting(
 	//	shaderEmissive->end();
 	//}
 
-	glActiveTexture(GL_TEXTURE6); glBindTexture(GL_TEXTURE_2D, 0);
-	glActiveTexture(GL_TEXTURE5); glBindTexture(GL_TEXTURE_2D, 0);
-	glActiveTexture(GL_TEXTURE4); glBindTexture(GL_TEXTURE_2D, 0);
-	glActiveTexture(GL_TEXTURE3); glBindTexture(GL_TEXTURE_2D, 0);
-	glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_2D, 0);
-	glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_2D, 0);
-	glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D, 0);
-	glDisable(GL_STENCIL_TEST);
+	backend.setActiveTexture(4);
+	backend.bindCubeMap(0);
+	for (int32_t unit = 3; unit >= 0; unit--)
+	{
+		backend.setActiveTexture(unit);
+		backend.bindTexture(0);
+	}
+	backend.setStencilTestEnabled(false);
 }
\ No newline at end of file
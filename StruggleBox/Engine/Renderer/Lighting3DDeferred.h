@@ -53,7 +53,7 @@ public:
 		const GBuffer& gBuffer,
 		const glm::vec3& reflectionPos,
 		const float reflectionSize,
-		const GLuint reflectionCubeMap);
+		const uint32_t reflectionCubeMap);
 
 private:
 	RenderCore& m_renderCore;
@@ -0,0 +1,77 @@
+#include "NullRenderBackend.h"
+
+NullRenderBackend::NullRenderBackend()
+    : m_nextHandle(1)
+{
+    resetCounters();
+}
+
+void NullRenderBackend::createDrawData(DrawData& drawData, const VertexConfig& config, const VertexConfig* instanceConfig)
+{
+    drawData.handleVAO = m_nextHandle++;
+    drawData.handleVBO = m_nextHandle++;
+    m_counters.buffersCreated++;
+    if (instanceConfig)
+    {
+        drawData.handleIBO = m_nextHandle++;
+        m_counters.buffersCreated++;
+    }
+}
+
+void NullRenderBackend::destroyDrawData(const DrawData& drawData)
+{
+    m_counters.buffersDestroyed += drawData.handleIBO ? 2 : 1;
+}
+
+void NullRenderBackend::bufferData(const DrawData& drawData, const bool instanced, const void* data, const size_t size, const bool dynamic)
+{
+    m_counters.uploads++;
+    m_counters.bytesUploaded += size;
+}
+
+bool NullRenderBackend::streamData(const DrawData& drawData, const bool instanced, const void* data, const size_t size)
+{
+    m_counters.streams++;
+    m_counters.bytesStreamed += size;
+    return true;
+}
+
+uint32_t NullRenderBackend::createUniformBuffer(const uint32_t binding, const size_t size)
+{
+    m_counters.buffersCreated++;
+    return m_nextHandle++;
+}
+
+uint32_t NullRenderBackend::createTexture(const TextureParams& params, const uint32_t width, const uint32_t height, const void* data)
+{
+    m_counters.texturesCreated++;
+    return m_nextHandle++;
+}
+
+uint32_t NullRenderBackend::createCubeMap(const uint32_t size)
+{
+    m_counters.texturesCreated++;
+    return m_nextHandle++;
+}
+
+uint32_t NullRenderBackend::createFrameBuffer(const uint32_t* colorTextures, const uint32_t colorCount, const uint32_t depthStencilTexture)
+{
+    m_counters.frameBuffersCreated++;
+    return m_nextHandle++;
+}
+
+void NullRenderBackend::drawArrays(const DrawMode mode, const uint32_t first, const uint32_t count)
+{
+    m_counters.drawCalls++;
+}
+
+void NullRenderBackend::drawArraysInstanced(const DrawMode mode, const uint32_t first, const uint32_t count, const uint32_t instanceCount)
+{
+    m_counters.drawCalls++;
+    m_counters.instancesDrawn += instanceCount;
+}
+
+void NullRenderBackend::resetCounters()
+{
+    m_counters = RenderBackendCounters();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+struct RenderBackendCounters
+{
+    uint32_t buffersCreated;
+    uint32_t buffersDestroyed;
+    uint32_t uploads;
+    uint64_t bytesUploaded;
+    uint32_t streams;
+    uint64_t bytesStreamed;
+    uint32_t uniformBufferUpdates;
+    uint32_t texturesCreated;           // Cube maps included
+    uint32_t texturesDestroyed;
+    uint32_t textureUpdates;
+    uint32_t frameBuffersCreated;
+    uint32_t frameBuffersDestroyed;
+    uint32_t clears;
+    uint32_t drawCalls;
+    uint32_t instancesDrawn;
+    uint32_t stateChanges;
+    uint32_t uniformsSet;
+};
+
+// Takes the calls without a GL context and only counts them, handles it hands
+// out are made up. Lets RenderCore and the renderers built on it run headless.
+class NullRenderBackend : public RenderBackend
+{
+public:
+    NullRenderBackend();
+
+    bool compilesShaders() const override { return false; }
+
+    void createDrawData(DrawData& drawData, const VertexConfig& config, const VertexConfig* instanceConfig) override;
+    void destroyDrawData(const DrawData& drawData) override;
+    void bufferData(const DrawData& drawData, const bool instanced, const void* data, const size_t size, const bool dynamic) override;
+    bool streamData(const DrawData& drawData, const bool instanced, const void* data, const size_t size) override;
+
+    uint32_t createUniformBuffer(const uint32_t binding, const size_t size) override;
+    void destroyUniformBuffer(const uint32_t buffer) override {}
+    void updateUniformBuffer(const uint32_t buffer, const void* data, const size_t size) override { m_counters.uniformBufferUpdates++; }
+
+    uint32_t createTexture(const TextureParams& params, const uint32_t width, const uint32_t height, const void* data) override;
+    void updateTexture(const uint32_t texture, const TextureFormat format, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const void* data) override { m_counters.textureUpdates++; }
+    void destroyTexture(const uint32_t texture) override { m_counters.texturesDestroyed++; }
+    uint32_t createCubeMap(const uint32_t size) override;
+    void generateCubeMapMipmaps(const uint32_t cubeMap) override {}
+
+    uint32_t createFrameBuffer(const uint32_t* colorTextures, const uint32_t colorCount, const uint32_t depthStencilTexture) override;
+    void destroyFrameBuffer(const uint32_t frameBuffer) override { m_counters.frameBuffersDestroyed++; }
+    void attachCubeMapSide(const uint32_t frameBuffer, const uint32_t cubeMap, const uint32_t side) override { m_counters.stateChanges++; }
+    void bindFrameBuffer(const uint32_t frameBuffer) override { m_counters.stateChanges++; }
+    void setViewport(const int32_t x, const int32_t y, const int32_t width, const int32_t height) override { m_counters.stateChanges++; }
+    void clear(const Color& color, const bool clearDepth, const bool clearStencil) override { m_counters.clears++; }
+    void blitToScreen(const uint32_t frameBuffer, const int32_t colorAttachment, const glm::ivec4& source, const glm::ivec4& destination) override {}
+    float readDepth(const int32_t x, const int32_t y) override { return 1.f; }
+
+    void useProgram(const uint32_t program) override { m_counters.stateChanges++; }
+    void bindVertexArray(const uint32_t vao) override { m_counters.stateChanges++; }
+    void bindArrayBuffer(const uint32_t buffer) override { m_counters.stateChanges++; }
+    void setActiveTexture(const uint32_t unit) override { m_counters.stateChanges++; }
+    void bindTexture(const uint32_t texture) override { m_counters.stateChanges++; }
+    void bindCubeMap(const uint32_t cubeMap) override { m_counters.stateChanges++; }
+    void setBlendEnabled(const bool enable) override { m_counters.stateChanges++; }
+    void setBlendFunc(const BlendFunc srcFunc, const BlendFunc dstFunc) override { m_counters.stateChanges++; }
+    void setDepthTestEnabled(const bool enable) override { m_counters.stateChanges++; }
+    void setDepthFunc(const DepthFunc func) override { m_counters.stateChanges++; }
+    void setDepthMask(const bool mask) override { m_counters.stateChanges++; }
+    void setCullingEnabled(const bool enable) override { m_counters.stateChanges++; }
+    void setStencilTestEnabled(const bool enable) override { m_counters.stateChanges++; }
+    void setStencilFunc(const DepthFunc func, const uint8_t ref) override { m_counters.stateChanges++; }
+
+    // The empty shaders have no uniforms, so every location is -1 but still counted
+    void setUniform1i(const int32_t location, const int value) override { m_counters.uniformsSet++; }
+    void setUniform1f(const int32_t location, const float value) override { m_counters.uniformsSet++; }
+    void setUniform2f(const int32_t location, const glm::vec2& value) override { m_counters.uniformsSet++; }
+    void setUniform3f(const int32_t location, const glm::vec3& value) override { m_counters.uniformsSet++; }
+    void setUniform4f(const int32_t location, const glm::vec4& value) override { m_counters.uniformsSet++; }
+    void setUniformM3(const int32_t location, const glm::mat3& value) override { m_counters.uniformsSet++; }
+    void setUniformM4(const int32_t location, const glm::mat4& value) override { m_counters.uniformsSet++; }
+
+    void drawArrays(const DrawMode mode, const uint32_t first, const uint32_t count) override;
+    void drawArraysInstanced(const DrawMode mode, const uint32_t first, const uint32_t count, const uint32_t instanceCount) override;
+
+    void beginFrame() override {}
+    void endFrame() override {}
+
+    const RenderBackendCounters& getCounters() const { return m_counters; }
+    void resetCounters();
+
+private:
+    uint32_t m_nextHandle;
+    RenderBackendCounters m_counters;
+};
@@ -1,6 +1,7 @@
 #include "ReflectionProbe.h"
 
 #include "Console.h"	// Should be removed after debugging size no longer needed
+#include "RenderBackend.h"
 #include <glm/gtc/matrix_transform.hpp>
 #define _USE_MATH_DEFINES
 #include <math.h> 
@@ -24,55 +25,36 @@ static const glm::vec3 cubeViewPosition[6] = {
 	glm::vec3(0.0f, 0.0f,-1.0f), // -z
 };
 
-ReflectionProbe::ReflectionProbe()
-	: m_empty(true)
+ReflectionProbe::ReflectionProbe(RenderBackend& backend)
+	: m_backend(backend)
+	, m_textureSize(0)
+	, m_empty(true)
 	, m_size(16.0f)
-	, m_cubeMap(0)
 	, m_fbo(0)
-	, m_textureSize(0)
+	, m_cubeMap(0)
 {
 	Console::AddVar((float&)m_size, "probeSize");
 }
 
 ReflectionProbe::~ReflectionProbe()
 {
-	glDeleteFramebuffers(1, &m_fbo);
-	glDeleteTextures(1, &m_cubeMap);
+	// Never set up unless reflections were rendered
+	if (m_fbo) m_backend.destroyFrameBuffer(m_fbo);
+	if (m_cubeMap) m_backend.destroyTexture(m_cubeMap);
 }
 
 void ReflectionProbe::setup(const int size)
 {
-	// Generate shadow cubemap for point lights
-	glGenTextures(1, &m_cubeMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubeMap);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LOD, 4);
-	glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-	// Create a shadow cubemap framebuffer object
-	glGenFramebuffers(1, &m_fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_cubeMap, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	m_cubeMap = m_backend.createCubeMap(size);
+	// Each side gets attached when it's bound
+	m_fbo = m_backend.createFrameBuffer(nullptr, 0, 0);
 
 	m_textureSize = size;
 }
 
 void ReflectionProbe::bind(const CubeMapSide side)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + side, m_cubeMap, 0);
+	m_backend.attachCubeMapSide(m_fbo, m_cubeMap, side);
 }
 
 const glm::mat4 ReflectionProbe::getRotation(const CubeMapSide side)
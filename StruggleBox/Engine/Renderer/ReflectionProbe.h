@@ -1,6 +1,9 @@
 #pragma once
 
-#include "CoreIncludes.h"
+#include "glm/glm.hpp"
+#include <stdint.h>
+
+class RenderBackend;
 
 enum CubeMapSide
 {
@@ -15,7 +18,7 @@ enum CubeMapSide
 class ReflectionProbe
 {
 public:
-	ReflectionProbe();
+	ReflectionProbe(RenderBackend& backend);
 	~ReflectionProbe();
 
 	void setup(const int size);
@@ -35,14 +38,15 @@ public:
 	const bool emtpy() const { return m_empty; }
 	const glm::vec3 getPosition() const { return m_position; }
 	const float getSize() const { return m_size; };
-	const GLuint getCubeMap() const { return m_cubeMap; }
+	const uint32_t getCubeMap() const { return m_cubeMap; }
 	const glm::vec4 getViewPort() { return glm::vec4(0, 0, m_textureSize, m_textureSize); }
 
 private:
+	RenderBackend& m_backend;
 	int m_textureSize;
 	bool m_empty;
 	glm::vec3 m_position;
 	float m_size;
-	GLuint m_fbo;
-	GLuint m_cubeMap;
+	uint32_t m_fbo;
+	uint32_t m_cubeMap;
 };
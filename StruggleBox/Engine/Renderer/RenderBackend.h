@@ -0,0 +1,92 @@
+#pragma once
+
+#include "RendererDefines.h"
+#include "DrawDataCache.h"
+#include <string>
+
+class Allocator;
+
+// The GL work of RenderCore, the renderers and their passes, behind an interface so
+// they can run without a GL context. Calls are made as they are, GLStateCache already
+// dropped the redundant ones it sees before they get here.
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() {}
+
+    // Without it RenderCore hands out empty shaders instead of compiling them
+    virtual bool compilesShaders() const = 0;
+
+    // Handles and attribute layout for the draw data, sizes are already filled in
+    virtual void createDrawData(DrawData& drawData, const VertexConfig& config, const VertexConfig* instanceConfig) = 0;
+    virtual void destroyDrawData(const DrawData& drawData) = 0;
+    // Into the draw data's own vertex or instance buffer, which has to be bound along with its vertex array
+    virtual void bufferData(const DrawData& drawData, const bool instanced, const void* data, const size_t size, const bool dynamic) = 0;
+    // Data for the next draw of the bound vertex array, written to a shared streaming buffer instead
+    // of its own. Returns false when it can't be streamed and has to go through bufferData.
+    virtual bool streamData(const DrawData& drawData, const bool instanced, const void* data, const size_t size) = 0;
+
+    // Buffers behind the shared uniform blocks, bound to their binding point for good
+    virtual uint32_t createUniformBuffer(const uint32_t binding, const size_t size) = 0;
+    virtual void destroyUniformBuffer(const uint32_t buffer) = 0;
+    virtual void updateUniformBuffer(const uint32_t buffer, const void* data, const size_t size) = 0;
+
+    // Made on the active texture unit, which is left with nothing bound. Data can be null,
+    // rows of R8 data are tightly packed and rows of the other formats 4-byte aligned.
+    virtual uint32_t createTexture(const TextureParams& params, const uint32_t width, const uint32_t height, const void* data) = 0;
+    virtual void updateTexture(const uint32_t texture, const TextureFormat format, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const void* data) = 0;
+    virtual void destroyTexture(const uint32_t texture) = 0;
+    // Six empty RGBA sides, linearly filtered through their mipmaps and sampled seamlessly
+    virtual uint32_t createCubeMap(const uint32_t size) = 0;
+    virtual void generateCubeMapMipmaps(const uint32_t cubeMap) = 0;
+
+    // Every color texture is drawn to, in order. The depth stencil texture can be 0.
+    virtual uint32_t createFrameBuffer(const uint32_t* colorTextures, const uint32_t colorCount, const uint32_t depthStencilTexture) = 0;
+    virtual void destroyFrameBuffer(const uint32_t frameBuffer) = 0;
+    // Points the first color attachment at one side of a cube map, leaves the frame buffer bound
+    virtual void attachCubeMapSide(const uint32_t frameBuffer, const uint32_t cubeMap, const uint32_t side) = 0;
+    // 0 is the screen
+    virtual void bindFrameBuffer(const uint32_t frameBuffer) = 0;
+    virtual void setViewport(const int32_t x, const int32_t y, const int32_t width, const int32_t height) = 0;
+    // Of the bound frame buffer, depth is cleared to 1 and stencil to 0
+    virtual void clear(const Color& color, const bool clearDepth, const bool clearStencil) = 0;
+    // From a frame buffer's color attachment, or its depth when the attachment is negative, to the screen.
+    // Rectangles are x0, y0, x1, y1.
+    virtual void blitToScreen(const uint32_t frameBuffer, const int32_t colorAttachment, const glm::ivec4& source, const glm::ivec4& destination) = 0;
+    // 0 to 1, from the bound frame buffer
+    virtual float readDepth(const int32_t x, const int32_t y) = 0;
+
+    virtual void useProgram(const uint32_t program) = 0;
+    virtual void bindVertexArray(const uint32_t vao) = 0;
+    virtual void bindArrayBuffer(const uint32_t buffer) = 0;
+    virtual void setActiveTexture(const uint32_t unit) = 0;
+    virtual void bindTexture(const uint32_t texture) = 0;
+    virtual void bindCubeMap(const uint32_t cubeMap) = 0;
+    virtual void setBlendEnabled(const bool enable) = 0;
+    virtual void setBlendFunc(const BlendFunc srcFunc, const BlendFunc dstFunc) = 0;
+    virtual void setDepthTestEnabled(const bool enable) = 0;
+    virtual void setDepthFunc(const DepthFunc func) = 0;
+    virtual void setDepthMask(const bool mask) = 0;
+    // Back faces
+    virtual void setCullingEnabled(const bool enable) = 0;
+    virtual void setStencilTestEnabled(const bool enable) = 0;
+    // Passes where ref compares to the stored value with func, draws that pass store ref
+    virtual void setStencilFunc(const DepthFunc func, const uint8_t ref) = 0;
+
+    // Locations on the bound program from its Shader, -1 is skipped
+    virtual void setUniform1i(const int32_t location, const int value) = 0;
+    virtual void setUniform1f(const int32_t location, const float value) = 0;
+    virtual void setUniform2f(const int32_t location, const glm::vec2& value) = 0;
+    virtual void setUniform3f(const int32_t location, const glm::vec3& value) = 0;
+    virtual void setUniform4f(const int32_t location, const glm::vec4& value) = 0;
+    virtual void setUniformM3(const int32_t location, const glm::mat3& value) = 0;
+    virtual void setUniformM4(const int32_t location, const glm::mat4& value) = 0;
+
+    virtual void drawArrays(const DrawMode mode, const uint32_t first, const uint32_t count) = 0;
+    virtual void drawArraysInstanced(const DrawMode mode, const uint32_t first, const uint32_t count, const uint32_t instanceCount) = 0;
+
+    // Default depth state and a cleared screen
+    virtual void beginFrame() = 0;
+    // Everything streamed this frame has been drawn
+    virtual void endFrame() = 0;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "RendererDefines.h"
+#include "GL/glew.h"
+
+// Passes submit in this order when they share a command buffer
+enum class RenderPass : uint8_t
+{
+    Geometry,
+    Forward,
+    Overlay,
+    GUI
+};
+
+// Draws queued with RenderCore are sorted by a 64 bit key, most significant first:
+// pass (4 bits), layer (8), shader (12), texture (12), blend and depth state (8), depth (20)
+// Layers keep draws that have to stay in order apart, within a layer draws are grouped by
+// shader, texture and state and then go front to back. Equal keys keep the order they were queued in.
+namespace RenderSortKey
+{
+    const uint32_t PASS_SHIFT = 60;
+    const uint32_t LAYER_SHIFT = 52;
+    const uint32_t SHADER_SHIFT = 40;
+    const uint32_t TEXTURE_SHIFT = 28;
+    const uint32_t STATE_SHIFT = 20;
+    const uint32_t MAX_DEPTH = (1 << 20) - 1;
+
+    inline uint64_t make(
+        const RenderPass pass,
+        const uint8_t layer,
+        const ShaderID shaderID,
+        const GLuint texture,
+        const uint8_t state,
+        const uint32_t depth)
+    {
+        // IDs past the field width only group less well, the command itself keeps the full value
+        return ((uint64_t)pass << PASS_SHIFT) |
+            ((uint64_t)layer << LAYER_SHIFT) |
+            ((uint64_t)(shaderID & 0xFFF) << SHADER_SHIFT) |
+            ((uint64_t)(texture & 0xFFF) << TEXTURE_SHIFT) |
+            ((uint64_t)state << STATE_SHIFT) |
+            (uint64_t)(depth < MAX_DEPTH ? depth : MAX_DEPTH);
+    }
+
+    // Distance from the camera scaled into the depth field, nearest first
+    inline uint32_t depthFromDistance(const float distance, const float farDistance)
+    {
+        if (distance <= 0.f || farDistance <= 0.f)
+        {
+            return 0;
+        }
+        const float scaled = distance / farDistance;
+        return scaled >= 1.f ? MAX_DEPTH : (uint32_t)(scaled * MAX_DEPTH);
+    }
+}
+
+const uint32_t MAX_COMMAND_TEXTURES = 6;
+const uint32_t DRAW_DATA_VERTEX_COUNT = UINT32_MAX; // Draw however many vertices the draw data holds at submission
+
+// Everything needed to issue one draw, references point into frame memory
+struct RenderCommand
+{
+    const glm::mat4* viewProjection;
+    const void* data;                   // Uploaded right before drawing when set
+    uint32_t dataCount;
+    uint32_t rangeStart;
+    uint32_t drawCount;
+    ShaderID shaderID;
+    DrawDataID drawDataID;
+    DrawMode drawMode;
+    BlendMode blendMode;
+    DepthMode depthMode;
+    bool setTextureMap;                 // Point the textureMap sampler at unit 0
+    uint8_t textureCount;
+    GLuint textures[MAX_COMMAND_TEXTURES];
+    const char* uniformName;            // Optional per draw vec4 uniform, name has to be a literal
+    glm::vec4 uniformValue;
+
+    void setUniform(const char* name, const glm::vec4& value)
+    {
+        uniformName = name;
+        uniformValue = value;
+    }
+};
+
+// Draw totals of one frame, counted as commands reach the backend
+struct RenderFrameStats
+{
+    uint32_t commands;
+    uint32_t drawCalls;
+    uint32_t bytesUploaded;
+    uint32_t bytesStreamed;             // Part of the upload that went through the streaming buffer
+    uint32_t stateChanges;
+    uint32_t redundantStateChanges;
+};
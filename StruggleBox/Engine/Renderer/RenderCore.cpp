@@ -13,25 +13,44 @@
 #include "Texture2D.h"
 #include "Shader.h"
 #include "ShaderLoader.h"
-#include <GL/glew.h>
+#include "Profiler.h"
+#include "RenderBackend.h"
+#include "Timer.h"
+#include <algorithm>
+#include <cstring>
 
 const size_t FRAME_ALLOCATOR_SIZE = 64 * 1024 * 1024;
-static uint32_t GL_DRAW_MODES[] = {
-    GL_POINTS, GL_LINES, GL_LINE_LOOP, GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_TRIANGLE_FAN
-};
+const uint32_t MAX_RENDER_COMMANDS = 16384; // Per submission, a full buffer is submitted early
 
-RenderCore::RenderCore(Allocator& reanderAllocator, ThreadPool& threadPool)
+RenderCore::RenderCore(Allocator& reanderAllocator, JobSystem& jobSystem, RenderBackend& backend)
 : m_allocator(reanderAllocator)
+, m_backend(backend)
 , m_frameAllocator(FRAME_ALLOCATOR_SIZE, reanderAllocator.allocate(FRAME_ALLOCATOR_SIZE))
-, m_textureLoader(reanderAllocator, threadPool)
+, m_textureLoader(backend, reanderAllocator, jobSystem)
 , m_textureCache()
 , m_atlasCache()
 , m_shaderCache()
 , m_frameCache()
 , m_textAtlasCache()
-, m_drawDataCache()
+, m_drawDataCache(backend)
 , m_renderResolution(1920, 1080)
-{
+, m_stateCache(backend)
+, m_commands(nullptr)
+, m_commandEntries(nullptr)
+, m_numCommands(0)
+, m_lastQueuedMatrix(nullptr)
+, m_boundViewProjection(nullptr)
+, m_frameStats()
+, m_lastFrameStats()
+, m_frameConstants(UniformBlocks::getDefaultFrameConstants())
+, m_viewProjection(0.f)
+{
+    memset(m_viewBlock, 0, sizeof(m_viewBlock));
+    for (uint32_t binding = 0; binding < (uint32_t)UniformBlockBinding::Count; binding++)
+    {
+        const uint32_t size = UniformBlocks::getBlockSize((UniformBlockBinding)binding);
+        m_uniformBuffers[binding] = m_backend.createUniformBuffer(binding, size);
+    }
 }
 
 RenderCore::~RenderCore()
@@ -75,6 +94,12 @@ void RenderCore::terminate()
 
     m_drawDataCache.terminate();
 
+    for (uint32_t binding = 0; binding < (uint32_t)UniformBlockBinding::Count; binding++)
+    {
+        m_backend.destroyUniformBuffer(m_uniformBuffers[binding]);
+        m_uniformBuffers[binding] = 0;
+    }
+
     m_frameAllocator.clear();
     void* frameAllocatorStart = m_frameAllocator.getStart();
     CUSTOM_DELETE(frameAllocatorStart, m_allocator);
@@ -180,7 +205,9 @@ ShaderID RenderCore::getShaderID(const std::string& shaderComputeName)
     ShaderID cachedID = m_shaderCache.getShaderID(shaderComputeName);
     if (cachedID == ShaderCache::NO_SHADER_ID)
     {
-        Shader* shader = ShaderLoader::load(shaderComputeName, m_allocator);
+        Shader* shader = m_backend.compilesShaders() ?
+            ShaderLoader::load(shaderComputeName, m_backend, m_allocator) :
+            createEmptyShader();
         if (shader)
         {
             cachedID = m_shaderCache.addShader(shader, shaderComputeName);
@@ -194,7 +221,9 @@ ShaderID RenderCore::getShaderID(const std::string& shaderVertexName, const std:
     ShaderID cachedID = m_shaderCache.getShaderID(shaderVertexName, shaderFragName);
     if (cachedID == ShaderCache::NO_SHADER_ID)
     {
-        Shader* shader = ShaderLoader::load(shaderVertexName, shaderFragName, m_allocator);
+        Shader* shader = m_backend.compilesShaders() ?
+            ShaderLoader::load(shaderVertexName, shaderFragName, m_backend, m_allocator) :
+            createEmptyShader();
         if (shader)
         {
             cachedID = m_shaderCache.addShader(shader, shaderVertexName, shaderFragName);
@@ -208,7 +237,9 @@ ShaderID RenderCore::getShaderID(const std::string& shaderGeometryName, const st
     ShaderID cachedID = m_shaderCache.getShaderID(shaderGeometryName, shaderVertexName, shaderFragName);
     if (cachedID == ShaderCache::NO_SHADER_ID)
     {
-        Shader* shader = ShaderLoader::load(shaderGeometryName, shaderVertexName, shaderFragName, m_allocator);
+        Shader* shader = m_backend.compilesShaders() ?
+            ShaderLoader::load(shaderGeometryName, shaderVertexName, shaderFragName, m_backend, m_allocator) :
+            createEmptyShader();
         if (shader)
         {
             cachedID = m_shaderCache.addShader(shader, shaderGeometryName, shaderVertexName, shaderFragName);
@@ -222,7 +253,9 @@ ShaderID RenderCore::getShaderIDFromSource(const std::string& shaderVertexSource
     ShaderID cachedID = m_shaderCache.getShaderID(shaderName, "");
     if (cachedID == ShaderCache::NO_SHADER_ID)
     {
-        Shader* shader = ShaderLoader::loadFromSource(shaderVertexSource, shaderFragmentSource, m_allocator);
+        Shader* shader = m_backend.compilesShaders() ?
+            ShaderLoader::loadFromSource(shaderVertexSource, shaderFragmentSource, m_backend, m_allocator) :
+            createEmptyShader();
         if (shader)
         {
             cachedID = m_shaderCache.addShader(shader, shaderName, "");
@@ -236,7 +269,9 @@ ShaderID RenderCore::getShaderIDFromSource(const std::string& shaderGeometrySour
     ShaderID cachedID = m_shaderCache.getShaderID(shaderName, "");
     if (cachedID == ShaderCache::NO_SHADER_ID)
     {
-        Shader* shader = ShaderLoader::loadFromSource(shaderGeometrySource, shaderVertexSource, shaderFragmentSource, m_allocator);
+        Shader* shader = m_backend.compilesShaders() ?
+            ShaderLoader::loadFromSource(shaderGeometrySource, shaderVertexSource, shaderFragmentSource, m_backend, m_allocator) :
+            createEmptyShader();
         if (shader)
         {
             cachedID = m_shaderCache.addShader(shader, shaderName, "");
@@ -275,7 +310,7 @@ TextAtlasID RenderCore::getTextAtlasID(const std::string& textAtlasName, const u
     TextAtlasID cachedID = m_textAtlasCache.getTextAtlasID(fontNameAndSize);
     if (cachedID == TextAtlasCache::NO_ATLAS_ID)
     {
-        TextAtlas* atlas = TextAtlasLoader::load(textAtlasName, fontHeight, m_allocator, m_textureCache);
+        TextAtlas* atlas = TextAtlasLoader::load(textAtlasName, fontHeight, m_backend, m_allocator, m_textureCache);
         if (atlas)
         {
             cachedID = m_textAtlasCache.addTextAtlas(atlas, fontNameAndSize);
@@ -310,6 +345,11 @@ DrawDataID RenderCore::createInstancedDrawData(const VertexConfig& instanceConfi
     return m_drawDataCache.createInstancedDrawData(instanceConfig, config);
 }
 
+void RenderCore::removeDrawData(const DrawDataID dataID)
+{
+    m_drawDataCache.destroyDrawData(dataID);
+}
+
 DrawData& RenderCore::getDrawData(const DrawDataID dataID)
 {
     return m_drawDataCache.getDrawData(dataID);
@@ -338,10 +378,12 @@ void RenderCore::upload(const DrawDataID drawDataID, const void* data, const siz
 {
     DrawData& drawData = getDrawData(drawDataID);
     const bool dynamic = drawData.handleIBO == 0;
-    glBindVertexArray(drawData.handleVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, drawData.handleVBO);
-    glBufferData(GL_ARRAY_BUFFER, drawData.vertexDataSize * count, data, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
-    glBindVertexArray(0);
+    invalidateState();
+    m_stateCache.bindVertexArray(drawData.handleVAO);
+    m_stateCache.bindArrayBuffer(drawData.handleVBO);
+    m_backend.bufferData(drawData, false, data, drawData.vertexDataSize * count, dynamic);
+    m_stateCache.bindVertexArray(0);
+    m_frameStats.bytesUploaded += drawData.vertexDataSize * (uint32_t)count;
     drawData.vertexCount = count;
 }
 
@@ -357,118 +399,354 @@ void RenderCore::draw(
     const BlendMode blendMode,
     const DepthMode depthMode)
 {
-    const Shader* shader = getShaderByID(shaderID);
-    DrawData& drawData = getDrawData(drawDataID);
+    RenderCommand command;
+    command.viewProjection = &matrix;
+    command.data = data;
+    command.dataCount = rangeEnd;
+    command.rangeStart = rangeStart;
+    command.drawCount = rangeEnd;
+    command.shaderID = shaderID;
+    command.drawDataID = drawDataID;
+    command.drawMode = drawMode;
+    command.blendMode = blendMode;
+    command.depthMode = depthMode;
+    command.setTextureMap = textureID != 0;
+    command.textureCount = textureID != 0 ? 1 : 0;
+    command.textures[0] = getGLTexture(textureID);
+    command.uniformName = nullptr;
+
+    // Whatever was drawn since the last submission may have changed GL behind the cache's back
+    invalidateState();
+    execute(command);
+}
+
+void RenderCore::draw(
+    const DrawParameters& drawParams,
+    const glm::mat4& matrix,
+    const DrawMode drawMode,
+    const void* data,
+    const size_t count)
+{
+    RenderCommand command;
+    command.viewProjection = &matrix;
+    command.data = data;
+    command.dataCount = (uint32_t)count;
+    command.rangeStart = 0;
+    command.drawCount = DRAW_DATA_VERTEX_COUNT;
+    command.shaderID = drawParams.shaderID;
+    command.drawDataID = drawParams.drawDataID;
+    command.drawMode = drawMode;
+    command.blendMode = drawParams.blendMode;
+    command.depthMode = drawParams.depthMode;
+    command.setTextureMap = false;
+    command.textureCount = std::min<uint8_t>(drawParams.textureCount, MAX_COMMAND_TEXTURES);
+    for (uint8_t i = 0; i < command.textureCount; i++)
+    {
+        command.textures[i] = getGLTexture(drawParams.textureIDs[i]);
+    }
+    command.uniformName = nullptr;
 
-    GLUtils::setBlendMode(blendMode);
-    GLUtils::setDepthMode(depthMode);
+    invalidateState();
+    execute(command);
+}
 
-    glBindVertexArray(drawData.handleVAO);
-    if (data)
+RenderCommand& RenderCore::queueDraw(
+    const RenderPass pass,
+    const uint8_t layer,
+    const ShaderID shaderID,
+    const TextureID textureID,
+    const DrawDataID drawDataID,
+    const glm::mat4& matrix,
+    const DrawMode drawMode,
+    const void* data,
+    const uint32_t rangeStart,
+    const uint32_t rangeEnd,
+    const BlendMode blendMode,
+    const DepthMode depthMode)
+{
+    const GLuint texture = getGLTexture(textureID);
+    RenderCommand& command = addCommand(pass, layer, shaderID, texture, blendMode, depthMode, 0);
+    command.viewProjection = storeMatrix(matrix);
+    command.data = data;
+    command.dataCount = rangeEnd;
+    command.rangeStart = rangeStart;
+    command.drawCount = rangeEnd;
+    command.drawDataID = drawDataID;
+    command.drawMode = drawMode;
+    command.setTextureMap = textureID != 0;
+    command.textureCount = textureID != 0 ? 1 : 0;
+    command.textures[0] = texture;
+    return command;
+}
+
+RenderCommand& RenderCore::queueDraw(
+    const RenderPass pass,
+    const uint8_t layer,
+    const DrawParameters& drawParams,
+    const glm::mat4& matrix,
+    const DrawMode drawMode,
+    const void* data,
+    const size_t count,
+    const uint32_t depth)
+{
+    const uint8_t textureCount = std::min<uint8_t>(drawParams.textureCount, MAX_COMMAND_TEXTURES);
+    GLuint textures[MAX_COMMAND_TEXTURES] = {};
+    for (uint8_t i = 0; i < textureCount; i++)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, drawData.handleVBO);
-        if (!drawData.handleIBO)
-        {
-            glBufferData(GL_ARRAY_BUFFER, drawData.vertexDataSize * rangeEnd, data, GL_DYNAMIC_DRAW);
-            drawData.vertexCount = rangeEnd;
-        }
-        else
-        {
-            glBindBuffer(GL_ARRAY_BUFFER, drawData.handleIBO);
-            glBufferData(GL_ARRAY_BUFFER, drawData.instanceDataSize * rangeEnd, data, GL_DYNAMIC_DRAW);
-            drawData.instanceCount = rangeEnd;
-        }
+        textures[i] = getGLTexture(drawParams.textureIDs[i]);
     }
-    shader->begin();
-    if (shader->hasUniform("viewProjection"))
+
+    RenderCommand& command = addCommand(pass, layer, drawParams.shaderID, textures[0], drawParams.blendMode, drawParams.depthMode, depth);
+    command.viewProjection = storeMatrix(matrix);
+    command.data = data;
+    command.dataCount = (uint32_t)count;
+    command.rangeStart = 0;
+    command.drawCount = DRAW_DATA_VERTEX_COUNT;
+    command.drawDataID = drawParams.drawDataID;
+    command.drawMode = drawMode;
+    command.setTextureMap = false;
+    command.textureCount = textureCount;
+    memcpy(command.textures, textures, sizeof(textures));
+    return command;
+}
+
+void RenderCore::submitCommands()
+{
+    if (m_numCommands == 0)
     {
-        shader->setUniformM4fv("viewProjection", matrix);
+        return;
     }
-    if (textureID != 0)
+    PROFILE_SCOPE("RenderCore::submitCommands");
+
+    // The index breaks ties, so draws with equal keys stay in the order they were queued
+    std::sort(m_commandEntries, m_commandEntries + m_numCommands, [](const RenderCommandEntry& a, const RenderCommandEntry& b) {
+        return a.key < b.key || (a.key == b.key && a.index < b.index);
+    });
+
+    invalidateState();
+    for (uint32_t i = 0; i < m_numCommands; i++)
     {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_textureCache.getTextureByID(textureID)->getGLTextureID());
-        shader->setUniform1iv("textureMap", 0);
+        execute(m_commands[m_commandEntries[i].index]);
     }
-    if (drawData.handleIBO)
+    m_frameStats.commands += m_numCommands;
+
+    // Recorded draws stay valid in frame memory, the buffers are reused for the next batch
+    m_numCommands = 0;
+    m_lastQueuedMatrix = nullptr;
+}
+
+RenderCommand& RenderCore::addCommand(
+    const RenderPass pass,
+    const uint8_t layer,
+    const ShaderID shaderID,
+    const GLuint texture,
+    const BlendMode& blendMode,
+    const DepthMode& depthMode,
+    const uint32_t depth)
+{
+    if (m_commands == nullptr)
     {
-        glDrawArraysInstanced(GL_DRAW_MODES[(uint32_t)drawMode], rangeStart, drawData.vertexCount, drawData.instanceCount);
+        m_commands = (RenderCommand*)m_frameAllocator.allocate(sizeof(RenderCommand) * MAX_RENDER_COMMANDS, __alignof(RenderCommand));
+        m_commandEntries = (RenderCommandEntry*)m_frameAllocator.allocate(sizeof(RenderCommandEntry) * MAX_RENDER_COMMANDS, __alignof(RenderCommandEntry));
     }
-    else
+    else if (m_numCommands == MAX_RENDER_COMMANDS)
     {
-        glDrawArrays(GL_DRAW_MODES[(uint32_t)drawMode], rangeStart, rangeEnd);
+        submitCommands();
     }
+
+    const uint32_t index = m_numCommands++;
+    m_commandEntries[index].key = RenderSortKey::make(pass, layer, shaderID, texture, getRenderStateID(blendMode, depthMode), depth);
+    m_commandEntries[index].index = index;
+
+    RenderCommand& command = m_commands[index];
+    command.shaderID = shaderID;
+    command.blendMode = blendMode;
+    command.depthMode = depthMode;
+    command.uniformName = nullptr;
+    return command;
 }
 
-void RenderCore::draw(
-    const DrawParameters& drawParams,
-    const glm::mat4& matrix,
-    const DrawMode drawMode,
-    const void* data,
-    const size_t count)
+const glm::mat4* RenderCore::storeMatrix(const glm::mat4& matrix)
+{
+    if (m_lastQueuedMatrix && *m_lastQueuedMatrix == matrix)
+    {
+        return m_lastQueuedMatrix;
+    }
+    glm::mat4* stored = (glm::mat4*)m_frameAllocator.allocate(sizeof(glm::mat4), __alignof(glm::mat4));
+    *stored = matrix;
+    m_lastQueuedMatrix = stored;
+    return stored;
+}
+
+uint8_t RenderCore::getRenderStateID(const BlendMode& blendMode, const DepthMode& depthMode)
+{
+    for (size_t i = 0; i < m_renderStates.size(); i++)
+    {
+        if (m_renderStates[i].first == blendMode && m_renderStates[i].second == depthMode)
+        {
+            return (uint8_t)i;
+        }
+    }
+    // Past the field width states share the last ID, which only costs some grouping
+    if (m_renderStates.size() < 255)
+    {
+        m_renderStates.emplace_back(blendMode, depthMode);
+        return (uint8_t)(m_renderStates.size() - 1);
+    }
+    return 255;
+}
+
+GLuint RenderCore::getGLTexture(const TextureID textureID)
 {
-    const Shader* shader = getShaderByID(drawParams.shaderID);
-    DrawData& drawData = getDrawData(drawParams.drawDataID);
+    if (textureID == 0)
+    {
+        return 0;
+    }
+    const Texture2D* texture = m_textureCache.getTextureByID(textureID);
+    return texture ? texture->getGLTextureID() : 0;
+}
 
-    GLUtils::setBlendMode(drawParams.blendMode);
-    GLUtils::setDepthMode(drawParams.depthMode);
+// Stands in for compiled shaders when the backend can't compile them, program 0 draws nothing
+Shader* RenderCore::createEmptyShader()
+{
+    return CUSTOM_NEW(Shader, m_allocator)(m_backend);
+}
 
-    glBindVertexArray(drawData.handleVAO);
-    if (data)
+void RenderCore::invalidateState()
+{
+    m_stateCache.invalidate();
+    m_boundViewProjection = nullptr;
+}
+
+void RenderCore::execute(const RenderCommand& command)
+{
+    const Shader* shader = getShaderByID(command.shaderID);
+    if (!shader)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, drawData.handleVBO);
-        if (!drawData.handleIBO)
+        return;
+    }
+    DrawData& drawData = getDrawData(command.drawDataID);
+
+    m_stateCache.setBlendMode(command.blendMode);
+    m_stateCache.setDepthMode(command.depthMode);
+    m_stateCache.bindVertexArray(drawData.handleVAO);
+    if (command.data)
+    {
+        const bool instanced = drawData.handleIBO != 0;
+        const uint32_t size = (instanced ? drawData.instanceDataSize : drawData.vertexDataSize) * command.dataCount;
+        if (m_backend.streamData(drawData, instanced, command.data, size))
         {
-            glBufferData(GL_ARRAY_BUFFER, drawData.vertexDataSize * count, data, GL_DYNAMIC_DRAW);
-            drawData.vertexCount = count;
+            m_frameStats.bytesStreamed += size;
         }
         else
         {
-            glBindBuffer(GL_ARRAY_BUFFER, drawData.handleIBO);
-            glBufferData(GL_ARRAY_BUFFER, drawData.instanceDataSize * count, data, GL_DYNAMIC_DRAW);
-            drawData.instanceCount = count;
+            m_stateCache.bindArrayBuffer(instanced ? drawData.handleIBO : drawData.handleVBO);
+            m_backend.bufferData(drawData, instanced, command.data, size, true);
         }
+        m_frameStats.bytesUploaded += size;
+        if (instanced)
+        {
+            drawData.instanceCount = command.dataCount;
+        }
+        else
+        {
+            drawData.vertexCount = command.dataCount;
+        }
+    }
+
+    // Programs read the matrix from the ViewConstants block, so it stays bound across program changes
+    const bool programChanged = m_stateCache.useProgram(shader->GetProgram());
+    if (command.viewProjection != m_boundViewProjection)
+    {
+        setViewProjection(*command.viewProjection);
+        m_boundViewProjection = command.viewProjection;
     }
-    shader->begin();
-    if (shader->hasUniform("viewProjection"))
+    if (command.setTextureMap && programChanged)
     {
-        shader->setUniformM4fv("viewProjection", matrix);
+        m_backend.setUniform1i(shader->findUniform("textureMap"), 0);
     }
-    for (uint8_t i = 0; i < drawParams.textureCount; i++)
+    if (command.uniformName)
+    {
+        m_backend.setUniform4f(shader->findUniform(command.uniformName), command.uniformValue);
+    }
+
+    for (uint8_t i = 0; i < command.textureCount; i++)
     {
-        const Texture2D* texture = getTextureByID(drawParams.textureIDs[i]);
-        if (!texture)
+        if (command.textures[i] != 0)
         {
-            continue;
+            m_stateCache.bindTexture(i, command.textures[i]);
         }
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, texture->getGLTextureID());
     }
+
     if (drawData.handleIBO)
     {
-        glDrawArraysInstanced(GL_DRAW_MODES[(uint32_t)drawMode], 0, drawData.vertexCount, drawData.instanceCount);
+        m_backend.drawArraysInstanced(command.drawMode, command.rangeStart, drawData.vertexCount, drawData.instanceCount);
     }
     else
     {
-        glDrawArrays(GL_DRAW_MODES[(uint32_t)drawMode], 0, drawData.vertexCount);
+        const uint32_t drawCount = command.drawCount == DRAW_DATA_VERTEX_COUNT ? (uint32_t)drawData.vertexCount : command.drawCount;
+        m_backend.drawArrays(command.drawMode, command.rangeStart, drawCount);
     }
+    m_frameStats.drawCalls++;
 }
 
 void RenderCore::beginFrame()
 {
+    const GLStateCounters& counters = m_stateCache.getCounters();
+    m_lastFrameStats = m_frameStats;
+    m_lastFrameStats.stateChanges = counters.stateChanges;
+    m_lastFrameStats.redundantStateChanges = counters.redundantStateChanges;
+    m_frameStats = RenderFrameStats();
+    m_stateCache.resetCounters();
+
     if (m_textureLoader.isLoading())
     {
         m_textureLoader.processQueue();
     }
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    glClearColor(0.f, 0.f, 0.f, 0.f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_backend.beginFrame();
+
+    m_frameConstants.time = (float)Timer::RunTimeSeconds();
+    m_frameConstants.renderResolution = glm::vec2(m_renderResolution);
+    uint8_t frameBlock[UniformBlocks::MAX_BLOCK_SIZE] = {};
+    UniformBlocks::pack(m_frameConstants, frameBlock);
+    const uint32_t frameBinding = (uint32_t)UniformBlockBinding::Frame;
+    m_backend.updateUniformBuffer(m_uniformBuffers[frameBinding], frameBlock, UniformBlocks::getBlockSize(UniformBlockBinding::Frame));
+}
+
+void RenderCore::setViewConstants(const ViewConstants& constants)
+{
+    UniformBlocks::pack(constants, m_viewBlock);
+    m_viewProjection = constants.projection * constants.view;
+    m_boundViewProjection = nullptr;
+    const uint32_t viewBinding = (uint32_t)UniformBlockBinding::View;
+    m_backend.updateUniformBuffer(m_uniformBuffers[viewBinding], m_viewBlock, UniformBlocks::getBlockSize(UniformBlockBinding::View));
+}
+
+// Draws made with the camera's matrix leave the block alone, others swap it in until the next one
+void RenderCore::setViewProjection(const glm::mat4& viewProjection)
+{
+    if (viewProjection == m_viewProjection)
+    {
+        return;
+    }
+    m_viewProjection = viewProjection;
+    UniformBlocks::packViewProjection(viewProjection, m_viewBlock);
+    const uint32_t viewBinding = (uint32_t)UniformBlockBinding::View;
+    m_backend.updateUniformBuffer(m_uniformBuffers[viewBinding], m_viewBlock, UniformBlocks::getBlockSize(UniformBlockBinding::View));
 }
 
 void RenderCore::endFrame()
 {
+    if (m_numCommands != 0)
+    {
+        Log::Warn("RenderCore::endFrame %u draws were queued but never submitted", m_numCommands);
+        submitCommands();
+    }
+    m_backend.endFrame();
+    m_commands = nullptr;
+    m_commandEntries = nullptr;
+    m_lastQueuedMatrix = nullptr;
     m_frameAllocator.clear();
 }
 
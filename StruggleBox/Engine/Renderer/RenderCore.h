@@ -1,7 +1,7 @@
 #pragma once
 
 #include "LinearAllocator.h"
-#include "ThreadPool.h"
+#include "JobSystem.h"
 #include "TextureLoader.h"
 #include "TextureCache.h"
 #include "TextureAtlasCache.h"
@@ -11,11 +11,17 @@
 #include "DrawDataCache.h"
 #include "RendererDefines.h"
 #include "DrawParameters.h"
+#include "GLStateCache.h"
+#include "RenderCommand.h"
+#include "UniformBlocks.h"
 #include <functional>
+#include <utility>
+#include <vector>
 
 class Allocator;
 class ComputeShader;
 class LinearAllocator;
+class RenderBackend;
 class Texture2D;
 class TextureAtlas;
 class Shader;
@@ -31,7 +37,7 @@ struct TempVertBuffer
 class RenderCore
 {
 public:
-    RenderCore(Allocator& allocator, ThreadPool& threadPool);
+    RenderCore(Allocator& allocator, JobSystem& jobSystem, RenderBackend& backend);
     ~RenderCore();
 
     void terminate();
@@ -61,6 +67,7 @@ public:
     DrawDataID createDrawData(const VertexConfig& config);
     DrawDataID createInstancedDrawData(const VertexConfig& instanceConfig, const VertexConfig& config);
     DrawData& getDrawData(const DrawDataID dataID);
+    void removeDrawData(const DrawDataID dataID);
 
     template <typename T>
     void setupTempVertBuffer(TempVertBuffer& buffer, const size_t capacity)
@@ -73,6 +80,8 @@ public:
     void* allocFrameData(const size_t size);
 
     void upload(const DrawDataID drawDataID, const void* data, const size_t count);
+
+    // Draws right away, for draws that depend on GL state set around them
     void draw(
         const ShaderID shaderID,
         const TextureID textureID,
@@ -91,17 +100,53 @@ public:
         const void* data,
         const size_t count);
 
+    // Records a draw into this frame's command buffer, data has to stay valid until it's submitted
+    RenderCommand& queueDraw(
+        const RenderPass pass,
+        const uint8_t layer,
+        const ShaderID shaderID,
+        const TextureID textureID,
+        const DrawDataID drawDataID,
+        const glm::mat4& matrix,
+        const DrawMode drawMode,
+        const void* data,
+        const uint32_t rangeStart,
+        const uint32_t rangeEnd,
+        const BlendMode blendMode,
+        const DepthMode depthMode);
+    RenderCommand& queueDraw(
+        const RenderPass pass,
+        const uint8_t layer,
+        const DrawParameters& drawParams,
+        const glm::mat4& matrix,
+        const DrawMode drawMode,
+        const void* data,
+        const size_t count,
+        const uint32_t depth = 0);
+    // Sorts everything queued and draws it, call before changing render targets or GL state the draws rely on
+    void submitCommands();
+
     void beginFrame();
     void endFrame();
 
+    // Camera for the ViewConstants block, set before drawing a view
+    void setViewConstants(const ViewConstants& constants);
+    // Uploaded to the FrameConstants block at the start of every frame, time and resolution are filled in
+    FrameConstants& getFrameConstants() { return m_frameConstants; }
+
     void setRenderResolution(const glm::ivec2& resolution) { m_renderResolution = resolution; }
     const glm::ivec2& getRenderResolution() const { return m_renderResolution; }
 
+    // Totals of the last finished frame
+    const RenderFrameStats& getLastFrameStats() const { return m_lastFrameStats; }
+
     TextureCache& getTextureCache() { return m_textureCache; }
     Allocator& getAllocator() { return m_allocator; }
+    RenderBackend& getBackend() { return m_backend; }
 
 private:
     Allocator& m_allocator;
+    RenderBackend& m_backend;
     LinearAllocator m_frameAllocator;
 
     TextureLoader m_textureLoader;
@@ -113,4 +158,41 @@ private:
     DrawDataCache m_drawDataCache;
 
     glm::ivec2 m_renderResolution;
+
+    struct RenderCommandEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    GLStateCache m_stateCache;
+    RenderCommand* m_commands;                      // Frame memory, allocated by the first draw queued each frame
+    RenderCommandEntry* m_commandEntries;
+    uint32_t m_numCommands;
+    const glm::mat4* m_lastQueuedMatrix;            // Draws queued with the same matrix share one copy
+    const glm::mat4* m_boundViewProjection;          // Matrix of the last draw, only a hint, the value is compared
+    std::vector<std::pair<BlendMode, DepthMode>> m_renderStates;
+    RenderFrameStats m_frameStats;
+    RenderFrameStats m_lastFrameStats;
+
+    uint32_t m_uniformBuffers[(uint32_t)UniformBlockBinding::Count];
+    FrameConstants m_frameConstants;
+    uint8_t m_viewBlock[UniformBlocks::MAX_BLOCK_SIZE];  // What the View buffer holds, draws rewrite its viewProjection
+    glm::mat4 m_viewProjection;
+
+    RenderCommand& addCommand(
+        const RenderPass pass,
+        const uint8_t layer,
+        const ShaderID shaderID,
+        const GLuint texture,
+        const BlendMode& blendMode,
+        const DepthMode& depthMode,
+        const uint32_t depth);
+    const glm::mat4* storeMatrix(const glm::mat4& matrix);
+    uint8_t getRenderStateID(const BlendMode& blendMode, const DepthMode& depthMode);
+    GLuint getGLTexture(const TextureID textureID);
+    Shader* createEmptyShader();
+    void invalidateState();
+    void setViewProjection(const glm::mat4& viewProjection);
+    void execute(const RenderCommand& command);
 };
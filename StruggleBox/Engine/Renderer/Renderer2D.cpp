@@ -2,12 +2,11 @@
 
 #include "Allocator.h"
 #include "DefaultShaders.h"
-#include "GLErrorUtil.h"
 #include "Log.h"
 #include "MathUtils.h"
+#include "RenderBackend.h"
 #include "RenderCore.h"
 #include "Shader.h"
-#include <GL/glew.h>
 #include <algorithm>
 
 const TexturedVertex2DData QUAD_VERTS[6] = {
@@ -46,29 +45,22 @@ Renderer2D::~Renderer2D()
 
 void Renderer2D::initialize()
 {
-    CHECK_GL_ERROR();
-
 	m_coloredVertsDrawDataID = m_renderCore.createDrawData(ColoredVertexConfig);
     m_coloredLinesDrawDataID = m_renderCore.createDrawData(ColoredVertexConfig);
 	m_texturedVertsDrawDataID = m_renderCore.createDrawData(TexturedVertex3DConfig);
 	m_textVertsDrawDataID = m_renderCore.createDrawData(TexturedVertex3DConfig);
-    CHECK_GL_ERROR();
 
     m_impostorVertsDrawDataID = m_renderCore.createInstancedDrawData(ImpostorVertexConfig, TexturedVertex2DConfig);
-    CHECK_GL_ERROR();
 
     m_renderCore.upload(m_impostorVertsDrawDataID, QUAD_VERTS, 6);
-    CHECK_GL_ERROR();
 
 	m_coloredVertsShaderID = m_renderCore.getShaderIDFromSource(coloredVertexShaderSource, coloredFragmentShaderSource, "ColoredVertsShader");
     m_texturedVertsShaderID = m_renderCore.getShaderIDFromSource(texturedVertexShaderSource, texturedFragmentShaderSource, "TexturedVertsShader");
     m_textVertsShaderID = m_renderCore.getShaderIDFromSource(texturedVertexShaderSource, textFragmentShaderSource, "TextVertsShader");
     m_impostorShaderID = m_renderCore.getShaderIDFromSource(textured2DInstanceVertexShaderSoure, textured2DInstanceFragmentShaderSource, "Instanced2DVertsShader");
-    CHECK_GL_ERROR();
 
     m_defaultCamera.setViewSize(m_renderCore.getRenderResolution());
     m_defaultCamera.update(0.f);
-    CHECK_GL_ERROR();
 }
 
 void Renderer2D::terminate()
@@ -86,26 +78,27 @@ void Renderer2D::update(const double deltaTime)
 
 void Renderer2D::flush()
 {
-    glViewport(0, 0, m_renderCore.getRenderResolution().x, m_renderCore.getRenderResolution().y);
+    m_renderCore.getBackend().setViewport(0, 0, m_renderCore.getRenderResolution().x, m_renderCore.getRenderResolution().y);
 
 	const glm::mat4& view = m_defaultCamera.getViewMatrix();
 	const glm::mat4& projection = m_defaultCamera.getProjectionMatrix();
 	const glm::mat4 viewProjection = projection * view;
 
-    m_renderCore.draw(m_coloredVertsShaderID, 0, m_coloredLinesDrawDataID, viewProjection, DrawMode::Lines, m_coloredLineVertsBuffer.data, 0, m_coloredLineVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
-	m_renderCore.draw(m_coloredVertsShaderID, 0, m_coloredVertsDrawDataID, viewProjection, DrawMode::Triangles, m_coloredTriVertsBuffer.data, 0, m_coloredTriVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+    // Queued in layers so the blended categories draw in the same order as before
+    m_renderCore.queueDraw(RenderPass::Forward, 0, m_coloredVertsShaderID, 0, m_coloredLinesDrawDataID, viewProjection, DrawMode::Lines, m_coloredLineVertsBuffer.data, 0, m_coloredLineVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+    m_renderCore.queueDraw(RenderPass::Forward, 1, m_coloredVertsShaderID, 0, m_coloredVertsDrawDataID, viewProjection, DrawMode::Triangles, m_coloredTriVertsBuffer.data, 0, m_coloredTriVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
     
     for (const auto& pair : m_texturedTriVertsBuffers.getData())
     {
         const TextureID textureID = pair.first;
         const TempVertBuffer& buffer = pair.second;
-        m_renderCore.draw(m_texturedVertsShaderID, textureID, m_texturedVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+        m_renderCore.queueDraw(RenderPass::Forward, 2, m_texturedVertsShaderID, textureID, m_texturedVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
     }
     for (const auto& pair : m_textTriVertsBuffers.getData())
     {
         const TextureID textureID = pair.first;
         const TempVertBuffer& buffer = pair.second;
-        m_renderCore.draw(m_textVertsShaderID, textureID, m_textVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+        m_renderCore.queueDraw(RenderPass::Forward, 3, m_textVertsShaderID, textureID, m_textVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
     }
 
     const glm::vec2 camPos = m_defaultCamera.getPosition();
@@ -114,15 +107,14 @@ void Renderer2D::flush()
     {
         const DrawParameters& drawParams = pair.first;
         const TempVertBuffer& buffer = pair.second;
-        m_renderCore.draw(drawParams.shaderID, drawParams.textureIDs[0], m_impostorVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, drawParams.blendMode, drawParams.depthMode);
+        m_renderCore.queueDraw(RenderPass::Forward, 4, drawParams.shaderID, drawParams.textureIDs[0], m_impostorVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, drawParams.blendMode, drawParams.depthMode);
     }
+    m_renderCore.submitCommands();
     m_renderCore.clearTempVertBuffer(m_coloredTriVertsBuffer);
     m_renderCore.clearTempVertBuffer(m_coloredLineVertsBuffer);
     m_texturedTriVertsBuffers.clear();
     m_textTriVertsBuffers.clear();
     m_impostorBuffers.clear();
-
-    CHECK_GL_ERROR();
 }
 
 ColoredVertex3DData* Renderer2D::bufferColoredTriangles(const size_t count)
@@ -1,6 +1,7 @@
 #include "Renderer2DDeferred.h"
 
 #include "DefaultShaders.h"
+#include "RenderBackend.h"
 #include "Shader.h"
 
 const glm::mat4 s_projection2D = glm::ortho<float>(-0.5f, 0.5f, -0.5f, 0.5f, -1.f, 1.f);
@@ -67,9 +68,10 @@ void Renderer2DDeferred::flush(const std::vector<Shape2D*>& occluders)
 	{
 		m_lightSystem.renderLighting(occluders);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glViewport(0, 0, m_renderCore.getRenderResolution().x, m_renderCore.getRenderResolution().y);
+		RenderBackend& backend = m_renderCore.getBackend();
+		backend.bindFrameBuffer(0);
+		backend.clear(COLOR_NONE, true, false);
+		backend.setViewport(0, 0, m_renderCore.getRenderResolution().x, m_renderCore.getRenderResolution().y);
 
 		TempVertBuffer buffer;
 		m_renderCore.setupTempVertBuffer<TexturedVertex3DData>(buffer, 4);
@@ -80,8 +82,8 @@ void Renderer2DDeferred::flush(const std::vector<Shape2D*>& occluders)
 		dataPtr[3] = { glm::vec3(-0.5, 0.5, 0.0), glm::vec2(0, 1) };
 		const Shader* lightPassShader = m_renderCore.getShaderByID(m_lightPassShaderID);
 		lightPassShader->begin();
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, m_lightSystem.getFrameBuffer().getGLTexture());
+		backend.setActiveTexture(1);
+		backend.bindTexture(m_lightSystem.getFrameBuffer().getGLTexture());
 		lightPassShader->setUniform1iv("lightMap", 1);
 		m_renderCore.draw(m_lightPassShaderID, m_frameBuffer.getTextureID(), m_texturedVertsDrawDataID, s_projection2D, DrawMode::TriangleFan, dataPtr, 0, 4, BLEND_MODE_DISABLED, DEPTH_MODE_DISABLED);
 	}
@@ -65,20 +65,21 @@ void Renderer3D::flush()
     const glm::mat4& projection = m_defaultCamera.getProjectionMatrix();
     const glm::mat4 viewProjection = projection * view;
 
-    m_renderCore.draw(m_coloredVertsShaderID, 0, m_coloredVertsDrawDataID, viewProjection, DrawMode::Triangles, m_coloredTriVertsBuffer.data, 0, m_coloredTriVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
-    m_renderCore.draw(m_coloredVertsShaderID, 0, m_coloredLinesDrawDataID, viewProjection, DrawMode::Lines, m_coloredLineVertsBuffer.data, 0, m_coloredLineVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+    // Queued in layers so the blended categories draw in the same order as before
+    m_renderCore.queueDraw(RenderPass::Forward, 0, m_coloredVertsShaderID, 0, m_coloredVertsDrawDataID, viewProjection, DrawMode::Triangles, m_coloredTriVertsBuffer.data, 0, m_coloredTriVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+    m_renderCore.queueDraw(RenderPass::Forward, 1, m_coloredVertsShaderID, 0, m_coloredLinesDrawDataID, viewProjection, DrawMode::Lines, m_coloredLineVertsBuffer.data, 0, m_coloredLineVertsBuffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
 
     for (const auto& pair : m_texturedTriVertsBuffers)
     {
         const TextureID textureID = pair.first;
         const TempVertBuffer& buffer = pair.second;
-        m_renderCore.draw(m_texturedVertsShaderID, textureID, m_texturedVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+        m_renderCore.queueDraw(RenderPass::Forward, 2, m_texturedVertsShaderID, textureID, m_texturedVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
     }
     for (const auto& pair : m_textTriVertsBuffers)
     {
         const TextureID textureID = pair.first;
         const TempVertBuffer& buffer = pair.second;
-        m_renderCore.draw(m_textVertsShaderID, textureID, m_textVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+        m_renderCore.queueDraw(RenderPass::Forward, 3, m_textVertsShaderID, textureID, m_textVertsDrawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
     }
 
     for (const auto& pair : m_instancedColorMeshBuffers)
@@ -92,7 +93,7 @@ void Renderer3D::flush()
     {
         const DrawDataID drawDataID = pair.first;
         const TempVertBuffer& buffer = pair.second;
-        m_renderCore.draw(m_instancedColoredVertsShaderID, 0, drawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+        m_renderCore.queueDraw(RenderPass::Forward, 4, m_instancedColoredVertsShaderID, 0, drawDataID, viewProjection, DrawMode::Triangles, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
     }
     
     const Shader* shaderImpostor = m_renderCore.getShaderByID(m_impostorShaderID);
@@ -103,8 +104,9 @@ void Renderer3D::flush()
     {
         const TextureID textureID = pair.first;
         const TempVertBuffer& buffer = pair.second;
-        m_renderCore.draw(m_impostorShaderID, textureID, m_impostorVertsDrawDataID, viewProjection, DrawMode::Points, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
+        m_renderCore.queueDraw(RenderPass::Forward, 5, m_impostorShaderID, textureID, m_impostorVertsDrawDataID, viewProjection, DrawMode::Points, buffer.data, 0, buffer.count, BLEND_MODE_DEFAULT, DEPTH_MODE_DEFAULT);
     }
+    m_renderCore.submitCommands();
 
     m_renderCore.clearTempVertBuffer(m_coloredTriVertsBuffer);
     m_renderCore.clearTempVertBuffer(m_coloredLineVertsBuffer);
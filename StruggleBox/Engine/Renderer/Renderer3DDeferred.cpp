@@ -1,9 +1,9 @@
 #include "Renderer3DDeferred.h"
 
-#include "GLErrorUtil.h"
 #include "ArenaOperators.h"
 #include "DefaultShaders.h"
 #include "Options.h"
+#include "RenderBackend.h"
 #include "Shader.h"
 #include "Texture2D.h"
 
@@ -19,6 +19,7 @@ Renderer3DDeferred::Renderer3DDeferred(RenderCore& renderCore, Allocator& alloca
 	, m_gBuffer(renderCore)
     , m_frameBuffer(renderCore, "Main3DFrameBuffer")
     , m_lighting(renderCore)
+    , m_reflectionProbe(renderCore.getBackend())
     , m_renderSize()
     , m_pbrTexturedVertsDrawDataID(0)
     , m_textured2DVertsDrawDataID(0)
@@ -40,15 +41,12 @@ Renderer3DDeferred::~Renderer3DDeferred()
 
 void Renderer3DDeferred::initialize()
 {
-    CHECK_GL_ERROR();
-
     m_renderSize = m_renderCore.getRenderResolution();
 
 	m_gBuffer.Initialize(m_renderSize.x, m_renderSize.y);
     m_frameBuffer.initialize(m_renderSize.x, m_renderSize.y, m_gBuffer.GetDepth());
 
     m_lighting.initialize();
-    CHECK_GL_ERROR();
 
     m_pbrTexturedVertsDrawDataID = m_renderCore.createDrawData(TexturedPBRVertexConfig);
     m_textured2DVertsDrawDataID = m_renderCore.createDrawData(TexturedVertex3DConfig);
@@ -58,7 +56,6 @@ void Renderer3DDeferred::initialize()
     m_textured2DVertsShaderID = m_renderCore.getShaderIDFromSource(texturedVertexShaderSource, texturedFragmentShaderSource, "TexturedVertsShader");
     m_colored2DVertsShaderID = m_renderCore.getShaderIDFromSource(coloredVertexShaderSource, coloredFragmentShaderSource, "ColoredVertsShader");
     m_instancedPBRMeshShaderID = m_renderCore.getShaderIDFromSource(instancedPBRVertexShaderSoure, texturedPBRFragmentShaderSource, "InstancedPBRMeshShader");
-    CHECK_GL_ERROR();
 
     const Shader* shaderPBRTris = m_renderCore.getShaderByID(m_pbrTexturedVertsShaderID);
     shaderPBRTris->begin();
@@ -69,7 +66,6 @@ void Renderer3DDeferred::initialize()
     shaderPBRTris->setUniform1iv("displacementTexture", 4);
     shaderPBRTris->setUniform1iv("emissiveTexture", 5);
     shaderPBRTris->end();
-    CHECK_GL_ERROR();
 
     m_defaultCamera.setViewSize(m_renderCore.getRenderResolution());
 }
@@ -93,9 +89,16 @@ void Renderer3DDeferred::update(const double deltaTime)
 
 void Renderer3DDeferred::flush()
 {
+    ViewConstants viewConstants;
+    viewConstants.view = m_defaultCamera.getViewMatrix();
+    viewConstants.projection = m_defaultCamera.getProjectionMatrix();
+    viewConstants.position = m_defaultCamera.getPosition();
+    viewConstants.nearDepth = m_defaultCamera.getNearDepth();
+    viewConstants.farDepth = m_defaultCamera.getFarDepth();
+    m_renderCore.setViewConstants(viewConstants);
+
     m_gBuffer.Bind();
     m_gBuffer.Clear();
-    m_gBuffer.BindDraw();
 
     draw();
 
@@ -121,8 +124,9 @@ void Renderer3DDeferred::flush()
         m_reflectionProbe.getSize(),
         m_reflectionProbe.getCubeMap());
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // Bind screen buffer and clear it
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    RenderBackend& backend = m_renderCore.getBackend();
+    backend.bindFrameBuffer(0); // Bind screen buffer and clear it
+    backend.clear(COLOR_NONE, true, true);
 
     TempVertBuffer buffer;
     m_renderCore.setupTempVertBuffer<TexturedVertex3DData>(buffer, 4);
@@ -147,11 +151,10 @@ void Renderer3DDeferred::draw()
     shaderPBRTris->begin();
     shaderPBRTris->setUniform3fv("cameraPosition", m_defaultCamera.getPosition());
 
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glEnable(GL_STENCIL_TEST);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    glStencilFunc(GL_ALWAYS, Stencil_Solid, 0xFF);
+    RenderBackend& backend = m_renderCore.getBackend();
+    backend.setCullingEnabled(true);
+    backend.setStencilTestEnabled(true);
+    backend.setStencilFunc(DepthFunc::Always, Stencil_Solid);
     for (const auto& pair : m_pbrTexturedTriVertsBuffers.getData())
     {
         const TextureID textureID = pair.first;
@@ -261,9 +264,8 @@ const glm::vec3 Renderer3DDeferred::getCursor3DPos(const glm::vec2& cursorPos) c
     const int hw = m_renderSize.x / 2;
     const int hh = m_renderSize.y / 2;
 
-    GLfloat cursorDepth = 0;
     // Obtain the Z position (not world coordinates but in range 0 ~ 1)
-    glReadPixels(cursorPos.x, cursorPos.y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &cursorDepth);
+    const float cursorDepth = m_renderCore.getBackend().readDepth((int32_t)cursorPos.x, (int32_t)cursorPos.y);
     // Grab pixel under cursor color
 //    GLfloat col[4];
 //    glReadPixels(cursorPos.x, cursorPos.y, 1, 1, GL_RGBA, GL_FLOAT, &col);
@@ -287,30 +289,18 @@ const glm::vec3 Renderer3DDeferred::getCursor3DPos(const glm::vec2& cursorPos) c
 
 void Renderer3DDeferred::debugGBuffer()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    m_gBuffer.BindRead();
-
-    GLsizei HalfWidth = (GLsizei)(m_renderSize.x / 2.0f);
-    GLsizei HalfHeight = (GLsizei)(m_renderSize.y / 2.0f);
-
-    glReadBuffer(GL_COLOR_ATTACHMENT0);
-    glBlitFramebuffer(0, 0, m_renderSize.x, m_renderSize.y,
-        0, 0, HalfWidth, HalfHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
-
-    glReadBuffer(GL_COLOR_ATTACHMENT1);
-    glBlitFramebuffer(0, 0, m_renderSize.x, m_renderSize.y,
-        0, HalfHeight, HalfWidth, m_renderSize.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
-
-    glReadBuffer(GL_COLOR_ATTACHMENT2);
-    glBlitFramebuffer(0, 0, m_renderSize.x, m_renderSize.y,
-        HalfWidth, HalfHeight, m_renderSize.x, m_renderSize.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
-
-    glReadBuffer(GL_DEPTH_ATTACHMENT);
-    glBlitFramebuffer(0, 0, m_renderSize.x, m_renderSize.y,
-        HalfWidth, 0, m_renderSize.x, HalfHeight, GL_DEPTH_BUFFER_BIT, GL_LINEAR);
+    RenderBackend& backend = m_renderCore.getBackend();
+    backend.bindFrameBuffer(0);
+    backend.clear(COLOR_NONE, true, false);
+
+    const int32_t HalfWidth = m_renderSize.x / 2;
+    const int32_t HalfHeight = m_renderSize.y / 2;
+    const glm::ivec4 source = glm::ivec4(0, 0, m_renderSize.x, m_renderSize.y);
+
+    backend.blitToScreen(m_gBuffer.GetFBO(), 0, source, glm::ivec4(0, 0, HalfWidth, HalfHeight));
+    backend.blitToScreen(m_gBuffer.GetFBO(), 1, source, glm::ivec4(0, HalfHeight, HalfWidth, m_renderSize.y));
+    backend.blitToScreen(m_gBuffer.GetFBO(), 2, source, glm::ivec4(HalfWidth, HalfHeight, m_renderSize.x, m_renderSize.y));
+    backend.blitToScreen(m_gBuffer.GetFBO(), -1, source, glm::ivec4(HalfWidth, 0, m_renderSize.x, HalfHeight));
 }
 
 void Renderer3DDeferred::prepareFrameBuffer()
@@ -325,7 +315,8 @@ void Renderer3DDeferred::prepareFrameBuffer()
     //glStencilFunc(GL_EQUAL, Stencil_Sky, 0xFF);             // Only draw sky layer
     //m_renderCore.draw(m_textured2DVertsShaderID, m_gBuffer.getAlbedoTextureID(), m_textured2DVertsDrawDataID, s_projection2D, DrawMode::Triangles, nullptr, 0, 6, BLEND_MODE_DISABLED, DEPTH_MODE_DISABLED);
 
-    glStencilFunc(GL_EQUAL, Stencil_Solid, 0xFF);           // Only draw solid layer
+    RenderBackend& backend = m_renderCore.getBackend();
+    backend.setStencilFunc(DepthFunc::Equal, Stencil_Solid);           // Only draw solid layer
     TempVertBuffer buffer;
     m_renderCore.setupTempVertBuffer<ColoredVertex3DData>(buffer, 4);
     ColoredVertex3DData* dataPtr = (ColoredVertex3DData*)buffer.data;
@@ -335,5 +326,5 @@ void Renderer3DDeferred::prepareFrameBuffer()
     dataPtr[3] = { glm::vec3(-0.5, 0.5, 0.0), COLOR_BLACK };
     m_renderCore.draw(m_colored2DVertsShaderID, 0, m_colored2DVertsDrawDataID, s_projection2D, DrawMode::TriangleFan, dataPtr, 0, 6, BLEND_MODE_DISABLED, DEPTH_MODE_DISABLED);
 
-    glDisable(GL_STENCIL_TEST);
+    backend.setStencilTestEnabled(false);
 }
\ No newline at end of file
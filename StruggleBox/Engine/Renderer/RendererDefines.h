@@ -13,10 +13,18 @@ typedef uint32_t DrawDataID;
 
 typedef uint32_t VertBufferID;
 
+// Attributes default to floats, integer attributes are passed to shaders unconverted
+enum class VertexAttributeType : uint8_t
+{
+	Float,
+	UnsignedInt
+};
+
 struct VertexConfig
 {
 	uint8_t attributeCount;
-	uint32_t attributeSizes[8];
+	uint32_t attributeSizes[8];		// Size in 4-byte components
+	VertexAttributeType attributeTypes[8] = {};	// Configs that leave these out are all floats
 };
 
 const VertexConfig ColoredVertexConfig = { 2, { 3, 4, 0, 0, 0, 0, 0, 0 } };
@@ -112,6 +120,32 @@ enum class DepthFunc {
 	NotEqual,
 };
 
+enum class TextureFormat {
+	R8 = 0,
+	RGB8,
+	RGBA8,
+	RGBA32F,
+	Depth24Stencil8
+};
+
+enum class TextureFilter {
+	Nearest = 0,
+	Linear
+};
+
+enum class TextureWrap {
+	Repeat = 0,
+	ClampToEdge
+};
+
+struct TextureParams
+{
+	TextureFormat format;
+	TextureWrap wrap;
+	TextureFilter filter;		// For both minifying and magnifying
+	bool mipmaps;
+};
+
 enum class DrawMode {
 	Points,
 	Lines,
@@ -1,10 +1,14 @@
 #include "Shader.h"
 
 #include "Log.h"
+#include "RenderBackend.h"
+#include "UniformBlocks.h"
 #include "glm/gtc/type_ptr.hpp"
+#include <cstring>
 
-Shader::Shader()
-	: m_program(0)
+Shader::Shader(RenderBackend& backend)
+	: m_backend(backend)
+	, m_program(0)
 	, m_vertexShader(0)
 	, m_geometryShader(0)
 	, m_fragmentShader(0)
@@ -56,7 +60,9 @@ void Shader::initialize(const std::string& cshSrc)
 		Log::Error("[Shader] Program linking failed: %s\n", log);
 		free(log);
 		m_program = 0;
+		return;
 	}
+	resolveUniforms();
 }
 
 void Shader::initialize(const std::string& vshSource, const std::string& fshSource)
@@ -113,6 +119,57 @@ void Shader::linkProgram()
 		Log::Error("[Shader] Program linking failed: %s\n", log);
 		free(log);
 		m_program = 0;
+		return;
+	}
+	resolveUniforms();
+}
+
+// Looks up every active uniform once and binds the shared uniform blocks the program declares
+void Shader::resolveUniforms()
+{
+	m_uniforms.clear();
+
+	GLint numUniforms = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &numUniforms);
+	glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<GLchar> name(maxNameLength + 1);
+	std::string elementName;
+	for (GLint i = 0; i < numUniforms; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = 0;
+		glGetActiveUniform(m_program, (GLuint)i, (GLsizei)name.size(), &nameLength, &arraySize, &type, name.data());
+		// Block members have no location and are skipped
+		const GLint location = glGetUniformLocation(m_program, name.data());
+		if (location == -1)
+		{
+			continue;
+		}
+		m_uniforms.add(name.data(), location);
+
+		// Arrays are listed as name[0], make the plain name and every element findable too
+		if (nameLength > 3 && strcmp(name.data() + nameLength - 3, "[0]") == 0)
+		{
+			const std::string baseName(name.data(), nameLength - 3);
+			m_uniforms.add(baseName.c_str(), location);
+			for (GLint element = 1; element < arraySize; element++)
+			{
+				elementName = baseName + "[" + std::to_string(element) + "]";
+				m_uniforms.add(elementName.c_str(), glGetUniformLocation(m_program, elementName.c_str()));
+			}
+		}
+	}
+
+	for (uint32_t binding = 0; binding < (uint32_t)UniformBlockBinding::Count; binding++)
+	{
+		const char* blockName = UniformBlocks::getBlockName((UniformBlockBinding)binding);
+		const GLuint blockIndex = glGetUniformBlockIndex(m_program, blockName);
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(m_program, blockIndex, binding);
+		}
 	}
 }
 
@@ -151,12 +208,7 @@ GLuint Shader::attach(GLuint program, GLenum type, const GLchar** source)
 
 bool Shader::hasUniform(const char* name) const
 {
-	const GLint uniform = glGetUniformLocation(m_program, name);
-	if (uniform == -1 || uniform == GL_INVALID_VALUE || uniform == GL_INVALID_OPERATION)
-	{
-		return false;
-	}
-	return true;
+	return m_uniforms.find(name) != UniformLocationTable::NOT_FOUND;
 }
 
 GLint Shader::getAttribute(const char* name) const
@@ -166,145 +218,106 @@ GLint Shader::getAttribute(const char* name) const
 
 GLint Shader::getUniform(const char* name) const
 {
-	GLint uniform = glGetUniformLocation(m_program, name);
-	if (uniform == -1)
+	const GLint uniform = m_uniforms.find(name);
+	// Shaders the backend didn't compile have no uniforms to find
+	if (uniform == -1 && m_program != 0)
 	{
 		Log::Error("[Shader::getUniform] failed to get uniform %s", name);
 	}
 	return uniform;
 }
 
+GLint Shader::findUniform(const char* name) const
+{
+	return m_uniforms.find(name);
+}
+
 void Shader::setUniform2fv(const char* name, float x, float y) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        GLfloat vec[2] = {x, y};
-        glUniform2fv( uniform, 1, vec);
-		return;
-	}
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform2f(getUniform(name), glm::vec2(x, y));
 }
 
 void Shader::setUniform2fv(const char* name, const glm::vec2& v) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        glUniform2fv(uniform, 1, (GLfloat*)&v);
-		return;
-	}
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform2f(getUniform(name), v);
 }
 
 void Shader::setUniform3fv(const char* name, float x, float y, float z) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        GLfloat vec[3] = {x,y,z};
-        glUniform3fv(uniform, 1, vec);
-		return;
-	}
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform3f(getUniform(name), glm::vec3(x, y, z));
 }
 
 void Shader::setUniform3fv(const char* name, const glm::vec3& v) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        glUniform3fv(uniform, 1, (GLfloat*)&v);
-		return;
-	}
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform3f(getUniform(name), v);
 }
 
 void Shader::setUniform4fv(const char *name, float x,float y, float z, float w) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        GLfloat vec[4] = {x,y,z,w};
-        glUniform4fv(uniform, 1, vec);
-		return;
-	}
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform4f(getUniform(name), glm::vec4(x, y, z, w));
 }
 
 void Shader::setUniform4fv(const char* name, const glm::vec4& v) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        glUniform4fv(uniform, 1, (GLfloat*)&v);
-		return;
-    }
-    Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform4f(getUniform(name), v);
 }
 
 void Shader::setUniform4fv(const char* name, const Color& c) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        glUniform4fv(uniform, 1, &c.r);
-		return;
-    }
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform4f(getUniform(name), glm::vec4(c.r, c.g, c.b, c.a));
 }
 
 void Shader::setUniformM4fv(const char* name, const glm::mat4& m) const
 {
-    GLint uniform = getUniform(name);
-    if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        glUniformMatrix4fv( uniform, 1, GL_FALSE, glm::value_ptr(m));
-		return;
-    }
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniformM4(getUniform(name), m);
 }
 
 void Shader::setUniformM3fv(const char* name, const glm::mat3& m) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        glUniformMatrix3fv( uniform, 1, GL_FALSE, glm::value_ptr(m));
-		return;
-	}
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniformM3(getUniform(name), m);
 }
 
 void Shader::setUniform1fv(const char *name, float val) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-        glUniform1fv( uniform, 1, &val);
-		return;
-	}
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform1f(getUniform(name), val);
 }
 
 void Shader::setUniform1iv(const char *name, int val) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-		glUniform1iv( uniform, 1, &val);
-		return;
-	}
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform1i(getUniform(name), val);
 }
 
 void Shader::setUniform1bv(const char *name, bool val) const
 {
-    GLint uniform = getUniform(name);
-	if (uniform != GL_INVALID_VALUE && uniform != GL_INVALID_OPERATION)
-	{
-		glUniform1iv( uniform, 1, (GLint*)&val);
-		return;
-	}
-	Log::Error("[Shader] no such uniform: %s", name);
+	m_backend.setUniform1i(getUniform(name), val ? 1 : 0);
+}
+
+void Shader::setUniform3fv(const GLint location, const glm::vec3& v) const
+{
+	m_backend.setUniform3f(location, v);
+}
+
+void Shader::setUniform4fv(const GLint location, const glm::vec4& v) const
+{
+	m_backend.setUniform4f(location, v);
+}
+
+void Shader::setUniform4fv(const GLint location, const Color& c) const
+{
+	m_backend.setUniform4f(location, glm::vec4(c.r, c.g, c.b, c.a));
+}
+
+void Shader::setUniform1fv(const GLint location, float val) const
+{
+	m_backend.setUniform1f(location, val);
+}
+
+void Shader::begin() const
+{
+	m_backend.useProgram(m_program);
+}
+
+void Shader::end() const
+{
+	m_backend.useProgram(0);
 }
@@ -2,14 +2,18 @@
 
 #include "GFXDefines.h"
 #include "Color.h"
+#include "UniformLocationTable.h"
 #include <map>
 #include <vector>
 #include <string>
 
+class RenderBackend;
+
+// Compiled through GL when the backend compiles shaders, everything else it does goes through the backend
 class Shader
 {
 public:
-    Shader();
+    Shader(RenderBackend& backend);
     ~Shader();
 
     void initialize(const std::string& cshSrc);
@@ -17,18 +21,20 @@ public:
 	void initialize(const std::string& gshSource, const std::string& vshSource, const std::string& fshSource);
     void terminate();
 
-    void begin() const { glUseProgram(m_program); }
-    void end() const { glUseProgram(0); }
+    void begin() const;
+    void end() const;
 
     GLuint GetVertexShader() { return m_vertexShader; }
     GLuint getGeometryShader() { return m_geometryShader; }
     GLuint GetFragmentShader() { return m_fragmentShader; }
     GLuint GetComputeShader() { return m_computeShader; };
-    GLuint GetProgram() { return m_program; };
+    GLuint GetProgram() const { return m_program; };
     
     bool hasUniform(const char* name) const;
 	GLint getAttribute(const char* name) const;
 	GLint getUniform(const char* name) const;
+	// Same as getUniform without complaining when it's missing
+	GLint findUniform(const char* name) const;
 
     void setUniform2fv(const char *name, float x,float y) const;
     void setUniform2fv(const char *name, const glm::vec2 & v) const;
@@ -43,7 +49,14 @@ public:
     void setUniform1iv(const char *name, int val ) const;
     void setUniform1bv(const char *name, bool val ) const;
 
+    // Locations from getUniform, for uniforms set over and over
+    void setUniform3fv(const GLint location, const glm::vec3& v) const;
+    void setUniform4fv(const GLint location, const glm::vec4& v) const;
+    void setUniform4fv(const GLint location, const Color& c) const;
+    void setUniform1fv(const GLint location, float val) const;
+
 private:
+    RenderBackend& m_backend;
     GLuint m_program;
     GLuint m_vertexShader;
     GLuint m_geometryShader;
@@ -53,4 +66,7 @@ private:
     GLuint compile(GLenum type, const GLchar **source);
     GLuint attach(GLuint program, GLenum type, const GLchar **source);
 	void linkProgram();
+	void resolveUniforms();
+
+    UniformLocationTable m_uniforms;
 };
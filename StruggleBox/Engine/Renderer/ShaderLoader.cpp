@@ -6,7 +6,7 @@
 #include "Log.h"
 #include "Shader.h"
 
-Shader* ShaderLoader::load(const std::string& cshFile, Allocator& allocator)
+Shader* ShaderLoader::load(const std::string& cshFile, RenderBackend& backend, Allocator& allocator)
 {
 	const std::string cshPath = FileUtil::GetPath() + "Shaders/" + cshFile;
 	const std::string computeShader = loadFile(cshPath, allocator);
@@ -16,10 +16,10 @@ Shader* ShaderLoader::load(const std::string& cshFile, Allocator& allocator)
 		return nullptr;
 	}
 
-	return loadFromSource(computeShader, allocator);
+	return loadFromSource(computeShader, backend, allocator);
 }
 
-Shader* ShaderLoader::load(const std::string& vshFile, const std::string& fshFile, Allocator& allocator)
+Shader* ShaderLoader::load(const std::string& vshFile, const std::string& fshFile, RenderBackend& backend, Allocator& allocator)
 {
 	const std::string vshPath = FileUtil::GetPath() + "Shaders/" + vshFile;
 	const std::string fshPath = FileUtil::GetPath() + "Shaders/" + fshFile;
@@ -34,10 +34,10 @@ Shader* ShaderLoader::load(const std::string& vshFile, const std::string& fshFil
 		return nullptr;
 	}
 
-	return loadFromSource(vertShader, fragShader, allocator);
+	return loadFromSource(vertShader, fragShader, backend, allocator);
 }
 
-Shader* ShaderLoader::load(const std::string& gshFile, const std::string& vshFile, const std::string& fshFile, Allocator& allocator)
+Shader* ShaderLoader::load(const std::string& gshFile, const std::string& vshFile, const std::string& fshFile, RenderBackend& backend, Allocator& allocator)
 {
 	const std::string gshPath = FileUtil::GetPath() + "Shaders/" + gshFile;
 	const std::string vshPath = FileUtil::GetPath() + "Shaders/" + vshFile;
@@ -52,12 +52,12 @@ Shader* ShaderLoader::load(const std::string& gshFile, const std::string& vshFil
 		return nullptr;
 	}
 
-	return loadFromSource(geomShader, vertShader, fragShader, allocator);
+	return loadFromSource(geomShader, vertShader, fragShader, backend, allocator);
 }
 
-Shader* ShaderLoader::loadFromSource(const std::string& computeShaderSource, Allocator& allocator)
+Shader* ShaderLoader::loadFromSource(const std::string& computeShaderSource, RenderBackend& backend, Allocator& allocator)
 {
-	Shader* shader = CUSTOM_NEW(Shader, allocator)();
+	Shader* shader = CUSTOM_NEW(Shader, allocator)(backend);
 	shader->initialize(computeShaderSource);
 
 	if (shader->GetProgram() == 0)
@@ -69,9 +69,9 @@ Shader* ShaderLoader::loadFromSource(const std::string& computeShaderSource, All
 	return shader;
 }
 
-Shader* ShaderLoader::loadFromSource(const std::string& vshSource, const std::string& fshSource, Allocator& allocator)
+Shader* ShaderLoader::loadFromSource(const std::string& vshSource, const std::string& fshSource, RenderBackend& backend, Allocator& allocator)
 {
-	Shader* shader = CUSTOM_NEW(Shader, allocator)();
+	Shader* shader = CUSTOM_NEW(Shader, allocator)(backend);
 	shader->initialize(vshSource, fshSource);
 
 	if (shader->GetProgram() == 0)
@@ -84,9 +84,9 @@ Shader* ShaderLoader::loadFromSource(const std::string& vshSource, const std::st
 	return shader;
 }
 
-Shader* ShaderLoader::loadFromSource(const std::string& gshSource, const std::string& vshSource, const std::string& fshSource, Allocator& allocator)
+Shader* ShaderLoader::loadFromSource(const std::string& gshSource, const std::string& vshSource, const std::string& fshSource, RenderBackend& backend, Allocator& allocator)
 {
-	Shader* shader = CUSTOM_NEW(Shader, allocator)();
+	Shader* shader = CUSTOM_NEW(Shader, allocator)(backend);
 	shader->initialize(gshSource, vshSource, fshSource);
 
 	if (shader->GetProgram() == 0)
@@ -0,0 +1,93 @@
+#include "StreamRing.h"
+
+StreamRing::StreamRing(const size_t capacity)
+    : m_capacity(capacity)
+{
+    reset();
+}
+
+size_t StreamRing::allocate(const size_t size, const size_t alignment)
+{
+    if (size == 0 || size > m_capacity)
+    {
+        return NO_SPACE;
+    }
+    if (m_used == 0 && m_numFrames == 0)
+    {
+        // Nothing left to wait for, start over at the front
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    const size_t align = alignment ? alignment : 1;
+    size_t start = (m_head + align - 1) / align * align;
+    if (m_head >= m_tail)
+    {
+        // Free space is after the head and before the tail, unless head caught up with tail
+        if (m_used != 0 && m_head == m_tail)
+        {
+            return NO_SPACE;
+        }
+        if (start + size > m_capacity)
+        {
+            // Skip what's left at the end and wrap, the front has to be free up to the tail
+            if (size > m_tail)
+            {
+                return NO_SPACE;
+            }
+            start = 0;
+        }
+    }
+    else if (start + size > m_tail)
+    {
+        return NO_SPACE;
+    }
+
+    const size_t end = start + size;
+    const size_t consumed = start >= m_head ? end - m_head : (m_capacity - m_head) + end;
+    m_used += consumed;
+    m_frameUsed += consumed;
+    m_head = end == m_capacity ? 0 : end;
+    return start;
+}
+
+bool StreamRing::endFrame()
+{
+    if (m_numFrames == MAX_FRAMES_IN_FLIGHT)
+    {
+        return false;
+    }
+    const uint32_t frame = (m_oldestFrame + m_numFrames) % MAX_FRAMES_IN_FLIGHT;
+    m_frameEnds[frame] = m_head;
+    m_frameSizes[frame] = m_frameUsed;
+    m_numFrames++;
+    m_frameUsed = 0;
+    return true;
+}
+
+void StreamRing::retireFrame()
+{
+    if (m_numFrames == 0)
+    {
+        return;
+    }
+    m_tail = m_frameEnds[m_oldestFrame];
+    m_used -= m_frameSizes[m_oldestFrame];
+    m_oldestFrame = (m_oldestFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    m_numFrames--;
+}
+
+void StreamRing::reset()
+{
+    m_head = 0;
+    m_tail = 0;
+    m_used = 0;
+    m_frameUsed = 0;
+    m_oldestFrame = 0;
+    m_numFrames = 0;
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        m_frameEnds[i] = 0;
+        m_frameSizes[i] = 0;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Hands out ranges of a fixed size buffer for data that only lives until the GPU
+// has drawn it. Allocations go forward and wrap to the start, the space a frame
+// used only comes back once that frame is retired, after its fence signalled.
+// Only does the bookkeeping, the buffer itself and the fences belong to the backend.
+class StreamRing
+{
+public:
+    static const uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+    static const size_t NO_SPACE = SIZE_MAX;
+
+    StreamRing(const size_t capacity);
+
+    // Offset of the range or NO_SPACE while the space is still in flight
+    size_t allocate(const size_t size, const size_t alignment);
+
+    // Closes the current frame, returns false when MAX_FRAMES_IN_FLIGHT are already waiting to be retired
+    bool endFrame();
+    // Frees the space of the oldest closed frame
+    void retireFrame();
+    // Frees everything at once, for when the storage behind the ring was replaced
+    void reset();
+
+    uint32_t getFramesInFlight() const { return m_numFrames; }
+    size_t getCapacity() const { return m_capacity; }
+    size_t getUsed() const { return m_used; }
+
+private:
+    size_t m_capacity;
+    size_t m_head;                              // Where the next allocation starts
+    size_t m_tail;                              // Start of the oldest data still in use
+    size_t m_used;                              // Bytes between tail and head, padding skipped on wrapping included
+    size_t m_frameUsed;                         // Bytes the current frame used so far
+
+    size_t m_frameEnds[MAX_FRAMES_IN_FLIGHT];
+    size_t m_frameSizes[MAX_FRAMES_IN_FLIGHT];
+    uint32_t m_oldestFrame;
+    uint32_t m_numFrames;
+};
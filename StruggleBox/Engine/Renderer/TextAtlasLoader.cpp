@@ -3,20 +3,20 @@
 #include "Allocator.h"
 #include "ArenaOperators.h"
 #include "Log.h"
-#include "GLUtils.h"
-#include "CoreIncludes.h"
+#include "RenderBackend.h"
 #include "TextAtlas.h"
 #include "TextureCache.h"
 #include "Texture2D.h"
 
 #include "MathUtils.h"
-#include "GLErrorUtil.h"
+#include <algorithm>
+#include <vector>
 
 bool TextAtlasLoader::s_initialized = false;
 FT_Library TextAtlasLoader::s_freeType;
 const uint32_t TextAtlasLoader::MAX_TEXT_ATLAS_WIDTH = 2048;
 
-TextAtlas* TextAtlasLoader::load(const std::string& filename, const uint8_t fontHeight, Allocator& allocator, TextureCache& textureCache)
+TextAtlas* TextAtlasLoader::load(const std::string& filename, const uint8_t fontHeight, RenderBackend& backend, Allocator& allocator, TextureCache& textureCache)
 {
     if (!s_initialized)
     {
@@ -45,17 +45,12 @@ TextAtlas* TextAtlasLoader::load(const std::string& filename, const uint8_t font
     //height = MathUtils::round_up_to_power_of_2(height);
 
     //Log::Info("Generated text atlas sized: %i x %i", width, height);
-    CHECK_GL_ERROR();
 
     /* Create a texture that will be used to hold all ASCII glyphs */
     // Our text shaders can read the red channel for the alpha value
-    std::vector<GLubyte> emptyData(width * height, 0);
-    const uint32_t textureIDGL = GLUtils::createTexture(width, height, 0, GL_RED, GL_UNSIGNED_BYTE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST, false, &emptyData[0]);
-    CHECK_GL_ERROR();
-
-    /* We require 1 byte alignment when uploading texture data */
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    CHECK_GL_ERROR();
+    const TextureParams params = { TextureFormat::R8, TextureWrap::ClampToEdge, TextureFilter::Nearest, false };
+    std::vector<uint8_t> emptyData(width * height, 0);
+    const uint32_t textureIDGL = backend.createTexture(params, width, height, &emptyData[0]);
 
     char buf[256];
 #ifdef _WIN32
@@ -65,15 +60,12 @@ TextAtlas* TextAtlasLoader::load(const std::string& filename, const uint8_t font
 #endif
     const std::string fontNameAndSize = std::string(buf);
 
-    Texture2D* texture = CUSTOM_NEW(Texture2D, allocator)(textureIDGL, width, height, GL_RED, GL_UNSIGNED_BYTE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST);
+    Texture2D* texture = CUSTOM_NEW(Texture2D, allocator)(textureIDGL, width, height, params);
     TextureID textureID = textureCache.addTexture(texture, fontNameAndSize);
     //Log::Info("[TextAtlasLoader::load] Loaded atlas with texture ID: %i", textureID);
     TextAtlas* atlas = CUSTOM_NEW(TextAtlas, allocator)(textureID, width, height);
 
-    glBindTexture(GL_TEXTURE_2D, textureIDGL);
-    CHECK_GL_ERROR();
-    readGlyphs(face, fontHeight, width, height, atlas->m_glyphs);
-    CHECK_GL_ERROR();
+    readGlyphs(face, fontHeight, width, height, backend, textureIDGL, atlas->m_glyphs);
 
     // Clean up face
     FT_Done_Face(face);
@@ -136,7 +128,7 @@ void TextAtlasLoader::calculateAtlasSize(FT_Face& face, const uint8_t fontHeight
     height += rowh;
 }
 
-void TextAtlasLoader::readGlyphs(FT_Face& face, const uint8_t fontHeight, const uint32_t width, uint32_t height, Glyph* glyphs)
+void TextAtlasLoader::readGlyphs(FT_Face& face, const uint8_t fontHeight, const uint32_t width, uint32_t height, RenderBackend& backend, const uint32_t texture, Glyph* glyphs)
 {
     FT_Set_Pixel_Sizes(face, 0, fontHeight);
     FT_GlyphSlot g = face->glyph;
@@ -163,7 +155,7 @@ void TextAtlasLoader::readGlyphs(FT_Face& face, const uint8_t fontHeight, const
         uint32_t w = g->bitmap.width;
         uint32_t r = g->bitmap.rows;
 
-        glTexSubImage2D(GL_TEXTURE_2D, 0, ox, oy, w, r, GL_RED, GL_UNSIGNED_BYTE, g->bitmap.buffer);
+        backend.updateTexture(texture, TextureFormat::R8, ox, oy, w, r, g->bitmap.buffer);
 
         glyphs[i].ax = g->advance.x >> 6;
         glyphs[i].ay = g->advance.y >> 6;
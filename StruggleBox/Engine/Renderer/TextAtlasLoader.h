@@ -6,6 +6,7 @@
 #include <string>
 
 class Allocator;
+class RenderBackend;
 class TextAtlas;
 class TextureCache;
 struct Glyph;
@@ -13,7 +14,7 @@ struct Glyph;
 class TextAtlasLoader
 {
 public:
-    static TextAtlas* load(const std::string& filename, const uint8_t fontHeight, Allocator& allocator, TextureCache& textureCache);
+    static TextAtlas* load(const std::string& filename, const uint8_t fontHeight, RenderBackend& backend, Allocator& allocator, TextureCache& textureCache);
 
     static void terminate();
 private:
@@ -24,5 +25,5 @@ private:
 
     static void initialize();
     static void calculateAtlasSize(FT_Face& face, const uint8_t fontHeight, uint32_t& width, uint32_t& height);
-    static void readGlyphs(FT_Face& face, const uint8_t fontHeight, const uint32_t width, const uint32_t height, Glyph* glyphs);
+    static void readGlyphs(FT_Face& face, const uint8_t fontHeight, const uint32_t width, const uint32_t height, RenderBackend& backend, const uint32_t texture, Glyph* glyphs);
 };
@@ -3,16 +3,18 @@
 #include "Allocator.h"
 #include "ArenaOperators.h"
 #include "Texture2D.h"
-#include "ThreadPool.h"
+#include "JobSystem.h"
 #include "Log.h"
-#include "GFXDefines.h"
-#include "GLUtils.h"
+#include "RenderBackend.h"
 #include <png.h>
-
-TextureLoader::TextureLoader(Allocator& allocator, ThreadPool& threadPool)
-    : m_allocator(allocator)
-    , m_threadPool(threadPool)
-    , m_isLoading(false)
+#include <thread>
+
+TextureLoader::TextureLoader(RenderBackend& backend, Allocator& allocator, JobSystem& jobSystem)
+    : m_backend(backend)
+    , m_allocator(allocator)
+    , m_jobSystem(jobSystem)
+    , m_numLoading(0)
+    , m_finishedPackages(TEXTURE_LOAD_QUEUE_SIZE)
 {
 }
 
@@ -139,9 +141,8 @@ png_byte* loadPNGImageData(const std::string& fileName, Allocator& allocator, pn
 
 Texture2D* TextureLoader::loadFromFile(
     const std::string& fileName,
-    GLint wrap /*= GL_REPEAT*/,
-    GLint minF /*= GL_NEAREST*/,
-    GLint magF /*= GL_NEAREST*/)
+    TextureWrap wrap /*= TextureWrap::Repeat*/,
+    TextureFilter filter /*= TextureFilter::Nearest*/)
 {
     int color_type;
     png_uint_32 temp_width, temp_height;
@@ -152,12 +153,12 @@ Texture2D* TextureLoader::loadFromFile(
         Log::Error("[TextureLoader] could not load %s", fileName.c_str());
         return nullptr;
     }
-    uint32_t formatGL = pngColorFormatToGL(color_type);
-    GLuint textureIDGL = GLUtils::createTexture(temp_width, temp_height, 0, formatGL, GL_UNSIGNED_BYTE, wrap, minF, magF, false, image_data);
+    const TextureParams params = { pngColorFormatToTextureFormat(color_type), wrap, filter, false };
+    const uint32_t textureID = m_backend.createTexture(params, temp_width, temp_height, image_data);
 
     m_allocator.deallocate(image_data);
 
-    Texture2D* texture = CUSTOM_NEW(Texture2D, m_allocator)(textureIDGL, temp_width, temp_height, formatGL, GL_UNSIGNED_BYTE, wrap, minF, magF);
+    Texture2D* texture = CUSTOM_NEW(Texture2D, m_allocator)(textureID, temp_width, temp_height, params);
 
 	return texture;
 }
@@ -294,7 +295,7 @@ Texture2D* TextureLoader::loadFromPNGData(const char* data)
     int width = temp_width;
     int height = temp_height;
     int bpp = bit_depth;
-    uint32_t formatGL = pngColorFormatToGL(color_type);
+    const TextureParams params = { pngColorFormatToTextureFormat(color_type), TextureWrap::Repeat, TextureFilter::Nearest, false };
 
     // Update the png info struct.
     png_read_update_info(png_ptr, info_ptr);
@@ -333,7 +334,7 @@ Texture2D* TextureLoader::loadFromPNGData(const char* data)
     png_read_image(png_ptr, row_pointers);
 
     // Generate the OpenGL Texture2D object
-    GLuint textureIDGL = GLUtils::createTexture(temp_width, temp_height, 0, formatGL, GL_UNSIGNED_BYTE, GL_REPEAT, GL_NEAREST, GL_NEAREST, false, image_data);
+    const uint32_t textureID = m_backend.createTexture(params, temp_width, temp_height, image_data);
 
     // clean up
     png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
@@ -343,93 +344,94 @@ Texture2D* TextureLoader::loadFromPNGData(const char* data)
     return nullptr;
 }
 
-void TextureLoader::asyncLoadFromFile(const std::string& fileName, const std::function<void(Texture2D*)>& callback, GLint wrap, GLint minF, GLint magF)
+void TextureLoader::asyncLoadFromFile(const std::string& fileName, const std::function<void(Texture2D*)>& callback, TextureWrap wrap, TextureFilter filter)
 {
+    // Keep the finished queue from filling up, a full queue would stall the loading threads
+    while (m_numLoading >= m_finishedPackages.capacity())
+    {
+        processQueue();
+        if (!m_jobSystem.runPendingJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+
     TextureLoadPackage* package = CUSTOM_NEW(TextureLoadPackage, m_allocator){ 
         fileName,
         callback,
-        wrap, minF, magF,
-        0, 0, 0,
-        nullptr,
-        false
+        { TextureFormat::RGBA8, wrap, filter, false },
+        0, 0,
+        nullptr
     };
-
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_packages.push_back(package);
-    m_isLoading = true;
+    m_numLoading++;
     //Log::Debug("TextureLoader::asyncLoadFromFile adding package at %p (%s)", package, package->fileName.c_str());
 
-    m_threadPool.addJob(0, &TextureLoader::LoadPackageInThread, package, &m_allocator, &m_mutex);
+    Allocator* allocator = &m_allocator;
+    MPMCQueue<TextureLoadPackage*>* finishedPackages = &m_finishedPackages;
+    m_jobSystem.addJob(JobPriority::Normal, nullptr, [package, allocator, finishedPackages]() {
+        LoadPackageInThread(package, allocator, finishedPackages);
+    });
 }
 
 void TextureLoader::processQueue()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    for (TextureLoadPackage* packageP : m_packages)
+    TextureLoadPackage* packageP = nullptr;
+    while (m_finishedPackages.tryPop(packageP))
     {
+        m_numLoading--;
         TextureLoadPackage& package = *packageP;
-        if (!package.finished)
-        {
-            continue;
-        }
         if (!package.image_data)
         {
             Log::Error("TextureLoader::processQueue failed to load package at %p (%s)", packageP, package.fileName.c_str());
+            package.callback(nullptr);
+            CUSTOM_DELETE(packageP, m_allocator);
             continue;
         }
 
         //Log::Debug("TextureLoader::processQueue loaded package at %p (%s)", packageP, package.fileName.c_str());
 
-        GLuint textureIDGL = GLUtils::createTexture(package.width, package.height, 0, package.formatGL, GL_UNSIGNED_BYTE, package.wrap, package.minF, package.magF, false, package.image_data);
-        Texture2D* texture = CUSTOM_NEW(Texture2D, m_allocator)(textureIDGL, package.width, package.height, package.formatGL, GL_UNSIGNED_BYTE, package.wrap, package.minF, package.magF);
+        const uint32_t textureID = m_backend.createTexture(package.params, package.width, package.height, package.image_data);
+        Texture2D* texture = CUSTOM_NEW(Texture2D, m_allocator)(textureID, package.width, package.height, package.params);
 
         package.callback(texture);
 
         m_allocator.deallocate(package.image_data);
-        m_allocator.deallocate(packageP);
+        CUSTOM_DELETE(packageP, m_allocator);
     }
-
-    m_packages.erase(
-        std::remove_if(
-            m_packages.begin(),
-            m_packages.end(),
-            [](TextureLoadPackage* package) { return package->finished; }),
-        m_packages.end());
-    m_isLoading = !m_packages.empty();
 }
 
-void TextureLoader::LoadPackageInThread(TextureLoadPackage* package, Allocator* allocator, std::mutex* mutex)
+void TextureLoader::LoadPackageInThread(TextureLoadPackage* package, Allocator* allocator, MPMCQueue<TextureLoadPackage*>* finishedPackages)
 {
 
     //Log::Debug("TextureLoader::LoadPackageInThread starting package at %p (%s)", package, package->fileName.c_str());
 
     int color_type;
     package->image_data = loadPNGImageData(package->fileName, *allocator, package->width, package->height, color_type);
-    package->formatGL = pngColorFormatToGL(color_type);
+    package->params.format = pngColorFormatToTextureFormat(color_type);
 
-    std::lock_guard<std::mutex> lock(*mutex);
-    package->finished = true;
+    // Never waits, there are no more packages in flight than the queue holds
+    finishedPackages->push(package);
 
     //Log::Debug("TextureLoader::LoadPackageInThread finished package at %p (%s)", package, package->fileName.c_str());
 }
 
-uint32_t TextureLoader::pngColorFormatToGL(const int pngColorFormat)
+TextureFormat TextureLoader::pngColorFormatToTextureFormat(const int pngColorFormat)
 {
     if (pngColorFormat == PNG_COLOR_TYPE_RGB)
     {
-        return GL_RGB;
+        return TextureFormat::RGB8;
     }
     else if (pngColorFormat == PNG_COLOR_TYPE_RGB_ALPHA)
     {
-        return GL_RGBA;
+        return TextureFormat::RGBA8;
     }
     else if (pngColorFormat == PNG_COLOR_TYPE_GRAY_ALPHA)
     {
-        return GL_RED;
+        return TextureFormat::R8;
     }
     else
     {
         Log::Error("[TextureLoader] Unknown Color format %i!", pngColorFormat);
     }
-    return GL_RGBA;
+    return TextureFormat::RGBA8;
 }
@@ -1,58 +1,53 @@
 #pragma once
 
-#include "CoreIncludes.h"
-#include "ThreadSafeQueue.h"
+#include "MPMCQueue.h"
+#include "RendererDefines.h"
 #include <functional>
 #include <string>
-#include <mutex>
-#include <vector>
 
 class Allocator;
-class ThreadPool;
+class JobSystem;
+class RenderBackend;
 class Texture2D;
 
+const size_t TEXTURE_LOAD_QUEUE_SIZE = 256;   // Most loads in flight, finished ones wait here for processQueue
+
 class TextureLoader
 {
 public:
-	TextureLoader(Allocator& allocator, ThreadPool& threadPool);
+	TextureLoader(RenderBackend& backend, Allocator& allocator, JobSystem& jobSystem);
 
-	Texture2D* loadFromFile(const std::string& fileName, GLint wrap = GL_REPEAT, GLint minF = GL_NEAREST, GLint magF = GL_NEAREST);
+	Texture2D* loadFromFile(const std::string& fileName, TextureWrap wrap = TextureWrap::Repeat, TextureFilter filter = TextureFilter::Nearest);
 	Texture2D* loadFromPNGData(const char* data);
 
 	void asyncLoadFromFile(
 		const std::string& fileName,
 		const std::function<void(Texture2D*)>& callback,
-		GLint wrap = GL_REPEAT,
-		GLint minF = GL_NEAREST,
-		GLint magF = GL_NEAREST);
+		TextureWrap wrap = TextureWrap::Repeat,
+		TextureFilter filter = TextureFilter::Nearest);
 
 	void processQueue();
 
-	bool isLoading() const { return m_isLoading; }
+	bool isLoading() const { return m_numLoading != 0; }
 
 private:
 	struct TextureLoadPackage {
 		std::string fileName;
 		std::function<void(Texture2D*)> callback;
-		GLint wrap;
-		GLint minF;
-		GLint magF;
+		TextureParams params;
 		uint32_t width;
 		uint32_t height;
-		uint32_t formatGL;
 		unsigned char* image_data;
-		bool finished;
 	};
 
+	RenderBackend& m_backend;
 	Allocator& m_allocator;
-	ThreadPool& m_threadPool;
-
-	bool m_isLoading;
+	JobSystem& m_jobSystem;
 
-	std::vector<TextureLoadPackage*> m_packages;
-	std::mutex m_mutex;
+	size_t m_numLoading;    // Only touched on the thread calling processQueue
+	MPMCQueue<TextureLoadPackage*> m_finishedPackages;
 
-	static void LoadPackageInThread(TextureLoadPackage* package, Allocator* allocator, std::mutex* mutex);
-	static uint32_t pngColorFormatToGL(const int pngColorFormat);
+	static void LoadPackageInThread(TextureLoadPackage* package, Allocator* allocator, MPMCQueue<TextureLoadPackage*>* finishedPackages);
+	static TextureFormat pngColorFormatToTextureFormat(const int pngColorFormat);
 };
 
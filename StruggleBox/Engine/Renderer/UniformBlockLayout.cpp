@@ -0,0 +1,116 @@
+#include "UniformBlockLayout.h"
+
+#include <cstring>
+
+const uint32_t VEC4_ALIGNMENT = 16;
+
+static uint32_t alignOffset(const uint32_t offset, const uint32_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+UniformBlockLayout::UniformBlockLayout()
+    : m_size(0)
+{
+}
+
+uint32_t UniformBlockLayout::add(const UniformType type, const uint32_t arrayLength)
+{
+    if (arrayLength == 0)
+    {
+        const uint32_t offset = alignOffset(m_size, getAlignment(type));
+        m_size = offset + getTypeSize(type);
+        return offset;
+    }
+    // Array elements are rounded up to a vec4 each, and so is whatever comes after the array
+    const uint32_t stride = alignOffset(getTypeSize(type), VEC4_ALIGNMENT);
+    const uint32_t offset = alignOffset(m_size, VEC4_ALIGNMENT);
+    m_size = offset + stride * arrayLength;
+    return offset;
+}
+
+uint32_t UniformBlockLayout::getSize() const
+{
+    return alignOffset(m_size, VEC4_ALIGNMENT);
+}
+
+uint32_t UniformBlockLayout::getAlignment(const UniformType type)
+{
+    switch (type)
+    {
+    case UniformType::Float:
+    case UniformType::Int:
+    case UniformType::Bool:
+        return 4;
+    case UniformType::Vec2:
+        return 8;
+    default:
+        return VEC4_ALIGNMENT;
+    }
+}
+
+uint32_t UniformBlockLayout::getTypeSize(const UniformType type)
+{
+    switch (type)
+    {
+    case UniformType::Float:
+    case UniformType::Int:
+    case UniformType::Bool:
+        return 4;
+    case UniformType::Vec2:
+        return 8;
+    case UniformType::Vec3:
+        return 12;
+    case UniformType::Vec4:
+        return 16;
+    case UniformType::Mat3:
+        return 3 * 16;  // Three columns, each padded to a vec4
+    case UniformType::Mat4:
+        return 4 * 16;
+    }
+    return 0;
+}
+
+void UniformBlockLayout::write(uint8_t* block, const uint32_t offset, const float value)
+{
+    memcpy(block + offset, &value, sizeof(float));
+}
+
+void UniformBlockLayout::write(uint8_t* block, const uint32_t offset, const int32_t value)
+{
+    memcpy(block + offset, &value, sizeof(int32_t));
+}
+
+void UniformBlockLayout::write(uint8_t* block, const uint32_t offset, const bool value)
+{
+    const uint32_t word = value ? 1 : 0;
+    memcpy(block + offset, &word, sizeof(uint32_t));
+}
+
+void UniformBlockLayout::write(uint8_t* block, const uint32_t offset, const glm::vec2& value)
+{
+    memcpy(block + offset, &value[0], sizeof(float) * 2);
+}
+
+void UniformBlockLayout::write(uint8_t* block, const uint32_t offset, const glm::vec3& value)
+{
+    memcpy(block + offset, &value[0], sizeof(float) * 3);
+}
+
+void UniformBlockLayout::write(uint8_t* block, const uint32_t offset, const glm::vec4& value)
+{
+    memcpy(block + offset, &value[0], sizeof(float) * 4);
+}
+
+void UniformBlockLayout::write(uint8_t* block, const uint32_t offset, const glm::mat3& value)
+{
+    for (uint32_t column = 0; column < 3; column++)
+    {
+        memcpy(block + offset + column * 16, &value[column][0], sizeof(float) * 3);
+    }
+}
+
+void UniformBlockLayout::write(uint8_t* block, const uint32_t offset, const glm::mat4& value)
+{
+    memcpy(block + offset, &value[0][0], sizeof(float) * 16);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <cstdint>
+
+enum class UniformType : uint8_t
+{
+    Float,
+    Int,
+    Bool,
+    Vec2,
+    Vec3,
+    Vec4,
+    Mat3,
+    Mat4
+};
+
+// Works out member offsets of a std140 uniform block, members have to be added
+// in the order the block declares them. Writing goes through the static helpers,
+// which pad mat3 columns and bools the way std140 stores them.
+class UniformBlockLayout
+{
+public:
+    UniformBlockLayout();
+
+    // Offset of the new member in bytes, arrayLength 0 for a member that isn't an array
+    uint32_t add(const UniformType type, const uint32_t arrayLength = 0);
+    // Size of the whole block, padded to a multiple of 16 bytes
+    uint32_t getSize() const;
+
+    static uint32_t getAlignment(const UniformType type);
+    static uint32_t getTypeSize(const UniformType type);
+
+    static void write(uint8_t* block, const uint32_t offset, const float value);
+    static void write(uint8_t* block, const uint32_t offset, const int32_t value);
+    static void write(uint8_t* block, const uint32_t offset, const bool value);
+    static void write(uint8_t* block, const uint32_t offset, const glm::vec2& value);
+    static void write(uint8_t* block, const uint32_t offset, const glm::vec3& value);
+    static void write(uint8_t* block, const uint32_t offset, const glm::vec4& value);
+    static void write(uint8_t* block, const uint32_t offset, const glm::mat3& value);
+    static void write(uint8_t* block, const uint32_t offset, const glm::mat4& value);
+
+private:
+    uint32_t m_size;
+};
@@ -0,0 +1,135 @@
+#include "UniformBlocks.h"
+
+#include "UniformBlockLayout.h"
+
+namespace UniformBlocks
+{
+    struct ViewConstantsLayout
+    {
+        uint32_t view;
+        uint32_t projection;
+        uint32_t viewProjection;
+        uint32_t position;
+        uint32_t nearDepth;
+        uint32_t depthParameter;
+        uint32_t farDepth;
+        uint32_t size;
+
+        ViewConstantsLayout()
+        {
+            UniformBlockLayout layout;
+            view = layout.add(UniformType::Mat4);
+            projection = layout.add(UniformType::Mat4);
+            viewProjection = layout.add(UniformType::Mat4);
+            position = layout.add(UniformType::Vec3);
+            nearDepth = layout.add(UniformType::Float);
+            depthParameter = layout.add(UniformType::Vec2);
+            farDepth = layout.add(UniformType::Float);
+            size = layout.getSize();
+        }
+    };
+
+    struct FrameConstantsLayout
+    {
+        uint32_t time;
+        uint32_t renderResolution;
+        uint32_t renderFog;
+        uint32_t fogDensity;
+        uint32_t fogHeightFalloff;
+        uint32_t fogExtinctionFalloff;
+        uint32_t fogInscatteringFalloff;
+        uint32_t fogColor;
+        uint32_t size;
+
+        FrameConstantsLayout()
+        {
+            UniformBlockLayout layout;
+            time = layout.add(UniformType::Float);
+            renderResolution = layout.add(UniformType::Vec2);
+            renderFog = layout.add(UniformType::Bool);
+            fogDensity = layout.add(UniformType::Float);
+            fogHeightFalloff = layout.add(UniformType::Float);
+            fogExtinctionFalloff = layout.add(UniformType::Float);
+            fogInscatteringFalloff = layout.add(UniformType::Float);
+            fogColor = layout.add(UniformType::Vec3);
+            size = layout.getSize();
+        }
+    };
+
+    static const ViewConstantsLayout s_viewLayout;
+    static const FrameConstantsLayout s_frameLayout;
+
+    const char* getBlockName(const UniformBlockBinding binding)
+    {
+        switch (binding)
+        {
+        case UniformBlockBinding::View:
+            return "ViewConstants";
+        case UniformBlockBinding::Frame:
+            return "FrameConstants";
+        default:
+            return "";
+        }
+    }
+
+    uint32_t getBlockSize(const UniformBlockBinding binding)
+    {
+        switch (binding)
+        {
+        case UniformBlockBinding::View:
+            return s_viewLayout.size;
+        case UniformBlockBinding::Frame:
+            return s_frameLayout.size;
+        default:
+            return 0;
+        }
+    }
+
+    void pack(const ViewConstants& constants, uint8_t* data)
+    {
+        // Parameters for linearizing depth values
+        const float nearDepth = constants.nearDepth;
+        const float farDepth = constants.farDepth;
+        const glm::vec2 depthParameter = glm::vec2(farDepth / (farDepth - nearDepth), farDepth * nearDepth / (nearDepth - farDepth));
+
+        UniformBlockLayout::write(data, s_viewLayout.view, constants.view);
+        UniformBlockLayout::write(data, s_viewLayout.projection, constants.projection);
+        UniformBlockLayout::write(data, s_viewLayout.viewProjection, constants.projection * constants.view);
+        UniformBlockLayout::write(data, s_viewLayout.position, constants.position);
+        UniformBlockLayout::write(data, s_viewLayout.nearDepth, nearDepth);
+        UniformBlockLayout::write(data, s_viewLayout.depthParameter, depthParameter);
+        UniformBlockLayout::write(data, s_viewLayout.farDepth, farDepth);
+    }
+
+    void packViewProjection(const glm::mat4& viewProjection, uint8_t* data)
+    {
+        UniformBlockLayout::write(data, s_viewLayout.viewProjection, viewProjection);
+    }
+
+    void pack(const FrameConstants& constants, uint8_t* data)
+    {
+        UniformBlockLayout::write(data, s_frameLayout.time, constants.time);
+        UniformBlockLayout::write(data, s_frameLayout.renderResolution, constants.renderResolution);
+        UniformBlockLayout::write(data, s_frameLayout.renderFog, constants.renderFog);
+        UniformBlockLayout::write(data, s_frameLayout.fogDensity, constants.fogDensity);
+        UniformBlockLayout::write(data, s_frameLayout.fogHeightFalloff, constants.fogHeightFalloff);
+        UniformBlockLayout::write(data, s_frameLayout.fogExtinctionFalloff, constants.fogExtinctionFalloff);
+        UniformBlockLayout::write(data, s_frameLayout.fogInscatteringFalloff, constants.fogInscatteringFalloff);
+        UniformBlockLayout::write(data, s_frameLayout.fogColor, constants.fogColor);
+    }
+
+    // Same values the light pass used to default its fog uniforms to
+    FrameConstants getDefaultFrameConstants()
+    {
+        FrameConstants constants;
+        constants.time = 0.f;
+        constants.renderResolution = glm::vec2(1920.f, 1080.f);
+        constants.renderFog = false;
+        constants.fogDensity = 1.f;
+        constants.fogHeightFalloff = 0.5f;
+        constants.fogExtinctionFalloff = 20.f;
+        constants.fogInscatteringFalloff = 20.f;
+        constants.fogColor = glm::vec3(0.5f, 0.6f, 0.8f);
+        return constants;
+    }
+}
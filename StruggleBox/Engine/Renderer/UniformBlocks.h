@@ -0,0 +1,78 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <cstdint>
+
+// Constants shared by every program through std140 uniform blocks. Programs get the
+// blocks they declare bound when they are linked, RenderCore keeps the buffers filled.
+// The GLSL declarations have to match the packing in UniformBlocks.cpp member for member.
+
+enum class UniformBlockBinding : uint32_t
+{
+    View = 0,
+    Frame = 1,
+    Count
+};
+
+// Camera of the view being drawn, set by the renderer drawing it
+struct ViewConstants
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 position;
+    float nearDepth;
+    float farDepth;
+};
+
+struct FrameConstants
+{
+    float time;
+    glm::vec2 renderResolution;
+    bool renderFog;
+    float fogDensity;
+    float fogHeightFalloff;
+    float fogExtinctionFalloff;
+    float fogInscatteringFalloff;
+    glm::vec3 fogColor;
+};
+
+namespace UniformBlocks
+{
+    const uint32_t MAX_BLOCK_SIZE = 256;
+
+    const char* getBlockName(const UniformBlockBinding binding);
+    uint32_t getBlockSize(const UniformBlockBinding binding);
+
+    // Write the block into data, which has room for getBlockSize bytes
+    void pack(const ViewConstants& constants, uint8_t* data);
+    void pack(const FrameConstants& constants, uint8_t* data);
+    // Rewrite only the viewProjection member of a packed ViewConstants block
+    void packViewProjection(const glm::mat4& viewProjection, uint8_t* data);
+
+    FrameConstants getDefaultFrameConstants();
+}
+
+#define VIEW_CONSTANTS_GLSL \
+"layout(std140) uniform ViewConstants\n" \
+"{\n" \
+"    mat4 view;\n" \
+"    mat4 projection;\n" \
+"    mat4 viewProjection;\n" \
+"    vec3 camPos;\n" \
+"    float nearDepth;\n" \
+"    vec2 depthParameter;\n" \
+"    float farDepth;\n" \
+"};\n"
+
+#define FRAME_CONSTANTS_GLSL \
+"layout(std140) uniform FrameConstants\n" \
+"{\n" \
+"    float time;\n" \
+"    vec2 renderResolution;\n" \
+"    bool renderFog;\n" \
+"    float fogDensity;\n" \
+"    float fogHeightFalloff;\n" \
+"    float fogExtinctionFalloff;\n" \
+"    float fogInscatteringFalloff;\n" \
+"    vec3 fogColor;\n" \
+"};\n"
@@ -0,0 +1,97 @@
+#include "UniformLocationTable.h"
+
+#include <cstring>
+
+const uint32_t MIN_TABLE_SIZE = 16;
+
+UniformLocationTable::UniformLocationTable()
+    : m_count(0)
+{
+}
+
+void UniformLocationTable::clear()
+{
+    m_entries.clear();
+    m_count = 0;
+}
+
+void UniformLocationTable::add(const char* name, const int32_t location)
+{
+    if (location == NOT_FOUND)
+    {
+        return;
+    }
+    if ((m_count + 1) * 2 > m_entries.size())
+    {
+        grow();
+    }
+    const uint32_t hash = hashName(name);
+    const uint32_t mask = (uint32_t)m_entries.size() - 1;
+    for (uint32_t slot = hash & mask; ; slot = (slot + 1) & mask)
+    {
+        Entry& entry = m_entries[slot];
+        if (entry.location == NOT_FOUND)
+        {
+            entry.hash = hash;
+            entry.location = location;
+            entry.name = name;
+            m_count++;
+            return;
+        }
+        if (entry.hash == hash && entry.name == name)
+        {
+            entry.location = location;
+            return;
+        }
+    }
+}
+
+int32_t UniformLocationTable::find(const char* name) const
+{
+    if (m_count == 0)
+    {
+        return NOT_FOUND;
+    }
+    const uint32_t hash = hashName(name);
+    const uint32_t mask = (uint32_t)m_entries.size() - 1;
+    for (uint32_t slot = hash & mask; ; slot = (slot + 1) & mask)
+    {
+        const Entry& entry = m_entries[slot];
+        if (entry.location == NOT_FOUND)
+        {
+            return NOT_FOUND;
+        }
+        if (entry.hash == hash && strcmp(entry.name.c_str(), name) == 0)
+        {
+            return entry.location;
+        }
+    }
+}
+
+// FNV-1a
+uint32_t UniformLocationTable::hashName(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c; c++)
+    {
+        hash ^= (uint8_t)*c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void UniformLocationTable::grow()
+{
+    std::vector<Entry> entries;
+    entries.swap(m_entries);
+    const size_t newSize = entries.empty() ? MIN_TABLE_SIZE : entries.size() * 2;
+    m_entries.resize(newSize, Entry{ 0, NOT_FOUND, std::string() });
+    m_count = 0;
+    for (const Entry& entry : entries)
+    {
+        if (entry.location != NOT_FOUND)
+        {
+            add(entry.name.c_str(), entry.location);
+        }
+    }
+}
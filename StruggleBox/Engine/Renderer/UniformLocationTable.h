@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Uniform names to locations, filled once when a program is linked so setting a
+// uniform by name hashes the name instead of asking GL for the location every time.
+class UniformLocationTable
+{
+public:
+    static const int32_t NOT_FOUND = -1;
+
+    UniformLocationTable();
+
+    void clear();
+    void add(const char* name, const int32_t location);
+    int32_t find(const char* name) const;
+
+    uint32_t size() const { return m_count; }
+
+private:
+    struct Entry
+    {
+        uint32_t hash;
+        int32_t location;           // NOT_FOUND marks an empty slot
+        std::string name;
+    };
+
+    std::vector<Entry> m_entries;   // Open addressing, the size is a power of two and kept at most half full
+    uint32_t m_count;
+
+    static uint32_t hashName(const char* name);
+    void grow();
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "RendererDefines.h"
+#include <stdint.h>
+
+// Packed voxel chunk vertex, 8 bytes instead of the 52 of VoxelMeshPBRVertexData
+// Positions are integer voxel corners relative to the chunk origin, the chunk
+// shader scales them by the voxel width and looks the material up in the palette
+//
+// position:   x (10 bits) | y (10 bits) | z (10 bits) | ambient occlusion (2 bits)
+// attributes: normal index (3 bits) | unused (5 bits) | material ID (8 bits) | unused (16 bits)
+//
+// Normal indices follow the CubeConstants side convention:
+// left, right, bottom, top, back, front (-x, +x, -y, +y, -z, +z)
+const VertexConfig VoxelChunkVertexConfig = { 2, { 1, 1, 0, 0, 0, 0, 0, 0 }, { VertexAttributeType::UnsignedInt, VertexAttributeType::UnsignedInt } };
+typedef struct VoxelChunkVertexData {
+	uint32_t position;
+	uint32_t attributes;
+} VoxelChunkVertexData;
+
+namespace VoxelChunkVertex
+{
+	const uint32_t POSITION_BITS = 10;
+	const uint32_t POSITION_MASK = (1 << POSITION_BITS) - 1;
+	const uint32_t MAX_POSITION = POSITION_MASK;
+	const uint32_t AO_SHIFT = POSITION_BITS * 3;
+	const uint32_t AO_MASK = 0x3;
+	const uint32_t NORMAL_MASK = 0x7;
+	const uint32_t MATERIAL_SHIFT = 8;
+	const uint32_t MATERIAL_MASK = 0xFF;
+
+	inline static VoxelChunkVertexData pack(
+		const glm::ivec3& corner,
+		const uint8_t normalIndex,
+		const uint8_t materialID,
+		const uint8_t ambientOcclusion)
+	{
+		VoxelChunkVertexData vertex;
+		vertex.position =
+			((uint32_t)corner.x & POSITION_MASK) |
+			(((uint32_t)corner.y & POSITION_MASK) << POSITION_BITS) |
+			(((uint32_t)corner.z & POSITION_MASK) << (POSITION_BITS * 2)) |
+			(((uint32_t)ambientOcclusion & AO_MASK) << AO_SHIFT);
+		vertex.attributes =
+			((uint32_t)normalIndex & NORMAL_MASK) |
+			(((uint32_t)materialID & MATERIAL_MASK) << MATERIAL_SHIFT);
+		return vertex;
+	}
+
+	inline static glm::ivec3 getCorner(const VoxelChunkVertexData& vertex)
+	{
+		return glm::ivec3(
+			vertex.position & POSITION_MASK,
+			(vertex.position >> POSITION_BITS) & POSITION_MASK,
+			(vertex.position >> (POSITION_BITS * 2)) & POSITION_MASK);
+	}
+
+	inline static uint8_t getAmbientOcclusion(const VoxelChunkVertexData& vertex)
+	{
+		return (vertex.position >> AO_SHIFT) & AO_MASK;
+	}
+
+	inline static uint8_t getNormalIndex(const VoxelChunkVertexData& vertex)
+	{
+		return vertex.attributes & NORMAL_MASK;
+	}
+
+	inline static uint8_t getMaterialID(const VoxelChunkVertexData& vertex)
+	{
+		return (vertex.attributes >> MATERIAL_SHIFT) & MATERIAL_MASK;
+	}
+
+	// Same decode as voxel_chunk.vsh
+	inline static glm::vec3 getPosition(const VoxelChunkVertexData& vertex, const glm::vec3& origin, const float voxelWidth)
+	{
+		return origin + glm::vec3(getCorner(vertex)) * voxelWidth;
+	}
+}
@@ -2,9 +2,10 @@
 
 #include "CubeConstants.h"
 #include "DefaultShaders.h"
-#include "Shader.h"
-#include "Texture2D.h"
+#include "RenderBackend.h"
 #include "RenderCore.h"
+#include "Shader.h"
+#include "Profiler.h"
 
 const glm::mat4 s_projection2D = glm::ortho<float>(-0.5f, 0.5f, -0.5f, 0.5f, -1.f, 1.f);
 
@@ -16,7 +17,7 @@ VoxelRenderer::VoxelRenderer(RenderCore& renderCore, Allocator& allocator, Optio
     , m_gBuffer(renderCore)
     , m_frameBuffer(renderCore, "Main3DFrameBuffer")
     , m_lighting(renderCore)
-    , m_reflectionProbe()
+    , m_reflectionProbe(renderCore.getBackend())
     , m_textured2DVertsDrawDataID(0)
     , m_colored2DVertsDrawDataID(0)
     , m_cubeInstancesDrawDataID(0)
@@ -32,11 +33,17 @@ VoxelRenderer::VoxelRenderer(RenderCore& renderCore, Allocator& allocator, Optio
     , m_voxelPBRInstanceBuffers(renderCore)
     , m_voxelChunkBuffers(renderCore)
     , m_voxelChunkQueue()
+    , m_chunkPaletteTexture(0)
+    , m_chunkPaletteDirty(true)
     , m_coloredLineVertsBuffer(renderCore)
     , m_cubeInstanceBuffer(renderCore)
     , m_lights()
     , m_enableLighting(true)
 {
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        setChunkMaterial(i, COLOR_WHITE, glm::vec3(1.f, 1.f, 1.f));
+    }
 }
 
 VoxelRenderer::~VoxelRenderer()
@@ -70,11 +77,17 @@ void VoxelRenderer::initialize()
     m_voxelMeshShaderID = m_renderCore.getShaderID("d_mesh_instance_colored.vsh", "d_mesh_instance_colored.fsh");
     m_chunkShaderID = m_renderCore.getShaderID("voxel_chunk.vsh", "voxel_chunk.fsh");
     m_cubeShaderID = m_renderCore.getShaderID("d_cube_instance_color.vsh", "d_cube_instance_color.fsh");
+
+    const TextureParams paletteParams = { TextureFormat::RGBA32F, TextureWrap::ClampToEdge, TextureFilter::Nearest, false };
+    m_chunkPaletteTexture = m_renderCore.getBackend().createTexture(paletteParams, 256, 2, nullptr);
+    m_chunkPaletteDirty = true;
 }
 
 void VoxelRenderer::terminate()
 {
     m_renderCore.removeShader(m_chunkShaderID);
+    m_renderCore.getBackend().destroyTexture(m_chunkPaletteTexture);
+    m_chunkPaletteTexture = 0;
 
     m_lighting.terminate();
     m_gBuffer.Terminate();
@@ -88,9 +101,17 @@ void VoxelRenderer::update(const double deltaTime)
 
 void VoxelRenderer::flush()
 {
+    PROFILE_SCOPE("VoxelRenderer::flush");
+    ViewConstants viewConstants;
+    viewConstants.view = m_defaultCamera.getViewMatrix();
+    viewConstants.projection = m_defaultCamera.getProjectionMatrix();
+    viewConstants.position = m_defaultCamera.getPosition();
+    viewConstants.nearDepth = m_defaultCamera.getNearDepth();
+    viewConstants.farDepth = m_defaultCamera.getFarDepth();
+    m_renderCore.setViewConstants(viewConstants);
+
     m_gBuffer.Bind();
     m_gBuffer.Clear();
-    m_gBuffer.BindDraw();
 
     draw();
 
@@ -119,8 +140,9 @@ void VoxelRenderer::flush()
             m_reflectionProbe.getCubeMap());
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // Bind screen buffer and clear it
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    RenderBackend& backend = m_renderCore.getBackend();
+    backend.bindFrameBuffer(0); // Bind screen buffer and clear it
+    backend.clear(COLOR_NONE, true, true);
 
     {
         //const TextureID sourceTexID = m_enableLighting ? m_frameBuffer.getTextureID() : m_gBuffer.getNormalTextureID();
@@ -162,11 +184,11 @@ void VoxelRenderer::flush()
 
 void VoxelRenderer::draw()
 {
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glEnable(GL_STENCIL_TEST);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    glStencilFunc(GL_ALWAYS, Stencil_Solid, 0xFF);
+    PROFILE_SCOPE("VoxelRenderer::draw");
+    RenderBackend& backend = m_renderCore.getBackend();
+    backend.setCullingEnabled(true);
+    backend.setStencilTestEnabled(true);
+    backend.setStencilFunc(DepthFunc::Always, Stencil_Solid);
     const glm::mat4& viewMatrix = m_defaultCamera.getViewMatrix();
     const glm::mat4& projectionMatrix = m_defaultCamera.getProjectionMatrix();
     const glm::mat4 viewProjection = projectionMatrix * viewMatrix;
@@ -182,13 +204,10 @@ void VoxelRenderer::draw()
     {
         const DrawParameters& drawParams = pair.first;
         const TempVertBuffer& buffer = pair.second;
-        m_renderCore.draw(drawParams, viewProjection, DrawMode::Triangles, buffer.data, buffer.count);
+        m_renderCore.queueDraw(RenderPass::Geometry, 0, drawParams, viewProjection, DrawMode::Triangles, buffer.data, buffer.count);
     }
 
-    const Shader* voxelInstanceShader = m_renderCore.getShaderByID(m_voxelMeshShaderID);
-    voxelInstanceShader->begin();
-    voxelInstanceShader->setUniformM4fv("projectionMatrix", projectionMatrix);
-    voxelInstanceShader->setUniformM4fv("viewMatrix", viewMatrix);
+    // The programs read the camera from the ViewConstants block, RenderCore keeps its matrix current per draw
     for (const auto& pair : m_voxelPBRInstanceBuffers.getData())
     {
         const DrawDataID drawDataID = pair.first;
@@ -199,7 +218,7 @@ void VoxelRenderer::draw()
         drawParams.blendMode = BLEND_MODE_DEFAULT;
         drawParams.depthMode = DEPTH_MODE_DEFAULT;
         drawParams.drawDataID = drawDataID;
-        m_renderCore.draw(drawParams, viewProjection, DrawMode::Triangles, buffer.data, buffer.count);
+        m_renderCore.queueDraw(RenderPass::Geometry, 0, drawParams, viewProjection, DrawMode::Triangles, buffer.data, buffer.count);
     }
 
     for (const auto& pair : m_voxelChunkBuffers.getData())
@@ -209,24 +228,35 @@ void VoxelRenderer::draw()
         m_renderCore.upload(drawDataID, buffer.data, buffer.count);
     }
 
+    if (m_chunkPaletteDirty)
+    {
+        backend.updateTexture(m_chunkPaletteTexture, TextureFormat::RGBA32F, 0, 0, 256, 2, m_chunkPalette);
+        m_chunkPaletteDirty = false;
+    }
+
+    // Set here, the sampler stays with the program until the queued draws are submitted below
     const Shader* chunkShader = m_renderCore.getShaderByID(m_chunkShaderID);
     chunkShader->begin();
-    chunkShader->setUniformM4fv("mvp", viewProjection);
-    for (const DrawDataID drawDataID : m_voxelChunkQueue)
+    chunkShader->setUniform1iv("materialMap", 0);
+    const glm::vec3& cameraPosition = m_defaultCamera.getPosition();
+    const float farDepth = m_defaultCamera.getFarDepth();
+    for (const VoxelChunkInstance& chunk : m_voxelChunkQueue)
     {
         DrawParameters drawParams;
         drawParams.textureCount = 0;
         drawParams.shaderID = m_chunkShaderID;
         drawParams.blendMode = BLEND_MODE_DEFAULT;
         drawParams.depthMode = DEPTH_MODE_DEFAULT;
-        drawParams.drawDataID = drawDataID;
-        m_renderCore.draw(drawParams, viewProjection, DrawMode::Triangles, nullptr, 0);
+        drawParams.drawDataID = chunk.drawDataID;
+        // Front to back, so the depth test rejects as much of the farther chunks as it can
+        const uint32_t depth = RenderSortKey::depthFromDistance(glm::distance(chunk.origin, cameraPosition), farDepth);
+        RenderCommand& command = m_renderCore.queueDraw(RenderPass::Geometry, 0, drawParams, viewProjection, DrawMode::Triangles, nullptr, 0, depth);
+        command.setUniform("chunkTransform", glm::vec4(chunk.origin, chunk.voxelWidth));
+        // The palette isn't a cached texture, so it goes into the command as a GL handle
+        command.textureCount = 1;
+        command.textures[0] = m_chunkPaletteTexture;
     }
 
-    const Shader* cubeShader = m_renderCore.getShaderByID(m_cubeShaderID);
-    cubeShader->begin();
-    cubeShader->setUniformM4fv("projectionMatrix", projectionMatrix);
-    cubeShader->setUniformM4fv("viewMatrix", viewMatrix);
     {
         const TempVertBuffer& buffer = m_cubeInstanceBuffer.getData();
         DrawParameters drawParams;
@@ -235,8 +265,10 @@ void VoxelRenderer::draw()
         drawParams.blendMode = BLEND_MODE_DEFAULT;
         drawParams.depthMode = DEPTH_MODE_DEFAULT;
         drawParams.drawDataID = m_cubeInstancesDrawDataID;
-        m_renderCore.draw(drawParams, viewProjection, DrawMode::Triangles, buffer.data, buffer.count);
+        m_renderCore.queueDraw(RenderPass::Geometry, 0, drawParams, viewProjection, DrawMode::Triangles, buffer.data, buffer.count);
     }
+
+    m_renderCore.submitCommands();
 }
 
 ShaderID VoxelRenderer::getShaderID(const std::string& shaderVertexName, const std::string& shaderFragName)
@@ -271,17 +303,37 @@ ColoredInstanceTransform3DData* VoxelRenderer::bufferVoxelMeshInstances(const si
 
 DrawDataID VoxelRenderer::createVoxelChunkDrawData()
 {
-    return m_renderCore.createDrawData(VoxelPBRVertexConfig);
+    return m_renderCore.createDrawData(VoxelChunkVertexConfig);
+}
+
+void VoxelRenderer::destroyVoxelChunkDrawData(const DrawDataID drawDataID)
+{
+    m_renderCore.removeDrawData(drawDataID);
 }
 
-VoxelMeshPBRVertexData* VoxelRenderer::bufferVoxelChunkVerts(const size_t count, const DrawDataID drawDataID)
+VoxelChunkVertexData* VoxelRenderer::bufferVoxelChunkVerts(const size_t count, const DrawDataID drawDataID)
 {
     return m_voxelChunkBuffers.buffer(count, drawDataID);
 }
 
-void VoxelRenderer::queueVoxelChunk(const DrawDataID drawDataID)
+void VoxelRenderer::queueVoxelChunk(const DrawDataID drawDataID, const glm::vec3& origin, const float voxelWidth)
+{
+    m_voxelChunkQueue.push_back({ drawDataID, origin, voxelWidth });
+}
+
+void VoxelRenderer::setChunkMaterial(const uint8_t materialID, const Color& albedo, const glm::vec3& material)
 {
-    m_voxelChunkQueue.push_back(drawDataID);
+    float* albedoTexel = &m_chunkPalette[materialID * 4];
+    float* materialTexel = &m_chunkPalette[(256 + materialID) * 4];
+    albedoTexel[0] = albedo.r;
+    albedoTexel[1] = albedo.g;
+    albedoTexel[2] = albedo.b;
+    albedoTexel[3] = albedo.a;
+    materialTexel[0] = material.r;
+    materialTexel[1] = material.g;
+    materialTexel[2] = material.b;
+    materialTexel[3] = 1.f;
+    m_chunkPaletteDirty = true;
 }
 
 void VoxelRenderer::buffer3DLine(const glm::vec3& pointA, const glm::vec3& pointB, const Color& colorA, const Color& colorB)
@@ -323,7 +375,8 @@ void VoxelRenderer::prepareFrameBuffer()
     //glStencilFunc(GL_EQUAL, Stencil_Sky, 0xFF);             // Only draw sky layer
     //m_renderCore.draw(m_textured2DVertsShaderID, m_gBuffer.getAlbedoTextureID(), m_textured2DVertsDrawDataID, s_projection2D, DrawMode::Triangles, nullptr, 0, 6, BLEND_MODE_DISABLED, DEPTH_MODE_DISABLED);
 
-    glStencilFunc(GL_EQUAL, Stencil_Solid, 0xFF);           // Only draw solid layer
+    RenderBackend& backend = m_renderCore.getBackend();
+    backend.setStencilFunc(DepthFunc::Equal, Stencil_Solid);           // Only draw solid layer
     TempVertBuffer buffer;
     m_renderCore.setupTempVertBuffer<ColoredVertex3DData>(buffer, 4);
     ColoredVertex3DData* dataPtr = (ColoredVertex3DData*)buffer.data;
@@ -333,14 +386,13 @@ void VoxelRenderer::prepareFrameBuffer()
     dataPtr[3] = { glm::vec3(-0.5, 0.5, 0.0), COLOR_BLACK };
     m_renderCore.draw(m_coloredVertsShaderID, 0, m_colored2DVertsDrawDataID, s_projection2D, DrawMode::TriangleFan, dataPtr, 0, 6, BLEND_MODE_DISABLED, DEPTH_MODE_DISABLED);
 
-    glDisable(GL_STENCIL_TEST);
+    backend.setStencilTestEnabled(false);
 }
 
 const glm::vec3 VoxelRenderer::getCursor3DPos(const glm::vec2& cursorPos) const
 {
-    GLfloat cursorDepth = 0;
     // Obtain the Z position (not world coordinates but in range 0 ~ 1)
-    glReadPixels(cursorPos.x, cursorPos.y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &cursorDepth);
+    const float cursorDepth = m_renderCore.getBackend().readDepth((int32_t)cursorPos.x, (int32_t)cursorPos.y);
     // Grab pixel under cursor color
 //    GLfloat col[4];
 //    glReadPixels(cursorPos.x, cursorPos.y, 1, 1, GL_RGBA, GL_FLOAT, &col);
@@ -368,24 +420,23 @@ void VoxelRenderer::updateReflections()
 
     const int drawSize = 256;
     const int cubeSize = m_reflectionProbe.getTextureSize();
+    RenderBackend& backend = m_renderCore.getBackend();
 
     for (int side = 0; side < 6; side++)
     {
         CubeMapSide cubeSide = (CubeMapSide)side;
-        glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-        glEnable(GL_STENCIL_TEST);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
-        glDepthMask(GL_TRUE);
+        backend.setStencilTestEnabled(true);
+        backend.setDepthTestEnabled(true);
+        backend.setDepthFunc(DepthFunc::LessOrEqual);
+        backend.setDepthMask(true);
         m_gBuffer.Bind();
         m_gBuffer.Clear();
         glm::mat4 reflectionView = m_reflectionProbe.getView(cubeSide);
         glm::mat4 reflectionProjection = m_reflectionProbe.getProjection(cubeSide);
         glm::mat3 reflectionNormalMatrix = glm::inverse(glm::mat3(reflectionView));
 
-        glViewport(0, 0, cubeSize, cubeSize);
-        glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-        glStencilFunc(GL_ALWAYS, Stencil_Solid, 0xFF);
+        backend.setViewport(0, 0, cubeSize, cubeSize);
+        backend.setStencilFunc(DepthFunc::Always, Stencil_Solid);
         //if (_material.allLoaded())
         //{
         //    renderCubes(m_reflectionProbe.getView(cubeSide), m_reflectionProbe.getProjection(cubeSide), *d_shaderCubeSimple);
@@ -428,25 +479,18 @@ void VoxelRenderer::updateReflections()
         m_reflectionProbe.bind(cubeSide);
         //glClear(GL_COLOR_BUFFER_BIT);
 
-        glDisable(GL_BLEND);
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_STENCIL_TEST);
-        glDepthMask(GL_FALSE);
+        backend.setBlendEnabled(false);
+        backend.setDepthTestEnabled(false);
+        backend.setStencilTestEnabled(false);
+        backend.setDepthMask(false);
 
         //Rect2D tRect = Rect2D(0.0f, 0.0f, ratioX, ratioY);
 
-        glm::mat4 mvp = glm::ortho<GLfloat>(0.0, 1.0, 0.0, 1.0, -1.0, 1.0);
+        glm::mat4 mvp = glm::ortho<float>(0.0, 1.0, 0.0, 1.0, -1.0, 1.0);
         // copy lit image from final_fbo to cubemap side
         //m_renderer.DrawTexture(Rect2D(0, 0, 1.0f, 1.0f), tRect, final_texture, mvp);
     }
 
     // Generate mipmaps for rough surfaces
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_reflectionProbe.getCubeMap());
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    backend.generateCubeMapMipmaps(m_reflectionProbe.getCubeMap());
 }
@@ -8,6 +8,7 @@
 #include "ReflectionProbe.h"
 #include "VertexDataBuffer.h"
 #include "VertexDataBufferMap.h"
+#include "VoxelChunkVertex.h"
 
 const VertexConfig VoxelPBRVertexConfig = { 4, { 3, 3, 4, 3, 0, 0, 0, 0 } };
 // Structure for PBR voxel vertex data
@@ -69,8 +70,12 @@ public:
 	ColoredInstanceTransform3DData* bufferVoxelMeshInstances(const size_t count, const DrawDataID drawDataID);
 
 	DrawDataID createVoxelChunkDrawData();
-	VoxelMeshPBRVertexData* bufferVoxelChunkVerts(const size_t count, const DrawDataID drawDataID);
-	void queueVoxelChunk(const DrawDataID drawDataID);
+	void destroyVoxelChunkDrawData(const DrawDataID drawDataID);
+	VoxelChunkVertexData* bufferVoxelChunkVerts(const size_t count, const DrawDataID drawDataID);
+	// Origin is the world position of voxel corner (0,0,0) in the chunk
+	void queueVoxelChunk(const DrawDataID drawDataID, const glm::vec3& origin, const float voxelWidth);
+	// Palette the packed chunk vertices look their material IDs up in
+	void setChunkMaterial(const uint8_t materialID, const Color& albedo, const glm::vec3& material);
 
 	void buffer3DLine(const glm::vec3& pointA, const glm::vec3& pointB, const Color& colorA, const Color& colorB);
 	ColoredVertex3DData* bufferColoredLines(const size_t count);
@@ -112,8 +117,16 @@ private:
 	VertexDataBufferMap<DrawParameters, ColoredInstanceTransform3DData> m_voxelPBRInstanceBuffersCustom;
 	VertexDataBufferMap<DrawDataID, ColoredInstanceTransform3DData> m_voxelPBRInstanceBuffers;
 
-	VertexDataBufferMap<DrawDataID, VoxelMeshPBRVertexData> m_voxelChunkBuffers;
-	std::vector<DrawDataID> m_voxelChunkQueue;
+	struct VoxelChunkInstance {
+		DrawDataID drawDataID;
+		glm::vec3 origin;
+		float voxelWidth;
+	};
+	VertexDataBufferMap<DrawDataID, VoxelChunkVertexData> m_voxelChunkBuffers;
+	std::vector<VoxelChunkInstance> m_voxelChunkQueue;
+	float m_chunkPalette[256 * 2 * 4];	// Albedo row followed by material row
+	uint32_t m_chunkPaletteTexture;
+	bool m_chunkPaletteDirty;
 
 	VertexDataBuffer<ColoredVertex3DData> m_coloredLineVertsBuffer;
 	VertexDataBuffer<CubeInstanceTransform3DData> m_cubeInstanceBuffer;
@@ -1,271 +1,190 @@
 #include "Frustum.h"
 
-namespace Frustum
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// The batch tests have to give the same answers as the single ones, so both
+// sum the plane distance terms in the same order
+
+static inline float planeDistance(const glm::vec4& plane, const glm::vec3& point)
 {
-    GLdouble frustum[6][4];
-    
-    //========================================================================
-    // ExtractFrustum() - Frustum extraction function
-    //========================================================================
-    void Extract( glm::mat4& mvp ) {
-        GLfloat t;
-        
-        /* Extract the numbers for the RIGHT plane */
-        frustum[0][0] = mvp[0][3] - mvp[0][0];
-        frustum[0][1] = mvp[1][3] - mvp[1][0];
-        frustum[0][2] = mvp[2][3] - mvp[2][0];
-        frustum[0][3] = mvp[3][3] - mvp[3][0];
-        /* Normalize the result */
-        t = sqrt( frustum[0][0] * frustum[0][0] + frustum[0][1] * frustum[0][1] + frustum[0][2] * frustum[0][2] );
-        frustum[0][0] /= t;
-        frustum[0][1] /= t;
-        frustum[0][2] /= t;
-        frustum[0][3] /= t;
-        
-        /* Extract the numbers for the LEFT plane */
-        frustum[1][0] = mvp[0][3] + mvp[0][0];
-        frustum[1][1] = mvp[1][3] + mvp[1][0];
-        frustum[1][2] = mvp[2][3] + mvp[2][0];
-        frustum[1][3] = mvp[3][3] + mvp[3][0];
+    return plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
+}
 
-        /* Normalize the result */
-        t = sqrt( frustum[1][0] * frustum[1][0] + frustum[1][1] * frustum[1][1] + frustum[1][2] * frustum[1][2] );
-        frustum[1][0] /= t;
-        frustum[1][1] /= t;
-        frustum[1][2] /= t;
-        frustum[1][3] /= t;
-        
-        /* Extract the BOTTOM plane */
-        frustum[2][0] = mvp[0][3] + mvp[0][1];
-        frustum[2][1] = mvp[1][3] + mvp[1][1];
-        frustum[2][2] = mvp[2][3] + mvp[2][1];
-        frustum[2][3] = mvp[3][3] + mvp[3][1];
-        /* Normalize the result */
-        t = sqrt( frustum[2][0] * frustum[2][0] + frustum[2][1] * frustum[2][1] + frustum[2][2] * frustum[2][2] );
-        frustum[2][0] /= t;
-        frustum[2][1] /= t;
-        frustum[2][2] /= t;
-        frustum[2][3] /= t;
-        
-        /* Extract the TOP plane */
-        frustum[3][0] = mvp[0][3] - mvp[0][1];
-        frustum[3][1] = mvp[1][3] - mvp[1][1];
-        frustum[3][2] = mvp[2][3] - mvp[2][1];
-        frustum[3][3] = mvp[3][3] - mvp[3][1];
-        
-        /* Normalize the result */
-        t = sqrt( frustum[3][0] * frustum[3][0] + frustum[3][1] * frustum[3][1] + frustum[3][2] * frustum[3][2] );
-        frustum[3][0] /= t;
-        frustum[3][1] /= t;
-        frustum[3][2] /= t;
-        frustum[3][3] /= t;
-        
-        /* Extract the FAR plane */
-        frustum[4][0] = mvp[0][3] - mvp[0][2];
-        frustum[4][1] = mvp[1][3] - mvp[1][2];
-        frustum[4][2] = mvp[2][3] - mvp[2][2];
-        frustum[4][3] = mvp[3][3] - mvp[3][2];
-        /* Normalize the result */
-        t = sqrt( frustum[4][0] * frustum[4][0] + frustum[4][1] * frustum[4][1] + frustum[4][2] * frustum[4][2] );
-        frustum[4][0] /= t;
-        frustum[4][1] /= t;
-        frustum[4][2] /= t;
-        frustum[4][3] /= t;
-        
-        /* Extract the NEAR plane */
-        frustum[5][0] = mvp[0][3] + mvp[0][2];
-        frustum[5][1] = mvp[1][3] + mvp[1][2];
-        frustum[5][2] = mvp[2][3] + mvp[2][2];
-        frustum[5][3] = mvp[3][3] + mvp[3][2];
-        /* Normalize the result */
-        t = sqrt( frustum[5][0] * frustum[5][0] + frustum[5][1] * frustum[5][1] + frustum[5][2] * frustum[5][2] );
-        frustum[5][0] /= t;
-        frustum[5][1] /= t;
-        frustum[5][2] /= t;
-        frustum[5][3] /= t;
-    }
-    //========================================================================
-    // PointInFrustum() - Test if point is in frustum
-    //========================================================================
-    bool PointInFrustum( GLfloat x, GLfloat y, GLfloat z ) {
-        int p;
-        for( p = 0; p < 6; p++ )
-            if( frustum[p][0] * x + frustum[p][1] * y + frustum[p][2] * z + frustum[p][3] <= 0 )
-                return false;
-        return true;
+static inline float planeExtent(const glm::vec4& plane, const glm::vec3& extents)
+{
+    return std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+}
+
+Frustum::Frustum()
+{
+    for (uint32_t i = 0; i < PLANE_COUNT; i++)
+    {
+        m_planes[i] = glm::vec4(0.f, 0.f, 0.f, 1.f);
     }
-    //========================================================================
-    // SphereInFrustumS() - Test if sphere is in frustum
-    //========================================================================
-    bool SphereInFrustumS( GLfloat x, GLfloat y, GLfloat z, GLfloat radius ) {
-        int p;
-        for( p = 0; p < 6; p++ ) {
-            if( frustum[p][0] * x + frustum[p][1] * y + frustum[p][2] * z + frustum[p][3] <= -radius )
-            { return false; }
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    // glm matrices are column major, the planes are built from the rows
+    const glm::mat4& m = viewProjection;
+    const glm::vec4 rowX = glm::vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const glm::vec4 rowY = glm::vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const glm::vec4 rowZ = glm::vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const glm::vec4 rowW = glm::vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    m_planes[0] = rowW + rowX;  // Left
+    m_planes[1] = rowW - rowX;  // Right
+    m_planes[2] = rowW + rowY;  // Bottom
+    m_planes[3] = rowW - rowY;  // Top
+    m_planes[4] = rowW + rowZ;  // Near
+    m_planes[5] = rowW - rowZ;  // Far
+
+    for (uint32_t i = 0; i < PLANE_COUNT; i++)
+    {
+        const float length = glm::length(glm::vec3(m_planes[i]));
+        if (length > 0.f)
+        {
+            m_planes[i] /= length;
         }
-        return true;
-    }
-    //========================================================================
-    // SphereInFrustumDist() - Get distance of circle from frustum
-    //========================================================================
-    GLfloat SphereInFrustumDist( GLfloat x, GLfloat y, GLfloat z, GLfloat radius ) {
-        int p;
-        GLfloat d = 0.0;
-        for ( p = 0; p < 6; p++ ) {
-            d = frustum[p][0] * x + frustum[p][1] * y + frustum[p][2] * z + frustum[p][3];
-            if( d <= -radius )
-                return 0;
+        else
+        {
+            // Degenerate plane, don't let it cull anything
+            m_planes[i] = glm::vec4(0.f, 0.f, 0.f, 1.f);
         }
-        return d + radius;
     }
-    //========================================================================
-    // SphereInFrustum() - Test if sphere is in frustum, return 2 if fully in
-    //========================================================================
-    int SphereInFrustum( GLfloat x, GLfloat y, GLfloat z, GLfloat radius ) {
-        int p;
-        int c = 0;
-        float d;
-        for ( p = 0; p < 6; p++ ) {
-            d = frustum[p][0] * x + frustum[p][1] * y + frustum[p][2] * z + frustum[p][3];
-            if( d <= -radius )
-            { return 0; }
-            if( d > radius )
-            { c++; }
+}
+
+bool Frustum::containsPoint(const glm::vec3& point) const
+{
+    for (uint32_t i = 0; i < PLANE_COUNT; i++)
+    {
+        if (planeDistance(m_planes[i], point) < 0.f)
+        {
+            return false;
         }
-        return (c == 6) ? 2 : 1;
     }
-    //========================================================================
-    // CubeInFrustum() - Test if cube is in frustum, return 2 if fully in
-    //========================================================================
-    int CubeInFrustum( GLfloat x, GLfloat y, GLfloat z, GLfloat size ) {
-        int p;
-        int c;
-        int c2 = 0;
-        for ( p = 0; p < 6; p++ ) {
-            c = 0;
-            if( frustum[p][0] * (x - size) + frustum[p][1] * (y - size) + frustum[p][2] * (z - size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + size) + frustum[p][1] * (y - size) + frustum[p][2] * (z - size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - size) + frustum[p][1] * (y + size) + frustum[p][2] * (z - size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + size) + frustum[p][1] * (y + size) + frustum[p][2] * (z - size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - size) + frustum[p][1] * (y - size) + frustum[p][2] * (z + size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + size) + frustum[p][1] * (y - size) + frustum[p][2] * (z + size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - size) + frustum[p][1] * (y + size) + frustum[p][2] * (z + size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + size) + frustum[p][1] * (y + size) + frustum[p][2] * (z + size) + frustum[p][3] > 0 )
-                c++;
-            if( c == 0 )
-            { return 0; }
-            if( c == 8 )
-            { c2++; }
+    return true;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, const float radius) const
+{
+    for (uint32_t i = 0; i < PLANE_COUNT; i++)
+    {
+        if (planeDistance(m_planes[i], center) < -radius)
+        {
+            return false;
         }
-        return (c2 == 6) ? 2 : 1;
     }
-    //========================================================================
-    // CubeInFrustumDist() - Test if cube is in frustum, return 2 if fully in
-    //========================================================================
-    GLfloat CubeInFrustumDist( GLfloat x, GLfloat y, GLfloat z, GLfloat size ) {
-        int p;
-        int c;
-        int c2 = 0;
-        for ( p = 0; p < 6; p++ ) {
-            c = 0;
-            if( frustum[p][0] * (x - size) + frustum[p][1] * (y - size) + frustum[p][2] * (z - size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + size) + frustum[p][1] * (y - size) + frustum[p][2] * (z - size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - size) + frustum[p][1] * (y + size) + frustum[p][2] * (z - size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + size) + frustum[p][1] * (y + size) + frustum[p][2] * (z - size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - size) + frustum[p][1] * (y - size) + frustum[p][2] * (z + size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + size) + frustum[p][1] * (y - size) + frustum[p][2] * (z + size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - size) + frustum[p][1] * (y + size) + frustum[p][2] * (z + size) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + size) + frustum[p][1] * (y + size) + frustum[p][2] * (z + size) + frustum[p][3] > 0 )
-                c++;
-            if( c == 0 )
-            { return 0; }
-            if( c == 8 )
-            { c2++; }
+    return true;
+}
+
+bool Frustum::intersectsBox(const BoundingBox& box) const
+{
+    for (uint32_t i = 0; i < PLANE_COUNT; i++)
+    {
+        if (planeDistance(m_planes[i], box.center) < -planeExtent(m_planes[i], box.extents))
+        {
+            return false;
         }
-        GLfloat d = frustum[5][0] * x + frustum[5][1] * y + frustum[5][2] * z + frustum[5][3];
-        return d+size;
     }
-    //========================================================================
-    // BoxInFrustum() - Test if cube is in frustum, return 2 if fully in
-    //========================================================================
-    int BoxInFrustum( GLfloat x, GLfloat y, GLfloat z, GLfloat sizeX, GLfloat sizeY, GLfloat sizeZ ) {
-        int p;
-        int c;
-        int c2 = 0;
-        for ( p = 0; p < 6; p++ ) {
-            c = 0;
-            if( frustum[p][0] * (x - sizeX) + frustum[p][1] * (y - sizeY) + frustum[p][2] * (z - sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + sizeX) + frustum[p][1] * (y - sizeY) + frustum[p][2] * (z - sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - sizeX) + frustum[p][1] * (y + sizeY) + frustum[p][2] * (z - sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + sizeX) + frustum[p][1] * (y + sizeY) + frustum[p][2] * (z - sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - sizeX) + frustum[p][1] * (y - sizeY) + frustum[p][2] * (z + sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + sizeX) + frustum[p][1] * (y - sizeY) + frustum[p][2] * (z + sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - sizeX) + frustum[p][1] * (y + sizeY) + frustum[p][2] * (z + sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + sizeX) + frustum[p][1] * (y + sizeY) + frustum[p][2] * (z + sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( c == 0 )
-            { return 0; }
-            if( c == 8 )
-            { c2++; }
+    return true;
+}
+
+void Frustum::cullSpheres(const glm::vec4* spheres, const size_t count, uint32_t* visibility, const uint32_t frustumMask) const
+{
+    size_t i = 0;
+#if FRUSTUM_SSE
+    // Four spheres at a time, transposed so each register holds one component
+    const __m128 signMask = _mm_set1_ps(-0.f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&spheres[i].x);
+        __m128 y = _mm_loadu_ps(&spheres[i + 1].x);
+        __m128 z = _mm_loadu_ps(&spheres[i + 2].x);
+        __m128 radius = _mm_loadu_ps(&spheres[i + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, radius);
+        const __m128 negRadius = _mm_xor_ps(radius, signMask);
+
+        __m128 outside = _mm_setzero_ps();
+        for (uint32_t p = 0; p < PLANE_COUNT; p++)
+        {
+            const glm::vec4& plane = m_planes[p];
+            __m128 distance = _mm_mul_ps(x, _mm_set1_ps(plane.x));
+            distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+            distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+        }
+
+        const int outsideBits = _mm_movemask_ps(outside);
+        for (uint32_t j = 0; j < 4; j++)
+        {
+            if ((outsideBits & (1 << j)) == 0)
+            {
+                visibility[i + j] |= frustumMask;
+            }
         }
-        return (c2 == 6) ? 2 : 1;
     }
-    //========================================================================
-    // BoxInFrustumDist() - Test if cube is in frustum, return 2 if fully in
-    //========================================================================
-    GLfloat BoxInFrustumDist( GLfloat x, GLfloat y, GLfloat z, GLfloat sizeX, GLfloat sizeY, GLfloat sizeZ ) {
-        int p;
-        int c;
-        int c2 = 0;
-        for ( p = 0; p < 6; p++ ) {
-            c = 0;
-            if( frustum[p][0] * (x - sizeX) + frustum[p][1] * (y - sizeY) + frustum[p][2] * (z - sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + sizeX) + frustum[p][1] * (y - sizeY) + frustum[p][2] * (z - sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - sizeX) + frustum[p][1] * (y + sizeY) + frustum[p][2] * (z - sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + sizeX) + frustum[p][1] * (y + sizeY) + frustum[p][2] * (z - sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - sizeX) + frustum[p][1] * (y - sizeY) + frustum[p][2] * (z + sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + sizeX) + frustum[p][1] * (y - sizeY) + frustum[p][2] * (z + sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x - sizeX) + frustum[p][1] * (y + sizeY) + frustum[p][2] * (z + sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( frustum[p][0] * (x + sizeX) + frustum[p][1] * (y + sizeY) + frustum[p][2] * (z + sizeZ) + frustum[p][3] > 0 )
-                c++;
-            if( c == 0 )
-            { return 0; }
-            if( c == 8 )
-            { c2++; }
+#endif
+    for (; i < count; i++)
+    {
+        if (intersectsSphere(glm::vec3(spheres[i]), spheres[i].w))
+        {
+            visibility[i] |= frustumMask;
         }
-        GLfloat d = frustum[5][0] * x + frustum[5][1] * y + frustum[5][2] * z + frustum[5][3];
-        return d+((sizeX+sizeY+sizeZ)/3.0f);
     }
-
 }
 
+void Frustum::cullBoxes(const BoundingBox* boxes, const size_t count, uint32_t* visibility, const uint32_t frustumMask) const
+{
+    size_t i = 0;
+#if FRUSTUM_SSE
+    // Four boxes at a time, each plane's reach into a box comes from its absolute normal
+    for (; i + 4 <= count; i += 4)
+    {
+        const BoundingBox* b = &boxes[i];
+        const __m128 x = _mm_setr_ps(b[0].center.x, b[1].center.x, b[2].center.x, b[3].center.x);
+        const __m128 y = _mm_setr_ps(b[0].center.y, b[1].center.y, b[2].center.y, b[3].center.y);
+        const __m128 z = _mm_setr_ps(b[0].center.z, b[1].center.z, b[2].center.z, b[3].center.z);
+        const __m128 extentX = _mm_setr_ps(b[0].extents.x, b[1].extents.x, b[2].extents.x, b[3].extents.x);
+        const __m128 extentY = _mm_setr_ps(b[0].extents.y, b[1].extents.y, b[2].extents.y, b[3].extents.y);
+        const __m128 extentZ = _mm_setr_ps(b[0].extents.z, b[1].extents.z, b[2].extents.z, b[3].extents.z);
 
+        __m128 outside = _mm_setzero_ps();
+        for (uint32_t p = 0; p < PLANE_COUNT; p++)
+        {
+            const glm::vec4& plane = m_planes[p];
+            __m128 distance = _mm_mul_ps(x, _mm_set1_ps(plane.x));
+            distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+            distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
 
+            __m128 reach = _mm_mul_ps(extentX, _mm_set1_ps(std::fabs(plane.x)));
+            reach = _mm_add_ps(reach, _mm_mul_ps(extentY, _mm_set1_ps(std::fabs(plane.y))));
+            reach = _mm_add_ps(reach, _mm_mul_ps(extentZ, _mm_set1_ps(std::fabs(plane.z))));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), reach)));
+        }
+
+        const int outsideBits = _mm_movemask_ps(outside);
+        for (uint32_t j = 0; j < 4; j++)
+        {
+            if ((outsideBits & (1 << j)) == 0)
+            {
+                visibility[i + j] |= frustumMask;
+            }
+        }
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (intersectsBox(boxes[i]))
+        {
+            visibility[i] |= frustumMask;
+        }
+    }
+}
@@ -1,17 +1,40 @@
-#ifndef FRUSTUM_H
-#define FRUSTUM_H
+#pragma once
 
-#include "GFXDefines.h"
+#include "glm/glm.hpp"
+#include <cstddef>
+#include <cstdint>
 
-namespace Frustum
+struct BoundingBox
 {
-    void Extract( glm::mat4& mvp );
-    bool PointInFrustum( GLfloat x, GLfloat y, GLfloat z );
-    GLfloat SphereInFrustumDist( GLfloat x, GLfloat y, GLfloat z, GLfloat radius );
-    int SphereInFrustum( GLfloat x, GLfloat y, GLfloat z, GLfloat radius );
-    int CubeInFrustum( GLfloat x, GLfloat y, GLfloat z, GLfloat size );
-    GLfloat CubeInFrustumDist( GLfloat x, GLfloat y, GLfloat z, GLfloat size );
-    int BoxInFrustum( GLfloat x, GLfloat y, GLfloat z, GLfloat sizeX, GLfloat sizeY, GLfloat sizeZ );
-    GLfloat BoxInFrustumDist( GLfloat x, GLfloat y, GLfloat z, GLfloat sizeX, GLfloat sizeY, GLfloat sizeZ );
-}
-#endif
+    glm::vec3 center;
+    glm::vec3 extents;      // Half the size on each axis
+};
+
+// Planes of a view frustum, taken from a view projection matrix. It's a plain value with
+// no shared state, so any number of frusta (main view, shadows, reflections) can be tested
+// at the same time from any thread.
+class Frustum
+{
+public:
+    static const uint32_t PLANE_COUNT = 6;
+
+    // Default frustum contains everything
+    Frustum();
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    bool containsPoint(const glm::vec3& point) const;
+    bool intersectsSphere(const glm::vec3& center, const float radius) const;
+    bool intersectsBox(const BoundingBox& box) const;
+
+    // Batch tests, spheres are xyz center and w radius. frustumMask gets OR'ed into
+    // visibility[i] for every object touching the frustum and other bits are left alone,
+    // so several frusta can be culled into the same visibility masks.
+    void cullSpheres(const glm::vec4* spheres, const size_t count, uint32_t* visibility, const uint32_t frustumMask) const;
+    void cullBoxes(const BoundingBox* boxes, const size_t count, uint32_t* visibility, const uint32_t frustumMask) const;
+
+    // Plane normals point inwards, xyz normal and w distance
+    const glm::vec4& getPlane(const uint32_t index) const { return m_planes[index]; }
+
+private:
+    glm::vec4 m_planes[PLANE_COUNT];
+};
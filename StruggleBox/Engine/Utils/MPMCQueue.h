@@ -0,0 +1,148 @@
+#pragma once
+
+#include "QueueWaiter.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+///  Bounded lock-free queue for any number of producer and consumer threads
+///  Every cell carries a sequence number telling producers and consumers
+///  whose turn it is, a position is claimed with one compare and swap
+///  Capacity is rounded up to a power of two
+template <class T>
+class MPMCQueue
+{
+public:
+    explicit MPMCQueue(const size_t capacity)
+        : m_capacity(roundUpToPowerOfTwo(capacity))
+        , m_mask(m_capacity - 1)
+        , m_cells(new Cell[m_capacity])
+        , m_enqueuePos(0)
+        , m_dequeuePos(0)
+    {
+        for (size_t i = 0; i < m_capacity; i++)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    /// Returns false without blocking if the queue is full
+    template <class U>
+    bool tryPush(U&& value)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;   // Cell still holds the value from a lap ago
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::forward<U>(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        m_waiter.notify();
+        return true;
+    }
+
+    /// Returns false without blocking if the queue is empty
+    bool tryPop(T& value)
+    {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;   // Nothing written to this cell yet
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        m_waiter.notify();
+        return true;
+    }
+
+    /// Waits for room if the queue is full
+    template <class U>
+    void push(U&& value)
+    {
+        m_waiter.waitUntil([this, &value]() { return tryPush(std::forward<U>(value)); });
+    }
+
+    /// Waits for a value if the queue is empty
+    void pop(T& value)
+    {
+        m_waiter.waitUntil([this, &value]() { return tryPop(value); });
+    }
+
+    /// Only a snapshot while other threads are pushing or popping
+    size_t size() const
+    {
+        const size_t enqueuePos = m_enqueuePos.load(std::memory_order_acquire);
+        const size_t dequeuePos = m_dequeuePos.load(std::memory_order_acquire);
+        return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return m_capacity; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    char m_padding0[QUEUE_CACHE_LINE_SIZE];
+    std::atomic<size_t> m_enqueuePos;
+    char m_padding1[QUEUE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_dequeuePos;
+    char m_padding2[QUEUE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    QueueWaiter m_waiter;
+
+    static size_t roundUpToPowerOfTwo(const size_t value)
+    {
+        size_t result = 2;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+};
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <climits>
+#include <cstdint>
 #include <type_traits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace MathUtils
 {
@@ -105,4 +109,16 @@ namespace MathUtils
         }
         return ++v;
     }
+
+    // Index of the lowest set bit, value must not be zero
+    inline static int CountTrailingZeros(const uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return (int)index;
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
 }
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+const size_t QUEUE_CACHE_LINE_SIZE = 64;    // Producer and consumer positions are kept this far apart
+const int QUEUE_WAIT_SPINS = 64;            // Retries before a waiting thread goes to sleep
+
+///  Lets threads sleep until a lock-free queue changes
+///  The mutex is only touched when somebody is actually asleep, so queues
+///  nobody waits on stay lock-free
+class QueueWaiter
+{
+public:
+    QueueWaiter() : m_numSleeping(0), m_epoch(0) {}
+
+    /// Calls tryFunc until it returns true, retrying for a while before sleeping
+    template<class F>
+    void waitUntil(const F& tryFunc)
+    {
+        for (int spin = 0; spin < QUEUE_WAIT_SPINS; spin++)
+        {
+            if (tryFunc())
+            {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        m_numSleeping.fetch_add(1, std::memory_order_relaxed);
+        while (true)
+        {
+            const uint32_t epoch = m_epoch.load(std::memory_order_acquire);
+            // Pairs with the fence in notify, either we see the change or the notifier sees us
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (tryFunc())
+            {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this, epoch]() { return m_epoch.load(std::memory_order_relaxed) != epoch; });
+        }
+        m_numSleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// Queues call this after every push and pop
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_numSleeping.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_epoch.fetch_add(1, std::memory_order_release);
+        }
+        m_condition.notify_all();
+    }
+
+private:
+    std::atomic<int> m_numSleeping;
+    std::atomic<uint32_t> m_epoch;      // Bumped by every notify that finds a sleeper
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
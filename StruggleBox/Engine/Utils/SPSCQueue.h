@@ -0,0 +1,117 @@
+#pragma once
+
+#include "QueueWaiter.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+///  Bounded lock-free queue for exactly one producer and one consumer thread
+///  Each side owns one position and only reads the other's, so neither
+///  needs more than a load and a store per value
+///  Capacity is rounded up to a power of two
+template <class T>
+class SPSCQueue
+{
+public:
+    explicit SPSCQueue(const size_t capacity)
+        : m_capacity(roundUpToPowerOfTwo(capacity))
+        , m_mask(m_capacity - 1)
+        , m_values(new T[m_capacity])
+        , m_writePos(0)
+        , m_cachedReadPos(0)
+        , m_readPos(0)
+        , m_cachedWritePos(0)
+    {
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    /// Producer only, returns false without blocking if the queue is full
+    template <class U>
+    bool tryPush(U&& value)
+    {
+        const size_t writePos = m_writePos.load(std::memory_order_relaxed);
+        if (writePos - m_cachedReadPos == m_capacity)
+        {
+            // Looks full, see how far the consumer really got
+            m_cachedReadPos = m_readPos.load(std::memory_order_acquire);
+            if (writePos - m_cachedReadPos == m_capacity)
+            {
+                return false;
+            }
+        }
+        m_values[writePos & m_mask] = std::forward<U>(value);
+        m_writePos.store(writePos + 1, std::memory_order_release);
+        m_waiter.notify();
+        return true;
+    }
+
+    /// Consumer only, returns false without blocking if the queue is empty
+    bool tryPop(T& value)
+    {
+        const size_t readPos = m_readPos.load(std::memory_order_relaxed);
+        if (readPos == m_cachedWritePos)
+        {
+            m_cachedWritePos = m_writePos.load(std::memory_order_acquire);
+            if (readPos == m_cachedWritePos)
+            {
+                return false;
+            }
+        }
+        value = std::move(m_values[readPos & m_mask]);
+        m_readPos.store(readPos + 1, std::memory_order_release);
+        m_waiter.notify();
+        return true;
+    }
+
+    /// Producer only, waits for room if the queue is full
+    template <class U>
+    void push(U&& value)
+    {
+        m_waiter.waitUntil([this, &value]() { return tryPush(std::forward<U>(value)); });
+    }
+
+    /// Consumer only, waits for a value if the queue is empty
+    void pop(T& value)
+    {
+        m_waiter.waitUntil([this, &value]() { return tryPop(value); });
+    }
+
+    /// Only a snapshot while the other side is working
+    size_t size() const
+    {
+        const size_t readPos = m_readPos.load(std::memory_order_acquire);
+        const size_t writePos = m_writePos.load(std::memory_order_acquire);
+        return writePos - readPos;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return m_capacity; }
+
+private:
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_values;
+    char m_padding0[QUEUE_CACHE_LINE_SIZE];
+    // Producer side
+    std::atomic<size_t> m_writePos;
+    size_t m_cachedReadPos;
+    char m_padding1[QUEUE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    // Consumer side
+    std::atomic<size_t> m_readPos;
+    size_t m_cachedWritePos;
+    char m_padding2[QUEUE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    QueueWaiter m_waiter;
+
+    static size_t roundUpToPowerOfTwo(const size_t value)
+    {
+        size_t result = 2;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+};
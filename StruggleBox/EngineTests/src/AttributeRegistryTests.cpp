@@ -0,0 +1,217 @@
+#include "CPUTests.h"
+
+#include "AttributeKey.h"
+#include "Entity.h"
+#include "EntityAttributes.h"
+#include "EntityPrefab.h"
+#include "FileUtil.h"
+#include "glm/gtc/quaternion.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+// Interning has to give a name the same ID every time and different names different IDs,
+// also from several threads at once. Attributes loaded by plist name are the ones typed keys
+// reach on the entity. Once every ID is taken new names get INVALID_ATTRIBUTE_ID and their
+// keys still work through the name.
+
+static void testInterning()
+{
+	const size_t countBefore = AttributeRegistry::getCount();
+	const AttributeID health = AttributeRegistry::intern("CPUTests health");
+	TEST_CHECK(health != INVALID_ATTRIBUTE_ID);
+	TEST_CHECK(AttributeRegistry::intern("CPUTests health") == health);
+	TEST_CHECK(AttributeRegistry::intern(std::string("CPUTests ") + "health") == health);
+	TEST_CHECK(AttributeRegistry::getName(health) == "CPUTests health");
+
+	const AttributeID otherCase = AttributeRegistry::intern("CPUTests Health");
+	const AttributeID other = AttributeRegistry::intern("CPUTests healthy");
+	TEST_CHECK(otherCase != health && other != health && other != otherCase);
+	TEST_CHECK(AttributeRegistry::getCount() == countBefore + 3);
+
+	const AttributeKey<int> key("CPUTests health");
+	TEST_CHECK(key.isValid() && key.getID() == health && key.getName() == "CPUTests health");
+	TEST_CHECK(AttributeRegistry::getName((AttributeID)AttributeRegistry::getCount()).empty());
+
+	// Threads racing to intern the same names all have to agree on every ID
+	const int threadCount = 8;
+	const int nameCount = 500;
+	std::vector<std::vector<AttributeID>> threadIDs(threadCount, std::vector<AttributeID>(nameCount));
+	std::vector<std::thread> threads;
+	const size_t countBeforeThreads = AttributeRegistry::getCount();
+	for (int thread = 0; thread < threadCount; thread++)
+	{
+		threads.emplace_back([&threadIDs, thread]() {
+			for (int i = 0; i < nameCount; i++)
+			{
+				// Half the threads go backwards so they meet in the middle
+				const int name = thread % 2 ? nameCount - 1 - i : i;
+				threadIDs[thread][name] = AttributeRegistry::intern("CPUTests threaded " + std::to_string(name));
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	size_t wrongIDs = 0;
+	std::vector<bool> used(AttributeRegistry::getCount(), false);
+	for (int i = 0; i < nameCount; i++)
+	{
+		const AttributeID attributeID = threadIDs[0][i];
+		for (int thread = 1; thread < threadCount; thread++)
+		{
+			wrongIDs += threadIDs[thread][i] != attributeID ? 1 : 0;
+		}
+		wrongIDs += (attributeID < countBeforeThreads || attributeID >= used.size() || used[attributeID]) ? 1 : 0;
+		wrongIDs += AttributeRegistry::getName(attributeID) != "CPUTests threaded " + std::to_string(i) ? 1 : 0;
+		if (attributeID < used.size())
+		{
+			used[attributeID] = true;
+		}
+	}
+	TEST_CHECK(wrongIDs == 0);
+	TEST_CHECK(AttributeRegistry::getCount() == countBeforeThreads + nameCount);
+}
+
+// The name and the key have to reach the very same attribute
+template<typename T> static bool sameAttribute(Entity& entity, const AttributeKey<T>& key)
+{
+	if (entity.HasAttribute(key) != entity.HasAttribute(key.getName()))
+	{
+		return false;
+	}
+	if (!entity.HasAttribute(key.getName()))
+	{
+		return true;
+	}
+	return &entity.GetAttributeData(key) == &entity.GetAttributeDataPtr<T>(key.getName());
+}
+
+static void testEntityAccess()
+{
+	// Added by name, reached by key and the other way round
+	Entity entity("CPUTests");
+	entity.GetAttributeDataPtr<float>("CPUTests speed") = 3.5f;
+	const AttributeKey<float> speed("CPUTests speed");
+	TEST_CHECK(entity.HasAttribute(speed));
+	TEST_CHECK(entity.GetAttributeData(speed) == 3.5f);
+	TEST_CHECK(sameAttribute(entity, speed));
+
+	const AttributeKey<glm::vec3> offset("CPUTests offset");
+	TEST_CHECK(!entity.HasAttribute(offset));
+	entity.GetAttributeData(offset) = glm::vec3(1.f, 2.f, 3.f);
+	TEST_CHECK(entity.HasAttribute("CPUTests offset"));
+	TEST_CHECK(entity.GetAttributeDataPtr<glm::vec3>("CPUTests offset") == glm::vec3(1.f, 2.f, 3.f));
+	TEST_CHECK(entity.GetAttributes().count("CPUTests offset") == 1);
+	TEST_CHECK(sameAttribute(entity, offset));
+
+	// The constructor adds its attributes by name
+	TEST_CHECK(entity.GetAttributeData(ATTR_ID) == (int)entity.GetID());
+	TEST_CHECK(entity.GetAttributeData(ATTR_NAME) == "CPUTests");
+
+	// Every shipped entity file, loaded by the names in its plist
+	std::vector<std::string> fileNames;
+	FileUtil::GetFilesOfType(FileUtil::GetPath() + "Data/Entities/", ".plist", fileNames);
+	size_t wrongAttributes = 0;
+	size_t loadedFiles = 0;
+	for (const std::string& fileName : fileNames)
+	{
+		EntityPrefab prefab;
+		if (!prefab.load(FileUtil::GetPath() + "Data/Entities/" + fileName))
+		{
+			continue;
+		}
+		loadedFiles++;
+		Entity loaded(prefab.getName());
+		prefab.applyAttributes(loaded);
+		// Every attribute the file named got an ID
+		for (const auto& pair : loaded.GetAttributes())
+		{
+			const AttributeID attributeID = AttributeRegistry::intern(pair.first);
+			wrongAttributes += (attributeID == INVALID_ATTRIBUTE_ID || AttributeRegistry::getName(attributeID) != pair.first) ? 1 : 0;
+		}
+		wrongAttributes += sameAttribute(loaded, ATTR_ALIGNMENT) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_BB) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_BLOCKING) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_DAMAGE) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_EXPLOSION_FORCE) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_EXPLOSION_RADIUS) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_GRIP_OFFSET) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_HEALTH) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_ITEM_TYPE) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_LIFE_TIME) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_MAX_HEALTH) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_NAME) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_OBJECT_FILE) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_PARTICLE_FILE) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_PHYSICS) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_ROTATION) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_SCALE) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_SPHERE_RADIUS) ? 0 : 1;
+		wrongAttributes += sameAttribute(loaded, ATTR_TYPE) ? 0 : 1;
+	}
+	TEST_CHECK(loadedFiles > 0);
+	TEST_CHECK(wrongAttributes == 0);
+	Log::Info("[CPUTests] %zu entity files checked by name and key", loadedFiles);
+}
+
+// Takes every ID that's left, so it runs last. Names interned later in the run fall back to name lookups.
+static void testOutOfIDs()
+{
+	const AttributeID existing = AttributeRegistry::intern("CPUTests health");
+	size_t fillCount = 0;
+	while (AttributeRegistry::getCount() < INVALID_ATTRIBUTE_ID)
+	{
+		AttributeRegistry::intern("CPUTests filler " + std::to_string(fillCount++));
+	}
+	Log::Info("[CPUTests] Interning a name with every attribute ID taken");
+	TEST_CHECK(AttributeRegistry::intern("CPUTests overflow") == INVALID_ATTRIBUTE_ID);
+	TEST_CHECK(AttributeRegistry::getCount() == INVALID_ATTRIBUTE_ID);
+	TEST_CHECK(AttributeRegistry::intern("CPUTests health") == existing);
+	TEST_CHECK(AttributeRegistry::getName(INVALID_ATTRIBUTE_ID).empty());
+
+	// Keys without an ID still reach their attribute through the name
+	const AttributeKey<int> overflow("CPUTests overflow");
+	TEST_CHECK(!overflow.isValid());
+	Entity entity("CPUTests");
+	TEST_CHECK(!entity.HasAttribute(overflow));
+	entity.GetAttributeData(overflow) = 7;
+	TEST_CHECK(entity.HasAttribute(overflow) && entity.HasAttribute("CPUTests overflow"));
+	TEST_CHECK(entity.GetAttributeDataPtr<int>("CPUTests overflow") == 7);
+	TEST_CHECK(sameAttribute(entity, overflow));
+	entity.GetAttributeDataPtr<int>("CPUTests overflow") = 8;
+	TEST_CHECK(entity.GetAttributeData(overflow) == 8);
+	// Attributes interned before still go through their ID
+	TEST_CHECK(entity.GetAttributeData(ATTR_ID) == (int)entity.GetID());
+}
+
+static void benchmarkAccess()
+{
+	Entity entity("CPUTests");
+	entity.GetAttributeData(ATTR_POSITION) = glm::vec3(0.f);
+	entity.GetAttributeData(ATTR_HEALTH) = 1;
+	const size_t accessCount = 1000000;
+	float sum = 0.f;
+	CPUTests::benchmark("Entity attribute by name, per access", accessCount, [&]() {
+		for (size_t i = 0; i < accessCount; i++)
+		{
+			sum += entity.GetAttributeDataPtr<glm::vec3>("position").x + (float)entity.GetAttributeDataPtr<int>("health");
+		}
+	});
+	CPUTests::benchmark("Entity attribute by key, per access", accessCount, [&]() {
+		for (size_t i = 0; i < accessCount; i++)
+		{
+			sum += entity.GetAttributeData(ATTR_POSITION).x + (float)entity.GetAttributeData(ATTR_HEALTH);
+		}
+	});
+	Log::Info("[CPUTests] Attribute checksum %f", sum);
+}
+
+void AttributeRegistryTests(Allocator& allocator)
+{
+	testInterning();
+	testEntityAccess();
+	benchmarkAccess();
+	testOutOfIDs();
+}
@@ -0,0 +1,109 @@
+#include "CPUTests.h"
+
+#include "ArenaOperators.h"
+#include "TLSFAllocator.h"
+#include "ThreadCacheAllocator.h"
+#include "LogOutputSTD.h"
+#include "CoreDefines.h"
+#include <cstdio>
+#include <cstring>
+
+struct CPUTestSuite {
+	const char* name;
+	void (*run)(Allocator& allocator);
+};
+
+static const CPUTestSuite SUITES[] = {
+	{ "voxelchunkvertex", VoxelChunkVertexTests },
+	{ "spatialhashgrid", SpatialHashGridTests },
+	{ "concurrentqueue", ConcurrentQueueTests },
+	{ "frustum", FrustumTests },
+	{ "jobsystem", JobSystemTests },
+	{ "streamring", StreamRingTests },
+	{ "uniformblock", UniformBlockTests },
+	{ "voxelloader", VoxelLoaderTests },
+	{ "densemap", DenseEntityMapTests },
+	{ "scheduler", SystemSchedulerTests },
+	{ "prefab", EntityPrefabTests },
+	{ "tlsf", TLSFAllocatorTests },
+	{ "virtualheap", VirtualHeapTests },
+	{ "profiler", ProfilerTests },
+	{ "rendercommands", RenderCommandTests },
+	{ "voxelbricks", VoxelBrickTests },
+	{ "compressedvoxels", CompressedVoxelTests },
+	{ "regionstore", RegionStoreTests },
+	{ "attributes", AttributeRegistryTests },
+	{ "threadcache", ThreadCacheTests },
+	{ "chunkstreamer", ChunkStreamerTests },
+	{ "renderheadless", RenderHeadlessTests },
+#ifdef MEMORY_TRACKING
+	{ "memorytracker", MemoryTrackerTests },
+#endif
+};
+static const size_t SUITE_COUNT = sizeof(SUITES) / sizeof(SUITES[0]);
+
+uint32_t CPUTests::s_failures = 0;
+
+int CPUTests::runHeadless(const char* suiteName)
+{
+	LogOutputSTD output;
+	Log::AttachOutput(&output);
+
+	// Far smaller than the game heap, pages are only committed as the tests use them
+	TLSFAllocator* heapAllocator = allocator::newVirtualTLSFAllocator(1024ull * MEGA);
+	if (heapAllocator == nullptr)
+	{
+		Log::DetachOutput(&output);
+		return 1;
+	}
+	ThreadCacheAllocator* testAllocator = CUSTOM_NEW(ThreadCacheAllocator, (*heapAllocator))(*heapAllocator);
+
+	const uint32_t failures = run(*testAllocator, suiteName);
+
+	CUSTOM_DELETE(testAllocator, (*heapAllocator));
+	allocator::deleteVirtualTLSFAllocator(*heapAllocator);
+	Log::DetachOutput(&output);
+
+	return failures == 0 ? 0 : 1;
+}
+
+uint32_t CPUTests::run(Allocator& allocator, const char* suiteName)
+{
+	s_failures = 0;
+	size_t suitesRun = 0;
+	for (size_t i = 0; i < SUITE_COUNT; i++)
+	{
+		if (suiteName != nullptr && strcmp(suiteName, SUITES[i].name) != 0)
+		{
+			continue;
+		}
+		Log::Info("[CPUTests] Running %s", SUITES[i].name);
+		const uint32_t failuresBefore = s_failures;
+		SUITES[i].run(allocator);
+		Log::Info("[CPUTests] %s %s", SUITES[i].name, s_failures == failuresBefore ? "passed" : "FAILED");
+		suitesRun++;
+	}
+
+	if (suitesRun == 0)
+	{
+		Log::Error("[CPUTests] No test suite named %s", suiteName);
+		return 1;
+	}
+
+	Log::Info("[CPUTests] %zu suites run, %u failed checks", suitesRun, s_failures);
+	return s_failures;
+}
+
+void CPUTests::check(const bool passed, const char* expression, const char* file, const int line)
+{
+	if (passed)
+	{
+		return;
+	}
+	// Only the first few failures of a run are worth reading
+	if (s_failures < 20)
+	{
+		Log::Error("[CPUTests] Check failed: %s (%s:%i)", expression, file, line);
+	}
+	s_failures++;
+}
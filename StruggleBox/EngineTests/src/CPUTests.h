@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Log.h"
+#include "MemoryTracker.h"
+#include "Random.h"
+#include "Timer.h"
+#include "glm/glm.hpp"
+#include <cstddef>
+#include <cstdint>
+
+class Allocator;
+
+// Correctness checks against brute force reference results and CPU benchmarks,
+// nothing here needs a window or a GL context. Run from the command line with
+// EngineTests -cputests [suite] or from the tests menu, results go to the log.
+class CPUTests
+{
+public:
+	// Sets up its own heap and log output, returns the process exit code
+	static int runHeadless(const char* suiteName);
+	// Runs every suite, or only the named one, returns the number of failed checks
+	static uint32_t run(Allocator& allocator, const char* suiteName);
+
+	static void check(const bool passed, const char* expression, const char* file, const int line);
+
+	// Runs func a few times and logs the fastest run, returns its time in milliseconds
+	template <typename Func>
+	static double benchmark(const char* name, const size_t itemCount, const Func& func)
+	{
+		double best = 0.0;
+		for (int run = 0; run < BENCHMARK_RUNS; run++)
+		{
+			const double start = Timer::Milliseconds();
+			func();
+			const double time = Timer::Milliseconds() - start;
+			if (run == 0 || time < best)
+			{
+				best = time;
+			}
+		}
+		Log::Info("[CPUTests] %s: %.3f ms, %.2f ns per item", name, best, itemCount > 0 ? best * 1000000.0 / itemCount : 0.0);
+		return best;
+	}
+
+private:
+	static const int BENCHMARK_RUNS = 5;
+	static uint32_t s_failures;
+};
+
+#define TEST_CHECK(condition) CPUTests::check((condition), #condition, __FILE__, __LINE__)
+
+// Random test data, seed with Random::RandomSeed first so failures reproduce
+inline float randomRange(const float min, const float max)
+{
+	return min + (max - min) * (float)Random::RandomDouble();
+}
+
+inline glm::vec3 randomPosition(const float halfSize)
+{
+	return glm::vec3(randomRange(-halfSize, halfSize), randomRange(-halfSize, halfSize), randomRange(-halfSize, halfSize));
+}
+
+// Suites, one file each
+void VoxelChunkVertexTests(Allocator& allocator);
+void SpatialHashGridTests(Allocator& allocator);
+void ConcurrentQueueTests(Allocator& allocator);
+void FrustumTests(Allocator& allocator);
+void JobSystemTests(Allocator& allocator);
+void StreamRingTests(Allocator& allocator);
+void UniformBlockTests(Allocator& allocator);
+void VoxelLoaderTests(Allocator& allocator);
+void DenseEntityMapTests(Allocator& allocator);
+void SystemSchedulerTests(Allocator& allocator);
+void EntityPrefabTests(Allocator& allocator);
+void TLSFAllocatorTests(Allocator& allocator);
+void VirtualHeapTests(Allocator& allocator);
+void ProfilerTests(Allocator& allocator);
+void RenderCommandTests(Allocator& allocator);
+void VoxelBrickTests(Allocator& allocator);
+void CompressedVoxelTests(Allocator& allocator);
+void RegionStoreTests(Allocator& allocator);
+void AttributeRegistryTests(Allocator& allocator);
+void ThreadCacheTests(Allocator& allocator);
+void ChunkStreamerTests(Allocator& allocator);
+void RenderHeadlessTests(Allocator& allocator);
+#ifdef MEMORY_TRACKING
+void MemoryTrackerTests(Allocator& allocator);
+#endif
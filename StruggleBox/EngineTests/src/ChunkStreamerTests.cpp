@@ -0,0 +1,395 @@
+#include "CPUTests.h"
+
+#include "ChunkStreamer.h"
+#include "CompressedVoxelData.h"
+#include "FileUtil.h"
+#include "JobSystem.h"
+#include "RegionStore.h"
+#include "VoxelData.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+// Streams a small grid of chunks on the job system with a handler standing in for the renderer
+// and physics. Every chunk has to move forward through its stages, get uploaded once with the
+// mesh of its voxels, and keep the same voxels when it is evicted to the cache, comes back from
+// the cache, or is dropped and reloaded from the region files, edits included.
+
+static std::string chunksPath()
+{
+	return FileUtil::GetPath() + "CPUTests_Chunks/";
+}
+
+static void removeChunkFiles()
+{
+	std::vector<std::string> fileNames;
+	if (!FileUtil::DoesFolderExist(chunksPath()) ||
+		!FileUtil::GetFilesOfType(chunksPath(), ".region", fileNames))
+	{
+		return;
+	}
+	for (const std::string& fileName : fileNames)
+	{
+		remove((chunksPath() + fileName).c_str());
+	}
+}
+
+// The middle layer of the grid is stored up front with some terrain, everything else is generated flat land
+static bool isStoredUpFront(const Coord3D& coord)
+{
+	return coord.y == 0 && abs(coord.x) <= 1 && abs(coord.z) <= 1;
+}
+
+static void fillExpected(const Coord3D& coord, VoxelData& voxels)
+{
+	if (!isStoredUpFront(coord))
+	{
+		voxels.generateFlatLand(coord);
+		return;
+	}
+	for (int z = 0; z < CHUNK_SIZE; z++)
+	{
+		for (int x = 0; x < CHUNK_SIZE; x++)
+		{
+			const int height = 4 + (x * 7 + z * 3 + (coord.x + 1) * 5 + (coord.z + 1) * 11) % 9;
+			for (int y = 0; y < CHUNK_SIZE; y++)
+			{
+				voxels(x, y, z) = y < height ? (uint8_t)(1 + (x + z + coord.x + 1) % 4) : EMPTY_VOXEL;
+			}
+		}
+	}
+}
+
+// Stands in for the renderer and physics, checks every mesh it is handed
+class RecordingUploadHandler : public ChunkUploadHandler
+{
+public:
+	RecordingUploadHandler()
+		: nextDrawDataID(1)
+		, wrongUploads(0)
+		, releases(0)
+	{
+	}
+
+	void uploadChunk(TerrainChunk& chunk) override
+	{
+		if (chunk.state != ChunkState::Uploading || !chunk.voxels || !chunk.pendingVerts || chunk.aabbs.empty())
+		{
+			wrongUploads++;
+		}
+		else
+		{
+			std::vector<VoxelChunkVertexData> verts(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 18);
+			size_t vertexCount = 0;
+			chunk.voxels->createTriangleMeshPacked(verts.data(), vertexCount);
+			if (vertexCount == 0 ||
+				vertexCount != chunk.pendingVertexCount ||
+				memcmp(verts.data(), chunk.pendingVerts, vertexCount * sizeof(VoxelChunkVertexData)) != 0)
+			{
+				wrongUploads++;
+			}
+		}
+		if (chunk.drawDataID == 0)
+		{
+			chunk.drawDataID = nextDrawDataID++;
+			liveDrawData.insert(chunk.drawDataID);
+		}
+		uploads[chunk.coord]++;
+		vertexCounts[chunk.coord] = chunk.pendingVertexCount;
+	}
+
+	void releaseChunk(TerrainChunk& chunk) override
+	{
+		if (chunk.drawDataID)
+		{
+			liveDrawData.erase(chunk.drawDataID);
+			chunk.drawDataID = 0;
+			releases++;
+		}
+	}
+
+	std::map<Coord3D, int> uploads;
+	std::map<Coord3D, size_t> vertexCounts;
+	std::set<DrawDataID> liveDrawData;
+	DrawDataID nextDrawDataID;
+	size_t wrongUploads;
+	size_t releases;
+};
+
+// Keeps every worker busy so an update can be looked at before any of the jobs it started run
+class WorkerHold
+{
+public:
+	WorkerHold(JobSystem& jobSystem, const size_t workerCount)
+		: m_jobSystem(jobSystem)
+		, m_started(0)
+		, m_released(false)
+	{
+		for (size_t i = 0; i < workerCount; i++)
+		{
+			m_jobSystem.addJob(JobPriority::High, &m_counter, [this]() {
+				m_started++;
+				while (!m_released)
+				{
+					std::this_thread::yield();
+				}
+			});
+		}
+		while (m_started < workerCount)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	~WorkerHold()
+	{
+		m_released = true;
+		m_jobSystem.wait(m_counter);
+	}
+
+private:
+	JobSystem& m_jobSystem;
+	JobCounter m_counter;
+	std::atomic<size_t> m_started;
+	std::atomic<bool> m_released;
+};
+
+static size_t countChunks(const ChunkStreamer& streamer, const ChunkState state)
+{
+	size_t count = 0;
+	for (const auto& pair : streamer.getChunks())
+	{
+		count += pair.second.state == state ? 1 : 0;
+	}
+	return count;
+}
+
+struct StreamRun {
+	size_t updates;
+	size_t maxUploadsPerUpdate;
+	int32_t chunksEvicted;
+	size_t wrongTransitions;
+};
+
+// Updates until every chunk around the center is loaded, stages may only ever move forward
+static StreamRun streamUntilLoaded(ChunkStreamer& streamer, const Coord3D& center, const size_t maxCachedBytes, const double uploadBudgetMS)
+{
+	StreamRun run = { 0, 0, 0, 0 };
+	std::map<Coord3D, ChunkState> lastStates;
+	bool loaded = false;
+	while (!loaded && run.updates < 100000)
+	{
+		const ChunkStreamStats stats = streamer.update(center, 1, 2, maxCachedBytes, uploadBudgetMS);
+		run.updates++;
+		run.chunksEvicted += stats.chunksEvicted;
+		run.maxUploadsPerUpdate = std::max(run.maxUploadsPerUpdate, stats.chunksUploaded);
+
+		loaded = true;
+		for (const auto& pair : streamer.getChunks())
+		{
+			auto last = lastStates.find(pair.first);
+			if (last != lastStates.end() && (int)pair.second.state < (int)last->second)
+			{
+				run.wrongTransitions++;
+			}
+			lastStates[pair.first] = pair.second.state;
+			loaded &= pair.second.state == ChunkState::Loaded;
+		}
+		if (!loaded)
+		{
+			std::this_thread::yield();
+		}
+	}
+	TEST_CHECK(loaded);
+	return run;
+}
+
+// Compares the chunk's current voxels with what it should hold, plus an optional edit
+static bool hasExpectedVoxels(Allocator& allocator, const CompressedVoxelData* compressed, const Coord3D& coord, const uint8_t* edit = nullptr)
+{
+	if (!compressed)
+	{
+		return false;
+	}
+	VoxelData expected(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, allocator);
+	fillExpected(coord, expected);
+	if (edit)
+	{
+		expected(edit[0], edit[1], edit[2]) = edit[3];
+	}
+	VoxelData decoded(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, allocator);
+	compressed->decompress(decoded);
+	return memcmp(decoded.getData(), expected.getData(), expected.getMemoryUsage()) == 0;
+}
+
+static size_t countWrongChunks(Allocator& allocator, ChunkStreamer& streamer, const uint8_t* edit = nullptr)
+{
+	size_t wrongChunks = 0;
+	for (const auto& pair : streamer.getChunks())
+	{
+		const TerrainChunk& chunk = pair.second;
+		const bool isEdited = edit && pair.first == Coord3D(0, 0, 0);
+		wrongChunks += hasExpectedVoxels(allocator, chunk.compressed, pair.first, isEdited ? edit : nullptr) ? 0 : 1;
+		// Loaded chunks only keep their compressed voxels and the uploaded mesh
+		wrongChunks += (chunk.voxels || chunk.pendingVerts || !chunk.aabbs.empty()) ? 1 : 0;
+		wrongChunks += (chunk.compressed && !chunk.compressed->isEmpty()) != (chunk.drawDataID != 0) ? 1 : 0;
+	}
+	return wrongChunks;
+}
+
+static void testStreaming(Allocator& allocator)
+{
+	removeChunkFiles();
+	const size_t workerCount = 2;
+	JobSystem jobSystem(workerCount);
+	RegionStore regionStore(allocator, jobSystem);
+	regionStore.open(chunksPath());
+	VoxelData voxels(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, allocator);
+	for (int x = -1; x <= 1; x++)
+	{
+		for (int z = -1; z <= 1; z++)
+		{
+			fillExpected(Coord3D(x, 0, z), voxels);
+			regionStore.storeChunk(Coord3D(x, 0, z), voxels);
+		}
+	}
+	regionStore.flush();
+
+	RecordingUploadHandler handler;
+	const Coord3D home(0, 0, 0);
+	const Coord3D away(5, 0, 0);
+	const size_t largeCache = 64 * 1024 * 1024;
+	{
+		ChunkStreamer streamer(allocator, jobSystem, regionStore, handler);
+
+		// Everything starts out generating, a zero budget still uploads one chunk per update
+		{
+			WorkerHold hold(jobSystem, workerCount);
+			streamer.update(home, 1, 2, largeCache, 0.0);
+			TEST_CHECK(streamer.getChunks().size() == 27);
+			TEST_CHECK(countChunks(streamer, ChunkState::Generating) == 27);
+		}
+		StreamRun run = streamUntilLoaded(streamer, home, largeCache, 0.0);
+		TEST_CHECK(run.wrongTransitions == 0);
+		TEST_CHECK(run.maxUploadsPerUpdate == 1);
+		TEST_CHECK(handler.wrongUploads == 0);
+
+		// Flat land above y 0 is empty, those chunks are never meshed or uploaded
+		size_t wrongUploadCounts = 0;
+		for (const auto& pair : streamer.getChunks())
+		{
+			const int expectedUploads = pair.first.y > 0 ? 0 : 1;
+			wrongUploadCounts += handler.uploads[pair.first] != expectedUploads ? 1 : 0;
+			wrongUploadCounts += pair.second.vertexCount != handler.vertexCounts[pair.first] ? 1 : 0;
+		}
+		TEST_CHECK(wrongUploadCounts == 0);
+		TEST_CHECK(handler.liveDrawData.size() == 18);
+		TEST_CHECK(countWrongChunks(allocator, streamer) == 0);
+
+		// Leaving evicts every chunk into the cache, they keep their voxels there
+		run = streamUntilLoaded(streamer, away, largeCache, 100.0);
+		TEST_CHECK(run.wrongTransitions == 0);
+		TEST_CHECK(run.chunksEvicted == 27);
+		TEST_CHECK(handler.releases == 18);
+		TEST_CHECK(streamer.getNumCachedChunks() == 27);
+		size_t wrongCached = 0;
+		size_t cachedBytes = 0;
+		for (int x = -1; x <= 1; x++)
+		{
+			for (int y = -1; y <= 1; y++)
+			{
+				for (int z = -1; z <= 1; z++)
+				{
+					const CompressedVoxelData* cached = streamer.getCachedChunk(Coord3D(x, y, z));
+					wrongCached += hasExpectedVoxels(allocator, cached, Coord3D(x, y, z)) ? 0 : 1;
+					cachedBytes += cached ? cached->getMemoryUsage() : 0;
+				}
+			}
+		}
+		TEST_CHECK(wrongCached == 0);
+		TEST_CHECK(streamer.getCachedBytes() == cachedBytes);
+
+		// Coming back takes the chunks from the cache instead of generating them again
+		{
+			WorkerHold hold(jobSystem, workerCount);
+			streamer.update(home, 1, 2, largeCache, 100.0);
+			TEST_CHECK(countChunks(streamer, ChunkState::Generating) == 0);
+			TEST_CHECK(countChunks(streamer, ChunkState::Meshing) == 18);
+		}
+		run = streamUntilLoaded(streamer, home, largeCache, 100.0);
+		TEST_CHECK(run.wrongTransitions == 0 && handler.wrongUploads == 0);
+		TEST_CHECK(streamer.getNumCachedChunks() == 27);
+		TEST_CHECK(streamer.getCachedChunk(home) == nullptr);
+		TEST_CHECK(countWrongChunks(allocator, streamer) == 0);
+
+		// An edit re-meshes its chunk into the draw data it already has
+		const uint8_t edit[4] = { 3, 14, 5, 7 };
+		const DrawDataID editedDrawData = streamer.getChunk(home)->drawDataID;
+		const int uploadsBefore = handler.uploads[home];
+		TEST_CHECK(streamer.setVoxel(home, edit[0], edit[1], edit[2], edit[3]));
+		TEST_CHECK(!streamer.setVoxel(Coord3D(9, 9, 9), 0, 0, 0, 1));
+		streamer.update(home, 1, 2, largeCache, 100.0);
+		TEST_CHECK(streamer.getChunk(home)->state == ChunkState::Meshing);
+		run = streamUntilLoaded(streamer, home, largeCache, 100.0);
+		TEST_CHECK(run.wrongTransitions == 0 && handler.wrongUploads == 0);
+		TEST_CHECK(handler.uploads[home] == uploadsBefore + 1);
+		TEST_CHECK(streamer.getChunk(home)->drawDataID == editedDrawData);
+		TEST_CHECK(countWrongChunks(allocator, streamer, edit) == 0);
+
+		// Without a cache the chunks are dropped, the edited one goes to the region files
+		run = streamUntilLoaded(streamer, away, 0, 100.0);
+		TEST_CHECK(run.chunksEvicted == 27);
+		TEST_CHECK(streamer.getNumCachedChunks() == 0 && streamer.getCachedBytes() == 0);
+		regionStore.flush();
+		TEST_CHECK(regionStore.loadChunk(home, voxels));
+		TEST_CHECK(voxels(edit[0], edit[1], edit[2]) == edit[3]);
+
+		// So coming back reloads them, every voxel the same
+		{
+			WorkerHold hold(jobSystem, workerCount);
+			streamer.update(home, 1, 2, 0, 100.0);
+			TEST_CHECK(streamer.getChunks().size() == 27);
+			TEST_CHECK(countChunks(streamer, ChunkState::Generating) == 27);
+		}
+		run = streamUntilLoaded(streamer, home, 0, 100.0);
+		TEST_CHECK(run.wrongTransitions == 0 && handler.wrongUploads == 0);
+		TEST_CHECK(countWrongChunks(allocator, streamer, edit) == 0);
+
+		streamer.releaseAll();
+		TEST_CHECK(streamer.getChunks().empty() && streamer.getNumCachedChunks() == 0);
+	}
+	TEST_CHECK(handler.liveDrawData.empty());
+	regionStore.close();
+	removeChunkFiles();
+}
+
+static void benchmarkStreaming(Allocator& allocator)
+{
+	removeChunkFiles();
+	JobSystem jobSystem(std::max(2u, std::thread::hardware_concurrency()) - 1);
+	RegionStore regionStore(allocator, jobSystem);
+	regionStore.open(chunksPath());
+	RecordingUploadHandler handler;
+	{
+		ChunkStreamer streamer(allocator, jobSystem, regionStore, handler);
+		int step = 0;
+		// Each run moves the grid three chunks along x, so all of its chunks are new
+		CPUTests::benchmark("ChunkStreamer 3x3x3 grid moved by 3, per chunk", 27, [&]() {
+			step += 3;
+			streamUntilLoaded(streamer, Coord3D(step, -1, 0), 0, 100.0);
+		});
+		streamer.releaseAll();
+	}
+	regionStore.close();
+	removeChunkFiles();
+}
+
+void ChunkStreamerTests(Allocator& allocator)
+{
+	testStreaming(allocator);
+	benchmarkStreaming(allocator);
+}
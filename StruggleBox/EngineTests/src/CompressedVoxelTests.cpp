@@ -0,0 +1,226 @@
+#include "CPUTests.h"
+
+#include "ArenaOperators.h"
+#include "CompressedVoxelData.h"
+#include "Random.h"
+#include "VoxelData.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Volumes using a known number of types have to pick the smallest index width that fits
+// the palette, decode back to the same bytes and answer getVoxel like the plain array.
+// Single type volumes store no indices at all.
+
+// Fills the volume with exactly typeCount distinct types, returns the number of index bits expected
+static uint8_t fillWithTypes(VoxelData& voxels, const int typeCount)
+{
+	std::vector<uint8_t> types(256);
+	for (int type = 0; type < 256; type++)
+	{
+		types[type] = (uint8_t)type;
+	}
+	for (int i = 0; i < typeCount; i++)
+	{
+		std::swap(types[i], types[Random::RandomInt(i, 255)]);
+	}
+	const int voxelCount = voxels.getSizeX() * voxels.getSizeY() * voxels.getSizeZ();
+	for (int i = 0; i < voxelCount; i++)
+	{
+		// The first voxels use every type once, so all of them are in the palette
+		voxels[i] = types[i < typeCount ? i : Random::RandomInt(0, typeCount - 1)];
+	}
+	if (typeCount <= 1) { return 0; }
+	if (typeCount <= 2) { return 1; }
+	if (typeCount <= 4) { return 2; }
+	if (typeCount <= 16) { return 4; }
+	return 8;
+}
+
+static size_t expectedMemoryUsage(const size_t voxelCount, const uint8_t bitsPerVoxel, const int typeCount)
+{
+	if (bitsPerVoxel == 0)
+	{
+		return sizeof(CompressedVoxelData);
+	}
+	const size_t voxelsPerWord = 64 / bitsPerVoxel;
+	return sizeof(CompressedVoxelData) + (voxelCount + voxelsPerWord - 1) / voxelsPerWord * sizeof(uint64_t) + typeCount;
+}
+
+static bool matchesVoxels(const CompressedVoxelData& compressed, const VoxelData& voxels)
+{
+	for (int z = 0; z < voxels.getSizeZ(); z++)
+	{
+		for (int y = 0; y < voxels.getSizeY(); y++)
+		{
+			for (int x = 0; x < voxels.getSizeX(); x++)
+			{
+				if (compressed.getVoxel(x, y, z) != voxels.getData()[voxels.getIndex(x, y, z)])
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void testRoundTrips(Allocator& allocator)
+{
+	Random::RandomSeed(6);
+	// Every width and both ends of each palette range, in volumes that do and don't fill the last index word
+	const int typeCounts[] = { 2, 3, 4, 5, 16, 17, 100, 256 };
+	const glm::ivec3 sizes[] = { glm::ivec3(16, 16, 16), glm::ivec3(7, 5, 3), glm::ivec3(33, 17, 9), glm::ivec3(1, 1, 64) };
+	size_t wrongLayout = 0;
+	size_t wrongDecode = 0;
+	size_t wrongLookup = 0;
+	CompressedVoxelData compressed(allocator);
+	for (const glm::ivec3& size : sizes)
+	{
+		for (const int typeCount : typeCounts)
+		{
+			VoxelData voxels(size.x, size.y, size.z, allocator);
+			if (voxels.getMemoryUsage() < (size_t)typeCount)
+			{
+				continue;
+			}
+			const uint8_t bitsPerVoxel = fillWithTypes(voxels, typeCount);
+			// The same object is reused, compressing again replaces what it held
+			compressed.compress(voxels);
+			wrongLayout += (compressed.getBitsPerVoxel() != bitsPerVoxel ||
+				compressed.getPaletteSize() != typeCount ||
+				compressed.isUniform() ||
+				compressed.getSizeX() != size.x || compressed.getSizeY() != size.y || compressed.getSizeZ() != size.z ||
+				compressed.getMemoryUsage() != expectedMemoryUsage(voxels.getMemoryUsage(), bitsPerVoxel, typeCount)) ? 1 : 0;
+
+			VoxelData decoded(size.x, size.y, size.z, allocator);
+			decoded.fill(255);
+			decoded.clearDirtyBricks();
+			compressed.decompress(decoded);
+			wrongDecode += memcmp(decoded.getData(), voxels.getData(), voxels.getMemoryUsage()) != 0 ? 1 : 0;
+			wrongDecode += decoded.isBrickDirty(0) ? 0 : 1;
+			wrongLookup += matchesVoxels(compressed, voxels) ? 0 : 1;
+		}
+	}
+	TEST_CHECK(wrongLayout == 0);
+	TEST_CHECK(wrongDecode == 0);
+	TEST_CHECK(wrongLookup == 0);
+
+	// Terrain is what chunks look like most of the time, a few types in layers
+	VoxelData terrain(16, 16, 16, allocator);
+	for (int z = 0; z < 16; z++)
+	{
+		for (int y = 0; y < 16; y++)
+		{
+			for (int x = 0; x < 16; x++)
+			{
+				terrain(x, y, z) = y < 6 ? 3 : (y < 8 ? 2 : (y == 8 && (x + z) % 5 == 0 ? 1 : EMPTY_VOXEL));
+			}
+		}
+	}
+	compressed.compress(terrain);
+	TEST_CHECK(compressed.getBitsPerVoxel() == 2 && compressed.getPaletteSize() == 4);
+	// A quarter of the plain bytes, plus the palette and the object itself
+	TEST_CHECK(compressed.getMemoryUsage() * 3 < terrain.getMemoryUsage());
+	TEST_CHECK(matchesVoxels(compressed, terrain));
+}
+
+static void testUniform(Allocator& allocator)
+{
+	VoxelData voxels(16, 16, 16, allocator);
+	CompressedVoxelData compressed(allocator);
+
+	// Still empty, before anything was compressed
+	TEST_CHECK(compressed.isUniform() && compressed.isEmpty());
+	TEST_CHECK(compressed.getMemoryUsage() == sizeof(CompressedVoxelData));
+
+	voxels.clear();
+	compressed.compress(voxels);
+	TEST_CHECK(compressed.isUniform() && compressed.isEmpty());
+	TEST_CHECK(compressed.getBitsPerVoxel() == 0 && compressed.getPaletteSize() == 1);
+	TEST_CHECK(compressed.getUniformType() == EMPTY_VOXEL);
+	TEST_CHECK(compressed.getMemoryUsage() == sizeof(CompressedVoxelData));
+	TEST_CHECK(matchesVoxels(compressed, voxels));
+
+	// A full volume replacing a mixed one gives its indices back
+	fillWithTypes(voxels, 9);
+	compressed.compress(voxels);
+	TEST_CHECK(!compressed.isUniform() && compressed.getMemoryUsage() > sizeof(CompressedVoxelData));
+	voxels.fill(7);
+	compressed.compress(voxels);
+	TEST_CHECK(compressed.isUniform() && !compressed.isEmpty());
+	TEST_CHECK(compressed.getUniformType() == 7);
+	TEST_CHECK(compressed.getMemoryUsage() == sizeof(CompressedVoxelData));
+	TEST_CHECK(matchesVoxels(compressed, voxels));
+
+	VoxelData decoded(16, 16, 16, allocator);
+	compressed.decompress(decoded);
+	TEST_CHECK(memcmp(decoded.getData(), voxels.getData(), voxels.getMemoryUsage()) == 0);
+
+	// Only matching volumes are decoded into, the error that follows is expected
+	Log::Info("[CPUTests] Decompressing into a volume of the wrong size");
+	VoxelData wrongSize(16, 16, 8, allocator);
+	wrongSize.fill(1);
+	compressed.decompress(wrongSize);
+	TEST_CHECK(wrongSize.getData()[0] == 1 && wrongSize.getData()[wrongSize.getMemoryUsage() - 1] == 1);
+}
+
+static void benchmarkCompression(Allocator& allocator)
+{
+	Random::RandomSeed(7);
+	const int chunkCount = 64;
+	std::vector<VoxelData*> chunks;
+	std::vector<CompressedVoxelData*> compressed;
+	for (int i = 0; i < chunkCount; i++)
+	{
+		chunks.push_back(CUSTOM_NEW(VoxelData, allocator)(16, 16, 16, allocator));
+		fillWithTypes(*chunks.back(), 1 + i % 20);
+		compressed.push_back(CUSTOM_NEW(CompressedVoxelData, allocator)(allocator));
+	}
+	const size_t voxelCount = (size_t)chunkCount * 16 * 16 * 16;
+
+	CPUTests::benchmark("CompressedVoxelData compress 16^3, per voxel", voxelCount, [&]() {
+		for (int i = 0; i < chunkCount; i++)
+		{
+			compressed[i]->compress(*chunks[i]);
+		}
+	});
+	CPUTests::benchmark("CompressedVoxelData decompress 16^3, per voxel", voxelCount, [&]() {
+		for (int i = 0; i < chunkCount; i++)
+		{
+			compressed[i]->decompress(*chunks[i]);
+		}
+	});
+	size_t sum = 0;
+	CPUTests::benchmark("CompressedVoxelData getVoxel, per voxel", voxelCount, [&]() {
+		for (int i = 0; i < chunkCount; i++)
+		{
+			for (int z = 0; z < 16; z++)
+			{
+				for (int y = 0; y < 16; y++)
+				{
+					for (int x = 0; x < 16; x++)
+					{
+						sum += compressed[i]->getVoxel(x, y, z);
+					}
+				}
+			}
+		}
+	});
+	size_t compressedBytes = 0;
+	for (int i = 0; i < chunkCount; i++)
+	{
+		compressedBytes += compressed[i]->getMemoryUsage();
+		CUSTOM_DELETE(compressed[i], allocator);
+		CUSTOM_DELETE(chunks[i], allocator);
+	}
+	Log::Info("[CPUTests] %d chunks of 1 to 20 types: %zu bytes compressed, %zu plain (checksum %zu)",
+		chunkCount, compressedBytes, voxelCount, sum);
+}
+
+void CompressedVoxelTests(Allocator& allocator)
+{
+	testRoundTrips(allocator);
+	testUniform(allocator);
+	benchmarkCompression(allocator);
+}
@@ -1,8 +1,8 @@
 #include "ComputeTestScene.h"
 
 #include "FileUtil.h"
-#include "GLUtils.h"
 #include "Renderer2D.h"
+#include "RenderBackend.h"
 #include "RenderCore.h"
 #include "SceneManager.h"
 #include "Shader.h"
@@ -38,8 +38,9 @@ void ComputeTestScene::Initialize()
 {
 	GUIScene::Initialize();
 
-	GLuint textureHandle = GLUtils::GenerateTextureRGBAF(TEXTURE_WIDTH, TEXTURE_HEIGHT);
-	Texture2D* texture = CUSTOM_NEW(Texture2D, m_renderCore.getAllocator())(textureHandle, TEXTURE_WIDTH, TEXTURE_HEIGHT, GL_RGBA, GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, 0);
+	const TextureParams params = { TextureFormat::RGBA32F, TextureWrap::ClampToEdge, TextureFilter::Linear, false };
+	const uint32_t textureHandle = m_renderCore.getBackend().createTexture(params, TEXTURE_WIDTH, TEXTURE_HEIGHT, nullptr);
+	Texture2D* texture = CUSTOM_NEW(Texture2D, m_renderCore.getAllocator())(textureHandle, TEXTURE_WIDTH, TEXTURE_HEIGHT, params);
 	m_textureID = m_renderCore.getTextureCache().addTexture(texture, "ComputeTestTexture");
 	m_computeShaderID = m_renderCore.getShaderID("c_compute_test.csh");
 }
@@ -0,0 +1,319 @@
+#include "CPUTests.h"
+
+#include "MPMCQueue.h"
+#include "SPSCQueue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Stress tests for the lock-free queues: every value pushed has to be popped exactly once,
+// in push order per producer, including when producers and consumers sleep on a full or
+// empty queue. Benchmarked against the mutex queue they replaced.
+
+// The old ThreadSafeQueue, kept here as the benchmark baseline
+template <class T>
+class LockedQueue
+{
+public:
+	void push(const T& value)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push(value);
+		m_condition.notify_one();
+	}
+
+	void pop(T& value)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (m_queue.empty())
+		{
+			m_condition.wait(lock);
+		}
+		value = m_queue.front();
+		m_queue.pop();
+	}
+
+	bool tryPush(const T& value)
+	{
+		push(value);
+		return true;
+	}
+
+	bool tryPop(T& value)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_queue.empty())
+		{
+			return false;
+		}
+		value = m_queue.front();
+		m_queue.pop();
+		return true;
+	}
+
+private:
+	std::queue<T> m_queue;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+};
+
+// Producer index in the high bits, sequence number in the low ones
+static const int PRODUCER_SHIFT = 40;
+static const uint64_t SEQUENCE_MASK = (1ull << PRODUCER_SHIFT) - 1;
+
+// Each producer pushes itemsPerProducer values, consumers pop until all of them are claimed
+template <class Queue>
+static void transfer(
+	Queue& queue,
+	const int producerCount,
+	const int consumerCount,
+	const size_t itemsPerProducer,
+	const bool blocking,
+	std::vector<uint8_t>* deliveries)
+{
+	const size_t totalItems = producerCount * itemsPerProducer;
+	std::atomic<size_t> claimed(0);
+	std::atomic<uint32_t> orderErrors(0);
+	std::vector<std::thread> threads;
+
+	for (int producer = 0; producer < producerCount; producer++)
+	{
+		threads.emplace_back([&, producer]() {
+			for (size_t i = 0; i < itemsPerProducer; i++)
+			{
+				const uint64_t value = ((uint64_t)producer << PRODUCER_SHIFT) | i;
+				if (blocking)
+				{
+					queue.push(value);
+				}
+				else
+				{
+					while (!queue.tryPush(value))
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+		});
+	}
+
+	std::mutex deliveriesMutex;
+	for (int consumer = 0; consumer < consumerCount; consumer++)
+	{
+		threads.emplace_back([&]() {
+			std::vector<int64_t> lastSequence(producerCount, -1);
+			std::vector<uint64_t> received;
+			// Claiming before popping means no consumer waits for a value that never comes
+			while (claimed.fetch_add(1) < totalItems)
+			{
+				uint64_t value = 0;
+				if (blocking)
+				{
+					queue.pop(value);
+				}
+				else
+				{
+					while (!queue.tryPop(value))
+					{
+						std::this_thread::yield();
+					}
+				}
+				const int producer = (int)(value >> PRODUCER_SHIFT);
+				const int64_t sequence = (int64_t)(value & SEQUENCE_MASK);
+				if (producer >= producerCount || sequence <= lastSequence[producer])
+				{
+					orderErrors++;
+					continue;
+				}
+				lastSequence[producer] = sequence;
+				if (deliveries)
+				{
+					received.push_back(value);
+				}
+			}
+			if (deliveries)
+			{
+				std::lock_guard<std::mutex> lock(deliveriesMutex);
+				for (const uint64_t value : received)
+				{
+					const size_t index = (size_t)(value >> PRODUCER_SHIFT) * itemsPerProducer + (size_t)(value & SEQUENCE_MASK);
+					(*deliveries)[index]++;
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	TEST_CHECK(orderErrors == 0);
+}
+
+template <class Queue>
+static void checkExactlyOnce(Queue& queue, const int producerCount, const int consumerCount, const size_t itemsPerProducer, const bool blocking)
+{
+	std::vector<uint8_t> deliveries(producerCount * itemsPerProducer, 0);
+	transfer(queue, producerCount, consumerCount, itemsPerProducer, blocking, &deliveries);
+	size_t wrongCount = 0;
+	for (const uint8_t count : deliveries)
+	{
+		if (count != 1)
+		{
+			wrongCount++;
+		}
+	}
+	TEST_CHECK(wrongCount == 0);
+	TEST_CHECK(queue.size() == 0);
+}
+
+template <class Queue>
+static void testSingleThreaded(const char* name)
+{
+	Queue rounded(3);
+	TEST_CHECK(rounded.capacity() == 4);
+	Queue minimum(0);
+	TEST_CHECK(minimum.capacity() == 2);
+
+	Queue queue(8);
+	uint64_t value = 0;
+	TEST_CHECK(!queue.tryPop(value));
+	TEST_CHECK(queue.empty());
+
+	// Several laps around the ring, filled up each time
+	uint64_t nextPush = 0;
+	uint64_t nextPop = 0;
+	for (int lap = 0; lap < 5; lap++)
+	{
+		while (queue.tryPush(nextPush))
+		{
+			nextPush++;
+		}
+		TEST_CHECK(queue.size() == queue.capacity());
+		for (int i = 0; i < 5; i++)
+		{
+			TEST_CHECK(queue.tryPop(value));
+			TEST_CHECK(value == nextPop);
+			nextPop++;
+		}
+	}
+	while (queue.tryPop(value))
+	{
+		TEST_CHECK(value == nextPop);
+		nextPop++;
+	}
+	TEST_CHECK(nextPop == nextPush);
+	TEST_CHECK(queue.empty());
+
+	Log::Info("[CPUTests] %s single threaded checks done", name);
+}
+
+static void testMoveOnlyValues()
+{
+	MPMCQueue<std::unique_ptr<int>> mpmc(2);
+	TEST_CHECK(mpmc.tryPush(std::unique_ptr<int>(new int(7))));
+	std::unique_ptr<int> pointer;
+	TEST_CHECK(mpmc.tryPop(pointer) && pointer && *pointer == 7);
+
+	SPSCQueue<std::unique_ptr<int>> spsc(2);
+	TEST_CHECK(spsc.tryPush(std::unique_ptr<int>(new int(8))));
+	TEST_CHECK(spsc.tryPop(pointer) && pointer && *pointer == 8);
+}
+
+// A consumer asleep on an empty queue and a producer asleep on a full one both have to wake up
+template <class Queue>
+static void testBlockingWakeUp()
+{
+	const std::chrono::milliseconds delay(20);
+
+	Queue empty(2);
+	uint64_t popped = 0;
+	std::thread consumer([&]() { empty.pop(popped); });
+	std::this_thread::sleep_for(delay);
+	empty.push(42);
+	consumer.join();
+	TEST_CHECK(popped == 42);
+
+	Queue full(2);
+	TEST_CHECK(full.tryPush(1) && full.tryPush(2));
+	TEST_CHECK(!full.tryPush(3));
+	std::atomic<bool> pushed(false);
+	std::thread producer([&]() {
+		full.push(3);
+		pushed = true;
+	});
+	std::this_thread::sleep_for(delay);
+	TEST_CHECK(!pushed);
+	uint64_t value = 0;
+	full.pop(value);
+	producer.join();
+	TEST_CHECK(pushed && value == 1);
+	TEST_CHECK(full.tryPop(value) && value == 2);
+	TEST_CHECK(full.tryPop(value) && value == 3);
+}
+
+static void testStress()
+{
+	const int threadCounts[3] = { 1, 2, 4 };
+	for (const int threads : threadCounts)
+	{
+		MPMCQueue<uint64_t> queue(1024);
+		checkExactlyOnce(queue, threads, threads, 200000, false);
+		checkExactlyOnce(queue, threads, threads, 200000, true);
+	}
+	// Uneven sides
+	MPMCQueue<uint64_t> fanIn(64);
+	checkExactlyOnce(fanIn, 6, 1, 50000, true);
+	MPMCQueue<uint64_t> fanOut(64);
+	checkExactlyOnce(fanOut, 1, 6, 300000, true);
+
+	// Smallest capacity, nearly every push and pop has to wait for the other side
+	MPMCQueue<uint64_t> tiny(2);
+	checkExactlyOnce(tiny, 3, 3, 50000, true);
+
+	SPSCQueue<uint64_t> spsc(1024);
+	checkExactlyOnce(spsc, 1, 1, 1000000, false);
+	checkExactlyOnce(spsc, 1, 1, 1000000, true);
+	SPSCQueue<uint64_t> tinySPSC(2);
+	checkExactlyOnce(tinySPSC, 1, 1, 200000, true);
+}
+
+static void benchmarkQueues()
+{
+	const size_t itemsPerProducer = 200000;
+	const int threadCounts[3] = { 1, 2, 4 };
+	char name[96];
+	for (const int threads : threadCounts)
+	{
+		const size_t totalItems = threads * itemsPerProducer;
+		MPMCQueue<uint64_t> mpmc(1024);
+		snprintf(name, sizeof(name), "MPMCQueue %iP/%iC, per item", threads, threads);
+		CPUTests::benchmark(name, totalItems, [&]() { transfer(mpmc, threads, threads, itemsPerProducer, true, nullptr); });
+		LockedQueue<uint64_t> locked;
+		snprintf(name, sizeof(name), "ThreadSafeQueue %iP/%iC, per item", threads, threads);
+		CPUTests::benchmark(name, totalItems, [&]() { transfer(locked, threads, threads, itemsPerProducer, true, nullptr); });
+	}
+
+	const size_t spscItems = 1000000;
+	SPSCQueue<uint64_t> spsc(1024);
+	CPUTests::benchmark("SPSCQueue 1P/1C, per item", spscItems, [&]() { transfer(spsc, 1, 1, spscItems, true, nullptr); });
+	LockedQueue<uint64_t> locked;
+	CPUTests::benchmark("ThreadSafeQueue 1P/1C, per item", spscItems, [&]() { transfer(locked, 1, 1, spscItems, true, nullptr); });
+}
+
+void ConcurrentQueueTests(Allocator& allocator)
+{
+	testSingleThreaded<MPMCQueue<uint64_t>>("MPMCQueue");
+	testSingleThreaded<SPSCQueue<uint64_t>>("SPSCQueue");
+	testMoveOnlyValues();
+	testBlockingWakeUp<MPMCQueue<uint64_t>>();
+	testBlockingWakeUp<SPSCQueue<uint64_t>>();
+	testStress();
+	benchmarkQueues();
+}
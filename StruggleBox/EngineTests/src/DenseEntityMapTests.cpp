@@ -0,0 +1,182 @@
+#include "CPUTests.h"
+
+#include "DenseEntityMap.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+// The component stores have to behave exactly like the std::map<EntityID, Component*>
+// they replaced for any sequence of set, remove and get. Walking them is benchmarked
+// the way EntityManager::update walks a component family every frame.
+
+struct TestComponent {
+	EntityID owner;
+	float lifeTime;
+
+	void update(const float deltaTime)
+	{
+		lifeTime += deltaTime;
+	}
+};
+
+// Packed values, ids and slots have to agree with each other
+static void checkConsistent(const DenseEntityMap<TestComponent>& map, const std::map<EntityID, TestComponent*>& reference)
+{
+	TEST_CHECK(map.size() == reference.size());
+	TEST_CHECK(map.empty() == reference.empty());
+	size_t wrongCount = 0;
+	for (size_t index = 0; index < map.size(); index++)
+	{
+		const EntityID id = map.idAt(index);
+		auto it = reference.find(id);
+		if (it == reference.end() || it->second != map.valueAt(index) || map.get(id) != map.valueAt(index))
+		{
+			wrongCount++;
+		}
+	}
+	TEST_CHECK(wrongCount == 0);
+}
+
+static void testAgainstMap()
+{
+	Random::RandomSeed(10);
+	// Pointers are only compared, never dereferenced
+	std::vector<TestComponent> components(512);
+	DenseEntityMap<TestComponent> map;
+	std::map<EntityID, TestComponent*> reference;
+
+	TEST_CHECK(map.get(0) == nullptr && map.remove(0) == nullptr && !map.contains(12345));
+
+	size_t mismatches = 0;
+	for (int operation = 0; operation < 200000; operation++)
+	{
+		// Small IDs collide often, a few big ones make the slot table grow
+		const EntityID id = Random::RandomInt(0, 99) < 98 ? (EntityID)Random::RandomInt(0, 2000) : (EntityID)Random::RandomInt(0, 100000);
+		const int action = Random::RandomInt(0, 9);
+		if (action < 4)
+		{
+			TestComponent* value = &components[Random::RandomInt(0, (int)components.size() - 1)];
+			map.set(id, value);
+			reference[id] = value;
+		}
+		else if (action < 7)
+		{
+			auto it = reference.find(id);
+			TestComponent* expected = it != reference.end() ? it->second : nullptr;
+			if (it != reference.end())
+			{
+				reference.erase(it);
+			}
+			mismatches += map.remove(id) != expected ? 1 : 0;
+		}
+		else
+		{
+			auto it = reference.find(id);
+			TestComponent* expected = it != reference.end() ? it->second : nullptr;
+			mismatches += map.get(id) != expected ? 1 : 0;
+			mismatches += map.contains(id) != (it != reference.end()) ? 1 : 0;
+		}
+		if (operation % 20000 == 0)
+		{
+			checkConsistent(map, reference);
+		}
+	}
+	TEST_CHECK(mismatches == 0);
+	checkConsistent(map, reference);
+
+	// Iteration visits every value exactly once
+	std::vector<TestComponent*> visited(map.begin(), map.end());
+	std::vector<TestComponent*> expected;
+	for (const auto& pair : reference)
+	{
+		expected.push_back(pair.second);
+	}
+	std::sort(visited.begin(), visited.end());
+	std::sort(expected.begin(), expected.end());
+	TEST_CHECK(visited == expected);
+
+	map.clear();
+	TEST_CHECK(map.empty() && map.get(1) == nullptr);
+	map.set(1, &components[0]);
+	TEST_CHECK(map.get(1) == &components[0] && map.size() == 1);
+}
+
+static void benchmarkIteration()
+{
+	// Components allocated and registered in a random order, as entities come and go in a game
+	Random::RandomSeed(11);
+	const size_t componentCount = 5000;
+	std::vector<std::unique_ptr<TestComponent>> components;
+	std::vector<EntityID> ids;
+	for (size_t i = 0; i < componentCount; i++)
+	{
+		ids.push_back((EntityID)(i + 1));
+	}
+	for (size_t i = componentCount - 1; i > 0; i--)
+	{
+		std::swap(ids[i], ids[Random::RandomInt(0, (int)i)]);
+	}
+	DenseEntityMap<TestComponent> dense;
+	std::map<EntityID, TestComponent*> nodeMap;
+	for (const EntityID id : ids)
+	{
+		components.emplace_back(new TestComponent{ id, 0.f });
+		dense.set(id, components.back().get());
+		nodeMap[id] = components.back().get();
+	}
+
+	const int frameCount = 1000;
+	CPUTests::benchmark("std::map component update, per component", componentCount * frameCount, [&]() {
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			for (auto& pair : nodeMap)
+			{
+				pair.second->update(0.016f);
+			}
+		}
+	});
+	CPUTests::benchmark("DenseEntityMap component update, per component", componentCount * frameCount, [&]() {
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			for (size_t index = 0; index < dense.size(); index++)
+			{
+				dense.valueAt(index)->update(0.016f);
+			}
+		}
+	});
+
+	// Both walks reached every component the same number of times
+	const float expected = components[0]->lifeTime;
+	size_t wrongCount = 0;
+	for (const std::unique_ptr<TestComponent>& component : components)
+	{
+		wrongCount += component->lifeTime != expected ? 1 : 0;
+	}
+	TEST_CHECK(wrongCount == 0);
+
+	const size_t lookupCount = 1000000;
+	size_t found = 0;
+	CPUTests::benchmark("std::map component lookup, per lookup", lookupCount, [&]() {
+		found = 0;
+		for (size_t i = 0; i < lookupCount; i++)
+		{
+			found += nodeMap.find(ids[i % componentCount]) != nodeMap.end() ? 1 : 0;
+		}
+	});
+	TEST_CHECK(found == lookupCount);
+	CPUTests::benchmark("DenseEntityMap component lookup, per lookup", lookupCount, [&]() {
+		found = 0;
+		for (size_t i = 0; i < lookupCount; i++)
+		{
+			found += dense.get(ids[i % componentCount]) != nullptr ? 1 : 0;
+		}
+	});
+	TEST_CHECK(found == lookupCount);
+}
+
+void DenseEntityMapTests(Allocator& allocator)
+{
+	testAgainstMap();
+	benchmarkIteration();
+}
@@ -0,0 +1,238 @@
+#include "CPUTests.h"
+
+#include "Dictionary.h"
+#include "Entity.h"
+#include "EntityPrefab.h"
+#include "FileUtil.h"
+#include "glm/gtc/quaternion.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+// Every shipped entity file spawned through its compiled prefab has to end up with the
+// same attributes, values and components as the plist loop EntityManager::addEntity
+// used to run on every spawn, which is kept here as the reference and the benchmark baseline.
+
+static std::string entitiesPath()
+{
+	return FileUtil::GetPath() + "Data/Entities/";
+}
+
+// The old EntityManager::addEntity loop, components collected instead of added
+static bool loadFromDictionary(Entity& entity, const std::string& filePath, std::string& name, std::vector<PrefabComponent>& components)
+{
+	Dictionary dict;
+	if (!dict.loadRootSubDictFromFile(filePath.c_str()))
+	{
+		return false;
+	}
+	dict.stepIntoSubDictWithKey("Attributes");
+	name = dict.getStringForKey("sname");
+	for (unsigned int i = 0; i < dict.getNumKeys(); i++)
+	{
+		const std::string name = dict.getKey(i);
+		if ( name.compare(0, 1,"b") == 0 ) {
+			bool data = dict.getBoolForKey(name.c_str());
+			entity.GetAttributeDataPtr<bool>(name.substr(1)) = data;
+		} else if ( name.compare(0, 1,"i") == 0 ) {
+			int data = dict.getIntegerForKey(name.c_str());
+			entity.GetAttributeDataPtr<int>(name.substr(1)) = data;
+		} else if ( name.compare(0, 1,"u") == 0 ) {
+			int data = dict.getIntegerForKey(name.c_str());
+			entity.GetAttributeDataPtr<unsigned int>(name.substr(1)) = data;
+		} else if ( name.compare(0, 1,"f") == 0 ) {
+			float data = dict.getFloatForKey(name.c_str());
+			entity.GetAttributeDataPtr<float>(name.substr(1)) = data;
+		} else if ( name.compare(0, 1,"d") == 0 ) {
+			float data = dict.getFloatForKey(name.c_str());
+			entity.GetAttributeDataPtr<double>(name.substr(1)) = data;
+		} else if ( name.compare(0, 1,"s") == 0 ) {
+			std::string data = dict.getStringForKey(name.c_str());
+			entity.GetAttributeDataPtr<std::string>(name.substr(1)) = data;
+		} else if ( name.compare(0, 2,"v2") == 0 ) {
+			float data = dict.getFloatForKey(name.c_str());
+			std::string attrName = name.substr(2, name.length()-3);
+			glm::vec2& attr = entity.GetAttributeDataPtr<glm::vec2>(attrName);
+			if ( name.compare(name.length()-1, 1, "X") == 0 ) { attr.x = data; }
+			else if ( name.compare(name.length()-1, 1, "Y") == 0 ) { attr.y = data; }
+		} else if ( name.compare(0, 2,"v3") == 0 ) {
+			float data = dict.getFloatForKey(name.c_str());
+			std::string attrName = name.substr(2, name.length()-3);
+			glm::vec3& attr = entity.GetAttributeDataPtr<glm::vec3>(attrName);
+			if ( name.compare(name.length()-1, 1, "X") == 0 ) { attr.x = data; }
+			else if ( name.compare(name.length()-1, 1, "Y") == 0 ) { attr.y = data; }
+			else if ( name.compare(name.length()-1, 1, "Z") == 0 ) { attr.z = data; }
+		} else if ( name.compare(0, 2,"v4") == 0 ) {
+			float data = dict.getFloatForKey(name.c_str());
+			std::string attrName = name.substr(2, name.length()-3);
+			glm::vec4& attr = entity.GetAttributeDataPtr<glm::vec4>(attrName);
+			if ( name.compare(name.length()-1, 1, "X") == 0 ) { attr.x = data; }
+			else if ( name.compare(name.length()-1, 1, "Y") == 0 ) { attr.y = data; }
+			else if ( name.compare(name.length()-1, 1, "Z") == 0 ) { attr.z = data; }
+			else if ( name.compare(name.length()-1, 1, "W") == 0 ) { attr.w = data; }
+		} else if ( name.compare(0, 2,"q4") == 0 ) {
+			float data = dict.getFloatForKey(name.c_str());
+			std::string attrName = name.substr(2, name.length()-3);
+			glm::quat& attr = entity.GetAttributeDataPtr<glm::quat>(attrName);
+			if ( name.compare(name.length()-1, 1, "X") == 0 ) { attr.x = data; }
+			else if ( name.compare(name.length()-1, 1, "Y") == 0 ) { attr.y = data; }
+			else if ( name.compare(name.length()-1, 1, "Z") == 0 ) { attr.z = data; }
+			else if ( name.compare(name.length()-1, 1, "W") == 0 ) { attr.w = data; }
+		}
+	}
+	dict.stepBackToRootSubDict();
+	dict.stepIntoSubDictWithKey("Components");
+	for (unsigned int i = 0; i < dict.getNumKeys(); i++)
+	{
+		PrefabComponent component = { dict.getKey(i), false, glm::vec3() };
+		if ( component.family == "Light3D" && dict.stepIntoSubDictWithKey("Light3D") )
+		{
+			for (unsigned int j = 0; j < dict.getNumKeys(); j++)
+			{
+				const std::string subName = dict.getKey(j);
+				if (subName == "v3offsetX") { component.offset.x = dict.getFloatForKey(subName.c_str()); }
+				else if (subName == "v3offsetY") { component.offset.y = dict.getFloatForKey(subName.c_str()); }
+				else if (subName == "v3offsetZ") { component.offset.z = dict.getFloatForKey(subName.c_str()); }
+			}
+			component.hasOffset = true;
+			dict.stepOutOfSubDict();
+		}
+		components.push_back(component);
+	}
+	return true;
+}
+
+// Same type and value, and the prefab's attribute is also the one in its ID slot
+template<typename T>
+static bool isSameAttribute(Entity& prefabEntity, const std::string& name, Attribute* prefabAttribute, Attribute* reference)
+{
+	if (!prefabAttribute->IsType<T>())
+	{
+		return false;
+	}
+	if (!(prefabAttribute->as<T>() == reference->as<T>()))
+	{
+		return false;
+	}
+	return &prefabEntity.GetAttributeData<T>(AttributeRegistry::intern(name), name) == &prefabAttribute->as<T>();
+}
+
+static bool isSameAttribute(Entity& prefabEntity, const std::string& name, Attribute* prefabAttribute, Attribute* reference)
+{
+	if (reference->IsType<bool>()) { return isSameAttribute<bool>(prefabEntity, name, prefabAttribute, reference); }
+	if (reference->IsType<int>()) { return isSameAttribute<int>(prefabEntity, name, prefabAttribute, reference); }
+	if (reference->IsType<unsigned int>()) { return isSameAttribute<unsigned int>(prefabEntity, name, prefabAttribute, reference); }
+	if (reference->IsType<float>()) { return isSameAttribute<float>(prefabEntity, name, prefabAttribute, reference); }
+	if (reference->IsType<double>()) { return isSameAttribute<double>(prefabEntity, name, prefabAttribute, reference); }
+	if (reference->IsType<std::string>()) { return isSameAttribute<std::string>(prefabEntity, name, prefabAttribute, reference); }
+	if (reference->IsType<glm::vec2>()) { return isSameAttribute<glm::vec2>(prefabEntity, name, prefabAttribute, reference); }
+	if (reference->IsType<glm::vec3>()) { return isSameAttribute<glm::vec3>(prefabEntity, name, prefabAttribute, reference); }
+	if (reference->IsType<glm::vec4>()) { return isSameAttribute<glm::vec4>(prefabEntity, name, prefabAttribute, reference); }
+	if (reference->IsType<glm::quat>()) { return isSameAttribute<glm::quat>(prefabEntity, name, prefabAttribute, reference); }
+	return false;
+}
+
+static void testShippedEntities()
+{
+	std::vector<std::string> fileNames;
+	FileUtil::GetFilesOfType(entitiesPath(), ".plist", fileNames);
+	TEST_CHECK(!fileNames.empty());
+
+	size_t attributeCount = 0;
+	size_t componentCount = 0;
+	for (const std::string& fileName : fileNames)
+	{
+		const std::string filePath = entitiesPath() + fileName;
+		Entity reference("Reference");
+		std::string referenceName;
+		std::vector<PrefabComponent> referenceComponents;
+		TEST_CHECK(loadFromDictionary(reference, filePath, referenceName, referenceComponents));
+
+		EntityPrefab prefab;
+		TEST_CHECK(prefab.load(filePath));
+		Entity spawned("Spawned");
+		prefab.applyAttributes(spawned);
+		TEST_CHECK(prefab.getName() == referenceName);
+
+		// Same names, same types, same values
+		std::map<const std::string, Attribute*>& referenceAttributes = reference.GetAttributes();
+		std::map<const std::string, Attribute*>& spawnedAttributes = spawned.GetAttributes();
+		TEST_CHECK(spawnedAttributes.size() == referenceAttributes.size());
+		size_t wrongCount = 0;
+		for (const auto& pair : referenceAttributes)
+		{
+			// Every entity starts with its own ID, unless the file sets one
+			if (pair.first == "ID" && pair.second->as<int>() == (int)reference.GetID())
+			{
+				TEST_CHECK(spawned.GetAttributeDataPtr<int>("ID") == (int)spawned.GetID());
+				continue;
+			}
+			auto it = spawnedAttributes.find(pair.first);
+			if (it == spawnedAttributes.end() || !isSameAttribute(spawned, pair.first, it->second, pair.second))
+			{
+				Log::Error("[CPUTests] %s attribute %s differs from the plist", fileName.c_str(), pair.first.c_str());
+				wrongCount++;
+			}
+		}
+		TEST_CHECK(wrongCount == 0);
+		attributeCount += referenceAttributes.size();
+
+		// Same components in the same order, Light3D with the same offset
+		const std::vector<PrefabComponent>& components = prefab.getComponents();
+		TEST_CHECK(components.size() == referenceComponents.size());
+		for (size_t i = 0; i < components.size() && i < referenceComponents.size(); i++)
+		{
+			TEST_CHECK(components[i].family == referenceComponents[i].family);
+			TEST_CHECK(components[i].hasOffset == referenceComponents[i].hasOffset);
+			TEST_CHECK(components[i].offset == referenceComponents[i].offset);
+		}
+		componentCount += components.size();
+
+		// Spawning onto an entity that already has the attributes overwrites them
+		reference.GetAttributeDataPtr<std::string>("name") = "Changed";
+		prefab.applyAttributes(reference);
+		TEST_CHECK(reference.GetAttributes().size() == referenceAttributes.size());
+		if (reference.HasAttribute("name"))
+		{
+			TEST_CHECK(reference.GetAttributeDataPtr<std::string>("name") == spawned.GetAttributeDataPtr<std::string>("name"));
+		}
+	}
+	Log::Info("[CPUTests] %zu entity files, %zu attributes and %zu components matched the plist loop",
+		fileNames.size(), attributeCount, componentCount);
+}
+
+static void benchmarkSpawn()
+{
+	const std::string filePath = entitiesPath() + "Player.plist";
+	EntityPrefab prefab;
+	TEST_CHECK(prefab.load(filePath));
+
+	const size_t spawnCount = 200;
+	size_t attributeCount = 0;
+	CPUTests::benchmark("Player spawn from the plist, per spawn", spawnCount, [&]() {
+		for (size_t i = 0; i < spawnCount; i++)
+		{
+			Entity entity("Player");
+			std::string name;
+			std::vector<PrefabComponent> components;
+			loadFromDictionary(entity, filePath, name, components);
+			attributeCount = entity.GetAttributes().size();
+		}
+	});
+	size_t prefabAttributeCount = 0;
+	CPUTests::benchmark("Player spawn from the prefab, per spawn", spawnCount, [&]() {
+		for (size_t i = 0; i < spawnCount; i++)
+		{
+			Entity entity(prefab.getName());
+			prefab.applyAttributes(entity);
+			prefabAttributeCount = entity.GetAttributes().size();
+		}
+	});
+	TEST_CHECK(attributeCount != 0 && attributeCount == prefabAttributeCount);
+}
+
+void EntityPrefabTests(Allocator& allocator)
+{
+	testShippedEntities();
+	benchmarkSpawn();
+}
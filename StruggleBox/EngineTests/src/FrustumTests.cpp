@@ -0,0 +1,241 @@
+#include "CPUTests.h"
+
+#include "Frustum.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <cmath>
+#include <vector>
+
+// Checks the frustum tests against a brute force reference: planes rebuilt from the
+// matrix in double precision, and points sampled in clip space which must never be
+// culled. The batch culls have to give exactly the answers of the single tests.
+
+static glm::mat4 randomViewProjection()
+{
+	const glm::mat4 projection = glm::perspective(glm::radians(randomRange(40.f, 100.f)), randomRange(1.f, 2.4f), 0.1f, randomRange(50.f, 400.f));
+	const glm::vec3 eye = randomPosition(200.f);
+	glm::vec3 target = randomPosition(200.f);
+	if (glm::length(target - eye) < 1.f)
+	{
+		target = eye + glm::vec3(0.f, 0.f, -10.f);
+	}
+	return projection * glm::lookAt(eye, target, glm::vec3(0.f, 1.f, 0.f));
+}
+
+// Gribb/Hartmann plane extraction with its own normalization, in doubles
+struct ReferencePlanes {
+	glm::dvec4 planes[Frustum::PLANE_COUNT];
+
+	ReferencePlanes(const glm::mat4& viewProjection)
+	{
+		const glm::dmat4 m = glm::dmat4(viewProjection);
+		const glm::dvec4 rows[4] = {
+			glm::dvec4(m[0][0], m[1][0], m[2][0], m[3][0]),
+			glm::dvec4(m[0][1], m[1][1], m[2][1], m[3][1]),
+			glm::dvec4(m[0][2], m[1][2], m[2][2], m[3][2]),
+			glm::dvec4(m[0][3], m[1][3], m[2][3], m[3][3]),
+		};
+		for (uint32_t i = 0; i < Frustum::PLANE_COUNT; i++)
+		{
+			const glm::dvec4 plane = (i % 2) ? rows[3] - rows[i / 2] : rows[3] + rows[i / 2];
+			planes[i] = plane / glm::length(glm::dvec3(plane));
+		}
+	}
+
+	// Signed distance to the nearest plane the object is past, positive means fully outside it
+	double sphereOutside(const glm::vec3& center, const float radius) const
+	{
+		double outside = -1e30;
+		for (uint32_t i = 0; i < Frustum::PLANE_COUNT; i++)
+		{
+			const double distance = glm::dot(glm::dvec3(planes[i]), glm::dvec3(center)) + planes[i].w;
+			outside = glm::max(outside, -distance - radius);
+		}
+		return outside;
+	}
+
+	double boxOutside(const BoundingBox& box) const
+	{
+		double outside = -1e30;
+		for (uint32_t i = 0; i < Frustum::PLANE_COUNT; i++)
+		{
+			const glm::dvec3 normal = glm::dvec3(planes[i]);
+			const double distance = glm::dot(normal, glm::dvec3(box.center)) + planes[i].w;
+			const double reach = glm::dot(glm::abs(normal), glm::dvec3(box.extents));
+			outside = glm::max(outside, -distance - reach);
+		}
+		return outside;
+	}
+};
+
+static bool isInsideClipSpace(const glm::mat4& viewProjection, const glm::vec3& point)
+{
+	const glm::vec4 clip = viewProjection * glm::vec4(point, 1.f);
+	const float limit = clip.w * 0.999f;
+	return clip.w > 0.f && std::fabs(clip.x) < limit && std::fabs(clip.y) < limit && std::fabs(clip.z) < limit;
+}
+
+static void testAgainstBruteForce()
+{
+	Random::RandomSeed(25);
+	// Objects within this distance of a plane are too close to call in floats
+	const double tolerance = 1e-3;
+	size_t visibleCount = 0;
+	size_t objectCount = 0;
+
+	for (int frame = 0; frame < 200; frame++)
+	{
+		const glm::mat4 viewProjection = randomViewProjection();
+		const Frustum frustum(viewProjection);
+		const ReferencePlanes reference(viewProjection);
+
+		for (uint32_t i = 0; i < Frustum::PLANE_COUNT; i++)
+		{
+			TEST_CHECK(std::fabs(glm::length(glm::vec3(frustum.getPlane(i))) - 1.f) < 1e-4f);
+		}
+
+		// Odd count so the batch tests run their scalar tail too
+		const size_t count = 1003;
+		std::vector<glm::vec4> spheres(count);
+		std::vector<BoundingBox> boxes(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			spheres[i] = glm::vec4(randomPosition(200.f), randomRange(0.1f, 20.f));
+			boxes[i].center = randomPosition(200.f);
+			boxes[i].extents = glm::vec3(randomRange(0.1f, 20.f), randomRange(0.1f, 20.f), randomRange(0.1f, 20.f));
+		}
+
+		// Bits set beforehand have to survive the batch culls
+		std::vector<uint32_t> sphereVisibility(count, 4);
+		std::vector<uint32_t> boxVisibility(count, 8);
+		frustum.cullSpheres(spheres.data(), count, sphereVisibility.data(), 1);
+		frustum.cullBoxes(boxes.data(), count, boxVisibility.data(), 2);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const glm::vec3 center = glm::vec3(spheres[i]);
+			const float radius = spheres[i].w;
+			const bool sphereVisible = frustum.intersectsSphere(center, radius);
+			const bool boxVisible = frustum.intersectsBox(boxes[i]);
+
+			TEST_CHECK(((sphereVisibility[i] & 1) != 0) == sphereVisible);
+			TEST_CHECK(((boxVisibility[i] & 2) != 0) == boxVisible);
+			TEST_CHECK((sphereVisibility[i] & 4) != 0 && (boxVisibility[i] & 8) != 0);
+
+			const double sphereOutside = reference.sphereOutside(center, radius);
+			if (std::fabs(sphereOutside) > tolerance)
+			{
+				TEST_CHECK(sphereVisible == (sphereOutside < 0.0));
+			}
+			const double boxOutside = reference.boxOutside(boxes[i]);
+			if (std::fabs(boxOutside) > tolerance)
+			{
+				TEST_CHECK(boxVisible == (boxOutside < 0.0));
+			}
+
+			// Culling may keep too much but never drop anything that's on screen
+			if (isInsideClipSpace(viewProjection, center))
+			{
+				TEST_CHECK(sphereVisible);
+				TEST_CHECK(frustum.containsPoint(center));
+			}
+			for (int corner = 0; corner < 8; corner++)
+			{
+				const glm::vec3 sign = glm::vec3((corner & 1) ? 1.f : -1.f, (corner & 2) ? 1.f : -1.f, (corner & 4) ? 1.f : -1.f);
+				const glm::vec3 point = boxes[i].center + boxes[i].extents * sign;
+				if (isInsideClipSpace(viewProjection, point))
+				{
+					TEST_CHECK(boxVisible);
+					TEST_CHECK(frustum.containsPoint(point));
+				}
+			}
+			visibleCount += boxVisible ? 1 : 0;
+			objectCount++;
+		}
+	}
+	Log::Info("[CPUTests] %zu of %zu random boxes visible", visibleCount, objectCount);
+
+	// Every batch size around the group of four
+	const Frustum frustum(randomViewProjection());
+	for (size_t count = 0; count <= 9; count++)
+	{
+		std::vector<BoundingBox> boxes(count);
+		std::vector<glm::vec4> spheres(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			boxes[i].center = randomPosition(100.f);
+			boxes[i].extents = glm::vec3(10.f);
+			spheres[i] = glm::vec4(boxes[i].center, 10.f);
+		}
+		std::vector<uint32_t> visibility(count + 1, 0);
+		frustum.cullBoxes(boxes.data(), count, visibility.data(), 1);
+		frustum.cullSpheres(spheres.data(), count, visibility.data(), 2);
+		for (size_t i = 0; i < count; i++)
+		{
+			TEST_CHECK(((visibility[i] & 1) != 0) == frustum.intersectsBox(boxes[i]));
+			TEST_CHECK(((visibility[i] & 2) != 0) == frustum.intersectsSphere(glm::vec3(spheres[i]), spheres[i].w));
+		}
+		TEST_CHECK(visibility[count] == 0);
+	}
+
+	// The default frustum keeps everything
+	const Frustum everything;
+	const BoundingBox farBox = { glm::vec3(1e6f, -1e6f, 1e6f), glm::vec3(1.f) };
+	TEST_CHECK(everything.intersectsBox(farBox));
+	TEST_CHECK(everything.intersectsSphere(glm::vec3(-1e6f), 0.f));
+	TEST_CHECK(everything.containsPoint(glm::vec3(0.f, 1e6f, 0.f)));
+}
+
+static void benchmarkCulling()
+{
+	Random::RandomSeed(1);
+	const Frustum frustum(glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 250.f));
+	const size_t count = 1 << 16;
+	std::vector<BoundingBox> boxes(count);
+	std::vector<glm::vec4> spheres(count);
+	std::vector<uint32_t> visibility(count, 0);
+	for (size_t i = 0; i < count; i++)
+	{
+		boxes[i].center = randomPosition(200.f);
+		boxes[i].extents = glm::vec3(8.f);
+		spheres[i] = glm::vec4(boxes[i].center, 8.f);
+	}
+
+	size_t visibleBoxes = 0;
+	CPUTests::benchmark("Frustum::cullBoxes, per box", count, [&]() {
+		frustum.cullBoxes(boxes.data(), count, visibility.data(), 1);
+	});
+	CPUTests::benchmark("Frustum::intersectsBox loop, per box", count, [&]() {
+		visibleBoxes = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			visibleBoxes += frustum.intersectsBox(boxes[i]) ? 1 : 0;
+		}
+	});
+	size_t visibleSpheres = 0;
+	CPUTests::benchmark("Frustum::cullSpheres, per sphere", count, [&]() {
+		frustum.cullSpheres(spheres.data(), count, visibility.data(), 2);
+	});
+	CPUTests::benchmark("Frustum::intersectsSphere loop, per sphere", count, [&]() {
+		visibleSpheres = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			visibleSpheres += frustum.intersectsSphere(glm::vec3(spheres[i]), spheres[i].w) ? 1 : 0;
+		}
+	});
+
+	size_t batchBoxes = 0;
+	size_t batchSpheres = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		batchBoxes += (visibility[i] & 1) ? 1 : 0;
+		batchSpheres += (visibility[i] & 2) ? 1 : 0;
+	}
+	TEST_CHECK(batchBoxes == visibleBoxes);
+	TEST_CHECK(batchSpheres == visibleSpheres);
+}
+
+void FrustumTests(Allocator& allocator)
+{
+	testAgainstBruteForce();
+	benchmarkCulling();
+}
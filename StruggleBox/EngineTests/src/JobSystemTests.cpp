@@ -0,0 +1,308 @@
+#include "CPUTests.h"
+
+#include "JobSystem.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Every job has to run exactly once and wait() may only return once its counter's jobs
+// have all finished, with no workers, one and several. parallelFor is benchmarked
+// against the ThreadPool it replaced, which allocated a task and a future per job.
+
+// The old ThreadPool, kept here as the benchmark baseline
+class ThreadPool
+{
+public:
+	ThreadPool(const size_t threads) : m_isRunning(true)
+	{
+		for (size_t i = 0; i < threads; i++)
+		{
+			m_workers.emplace_back([this]() {
+				while (true)
+				{
+					std::unique_lock<std::mutex> lock(m_queueMutex);
+					while (m_isRunning && m_jobs.empty())
+					{
+						m_condition.wait(lock);
+					}
+					if (!m_isRunning && m_jobs.empty())
+					{
+						return;
+					}
+					std::function<void()> job(m_jobs.begin()->second.back());
+					m_jobs.begin()->second.pop_back();
+					if (m_jobs.begin()->second.empty())
+					{
+						m_jobs.erase(m_jobs.begin());
+					}
+					lock.unlock();
+					job();
+				}
+			});
+		}
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_isRunning = false;
+		}
+		m_condition.notify_all();
+		for (std::thread& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	template <class F>
+	std::future<void> addJob(const int priority, F&& func)
+	{
+		auto job = std::make_shared<std::packaged_task<void()>>(std::forward<F>(func));
+		std::future<void> result = job->get_future();
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_jobs[priority].push_back([job]() { (*job)(); });
+		m_condition.notify_one();
+		return result;
+	}
+
+private:
+	std::vector<std::thread> m_workers;
+	std::map<int, std::vector<std::function<void()>>> m_jobs;
+	std::mutex m_queueMutex;
+	std::condition_variable m_condition;
+	bool m_isRunning;
+};
+
+static const size_t WORKER_COUNTS[3] = { 0, 1, 4 };
+
+static void testCounters(const size_t workerCount)
+{
+	JobSystem jobSystem(workerCount);
+	TEST_CHECK(jobSystem.numWorkers() == workerCount);
+
+	// Waiting on a counter nothing was added to returns straight away
+	JobCounter unused;
+	TEST_CHECK(unused.isDone());
+	jobSystem.wait(unused);
+
+	const int jobCount = 20000;
+	std::vector<std::atomic<int>> runs(jobCount);
+	for (std::atomic<int>& run : runs)
+	{
+		run = 0;
+	}
+	JobCounter counter;
+	std::atomic<int>* runsPtr = runs.data();
+	for (int i = 0; i < jobCount; i++)
+	{
+		const JobPriority priority = (JobPriority)(i % (int)JobPriority::Count);
+		jobSystem.addJob(priority, &counter, [runsPtr, i]() { runsPtr[i]++; });
+	}
+	jobSystem.wait(counter);
+	TEST_CHECK(counter.isDone());
+	int wrongCount = 0;
+	for (const std::atomic<int>& run : runs)
+	{
+		wrongCount += run != 1 ? 1 : 0;
+	}
+	TEST_CHECK(wrongCount == 0);
+	TEST_CHECK(jobSystem.numJobs() == 0);
+
+	// Jobs adding jobs to the counter being waited on, wait() must not return before the children ran
+	JobSystem* jobSystemPtr = &jobSystem;
+	JobCounter* counterPtr = &counter;
+	std::atomic<int> childRuns(0);
+	std::atomic<int>* childRunsPtr = &childRuns;
+	const int parentCount = 500;
+	const int childrenPerParent = 8;
+	for (int i = 0; i < parentCount; i++)
+	{
+		jobSystem.addJob(JobPriority::Normal, &counter, [jobSystemPtr, counterPtr, childRunsPtr]() {
+			for (int child = 0; child < childrenPerParent; child++)
+			{
+				jobSystemPtr->addJob(JobPriority::High, counterPtr, [childRunsPtr]() { (*childRunsPtr)++; });
+			}
+		});
+	}
+	jobSystem.wait(counter);
+	TEST_CHECK(childRuns == parentCount * childrenPerParent);
+	TEST_CHECK(counter.isDone());
+
+	// Separate counters only wait for their own jobs
+	JobCounter fast;
+	JobCounter slow;
+	std::atomic<bool> started(false);
+	std::atomic<bool> release(false);
+	std::atomic<bool>* startedPtr = &started;
+	std::atomic<bool>* releasePtr = &release;
+	std::atomic<int> fastRuns(0);
+	std::atomic<int>* fastRunsPtr = &fastRuns;
+	if (workerCount > 0)
+	{
+		jobSystem.addJob(JobPriority::Low, &slow, [startedPtr, releasePtr]() {
+			*startedPtr = true;
+			while (!*releasePtr)
+			{
+				std::this_thread::yield();
+			}
+		});
+		// On a worker before waiting, this thread would never get out of it otherwise
+		while (!started)
+		{
+			std::this_thread::yield();
+		}
+	}
+	for (int i = 0; i < 100; i++)
+	{
+		jobSystem.addJob(JobPriority::High, &fast, [fastRunsPtr]() { (*fastRunsPtr)++; });
+	}
+	jobSystem.wait(fast);
+	TEST_CHECK(fastRuns == 100);
+	TEST_CHECK(workerCount == 0 || !slow.isDone());
+	release = true;
+	jobSystem.wait(slow);
+	TEST_CHECK(slow.isDone());
+
+	// Jobs added from threads that aren't workers, all at once
+	JobCounter shared;
+	JobCounter* sharedPtr = &shared;
+	std::atomic<int> externalRuns(0);
+	std::atomic<int>* externalRunsPtr = &externalRuns;
+	std::vector<std::thread> producers;
+	for (int producer = 0; producer < 4; producer++)
+	{
+		producers.emplace_back([jobSystemPtr, sharedPtr, externalRunsPtr]() {
+			for (int i = 0; i < 5000; i++)
+			{
+				jobSystemPtr->addJob(JobPriority::Normal, sharedPtr, [externalRunsPtr]() { (*externalRunsPtr)++; });
+			}
+		});
+	}
+	for (std::thread& producer : producers)
+	{
+		producer.join();
+	}
+	jobSystem.wait(shared);
+	TEST_CHECK(externalRuns == 4 * 5000);
+	TEST_CHECK(jobSystem.numJobs() == 0);
+}
+
+static void testParallelFor(const size_t workerCount)
+{
+	JobSystem jobSystem(workerCount);
+	const size_t grainSizes[5] = { 0, 1, 16, 256, 4096 };
+	const size_t counts[5] = { 0, 1, 255, 4097, 100000 };
+	for (const size_t grainSize : grainSizes)
+	{
+		for (const size_t count : counts)
+		{
+			// Offset so the range doesn't start at zero
+			const size_t begin = 7;
+			std::vector<std::atomic<uint8_t>> visits(count);
+			for (std::atomic<uint8_t>& visit : visits)
+			{
+				visit = 0;
+			}
+			jobSystem.parallelFor(begin, begin + count, grainSize, [&visits](const size_t index) {
+				visits[index - begin]++;
+			});
+			size_t wrongCount = 0;
+			for (const std::atomic<uint8_t>& visit : visits)
+			{
+				wrongCount += visit != 1 ? 1 : 0;
+			}
+			TEST_CHECK(wrongCount == 0);
+		}
+	}
+
+	// Nested inside a job, the job helps run the inner loop instead of blocking a worker
+	JobCounter counter;
+	std::atomic<size_t> sum(0);
+	std::atomic<size_t>* sumPtr = &sum;
+	JobSystem* jobSystemPtr = &jobSystem;
+	for (int outer = 0; outer < 8; outer++)
+	{
+		jobSystem.addJob(JobPriority::Normal, &counter, [jobSystemPtr, sumPtr]() {
+			jobSystemPtr->parallelFor(0, 1000, 16, [sumPtr](const size_t index) { (*sumPtr) += index; });
+		});
+	}
+	jobSystem.wait(counter);
+	TEST_CHECK(sum == 8 * (999 * 1000 / 2));
+}
+
+// Cheap per item work, so the cost of handing out the jobs shows
+static inline float work(const size_t index)
+{
+	float value = (float)index;
+	for (int i = 0; i < 8; i++)
+	{
+		value = value * 0.5f + 1.f;
+	}
+	return value;
+}
+
+static void benchmarkParallelFor()
+{
+	const size_t workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	const size_t count = 1 << 20;
+	std::vector<float> results(count);
+	float* resultsPtr = results.data();
+	JobSystem jobSystem(workerCount);
+	ThreadPool threadPool(workerCount);
+
+	const size_t grainSizes[3] = { 16, 256, 4096 };
+	char name[96];
+	for (const size_t grainSize : grainSizes)
+	{
+		snprintf(name, sizeof(name), "JobSystem::parallelFor, %zu workers, grain %zu, per item", workerCount, grainSize);
+		CPUTests::benchmark(name, count, [&]() {
+			jobSystem.parallelFor(0, count, grainSize, [resultsPtr](const size_t index) { resultsPtr[index] = work(index); });
+		});
+
+		snprintf(name, sizeof(name), "ThreadPool, %zu workers, grain %zu, per item", workerCount, grainSize);
+		CPUTests::benchmark(name, count, [&]() {
+			std::vector<std::future<void>> futures;
+			futures.reserve(count / grainSize + 1);
+			for (size_t begin = 0; begin < count; begin += grainSize)
+			{
+				const size_t end = std::min(begin + grainSize, count);
+				futures.push_back(threadPool.addJob(0, [resultsPtr, begin, end]() {
+					for (size_t index = begin; index < end; index++)
+					{
+						resultsPtr[index] = work(index);
+					}
+				}));
+			}
+			for (std::future<void>& future : futures)
+			{
+				future.wait();
+			}
+		});
+	}
+
+	size_t wrongCount = 0;
+	for (size_t index = 0; index < count; index++)
+	{
+		wrongCount += results[index] != work(index) ? 1 : 0;
+	}
+	TEST_CHECK(wrongCount == 0);
+}
+
+void JobSystemTests(Allocator& allocator)
+{
+	for (const size_t workerCount : WORKER_COUNTS)
+	{
+		testCounters(workerCount);
+		testParallelFor(workerCount);
+		Log::Info("[CPUTests] JobSystem with %zu workers checked", workerCount);
+	}
+	benchmarkParallelFor();
+}
@@ -0,0 +1,300 @@
+#include "CPUTests.h"
+
+#ifdef MEMORY_TRACKING
+#include "MemoryTracker.h"
+#include "ProxyAllocator.h"
+#include "TaggedAllocator.h"
+#include "ThreadCacheAllocator.h"
+#include "TLSFAllocator.h"
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Allocations from several threads at once go through tagged, proxied and chained allocators
+// in front of a tracked heap, and every tag's totals, high-water mark and size histogram
+// have to come out exactly as counted by hand. Only built with memory tracking on.
+
+const size_t TRACKER_HEAP_SIZE = 256 * 1024 * 1024;
+const int TRACKER_THREAD_COUNT = 4;
+
+// The ways a subsystem can end up allocating, and who owns the memory in each
+enum TrackedPath {
+	PATH_TAGGED,            // Tagged Voxels
+	PATH_PROXY,             // Proxy Physics
+	PATH_TAGGED_OVER_PROXY, // Tagged Particles in front of proxy Physics, the outer one wins
+	PATH_PROXY_OVER_TAGGED, // Proxy Entities in front of tagged GUI
+	PATH_SCOPE,             // Renderer scope around the plain heap
+	PATH_SCOPE_AND_TAGGED,  // Renderer scope around tagged Voxels, the allocator wins
+	PATH_COUNT,
+};
+
+static const MemoryTag PATH_TAGS[PATH_COUNT] = {
+	MemoryTag::Voxels,
+	MemoryTag::Physics,
+	MemoryTag::Particles,
+	MemoryTag::Entities,
+	MemoryTag::Renderer,
+	MemoryTag::Voxels,
+};
+
+static const MemoryTag CHECKED_TAGS[5] = {
+	MemoryTag::Voxels,
+	MemoryTag::Physics,
+	MemoryTag::Particles,
+	MemoryTag::Entities,
+	MemoryTag::Renderer,
+};
+
+struct ExpectedStats {
+	size_t bytes;
+	size_t count;
+	size_t histogram[MemoryTracker::NUM_SIZE_BUCKETS];
+};
+
+// Powers of two from 16 bytes, the last bucket takes everything larger
+static size_t expectedBucket(const size_t size)
+{
+	size_t bucket = 0;
+	while (bucket < MemoryTracker::NUM_SIZE_BUCKETS - 1 && ((size_t)16 << bucket) < size)
+	{
+		bucket++;
+	}
+	return bucket;
+}
+
+struct TrackedAllocators {
+	Allocator& heap;
+	TaggedAllocator& tagged;
+	ProxyAllocator& proxy;
+	TaggedAllocator& taggedOverProxy;
+	ProxyAllocator& proxyOverTagged;
+};
+
+static void* allocateThrough(TrackedAllocators& allocators, const TrackedPath path, const size_t size)
+{
+	switch (path)
+	{
+	case PATH_TAGGED:
+		return allocators.tagged.allocate(size, 16);
+	case PATH_PROXY:
+		return allocators.proxy.allocate(size, 16);
+	case PATH_TAGGED_OVER_PROXY:
+		return allocators.taggedOverProxy.allocate(size, 16);
+	case PATH_PROXY_OVER_TAGGED:
+		return allocators.proxyOverTagged.allocate(size, 16);
+	case PATH_SCOPE:
+	{
+		MemoryTagScope scope(MemoryTag::Renderer);
+		return allocators.heap.allocate(size, 16);
+	}
+	case PATH_SCOPE_AND_TAGGED:
+	{
+		MemoryTagScope scope(MemoryTag::Renderer);
+		return allocators.tagged.allocate(size, 16);
+	}
+	default:
+		return nullptr;
+	}
+}
+
+static void deallocateThrough(TrackedAllocators& allocators, const TrackedPath path, void* p)
+{
+	switch (path)
+	{
+	case PATH_TAGGED:
+	case PATH_SCOPE_AND_TAGGED:
+		allocators.tagged.deallocate(p);
+		break;
+	case PATH_PROXY:
+		allocators.proxy.deallocate(p);
+		break;
+	case PATH_TAGGED_OVER_PROXY:
+		allocators.taggedOverProxy.deallocate(p);
+		break;
+	case PATH_PROXY_OVER_TAGGED:
+		allocators.proxyOverTagged.deallocate(p);
+		break;
+	default:
+		allocators.heap.deallocate(p);
+		break;
+	}
+}
+
+struct TrackedAllocation {
+	void* p;
+	TrackedPath path;
+};
+
+static void checkTagStats(ThreadCacheAllocator& heap)
+{
+	TaggedAllocator tagged(heap, MemoryTag::Voxels);
+	ProxyAllocator proxy(heap, MemoryTag::Physics);
+	TaggedAllocator taggedOverProxy(proxy, MemoryTag::Particles);
+	TaggedAllocator taggedGUI(heap, MemoryTag::GUI);
+	ProxyAllocator proxyOverTagged(taggedGUI, MemoryTag::Entities);
+	TrackedAllocators allocators = { heap, tagged, proxy, taggedOverProxy, proxyOverTagged };
+
+	MemoryTagStats before[(size_t)MemoryTag::Count];
+	for (const MemoryTag tag : CHECKED_TAGS)
+	{
+		MemoryTracker::ResetPeak(tag);
+		before[(size_t)tag] = MemoryTracker::GetTagStats(tag);
+	}
+	const MemoryTagStats guiBefore = MemoryTracker::GetTagStats(MemoryTag::GUI);
+
+	// Every thread holds on to everything it allocated until all of them are done, so the peak is the sum
+	std::vector<std::vector<ExpectedStats>> expected(TRACKER_THREAD_COUNT, std::vector<ExpectedStats>((size_t)MemoryTag::Count));
+	std::vector<std::vector<TrackedAllocation>> live(TRACKER_THREAD_COUNT);
+	std::vector<size_t> failed(TRACKER_THREAD_COUNT, 0);
+	std::atomic<int> allocated(0);
+	std::atomic<bool> checkedPeak(false);
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < TRACKER_THREAD_COUNT; thread++)
+	{
+		threads.emplace_back([&, thread]() {
+			// Random isn't thread safe, each thread runs its own generator
+			uint32_t state = 2166136261u + thread * 16777619u;
+			auto next = [&state]() {
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				return state;
+			};
+			for (ExpectedStats& stats : expected[thread])
+			{
+				stats = {};
+			}
+			for (int i = 0; i < 3000; i++)
+			{
+				// Mostly small, a few in every bucket up to the one for everything past 512KB
+				const size_t size = i % 500 == 0 ? 600 * 1024 + next() % 100000 : 1 + next() % ((size_t)16 << (next() % 13));
+				const TrackedPath path = (TrackedPath)(next() % PATH_COUNT);
+				void* p = allocateThrough(allocators, path, size);
+				if (!p)
+				{
+					failed[thread]++;
+					continue;
+				}
+				ExpectedStats& stats = expected[thread][(size_t)PATH_TAGS[path]];
+				stats.bytes += size;
+				stats.count++;
+				stats.histogram[expectedBucket(size)]++;
+				live[thread].push_back({ p, path });
+			}
+			allocated++;
+			while (!checkedPeak)
+			{
+				std::this_thread::yield();
+			}
+			// Every thread frees what the next one allocated
+			for (const TrackedAllocation& allocation : live[(thread + 1) % TRACKER_THREAD_COUNT])
+			{
+				deallocateThrough(allocators, allocation.path, allocation.p);
+			}
+		});
+	}
+	while (allocated < TRACKER_THREAD_COUNT)
+	{
+		std::this_thread::yield();
+	}
+
+	ExpectedStats totals[(size_t)MemoryTag::Count] = {};
+	for (int thread = 0; thread < TRACKER_THREAD_COUNT; thread++)
+	{
+		for (size_t tag = 0; tag < (size_t)MemoryTag::Count; tag++)
+		{
+			totals[tag].bytes += expected[thread][tag].bytes;
+			totals[tag].count += expected[thread][tag].count;
+			for (size_t bucket = 0; bucket < MemoryTracker::NUM_SIZE_BUCKETS; bucket++)
+			{
+				totals[tag].histogram[bucket] += expected[thread][tag].histogram[bucket];
+			}
+		}
+	}
+	for (const MemoryTag tag : CHECKED_TAGS)
+	{
+		const MemoryTagStats& start = before[(size_t)tag];
+		const MemoryTagStats stats = MemoryTracker::GetTagStats(tag);
+		const ExpectedStats& total = totals[(size_t)tag];
+		TEST_CHECK(total.count > 0);
+		TEST_CHECK(stats.currentBytes - start.currentBytes == total.bytes);
+		TEST_CHECK(stats.currentCount - start.currentCount == total.count);
+		TEST_CHECK(stats.peakBytes == start.currentBytes + total.bytes);
+		Log::Info("[CPUTests] %s holds %zu allocations, %zu bytes", GetMemoryTagName(tag), total.count, total.bytes);
+	}
+	// The inner tag of a chain never sees the memory
+	TEST_CHECK(MemoryTracker::GetTagStats(MemoryTag::GUI).totalCount == guiBefore.totalCount);
+	checkedPeak = true;
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	size_t failedCount = 0;
+	for (const size_t count : failed)
+	{
+		failedCount += count;
+	}
+	TEST_CHECK(failedCount == 0);
+	for (const MemoryTag tag : CHECKED_TAGS)
+	{
+		const MemoryTagStats& start = before[(size_t)tag];
+		const MemoryTagStats stats = MemoryTracker::GetTagStats(tag);
+		const ExpectedStats& total = totals[(size_t)tag];
+		TEST_CHECK(stats.currentBytes == start.currentBytes);
+		TEST_CHECK(stats.currentCount == start.currentCount);
+		TEST_CHECK(stats.totalCount - start.totalCount == total.count);
+		TEST_CHECK(stats.peakBytes == start.currentBytes + total.bytes);
+		size_t wrongBuckets = 0;
+		for (size_t bucket = 0; bucket < MemoryTracker::NUM_SIZE_BUCKETS; bucket++)
+		{
+			wrongBuckets += stats.histogram[bucket] - start.histogram[bucket] != total.histogram[bucket] ? 1 : 0;
+		}
+		TEST_CHECK(wrongBuckets == 0);
+	}
+	TEST_CHECK(proxy.getNumAllocations() == 0 && proxyOverTagged.getNumAllocations() == 0);
+
+	// The bucket edges themselves
+	TEST_CHECK(expectedBucket(1) == 0 && expectedBucket(16) == 0 && expectedBucket(17) == 1);
+	MemoryTracker::ResetPeak(MemoryTag::Particles);
+	const MemoryTagStats edgesBefore = MemoryTracker::GetTagStats(MemoryTag::Particles);
+	const size_t edgeSizes[5] = { 16, 17, 512 * 1024, 512 * 1024 + 1, 4 * 1024 * 1024 };
+	for (const size_t size : edgeSizes)
+	{
+		void* p = taggedOverProxy.allocate(size, 16);
+		TEST_CHECK(p != nullptr);
+		if (p)
+		{
+			taggedOverProxy.deallocate(p);
+		}
+	}
+	const MemoryTagStats edgesAfter = MemoryTracker::GetTagStats(MemoryTag::Particles);
+	TEST_CHECK(edgesAfter.histogram[0] - edgesBefore.histogram[0] == 1);
+	TEST_CHECK(edgesAfter.histogram[1] - edgesBefore.histogram[1] == 1);
+	TEST_CHECK(edgesAfter.histogram[15] - edgesBefore.histogram[15] == 1);
+	TEST_CHECK(edgesAfter.histogram[16] - edgesBefore.histogram[16] == 2);
+	TEST_CHECK(edgesAfter.peakBytes == edgesBefore.currentBytes + 4 * 1024 * 1024);
+}
+
+static void testTagStats()
+{
+	unsigned char* memory = (unsigned char*)malloc(TRACKER_HEAP_SIZE);
+	TEST_CHECK(memory != nullptr);
+	if (!memory)
+	{
+		return;
+	}
+	{
+		TLSFAllocator parent(TRACKER_HEAP_SIZE, memory);
+		ThreadCacheAllocator heap(parent);
+		checkTagStats(heap);
+	}
+	free(memory);
+}
+
+void MemoryTrackerTests(Allocator& allocator)
+{
+	testTagStats();
+}
+#endif
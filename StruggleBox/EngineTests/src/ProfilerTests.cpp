@@ -0,0 +1,537 @@
+#include "CPUTests.h"
+
+#include "FileUtil.h"
+#include "Profiler.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Several threads record nested scopes while the main thread collects frames, and every
+// scope has to show up in the summary exactly once with the right depth. A capture is
+// read back with a strict JSON parser and the events in it checked against what ran.
+// Writes its scratch capture next to the executable.
+
+const int PROFILER_THREAD_COUNT = 4;
+const int INNER_SCOPES = 8;
+
+// Scope names are compared by pointer in the profiler, so they live here for good
+static const char* const OUTER_SCOPE = "CPUTests outer";
+static const char* const INNER_SCOPE = "CPUTests inner";
+static const char* const ESCAPED_SCOPE = "CPUTests \"quoted\" \\ scope";
+static const char* const BURST_SCOPE = "CPUTests burst";
+
+static const ProfileScopeSummary* findSummary(const char* name)
+{
+	for (const ProfileScopeSummary& summary : Profiler::getSummary())
+	{
+		if (strcmp(summary.name, name) == 0)
+		{
+			return &summary;
+		}
+	}
+	return nullptr;
+}
+
+// Just enough of JSON to read a capture back, anything malformed fails the whole parse
+struct JsonValue {
+	enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+	double number = 0.0;
+	std::string text;
+	std::vector<JsonValue> items;
+	std::vector<std::pair<std::string, JsonValue>> members;
+
+	const JsonValue* find(const char* key) const
+	{
+		for (const auto& member : members)
+		{
+			if (member.first == key)
+			{
+				return &member.second;
+			}
+		}
+		return nullptr;
+	}
+};
+
+class JsonParser {
+public:
+	explicit JsonParser(const std::string& text) : m_text(text), m_pos(0) {}
+
+	bool parse(JsonValue& value)
+	{
+		if (!parseValue(value))
+		{
+			return false;
+		}
+		skipSpace();
+		return m_pos == m_text.size();
+	}
+
+private:
+	const std::string& m_text;
+	size_t m_pos;
+
+	void skipSpace()
+	{
+		while (m_pos < m_text.size() && strchr(" \t\r\n", m_text[m_pos]) != nullptr)
+		{
+			m_pos++;
+		}
+	}
+
+	bool consume(const char c)
+	{
+		skipSpace();
+		if (m_pos < m_text.size() && m_text[m_pos] == c)
+		{
+			m_pos++;
+			return true;
+		}
+		return false;
+	}
+
+	bool parseString(std::string& out)
+	{
+		if (!consume('"'))
+		{
+			return false;
+		}
+		while (m_pos < m_text.size())
+		{
+			const char c = m_text[m_pos++];
+			if (c == '"')
+			{
+				return true;
+			}
+			if ((unsigned char)c < 0x20)
+			{
+				return false;
+			}
+			if (c == '\\')
+			{
+				if (m_pos >= m_text.size())
+				{
+					return false;
+				}
+				const char escaped = m_text[m_pos++];
+				switch (escaped)
+				{
+				case '"': out += '"'; break;
+				case '\\': out += '\\'; break;
+				case '/': out += '/'; break;
+				case 'n': out += '\n'; break;
+				case 't': out += '\t'; break;
+				case 'r': out += '\r'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				default: return false;
+				}
+				continue;
+			}
+			out += c;
+		}
+		return false;
+	}
+
+	bool parseNumber(double& out)
+	{
+		const size_t start = m_pos;
+		if (m_pos < m_text.size() && m_text[m_pos] == '-') { m_pos++; }
+		size_t digits = 0;
+		while (m_pos < m_text.size() && isdigit((unsigned char)m_text[m_pos])) { m_pos++; digits++; }
+		if (digits == 0)
+		{
+			return false;
+		}
+		if (m_pos < m_text.size() && m_text[m_pos] == '.')
+		{
+			m_pos++;
+			digits = 0;
+			while (m_pos < m_text.size() && isdigit((unsigned char)m_text[m_pos])) { m_pos++; digits++; }
+			if (digits == 0)
+			{
+				return false;
+			}
+		}
+		if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E'))
+		{
+			m_pos++;
+			if (m_pos < m_text.size() && (m_text[m_pos] == '+' || m_text[m_pos] == '-')) { m_pos++; }
+			digits = 0;
+			while (m_pos < m_text.size() && isdigit((unsigned char)m_text[m_pos])) { m_pos++; digits++; }
+			if (digits == 0)
+			{
+				return false;
+			}
+		}
+		out = atof(m_text.substr(start, m_pos - start).c_str());
+		return true;
+	}
+
+	bool parseValue(JsonValue& value)
+	{
+		skipSpace();
+		if (m_pos >= m_text.size())
+		{
+			return false;
+		}
+		const char c = m_text[m_pos];
+		if (c == '{')
+		{
+			m_pos++;
+			value.type = JsonValue::Object;
+			if (consume('}'))
+			{
+				return true;
+			}
+			do
+			{
+				std::pair<std::string, JsonValue> member;
+				if (!parseString(member.first) || !consume(':') || !parseValue(member.second))
+				{
+					return false;
+				}
+				value.members.push_back(std::move(member));
+			} while (consume(','));
+			return consume('}');
+		}
+		if (c == '[')
+		{
+			m_pos++;
+			value.type = JsonValue::Array;
+			if (consume(']'))
+			{
+				return true;
+			}
+			do
+			{
+				value.items.emplace_back();
+				if (!parseValue(value.items.back()))
+				{
+					return false;
+				}
+			} while (consume(','));
+			return consume(']');
+		}
+		if (c == '"')
+		{
+			value.type = JsonValue::String;
+			return parseString(value.text);
+		}
+		if (m_text.compare(m_pos, 4, "true") == 0 || m_text.compare(m_pos, 5, "false") == 0)
+		{
+			value.type = JsonValue::Bool;
+			value.number = m_text[m_pos] == 't' ? 1.0 : 0.0;
+			m_pos += m_text[m_pos] == 't' ? 4 : 5;
+			return true;
+		}
+		if (m_text.compare(m_pos, 4, "null") == 0)
+		{
+			m_pos += 4;
+			return true;
+		}
+		value.type = JsonValue::Number;
+		return parseNumber(value.number);
+	}
+};
+
+static void testParser()
+{
+	const char* valid[4] = { "{}", "[1, -2.5e3, \"a\\\"b\", true, null]", "{\"a\":{\"b\":[]}}", " [ ] " };
+	const char* invalid[6] = { "{", "[1,]", "{\"a\" 1}", "\"a\\q\"", "[1] 2", "{\"a\":01.}" };
+	for (const char* text : valid)
+	{
+		JsonValue value;
+		TEST_CHECK(JsonParser(text).parse(value));
+	}
+	for (const char* text : invalid)
+	{
+		JsonValue value;
+		TEST_CHECK(!JsonParser(text).parse(value));
+	}
+}
+
+// Keeps the frames in step: every thread records one frame's worth, then the main thread collects it
+struct FrameBarrier {
+	std::atomic<int> frame;
+	std::atomic<int> recorded;
+};
+
+static void recordFrame(const int thread)
+{
+	PROFILE_SCOPE(OUTER_SCOPE);
+	for (int i = 0; i < INNER_SCOPES; i++)
+	{
+		PROFILE_SCOPE(INNER_SCOPE);
+		if (thread == 0 && i == 0)
+		{
+			PROFILE_SCOPE(ESCAPED_SCOPE);
+		}
+	}
+}
+
+static void testThreadsAndCapture()
+{
+	const std::string capturePath = FileUtil::GetPath() + "CPUTests_Profile.tmp";
+	const int frameCount = 6;
+	const uint32_t captureFrames = 3;
+
+	// Anything left over from other suites goes into a frame of its own
+	Profiler::endFrame();
+
+	FrameBarrier barrier;
+	barrier.frame = 0;
+	barrier.recorded = 0;
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < PROFILER_THREAD_COUNT; thread++)
+	{
+		threads.emplace_back([&barrier, thread]() {
+			char name[32];
+			snprintf(name, sizeof(name), "CPUTests %d", thread);
+			Profiler::setThreadName(name);
+			for (int frame = 0; frame < frameCount; frame++)
+			{
+				while (barrier.frame < frame)
+				{
+					std::this_thread::yield();
+				}
+				recordFrame(thread);
+				barrier.recorded++;
+			}
+		});
+	}
+
+	size_t wrongCount = 0;
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		if (frame == frameCount - (int)captureFrames)
+		{
+			Profiler::startCapture(captureFrames, capturePath);
+			TEST_CHECK(Profiler::isCapturing());
+		}
+		while (barrier.recorded < (frame + 1) * PROFILER_THREAD_COUNT)
+		{
+			std::this_thread::yield();
+		}
+		Profiler::endFrame();
+
+		// Every thread's scopes in this frame, and nothing from the last
+		const ProfileScopeSummary* outer = findSummary(OUTER_SCOPE);
+		const ProfileScopeSummary* inner = findSummary(INNER_SCOPE);
+		const ProfileScopeSummary* escaped = findSummary(ESCAPED_SCOPE);
+		if (!outer || !inner || !escaped)
+		{
+			wrongCount++;
+		}
+		else
+		{
+			wrongCount += outer->calls != PROFILER_THREAD_COUNT || outer->depth != 0 ? 1 : 0;
+			wrongCount += inner->calls != PROFILER_THREAD_COUNT * INNER_SCOPES || inner->depth != 1 ? 1 : 0;
+			wrongCount += escaped->calls != 1 || escaped->depth != 2 ? 1 : 0;
+			// Inner scopes run inside the outer ones, so they can't take longer
+			wrongCount += inner->lastMs > outer->lastMs || outer->maxMs < outer->lastMs ? 1 : 0;
+		}
+		barrier.frame++;
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	TEST_CHECK(wrongCount == 0);
+	TEST_CHECK(!Profiler::isCapturing());
+
+	// The summary keeps each thread's scopes together
+	const std::vector<ProfileScopeSummary>& summary = Profiler::getSummary();
+	size_t unsorted = 0;
+	for (size_t i = 1; i < summary.size(); i++)
+	{
+		unsorted += summary[i].threadID < summary[i - 1].threadID ? 1 : 0;
+	}
+	TEST_CHECK(unsorted == 0);
+
+	// The capture is valid JSON holding exactly the captured frames
+	std::ifstream file(capturePath.c_str());
+	TEST_CHECK(file.is_open());
+	std::stringstream contents;
+	contents << file.rdbuf();
+	file.close();
+	remove(capturePath.c_str());
+
+	JsonValue root;
+	TEST_CHECK(JsonParser(contents.str()).parse(root));
+	const JsonValue* events = root.find("traceEvents");
+	TEST_CHECK(events != nullptr && events->type == JsonValue::Array);
+	if (!events || events->type != JsonValue::Array)
+	{
+		return;
+	}
+
+	std::map<int, std::string> threadNames;
+	std::map<std::string, size_t> counts;
+	std::map<int, std::vector<const JsonValue*>> outerEvents;
+	std::map<int, std::vector<const JsonValue*>> innerEvents;
+	size_t malformed = 0;
+	for (const JsonValue& event : events->items)
+	{
+		const JsonValue* name = event.find("name");
+		const JsonValue* phase = event.find("ph");
+		const JsonValue* tid = event.find("tid");
+		if (!name || !phase || !tid || name->type != JsonValue::String || tid->type != JsonValue::Number)
+		{
+			malformed++;
+			continue;
+		}
+		if (phase->text == "M")
+		{
+			const JsonValue* args = event.find("args");
+			const JsonValue* threadName = args ? args->find("name") : nullptr;
+			if (name->text == "thread_name" && threadName)
+			{
+				threadNames[(int)tid->number] = threadName->text;
+			}
+			continue;
+		}
+		const JsonValue* ts = event.find("ts");
+		const JsonValue* dur = event.find("dur");
+		if (phase->text != "X" || !ts || !dur || ts->number < 0.0 || dur->number < 0.0)
+		{
+			malformed++;
+			continue;
+		}
+		counts[name->text]++;
+		if (name->text == OUTER_SCOPE) { outerEvents[(int)tid->number].push_back(&event); }
+		if (name->text == INNER_SCOPE) { innerEvents[(int)tid->number].push_back(&event); }
+	}
+	TEST_CHECK(malformed == 0);
+	TEST_CHECK(counts[OUTER_SCOPE] == captureFrames * PROFILER_THREAD_COUNT);
+	TEST_CHECK(counts[INNER_SCOPE] == captureFrames * PROFILER_THREAD_COUNT * INNER_SCOPES);
+	TEST_CHECK(counts[ESCAPED_SCOPE] == captureFrames);
+
+	// Each recording thread is named, and every inner scope sits inside an outer one on its thread
+	size_t namedThreads = 0;
+	size_t outside = 0;
+	for (const auto& pair : outerEvents)
+	{
+		const std::string& threadName = threadNames[pair.first];
+		namedThreads += threadName.compare(0, 9, "CPUTests ") == 0 ? 1 : 0;
+		for (const JsonValue* inner : innerEvents[pair.first])
+		{
+			const double start = inner->find("ts")->number;
+			const double end = start + inner->find("dur")->number;
+			bool inside = false;
+			for (const JsonValue* outer : pair.second)
+			{
+				const double outerStart = outer->find("ts")->number;
+				const double outerEnd = outerStart + outer->find("dur")->number;
+				// Times are written to the nearest nanosecond
+				inside |= start >= outerStart - 0.001 && end <= outerEnd + 0.001;
+			}
+			outside += inside ? 0 : 1;
+		}
+	}
+	TEST_CHECK(namedThreads == PROFILER_THREAD_COUNT);
+	TEST_CHECK(outside == 0);
+	Log::Info("[CPUTests] Profiler capture held %zu events from %zu threads", events->items.size(), threadNames.size());
+}
+
+// Threads keep recording while the main thread collects, nothing may be lost or torn
+static void testConcurrentCollection()
+{
+	Profiler::endFrame();
+	const int burstCount = 200;
+	const int burstSize = 500;
+	std::atomic<int> collected(0);
+	std::atomic<int> finished(0);
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < PROFILER_THREAD_COUNT; thread++)
+	{
+		threads.emplace_back([&]() {
+			for (int burst = 0; burst < burstCount; burst++)
+			{
+				// Never more between two collections than a buffer holds
+				const int seen = collected;
+				for (int i = 0; i < burstSize; i++)
+				{
+					PROFILE_SCOPE(BURST_SCOPE);
+				}
+				while (collected < seen + 1)
+				{
+					std::this_thread::yield();
+				}
+			}
+			finished++;
+		});
+	}
+	size_t total = 0;
+	size_t wrongDepth = 0;
+	while (finished < PROFILER_THREAD_COUNT)
+	{
+		Profiler::endFrame();
+		collected++;
+		const ProfileScopeSummary* burst = findSummary(BURST_SCOPE);
+		if (burst)
+		{
+			total += burst->calls;
+			wrongDepth += burst->calls > 0 && burst->depth != 0 ? 1 : 0;
+		}
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	Profiler::endFrame();
+	const ProfileScopeSummary* burst = findSummary(BURST_SCOPE);
+	total += burst ? burst->calls : 0;
+	TEST_CHECK(total == (size_t)PROFILER_THREAD_COUNT * burstCount * burstSize);
+	TEST_CHECK(wrongDepth == 0);
+}
+
+// A thread recording more than its buffer in one frame loses the oldest scopes, never the frame
+static void testOverflow()
+{
+	Profiler::endFrame();
+	const size_t recorded = Profiler::EVENTS_PER_THREAD * 3 / 2;
+	std::thread thread([recorded]() {
+		for (size_t i = 0; i < recorded; i++)
+		{
+			PROFILE_SCOPE(BURST_SCOPE);
+		}
+	});
+	thread.join();
+	Profiler::endFrame();
+	const ProfileScopeSummary* burst = findSummary(BURST_SCOPE);
+	// The slot the thread would write next can't be told from a torn one, so it goes too
+	TEST_CHECK(burst != nullptr && burst->calls == Profiler::EVENTS_PER_THREAD - 1);
+}
+
+static void benchmarkScope()
+{
+	const size_t scopeCount = Profiler::EVENTS_PER_THREAD / 2;
+	Profiler::endFrame();
+	CPUTests::benchmark("PROFILE_SCOPE, per scope", scopeCount, [&]() {
+		for (size_t i = 0; i < scopeCount; i++)
+		{
+			PROFILE_SCOPE(BURST_SCOPE);
+		}
+		Profiler::endFrame();
+	});
+}
+
+void ProfilerTests(Allocator& allocator)
+{
+#ifdef PROFILING
+	testParser();
+	testThreadsAndCapture();
+	testConcurrentCollection();
+	testOverflow();
+	benchmarkScope();
+#else
+	Log::Info("[CPUTests] Profiling is compiled out, nothing to check");
+#endif
+}
@@ -0,0 +1,339 @@
+#include "CPUTests.h"
+
+#include "FileUtil.h"
+#include "JobSystem.h"
+#include "Random.h"
+#include "RegionStore.h"
+#include "Serialise.h"
+#include "VoxelData.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+
+// Chunks stored in region files have to load back unchanged after the store is closed and
+// reopened, records that shrink reuse their slot even in a later session, damaged or cut
+// off records are rejected, and the offset table stays consistent with many chunks in it.
+
+static std::string regionsPath()
+{
+	return FileUtil::GetPath() + "CPUTests_Regions/";
+}
+
+static void removeRegionFiles()
+{
+	std::vector<std::string> fileNames;
+	if (!FileUtil::DoesFolderExist(regionsPath()) ||
+		!FileUtil::GetFilesOfType(regionsPath(), ".region", fileNames))
+	{
+		return;
+	}
+	for (const std::string& fileName : fileNames)
+	{
+		remove((regionsPath() + fileName).c_str());
+	}
+}
+
+static std::string regionFile(const int x, const int y, const int z)
+{
+	return regionsPath() + "r." + std::to_string(x) + "." + std::to_string(y) + "." + std::to_string(z) + ".region";
+}
+
+static std::vector<unsigned char> readFile(const std::string& path)
+{
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string& path, const std::vector<unsigned char>& data)
+{
+	std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	file.write((const char*)data.data(), data.size());
+}
+
+struct TableEntry {
+	uint32_t offset;
+	uint32_t size;
+	uint32_t capacity;
+};
+
+static TableEntry readTableEntry(const std::vector<unsigned char>& file, const int index)
+{
+	const unsigned char* entry = file.data() + REGION_TAG_SIZE + index * REGION_TABLE_ENTRY_SIZE;
+	return TableEntry{ Serialise::deserialiseInt(entry), Serialise::deserialiseInt(entry + SERIALISED_INT_SIZE), Serialise::deserialiseInt(entry + SERIALISED_INT_SIZE * 2) };
+}
+
+// A few types compress well, many types barely compress
+static void fillRandom(VoxelData& voxels, const int typeCount)
+{
+	for (size_t i = 0; i < voxels.getMemoryUsage(); i++)
+	{
+		voxels[(int)i] = (uint8_t)Random::RandomInt(0, typeCount - 1);
+	}
+}
+
+static bool sameVoxels(const VoxelData& a, const VoxelData& b)
+{
+	return memcmp(a.getData(), b.getData(), a.getMemoryUsage()) == 0;
+}
+
+static void testStoreAndReopen(Allocator& allocator, JobSystem& jobSystem)
+{
+	Random::RandomSeed(8);
+	VoxelData stored(16, 16, 16, allocator);
+	VoxelData loaded(16, 16, 16, allocator);
+	fillRandom(stored, 12);
+	const Coord3D coord(3, -2, 17);
+
+	RegionStore store(allocator, jobSystem);
+	store.open(regionsPath());
+	TEST_CHECK(!store.loadChunk(coord, loaded));
+	store.storeChunk(coord, stored);
+	// Still waiting for the write job, or already written, both load the same
+	TEST_CHECK(store.loadChunk(coord, loaded) && sameVoxels(stored, loaded));
+	store.close();
+
+	loaded.clear();
+	loaded.clearDirtyBricks();
+	store.open(regionsPath());
+	TEST_CHECK(store.loadChunk(coord, loaded) && sameVoxels(stored, loaded));
+	TEST_CHECK(loaded.hasDirtyBricks());
+	// Neighbours in the same region and chunks of other regions were never stored
+	TEST_CHECK(!store.loadChunk(Coord3D(3, -2, 18), loaded));
+	TEST_CHECK(!store.loadChunk(Coord3D(-40, 0, 0), loaded));
+	store.close();
+}
+
+static void testSlotReuse(Allocator& allocator, JobSystem& jobSystem)
+{
+	Random::RandomSeed(9);
+	VoxelData medium(16, 16, 16, allocator);
+	VoxelData small(16, 16, 16, allocator);
+	VoxelData large(16, 16, 16, allocator);
+	VoxelData loaded(16, 16, 16, allocator);
+	fillRandom(medium, 16);
+	small.fill(4);
+	fillRandom(large, 256);
+	const Coord3D coord(1, 2, 3);
+	const int index = 1 + 2 * REGION_SIZE + 3 * REGION_SIZE * REGION_SIZE;
+	const std::string path = regionFile(0, 0, 0);
+
+	RegionStore store(allocator, jobSystem);
+	store.open(regionsPath());
+	store.storeChunk(coord, medium);
+	store.flush();
+	const long slotFileSize = FileUtil::GetFileSize(path);
+	const TableEntry mediumEntry = readTableEntry(readFile(path), index);
+	TEST_CHECK(mediumEntry.offset == REGION_HEADER_SIZE);
+	TEST_CHECK(slotFileSize == (long)(REGION_HEADER_SIZE + mediumEntry.size));
+	TEST_CHECK(mediumEntry.capacity == mediumEntry.size);
+
+	// Smaller records overwrite the slot, which keeps its capacity
+	store.storeChunk(coord, small);
+	store.flush();
+	const TableEntry smallEntry = readTableEntry(readFile(path), index);
+	TEST_CHECK(FileUtil::GetFileSize(path) == slotFileSize);
+	TEST_CHECK(smallEntry.offset == mediumEntry.offset && smallEntry.size < mediumEntry.size);
+	TEST_CHECK(smallEntry.capacity == mediumEntry.capacity);
+	TEST_CHECK(store.loadChunk(coord, loaded) && sameVoxels(small, loaded));
+	store.close();
+
+	// The capacity comes back with the table, growing again still fits the slot
+	store.open(regionsPath());
+	store.storeChunk(coord, medium);
+	store.flush();
+	TEST_CHECK(FileUtil::GetFileSize(path) == slotFileSize);
+	TEST_CHECK(readTableEntry(readFile(path), index).offset == mediumEntry.offset);
+	TEST_CHECK(store.loadChunk(coord, loaded) && sameVoxels(medium, loaded));
+
+	// Records bigger than the slot are appended
+	store.storeChunk(coord, large);
+	store.flush();
+	const TableEntry largeEntry = readTableEntry(readFile(path), index);
+	TEST_CHECK(largeEntry.offset == (uint32_t)slotFileSize);
+	TEST_CHECK(largeEntry.size > mediumEntry.capacity && largeEntry.capacity == largeEntry.size);
+	TEST_CHECK(FileUtil::GetFileSize(path) == slotFileSize + (long)largeEntry.size);
+	store.close();
+
+	store.open(regionsPath());
+	TEST_CHECK(store.loadChunk(coord, loaded) && sameVoxels(large, loaded));
+	store.close();
+}
+
+static void testDamagedRecords(Allocator& allocator, JobSystem& jobSystem)
+{
+	Random::RandomSeed(10);
+	VoxelData first(16, 16, 16, allocator);
+	VoxelData second(16, 16, 16, allocator);
+	VoxelData loaded(16, 16, 16, allocator);
+	fillRandom(first, 6);
+	fillRandom(second, 6);
+	// Region -1, -1, -1 so nothing earlier in the suite shares the file
+	const Coord3D firstCoord(-1, -1, -1);
+	const Coord3D secondCoord(-2, -1, -1);
+	const int firstIndex = REGION_NUM_CHUNKS - 1;
+	const std::string path = regionFile(-1, -1, -1);
+
+	RegionStore store(allocator, jobSystem);
+	store.open(regionsPath());
+	store.storeChunk(firstCoord, first);
+	store.flush();
+	store.storeChunk(secondCoord, second);
+	store.close();
+
+	std::vector<unsigned char> file = readFile(path);
+	const std::vector<unsigned char> original = file;
+	const TableEntry firstEntry = readTableEntry(file, firstIndex);
+	TEST_CHECK(firstEntry.offset == REGION_HEADER_SIZE);
+
+	// A flipped byte of the stored CRC
+	file[firstEntry.offset + SERIALISED_INT_SIZE] ^= 0x10;
+	writeFile(path, file);
+	Log::Info("[CPUTests] Loading a record with a bad CRC");
+	store.open(regionsPath());
+	loaded.fill(1);
+	TEST_CHECK(!store.loadChunk(firstCoord, loaded));
+	TEST_CHECK(loaded.getData()[0] == EMPTY_VOXEL);
+	TEST_CHECK(store.loadChunk(secondCoord, loaded) && sameVoxels(second, loaded));
+	store.close();
+
+	// A flipped byte in the middle of the zlib stream
+	file = original;
+	file[firstEntry.offset + REGION_RECORD_HEADER_SIZE + (firstEntry.size - REGION_RECORD_HEADER_SIZE) / 2] ^= 0x55;
+	writeFile(path, file);
+	Log::Info("[CPUTests] Loading a record with a damaged stream");
+	store.open(regionsPath());
+	TEST_CHECK(!store.loadChunk(firstCoord, loaded));
+	TEST_CHECK(store.loadChunk(secondCoord, loaded) && sameVoxels(second, loaded));
+	store.close();
+
+	// The second record was appended last, cutting the file short truncates it
+	file = original;
+	file.resize(file.size() - 10);
+	writeFile(path, file);
+	Log::Info("[CPUTests] Loading a truncated record");
+	store.open(regionsPath());
+	TEST_CHECK(!store.loadChunk(secondCoord, loaded));
+	TEST_CHECK(store.loadChunk(firstCoord, loaded) && sameVoxels(first, loaded));
+	store.close();
+}
+
+static void testManyChunks(Allocator& allocator, JobSystem& jobSystem)
+{
+	Random::RandomSeed(11);
+	// Spread over eight regions, a third of them stored twice so slots are reused and appended
+	std::map<Coord3D, std::vector<uint8_t>> expected;
+	VoxelData voxels(16, 16, 16, allocator);
+	RegionStore store(allocator, jobSystem);
+	store.open(regionsPath());
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int i = 0; i < 600; i++)
+		{
+			const Coord3D coord(Random::RandomInt(-REGION_SIZE, REGION_SIZE - 1), Random::RandomInt(-REGION_SIZE, REGION_SIZE - 1), Random::RandomInt(-REGION_SIZE, REGION_SIZE - 1));
+			if (pass == 1 && (expected.find(coord) == expected.end() || i % 3 != 0))
+			{
+				continue;
+			}
+			fillRandom(voxels, Random::RandomInt(1, 40));
+			store.storeChunk(coord, voxels);
+			expected[coord] = std::vector<uint8_t>(voxels.getData(), voxels.getData() + voxels.getMemoryUsage());
+		}
+		store.flush();
+	}
+	store.close();
+
+	// Every table entry points inside its file, fits its slot and no two slots overlap
+	size_t badEntries = 0;
+	size_t storedEntries = 0;
+	for (int region = 0; region < 8; region++)
+	{
+		const std::vector<unsigned char> file = readFile(regionFile(region & 1 ? 0 : -1, region & 2 ? 0 : -1, region & 4 ? 0 : -1));
+		if (file.size() < REGION_HEADER_SIZE)
+		{
+			badEntries++;
+			continue;
+		}
+		std::map<uint32_t, uint32_t> slots;
+		for (int index = 0; index < REGION_NUM_CHUNKS; index++)
+		{
+			const TableEntry entry = readTableEntry(file, index);
+			if (entry.size == 0)
+			{
+				continue;
+			}
+			storedEntries++;
+			if (entry.offset < REGION_HEADER_SIZE ||
+				entry.size > entry.capacity ||
+				(uint64_t)entry.offset + entry.capacity > file.size() ||
+				!slots.emplace(entry.offset, entry.capacity).second)
+			{
+				badEntries++;
+			}
+		}
+		uint32_t slotEnd = REGION_HEADER_SIZE;
+		for (const auto& slot : slots)
+		{
+			badEntries += slot.first < slotEnd ? 1 : 0;
+			slotEnd = slot.first + slot.second;
+		}
+	}
+	TEST_CHECK(badEntries == 0);
+	TEST_CHECK(storedEntries == expected.size());
+
+	size_t wrongChunks = 0;
+	store.open(regionsPath());
+	for (const auto& pair : expected)
+	{
+		if (!store.loadChunk(pair.first, voxels) ||
+			memcmp(voxels.getData(), pair.second.data(), pair.second.size()) != 0)
+		{
+			wrongChunks++;
+		}
+	}
+	store.close();
+	TEST_CHECK(wrongChunks == 0);
+	Log::Info("[CPUTests] %zu chunks checked in 8 regions", expected.size());
+}
+
+static void benchmarkStore(Allocator& allocator, JobSystem& jobSystem)
+{
+	Random::RandomSeed(12);
+	const int chunkCount = 256;
+	VoxelData voxels(16, 16, 16, allocator);
+	fillRandom(voxels, 8);
+	RegionStore store(allocator, jobSystem);
+	store.open(regionsPath());
+	CPUTests::benchmark("RegionStore store and flush 16^3, per chunk", chunkCount, [&]() {
+		for (int i = 0; i < chunkCount; i++)
+		{
+			store.storeChunk(Coord3D(i % REGION_SIZE, i / REGION_SIZE, 0), voxels);
+		}
+		store.flush();
+	});
+	size_t loadedCount = 0;
+	CPUTests::benchmark("RegionStore load 16^3, per chunk", chunkCount, [&]() {
+		for (int i = 0; i < chunkCount; i++)
+		{
+			loadedCount += store.loadChunk(Coord3D(i % REGION_SIZE, i / REGION_SIZE, 0), voxels) ? 1 : 0;
+		}
+	});
+	store.close();
+	TEST_CHECK(loadedCount > 0);
+}
+
+void RegionStoreTests(Allocator& allocator)
+{
+	removeRegionFiles();
+	// One worker so records are written while the test goes on
+	JobSystem jobSystem(1);
+	testStoreAndReopen(allocator, jobSystem);
+	testSlotReuse(allocator, jobSystem);
+	testDamagedRecords(allocator, jobSystem);
+	removeRegionFiles();
+	testManyChunks(allocator, jobSystem);
+	removeRegionFiles();
+	benchmarkStore(allocator, jobSystem);
+	removeRegionFiles();
+}
@@ -0,0 +1,406 @@
+#include "CPUTests.h"
+
+#include "ArenaOperators.h"
+#include "JobSystem.h"
+#include "NullRenderBackend.h"
+#include "RenderCore.h"
+#include "Texture2D.h"
+#include <algorithm>
+#include <vector>
+
+// Draws queued in random order have to come out of RenderCore sorted by their key, with
+// equal keys in the order they were queued. The state cache may skip any call that would
+// not change what's bound, but never one a draw depends on: a backend that tracks what GL
+// would have bound checks every draw against what it asked for.
+
+static const BlendMode TEST_BLEND_MODES[4] = { BLEND_MODE_DISABLED, BLEND_MODE_DEFAULT, BLEND_MODE_ADDITIVE, BLEND_MODE_SCREEN };
+static const DepthMode TEST_DEPTH_MODES[3] = { DEPTH_MODE_DEFAULT, DEPTH_MODE_DISABLED, { DepthFunc::LessOrEqual, true, false } };
+static const uint32_t TEST_TEXTURE_COUNT = 4;
+static const uint32_t TEST_SHADER_COUNT = 4;
+
+// Counts like the null backend, and also keeps what a real context would have bound
+class RecordingBackend : public NullRenderBackend
+{
+public:
+	struct BoundState {
+		uint32_t activeUnit;
+		uint32_t textures[GLStateCache::MAX_TEXTURE_UNITS];
+		uint32_t vao;
+		bool blendEnabled;
+		BlendFunc srcFunc;
+		BlendFunc dstFunc;
+		bool depthEnabled;
+		DepthFunc depthFunc;
+		bool depthMask;
+	};
+
+	struct RecordedDraw {
+		uint32_t id;
+		BoundState state;
+	};
+
+	RecordingBackend() : m_state(), m_currentID(0), m_repeatedCalls(0), m_textureBinds(0) {}
+
+	void bindVertexArray(const uint32_t vao) override { NullRenderBackend::bindVertexArray(vao); m_repeatedCalls += m_state.vao == vao ? 1 : 0; m_state.vao = vao; }
+	void setActiveTexture(const uint32_t unit) override { NullRenderBackend::setActiveTexture(unit); m_repeatedCalls += m_state.activeUnit == unit ? 1 : 0; m_state.activeUnit = unit; }
+	void bindTexture(const uint32_t texture) override
+	{
+		NullRenderBackend::bindTexture(texture);
+		m_repeatedCalls += m_state.textures[m_state.activeUnit] == texture ? 1 : 0;
+		m_state.textures[m_state.activeUnit] = texture;
+		m_textureBinds++;
+	}
+	void setBlendEnabled(const bool enable) override { NullRenderBackend::setBlendEnabled(enable); m_repeatedCalls += m_state.blendEnabled == enable ? 1 : 0; m_state.blendEnabled = enable; }
+	void setBlendFunc(const BlendFunc srcFunc, const BlendFunc dstFunc) override
+	{
+		NullRenderBackend::setBlendFunc(srcFunc, dstFunc);
+		m_repeatedCalls += m_state.srcFunc == srcFunc && m_state.dstFunc == dstFunc ? 1 : 0;
+		m_state.srcFunc = srcFunc;
+		m_state.dstFunc = dstFunc;
+	}
+	void setDepthTestEnabled(const bool enable) override { NullRenderBackend::setDepthTestEnabled(enable); m_repeatedCalls += m_state.depthEnabled == enable ? 1 : 0; m_state.depthEnabled = enable; }
+	void setDepthFunc(const DepthFunc func) override { NullRenderBackend::setDepthFunc(func); m_repeatedCalls += m_state.depthFunc == func ? 1 : 0; m_state.depthFunc = func; }
+	void setDepthMask(const bool mask) override { NullRenderBackend::setDepthMask(mask); m_repeatedCalls += m_state.depthMask == mask ? 1 : 0; m_state.depthMask = mask; }
+
+	// Every queued draw carries its index in a per draw uniform, set right before it's drawn
+	void setUniform4f(const int32_t location, const glm::vec4& value) override
+	{
+		NullRenderBackend::setUniform4f(location, value);
+		m_currentID = (uint32_t)value.x;
+	}
+	void drawArrays(const DrawMode mode, const uint32_t first, const uint32_t count) override
+	{
+		NullRenderBackend::drawArrays(mode, first, count);
+		m_draws.push_back({ m_currentID, m_state });
+	}
+
+	std::vector<RecordedDraw>& getDraws() { return m_draws; }
+	// Calls that set what was already bound, only the first of each kind after an invalidate should get here
+	uint32_t getRepeatedCalls() const { return m_repeatedCalls; }
+	uint32_t getTextureBinds() const { return m_textureBinds; }
+	void clearRecording() { m_draws.clear(); m_repeatedCalls = 0; m_textureBinds = 0; }
+
+private:
+	BoundState m_state;
+	uint32_t m_currentID;
+	uint32_t m_repeatedCalls;
+	uint32_t m_textureBinds;
+	std::vector<RecordedDraw> m_draws;
+};
+
+struct QueuedDraw {
+	RenderPass pass;
+	uint8_t layer;
+	uint32_t shader;
+	uint32_t texture;
+	uint32_t blend;
+	uint32_t depthMode;
+	uint32_t depth;
+	uint32_t drawData;
+};
+
+static void testSortKey()
+{
+	// Each field outranks everything after it
+	const uint64_t base = RenderSortKey::make(RenderPass::Forward, 3, 5, 7, 2, 100);
+	TEST_CHECK(RenderSortKey::make(RenderPass::Geometry, 255, 0xFFF, 0xFFF, 255, RenderSortKey::MAX_DEPTH) < base);
+	TEST_CHECK(RenderSortKey::make(RenderPass::Forward, 2, 0xFFF, 0xFFF, 255, RenderSortKey::MAX_DEPTH) < base);
+	TEST_CHECK(RenderSortKey::make(RenderPass::Forward, 3, 4, 0xFFF, 255, RenderSortKey::MAX_DEPTH) < base);
+	TEST_CHECK(RenderSortKey::make(RenderPass::Forward, 3, 5, 6, 255, RenderSortKey::MAX_DEPTH) < base);
+	TEST_CHECK(RenderSortKey::make(RenderPass::Forward, 3, 5, 7, 1, RenderSortKey::MAX_DEPTH) < base);
+	TEST_CHECK(RenderSortKey::make(RenderPass::Forward, 3, 5, 7, 2, 99) < base);
+	TEST_CHECK(RenderSortKey::make(RenderPass::GUI, 0, 0, 0, 0, 0) > base);
+
+	// Too far away clamps to the back, IDs past the field width only group with their low bits
+	TEST_CHECK(RenderSortKey::make(RenderPass::Forward, 0, 0, 0, 0, 0xFFFFFFFF) == RenderSortKey::make(RenderPass::Forward, 0, 0, 0, 0, RenderSortKey::MAX_DEPTH));
+	TEST_CHECK(RenderSortKey::make(RenderPass::Forward, 0, 0x1005, 0, 0, 0) == RenderSortKey::make(RenderPass::Forward, 0, 5, 0, 0, 0));
+	TEST_CHECK(RenderSortKey::make(RenderPass::Forward, 0, 0, 0x1007, 0, 0) == RenderSortKey::make(RenderPass::Forward, 0, 0, 7, 0, 0));
+
+	// Nearer is smaller, all the way to the far plane
+	TEST_CHECK(RenderSortKey::depthFromDistance(-1.f, 100.f) == 0 && RenderSortKey::depthFromDistance(1.f, 0.f) == 0);
+	TEST_CHECK(RenderSortKey::depthFromDistance(100.f, 100.f) == RenderSortKey::MAX_DEPTH);
+	TEST_CHECK(RenderSortKey::depthFromDistance(1000.f, 100.f) == RenderSortKey::MAX_DEPTH);
+	size_t unordered = 0;
+	for (int i = 1; i < 1000; i++)
+	{
+		unordered += RenderSortKey::depthFromDistance(i * 0.1f, 100.f) < RenderSortKey::depthFromDistance((i - 1) * 0.1f, 100.f) ? 1 : 0;
+	}
+	TEST_CHECK(unordered == 0);
+}
+
+// Directly on the cache: only changes reach the backend, an invalidate forgets everything
+static void testStateCache()
+{
+	NullRenderBackend backend;
+	GLStateCache cache(backend);
+
+	TEST_CHECK(cache.useProgram(5));
+	TEST_CHECK(!cache.useProgram(5));
+	TEST_CHECK(cache.useProgram(6));
+	TEST_CHECK(cache.bindVertexArray(3) && !cache.bindVertexArray(3));
+	TEST_CHECK(cache.bindArrayBuffer(4) && !cache.bindArrayBuffer(4));
+	TEST_CHECK(backend.getCounters().stateChanges == 4);
+	TEST_CHECK(cache.getCounters().stateChanges == 4 && cache.getCounters().redundantStateChanges == 3);
+
+	// The first bind also selects the unit, switching units costs a second call
+	TEST_CHECK(cache.bindTexture(0, 10));
+	TEST_CHECK(backend.getCounters().stateChanges == 6);
+	TEST_CHECK(!cache.bindTexture(0, 10));
+	TEST_CHECK(cache.bindTexture(1, 10));
+	TEST_CHECK(backend.getCounters().stateChanges == 8);
+	TEST_CHECK(cache.bindTexture(1, 11));
+	TEST_CHECK(backend.getCounters().stateChanges == 9);
+	TEST_CHECK(!cache.bindTexture(0, 10) && !cache.bindTexture(1, 11));
+	// Units past the cached ones always go through and leave the active unit unknown
+	TEST_CHECK(cache.bindTexture(GLStateCache::MAX_TEXTURE_UNITS, 12));
+	TEST_CHECK(backend.getCounters().stateChanges == 11);
+	TEST_CHECK(cache.bindTexture(1, 13));
+	TEST_CHECK(backend.getCounters().stateChanges == 13);
+
+	// Blend functions don't matter while blending is off
+	const uint32_t beforeBlend = backend.getCounters().stateChanges;
+	cache.setBlendMode(BLEND_MODE_DISABLED);
+	TEST_CHECK(backend.getCounters().stateChanges == beforeBlend + 1);
+	cache.setBlendMode({ BlendFunc::Source_Color, BlendFunc::One, false });
+	TEST_CHECK(backend.getCounters().stateChanges == beforeBlend + 1);
+	cache.setBlendMode(BLEND_MODE_DEFAULT);
+	TEST_CHECK(backend.getCounters().stateChanges == beforeBlend + 3);
+	cache.setBlendMode(BLEND_MODE_DEFAULT);
+	cache.setBlendMode(BLEND_MODE_ADDITIVE);
+	TEST_CHECK(backend.getCounters().stateChanges == beforeBlend + 4);
+
+	const uint32_t beforeDepth = backend.getCounters().stateChanges;
+	cache.setDepthMode(DEPTH_MODE_DEFAULT);
+	TEST_CHECK(backend.getCounters().stateChanges == beforeDepth + 3);
+	cache.setDepthMode(DEPTH_MODE_DEFAULT);
+	cache.setDepthMode({ DepthFunc::Less, true, false });
+	TEST_CHECK(backend.getCounters().stateChanges == beforeDepth + 4);
+
+	// Whatever GL has now, the next call of each kind can't be skipped
+	cache.invalidate();
+	const uint32_t beforeInvalidate = backend.getCounters().stateChanges;
+	TEST_CHECK(cache.useProgram(6) && cache.bindVertexArray(3) && cache.bindArrayBuffer(4) && cache.bindTexture(0, 10));
+	cache.setBlendMode(BLEND_MODE_ADDITIVE);
+	cache.setDepthMode({ DepthFunc::Less, true, false });
+	TEST_CHECK(backend.getCounters().stateChanges == beforeInvalidate + 10);
+	TEST_CHECK(cache.getCounters().stateChanges == backend.getCounters().stateChanges);
+
+	cache.resetCounters();
+	TEST_CHECK(cache.getCounters().stateChanges == 0 && cache.getCounters().redundantStateChanges == 0);
+}
+
+struct TestRenderSetup {
+	ShaderID shaders[TEST_SHADER_COUNT];
+	TextureID textures[TEST_TEXTURE_COUNT + 1];     // The first draws untextured
+	uint32_t glTextures[TEST_TEXTURE_COUNT + 1];
+	DrawDataID drawData[2];
+};
+
+static TestRenderSetup setupRenderCore(RenderCore& renderCore, Allocator& allocator)
+{
+	TestRenderSetup setup = {};
+	for (uint32_t i = 0; i < TEST_SHADER_COUNT; i++)
+	{
+		setup.shaders[i] = renderCore.getShaderIDFromSource("", "", "CPUTests shader " + std::to_string(i));
+	}
+	for (uint32_t i = 1; i <= TEST_TEXTURE_COUNT; i++)
+	{
+		// Made up handles, nothing is ever sampled
+		setup.glTextures[i] = 100 + i;
+		Texture2D* texture = CUSTOM_NEW(Texture2D, allocator)(setup.glTextures[i], 64, 64, TextureParams{ TextureFormat::RGBA8, TextureWrap::Repeat, TextureFilter::Nearest, false });
+		setup.textures[i] = renderCore.getTextureCache().addTexture(texture, "CPUTests texture " + std::to_string(i));
+	}
+	setup.drawData[0] = renderCore.createDrawData(ColoredVertexConfig);
+	setup.drawData[1] = renderCore.createDrawData(TexturedVertex3DConfig);
+	return setup;
+}
+
+static std::vector<QueuedDraw> randomDraws(const size_t count)
+{
+	std::vector<QueuedDraw> draws(count);
+	for (QueuedDraw& draw : draws)
+	{
+		draw.pass = (RenderPass)Random::RandomInt(0, 3);
+		draw.layer = (uint8_t)Random::RandomInt(0, 2);
+		draw.shader = (uint32_t)Random::RandomInt(0, TEST_SHADER_COUNT - 1);
+		draw.texture = (uint32_t)Random::RandomInt(0, TEST_TEXTURE_COUNT);
+		draw.blend = (uint32_t)Random::RandomInt(0, 3);
+		draw.depthMode = (uint32_t)Random::RandomInt(0, 2);
+		// Few distinct depths so plenty of keys are equal
+		draw.depth = (uint32_t)Random::RandomInt(0, 3) * 1000;
+		draw.drawData = (uint32_t)Random::RandomInt(0, 1);
+	}
+	return draws;
+}
+
+static DrawParameters drawParameters(const TestRenderSetup& setup, const QueuedDraw& draw)
+{
+	DrawParameters params = {};
+	params.drawDataID = setup.drawData[draw.drawData];
+	params.textureCount = draw.texture != 0 ? 1 : 0;
+	params.textureIDs[0] = setup.textures[draw.texture];
+	params.shaderID = setup.shaders[draw.shader];
+	params.blendMode = TEST_BLEND_MODES[draw.blend];
+	params.depthMode = TEST_DEPTH_MODES[draw.depthMode];
+	return params;
+}
+
+// The draw was made with everything it asked for bound
+static bool hasState(const TestRenderSetup& setup, const QueuedDraw& draw, const RecordingBackend::BoundState& state)
+{
+	const BlendMode& blend = TEST_BLEND_MODES[draw.blend];
+	const DepthMode& depth = TEST_DEPTH_MODES[draw.depthMode];
+	if (draw.texture != 0 && state.textures[0] != setup.glTextures[draw.texture])
+	{
+		return false;
+	}
+	if (state.blendEnabled != blend.enable || (blend.enable && (state.srcFunc != blend.srcFunc || state.dstFunc != blend.dstFunc)))
+	{
+		return false;
+	}
+	return state.depthEnabled == depth.enable && state.depthFunc == depth.func && state.depthMask == depth.mask;
+}
+
+static void testSubmitOrder(Allocator& allocator)
+{
+	Random::RandomSeed(21);
+	JobSystem jobSystem(0);
+	RecordingBackend backend;
+	RenderCore renderCore(allocator, jobSystem, backend);
+	const TestRenderSetup setup = setupRenderCore(renderCore, allocator);
+	const glm::mat4 matrices[2] = { glm::mat4(), glm::mat4(2.f) };
+
+	size_t wrongOrder = 0;
+	size_t wrongState = 0;
+	uint32_t queuedStateChanges = 0;
+	uint32_t immediateStateChanges = 0;
+	uint32_t queuedTextureBinds = 0;
+	uint32_t immediateTextureBinds = 0;
+	const int frameCount = 10;
+	std::vector<std::pair<BlendMode, DepthMode>> stateIDs;
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		const std::vector<QueuedDraw> draws = randomDraws(2000);
+
+		renderCore.beginFrame();
+		backend.resetCounters();
+		backend.clearRecording();
+		for (size_t i = 0; i < draws.size(); i++)
+		{
+			const QueuedDraw& draw = draws[i];
+			RenderCommand& command = renderCore.queueDraw(draw.pass, draw.layer, drawParameters(setup, draw),
+				matrices[i % 2], DrawMode::Triangles, nullptr, 0, draw.depth);
+			command.setUniform("drawIndex", glm::vec4((float)i));
+		}
+		renderCore.submitCommands();
+
+		// Render states get their IDs as they're first queued, and keep them
+		std::vector<uint64_t> keys;
+		for (const QueuedDraw& draw : draws)
+		{
+			const std::pair<BlendMode, DepthMode> state(TEST_BLEND_MODES[draw.blend], TEST_DEPTH_MODES[draw.depthMode]);
+			auto it = std::find(stateIDs.begin(), stateIDs.end(), state);
+			if (it == stateIDs.end())
+			{
+				it = stateIDs.insert(stateIDs.end(), state);
+			}
+			keys.push_back(RenderSortKey::make(draw.pass, draw.layer, setup.shaders[draw.shader],
+				setup.glTextures[draw.texture], (uint8_t)(it - stateIDs.begin()), draw.depth));
+		}
+		std::vector<uint32_t> expected(draws.size());
+		for (uint32_t i = 0; i < expected.size(); i++)
+		{
+			expected[i] = i;
+		}
+		std::stable_sort(expected.begin(), expected.end(), [&keys](const uint32_t a, const uint32_t b) { return keys[a] < keys[b]; });
+
+		std::vector<RecordingBackend::RecordedDraw>& recorded = backend.getDraws();
+		TEST_CHECK(recorded.size() == draws.size());
+		for (size_t i = 0; i < recorded.size() && i < expected.size(); i++)
+		{
+			wrongOrder += recorded[i].id != expected[i] ? 1 : 0;
+			wrongState += hasState(setup, draws[recorded[i].id], recorded[i].state) ? 0 : 1;
+		}
+		// Only the first call of each kind after the submission's invalidate can be a repeat
+		TEST_CHECK(backend.getRepeatedCalls() <= 10);
+		queuedTextureBinds += backend.getTextureBinds();
+
+		// The frame stats hold exactly what reached the backend
+		const uint32_t backendStateChanges = backend.getCounters().stateChanges;
+		renderCore.endFrame();
+		renderCore.beginFrame();
+		const RenderFrameStats& stats = renderCore.getLastFrameStats();
+		TEST_CHECK(stats.commands == draws.size() && stats.drawCalls == draws.size());
+		TEST_CHECK(stats.stateChanges == backendStateChanges);
+		TEST_CHECK(stats.redundantStateChanges > stats.stateChanges);
+		queuedStateChanges += stats.stateChanges;
+
+		// The same draws made right away, in the order they came
+		backend.resetCounters();
+		backend.clearRecording();
+		for (size_t i = 0; i < draws.size(); i++)
+		{
+			renderCore.draw(drawParameters(setup, draws[i]), matrices[i % 2], DrawMode::Triangles, nullptr, 0);
+		}
+		for (size_t i = 0; i < backend.getDraws().size(); i++)
+		{
+			wrongState += hasState(setup, draws[i], backend.getDraws()[i].state) ? 0 : 1;
+		}
+		immediateStateChanges += backend.getCounters().stateChanges;
+		immediateTextureBinds += backend.getTextureBinds();
+		renderCore.endFrame();
+	}
+	TEST_CHECK(wrongOrder == 0);
+	TEST_CHECK(wrongState == 0);
+	// Sorting groups textures and states, the cache then skips what stays the same. Blend and
+	// depth state sort below texture, so they still change between most draws
+	TEST_CHECK(queuedStateChanges * 2 < immediateStateChanges);
+	TEST_CHECK(queuedTextureBinds * 4 < immediateTextureBinds);
+	Log::Info("[CPUTests] %d frames of 2000 draws: %u state changes and %u texture binds sorted, %u and %u immediate",
+		frameCount, queuedStateChanges, queuedTextureBinds, immediateStateChanges, immediateTextureBinds);
+
+	renderCore.terminate();
+}
+
+static void benchmarkSubmit(Allocator& allocator)
+{
+	Random::RandomSeed(22);
+	JobSystem jobSystem(0);
+	NullRenderBackend backend;
+	RenderCore renderCore(allocator, jobSystem, backend);
+	const TestRenderSetup setup = setupRenderCore(renderCore, allocator);
+	const glm::mat4 matrix;
+	const std::vector<QueuedDraw> draws = randomDraws(10000);
+	std::vector<DrawParameters> params;
+	for (const QueuedDraw& draw : draws)
+	{
+		params.push_back(drawParameters(setup, draw));
+	}
+
+	CPUTests::benchmark("RenderCore queue, sort and submit, per draw", draws.size(), [&]() {
+		renderCore.beginFrame();
+		for (size_t i = 0; i < draws.size(); i++)
+		{
+			renderCore.queueDraw(draws[i].pass, draws[i].layer, params[i], matrix, DrawMode::Triangles, nullptr, 0, draws[i].depth);
+		}
+		renderCore.submitCommands();
+		renderCore.endFrame();
+	});
+	CPUTests::benchmark("RenderCore immediate draws, per draw", draws.size(), [&]() {
+		renderCore.beginFrame();
+		for (size_t i = 0; i < draws.size(); i++)
+		{
+			renderCore.draw(params[i], matrix, DrawMode::Triangles, nullptr, 0);
+		}
+		renderCore.endFrame();
+	});
+	renderCore.terminate();
+}
+
+void RenderCommandTests(Allocator& allocator)
+{
+	testSortKey();
+	testStateCache();
+	testSubmitOrder(allocator);
+	benchmarkSubmit(allocator);
+}
@@ -0,0 +1,293 @@
+#include "CPUTests.h"
+
+#include "ButtonNode.h"
+#include "FileUtil.h"
+#include "GUI.h"
+#include "Injector.h"
+#include "Input.h"
+#include "JobSystem.h"
+#include "LabelNode.h"
+#include "NullRenderBackend.h"
+#include "OSWindow.h"
+#include "Options.h"
+#include "ParticleSystem.h"
+#include "Particles.h"
+#include "RenderCore.h"
+#include "Renderer2D.h"
+#include "VoxelRenderer.h"
+#include "WindowNode.h"
+#include <vector>
+
+// The renderers run their real frames against the null backend, which counts what would have
+// reached GL. A frame has to cost the same every time it's drawn with the same contents, each
+// queued chunk or light has to add exactly one draw, the chunk palette only goes up when it
+// changed, and everything a renderer creates on the backend has to be gone after it terminates.
+
+static const uint32_t TEST_CHUNK_COUNT = 64;
+static const uint32_t TEST_CHUNK_VERTS = 6 * 1024;
+static const uint32_t TEST_LIGHT_COUNT = 8;
+
+struct HeadlessFrame {
+	RenderFrameStats stats;
+	RenderBackendCounters counters;
+};
+
+// Drawn between a begin and end frame, the stats come from the next begin
+template<typename Func>
+static HeadlessFrame drawFrame(RenderCore& renderCore, NullRenderBackend& backend, const Func& func)
+{
+	renderCore.beginFrame();
+	backend.resetCounters();
+	func();
+	HeadlessFrame frame;
+	frame.counters = backend.getCounters();
+	renderCore.endFrame();
+	renderCore.beginFrame();
+	frame.stats = renderCore.getLastFrameStats();
+	renderCore.endFrame();
+	return frame;
+}
+
+static void testVoxelRenderer(Allocator& allocator)
+{
+	JobSystem jobSystem(0);
+	NullRenderBackend backend;
+	RenderCore renderCore(allocator, jobSystem, backend);
+	Options options;
+	VoxelRenderer renderer(renderCore, allocator, options);
+
+	backend.resetCounters();
+	renderer.initialize();
+	const RenderBackendCounters initialized = backend.getCounters();
+	TEST_CHECK(initialized.texturesCreated > 0 && initialized.frameBuffersCreated > 0);
+
+	// Chunks keep their vertices on the backend, only the first frame uploads them
+	std::vector<DrawDataID> chunks;
+	for (uint32_t i = 0; i < TEST_CHUNK_COUNT; i++)
+	{
+		const DrawDataID drawDataID = renderer.createVoxelChunkDrawData();
+		VoxelChunkVertexData* verts = renderer.bufferVoxelChunkVerts(TEST_CHUNK_VERTS, drawDataID);
+		for (uint32_t v = 0; v < TEST_CHUNK_VERTS; v++)
+		{
+			verts[v] = VoxelChunkVertex::pack(glm::ivec3(v % 16, (v / 16) % 16, v / 256 % 16), v % 6, (uint8_t)(v % 256), v % 4);
+		}
+		chunks.push_back(drawDataID);
+	}
+	LightInstance light = {};
+	light.position = glm::vec4(0.f, 8.f, 0.f, 16.f);
+	light.color = COLOR_WHITE;
+	light.attenuation = glm::vec3(1.f, 0.f, 0.f);
+	light.active = true;
+	auto queueScene = [&](const uint32_t chunkCount, const uint32_t lightCount) {
+		for (uint32_t i = 0; i < chunkCount; i++)
+		{
+			renderer.queueVoxelChunk(chunks[i], glm::vec3(i % 8, 0, i / 8) * 16.f, 0.25f);
+		}
+		for (uint32_t i = 0; i < lightCount; i++)
+		{
+			renderer.queueLight(light);
+		}
+		renderer.bufferCube(glm::vec3(), glm::vec3(1.f), glm::quat(), COLOR_WHITE, glm::vec3(1.f));
+		renderer.buffer3DLine(glm::vec3(), glm::vec3(1.f), COLOR_RED, COLOR_GREEN);
+	};
+
+	const HeadlessFrame first = drawFrame(renderCore, backend, [&]() { queueScene(TEST_CHUNK_COUNT, TEST_LIGHT_COUNT); renderer.flush(); });
+	TEST_CHECK(first.counters.uploads >= TEST_CHUNK_COUNT);
+	TEST_CHECK(first.counters.textureUpdates == 1);
+	const HeadlessFrame empty = drawFrame(renderCore, backend, [&]() { queueScene(0, 0); renderer.flush(); });
+	const HeadlessFrame chunksOnly = drawFrame(renderCore, backend, [&]() { queueScene(TEST_CHUNK_COUNT, 0); renderer.flush(); });
+	const HeadlessFrame full = drawFrame(renderCore, backend, [&]() { queueScene(TEST_CHUNK_COUNT, TEST_LIGHT_COUNT); renderer.flush(); });
+	const HeadlessFrame again = drawFrame(renderCore, backend, [&]() { queueScene(TEST_CHUNK_COUNT, TEST_LIGHT_COUNT); renderer.flush(); });
+
+	// Same contents cost the same, every chunk and light is one draw on top of the fixed passes
+	TEST_CHECK(chunksOnly.stats.drawCalls == empty.stats.drawCalls + TEST_CHUNK_COUNT);
+	TEST_CHECK(full.stats.drawCalls == chunksOnly.stats.drawCalls + TEST_LIGHT_COUNT);
+	TEST_CHECK(full.counters.drawCalls == full.stats.drawCalls);
+	TEST_CHECK(again.stats.drawCalls == full.stats.drawCalls && again.stats.stateChanges == full.stats.stateChanges);
+	TEST_CHECK(again.counters.uploads == full.counters.uploads && again.counters.uploads < first.counters.uploads);
+	TEST_CHECK(again.counters.uniformsSet == full.counters.uniformsSet);
+	// The view block only goes up when the matrix changes, chunks share the camera and all lights share
+	// one matrix, which goes in once and is swapped back out by the 2D draw after them
+	TEST_CHECK(chunksOnly.counters.uniformBufferUpdates == empty.counters.uniformBufferUpdates);
+	TEST_CHECK(full.counters.uniformBufferUpdates == chunksOnly.counters.uniformBufferUpdates + 2);
+	// G-buffer, lit frame and screen, each cleared once
+	TEST_CHECK(full.counters.clears == 3);
+	TEST_CHECK(full.counters.textureUpdates == 0);
+	TEST_CHECK(full.counters.texturesCreated == 0 && full.counters.frameBuffersCreated == 0);
+
+	const HeadlessFrame edited = drawFrame(renderCore, backend, [&]() {
+		renderer.setChunkMaterial(7, COLOR_RED, glm::vec3(0.5f));
+		renderer.setChunkMaterial(8, COLOR_GREEN, glm::vec3(0.5f));
+		queueScene(TEST_CHUNK_COUNT, TEST_LIGHT_COUNT);
+		renderer.flush();
+	});
+	TEST_CHECK(edited.counters.textureUpdates == 1);
+	TEST_CHECK(edited.stats.drawCalls == full.stats.drawCalls);
+	Log::Info("[CPUTests] VoxelRenderer frame of %u chunks and %u lights: %u draws, %u state changes, %u uniforms, %u block updates",
+		TEST_CHUNK_COUNT, TEST_LIGHT_COUNT, full.stats.drawCalls, full.stats.stateChanges, full.counters.uniformsSet, full.counters.uniformBufferUpdates);
+
+	CPUTests::benchmark("VoxelRenderer flush, per chunk", TEST_CHUNK_COUNT, [&]() {
+		renderCore.beginFrame();
+		queueScene(TEST_CHUNK_COUNT, TEST_LIGHT_COUNT);
+		renderer.flush();
+		renderCore.endFrame();
+	});
+
+	for (const DrawDataID drawDataID : chunks)
+	{
+		renderer.destroyVoxelChunkDrawData(drawDataID);
+	}
+	backend.resetCounters();
+	renderer.terminate();
+	TEST_CHECK(backend.getCounters().texturesDestroyed == initialized.texturesCreated);
+	TEST_CHECK(backend.getCounters().frameBuffersDestroyed == initialized.frameBuffersCreated);
+	renderCore.terminate();
+}
+
+static void bufferSprites(Renderer2D& renderer, const TextureID textureID, const uint32_t count)
+{
+	TexturedVertex3DData* verts = renderer.bufferTexturedTriangles(count * 6, textureID);
+	for (uint32_t i = 0; i < count * 6; i++)
+	{
+		verts[i] = { glm::vec3((float)i, (float)(i % 6), 0.f), glm::vec2() };
+	}
+	ColoredVertex3DData* colored = renderer.bufferColoredTriangles(count * 3);
+	for (uint32_t i = 0; i < count * 3; i++)
+	{
+		colored[i] = { glm::vec3((float)i, 0.f, 0.f), COLOR_WHITE };
+	}
+	for (uint32_t i = 0; i < count; i += 4)
+	{
+		renderer.drawLine(glm::vec2((float)i, 0.f), glm::vec2((float)i, 1.f), COLOR_RED, 0.f);
+	}
+}
+
+static void testRenderer2D(Allocator& allocator)
+{
+	JobSystem jobSystem(0);
+	NullRenderBackend backend;
+	RenderCore renderCore(allocator, jobSystem, backend);
+	Renderer2D renderer(renderCore, allocator);
+	renderer.initialize();
+	const TextureID textureID = renderCore.getTextureID(FileUtil::GetPath() + "Data/Particles/SparkTex.png", true);
+	const uint32_t spriteCount = 1000;
+
+	// Lines, colored and textured triangles, one draw each whatever the count
+	const HeadlessFrame sprites = drawFrame(renderCore, backend, [&]() { bufferSprites(renderer, textureID, spriteCount); renderer.flush(); });
+	const HeadlessFrame again = drawFrame(renderCore, backend, [&]() { bufferSprites(renderer, textureID, spriteCount); renderer.flush(); });
+	TEST_CHECK(sprites.stats.drawCalls == 3 && sprites.stats.commands == 3);
+	TEST_CHECK(again.stats.drawCalls == sprites.stats.drawCalls && again.stats.stateChanges == sprites.stats.stateChanges);
+	const uint32_t spriteBytes = spriteCount * (6 * sizeof(TexturedVertex3DData) + 3 * sizeof(ColoredVertex3DData)) + spriteCount / 4 * 2 * sizeof(ColoredVertex3DData);
+	TEST_CHECK(sprites.stats.bytesUploaded == spriteBytes);
+	// The ortho matrix goes into the view block once and stays there while it doesn't change
+	TEST_CHECK(sprites.counters.uniformBufferUpdates == 1 && again.counters.uniformBufferUpdates == 0);
+
+	// Flushing empties the buffers, so nothing is drawn twice
+	const HeadlessFrame empty = drawFrame(renderCore, backend, [&]() { renderer.flush(); });
+	TEST_CHECK(empty.stats.bytesUploaded == 0);
+	TEST_CHECK(empty.stats.drawCalls < sprites.stats.drawCalls);
+
+	CPUTests::benchmark("Renderer2D flush, per sprite", spriteCount, [&]() {
+		renderCore.beginFrame();
+		bufferSprites(renderer, textureID, spriteCount);
+		renderer.flush();
+		renderCore.endFrame();
+	});
+
+	renderer.terminate();
+	renderCore.terminate();
+}
+
+static void testParticles(Allocator& allocator)
+{
+	JobSystem jobSystem(0);
+	NullRenderBackend backend;
+	RenderCore renderCore(allocator, jobSystem, backend);
+	Renderer2D renderer(renderCore, allocator);
+	renderer.initialize();
+	Injector injector(allocator);
+	injector.mapInstance<RenderCore>(renderCore);
+	injector.mapInstance<Renderer2D>(renderer);
+
+	{
+		Particles particles(allocator, injector);
+		const ParticleSystemID systemID = particles.create(FileUtil::GetPath() + "Data/Particles/", "Sparks2D.plist");
+		ParticleSystem* system = particles.getSystemByID(systemID);
+		TEST_CHECK(system != nullptr);
+		if (system)
+		{
+			system->setActive(true);
+		}
+		for (int i = 0; i < 60 && system && system->getParticleCount() == 0; i++)
+		{
+			particles.update(1.0 / 60.0);
+		}
+		TEST_CHECK(system && system->getParticleCount() > 0);
+
+		// All of a system's particles go out as impostors in one draw
+		const HeadlessFrame frame = drawFrame(renderCore, backend, [&]() { particles.update(1.0 / 60.0); particles.draw(); renderer.flush(); });
+		const HeadlessFrame none = drawFrame(renderCore, backend, [&]() { renderer.flush(); });
+		TEST_CHECK(frame.stats.drawCalls == none.stats.drawCalls + 1);
+		TEST_CHECK(frame.stats.bytesUploaded >= system->getParticleCount() * sizeof(ImpostorVertexData));
+
+		const size_t particleCount = system ? system->getParticleCount() : 0;
+		CPUTests::benchmark("Particles update and draw, per particle", particleCount, [&]() {
+			renderCore.beginFrame();
+			particles.update(1.0 / 60.0);
+			particles.draw();
+			renderer.flush();
+			renderCore.endFrame();
+		});
+		particles.destroy(systemID);
+	}
+
+	injector.clear();
+	renderer.terminate();
+	renderCore.terminate();
+}
+
+static void testGUI(Allocator& allocator)
+{
+	JobSystem jobSystem(0);
+	NullRenderBackend backend;
+	RenderCore renderCore(allocator, jobSystem, backend);
+	OSWindow window;
+	Input input(window);
+	GUI gui(allocator, renderCore, input, window);
+	gui.initialize();
+
+	const uint32_t windowCount = 16;
+	for (uint32_t i = 0; i < windowCount; i++)
+	{
+		WindowNode* windowNode = gui.createDefaultWindow(glm::vec2(200.f, 160.f), "Window");
+		windowNode->setPosition(glm::vec3(i * 20.f, i * 10.f, 0.f));
+		windowNode->addChild(gui.createDefaultButton(glm::vec2(80.f, 24.f), "Button"));
+		windowNode->addChild(gui.createLabelNode("Label", GUI::FONT_DEFAULT, 14));
+		gui.getRoot().addChild(windowNode);
+	}
+
+	// Sprites, text and lines each batch into a draw per texture
+	const HeadlessFrame frame = drawFrame(renderCore, backend, [&]() { gui.draw(); });
+	const HeadlessFrame again = drawFrame(renderCore, backend, [&]() { gui.draw(); });
+	TEST_CHECK(frame.stats.drawCalls > 0 && frame.stats.drawCalls <= 8);
+	TEST_CHECK(again.stats.drawCalls == frame.stats.drawCalls && again.stats.bytesUploaded == frame.stats.bytesUploaded);
+	TEST_CHECK(again.stats.stateChanges == frame.stats.stateChanges);
+	Log::Info("[CPUTests] GUI frame of %u windows: %u draws, %u bytes", windowCount, frame.stats.drawCalls, frame.stats.bytesUploaded);
+
+	CPUTests::benchmark("GUI draw, per window", windowCount, [&]() {
+		renderCore.beginFrame();
+		gui.draw();
+		renderCore.endFrame();
+	});
+
+	gui.terminate();
+	renderCore.terminate();
+}
+
+void RenderHeadlessTests(Allocator& allocator)
+{
+	testVoxelRenderer(allocator);
+	testRenderer2D(allocator);
+	testParticles(allocator);
+	testGUI(allocator);
+}
@@ -0,0 +1,233 @@
+#include "CPUTests.h"
+
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+// Grid queries have to find exactly the entities a brute force distance check finds,
+// benchmarked the way EntityManager uses the grid: every entity searches around itself each frame
+
+static const float SEARCH_RADIUS = 8.f;    // ENTITY_SEARCH_RADIUS and ENTITY_GRID_CELL_SIZE
+static const float WORLD_HALF_SIZE = 150.f;
+
+static void randomPositions(std::vector<glm::vec3>& positions, const size_t count)
+{
+	// Index 0 is unused, entity IDs start at 1
+	positions.resize(count + 1);
+	for (size_t i = 1; i <= count; i++)
+	{
+		// Flattened, the world is much wider than it is tall
+		positions[i] = randomPosition(WORLD_HALF_SIZE) * glm::vec3(1.f, 0.1f, 1.f);
+	}
+}
+
+static bool isInRange(const glm::vec3& a, const glm::vec3& b, const float radius)
+{
+	const glm::vec3 delta = a - b;
+	return glm::dot(delta, delta) <= radius * radius;
+}
+
+static void bruteForceQuery(
+	const std::vector<glm::vec3>& positions,
+	const std::vector<bool>& inGrid,
+	const glm::vec3& center,
+	const float radius,
+	std::vector<EntityID>& result)
+{
+	for (EntityID id = 1; id < positions.size(); id++)
+	{
+		if (inGrid[id] && isInRange(positions[id], center, radius))
+		{
+			result.push_back(id);
+		}
+	}
+}
+
+static void checkQuery(
+	const SpatialHashGrid& grid,
+	const std::vector<glm::vec3>& positions,
+	const std::vector<bool>& inGrid,
+	const glm::vec3& center,
+	const float radius)
+{
+	std::vector<EntityID> candidates;
+	const size_t added = grid.query(center, radius, candidates);
+	TEST_CHECK(added == candidates.size());
+
+	// Candidates can be further away than the radius but never outside the overlapped cells
+	const float cellReach = radius + grid.getCellSize();
+	std::vector<EntityID> found;
+	for (const EntityID id : candidates)
+	{
+		TEST_CHECK(id < positions.size() && inGrid[id]);
+		if (id >= positions.size())
+		{
+			continue;
+		}
+		const glm::vec3 delta = glm::abs(positions[id] - center);
+		TEST_CHECK(delta.x <= cellReach && delta.y <= cellReach && delta.z <= cellReach);
+		if (isInRange(positions[id], center, radius))
+		{
+			found.push_back(id);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+	TEST_CHECK(std::adjacent_find(candidates.begin(), candidates.end()) == candidates.end());
+
+	std::vector<EntityID> expected;
+	bruteForceQuery(positions, inGrid, center, radius, expected);
+	std::sort(found.begin(), found.end());
+	TEST_CHECK(found == expected);
+}
+
+static void testAgainstBruteForce()
+{
+	Random::RandomSeed(12);
+	const size_t entityCount = 2000;
+	std::vector<glm::vec3> positions;
+	randomPositions(positions, entityCount);
+	std::vector<bool> inGrid(entityCount + 1, false);
+
+	SpatialHashGrid grid(SEARCH_RADIUS);
+	for (EntityID id = 1; id <= entityCount; id++)
+	{
+		grid.update(id, positions[id]);
+		inGrid[id] = true;
+	}
+
+	for (int frame = 0; frame < 20; frame++)
+	{
+		// Small moves mostly stay in their cell, some entities jump across the world or leave the grid
+		for (EntityID id = 1; id <= entityCount; id++)
+		{
+			const int action = Random::RandomInt(0, 99);
+			if (action < 2)
+			{
+				grid.remove(id);
+				inGrid[id] = false;
+				continue;
+			}
+			if (action < 4)
+			{
+				positions[id] = glm::vec3(randomRange(-WORLD_HALF_SIZE, WORLD_HALF_SIZE), 0.f, randomRange(-WORLD_HALF_SIZE, WORLD_HALF_SIZE));
+			}
+			else
+			{
+				positions[id] += glm::vec3(randomRange(-2.f, 2.f), randomRange(-0.5f, 0.5f), randomRange(-2.f, 2.f));
+			}
+			grid.update(id, positions[id]);
+			inGrid[id] = true;
+		}
+
+		for (EntityID id = 1; id <= entityCount; id++)
+		{
+			TEST_CHECK(grid.contains(id) == inGrid[id]);
+		}
+		for (int query = 0; query < 100; query++)
+		{
+			const EntityID id = (EntityID)Random::RandomInt(1, (int)entityCount);
+			checkQuery(grid, positions, inGrid, positions[id], SEARCH_RADIUS);
+			const glm::vec3 center = glm::vec3(randomRange(-WORLD_HALF_SIZE, WORLD_HALF_SIZE), 0.f, randomRange(-WORLD_HALF_SIZE, WORLD_HALF_SIZE));
+			checkQuery(grid, positions, inGrid, center, randomRange(0.f, 40.f));
+		}
+	}
+
+	// More cells than are occupied, takes the path walking the occupied cells
+	checkQuery(grid, positions, inGrid, glm::vec3(0.f), 1000000.f);
+	checkQuery(grid, positions, inGrid, glm::vec3(WORLD_HALF_SIZE, 0.f, 0.f), 500.f);
+
+	// Negative cell coordinates and cell borders
+	SpatialHashGrid borders(SEARCH_RADIUS);
+	const glm::vec3 borderPositions[4] = {
+		glm::vec3(-8.f, 0.f, 0.f), glm::vec3(-0.001f, 0.f, 0.f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(8.f, -8.f, 8.f),
+	};
+	std::vector<glm::vec3> borderList(1);
+	for (EntityID id = 1; id <= 4; id++)
+	{
+		borders.update(id, borderPositions[id - 1]);
+		borderList.push_back(borderPositions[id - 1]);
+	}
+	const std::vector<bool> allInGrid(5, true);
+	checkQuery(borders, borderList, allInGrid, glm::vec3(0.f), 8.f);
+	checkQuery(borders, borderList, allInGrid, glm::vec3(-4.f, 0.f, 0.f), 4.f);
+	checkQuery(borders, borderList, allInGrid, glm::vec3(4.f, -4.f, 4.f), 7.f);
+
+	grid.clear();
+	for (EntityID id = 1; id <= entityCount; id++)
+	{
+		TEST_CHECK(!grid.contains(id));
+	}
+	std::vector<EntityID> result;
+	TEST_CHECK(grid.query(glm::vec3(0.f), 1000.f, result) == 0);
+}
+
+static void benchmarkEntityCount(const size_t entityCount)
+{
+	Random::RandomSeed((int)entityCount);
+	std::vector<glm::vec3> positions;
+	randomPositions(positions, entityCount);
+
+	SpatialHashGrid grid(SEARCH_RADIUS);
+	for (EntityID id = 1; id <= entityCount; id++)
+	{
+		grid.update(id, positions[id]);
+	}
+
+	std::vector<EntityID> result;
+	size_t bruteForceHits = 0;
+	char name[96];
+	snprintf(name, sizeof(name), "Brute force search, %zu entities, per entity", entityCount);
+	CPUTests::benchmark(name, entityCount, [&]() {
+		bruteForceHits = 0;
+		for (EntityID id = 1; id <= entityCount; id++)
+		{
+			for (EntityID other = 1; other <= entityCount; other++)
+			{
+				if (isInRange(positions[other], positions[id], SEARCH_RADIUS))
+				{
+					bruteForceHits++;
+				}
+			}
+		}
+	});
+
+	size_t gridHits = 0;
+	snprintf(name, sizeof(name), "Grid search, %zu entities, per entity", entityCount);
+	CPUTests::benchmark(name, entityCount, [&]() {
+		gridHits = 0;
+		for (EntityID id = 1; id <= entityCount; id++)
+		{
+			result.clear();
+			grid.query(positions[id], SEARCH_RADIUS, result);
+			for (const EntityID other : result)
+			{
+				if (isInRange(positions[other], positions[id], SEARCH_RADIUS))
+				{
+					gridHits++;
+				}
+			}
+		}
+	});
+	TEST_CHECK(gridHits == bruteForceHits);
+
+	// Every entity moving a little each frame, as EntityManager::Update does
+	snprintf(name, sizeof(name), "Grid update, %zu entities, per entity", entityCount);
+	float step = 0.5f;
+	CPUTests::benchmark(name, entityCount, [&]() {
+		for (EntityID id = 1; id <= entityCount; id++)
+		{
+			positions[id].x += step;
+			grid.update(id, positions[id]);
+		}
+		step = -step;
+	});
+}
+
+void SpatialHashGridTests(Allocator& allocator)
+{
+	testAgainstBruteForce();
+	benchmarkEntityCount(1000);
+	benchmarkEntityCount(4000);
+	benchmarkEntityCount(10000);
+}
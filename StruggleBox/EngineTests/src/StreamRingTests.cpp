@@ -0,0 +1,255 @@
+#include "CPUTests.h"
+
+#include "StreamRing.h"
+#include <deque>
+#include <vector>
+
+// Hand picked cases for the edges of the ring bookkeeping, then random frames checked
+// against a list of the ranges still in flight: nothing handed out may overlap them.
+
+static void testAlignment()
+{
+	StreamRing ring(256);
+	TEST_CHECK(ring.allocate(3, 1) == 0);
+	// Padding up to the alignment counts as used until the frame retires
+	TEST_CHECK(ring.allocate(4, 16) == 16);
+	TEST_CHECK(ring.getUsed() == 20);
+	TEST_CHECK(ring.allocate(1, 0) == 20);
+	TEST_CHECK(ring.allocate(8, 64) == 64);
+	TEST_CHECK(ring.getUsed() == 72);
+
+	TEST_CHECK(ring.allocate(0, 4) == StreamRing::NO_SPACE);
+	TEST_CHECK(ring.allocate(257, 4) == StreamRing::NO_SPACE);
+	TEST_CHECK(ring.getUsed() == 72);
+}
+
+static void testWrap()
+{
+	StreamRing ring(100);
+	TEST_CHECK(ring.allocate(60, 1) == 0);
+	TEST_CHECK(ring.endFrame());
+	TEST_CHECK(ring.allocate(30, 1) == 60);
+	TEST_CHECK(ring.endFrame());
+	ring.retireFrame();
+	TEST_CHECK(ring.getUsed() == 30);
+
+	// Doesn't fit after the head and the free space at the front ends at the tail, 60
+	TEST_CHECK(ring.allocate(70, 1) == StreamRing::NO_SPACE);
+	TEST_CHECK(ring.getUsed() == 30);
+	// Fits at the front, the 10 bytes skipped at the end count as used
+	TEST_CHECK(ring.allocate(60, 1) == 0);
+	TEST_CHECK(ring.getUsed() == 100);
+	TEST_CHECK(ring.allocate(1, 1) == StreamRing::NO_SPACE);
+}
+
+static void testFull()
+{
+	// An allocation ending at the capacity wraps the head onto the tail
+	StreamRing whole(64);
+	TEST_CHECK(whole.allocate(64, 1) == 0);
+	TEST_CHECK(whole.getUsed() == 64);
+	TEST_CHECK(whole.allocate(1, 1) == StreamRing::NO_SPACE);
+
+	// Head catching up with the tail from behind
+	StreamRing ring(64);
+	TEST_CHECK(ring.allocate(32, 1) == 0);
+	TEST_CHECK(ring.endFrame());
+	TEST_CHECK(ring.allocate(32, 1) == 32);
+	TEST_CHECK(ring.endFrame());
+	ring.retireFrame();
+	TEST_CHECK(ring.allocate(32, 1) == 0);
+	TEST_CHECK(ring.getUsed() == 64);
+	TEST_CHECK(ring.allocate(1, 1) == StreamRing::NO_SPACE);
+	TEST_CHECK(ring.endFrame());
+	ring.retireFrame();
+	TEST_CHECK(ring.allocate(32, 1) == 32);
+}
+
+static void testFramesInFlight()
+{
+	StreamRing ring(1024);
+	for (uint32_t frame = 0; frame < StreamRing::MAX_FRAMES_IN_FLIGHT; frame++)
+	{
+		TEST_CHECK(ring.allocate(16, 16) != StreamRing::NO_SPACE);
+		TEST_CHECK(ring.endFrame());
+	}
+	TEST_CHECK(ring.getFramesInFlight() == StreamRing::MAX_FRAMES_IN_FLIGHT);
+	TEST_CHECK(!ring.endFrame());
+	TEST_CHECK(ring.getFramesInFlight() == StreamRing::MAX_FRAMES_IN_FLIGHT);
+	ring.retireFrame();
+	TEST_CHECK(ring.getFramesInFlight() == StreamRing::MAX_FRAMES_IN_FLIGHT - 1);
+	TEST_CHECK(ring.endFrame());
+}
+
+static void testRetireWrapped()
+{
+	StreamRing ring(100);
+	TEST_CHECK(ring.allocate(70, 1) == 0);
+	TEST_CHECK(ring.endFrame());
+	TEST_CHECK(ring.allocate(20, 1) == 70);
+	TEST_CHECK(ring.endFrame());
+	ring.retireFrame();
+	TEST_CHECK(ring.getUsed() == 20);
+
+	// Skips the 10 bytes at the end, the frame owns those too
+	TEST_CHECK(ring.allocate(20, 1) == 0);
+	TEST_CHECK(ring.getUsed() == 50);
+	TEST_CHECK(ring.endFrame());
+	ring.retireFrame();
+	TEST_CHECK(ring.getUsed() == 30);
+	ring.retireFrame();
+	TEST_CHECK(ring.getUsed() == 0);
+	TEST_CHECK(ring.getFramesInFlight() == 0);
+
+	// Nothing to retire is fine
+	ring.retireFrame();
+	TEST_CHECK(ring.getUsed() == 0);
+	// Empty again, so it starts over at the front
+	TEST_CHECK(ring.allocate(100, 1) == 0);
+}
+
+static void testReset()
+{
+	StreamRing ring(512);
+	TEST_CHECK(ring.allocate(200, 16) == 0);
+	TEST_CHECK(ring.endFrame());
+	TEST_CHECK(ring.allocate(200, 16) == 208);
+	TEST_CHECK(ring.endFrame());
+	TEST_CHECK(ring.allocate(100, 16) == StreamRing::NO_SPACE);
+	ring.reset();
+	TEST_CHECK(ring.getUsed() == 0);
+	TEST_CHECK(ring.getFramesInFlight() == 0);
+	TEST_CHECK(ring.getCapacity() == 512);
+	TEST_CHECK(ring.allocate(512, 16) == 0);
+}
+
+struct LiveRange {
+	size_t start;
+	size_t size;
+};
+
+static bool overlaps(const LiveRange& a, const LiveRange& b)
+{
+	return a.start < b.start + b.size && b.start < a.start + a.size;
+}
+
+static void testAgainstLiveRanges()
+{
+	Random::RandomSeed(23);
+	const size_t capacity = 4096;
+	const size_t alignments[4] = { 1, 4, 16, 256 };
+	StreamRing ring(capacity);
+	std::deque<std::vector<LiveRange>> framesInFlight;
+	std::vector<LiveRange> currentFrame;
+	size_t allocated = 0;
+	size_t refused = 0;
+
+	for (int frame = 0; frame < 20000; frame++)
+	{
+		const int allocationCount = Random::RandomInt(0, 12);
+		for (int i = 0; i < allocationCount; i++)
+		{
+			const size_t size = (size_t)Random::RandomInt(1, 700);
+			const size_t alignment = alignments[Random::RandomInt(0, 3)];
+			const size_t offset = ring.allocate(size, alignment);
+			if (offset == StreamRing::NO_SPACE)
+			{
+				refused++;
+				continue;
+			}
+			const LiveRange range = { offset, size };
+			TEST_CHECK(offset % alignment == 0);
+			TEST_CHECK(offset + size <= capacity);
+			bool overlapFound = false;
+			for (const std::vector<LiveRange>& ranges : framesInFlight)
+			{
+				for (const LiveRange& live : ranges)
+				{
+					overlapFound |= overlaps(range, live);
+				}
+			}
+			for (const LiveRange& live : currentFrame)
+			{
+				overlapFound |= overlaps(range, live);
+			}
+			TEST_CHECK(!overlapFound);
+			currentFrame.push_back(range);
+			allocated++;
+		}
+
+		size_t liveBytes = 0;
+		for (const std::vector<LiveRange>& ranges : framesInFlight)
+		{
+			for (const LiveRange& live : ranges)
+			{
+				liveBytes += live.size;
+			}
+		}
+		for (const LiveRange& live : currentFrame)
+		{
+			liveBytes += live.size;
+		}
+		TEST_CHECK(ring.getUsed() >= liveBytes && ring.getUsed() <= capacity);
+
+		// The GPU falls behind at random, endFrame refusing means the oldest frame has to be waited for
+		while (!ring.endFrame())
+		{
+			TEST_CHECK(framesInFlight.size() == StreamRing::MAX_FRAMES_IN_FLIGHT);
+			ring.retireFrame();
+			framesInFlight.pop_front();
+		}
+		framesInFlight.push_back(currentFrame);
+		currentFrame.clear();
+		while (!framesInFlight.empty() && Random::RandomInt(0, 2) == 0)
+		{
+			ring.retireFrame();
+			framesInFlight.pop_front();
+		}
+		TEST_CHECK(ring.getFramesInFlight() == framesInFlight.size());
+	}
+
+	while (!framesInFlight.empty())
+	{
+		ring.retireFrame();
+		framesInFlight.pop_front();
+	}
+	TEST_CHECK(ring.getUsed() == 0);
+	TEST_CHECK(ring.allocate(capacity, 256) == 0);
+	Log::Info("[CPUTests] StreamRing handed out %zu ranges, refused %zu", allocated, refused);
+}
+
+static void benchmarkAllocate()
+{
+	// Sized like a frame of 2D sprites and text, retired three frames later
+	const size_t allocationsPerFrame = 1000;
+	const int frameCount = 1000;
+	StreamRing ring(64 * 1024 * 1024);
+	size_t refused = 0;
+	CPUTests::benchmark("StreamRing::allocate, per allocation", allocationsPerFrame * frameCount, [&]() {
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			for (size_t i = 0; i < allocationsPerFrame; i++)
+			{
+				refused += ring.allocate(64 + (i & 511), 16) == StreamRing::NO_SPACE ? 1 : 0;
+			}
+			if (!ring.endFrame())
+			{
+				ring.retireFrame();
+				ring.endFrame();
+			}
+		}
+	});
+	TEST_CHECK(refused == 0);
+}
+
+void StreamRingTests(Allocator& allocator)
+{
+	testAlignment();
+	testWrap();
+	testFull();
+	testFramesInFlight();
+	testRetireWrapped();
+	testReset();
+	testAgainstLiveRanges();
+	benchmarkAllocate();
+}
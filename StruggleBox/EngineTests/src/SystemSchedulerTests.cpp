@@ -0,0 +1,310 @@
+#include "CPUTests.h"
+
+#include "JobSystem.h"
+#include "SystemScheduler.h"
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Stages built by hand for a few resource patterns, then random sets of systems run
+// through the scheduler with no workers, one and several. Every frame has to leave
+// exactly the data running the same systems one after another in added order does.
+
+static const size_t WORKER_COUNTS[3] = { 0, 1, 4 };
+
+static void testStages()
+{
+	JobSystem jobSystem(0);
+	SystemScheduler scheduler(jobSystem);
+	TEST_CHECK(scheduler.getNumStages() == 0);
+	scheduler.run();
+
+	std::vector<std::string> order;
+	auto record = [&order](const char* name) {
+		return [&order, name]() { order.push_back(name); };
+	};
+	// Readers of the same resource share a stage
+	scheduler.addSystem("a", 1 << 0, 1 << 1, record("a"));
+	scheduler.addSystem("b", 1 << 0, 1 << 2, record("b"));
+	TEST_CHECK(scheduler.getNumStages() == 1);
+	// Reading what a writes waits for a
+	scheduler.addSystem("c", 1 << 1, 0, record("c"));
+	TEST_CHECK(scheduler.getNumStages() == 2);
+	// Writing what a and b read waits for both, but not for c
+	scheduler.addSystem("d", 0, 1 << 0, record("d"));
+	TEST_CHECK(scheduler.getNumStages() == 2);
+	// Writing what c reads waits for c
+	scheduler.addSystem("e", 0, 1 << 1, record("e"));
+	TEST_CHECK(scheduler.getNumStages() == 3);
+	// Nothing in common with anything
+	scheduler.addSystem("f", 1 << 5, 1 << 6, record("f"));
+	// Two writers of the same resource never share a stage
+	scheduler.addSystem("g", 0, 1 << 6, record("g"));
+	scheduler.addSystem("h", 0, 1 << 6, record("h"));
+	TEST_CHECK(scheduler.getNumSystems() == 8);
+	TEST_CHECK(scheduler.getNumStages() == 3);
+
+	scheduler.run();
+	const std::vector<std::string> expected = { "a", "b", "f", "c", "d", "g", "e", "h" };
+	TEST_CHECK(order == expected);
+
+	// Systems without functions aren't added
+	Log::Info("[CPUTests] Adding systems without update functions, the scheduler errors that follow are expected");
+	scheduler.addSystem("missing", 0, 0, nullptr);
+	scheduler.addParallelSystem("missing count", 0, 0, 16, nullptr, [](size_t) {});
+	scheduler.addParallelSystem("missing update", 0, 0, 16, []() { return (size_t)1; }, nullptr);
+	TEST_CHECK(scheduler.getNumSystems() == 8);
+}
+
+// Each resource is an array of values, systems mix what they read into what they write
+const int RESOURCE_COUNT = 8;
+const size_t VALUE_COUNT = 1000;
+
+typedef std::vector<std::vector<uint64_t>> Resources;
+
+struct TestSystem {
+	SystemResources reads;
+	SystemResources writes;
+	bool parallel;
+	size_t grainSize;
+	uint64_t seed;
+};
+
+static inline uint64_t mix(const uint64_t value, const uint64_t input)
+{
+	uint64_t result = (value ^ input) * 6364136223846793005ull + 1442695040888963407ull;
+	return result ^ (result >> 29);
+}
+
+// Parallel systems only touch their own index
+static void updateIndex(const TestSystem& system, Resources& resources, const size_t index)
+{
+	uint64_t input = system.seed;
+	for (int resource = 0; resource < RESOURCE_COUNT; resource++)
+	{
+		if (system.reads & (1 << resource))
+		{
+			input = mix(input, resources[resource][index]);
+		}
+	}
+	for (int resource = 0; resource < RESOURCE_COUNT; resource++)
+	{
+		if (system.writes & (1 << resource))
+		{
+			resources[resource][index] = mix(resources[resource][index], input + resource);
+		}
+	}
+}
+
+// Serial systems read their neighbours too, and write in order so each value depends on the last
+static void update(const TestSystem& system, Resources& resources)
+{
+	uint64_t carry = system.seed;
+	for (size_t index = 0; index < VALUE_COUNT; index++)
+	{
+		const size_t neighbour = (index * 7 + 3) % VALUE_COUNT;
+		for (int resource = 0; resource < RESOURCE_COUNT; resource++)
+		{
+			if (system.reads & (1 << resource))
+			{
+				carry = mix(carry, resources[resource][neighbour]);
+			}
+		}
+		for (int resource = 0; resource < RESOURCE_COUNT; resource++)
+		{
+			if (system.writes & (1 << resource))
+			{
+				resources[resource][index] = mix(resources[resource][index], carry);
+			}
+		}
+	}
+}
+
+static SystemResources randomResources(const int chance)
+{
+	SystemResources resources = 0;
+	for (int resource = 0; resource < RESOURCE_COUNT; resource++)
+	{
+		if (Random::RandomInt(0, 99) < chance)
+		{
+			resources |= 1 << resource;
+		}
+	}
+	return resources;
+}
+
+static Resources makeResources()
+{
+	Resources resources(RESOURCE_COUNT, std::vector<uint64_t>(VALUE_COUNT));
+	for (int resource = 0; resource < RESOURCE_COUNT; resource++)
+	{
+		for (size_t index = 0; index < VALUE_COUNT; index++)
+		{
+			resources[resource][index] = resource * VALUE_COUNT + index;
+		}
+	}
+	return resources;
+}
+
+static void testAgainstSerial(const size_t workerCount)
+{
+	Random::RandomSeed(13);
+	JobSystem jobSystem(workerCount);
+	const int frameCount = 4;
+	size_t wrongCount = 0;
+	size_t stageCount = 0;
+	size_t systemCount = 0;
+	for (int setup = 0; setup < 60; setup++)
+	{
+		std::vector<TestSystem> systems(Random::RandomInt(1, 16));
+		for (TestSystem& system : systems)
+		{
+			system.reads = randomResources(25);
+			system.writes = randomResources(Random::RandomInt(0, 3) == 0 ? 0 : 15);
+			system.parallel = Random::RandomInt(0, 2) != 0;
+			system.grainSize = (size_t)Random::RandomInt(0, 300);
+			system.seed = (uint64_t)Random::RandomInt(0, 1 << 30);
+		}
+
+		Resources expected = makeResources();
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			for (const TestSystem& system : systems)
+			{
+				if (system.parallel)
+				{
+					for (size_t index = 0; index < VALUE_COUNT; index++)
+					{
+						updateIndex(system, expected, index);
+					}
+				}
+				else
+				{
+					update(system, expected);
+				}
+			}
+		}
+
+		Resources scheduled = makeResources();
+		Resources* resources = &scheduled;
+		SystemScheduler scheduler(jobSystem);
+		std::vector<std::thread::id> serialThreads;
+		std::mutex serialThreadsMutex;
+		for (const TestSystem& system : systems)
+		{
+			const TestSystem* systemPtr = &system;
+			if (system.parallel)
+			{
+				scheduler.addParallelSystem("parallel", system.reads, system.writes, system.grainSize,
+					[]() { return VALUE_COUNT; },
+					[systemPtr, resources](const size_t index) { updateIndex(*systemPtr, *resources, index); });
+			}
+			else
+			{
+				scheduler.addSystem("serial", system.reads, system.writes, [systemPtr, resources, &serialThreads, &serialThreadsMutex]() {
+					update(*systemPtr, *resources);
+					std::lock_guard<std::mutex> lock(serialThreadsMutex);
+					serialThreads.push_back(std::this_thread::get_id());
+				});
+			}
+		}
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			scheduler.run();
+		}
+		wrongCount += scheduled != expected ? 1 : 0;
+		stageCount += scheduler.getNumStages();
+		systemCount += systems.size();
+
+		// Serial systems stay on the thread calling run()
+		for (const std::thread::id& thread : serialThreads)
+		{
+			wrongCount += thread != std::this_thread::get_id() ? 1 : 0;
+		}
+		TEST_CHECK(jobSystem.numJobs() == 0);
+	}
+	TEST_CHECK(wrongCount == 0);
+	Log::Info("[CPUTests] SystemScheduler with %zu workers, %zu systems in %zu stages matched the serial results",
+		workerCount, systemCount, stageCount);
+}
+
+// Costly enough per index that splitting the work pays off
+static inline float work(const float value)
+{
+	float result = value;
+	for (int i = 0; i < 64; i++)
+	{
+		result = result * 0.999f + 0.5f;
+	}
+	return result;
+}
+
+static void benchmarkRun()
+{
+	// Shaped like the entity update: four families that only touch themselves, one that reads them all
+	const size_t workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	const size_t familySize = 20000;
+	const int familyCount = 4;
+	std::vector<std::vector<float>> families(familyCount, std::vector<float>(familySize, 1.f));
+	float total = 0.f;
+
+	JobSystem jobSystem(workerCount);
+	SystemScheduler scheduler(jobSystem);
+	for (int family = 0; family < familyCount; family++)
+	{
+		std::vector<float>* values = &families[family];
+		scheduler.addParallelSystem("family", 0, 1 << family, 64,
+			[values]() { return values->size(); },
+			[values](const size_t index) { (*values)[index] = work((*values)[index]); });
+	}
+	scheduler.addSystem("total", (1 << familyCount) - 1, 1 << familyCount, [&families, &total]() {
+		total = 0.f;
+		for (const std::vector<float>& values : families)
+		{
+			total += values[0];
+		}
+	});
+	TEST_CHECK(scheduler.getNumStages() == 2);
+
+	char name[96];
+	snprintf(name, sizeof(name), "SystemScheduler::run, %zu workers, per component", workerCount);
+	CPUTests::benchmark(name, familySize * familyCount, [&]() {
+		scheduler.run();
+	});
+	CPUTests::benchmark("Serial update loop, per component", familySize * familyCount, [&]() {
+		for (std::vector<float>& values : families)
+		{
+			for (float& value : values)
+			{
+				value = work(value);
+			}
+		}
+		total = 0.f;
+		for (const std::vector<float>& values : families)
+		{
+			total += values[0];
+		}
+	});
+	// Every family went through the same number of updates
+	size_t wrongCount = 0;
+	for (const std::vector<float>& values : families)
+	{
+		for (const float value : values)
+		{
+			wrongCount += value != families[0][0] ? 1 : 0;
+		}
+	}
+	TEST_CHECK(wrongCount == 0);
+}
+
+void SystemSchedulerTests(Allocator& allocator)
+{
+	testStages();
+	for (const size_t workerCount : WORKER_COUNTS)
+	{
+		testAgainstSerial(workerCount);
+	}
+	benchmarkRun();
+}
@@ -0,0 +1,351 @@
+#include "CPUTests.h"
+
+#include "AllocationTrace.h"
+#include "FileUtil.h"
+#include "FreeListAllocator.h"
+#include "TLSFAllocator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// The TLSF allocator and the FreeList allocator it replaced go through the same random
+// churn: every block has to be aligned, inside the pool and keep its contents until it
+// is freed. A recorded trace of a frame-like workload is then replayed against both
+// for latency and fragmentation. Writes its scratch trace next to the executable.
+
+const size_t TEST_HEAP_SIZE = 64 * 1024 * 1024;
+
+struct LiveBlock {
+	uint8_t* p;
+	size_t size;
+	uint8_t fill;
+};
+
+static size_t randomSize()
+{
+	const int bucket = Random::RandomInt(0, 99);
+	if (bucket < 70)
+	{
+		return (size_t)Random::RandomInt(1, 256);
+	}
+	if (bucket < 95)
+	{
+		return (size_t)Random::RandomInt(257, 8192);
+	}
+	return (size_t)Random::RandomInt(8193, 256 * 1024);
+}
+
+static bool isFilled(const LiveBlock& block)
+{
+	for (size_t i = 0; i < block.size; i++)
+	{
+		if (block.p[i] != block.fill)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void stressAllocator(Allocator& allocator, const char* name, const bool knowsAllocationSize)
+{
+	Random::RandomSeed(16);
+	const uint8_t alignments[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+	const uint8_t* poolStart = (const uint8_t*)allocator.getStart();
+	const uint8_t* poolEnd = poolStart + allocator.getSize();
+	std::vector<LiveBlock> live;
+	size_t misplaced = 0;
+	size_t overwritten = 0;
+	size_t failed = 0;
+
+	for (int operation = 0; operation < 200000; operation++)
+	{
+		// Keeps a couple of thousand blocks alive, sometimes drops most of them at once
+		const bool allocate = live.empty() || (live.size() < 2000 && Random::RandomInt(0, 99) < 55);
+		if (allocate)
+		{
+			const size_t size = randomSize();
+			const uint8_t alignment = alignments[Random::RandomInt(0, 7)];
+			uint8_t* p = (uint8_t*)allocator.allocate(size, alignment);
+			if (!p)
+			{
+				failed++;
+				continue;
+			}
+			if ((uintptr_t)p % alignment != 0 || p < poolStart || p + size > poolEnd ||
+				(knowsAllocationSize && allocator.getAllocationSize(p) < size))
+			{
+				misplaced++;
+			}
+			const LiveBlock block = { p, size, (uint8_t)Random::RandomInt(1, 255) };
+			memset(block.p, block.fill, block.size);
+			live.push_back(block);
+		}
+		else
+		{
+			const size_t index = (size_t)Random::RandomInt(0, (int)live.size() - 1);
+			overwritten += isFilled(live[index]) ? 0 : 1;
+			allocator.deallocate(live[index].p);
+			live[index] = live.back();
+			live.pop_back();
+		}
+		if (operation % 50000 == 49999)
+		{
+			TEST_CHECK(allocator.getNumAllocations() == live.size());
+			while (live.size() > 100)
+			{
+				overwritten += isFilled(live.back()) ? 0 : 1;
+				allocator.deallocate(live.back().p);
+				live.pop_back();
+			}
+		}
+	}
+	TEST_CHECK(misplaced == 0);
+	TEST_CHECK(failed == 0);
+	TEST_CHECK(allocator.getNumAllocations() == live.size());
+	for (const LiveBlock& block : live)
+	{
+		overwritten += isFilled(block) ? 0 : 1;
+		allocator.deallocate(block.p);
+	}
+	TEST_CHECK(overwritten == 0);
+	TEST_CHECK(allocator.getNumAllocations() == 0 && allocator.getUsedMemory() == 0);
+
+	// Everything freed has merged back into one block
+	void* whole = allocator.allocate(allocator.getSize() * 9 / 10, 16);
+	TEST_CHECK(whole != nullptr);
+	if (whole)
+	{
+		allocator.deallocate(whole);
+	}
+	Log::Info("[CPUTests] %s survived the random churn", name);
+}
+
+static void stressThreads(Allocator& allocator, const char* name)
+{
+	const int threadCount = 4;
+	std::vector<size_t> overwritten(threadCount, 0);
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < threadCount; thread++)
+	{
+		threads.emplace_back([&allocator, &overwritten, thread]() {
+			// Random isn't thread safe, each thread runs its own generator
+			uint32_t state = 2166136261u + thread;
+			auto next = [&state]() {
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				return state;
+			};
+			std::vector<LiveBlock> live;
+			for (int operation = 0; operation < 50000; operation++)
+			{
+				if (live.empty() || (live.size() < 500 && next() % 2 == 0))
+				{
+					const size_t size = 1 + next() % 2048;
+					uint8_t* p = (uint8_t*)allocator.allocate(size, 16);
+					if (!p)
+					{
+						overwritten[thread]++;
+						continue;
+					}
+					const LiveBlock block = { p, size, (uint8_t)(1 + thread * 50 + next() % 50) };
+					memset(block.p, block.fill, block.size);
+					live.push_back(block);
+				}
+				else
+				{
+					const size_t index = next() % live.size();
+					overwritten[thread] += isFilled(live[index]) ? 0 : 1;
+					allocator.deallocate(live[index].p);
+					live[index] = live.back();
+					live.pop_back();
+				}
+			}
+			for (const LiveBlock& block : live)
+			{
+				overwritten[thread] += isFilled(block) ? 0 : 1;
+				allocator.deallocate(block.p);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	size_t wrongCount = 0;
+	for (const size_t count : overwritten)
+	{
+		wrongCount += count;
+	}
+	TEST_CHECK(wrongCount == 0);
+	TEST_CHECK(allocator.getNumAllocations() == 0 && allocator.getUsedMemory() == 0);
+	Log::Info("[CPUTests] %s survived %i threads at once", name, threadCount);
+}
+
+static void testBatches(TLSFAllocator& allocator)
+{
+	std::vector<void*> blocks(1000, nullptr);
+	TEST_CHECK(allocator.allocateBatch(48, blocks.size(), blocks.data()) == blocks.size());
+	size_t wrongCount = 0;
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		wrongCount += ((uintptr_t)blocks[i] % 16 != 0 || allocator.getAllocationSize(blocks[i]) < 48) ? 1 : 0;
+		memset(blocks[i], (int)(i & 0xFF), 48);
+	}
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		const LiveBlock block = { (uint8_t*)blocks[i], 48, (uint8_t)(i & 0xFF) };
+		wrongCount += isFilled(block) ? 0 : 1;
+	}
+	TEST_CHECK(wrongCount == 0);
+	TEST_CHECK(allocator.getNumAllocations() == blocks.size());
+	allocator.deallocateBatch(blocks.data(), blocks.size());
+	TEST_CHECK(allocator.getNumAllocations() == 0 && allocator.getUsedMemory() == 0);
+
+	// Stops at what fits instead of failing the whole batch
+	const size_t blockSize = allocator.getSize() / 8;
+	TEST_CHECK(allocator.allocateBatch(blockSize, 16, blocks.data()) == 7);
+	allocator.deallocateBatch(blocks.data(), 7);
+	TEST_CHECK(allocator.getNumAllocations() == 0);
+}
+
+// Per frame scratch that dies at the end of the frame, plus a slowly changing set of longer lived blocks
+static void runFrameWorkload(Allocator& allocator, size_t& allocationCount)
+{
+	Random::RandomSeed(17);
+	std::vector<void*> longLived;
+	std::vector<void*> frame;
+	for (int frameIndex = 0; frameIndex < 400; frameIndex++)
+	{
+		const int scratchCount = Random::RandomInt(200, 600);
+		for (int i = 0; i < scratchCount; i++)
+		{
+			frame.push_back(allocator.allocate(randomSize() / 4 + 1, Random::RandomInt(0, 9) == 0 ? 64 : 8));
+			allocationCount++;
+		}
+		for (int i = Random::RandomInt(0, 30); i > 0; i--)
+		{
+			if (!longLived.empty() && (longLived.size() > 3000 || Random::RandomInt(0, 2) == 0))
+			{
+				const size_t index = (size_t)Random::RandomInt(0, (int)longLived.size() - 1);
+				allocator.deallocate(longLived[index]);
+				longLived[index] = longLived.back();
+				longLived.pop_back();
+			}
+			else
+			{
+				longLived.push_back(allocator.allocate(randomSize(), 16));
+				allocationCount++;
+			}
+		}
+		for (void* p : frame)
+		{
+			allocator.deallocate(p);
+		}
+		frame.clear();
+	}
+	for (void* p : longLived)
+	{
+		allocator.deallocate(p);
+	}
+}
+
+static void logReplay(const char* name, const AllocationReplayResult& result)
+{
+	Log::Info("[CPUTests] %s: allocate median %.0fns, 99th %.0fns, deallocate median %.0fns, 99th %.0fns, fragmentation %.1f%%",
+		name, result.allocateMedianNs, result.allocate99thNs, result.deallocateMedianNs, result.deallocate99thNs,
+		result.fragmentation * 100.f);
+}
+
+static void testTraceReplay(unsigned char* heap)
+{
+	// Recorded from a TLSF allocator serving the workload
+	AllocationTrace recorded;
+	size_t allocationCount = 0;
+	{
+		TLSFAllocator recordingAllocator(TEST_HEAP_SIZE, heap);
+		recordingAllocator.setTrace(&recorded);
+		runFrameWorkload(recordingAllocator, allocationCount);
+		recordingAllocator.setTrace(nullptr);
+	}
+	TEST_CHECK(recorded.getNumEvents() == allocationCount * 2);
+	TEST_CHECK(recorded.getPeakRequestedSize() > 0 && recorded.getPeakRequestedSize() < TEST_HEAP_SIZE / 2);
+
+	// Saved and loaded back unchanged
+	const std::string scratchPath = FileUtil::GetPath() + "CPUTests_AllocationTrace.tmp";
+	TEST_CHECK(recorded.save(scratchPath));
+	AllocationTrace trace;
+	TEST_CHECK(trace.load(scratchPath));
+	TEST_CHECK(trace.getNumEvents() == recorded.getNumEvents());
+	TEST_CHECK(trace.getPeakRequestedSize() == recorded.getPeakRequestedSize());
+
+	AllocationReplayResult freeListResult;
+	{
+		FreeListAllocator freeListAllocator(TEST_HEAP_SIZE, heap);
+		freeListResult = trace.replay(freeListAllocator);
+		TEST_CHECK(freeListAllocator.getNumAllocations() == 0);
+	}
+	AllocationReplayResult tlsfResult;
+	{
+		TLSFAllocator tlsfAllocator(TEST_HEAP_SIZE, heap);
+		tlsfResult = trace.replay(tlsfAllocator);
+		TEST_CHECK(tlsfAllocator.getNumAllocations() == 0);
+	}
+	for (const AllocationReplayResult* result : { &freeListResult, &tlsfResult })
+	{
+		TEST_CHECK(result->numAllocations == allocationCount);
+		TEST_CHECK(result->numDeallocations == allocationCount);
+		TEST_CHECK(result->numFailed == 0);
+		TEST_CHECK(result->peakUsedMemory >= trace.getPeakRequestedSize());
+		TEST_CHECK(result->fragmentation >= 0.f && result->fragmentation <= 1.f);
+	}
+	Log::Info("[CPUTests] Replaying %zu allocation events, peak %zu bytes requested", trace.getNumEvents(), trace.getPeakRequestedSize());
+	logReplay("FreeListAllocator", freeListResult);
+	logReplay("TLSFAllocator", tlsfResult);
+
+	// Anything but a whole trace doesn't load
+	Log::Info("[CPUTests] Loading damaged traces, the trace errors that follow are expected");
+	std::ifstream input(scratchPath.c_str(), std::ios::in | std::ios::binary);
+	std::vector<char> bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	input.close();
+	{
+		std::ofstream output(scratchPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		output.write(bytes.data(), bytes.size() / 2);
+	}
+	TEST_CHECK(!trace.load(scratchPath));
+	TEST_CHECK(trace.getNumEvents() == 0);
+	bytes[0] ^= 0x5A;
+	{
+		std::ofstream output(scratchPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		output.write(bytes.data(), bytes.size());
+	}
+	TEST_CHECK(!trace.load(scratchPath));
+	std::remove(scratchPath.c_str());
+}
+
+void TLSFAllocatorTests(Allocator& allocator)
+{
+	unsigned char* heap = (unsigned char*)malloc(TEST_HEAP_SIZE);
+	TEST_CHECK(heap != nullptr);
+	if (!heap)
+	{
+		return;
+	}
+	{
+		TLSFAllocator tlsfAllocator(TEST_HEAP_SIZE, heap);
+		stressAllocator(tlsfAllocator, "TLSFAllocator", true);
+		stressThreads(tlsfAllocator, "TLSFAllocator");
+		testBatches(tlsfAllocator);
+	}
+	{
+		FreeListAllocator freeListAllocator(TEST_HEAP_SIZE, heap);
+		stressAllocator(freeListAllocator, "FreeListAllocator", false);
+		stressThreads(freeListAllocator, "FreeListAllocator");
+	}
+	testTraceReplay(heap);
+	free(heap);
+}
@@ -21,6 +21,7 @@
 #include "VoxelTestScene.h"
 #include "SceneManager.h"
 #include "RenderCore.h"
+#include "CPUTests.h"
 
 TestsMenu::TestsMenu(Injector& injector, Allocator& allocator, Renderer2D& renderer, Input& input, OSWindow& window, Options& options, StatTracker& statTracker)
 	: GUIScene("Engine Tests Menu", allocator, renderer.getRenderCore(), input, window, options, statTracker)
@@ -86,6 +87,14 @@ void TestsMenu::Initialize()
 		m_injector.getInstance<SceneManager>().AddActiveScene(&testScene);
 		});
 	m_gui.getRoot().addChild(buttonCompute);
+	buttonPosY -= buttonSpacing;
+	ButtonNode* buttonCPU = createMenuButton("CPU Tests");
+	buttonCPU->setPosition(glm::vec3(hW, buttonPosY, 1.f));
+	buttonCPU->setCallback([this](bool) {
+		// Blocks until every suite is done, results go to the log
+		CPUTests::run(m_allocator, nullptr);
+		});
+	m_gui.getRoot().addChild(buttonCPU);
 }
 
 void TestsMenu::Update(const double delta)
@@ -0,0 +1,323 @@
+#include "CPUTests.h"
+
+#include "TLSFAllocator.h"
+#include "ThreadCacheAllocator.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Size class lists have to take blocks from the parent REFILL_COUNT at a time and hand half
+// of them back once more than MAX_CACHED_BLOCKS are cached, which collectStats counts.
+// Threads allocating and freeing each other's blocks must never be handed a block that is
+// still in use: every block carries a tag of its owner that has to survive until it is freed.
+
+const size_t THREAD_CACHE_HEAP_SIZE = 64 * 1024 * 1024;
+
+static void testBatches()
+{
+	TLSFAllocator* parent = allocator::newVirtualTLSFAllocator(THREAD_CACHE_HEAP_SIZE);
+	TEST_CHECK(parent != nullptr);
+	if (!parent)
+	{
+		return;
+	}
+	{
+		ThreadCacheAllocator heap(*parent);
+		heap.collectStats();
+
+		// The first allocation makes the thread's cache and takes a whole batch
+		const size_t blockCount = ThreadCacheAllocator::REFILL_COUNT * 8;
+		std::vector<void*> blocks;
+		blocks.push_back(heap.allocate(24));
+		ThreadCacheStats stats = heap.collectStats();
+		TEST_CHECK(stats.numRefills == 1 && stats.numReturns == 0);
+		const size_t parentAllocationsWithCache = parent->getNumAllocations();
+		TEST_CHECK(parentAllocationsWithCache >= ThreadCacheAllocator::REFILL_COUNT);
+
+		for (size_t i = 1; i < ThreadCacheAllocator::REFILL_COUNT; i++)
+		{
+			blocks.push_back(heap.allocate(17 + i % 16));
+		}
+		stats = heap.collectStats();
+		TEST_CHECK(stats.numRefills == 0);
+		TEST_CHECK(parent->getNumAllocations() == parentAllocationsWithCache);
+
+		while (blocks.size() < blockCount)
+		{
+			blocks.push_back(heap.allocate(32));
+		}
+		stats = heap.collectStats();
+		TEST_CHECK(stats.numRefills == blockCount / ThreadCacheAllocator::REFILL_COUNT - 1);
+		TEST_CHECK(parent->getNumAllocations() == parentAllocationsWithCache + blockCount - ThreadCacheAllocator::REFILL_COUNT);
+		TEST_CHECK(heap.getNumAllocations() == blockCount);
+
+		// Freed blocks stay cached until the list passes MAX_CACHED_BLOCKS, then half go back at once
+		const size_t otherParentAllocations = parentAllocationsWithCache - ThreadCacheAllocator::REFILL_COUNT;
+		size_t liveBlocks = blockCount;
+		size_t cachedBlocks = 0;
+		size_t expectedReturns = 0;
+		size_t wrongParentCounts = 0;
+		for (void* p : blocks)
+		{
+			heap.deallocate(p);
+			liveBlocks--;
+			if (++cachedBlocks > ThreadCacheAllocator::MAX_CACHED_BLOCKS)
+			{
+				cachedBlocks -= ThreadCacheAllocator::MAX_CACHED_BLOCKS / 2;
+				expectedReturns++;
+			}
+			wrongParentCounts += parent->getNumAllocations() != otherParentAllocations + liveBlocks + cachedBlocks ? 1 : 0;
+		}
+		stats = heap.collectStats();
+		TEST_CHECK(expectedReturns > 1);
+		TEST_CHECK(stats.numReturns == expectedReturns && stats.numRefills == 0);
+		TEST_CHECK(wrongParentCounts == 0);
+		TEST_CHECK(heap.getNumAllocations() == 0 && heap.getUsedMemory() == 0);
+
+		// Cached blocks are used again before anything new is taken
+		for (size_t i = 0; i < cachedBlocks; i++)
+		{
+			blocks[i] = heap.allocate(32);
+		}
+		TEST_CHECK(heap.collectStats().numRefills == 0);
+		for (size_t i = 0; i < cachedBlocks; i++)
+		{
+			heap.deallocate(blocks[i]);
+		}
+
+		// Too large or too aligned goes straight to the parent
+		const size_t parentAllocations = parent->getNumAllocations();
+		void* large = heap.allocate(ThreadCacheAllocator::MAX_CACHED_SIZE + 1);
+		void* aligned = heap.allocate(64, 64);
+		TEST_CHECK(parent->getNumAllocations() == parentAllocations + 2);
+		TEST_CHECK(((uintptr_t)aligned & 63) == 0);
+		// Once freed a small aligned block is like any other and joins the cache
+		heap.deallocate(large);
+		heap.deallocate(aligned);
+		TEST_CHECK(parent->getNumAllocations() == parentAllocations + 1);
+		stats = heap.collectStats();
+		TEST_CHECK(stats.numRefills == 0 && stats.numReturns == 0);
+	}
+	// Destroying the allocator gives every cached block back
+	TEST_CHECK(parent->getNumAllocations() == 0);
+	allocator::deleteVirtualTLSFAllocator(*parent);
+}
+
+struct TaggedBlock {
+	uint32_t* p;
+	uint32_t words;
+	uint32_t tag;
+};
+
+// Handed from one thread to the next, which checks and frees them
+struct BlockExchange {
+	std::mutex mutex;
+	std::vector<TaggedBlock> blocks;
+};
+
+static TaggedBlock allocateTagged(ThreadCacheAllocator& heap, std::mt19937& random, const uint32_t tag)
+{
+	const int bucket = random() % 100;
+	size_t size = 4 + random() % ThreadCacheAllocator::MAX_CACHED_SIZE;
+	uint8_t alignment = 4;
+	if (bucket < 5)
+	{
+		size = ThreadCacheAllocator::MAX_CACHED_SIZE + 4 + random() % 4096;
+	}
+	else if (bucket < 10)
+	{
+		alignment = 64;
+	}
+	TaggedBlock block = { (uint32_t*)heap.allocate(size, alignment), (uint32_t)(size / sizeof(uint32_t)), tag };
+	if (block.p)
+	{
+		for (uint32_t i = 0; i < block.words; i++)
+		{
+			block.p[i] = tag + i;
+		}
+	}
+	return block;
+}
+
+static bool isTagIntact(const TaggedBlock& block)
+{
+	for (uint32_t i = 0; i < block.words; i++)
+	{
+		if (block.p[i] != block.tag + i)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void testThreads()
+{
+	TLSFAllocator* parent = allocator::newVirtualTLSFAllocator(THREAD_CACHE_HEAP_SIZE);
+	TEST_CHECK(parent != nullptr);
+	if (!parent)
+	{
+		return;
+	}
+	const int threadCount = 6;
+	const int rounds = 20000;
+	std::atomic<size_t> failedAllocations(0);
+	std::atomic<size_t> damagedBlocks(0);
+	std::atomic<size_t> duplicateBlocks(0);
+	std::atomic<size_t> crossThreadFrees(0);
+	{
+		ThreadCacheAllocator heap(*parent);
+		heap.collectStats();
+		std::vector<BlockExchange> exchanges(threadCount);
+		std::mutex liveMutex;
+		std::unordered_set<void*> live;
+
+		std::vector<std::thread> threads;
+		for (int thread = 0; thread < threadCount; thread++)
+		{
+			threads.emplace_back([&, thread]() {
+				std::mt19937 random(1000 + thread);
+				std::vector<TaggedBlock> owned;
+				auto release = [&](const TaggedBlock& block) {
+					damagedBlocks += isTagIntact(block) ? 0 : 1;
+					{
+						std::lock_guard<std::mutex> lock(liveMutex);
+						live.erase(block.p);
+					}
+					heap.deallocate(block.p);
+				};
+				for (int round = 0; round < rounds; round++)
+				{
+					const TaggedBlock block = allocateTagged(heap, random, (uint32_t)(thread << 24 | round << 4));
+					if (!block.p)
+					{
+						failedAllocations++;
+						continue;
+					}
+					{
+						std::lock_guard<std::mutex> lock(liveMutex);
+						duplicateBlocks += live.insert(block.p).second ? 0 : 1;
+					}
+					// A third go to the next thread, the rest are freed here at random
+					if (round % 3 == 0)
+					{
+						BlockExchange& next = exchanges[(thread + 1) % threadCount];
+						std::lock_guard<std::mutex> lock(next.mutex);
+						next.blocks.push_back(block);
+					}
+					else
+					{
+						owned.push_back(block);
+					}
+					if (owned.size() > 200 || (!owned.empty() && random() % 2 == 0))
+					{
+						const size_t index = random() % owned.size();
+						release(owned[index]);
+						owned[index] = owned.back();
+						owned.pop_back();
+					}
+					if (round % 64 == 0)
+					{
+						std::vector<TaggedBlock> received;
+						{
+							std::lock_guard<std::mutex> lock(exchanges[thread].mutex);
+							received.swap(exchanges[thread].blocks);
+						}
+						for (const TaggedBlock& other : received)
+						{
+							release(other);
+						}
+						crossThreadFrees += received.size();
+					}
+				}
+				for (const TaggedBlock& block : owned)
+				{
+					release(block);
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		// Whatever was still on its way to another thread
+		for (BlockExchange& exchange : exchanges)
+		{
+			for (const TaggedBlock& block : exchange.blocks)
+			{
+				damagedBlocks += isTagIntact(block) ? 0 : 1;
+				heap.deallocate(block.p);
+			}
+		}
+
+		// The threads have exited and returned their caches, usage comes out even
+		const ThreadCacheStats stats = heap.collectStats();
+		TEST_CHECK(stats.numRefills > 0 && stats.numReturns > 0);
+		TEST_CHECK(heap.getNumAllocations() == 0 && heap.getUsedMemory() == 0);
+		Log::Info("[CPUTests] %d threads: %zu cross thread frees, %zu refills, %zu returns, %zu contended locks",
+			threadCount, crossThreadFrees.load(), stats.numRefills, stats.numReturns, stats.numContendedLocks);
+	}
+	TEST_CHECK(failedAllocations == 0);
+	TEST_CHECK(damagedBlocks == 0);
+	TEST_CHECK(duplicateBlocks == 0);
+	TEST_CHECK(crossThreadFrees > 0);
+	TEST_CHECK(parent->getNumAllocations() == 0);
+	allocator::deleteVirtualTLSFAllocator(*parent);
+}
+
+static void benchmarkThreads()
+{
+	TLSFAllocator* parent = allocator::newVirtualTLSFAllocator(THREAD_CACHE_HEAP_SIZE);
+	if (!parent)
+	{
+		return;
+	}
+	const size_t threadCount = 4;
+	const size_t blocksPerThread = 100000;
+	auto churn = [&](Allocator& heap) {
+		std::vector<std::thread> threads;
+		for (size_t thread = 0; thread < threadCount; thread++)
+		{
+			threads.emplace_back([&heap, thread]() {
+				std::vector<void*> blocks(64, nullptr);
+				for (size_t i = 0; i < blocksPerThread; i++)
+				{
+					void*& slot = blocks[(i * 7 + thread) % blocks.size()];
+					if (slot)
+					{
+						heap.deallocate(slot);
+					}
+					slot = heap.allocate(16 + (i % 8) * 16);
+				}
+				for (void* p : blocks)
+				{
+					if (p)
+					{
+						heap.deallocate(p);
+					}
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	};
+	{
+		ThreadCacheAllocator heap(*parent);
+		CPUTests::benchmark("ThreadCacheAllocator 4 threads, per allocation", threadCount * blocksPerThread, [&]() { churn(heap); });
+	}
+	CPUTests::benchmark("TLSFAllocator 4 threads, per allocation", threadCount * blocksPerThread, [&]() { churn(*parent); });
+	allocator::deleteVirtualTLSFAllocator(*parent);
+}
+
+void ThreadCacheTests(Allocator& allocator)
+{
+	testBatches();
+	testThreads();
+	benchmarkThreads();
+}
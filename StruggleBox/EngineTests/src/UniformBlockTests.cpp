@@ -0,0 +1,278 @@
+#include "CPUTests.h"
+
+#include "UniformBlockLayout.h"
+#include "UniformLocationTable.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// std140 offsets worked out by hand from the rules in the GL spec, the padded writes
+// checked byte by byte, and the uniform location table against a std::map of the same names.
+
+static void testLayoutOffsets()
+{
+	// A vec3 leaves room for a float in its last four bytes
+	UniformBlockLayout packed;
+	TEST_CHECK(packed.add(UniformType::Vec3) == 0);
+	TEST_CHECK(packed.add(UniformType::Float) == 12);
+	TEST_CHECK(packed.getSize() == 16);
+
+	// But has to start on 16 bytes itself
+	UniformBlockLayout padded;
+	TEST_CHECK(padded.add(UniformType::Float) == 0);
+	TEST_CHECK(padded.add(UniformType::Vec3) == 16);
+	TEST_CHECK(padded.add(UniformType::Vec2) == 32);
+	TEST_CHECK(padded.add(UniformType::Int) == 40);
+	TEST_CHECK(padded.add(UniformType::Bool) == 44);
+	TEST_CHECK(padded.add(UniformType::Vec4) == 48);
+	TEST_CHECK(padded.getSize() == 64);
+
+	// Scalar arrays get a vec4 per element, and whatever follows starts on 16 bytes again
+	UniformBlockLayout array;
+	TEST_CHECK(array.add(UniformType::Float) == 0);
+	TEST_CHECK(array.add(UniformType::Float, 4) == 16);
+	TEST_CHECK(array.add(UniformType::Float) == 80);
+	TEST_CHECK(array.add(UniformType::Vec2, 2) == 96);
+	TEST_CHECK(array.add(UniformType::Vec3, 3) == 128);
+	TEST_CHECK(array.getSize() == 176);
+
+	// mat3 is three vec4 columns, 48 bytes, alone or in an array
+	UniformBlockLayout matrices;
+	TEST_CHECK(matrices.add(UniformType::Float) == 0);
+	TEST_CHECK(matrices.add(UniformType::Mat3) == 16);
+	TEST_CHECK(matrices.add(UniformType::Float) == 64);
+	TEST_CHECK(matrices.add(UniformType::Mat4) == 80);
+	TEST_CHECK(matrices.add(UniformType::Mat3, 2) == 144);
+	TEST_CHECK(matrices.getSize() == 240);
+	TEST_CHECK(UniformBlockLayout::getTypeSize(UniformType::Mat3) == 48);
+
+	// The size is always a multiple of 16
+	UniformBlockLayout empty;
+	TEST_CHECK(empty.getSize() == 0);
+	UniformBlockLayout single;
+	single.add(UniformType::Float);
+	TEST_CHECK(single.getSize() == 16);
+	single.add(UniformType::Vec4);
+	TEST_CHECK(single.getSize() == 32);
+	single.add(UniformType::Vec2);
+	TEST_CHECK(single.getSize() == 48);
+
+	// Every rule at once
+	UniformBlockLayout mixed;
+	TEST_CHECK(mixed.add(UniformType::Float) == 0);
+	TEST_CHECK(mixed.add(UniformType::Vec2) == 8);
+	TEST_CHECK(mixed.add(UniformType::Vec3) == 16);
+	TEST_CHECK(mixed.add(UniformType::Float) == 28);
+	TEST_CHECK(mixed.add(UniformType::Vec2) == 32);
+	TEST_CHECK(mixed.add(UniformType::Float, 2) == 48);
+	TEST_CHECK(mixed.add(UniformType::Mat4) == 80);
+	TEST_CHECK(mixed.getSize() == 144);
+}
+
+static void testWrites()
+{
+	const uint8_t FILL = 0xCD;
+	uint8_t block[128];
+
+	// Columns start 16 bytes apart, the padding after each one is left alone
+	memset(block, FILL, sizeof(block));
+	const glm::mat3 matrix = glm::mat3(1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f);
+	UniformBlockLayout::write(block, 16, matrix);
+	for (int column = 0; column < 3; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			float value = 0.f;
+			memcpy(&value, block + 16 + column * 16 + row * 4, sizeof(float));
+			TEST_CHECK(value == matrix[column][row]);
+		}
+		for (int padding = 12; padding < 16; padding++)
+		{
+			TEST_CHECK(block[16 + column * 16 + padding] == FILL);
+		}
+	}
+	for (int i = 0; i < 16; i++)
+	{
+		TEST_CHECK(block[i] == FILL);
+	}
+	TEST_CHECK(block[64] == FILL);
+
+	// Bools are a whole 32 bit word of 0 or 1
+	memset(block, FILL, sizeof(block));
+	UniformBlockLayout::write(block, 4, true);
+	uint32_t word = 0;
+	memcpy(&word, block + 4, sizeof(word));
+	TEST_CHECK(word == 1);
+	UniformBlockLayout::write(block, 8, false);
+	memcpy(&word, block + 8, sizeof(word));
+	TEST_CHECK(word == 0);
+	TEST_CHECK(block[3] == FILL && block[12] == FILL);
+
+	memset(block, FILL, sizeof(block));
+	UniformBlockLayout::write(block, 0, glm::vec3(1.f, 2.f, 3.f));
+	UniformBlockLayout::write(block, 12, 4.f);
+	float vector[4];
+	memcpy(vector, block, sizeof(vector));
+	TEST_CHECK(vector[0] == 1.f && vector[1] == 2.f && vector[2] == 3.f && vector[3] == 4.f);
+	TEST_CHECK(block[16] == FILL);
+
+	const glm::mat4 transform = glm::mat4(glm::vec4(1.f), glm::vec4(2.f), glm::vec4(3.f), glm::vec4(4.f));
+	UniformBlockLayout::write(block, 32, transform);
+	TEST_CHECK(memcmp(block + 32, &transform[0][0], sizeof(float) * 16) == 0);
+	TEST_CHECK(block[96] == FILL);
+}
+
+static void testLocationTable()
+{
+	UniformLocationTable table;
+	TEST_CHECK(table.find("missing") == UniformLocationTable::NOT_FOUND);
+
+	// Enough names to grow the table several times from its first 16 slots
+	std::map<std::string, int32_t> reference;
+	char name[32];
+	for (int32_t i = 0; i < 1000; i++)
+	{
+		snprintf(name, sizeof(name), "u_light[%i].position", i);
+		table.add(name, i);
+		reference[name] = i;
+		if (i % 100 == 0)
+		{
+			TEST_CHECK(table.size() == reference.size());
+			for (const auto& pair : reference)
+			{
+				TEST_CHECK(table.find(pair.first.c_str()) == pair.second);
+			}
+		}
+	}
+	TEST_CHECK(table.size() == 1000);
+	for (const auto& pair : reference)
+	{
+		TEST_CHECK(table.find(pair.first.c_str()) == pair.second);
+	}
+	TEST_CHECK(table.find("u_light[1000].position") == UniformLocationTable::NOT_FOUND);
+	TEST_CHECK(table.find("") == UniformLocationTable::NOT_FOUND);
+
+	// Adding a name again moves it, locations GL didn't find aren't stored
+	table.add("u_light[5].position", 5000);
+	TEST_CHECK(table.find("u_light[5].position") == 5000);
+	table.add("inactive", UniformLocationTable::NOT_FOUND);
+	TEST_CHECK(table.find("inactive") == UniformLocationTable::NOT_FOUND);
+	TEST_CHECK(table.size() == 1000);
+
+	table.clear();
+	TEST_CHECK(table.size() == 0);
+	TEST_CHECK(table.find("u_light[5].position") == UniformLocationTable::NOT_FOUND);
+	table.add("u_light[5].position", 1);
+	TEST_CHECK(table.find("u_light[5].position") == 1);
+}
+
+static uint32_t fnv1a(const char* name)
+{
+	uint32_t hash = 2166136261u;
+	for (const char* c = name; *c; c++)
+	{
+		hash ^= (uint8_t)*c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static void testHashCollisions()
+{
+	// Two different names with the same full 32 bit hash, found by brute force
+	std::unordered_map<uint32_t, std::string> seen;
+	std::string first;
+	std::string second;
+	char name[32];
+	for (int i = 0; first.empty() && i < 1000000; i++)
+	{
+		snprintf(name, sizeof(name), "u_%i", i);
+		const uint32_t hash = fnv1a(name);
+		auto it = seen.find(hash);
+		if (it != seen.end())
+		{
+			first = it->second;
+			second = name;
+		}
+		else
+		{
+			seen[hash] = name;
+		}
+	}
+	TEST_CHECK(!first.empty());
+	if (first.empty())
+	{
+		return;
+	}
+
+	UniformLocationTable table;
+	table.add(first.c_str(), 1);
+	TEST_CHECK(table.find(second.c_str()) == UniformLocationTable::NOT_FOUND);
+	table.add(second.c_str(), 2);
+	TEST_CHECK(table.size() == 2);
+	TEST_CHECK(table.find(first.c_str()) == 1);
+	TEST_CHECK(table.find(second.c_str()) == 2);
+
+	// Both have to survive the table growing around them
+	for (int32_t i = 0; i < 200; i++)
+	{
+		snprintf(name, sizeof(name), "u_pad%i", i);
+		table.add(name, 10 + i);
+	}
+	TEST_CHECK(table.find(first.c_str()) == 1);
+	TEST_CHECK(table.find(second.c_str()) == 2);
+	for (int32_t i = 0; i < 200; i++)
+	{
+		snprintf(name, sizeof(name), "u_pad%i", i);
+		TEST_CHECK(table.find(name) == 10 + i);
+	}
+}
+
+static void benchmarkLookups()
+{
+	// About the uniforms one of the bigger shaders has
+	const size_t uniformCount = 40;
+	std::vector<std::string> names;
+	UniformLocationTable table;
+	std::map<std::string, int32_t> map;
+	char name[32];
+	for (size_t i = 0; i < uniformCount; i++)
+	{
+		snprintf(name, sizeof(name), "u_uniform%zu", i);
+		names.push_back(name);
+		table.add(name, (int32_t)i);
+		map[name] = (int32_t)i;
+	}
+
+	const size_t lookupCount = 1000000;
+	int64_t tableSum = 0;
+	CPUTests::benchmark("UniformLocationTable::find, per lookup", lookupCount, [&]() {
+		tableSum = 0;
+		for (size_t i = 0; i < lookupCount; i++)
+		{
+			tableSum += table.find(names[i % uniformCount].c_str());
+		}
+	});
+	int64_t mapSum = 0;
+	CPUTests::benchmark("std::map<std::string> find, per lookup", lookupCount, [&]() {
+		mapSum = 0;
+		for (size_t i = 0; i < lookupCount; i++)
+		{
+			// Shaders are handed a const char*, the map needs a string made from it
+			mapSum += map.find(names[i % uniformCount].c_str())->second;
+		}
+	});
+	TEST_CHECK(tableSum == mapSum);
+}
+
+void UniformBlockTests(Allocator& allocator)
+{
+	testLayoutOffsets();
+	testWrites();
+	testLocationTable();
+	testHashCollisions();
+	benchmarkLookups();
+}
@@ -0,0 +1,366 @@
+#include "CPUTests.h"
+
+#include "TLSFAllocator.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// The engine heap only reserves its address space up front. It has to commit pages as
+// allocations need them, hand big free stretches at the end back to the OS, and serve
+// blocks larger than anything committed so far, without touching what's still in use.
+
+const size_t VIRTUAL_HEAP_SIZE = 512 * 1024 * 1024;
+const size_t MEGABYTE = 1024 * 1024;
+
+struct FilledBlock {
+	uint8_t* p;
+	size_t size;
+	uint8_t fill;
+};
+
+// Checking the ends and a few bytes in between is enough to catch pages that went missing
+static void fillBlock(FilledBlock& block)
+{
+	for (size_t offset = 0; offset < block.size; offset += 4096)
+	{
+		block.p[offset] = block.fill;
+	}
+	block.p[block.size - 1] = block.fill;
+}
+
+static bool isBlockFilled(const FilledBlock& block)
+{
+	for (size_t offset = 0; offset < block.size; offset += 4096)
+	{
+		if (block.p[offset] != block.fill)
+		{
+			return false;
+		}
+	}
+	return block.p[block.size - 1] == block.fill;
+}
+
+static size_t countDamaged(const std::vector<FilledBlock>& blocks)
+{
+	size_t damaged = 0;
+	for (const FilledBlock& block : blocks)
+	{
+		damaged += isBlockFilled(block) ? 0 : 1;
+	}
+	return damaged;
+}
+
+static void testCommitOnDemand()
+{
+	TLSFAllocator* heap = allocator::newVirtualTLSFAllocator(VIRTUAL_HEAP_SIZE);
+	TEST_CHECK(heap != nullptr);
+	if (!heap)
+	{
+		return;
+	}
+	// Only the first granule is committed, the allocator itself sits at its start
+	const size_t initialCommit = heap->getCommittedSize();
+	TEST_CHECK(initialCommit + sizeof(TLSFAllocator) == TLSFAllocator::COMMIT_GRANULARITY);
+	TEST_CHECK(heap->getSize() + sizeof(TLSFAllocator) == VIRTUAL_HEAP_SIZE);
+
+	// Growing a megabyte at a time, the commit never falls behind and never runs far ahead
+	std::vector<FilledBlock> blocks;
+	size_t grows = 0;
+	size_t overCommitted = 0;
+	size_t lastCommit = initialCommit;
+	for (int i = 0; i < 128; i++)
+	{
+		FilledBlock block = { (uint8_t*)heap->allocate(MEGABYTE, 16), MEGABYTE, (uint8_t)(i + 1) };
+		TEST_CHECK(block.p != nullptr);
+		if (!block.p)
+		{
+			break;
+		}
+		fillBlock(block);
+		blocks.push_back(block);
+
+		const size_t committed = heap->getCommittedSize();
+		grows += committed > lastCommit ? 1 : 0;
+		overCommitted += committed < heap->getUsedMemory() ||
+			committed > heap->getUsedMemory() + 2 * TLSFAllocator::COMMIT_GRANULARITY ? 1 : 0;
+		// Always whole granules past the allocator
+		overCommitted += (committed + sizeof(TLSFAllocator)) % TLSFAllocator::COMMIT_GRANULARITY != 0 ? 1 : 0;
+		lastCommit = committed;
+	}
+	TEST_CHECK(grows > 32);
+	TEST_CHECK(overCommitted == 0);
+	TEST_CHECK(countDamaged(blocks) == 0);
+	Log::Info("[CPUTests] Virtual heap grew %zu times to %zu MB for %zu MB in use",
+		grows, heap->getCommittedSize() / MEGABYTE, heap->getUsedMemory() / MEGABYTE);
+
+	for (const FilledBlock& block : blocks)
+	{
+		heap->deallocate(block.p);
+	}
+	TEST_CHECK(heap->getNumAllocations() == 0);
+	allocator::deleteVirtualTLSFAllocator(*heap);
+}
+
+static void testDecommit()
+{
+	TLSFAllocator* heap = allocator::newVirtualTLSFAllocator(VIRTUAL_HEAP_SIZE);
+	TEST_CHECK(heap != nullptr);
+	if (!heap)
+	{
+		return;
+	}
+	std::vector<FilledBlock> blocks;
+	for (int i = 0; i < 200; i++)
+	{
+		FilledBlock block = { (uint8_t*)heap->allocate(MEGABYTE, 16), MEGABYTE, (uint8_t)(i + 1) };
+		TEST_CHECK(block.p != nullptr);
+		if (!block.p)
+		{
+			break;
+		}
+		fillBlock(block);
+		blocks.push_back(block);
+	}
+	const size_t fullCommit = heap->getCommittedSize();
+	TEST_CHECK(fullCommit >= 200 * MEGABYTE);
+
+	// Less than the threshold free at the end stays committed for the next allocations
+	const size_t belowThreshold = TLSFAllocator::DECOMMIT_THRESHOLD / MEGABYTE / 2;
+	for (size_t i = 0; i < belowThreshold; i++)
+	{
+		heap->deallocate(blocks.back().p);
+		blocks.pop_back();
+	}
+	TEST_CHECK(heap->getCommittedSize() == fullCommit);
+
+	// Freeing in the middle doesn't shrink anything either, the pages are still between used blocks
+	std::vector<FilledBlock> kept;
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		if (i >= 10 && i < 90)
+		{
+			heap->deallocate(blocks[i].p);
+		}
+		else
+		{
+			kept.push_back(blocks[i]);
+		}
+	}
+	blocks = kept;
+	TEST_CHECK(heap->getCommittedSize() == fullCommit);
+
+	// Once the free end passes the threshold it's trimmed back to the slack past the last block
+	size_t trims = 0;
+	size_t wrongTrims = 0;
+	size_t lastCommit = fullCommit;
+	while (blocks.size() > 20)
+	{
+		heap->deallocate(blocks.back().p);
+		blocks.pop_back();
+		const size_t committed = heap->getCommittedSize();
+		if (committed < lastCommit)
+		{
+			const size_t usedSpan = (uintptr_t)blocks.back().p + blocks.back().size - (uintptr_t)heap->getStart();
+			wrongTrims += committed < usedSpan + TLSFAllocator::DECOMMIT_SLACK ||
+				committed > usedSpan + TLSFAllocator::DECOMMIT_SLACK + 2 * TLSFAllocator::COMMIT_GRANULARITY ? 1 : 0;
+			trims++;
+		}
+		lastCommit = committed;
+	}
+	// Between trims the free end never grows past the threshold
+	const size_t usedSpan = (uintptr_t)blocks.back().p + blocks.back().size - (uintptr_t)heap->getStart();
+	const size_t trimmedCommit = heap->getCommittedSize();
+	TEST_CHECK(trims > 0 && wrongTrims == 0);
+	TEST_CHECK(trimmedCommit < usedSpan + TLSFAllocator::DECOMMIT_THRESHOLD + TLSFAllocator::DECOMMIT_SLACK + TLSFAllocator::COMMIT_GRANULARITY);
+	TEST_CHECK(countDamaged(blocks) == 0);
+	Log::Info("[CPUTests] Virtual heap trimmed from %zu MB to %zu MB with %zu MB in use",
+		fullCommit / MEGABYTE, trimmedCommit / MEGABYTE, heap->getUsedMemory() / MEGABYTE);
+
+	// Decommitted pages come back zeroed or not, but they have to come back usable
+	for (int i = 0; i < 100; i++)
+	{
+		FilledBlock block = { (uint8_t*)heap->allocate(MEGABYTE, 16), MEGABYTE, (uint8_t)(0x80 + i) };
+		TEST_CHECK(block.p != nullptr);
+		if (!block.p)
+		{
+			break;
+		}
+		fillBlock(block);
+		blocks.push_back(block);
+	}
+	TEST_CHECK(heap->getCommittedSize() >= heap->getUsedMemory());
+	TEST_CHECK(countDamaged(blocks) == 0);
+
+	// Everything gone leaves only the slack
+	for (const FilledBlock& block : blocks)
+	{
+		heap->deallocate(block.p);
+	}
+	TEST_CHECK(heap->getNumAllocations() == 0 && heap->getUsedMemory() == 0);
+	TEST_CHECK(heap->getCommittedSize() <= TLSFAllocator::DECOMMIT_SLACK + 2 * TLSFAllocator::COMMIT_GRANULARITY);
+	allocator::deleteVirtualTLSFAllocator(*heap);
+}
+
+static void testLargeAllocations()
+{
+	TLSFAllocator* heap = allocator::newVirtualTLSFAllocator(VIRTUAL_HEAP_SIZE);
+	TEST_CHECK(heap != nullptr);
+	if (!heap)
+	{
+		return;
+	}
+	FilledBlock small = { (uint8_t*)heap->allocate(4096, 16), 4096, 0x11 };
+	TEST_CHECK(small.p != nullptr);
+	if (!small.p)
+	{
+		allocator::deleteVirtualTLSFAllocator(*heap);
+		return;
+	}
+	fillBlock(small);
+
+	// Far bigger than anything committed, in one go and with a large alignment
+	const uint8_t alignments[3] = { 16, 64, 128 };
+	const size_t largeSizes[3] = { 300 * MEGABYTE, 64 * MEGABYTE + 12345, 3 * MEGABYTE + 1 };
+	for (int i = 0; i < 3; i++)
+	{
+		FilledBlock large = { (uint8_t*)heap->allocate(largeSizes[i], alignments[i]), largeSizes[i], (uint8_t)(0x20 + i) };
+		TEST_CHECK(large.p != nullptr);
+		if (!large.p)
+		{
+			continue;
+		}
+		TEST_CHECK((uintptr_t)large.p % alignments[i] == 0);
+		TEST_CHECK(large.p + large.size <= (uint8_t*)heap->getStart() + heap->getCommittedSize());
+		fillBlock(large);
+		TEST_CHECK(isBlockFilled(large) && isBlockFilled(small));
+		heap->deallocate(large.p);
+		// Big enough to go straight back
+		if (largeSizes[i] >= TLSFAllocator::DECOMMIT_THRESHOLD)
+		{
+			TEST_CHECK(heap->getCommittedSize() <= TLSFAllocator::DECOMMIT_SLACK + 2 * TLSFAllocator::COMMIT_GRANULARITY + small.size);
+		}
+	}
+
+	// Past the reservation fails cleanly and leaves the heap as it was
+	const size_t committedBefore = heap->getCommittedSize();
+	TEST_CHECK(heap->allocate(VIRTUAL_HEAP_SIZE, 16) == nullptr);
+	TEST_CHECK(heap->getCommittedSize() == committedBefore && heap->getNumAllocations() == 1);
+
+	// The whole reservation less a little still fits, then nothing more does
+	std::vector<void*> rest;
+	void* p = nullptr;
+	while ((p = heap->allocate(32 * MEGABYTE, 16)) != nullptr)
+	{
+		rest.push_back(p);
+	}
+	TEST_CHECK(rest.size() >= VIRTUAL_HEAP_SIZE / (32 * MEGABYTE) - 2);
+	TEST_CHECK(heap->getCommittedSize() <= heap->getSize());
+	TEST_CHECK(isBlockFilled(small));
+	for (void* block : rest)
+	{
+		heap->deallocate(block);
+	}
+	TEST_CHECK(heap->getCommittedSize() <= committedBefore + TLSFAllocator::DECOMMIT_SLACK);
+	heap->deallocate(small.p);
+	allocator::deleteVirtualTLSFAllocator(*heap);
+}
+
+// A pool handed over fully committed must never be decommitted
+static void testFixedPool()
+{
+	const size_t size = 128 * MEGABYTE;
+	void* memory = malloc(size);
+	TEST_CHECK(memory != nullptr);
+	if (!memory)
+	{
+		return;
+	}
+	{
+		TLSFAllocator heap(size, memory);
+		TEST_CHECK(heap.getCommittedSize() == size);
+		void* large = heap.allocate(100 * MEGABYTE, 16);
+		TEST_CHECK(large != nullptr);
+		if (large)
+		{
+			memset(large, 0x5a, 100 * MEGABYTE);
+			heap.deallocate(large);
+		}
+		TEST_CHECK(heap.getCommittedSize() == size);
+		TEST_CHECK(heap.allocate(size, 16) == nullptr);
+	}
+	free(memory);
+}
+
+static void benchmarkGrowth()
+{
+	// Loading a level: lots of mid sized blocks while the heap is still cold, then all freed
+	const size_t blockSize = 64 * 1024;
+	const size_t blockCount = 2048;
+	std::vector<void*> blocks(blockCount);
+
+	TLSFAllocator* heap = allocator::newVirtualTLSFAllocator(VIRTUAL_HEAP_SIZE);
+	TEST_CHECK(heap != nullptr);
+	if (!heap)
+	{
+		return;
+	}
+	size_t failed = 0;
+	CPUTests::benchmark("Virtual TLSF heap, 64KB allocate, touch and free, per block", blockCount, [&]() {
+		for (void*& block : blocks)
+		{
+			block = heap->allocate(blockSize, 16);
+			failed += block ? 0 : 1;
+			if (block)
+			{
+				memset(block, 1, blockSize);
+			}
+		}
+		for (void* block : blocks)
+		{
+			if (block)
+			{
+				heap->deallocate(block);
+			}
+		}
+	});
+	allocator::deleteVirtualTLSFAllocator(*heap);
+
+	void* memory = malloc(VIRTUAL_HEAP_SIZE);
+	TEST_CHECK(memory != nullptr);
+	if (!memory)
+	{
+		return;
+	}
+	{
+		TLSFAllocator fixed(VIRTUAL_HEAP_SIZE, memory);
+		CPUTests::benchmark("Committed TLSF heap, 64KB allocate, touch and free, per block", blockCount, [&]() {
+			for (void*& block : blocks)
+			{
+				block = fixed.allocate(blockSize, 16);
+				failed += block ? 0 : 1;
+				if (block)
+				{
+					memset(block, 1, blockSize);
+				}
+			}
+			for (void* block : blocks)
+			{
+				if (block)
+				{
+					fixed.deallocate(block);
+				}
+			}
+		});
+	}
+	free(memory);
+	TEST_CHECK(failed == 0);
+}
+
+void VirtualHeapTests(Allocator& allocator)
+{
+	testCommitOnDemand();
+	testDecommit();
+	testLargeAllocations();
+	testFixedPool();
+	benchmarkGrowth();
+}
@@ -0,0 +1,432 @@
+#include "CPUTests.h"
+
+#include "Allocator.h"
+#include "CubeConstants.h"
+#include "Random.h"
+#include "VoxelBrickMesh.h"
+#include "VoxelData.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// An edit dirties the brick it's in and every brick holding one of its six face neighbours,
+// since those are the only voxels whose visible faces can change. After random edits the
+// incrementally updated brick mesh has to match one built from scratch byte for byte, and
+// cover exactly the unit faces a full createTriangleMeshBinary covers.
+
+static bool isSolid(const VoxelData& voxels, const glm::ivec3& coord)
+{
+	if (!voxels.contains(coord.x, coord.y, coord.z))
+	{
+		return false;
+	}
+	return voxels.getData()[voxels.getIndex(coord)] != EMPTY_VOXEL;
+}
+
+static int brickIndex(const VoxelData& voxels, const glm::ivec3& coord)
+{
+	const glm::ivec3 brick = coord / VOXEL_BRICK_SIZE;
+	const int bricksX = (voxels.getSizeX() + VOXEL_BRICK_SIZE - 1) / VOXEL_BRICK_SIZE;
+	const int bricksY = (voxels.getSizeY() + VOXEL_BRICK_SIZE - 1) / VOXEL_BRICK_SIZE;
+	return brick.x + brick.y * bricksX + brick.z * bricksX * bricksY;
+}
+
+// Reference for which bricks an edit at coord has to dirty
+static std::vector<bool> expectedDirtyBricks(const VoxelData& voxels, const glm::ivec3& coord)
+{
+	std::vector<bool> dirty(voxels.getNumBricks(), false);
+	dirty[brickIndex(voxels, coord)] = true;
+	for (int side = 0; side < 6; side++)
+	{
+		glm::ivec3 neighbour = coord;
+		neighbour[side / 2] += (side % 2) ? 1 : -1;
+		if (voxels.contains(neighbour.x, neighbour.y, neighbour.z))
+		{
+			dirty[brickIndex(voxels, neighbour)] = true;
+		}
+	}
+	return dirty;
+}
+
+static bool dirtyBricksMatch(const VoxelData& voxels, const std::vector<bool>& expected)
+{
+	bool anyDirty = false;
+	for (size_t brick = 0; brick < voxels.getNumBricks(); brick++)
+	{
+		if (voxels.isBrickDirty((int)brick) != expected[brick])
+		{
+			return false;
+		}
+		anyDirty |= expected[brick];
+	}
+	return voxels.hasDirtyBricks() == anyDirty;
+}
+
+static void testBrickLayout(Allocator& allocator)
+{
+	// Sides that aren't a multiple of the brick size end in a partial brick
+	const glm::ivec3 sizes[4] = { glm::ivec3(16, 16, 16), glm::ivec3(40, 33, 5), glm::ivec3(1, 64, 17), glm::ivec3(48, 32, 16) };
+	for (const glm::ivec3& size : sizes)
+	{
+		VoxelData voxels(size.x, size.y, size.z, allocator);
+		const glm::ivec3 bricks = (size + VOXEL_BRICK_SIZE - 1) / VOXEL_BRICK_SIZE;
+		TEST_CHECK(voxels.getNumBricks() == (size_t)bricks.x * bricks.y * bricks.z);
+
+		// The brick bounds cover every voxel exactly once
+		std::vector<int> covered((size_t)size.x * size.y * size.z, 0);
+		for (size_t brick = 0; brick < voxels.getNumBricks(); brick++)
+		{
+			glm::ivec3 min, max;
+			voxels.getBrickBounds((int)brick, min, max);
+			for (int z = min.z; z < max.z; z++)
+			{
+				for (int y = min.y; y < max.y; y++)
+				{
+					for (int x = min.x; x < max.x; x++)
+					{
+						covered[voxels.getIndex(x, y, z)]++;
+						TEST_CHECK(brickIndex(voxels, glm::ivec3(x, y, z)) == (int)brick);
+					}
+				}
+			}
+		}
+		TEST_CHECK(std::count(covered.begin(), covered.end(), 1) == (std::ptrdiff_t)covered.size());
+	}
+}
+
+static void testEditFlags(Allocator& allocator)
+{
+	// Every voxel of a volume with full and partial bricks, borders included
+	VoxelData voxels(40, 33, 20, allocator);
+	voxels.clearDirtyBricks();
+	TEST_CHECK(!voxels.hasDirtyBricks());
+
+	size_t wrongFlags = 0;
+	for (int z = 0; z < voxels.getSizeZ(); z++)
+	{
+		for (int y = 0; y < voxels.getSizeY(); y++)
+		{
+			for (int x = 0; x < voxels.getSizeX(); x++)
+			{
+				const glm::ivec3 coord = glm::ivec3(x, y, z);
+				voxels.setVoxel(x, y, z, 3);
+				wrongFlags += dirtyBricksMatch(voxels, expectedDirtyBricks(voxels, coord)) ? 0 : 1;
+				voxels.clearDirtyBricks();
+
+				// Setting what's already there changes nothing
+				voxels.setVoxel(x, y, z, 3);
+				wrongFlags += voxels.hasDirtyBricks() ? 1 : 0;
+
+				// Writes past setVoxel only count once marked
+				voxels(x, y, z) = EMPTY_VOXEL;
+				wrongFlags += voxels.hasDirtyBricks() ? 1 : 0;
+				voxels.markDirty(x, y, z);
+				wrongFlags += dirtyBricksMatch(voxels, expectedDirtyBricks(voxels, coord)) ? 0 : 1;
+				voxels.clearDirtyBricks();
+			}
+		}
+	}
+	TEST_CHECK(wrongFlags == 0);
+
+	// Edits add up until cleared
+	const glm::ivec3 corner = glm::ivec3(15, 16, 0);
+	const glm::ivec3 far = glm::ivec3(39, 0, 19);
+	voxels.setVoxel(corner.x, corner.y, corner.z, 1);
+	voxels.setVoxel(far.x, far.y, far.z, 1);
+	std::vector<bool> expected = expectedDirtyBricks(voxels, corner);
+	const std::vector<bool> farExpected = expectedDirtyBricks(voxels, far);
+	for (size_t brick = 0; brick < expected.size(); brick++)
+	{
+		expected[brick] = expected[brick] || farExpected[brick];
+	}
+	TEST_CHECK(dirtyBricksMatch(voxels, expected));
+
+	// Whole volume changes dirty every brick
+	voxels.clearDirtyBricks();
+	voxels.fill(2);
+	TEST_CHECK(dirtyBricksMatch(voxels, std::vector<bool>(voxels.getNumBricks(), true)));
+	voxels.clearDirtyBricks();
+	voxels.markAllDirty();
+	TEST_CHECK(dirtyBricksMatch(voxels, std::vector<bool>(voxels.getNumBricks(), true)));
+
+	voxels.clearDirtyBricks();
+	TEST_CHECK(dirtyBricksMatch(voxels, std::vector<bool>(voxels.getNumBricks(), false)));
+}
+
+// Marks every unit face a mesh covers, by voxel and side, returns false if one is covered twice
+static bool coverUnitFaces(
+	const VoxelData& voxels,
+	const VoxelMeshPBRVertexData* verts,
+	const size_t vertexCount,
+	const float radius,
+	const glm::vec3& offset,
+	std::vector<uint8_t>& covered)
+{
+	covered.assign((size_t)voxels.getSizeX() * voxels.getSizeY() * voxels.getSizeZ() * 6, 0);
+	if (vertexCount % 6 != 0)
+	{
+		return false;
+	}
+	const glm::vec3 origin = voxels.getMeshOrigin(radius, offset);
+	for (size_t face = 0; face < vertexCount; face += 6)
+	{
+		int side = -1;
+		for (int i = 0; i < 6; i++)
+		{
+			if (CubeConstants::cube_normals[i] == verts[face].normal)
+			{
+				side = i;
+			}
+		}
+		if (side < 0)
+		{
+			return false;
+		}
+		glm::ivec3 cornerMin = glm::ivec3(INT32_MAX);
+		glm::ivec3 cornerMax = glm::ivec3(INT32_MIN);
+		for (size_t i = face; i < face + 6; i++)
+		{
+			const glm::vec3 corner = (verts[i].pos - origin) / (radius * 2.f);
+			const glm::ivec3 rounded = glm::ivec3(std::lround(corner.x), std::lround(corner.y), std::lround(corner.z));
+			cornerMin = glm::min(cornerMin, rounded);
+			cornerMax = glm::max(cornerMax, rounded);
+		}
+		// The face lies on the far corner of its voxels for the positive sides
+		const int axis = side / 2;
+		const glm::ivec3 normal = glm::ivec3(CubeConstants::cube_normals[side]);
+		const bool positive = normal[axis] > 0;
+		if (cornerMin[axis] != cornerMax[axis])
+		{
+			return false;
+		}
+		glm::ivec3 voxelMin = cornerMin;
+		glm::ivec3 voxelMax = cornerMax;
+		voxelMin[axis] = positive ? cornerMin[axis] - 1 : cornerMin[axis];
+		voxelMax[axis] = voxelMin[axis] + 1;
+		for (int z = voxelMin.z; z < voxelMax.z; z++)
+		{
+			for (int y = voxelMin.y; y < voxelMax.y; y++)
+			{
+				for (int x = voxelMin.x; x < voxelMax.x; x++)
+				{
+					if (!voxels.contains(x, y, z))
+					{
+						return false;
+					}
+					uint8_t& unitFace = covered[(size_t)voxels.getIndex(x, y, z) * 6 + side];
+					if (unitFace != 0)
+					{
+						return false;
+					}
+					unitFace = 1;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Brute force, every solid voxel side that isn't against another solid voxel
+static std::vector<uint8_t> visibleUnitFaces(const VoxelData& voxels)
+{
+	std::vector<uint8_t> visible((size_t)voxels.getSizeX() * voxels.getSizeY() * voxels.getSizeZ() * 6, 0);
+	for (int z = 0; z < voxels.getSizeZ(); z++)
+	{
+		for (int y = 0; y < voxels.getSizeY(); y++)
+		{
+			for (int x = 0; x < voxels.getSizeX(); x++)
+			{
+				const glm::ivec3 coord = glm::ivec3(x, y, z);
+				if (!isSolid(voxels, coord))
+				{
+					continue;
+				}
+				for (int side = 0; side < 6; side++)
+				{
+					const glm::ivec3 neighbour = coord + glm::ivec3(CubeConstants::cube_normals[side]);
+					visible[(size_t)voxels.getIndex(coord) * 6 + side] = isSolid(voxels, neighbour) ? 0 : 1;
+				}
+			}
+		}
+	}
+	return visible;
+}
+
+static void fillRandom(VoxelData& voxels, const int density, const int materialCount)
+{
+	const int voxelCount = voxels.getSizeX() * voxels.getSizeY() * voxels.getSizeZ();
+	for (int i = 0; i < voxelCount; i++)
+	{
+		voxels[i] = Random::RandomInt(0, 99) < density ? (uint8_t)Random::RandomInt(1, materialCount) : EMPTY_VOXEL;
+	}
+	voxels.markAllDirty();
+}
+
+// Mostly near brick borders, that's where the neighbour flags matter
+static glm::ivec3 randomEditCoord(const VoxelData& voxels)
+{
+	const glm::ivec3 size = glm::ivec3(voxels.getSizeX(), voxels.getSizeY(), voxels.getSizeZ());
+	glm::ivec3 coord;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		coord[axis] = Random::RandomInt(0, size[axis] - 1);
+		if (Random::RandomInt(0, 1) == 0)
+		{
+			const int border = (coord[axis] / VOXEL_BRICK_SIZE) * VOXEL_BRICK_SIZE;
+			coord[axis] = std::min(size[axis] - 1, border + (Random::RandomInt(0, 1) ? 0 : VOXEL_BRICK_SIZE - 1));
+		}
+	}
+	return coord;
+}
+
+static void testIncrementalRemesh(Allocator& allocator)
+{
+	Random::RandomSeed(5);
+	const float radius = 0.5f;
+	const glm::vec3 offset = glm::vec3(8.f, -4.f, 2.f);
+	const size_t maxVerts = (size_t)64 * 64 * 64 * 18;
+	VoxelMeshPBRVertexData* brickVerts = (VoxelMeshPBRVertexData*)allocator.allocate(sizeof(VoxelMeshPBRVertexData) * maxVerts);
+	VoxelMeshPBRVertexData* freshVerts = (VoxelMeshPBRVertexData*)allocator.allocate(sizeof(VoxelMeshPBRVertexData) * maxVerts);
+	VoxelMeshPBRVertexData* fullVerts = (VoxelMeshPBRVertexData*)allocator.allocate(sizeof(VoxelMeshPBRVertexData) * maxVerts);
+
+	size_t differentFromFresh = 0;
+	size_t differentFromFull = 0;
+	size_t badCoverage = 0;
+	size_t rounds = 0;
+	const glm::ivec3 sizes[3] = { glm::ivec3(40, 33, 20), glm::ivec3(64, 16, 48), glm::ivec3(17, 17, 17) };
+	for (const glm::ivec3& size : sizes)
+	{
+		VoxelData voxels(size.x, size.y, size.z, allocator);
+		fillRandom(voxels, 40, 4);
+		VoxelBrickMesh brickMesh(allocator);
+		TEST_CHECK(brickMesh.update(voxels, radius, offset));
+		TEST_CHECK(!voxels.hasDirtyBricks());
+		TEST_CHECK(!brickMesh.update(voxels, radius, offset));
+
+		for (int round = 0; round < 40; round++)
+		{
+			const int editCount = Random::RandomInt(1, 20);
+			for (int edit = 0; edit < editCount; edit++)
+			{
+				const glm::ivec3 coord = randomEditCoord(voxels);
+				voxels.setVoxel(coord.x, coord.y, coord.z, Random::RandomInt(0, 2) ? EMPTY_VOXEL : (uint8_t)Random::RandomInt(1, 4));
+			}
+			if (!voxels.hasDirtyBricks())
+			{
+				continue;
+			}
+			TEST_CHECK(brickMesh.update(voxels, radius, offset));
+			TEST_CHECK(!voxels.hasDirtyBricks());
+			const size_t brickCount = brickMesh.getVertexCount();
+			brickMesh.copyVerts(brickVerts);
+
+			// The same voxels meshed from scratch
+			VoxelBrickMesh freshMesh(allocator);
+			freshMesh.update(voxels, radius, offset);
+			freshMesh.copyVerts(freshVerts);
+			differentFromFresh += (freshMesh.getVertexCount() != brickCount ||
+				memcmp(freshVerts, brickVerts, sizeof(VoxelMeshPBRVertexData) * brickCount) != 0) ? 1 : 0;
+
+			// Brick meshes aren't merged across brick borders, so only the covered faces can be compared
+			size_t fullCount = 0;
+			voxels.createTriangleMeshBinary(fullVerts, fullCount, radius, offset);
+			std::vector<uint8_t> brickFaces;
+			std::vector<uint8_t> fullFaces;
+			badCoverage += coverUnitFaces(voxels, brickVerts, brickCount, radius, offset, brickFaces) ? 0 : 1;
+			badCoverage += coverUnitFaces(voxels, fullVerts, fullCount, radius, offset, fullFaces) ? 0 : 1;
+			differentFromFull += (brickFaces != fullFaces || brickFaces != visibleUnitFaces(voxels)) ? 1 : 0;
+			rounds++;
+		}
+	}
+	TEST_CHECK(differentFromFresh == 0);
+	TEST_CHECK(differentFromFull == 0);
+	TEST_CHECK(badCoverage == 0);
+	Log::Info("[CPUTests] %zu rounds of random edits re-meshed by brick", rounds);
+
+	allocator.deallocate(fullVerts);
+	allocator.deallocate(freshVerts);
+	allocator.deallocate(brickVerts);
+}
+
+static void testClearDirty(Allocator& allocator)
+{
+	VoxelData voxels(32, 32, 32, allocator);
+	voxels.fill(1);
+	VoxelBrickMesh brickMesh(allocator);
+	TEST_CHECK(brickMesh.update(voxels, 0.5f, glm::vec3(0.f)));
+	const size_t vertexCount = brickMesh.getVertexCount();
+	TEST_CHECK(vertexCount > 0);
+
+	// Cleared edits are dropped, the mesh doesn't see them
+	voxels.setVoxel(0, 0, 0, EMPTY_VOXEL);
+	voxels.setVoxel(16, 16, 16, EMPTY_VOXEL);
+	TEST_CHECK(voxels.hasDirtyBricks());
+	voxels.clearDirtyBricks();
+	TEST_CHECK(!voxels.hasDirtyBricks());
+	for (size_t brick = 0; brick < voxels.getNumBricks(); brick++)
+	{
+		TEST_CHECK(!voxels.isBrickDirty((int)brick));
+	}
+	TEST_CHECK(!brickMesh.update(voxels, 0.5f, glm::vec3(0.f)));
+	TEST_CHECK(brickMesh.getVertexCount() == vertexCount);
+
+	// A new mesh transform re-meshes every brick, edits included
+	TEST_CHECK(brickMesh.update(voxels, 0.25f, glm::vec3(0.f)));
+	TEST_CHECK(brickMesh.getVertexCount() > vertexCount);
+	TEST_CHECK(!voxels.hasDirtyBricks());
+
+	brickMesh.clear();
+	TEST_CHECK(brickMesh.getVertexCount() == 0);
+}
+
+static void benchmarkRemesh(Allocator& allocator)
+{
+	Random::RandomSeed(6);
+	VoxelData voxels(64, 64, 64, allocator);
+	for (int z = 0; z < 64; z++)
+	{
+		for (int x = 0; x < 64; x++)
+		{
+			const float height = 32.f + 12.f * std::sin(x * 0.2f) * std::cos(z * 0.15f);
+			for (int y = 0; y < 64; y++)
+			{
+				voxels(x, y, z) = y < height ? 1 : EMPTY_VOXEL;
+			}
+		}
+	}
+	const size_t maxVerts = (size_t)64 * 64 * 64 * 18;
+	VoxelMeshPBRVertexData* verts = (VoxelMeshPBRVertexData*)allocator.allocate(sizeof(VoxelMeshPBRVertexData) * maxVerts);
+
+	VoxelBrickMesh brickMesh(allocator);
+	brickMesh.update(voxels, 0.5f, glm::vec3(0.f));
+	const int edits = 100;
+	CPUTests::benchmark("Brick re-mesh after one edit, 64^3 terrain, per edit", edits, [&]() {
+		for (int edit = 0; edit < edits; edit++)
+		{
+			const glm::ivec3 coord = randomEditCoord(voxels);
+			voxels.setVoxel(coord.x, coord.y, coord.z, voxels(coord.x, coord.y, coord.z) ? EMPTY_VOXEL : 1);
+			brickMesh.update(voxels, 0.5f, glm::vec3(0.f));
+			brickMesh.copyVerts(verts);
+		}
+	});
+	CPUTests::benchmark("Full binary re-mesh after one edit, 64^3 terrain, per edit", edits, [&]() {
+		for (int edit = 0; edit < edits; edit++)
+		{
+			const glm::ivec3 coord = randomEditCoord(voxels);
+			voxels.setVoxel(coord.x, coord.y, coord.z, voxels(coord.x, coord.y, coord.z) ? EMPTY_VOXEL : 1);
+			size_t vertexCount = 0;
+			voxels.createTriangleMeshBinary(verts, vertexCount, 0.5f, glm::vec3(0.f));
+		}
+	});
+	allocator.deallocate(verts);
+}
+
+void VoxelBrickTests(Allocator& allocator)
+{
+	testBrickLayout(allocator);
+	testEditFlags(allocator);
+	testIncrementalRemesh(allocator);
+	testClearDirty(allocator);
+	benchmarkRemesh(allocator);
+}
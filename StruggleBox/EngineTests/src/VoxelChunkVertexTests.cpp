@@ -0,0 +1,387 @@
+#include "CPUTests.h"
+
+#include "Allocator.h"
+#include "ArenaOperators.h"
+#include "CubeConstants.h"
+#include "FileUtil.h"
+#include "PathUtil.h"
+#include "Random.h"
+#include "VoxelChunkVertex.h"
+#include "VoxelData.h"
+#include "VoxelLoader.h"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Checks the packed chunk vertex format on its own, then checks packed chunk meshes
+// against the visible faces found by brute force and against createTriangleMeshBinary.
+// createTriangleMeshBinary itself has to give exactly the mesh createTriangleMeshReduced
+// gives, for the shipped objects and for random volumes.
+
+static void testPackRoundTrip()
+{
+	TEST_CHECK(sizeof(VoxelChunkVertexData) == 8);
+
+	// Every value of each field with the others at their extremes, so no field bleeds into another
+	const uint32_t maxPosition = VoxelChunkVertex::MAX_POSITION;
+	for (uint32_t value = 0; value <= maxPosition; value++)
+	{
+		const glm::ivec3 corners[3] = {
+			glm::ivec3(value, maxPosition, 0),
+			glm::ivec3(0, value, maxPosition),
+			glm::ivec3(maxPosition, 0, value),
+		};
+		for (int i = 0; i < 3; i++)
+		{
+			const VoxelChunkVertexData vertex = VoxelChunkVertex::pack(corners[i], 5, 255, 3);
+			TEST_CHECK(VoxelChunkVertex::getCorner(vertex) == corners[i]);
+			TEST_CHECK(VoxelChunkVertex::getNormalIndex(vertex) == 5);
+			TEST_CHECK(VoxelChunkVertex::getMaterialID(vertex) == 255);
+			TEST_CHECK(VoxelChunkVertex::getAmbientOcclusion(vertex) == 3);
+		}
+	}
+
+	for (uint32_t normalIndex = 0; normalIndex < 6; normalIndex++)
+	{
+		for (uint32_t materialID = 0; materialID < 256; materialID++)
+		{
+			for (uint32_t ao = 0; ao < 4; ao++)
+			{
+				const glm::ivec3 corner = glm::ivec3(maxPosition, 0, maxPosition);
+				const VoxelChunkVertexData vertex = VoxelChunkVertex::pack(corner, normalIndex, materialID, ao);
+				TEST_CHECK(VoxelChunkVertex::getCorner(vertex) == corner);
+				TEST_CHECK(VoxelChunkVertex::getNormalIndex(vertex) == normalIndex);
+				TEST_CHECK(VoxelChunkVertex::getMaterialID(vertex) == materialID);
+				TEST_CHECK(VoxelChunkVertex::getAmbientOcclusion(vertex) == ao);
+			}
+		}
+	}
+
+	const VoxelChunkVertexData vertex = VoxelChunkVertex::pack(glm::ivec3(3, 4, 5), 0, 1, 0);
+	const glm::vec3 position = VoxelChunkVertex::getPosition(vertex, glm::vec3(-1.f, 2.f, 0.5f), 0.25f);
+	TEST_CHECK(position == glm::vec3(-0.25f, 3.f, 1.75f));
+}
+
+static bool isSolid(const VoxelData& voxels, const glm::ivec3& coord)
+{
+	if (!voxels.contains(coord.x, coord.y, coord.z))
+	{
+		return false;
+	}
+	return voxels.getData()[voxels.getIndex(coord)] != EMPTY_VOXEL;
+}
+
+static glm::ivec3 getSideNormal(const int side)
+{
+	glm::ivec3 normal = glm::ivec3(0);
+	normal[side / 2] = (side % 2) ? 1 : -1;
+	return normal;
+}
+
+// Brute force reference, one unit face per solid voxel side that isn't against another solid voxel
+static size_t countVisibleFaces(const VoxelData& voxels)
+{
+	size_t faceCount = 0;
+	for (int z = 0; z < voxels.getSizeZ(); z++)
+	{
+		for (int y = 0; y < voxels.getSizeY(); y++)
+		{
+			for (int x = 0; x < voxels.getSizeX(); x++)
+			{
+				const glm::ivec3 coord = glm::ivec3(x, y, z);
+				if (!isSolid(voxels, coord))
+				{
+					continue;
+				}
+				for (int side = 0; side < 6; side++)
+				{
+					if (!isSolid(voxels, coord + getSideNormal(side)))
+					{
+						faceCount++;
+					}
+				}
+			}
+		}
+	}
+	return faceCount;
+}
+
+// Every visible unit face has to be covered by exactly one packed face of its voxel's
+// material, and packed faces may not cover anything else
+static void checkPackedFaces(const VoxelData& voxels, const VoxelChunkVertexData* verts, const size_t vertexCount)
+{
+	const glm::ivec3 size = glm::ivec3(voxels.getSizeX(), voxels.getSizeY(), voxels.getSizeZ());
+	std::vector<uint8_t> covered((size_t)size.x * size.y * size.z * 6, 0);
+	size_t coveredCount = 0;
+
+	TEST_CHECK(vertexCount % 6 == 0);
+	for (size_t face = 0; face + 6 <= vertexCount; face += 6)
+	{
+		const uint8_t side = VoxelChunkVertex::getNormalIndex(verts[face]);
+		const uint8_t materialID = VoxelChunkVertex::getMaterialID(verts[face]);
+		TEST_CHECK(side < 6);
+		if (side >= 6)
+		{
+			continue;
+		}
+		glm::ivec3 cornerMin = VoxelChunkVertex::getCorner(verts[face]);
+		glm::ivec3 cornerMax = cornerMin;
+		for (size_t i = face; i < face + 6; i++)
+		{
+			TEST_CHECK(VoxelChunkVertex::getNormalIndex(verts[i]) == side);
+			TEST_CHECK(VoxelChunkVertex::getMaterialID(verts[i]) == materialID);
+			cornerMin = glm::min(cornerMin, VoxelChunkVertex::getCorner(verts[i]));
+			cornerMax = glm::max(cornerMax, VoxelChunkVertex::getCorner(verts[i]));
+		}
+
+		// Flat on the side's plane, which lies on the far corner of the voxels for positive sides
+		const int axis = side / 2;
+		TEST_CHECK(cornerMin[axis] == cornerMax[axis]);
+		const glm::ivec3 normal = getSideNormal(side);
+		glm::ivec3 voxelMin = cornerMin;
+		glm::ivec3 voxelMax = cornerMax;
+		voxelMin[axis] = (side % 2) ? cornerMin[axis] - 1 : cornerMin[axis];
+		voxelMax[axis] = voxelMin[axis] + 1;
+
+		for (int z = voxelMin.z; z < voxelMax.z; z++)
+		{
+			for (int y = voxelMin.y; y < voxelMax.y; y++)
+			{
+				for (int x = voxelMin.x; x < voxelMax.x; x++)
+				{
+					const glm::ivec3 coord = glm::ivec3(x, y, z);
+					const bool inside = voxels.contains(x, y, z);
+					TEST_CHECK(inside);
+					if (!inside)
+					{
+						continue;
+					}
+					TEST_CHECK(voxels.getData()[voxels.getIndex(coord)] == materialID);
+					TEST_CHECK(!isSolid(voxels, coord + normal));
+					uint8_t& coveredFace = covered[(size_t)voxels.getIndex(coord) * 6 + side];
+					TEST_CHECK(coveredFace == 0);
+					coveredFace = 1;
+					coveredCount++;
+				}
+			}
+		}
+	}
+	TEST_CHECK(coveredCount == countVisibleFaces(voxels));
+}
+
+// Same faces in the same order as the float mesh, only the encoding differs
+static void compareWithBinaryMesh(
+	const VoxelData& voxels,
+	const VoxelChunkVertexData* packedVerts,
+	const size_t packedCount,
+	const VoxelMeshPBRVertexData* binaryVerts,
+	const size_t binaryCount,
+	const float radius,
+	const glm::vec3& offset)
+{
+	TEST_CHECK(packedCount == binaryCount);
+	const size_t count = packedCount < binaryCount ? packedCount : binaryCount;
+	const glm::vec3 origin = voxels.getMeshOrigin(radius, offset);
+	const float tolerance = 1e-4f * (glm::length(offset) + radius * 128.f);
+	for (size_t i = 0; i < count; i++)
+	{
+		const glm::vec3 position = VoxelChunkVertex::getPosition(packedVerts[i], origin, radius * 2.f);
+		const glm::vec3 difference = glm::abs(position - binaryVerts[i].pos);
+		TEST_CHECK(difference.x <= tolerance && difference.y <= tolerance && difference.z <= tolerance);
+		TEST_CHECK(CubeConstants::cube_normals[VoxelChunkVertex::getNormalIndex(packedVerts[i]) % 6] == binaryVerts[i].normal);
+	}
+}
+
+static void meshAndCheck(Allocator& allocator, const VoxelData& voxels, const float radius, const glm::vec3& offset)
+{
+	// Merged faces never need more vertices than one face per visible voxel side
+	const size_t maxVerts = countVisibleFaces(voxels) * 6;
+	VoxelChunkVertexData* packedVerts = (VoxelChunkVertexData*)allocator.allocate(sizeof(VoxelChunkVertexData) * (maxVerts + 6));
+	VoxelMeshPBRVertexData* binaryVerts = (VoxelMeshPBRVertexData*)allocator.allocate(sizeof(VoxelMeshPBRVertexData) * (maxVerts + 6));
+
+	size_t packedCount = 0;
+	voxels.createTriangleMeshPacked(packedVerts, packedCount);
+	size_t binaryCount = 0;
+	voxels.createTriangleMeshBinary(binaryVerts, binaryCount, radius, offset);
+
+	TEST_CHECK(packedCount <= maxVerts);
+	checkPackedFaces(voxels, packedVerts, packedCount);
+	compareWithBinaryMesh(voxels, packedVerts, packedCount, binaryVerts, binaryCount, radius, offset);
+
+	allocator.deallocate(binaryVerts);
+	allocator.deallocate(packedVerts);
+}
+
+// Returns false on a mismatch so callers can say which volume it was
+static bool compareBinaryWithReduced(Allocator& allocator, const VoxelData& voxels, const float radius, const glm::vec3& offset)
+{
+	const size_t maxVerts = countVisibleFaces(voxels) * 6 + 6;
+	VoxelMeshPBRVertexData* reducedVerts = (VoxelMeshPBRVertexData*)allocator.allocate(sizeof(VoxelMeshPBRVertexData) * maxVerts);
+	VoxelMeshPBRVertexData* binaryVerts = (VoxelMeshPBRVertexData*)allocator.allocate(sizeof(VoxelMeshPBRVertexData) * maxVerts);
+
+	size_t reducedCount = 0;
+	voxels.createTriangleMeshReduced(reducedVerts, reducedCount, radius, offset);
+	size_t binaryCount = 0;
+	voxels.createTriangleMeshBinary(binaryVerts, binaryCount, radius, offset);
+
+	// Every field is a float, so identical vertices are identical bytes
+	const bool matches = reducedCount == binaryCount &&
+		memcmp(reducedVerts, binaryVerts, sizeof(VoxelMeshPBRVertexData) * reducedCount) == 0;
+	TEST_CHECK(reducedCount <= maxVerts && binaryCount <= maxVerts);
+	TEST_CHECK(matches);
+
+	allocator.deallocate(binaryVerts);
+	allocator.deallocate(reducedVerts);
+	return matches;
+}
+
+static void fillRandom(VoxelData& voxels, const int density, const int materialCount)
+{
+	const int voxelCount = voxels.getSizeX() * voxels.getSizeY() * voxels.getSizeZ();
+	for (int i = 0; i < voxelCount; i++)
+	{
+		voxels[i] = Random::RandomInt(0, 99) < density ? (uint8_t)Random::RandomInt(1, materialCount) : EMPTY_VOXEL;
+	}
+}
+
+// Rolling hills, close to what the terrain chunks look like
+static void fillTerrain(VoxelData& voxels)
+{
+	for (int z = 0; z < voxels.getSizeZ(); z++)
+	{
+		for (int x = 0; x < voxels.getSizeX(); x++)
+		{
+			const float height = voxels.getSizeY() * (0.5f + 0.2f * std::sin(x * 0.2f) * std::cos(z * 0.15f));
+			for (int y = 0; y < voxels.getSizeY(); y++)
+			{
+				voxels(x, y, z) = y < height ? (y + 3 < height ? 2 : 1) : EMPTY_VOXEL;
+			}
+		}
+	}
+}
+
+static void testPackedMeshes(Allocator& allocator)
+{
+	Random::RandomSeed(4);
+	for (int test = 0; test < 200; test++)
+	{
+		const uint16_t maxSide = test < 20 ? 64 : 24;
+		VoxelData voxels(Random::RandomInt(1, maxSide), Random::RandomInt(1, maxSide), Random::RandomInt(1, maxSide), allocator);
+		if (test < 20)
+		{
+			// Sparse so the 64 voxel sides stay affordable
+			fillRandom(voxels, Random::RandomInt(0, 5), 1 + test % 4);
+		}
+		else
+		{
+			fillRandom(voxels, Random::RandomInt(0, 100), Random::RandomInt(1, 255));
+		}
+		const float radius = 0.05f + 0.5f * (float)Random::RandomDouble();
+		const glm::vec3 offset = glm::vec3(Random::RandomInt(-100, 100), Random::RandomInt(-100, 100), Random::RandomInt(-100, 100));
+		meshAndCheck(allocator, voxels, radius, offset);
+	}
+
+	VoxelData full(64, 64, 64, allocator);
+	full.fill(7);
+	meshAndCheck(allocator, full, 0.5f, glm::vec3(0.f));
+
+	VoxelData checkerboard(16, 16, 16, allocator);
+	for (int z = 0; z < 16; z++)
+	{
+		for (int y = 0; y < 16; y++)
+		{
+			for (int x = 0; x < 16; x++)
+			{
+				checkerboard(x, y, z) = ((x + y + z) % 2) ? 3 : EMPTY_VOXEL;
+			}
+		}
+	}
+	meshAndCheck(allocator, checkerboard, 0.25f, glm::vec3(1.f, 2.f, 3.f));
+
+	VoxelData terrain(64, 64, 64, allocator);
+	fillTerrain(terrain);
+	meshAndCheck(allocator, terrain, 0.125f, glm::vec3(32.f, 0.f, -32.f));
+}
+
+static void testBinaryMatchesReduced(Allocator& allocator)
+{
+	// The shipped objects, old BWOCB cube sets and VxlDt files alike
+	std::vector<std::string> fileNames;
+	FileUtil::GetFilesOfType(PathUtil::ObjectsPath(), ".bwo", fileNames);
+	TEST_CHECK(!fileNames.empty());
+	size_t objectCount = 0;
+	for (const std::string& fileName : fileNames)
+	{
+		VoxelData* voxels = VoxelLoader::load(fileName, allocator);
+		TEST_CHECK(voxels != nullptr);
+		if (!voxels)
+		{
+			continue;
+		}
+		if (!compareBinaryWithReduced(allocator, *voxels, 0.5f, glm::vec3(1.f, 2.f, 3.f)))
+		{
+			Log::Error("[CPUTests] Binary and reduced meshes differ for %s", fileName.c_str());
+		}
+		CUSTOM_DELETE(voxels, allocator);
+		objectCount++;
+	}
+
+	Random::RandomSeed(3);
+	for (int test = 0; test < 600; test++)
+	{
+		// Mostly small volumes, some with sides of 64 and a few past it, which fall back to the reduced mesher
+		const int maxSide = test % 3 == 0 ? 64 : 17;
+		const int sizeX = test % 100 == 99 ? 65 + test % 7 : Random::RandomInt(1, maxSide);
+		VoxelData voxels(sizeX, Random::RandomInt(1, maxSide), Random::RandomInt(1, maxSide), allocator);
+		fillRandom(voxels, Random::RandomInt(0, 99), Random::RandomInt(1, 4));
+		const float radius = 0.05f + 0.5f * (float)Random::RandomDouble();
+		const glm::vec3 offset = glm::vec3(Random::RandomInt(-100, 100), Random::RandomInt(-100, 100), Random::RandomInt(-100, 100));
+		if (!compareBinaryWithReduced(allocator, voxels, radius, offset))
+		{
+			Log::Error("[CPUTests] Binary and reduced meshes differ for random volume %i", test);
+		}
+	}
+	Log::Info("[CPUTests] Binary and reduced meshes compared for %zu objects and 600 random volumes", objectCount);
+}
+
+static void benchmarkMeshing(Allocator& allocator)
+{
+	VoxelData terrain(64, 64, 64, allocator);
+	fillTerrain(terrain);
+	const size_t voxelCount = (size_t)64 * 64 * 64;
+	const size_t maxVerts = countVisibleFaces(terrain) * 6;
+	VoxelChunkVertexData* packedVerts = (VoxelChunkVertexData*)allocator.allocate(sizeof(VoxelChunkVertexData) * maxVerts);
+	VoxelMeshPBRVertexData* binaryVerts = (VoxelMeshPBRVertexData*)allocator.allocate(sizeof(VoxelMeshPBRVertexData) * maxVerts);
+
+	size_t packedCount = 0;
+	CPUTests::benchmark("Packed chunk mesh 64^3 terrain, per voxel", voxelCount, [&]() {
+		packedCount = 0;
+		terrain.createTriangleMeshPacked(packedVerts, packedCount);
+	});
+	size_t binaryCount = 0;
+	CPUTests::benchmark("Binary PBR mesh 64^3 terrain, per voxel", voxelCount, [&]() {
+		binaryCount = 0;
+		terrain.createTriangleMeshBinary(binaryVerts, binaryCount, 0.125f, glm::vec3(0.f));
+	});
+	TEST_CHECK(packedCount == binaryCount);
+	size_t reducedCount = 0;
+	CPUTests::benchmark("Reduced PBR mesh 64^3 terrain, per voxel", voxelCount, [&]() {
+		reducedCount = 0;
+		terrain.createTriangleMeshReduced(binaryVerts, reducedCount, 0.125f, glm::vec3(0.f));
+	});
+	TEST_CHECK(reducedCount == binaryCount);
+	Log::Info("[CPUTests] %zu vertices, %zu bytes packed, %zu bytes as VoxelMeshPBRVertexData",
+		packedCount, packedCount * sizeof(VoxelChunkVertexData), binaryCount * sizeof(VoxelMeshPBRVertexData));
+
+	allocator.deallocate(binaryVerts);
+	allocator.deallocate(packedVerts);
+}
+
+void VoxelChunkVertexTests(Allocator& allocator)
+{
+	testPackRoundTrip();
+	testPackedMeshes(allocator);
+	testBinaryMatchesReduced(allocator);
+	benchmarkMeshing(allocator);
+}
@@ -0,0 +1,228 @@
+#include "CPUTests.h"
+
+#include "Allocator.h"
+#include "ArenaOperators.h"
+#include "FileUtil.h"
+#include "PathUtil.h"
+#include "Serialise.h"
+#include "VoxelData.h"
+#include "VoxelLoader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Every shipped object saved as a compressed 0.2 file has to load back with exactly the
+// voxels it had as a 0.1 or cube set file, and damaged 0.2 files must not load at all.
+// Writes its scratch file next to the executable and removes it again.
+
+const size_t VOXELDATA_RAW_DATA_OFFSET = 20;        // Tag and three sizes
+const size_t VOXELDATA_COMPRESSED_SIZE_OFFSET = 20;
+const size_t VOXELDATA_CHECKSUM_OFFSET = 24;
+const size_t VOXELDATA_STREAM_OFFSET = 28;
+
+static std::vector<uint8_t> readFile(const std::string& path)
+{
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+	std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	file.write((const char*)bytes.data(), bytes.size());
+}
+
+static bool isSameVoxels(const VoxelData& a, const VoxelData& b)
+{
+	return a.getSizeX() == b.getSizeX() &&
+		a.getSizeY() == b.getSizeY() &&
+		a.getSizeZ() == b.getSizeZ() &&
+		memcmp(a.getData(), b.getData(), a.getMemoryUsage()) == 0;
+}
+
+// Best of a few loads, in milliseconds
+static double timeLoad(const std::string& fileName, Allocator& allocator)
+{
+	double best = 0.0;
+	for (int run = 0; run < 5; run++)
+	{
+		const double start = Timer::Milliseconds();
+		VoxelData* voxels = VoxelLoader::load(fileName, allocator);
+		const double time = Timer::Milliseconds() - start;
+		if (voxels)
+		{
+			CUSTOM_DELETE(voxels, allocator);
+		}
+		if (run == 0 || time < best)
+		{
+			best = time;
+		}
+	}
+	return best;
+}
+
+static void testShippedObjects(Allocator& allocator, const std::string& scratchPath)
+{
+	std::vector<std::string> fileNames;
+	FileUtil::GetFilesOfType(PathUtil::ObjectsPath(), ".bwo", fileNames);
+	TEST_CHECK(!fileNames.empty());
+
+	size_t objectCount = 0;
+	long oldBytes = 0;
+	long newBytes = 0;
+	double oldLoadTime = 0.0;
+	double newLoadTime = 0.0;
+	for (const std::string& fileName : fileNames)
+	{
+		VoxelData* original = VoxelLoader::load(fileName, allocator);
+		TEST_CHECK(original != nullptr);
+		if (!original)
+		{
+			continue;
+		}
+		VoxelLoader::save(scratchPath, original, allocator);
+		VoxelData* reloaded = VoxelLoader::load(scratchPath, allocator);
+		TEST_CHECK(reloaded != nullptr);
+		if (reloaded)
+		{
+			TEST_CHECK(isSameVoxels(*original, *reloaded));
+			// Uncompressed files hold the voxels as they are, compare with the bytes on disk too
+			const std::vector<uint8_t> fileBytes = readFile(PathUtil::getObjectPath(fileName));
+			if (fileBytes.size() >= VOXELDATA_RAW_DATA_OFFSET && memcmp(fileBytes.data() + 5, VOXELDATA_VERSION_RAW, 3) == 0)
+			{
+				TEST_CHECK(fileBytes.size() == VOXELDATA_RAW_DATA_OFFSET + reloaded->getMemoryUsage());
+				TEST_CHECK(memcmp(fileBytes.data() + VOXELDATA_RAW_DATA_OFFSET, reloaded->getData(),
+					std::min(fileBytes.size() - VOXELDATA_RAW_DATA_OFFSET, reloaded->getMemoryUsage())) == 0);
+			}
+			CUSTOM_DELETE(reloaded, allocator);
+		}
+		CUSTOM_DELETE(original, allocator);
+
+		oldBytes += FileUtil::GetFileSize(PathUtil::getObjectPath(fileName));
+		newBytes += FileUtil::GetFileSize(scratchPath);
+		oldLoadTime += timeLoad(fileName, allocator);
+		newLoadTime += timeLoad(scratchPath, allocator);
+		objectCount++;
+	}
+	Log::Info("[CPUTests] %zu objects, 0.1 and cube set files %li bytes, 0.2 files %li bytes", objectCount, oldBytes, newBytes);
+	Log::Info("[CPUTests] Loading all objects took %.3f ms from 0.1 and cube set files, %.3f ms from 0.2 files", oldLoadTime, newLoadTime);
+}
+
+// A hand written 0.1 file has to load as the same voxels once saved and loaded as 0.2
+static void testRawRoundTrip(Allocator& allocator, const std::string& scratchPath)
+{
+	Random::RandomSeed(7);
+	VoxelData voxels(13, 7, 29, allocator);
+	for (size_t i = 0; i < voxels.getMemoryUsage(); i++)
+	{
+		voxels[(int)i] = Random::RandomInt(0, 3) == 0 ? (uint8_t)Random::RandomInt(1, 255) : EMPTY_VOXEL;
+	}
+	std::vector<uint8_t> rawFile(VOXELDATA_RAW_DATA_OFFSET + voxels.getMemoryUsage());
+	memcpy(rawFile.data(), VOXELDATA_HEADER, 5);
+	memcpy(rawFile.data() + 5, VOXELDATA_VERSION_RAW, 3);
+	Serialise::serialise((unsigned int)voxels.getSizeX(), rawFile.data() + 8);
+	Serialise::serialise((unsigned int)voxels.getSizeY(), rawFile.data() + 12);
+	Serialise::serialise((unsigned int)voxels.getSizeZ(), rawFile.data() + 16);
+	memcpy(rawFile.data() + VOXELDATA_RAW_DATA_OFFSET, voxels.getData(), voxels.getMemoryUsage());
+	writeFile(scratchPath, rawFile);
+
+	VoxelData* raw = VoxelLoader::load(scratchPath, allocator);
+	TEST_CHECK(raw != nullptr && isSameVoxels(*raw, voxels));
+	if (raw)
+	{
+		VoxelLoader::save(scratchPath, raw, allocator);
+		CUSTOM_DELETE(raw, allocator);
+	}
+	const std::vector<uint8_t> compressedFile = readFile(scratchPath);
+	TEST_CHECK(compressedFile.size() > VOXELDATA_STREAM_OFFSET && memcmp(compressedFile.data() + 5, VOXELDATA_VERSION, 3) == 0);
+	VoxelData* compressed = VoxelLoader::load(scratchPath, allocator);
+	TEST_CHECK(compressed != nullptr && isSameVoxels(*compressed, voxels));
+	if (compressed)
+	{
+		CUSTOM_DELETE(compressed, allocator);
+	}
+}
+
+static void checkDoesNotLoad(Allocator& allocator, const std::string& scratchPath, const std::vector<uint8_t>& bytes)
+{
+	writeFile(scratchPath, bytes);
+	VoxelData* voxels = VoxelLoader::load(scratchPath, allocator);
+	TEST_CHECK(voxels == nullptr);
+	if (voxels)
+	{
+		CUSTOM_DELETE(voxels, allocator);
+	}
+}
+
+static void testDamagedFiles(Allocator& allocator, const std::string& scratchPath)
+{
+	// Noisy enough that the zlib stream spans more than one read
+	Random::RandomSeed(8);
+	VoxelData voxels(48, 40, 44, allocator);
+	for (size_t i = 0; i < voxels.getMemoryUsage(); i++)
+	{
+		voxels[(int)i] = (uint8_t)Random::RandomInt(0, 255);
+	}
+	VoxelLoader::save(scratchPath, &voxels, allocator);
+	const std::vector<uint8_t> intact = readFile(scratchPath);
+	TEST_CHECK(intact.size() > VOXELDATA_STREAM_OFFSET + 16 * 1024);
+	VoxelData* loaded = VoxelLoader::load(scratchPath, allocator);
+	TEST_CHECK(loaded != nullptr && isSameVoxels(*loaded, voxels));
+	if (loaded)
+	{
+		CUSTOM_DELETE(loaded, allocator);
+	}
+	if (intact.size() <= VOXELDATA_STREAM_OFFSET)
+	{
+		return;
+	}
+
+	Log::Info("[CPUTests] Loading damaged files, the loader errors that follow are expected");
+	// Cut off in the tag, the header, at the first read, in the middle and right before the end
+	const size_t cuts[10] = {
+		0, 5, 8, 12, 20, VOXELDATA_STREAM_OFFSET - 1, VOXELDATA_STREAM_OFFSET,
+		VOXELDATA_STREAM_OFFSET + 16 * 1024, intact.size() / 2, intact.size() - 1,
+	};
+	for (const size_t cut : cuts)
+	{
+		checkDoesNotLoad(allocator, scratchPath, std::vector<uint8_t>(intact.begin(), intact.begin() + std::min(cut, intact.size() - 1)));
+	}
+
+	// One damaged byte each
+	const size_t damaged[7] = {
+		11,                                     // Size x, the voxel count no longer matches
+		VOXELDATA_COMPRESSED_SIZE_OFFSET + 3,   // Compressed size
+		VOXELDATA_CHECKSUM_OFFSET + 1,          // CRC
+		VOXELDATA_STREAM_OFFSET + 1,            // zlib header
+		VOXELDATA_STREAM_OFFSET + 100,
+		intact.size() / 2,
+		intact.size() - 1,                      // zlib's own checksum
+	};
+	for (const size_t offset : damaged)
+	{
+		std::vector<uint8_t> bytes = intact;
+		bytes[offset] ^= 0x5A;
+		checkDoesNotLoad(allocator, scratchPath, bytes);
+	}
+
+	// Compressed size off by one either way
+	for (const int change : { -1, 1 })
+	{
+		std::vector<uint8_t> bytes = intact;
+		const unsigned int compressedSize = Serialise::deserialiseInt(bytes.data() + VOXELDATA_COMPRESSED_SIZE_OFFSET);
+		Serialise::serialise(compressedSize + change, bytes.data() + VOXELDATA_COMPRESSED_SIZE_OFFSET);
+		checkDoesNotLoad(allocator, scratchPath, bytes);
+	}
+}
+
+void VoxelLoaderTests(Allocator& allocator)
+{
+	const std::string scratchPath = FileUtil::GetPath() + "CPUTests_VoxelLoader.tmp";
+	testShippedObjects(allocator, scratchPath);
+	testRawRoundTrip(allocator, scratchPath);
+	testDamagedFiles(allocator, scratchPath);
+	std::remove(scratchPath.c_str());
+}
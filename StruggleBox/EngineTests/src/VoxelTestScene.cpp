@@ -157,14 +157,8 @@ void VoxelTestScene::Draw()
 		//	}
 		//}
 
-		const glm::mat4& viewMatrix = m_renderer3D.getDefaultCamera().getViewMatrix();
-		const glm::mat4& projectionMatrix = m_renderer3D.getDefaultCamera().getProjectionMatrix();
-		const glm::mat4 viewProjection = projectionMatrix * viewMatrix;
-
 		const Shader* voxelShader = m_renderCore.getShaderByID(m_voxelInstancesShaderID);
 		voxelShader->begin();
-		voxelShader->setUniformM4fv("projectionMatrix", projectionMatrix);
-		voxelShader->setUniformM4fv("viewMatrix", viewMatrix);
 		voxelShader->setUniform3fv("cameraPosition", m_renderer3D.getDefaultCamera().getPosition());
 		voxelShader->end();
 	}
@@ -186,15 +180,6 @@ void VoxelTestScene::Draw()
 				instances[(x * 16) + y] = { glm::vec3(x, 0.0, y), glm::vec3(1.f, 1.f, 1.f), glm::quat(), HSVColor((x / 16.f)*360.f, y / 16.f, 1.f)};
 			}
 		}
-
-		const glm::mat4& viewMatrix = m_renderer3D.getDefaultCamera().getViewMatrix();
-		const glm::mat4& projectionMatrix = m_renderer3D.getDefaultCamera().getProjectionMatrix();
-		const glm::mat4 viewProjection = projectionMatrix * viewMatrix;
-		const Shader* voxelShader = m_renderCore.getShaderByID(m_simplerCubeShaderID);
-		voxelShader->begin();
-		voxelShader->setUniformM4fv("projectionMatrix", projectionMatrix);
-		voxelShader->setUniformM4fv("viewMatrix", viewMatrix);
-		voxelShader->end();
 	}
 
 	m_renderer3D.flush();
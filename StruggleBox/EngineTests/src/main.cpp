@@ -14,13 +14,21 @@
 #include "OSWindow.h"
 #include "StatTracker.h"
 #include "Options.h"
+#include "CPUTests.h"
+#include <cstring>
 
 int main(int argc, char* argv[])
 {
-	const size_t HEAP_SIZE = 512 * 1024 * 1024;
-	unsigned char* heap = (unsigned char*)malloc(HEAP_SIZE); // This is the heap memory for the entire application
+	// Headless CPU tests and benchmarks: EngineTests -cputests [suite]
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-cputests") == 0)
+		{
+			return CPUTests::runHeadless(i + 1 < argc ? argv[i + 1] : nullptr);
+		}
+	}
 
-	EngineCore& core = EngineCore::create(argc, const_cast<const char**>(argv), heap);
+	EngineCore& core = EngineCore::create(argc, const_cast<const char**>(argv));
 	core.setTitle("Engine Tests");
 	core.initialize();
 	
@@ -64,7 +72,5 @@ int main(int argc, char* argv[])
 	int result = core.terminate();
 	EngineCore::destroy(core);
 
-	free(heap);
-
 	return result;
 }
\ No newline at end of file
@@ -13,10 +13,7 @@
 
 int main(int argc, char* argv[])
 {
-	const size_t HEAP_SIZE = 128 * 1024 * 1024;
-	unsigned char* heap = (unsigned char*)malloc(HEAP_SIZE); // This is the heap memory for the entire application
-
-	EngineCore& core = EngineCore::create(argc, const_cast<const char**>(argv), heap);
+	EngineCore& core = EngineCore::create(argc, const_cast<const char**>(argv));
 	core.setTitle("Engine Tests");
 	core.initialize();
 
@@ -37,7 +34,5 @@ int main(int argc, char* argv[])
 	int result = core.terminate();
 	EngineCore::destroy(core);
 
-	free(heap);
-
 	return result;
 }
\ No newline at end of file
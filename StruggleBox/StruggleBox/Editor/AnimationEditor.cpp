@@ -5,6 +5,7 @@
 #include "VoxelRenderer.h"
 #include "PathUtil.h"
 #include "Camera3D.h"
+#include "Frustum.h"
 #include "ButtonNode.h"
 
 AnimationEditor::AnimationEditor(
@@ -65,7 +66,8 @@ void AnimationEditor::Draw()
 {
 	EditorScene::Draw();
 
-	m_voxels.draw();
+	const Camera3D& camera = m_renderer.getDefaultCamera();
+	m_voxels.draw(Frustum(camera.getProjectionMatrix() * camera.getViewMatrix()));
 
 	//_cursor.posWorld = _renderer.GetCursor3DPos(_cursor.posScrn);
 	auto data = m_skeleton.getInstanceData(m_skeletonWindow->getCurrentAnimation(), 0.0f);
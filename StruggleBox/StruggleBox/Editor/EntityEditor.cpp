@@ -5,6 +5,9 @@
 #include "Lighting3DDeferred.h"
 #include "Camera3D.h"
 #include "FileUtil.h"
+#include "Frustum.h"
+#include "Injector.h"
+#include "JobSystem.h"
 #include "PathUtil.h"
 #include "SceneManager.h"
 #include "Log.h"
@@ -48,7 +51,7 @@ EntityEditor::EntityEditor(
 	, m_particles(allocator, injector)
 	, m_physics(allocator)
 	, m_voxels(renderer, allocator)
-	, m_entityManager(allocator, renderer, m_voxels, m_particles, m_physics)
+	, m_entityManager(allocator, injector.getInstance<JobSystem>(), renderer, m_voxels, m_particles, m_physics)
 	, m_entity(nullptr)
 	, m_entityID(0)
 	, m_entityWindow(nullptr)
@@ -121,7 +124,8 @@ void EntityEditor::Draw()
 {
 	EditorScene::Draw();
 
-	m_voxels.draw();
+	const Camera3D& camera = m_renderer.getDefaultCamera();
+	m_voxels.draw(Frustum(camera.getProjectionMatrix() * camera.getViewMatrix()));
 	m_entityManager.draw();
 	m_particles.draw();
 
@@ -137,14 +137,6 @@ void MaterialEditor::Draw()
 	drawParams.blendMode = BLEND_MODE_DISABLED;
 	drawParams.depthMode = DEPTH_MODE_DEFAULT;
 
-	const glm::mat4& viewMatrix = m_renderer.getDefaultCamera().getViewMatrix();
-	const glm::mat4& projectionMatrix = m_renderer.getDefaultCamera().getProjectionMatrix();
-	const Shader* voxelShader = m_renderCore.getShaderByID(m_voxelMeshShaderID);
-	voxelShader->begin();
-	voxelShader->setUniformM4fv("projectionMatrix", projectionMatrix);
-	voxelShader->setUniformM4fv("viewMatrix", viewMatrix);
-	voxelShader->end();
-
 	const uint8_t materialID = m_materialsWindow->getCurrentID();
 	MaterialDef& current = m_materialData[materialID];
 
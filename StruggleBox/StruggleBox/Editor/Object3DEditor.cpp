@@ -49,6 +49,7 @@ Object3DEditor::Object3DEditor(
 	StatTracker& statTracker)
 	: EditorScene(allocator, renderer, renderCore, osWindow, options, input, statTracker)
 	, m_voxelData(nullptr)
+	, m_voxelMesh(allocator)
 	, m_objectWindow(nullptr)
 	, m_meshWindow(nullptr)
 	, m_objectDrawDataID(0)
@@ -240,11 +241,11 @@ void Object3DEditor::Create()
 		if (!projectedInside)
 			return;
 
-		(*m_voxelData)(projectedVoxelXoord.x, projectedVoxelXoord.y, projectedVoxelXoord.z) = m_objectWindow->getCurrentID();
+		m_voxelData->setVoxel(projectedVoxelXoord.x, projectedVoxelXoord.y, projectedVoxelXoord.z, m_objectWindow->getCurrentID());
 	}
 	else
 	{ 
-		(*m_voxelData)(_cursorObjectCoord.x, _cursorObjectCoord.y, _cursorObjectCoord.z) = m_objectWindow->getCurrentID();
+		m_voxelData->setVoxel(_cursorObjectCoord.x, _cursorObjectCoord.y, _cursorObjectCoord.z, m_objectWindow->getCurrentID());
 	}
 	refreshVoxelMesh();
 }
@@ -257,7 +258,7 @@ void Object3DEditor::Erase()
 	const uint8_t cursorVoxel = (*m_voxelData)(_cursorObjectCoord.x, _cursorObjectCoord.y, _cursorObjectCoord.z);
 	if (cursorVoxel != EMPTY_VOXEL)
 	{
-		(*m_voxelData)(_cursorObjectCoord.x, _cursorObjectCoord.y, _cursorObjectCoord.z) = EMPTY_VOXEL;
+		m_voxelData->setVoxel(_cursorObjectCoord.x, _cursorObjectCoord.y, _cursorObjectCoord.z, EMPTY_VOXEL);
 	}
 	else
 	{
@@ -273,7 +274,7 @@ void Object3DEditor::Erase()
 		if (!projectedInside)
 			return;
 
-		(*m_voxelData)(projectedVoxelXoord.x, projectedVoxelXoord.y, projectedVoxelXoord.z) = EMPTY_VOXEL;
+		m_voxelData->setVoxel(projectedVoxelXoord.x, projectedVoxelXoord.y, projectedVoxelXoord.z, EMPTY_VOXEL);
 	}
 	refreshVoxelMesh();
 }
@@ -451,12 +452,12 @@ bool Object3DEditor::OnMouse(const glm::ivec2& coord)
 
 void Object3DEditor::refreshVoxelMesh()
 {
-	const size_t numVoxels = m_voxelData->getSizeX() * m_voxelData->getSizeY() * m_voxelData->getSizeZ();
-	VoxelMeshPBRVertexData* tempVerts = (VoxelMeshPBRVertexData*)m_allocator.allocate(sizeof(VoxelMeshPBRVertexData) * numVoxels * 36);
-	size_t vertexCount = 0;
-	m_voxelData->createTriangleMeshReduced(tempVerts, vertexCount, 1.f, glm::vec3());
-	VoxelMeshPBRVertexData* verts = m_renderer.bufferVoxelMeshVerts(vertexCount, m_objectDrawDataID);
-	memcpy(verts, tempVerts, sizeof(VoxelMeshPBRVertexData) * vertexCount);
-	m_allocator.deallocate(tempVerts);
+	// Only the bricks touched since the last refresh are meshed again
+	if (!m_voxelMesh.update(*m_voxelData, 1.f, glm::vec3()))
+	{
+		return;
+	}
+	VoxelMeshPBRVertexData* verts = m_renderer.bufferVoxelMeshVerts(m_voxelMesh.getVertexCount(), m_objectDrawDataID);
+	m_voxelMesh.copyVerts(verts);
 }
 
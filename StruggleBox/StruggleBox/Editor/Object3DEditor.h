@@ -3,6 +3,7 @@
 #include "EditorScene.h"
 #include "AABB3D.h"
 #include "EditorCursor3D.h"
+#include "VoxelBrickMesh.h"
 
 class Allocator;
 class MeshWindow;
@@ -48,6 +49,7 @@ public:
 
 private:	
 	VoxelData* m_voxelData;
+	VoxelBrickMesh m_voxelMesh;
 	ObjectWindow* m_objectWindow;
 	MeshWindow* m_meshWindow;
 
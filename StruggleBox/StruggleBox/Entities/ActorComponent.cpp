@@ -1,4 +1,5 @@
 #include "ActorComponent.h"
+#include "EntityAttributes.h"
 #include "EntityManager.h"
 #include "Timer.h"
 #include "Random.h"
@@ -17,7 +18,7 @@ _manager(manager)
 {
     lastUpdateTime=0.0;
     lastMoveTime=0.0;
-    targetPosition = _manager.getEntity(ownerID)->GetAttributeDataPtr<glm::vec3>("position");
+    targetPosition = _manager.getEntity(ownerID)->GetAttributeData(ATTR_POSITION);
     targetState = Target_Move;
     targetEntity = NULL;
 }
@@ -31,41 +32,41 @@ void ActorComponent::update(const double delta)
     lastUpdateTime += delta;
     lastMoveTime += delta;
     Entity* m_owner = _manager.getEntity(_ownerID);
-    const glm::vec3 position = m_owner->GetAttributeDataPtr<glm::vec3>("position");
+    const glm::vec3 position = m_owner->GetAttributeData(ATTR_POSITION);
     if ( lastUpdateTime > brainUpdateTime ) {       // Time to update the brain
         // Try to gather data about us and the environment in 0.0 to 1.0 ranges
-        const int alignment = m_owner->GetAttributeDataPtr<int>("alignment");
-        const int maxHealth = m_owner->GetAttributeDataPtr<int>("maxHealth");
-        const int health = m_owner->GetAttributeDataPtr<int>("health");
+        const int alignment = m_owner->GetAttributeData(ATTR_ALIGNMENT);
+        const int maxHealth = m_owner->GetAttributeData(ATTR_MAX_HEALTH);
+        const int health = m_owner->GetAttributeData(ATTR_HEALTH);
         float healthFactor = float(health)/maxHealth;   // If high we are good to attack
-        bool armed = (m_owner->GetAttributeDataPtr<int>("rightHandItemID") > -1);
+        bool armed = (m_owner->GetAttributeData(ATTR_RIGHT_HAND_ITEM_ID) > -1);
         float attackInterest = (armed?0.5f:-0.5f);      // How much we want to attack/run
         if ( alignment == ALIGNMENT_CHAOTIC ) attackInterest += 0.5f;
         // TODO:: Get value for weapon damage etc to prioritize grabbing new weapons
         
         // Gather nearby entities
-        std::map<EntityID, Entity*> nearbyEnts = _manager.getNearbyEntities(position,
-                                                                         _ownerID,
-                                                                         ENTITY_NONE,
-                                                                         brainViewDist);
-        std::map<EntityID, Entity*>::iterator it;
+        m_nearbyEntities.clear();
+        _manager.getNearbyEntities(position,
+                                   m_nearbyEntities,
+                                   _ownerID,
+                                   ENTITY_NONE,
+                                   brainViewDist);
         Entity* interestingEntity = NULL;   // Try to find biggest absolute interest,
         int interestType = ENTITY_NONE;
         float topInterest = 0.0f;           // Negative values mean we want to move away
-        for (it=nearbyEnts.begin(); it != nearbyEnts.end(); it++) {
-            Entity* ent = it->second;
-            const int type = ent->GetAttributeDataPtr<int>("type");
+        for (Entity* ent : m_nearbyEntities) {
+            const int type = ent->GetAttributeData(ATTR_TYPE);
             float interest = 0.0f;
             if ( type == ENTITY_ITEM ) {
-                if ( ent->GetAttributeDataPtr<int>("ownerID") == 0 ) {
-                    if ( ent->GetAttributeDataPtr<int>("damage") > 0 ) {
+                if ( ent->GetAttributeData(ATTR_OWNER_ID) == 0 ) {
+                    if ( ent->GetAttributeData(ATTR_DAMAGE) > 0 ) {
                         interest = (armed ? 0.0f : 1.0f);
-                    } else if ( ent->GetAttributeDataPtr<int>("healing") > 0 ) {
+                    } else if ( ent->GetAttributeData(ATTR_HEALING) > 0 ) {
                         interest = (1.f-healthFactor);
                     }
                 }
             } else if ( type == ENTITY_HUMANOID || type == ENTITY_SKELETON ) {
-                const int entAlignment = ent->GetAttributeDataPtr<int>("alignment");
+                const int entAlignment = ent->GetAttributeData(ATTR_ALIGNMENT);
                 int threatLevel = alignment*entAlignment;
                 if ( threatLevel == -1 ) {    // Enemy alignment, attack or flee
                     interest = (healthFactor)*(attackInterest);
@@ -79,7 +80,7 @@ void ActorComponent::update(const double delta)
         }
         if ( interestingEntity != NULL ) {  // We want to go towards or away from something
             targetEntity = interestingEntity;
-            targetPosition = interestingEntity->GetAttributeDataPtr<glm::vec3>("position");
+            targetPosition = interestingEntity->GetAttributeData(ATTR_POSITION);
             if ( interestType == ENTITY_ITEM ) {
                 targetState = Target_Pickup;
             } else if ( interestType == ENTITY_HUMANOID || interestType == ENTITY_SKELETON ) {
@@ -105,8 +106,8 @@ void ActorComponent::update(const double delta)
         }
         float distance =  glm::length(targetDir);
         if ( distance > 0.0f ) targetDir = glm::normalize(targetDir);
-        bool& jumping = m_owner->GetAttributeDataPtr<bool>("jumping");
-        bool& running = m_owner->GetAttributeDataPtr<bool>("running");
+        bool& jumping = m_owner->GetAttributeData(ATTR_JUMPING);
+        bool& running = m_owner->GetAttributeData(ATTR_RUNNING);
         jumping = false;
         running = false;
         if ( distance > 2.0f ) { // Move towards or away from target
@@ -115,7 +116,7 @@ void ActorComponent::update(const double delta)
             else if ( targetState == Target_Flee ) { running = true; }
         } else { // Close enough to perform an action on target
             if ( targetState == Target_Pickup && targetEntity ) {
-                if ( targetEntity->GetAttributeDataPtr<int>("ownerID") != 0 ) 
+                if ( targetEntity->GetAttributeData(ATTR_OWNER_ID) != 0 ) 
                 {
                     targetEntity = NULL;
                     targetState = Target_Move;
@@ -141,7 +142,7 @@ void ActorComponent::update(const double delta)
             }
             targetDir *= 0.1f;
         }
-        m_owner->GetAttributeDataPtr<glm::vec3>("direction") = targetDir;
+        m_owner->GetAttributeData(ATTR_DIRECTION) = targetDir;
         lastMoveTime -= movementUpdateTime;
     }
 }
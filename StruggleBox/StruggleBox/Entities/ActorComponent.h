@@ -33,5 +33,6 @@ private:
 	int targetState;
 	glm::vec3 targetPosition;
 	Entity* targetEntity;
+	std::vector<Entity*> m_nearbyEntities;	// Reused by every brain update
 };
 #endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Entity.h"
+#include <cstdint>
+#include <vector>
+
+// Maps EntityIDs to pointers, stored as a sparse set.
+// The pointers are packed into one array so walking them is a linear scan,
+// a second array indexed by EntityID finds a pointer's slot in O(1).
+// Removing swaps the last pointer into the freed slot, so the order of
+// iteration is not the order of insertion.
+template<class T>
+class DenseEntityMap
+{
+public:
+	void set(const EntityID entityID, T* value)
+	{
+		if (entityID >= m_slots.size())
+		{
+			m_slots.resize(entityID + 1, INVALID_SLOT);
+		}
+		uint32_t& slot = m_slots[entityID];
+		if (slot != INVALID_SLOT)
+		{
+			m_values[slot] = value;
+			return;
+		}
+		slot = (uint32_t)m_values.size();
+		m_values.push_back(value);
+		m_ids.push_back(entityID);
+	}
+
+	// Returns the removed pointer, nullptr if there was none
+	T* remove(const EntityID entityID)
+	{
+		if (!contains(entityID))
+		{
+			return nullptr;
+		}
+		const uint32_t slot = m_slots[entityID];
+		T* value = m_values[slot];
+		const uint32_t lastSlot = (uint32_t)m_values.size() - 1;
+		if (slot != lastSlot)
+		{
+			m_values[slot] = m_values[lastSlot];
+			m_ids[slot] = m_ids[lastSlot];
+			m_slots[m_ids[slot]] = slot;
+		}
+		m_values.pop_back();
+		m_ids.pop_back();
+		m_slots[entityID] = INVALID_SLOT;
+		return value;
+	}
+
+	T* get(const EntityID entityID) const
+	{
+		return contains(entityID) ? m_values[m_slots[entityID]] : nullptr;
+	}
+
+	bool contains(const EntityID entityID) const
+	{
+		return entityID < m_slots.size() && m_slots[entityID] != INVALID_SLOT;
+	}
+
+	void clear()
+	{
+		m_values.clear();
+		m_ids.clear();
+		m_slots.clear();
+	}
+
+	size_t size() const { return m_values.size(); }
+	bool empty() const { return m_values.empty(); }
+
+	// Packed access, indices are only valid until the next add or remove
+	T* valueAt(const size_t index) const { return m_values[index]; }
+	EntityID idAt(const size_t index) const { return m_ids[index]; }
+
+	typename std::vector<T*>::const_iterator begin() const { return m_values.begin(); }
+	typename std::vector<T*>::const_iterator end() const { return m_values.end(); }
+
+private:
+	static const uint32_t INVALID_SLOT = 0xFFFFFFFF;
+
+	std::vector<T*> m_values;
+	std::vector<EntityID> m_ids;        // Owner of each packed pointer
+	std::vector<uint32_t> m_slots;      // Packed index by EntityID
+};
+
+template<class T>
+const uint32_t DenseEntityMap<T>::INVALID_SLOT;
@@ -0,0 +1,52 @@
+#include "EntityAttributes.h"
+
+const AttributeKey<int> ATTR_ALIGNMENT("alignment");
+const AttributeKey<int> ATTR_BACKPACK_ITEM_ID("backpackItemID");
+const AttributeKey<glm::vec3> ATTR_BB("bb");
+const AttributeKey<bool> ATTR_BLOCKING("blocking");
+const AttributeKey<int> ATTR_DAMAGE("damage");
+const AttributeKey<glm::vec3> ATTR_DIRECTION("direction");
+const AttributeKey<bool> ATTR_DONE("done");
+const AttributeKey<float> ATTR_EXPLOSION_FORCE("explosionForce");
+const AttributeKey<float> ATTR_EXPLOSION_RADIUS("explosionRadius");
+const AttributeKey<bool> ATTR_GENERATE_COLLISIONS("generateCollisions");
+const AttributeKey<glm::vec3> ATTR_GRIP_OFFSET("gripOffset");
+const AttributeKey<int> ATTR_HEAD_ID("headID");
+const AttributeKey<std::string> ATTR_HEAD_OBJECT("headObject");
+const AttributeKey<int> ATTR_HEALING("healing");
+const AttributeKey<int> ATTR_HEALTH("health");
+const AttributeKey<int> ATTR_ID("ID");
+const AttributeKey<float> ATTR_IMPLOSION_DURATION("implosionDuration");
+const AttributeKey<int> ATTR_INSTANCE_ID("instanceID");
+const AttributeKey<int> ATTR_ITEM_TYPE("itemType");
+const AttributeKey<bool> ATTR_JUMPING("jumping");
+const AttributeKey<int> ATTR_LEFT_ARM_ID("leftArmID");
+const AttributeKey<std::string> ATTR_LEFT_ARM_OBJECT("leftArmObject");
+const AttributeKey<int> ATTR_LEFT_FOOT_ID("leftFootID");
+const AttributeKey<std::string> ATTR_LEFT_FOOT_OBJECT("leftFootObject");
+const AttributeKey<int> ATTR_LEFT_HAND_ITEM_ID("leftHandItemID");
+const AttributeKey<float> ATTR_LIFE_TIME("lifeTime");
+const AttributeKey<glm::vec3> ATTR_LOOK_DIRECTION("lookDirection");
+const AttributeKey<int> ATTR_MAX_HEALTH("maxHealth");
+const AttributeKey<glm::vec3> ATTR_MOVE_INPUT("moveInput");
+const AttributeKey<std::string> ATTR_NAME("name");
+const AttributeKey<std::string> ATTR_OBJECT_FILE("objectFile");
+const AttributeKey<int> ATTR_OWNER_ID("ownerID");
+const AttributeKey<std::string> ATTR_PARTICLE_FILE("particleFile");
+const AttributeKey<glm::vec3> ATTR_PARTICLE_OFFSET("particleOffset");
+const AttributeKey<int> ATTR_PHYSICS("physics");
+const AttributeKey<glm::vec3> ATTR_POSITION("position");
+const AttributeKey<int> ATTR_RIGHT_ARM_ID("rightArmID");
+const AttributeKey<std::string> ATTR_RIGHT_ARM_OBJECT("rightArmObject");
+const AttributeKey<int> ATTR_RIGHT_FOOT_ID("rightFootID");
+const AttributeKey<std::string> ATTR_RIGHT_FOOT_OBJECT("rightFootObject");
+const AttributeKey<int> ATTR_RIGHT_HAND_ITEM_ID("rightHandItemID");
+const AttributeKey<glm::quat> ATTR_ROTATION("rotation");
+const AttributeKey<bool> ATTR_RUNNING("running");
+const AttributeKey<glm::vec3> ATTR_SCALE("scale");
+const AttributeKey<bool> ATTR_SNEAKING("sneaking");
+const AttributeKey<float> ATTR_SPHERE_RADIUS("sphereRadius");
+const AttributeKey<int> ATTR_TORSO_ID("torsoID");
+const AttributeKey<std::string> ATTR_TORSO_OBJECT("torsoObject");
+const AttributeKey<int> ATTR_TYPE("type");
+const AttributeKey<glm::vec3> ATTR_VELOCITY("velocity");
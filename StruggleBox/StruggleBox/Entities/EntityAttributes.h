@@ -0,0 +1,59 @@
+#pragma once
+
+#include "AttributeKey.h"
+#include "GFXDefines.h"
+#include <string>
+
+// Interned keys of the entity attributes used by the game.
+// Entity::GetAttributeData(key) indexes the attribute directly,
+// the string based GetAttributeDataPtr is left for loading and tools.
+extern const AttributeKey<int> ATTR_ALIGNMENT;
+extern const AttributeKey<int> ATTR_BACKPACK_ITEM_ID;
+extern const AttributeKey<glm::vec3> ATTR_BB;
+extern const AttributeKey<bool> ATTR_BLOCKING;
+extern const AttributeKey<int> ATTR_DAMAGE;
+extern const AttributeKey<glm::vec3> ATTR_DIRECTION;
+extern const AttributeKey<bool> ATTR_DONE;
+extern const AttributeKey<float> ATTR_EXPLOSION_FORCE;
+extern const AttributeKey<float> ATTR_EXPLOSION_RADIUS;
+extern const AttributeKey<bool> ATTR_GENERATE_COLLISIONS;
+extern const AttributeKey<glm::vec3> ATTR_GRIP_OFFSET;
+extern const AttributeKey<int> ATTR_HEAD_ID;
+extern const AttributeKey<std::string> ATTR_HEAD_OBJECT;
+extern const AttributeKey<int> ATTR_HEALING;
+extern const AttributeKey<int> ATTR_HEALTH;
+extern const AttributeKey<int> ATTR_ID;
+extern const AttributeKey<float> ATTR_IMPLOSION_DURATION;
+extern const AttributeKey<int> ATTR_INSTANCE_ID;
+extern const AttributeKey<int> ATTR_ITEM_TYPE;
+extern const AttributeKey<bool> ATTR_JUMPING;
+extern const AttributeKey<int> ATTR_LEFT_ARM_ID;
+extern const AttributeKey<std::string> ATTR_LEFT_ARM_OBJECT;
+extern const AttributeKey<int> ATTR_LEFT_FOOT_ID;
+extern const AttributeKey<std::string> ATTR_LEFT_FOOT_OBJECT;
+extern const AttributeKey<int> ATTR_LEFT_HAND_ITEM_ID;
+extern const AttributeKey<float> ATTR_LIFE_TIME;
+extern const AttributeKey<glm::vec3> ATTR_LOOK_DIRECTION;
+extern const AttributeKey<int> ATTR_MAX_HEALTH;
+extern const AttributeKey<glm::vec3> ATTR_MOVE_INPUT;
+extern const AttributeKey<std::string> ATTR_NAME;
+extern const AttributeKey<std::string> ATTR_OBJECT_FILE;
+extern const AttributeKey<int> ATTR_OWNER_ID;
+extern const AttributeKey<std::string> ATTR_PARTICLE_FILE;
+extern const AttributeKey<glm::vec3> ATTR_PARTICLE_OFFSET;
+extern const AttributeKey<int> ATTR_PHYSICS;
+extern const AttributeKey<glm::vec3> ATTR_POSITION;
+extern const AttributeKey<int> ATTR_RIGHT_ARM_ID;
+extern const AttributeKey<std::string> ATTR_RIGHT_ARM_OBJECT;
+extern const AttributeKey<int> ATTR_RIGHT_FOOT_ID;
+extern const AttributeKey<std::string> ATTR_RIGHT_FOOT_OBJECT;
+extern const AttributeKey<int> ATTR_RIGHT_HAND_ITEM_ID;
+extern const AttributeKey<glm::quat> ATTR_ROTATION;
+extern const AttributeKey<bool> ATTR_RUNNING;
+extern const AttributeKey<glm::vec3> ATTR_SCALE;
+extern const AttributeKey<bool> ATTR_SNEAKING;
+extern const AttributeKey<float> ATTR_SPHERE_RADIUS;
+extern const AttributeKey<int> ATTR_TORSO_ID;
+extern const AttributeKey<std::string> ATTR_TORSO_OBJECT;
+extern const AttributeKey<int> ATTR_TYPE;
+extern const AttributeKey<glm::vec3> ATTR_VELOCITY;
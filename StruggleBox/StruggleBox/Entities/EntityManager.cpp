@@ -7,6 +7,8 @@
 #include "Particles.h"
 
 #include "Entity.h"
+#include "EntityAttributes.h"
+#include "EntityPrefab.h"
 #include "ActorComponent.h"
 #include "VoxelComponent.h"
 #include "ExplosiveComponent.h"
@@ -21,7 +23,10 @@
 #include "SelfDestructComponent.h"
 
 #include "Dictionary.h"
+#include "JobSystem.h"
 #include "Log.h"
+#include "Profiler.h"
+#include <algorithm>
 
 const std::vector<std::string> EntityManager::ENTITY_COMPONENT_FAMILY_NAMES = {
     "Actor",
@@ -38,95 +43,137 @@ const std::vector<std::string> EntityManager::ENTITY_COMPONENT_FAMILY_NAMES = {
     "SelfDestruct",
 };
 
-EntityManager::EntityManager(Allocator& allocator, VoxelRenderer& renderer, VoxelCache& voxelFactory, Particles& particles, Physics& physics)
-    : m_allocator(allocator)
+// Data the component updates share, systems declare which of these they read and write.
+// Reading an attribute an entity doesn't have yet adds it, so attribute access counts as a write
+enum EntityResource : SystemResources {
+    Resource_Entities       = 1 << 0,   // Entity and component stores, erase queue
+    Resource_Attributes     = 1 << 1,
+    Resource_Physics        = 1 << 2,   // Bullet bodies and characters
+    Resource_VoxelInstances = 1 << 3,
+    Resource_Lights         = 1 << 4,
+    Resource_Particles      = 1 << 5,
+    Resource_Health         = 1 << 6,
+};
+
+const size_t COMPONENT_SYSTEM_GRAIN_SIZE = 64;  // Components updated by each job of a parallel family
+
+EntityManager::EntityManager(Allocator& allocator, JobSystem& jobSystem, VoxelRenderer& renderer, VoxelCache& voxelFactory, Particles& particles, Physics& physics)
+    : m_allocator(allocator, MemoryTag::Entities)
     , m_renderer(renderer)
     , m_voxelFactory(voxelFactory)
     , m_particles(particles)
     , m_physics(physics)
+    , m_scheduler(jobSystem)
+    , m_updateDelta(0.0)
+    , m_spatialGrid(ENTITY_GRID_CELL_SIZE)
 {
 	Log::Debug("[EntityManager] Constructor, instance at %p", this);
+    addComponentSystems();
 }
 
 EntityManager::~EntityManager()
 {
 	Log::Debug("[EntityManager] Destructor, instance at %p", this);
 
-    for (auto it : entityMap)
+    for (Entity* entity : entityMap)
     {
-        CUSTOM_DELETE(it.second,  m_allocator);
+        CUSTOM_DELETE(entity,  m_allocator);
     }
     entityMap.clear();
+    _lifeTimes.clear();
 }
 
-void EntityManager::update(const double delta)
+// Walks the packed components by index, so components added while updating are safe.
+// A store only ever holds exactly T, which lets the update call skip the virtual lookup
+template<class T>
+static void updateComponents(const DenseEntityMap<T>& components, const double delta)
 {
-    for (auto it : _physicsComponents) {
-		it.second->update( delta );
-    }
-    for (auto it : _actorComponents) {
-        it.second->update( delta );
-    }
-    for (auto it : _healthComponents) {
-        it.second->update( delta );
-    }
-    for (auto it : _humanoidComponents) {
-        it.second->update( delta );
-    }
-    for (auto it : _inventoryComponents) {
-        it.second->update( delta );
-    }
-    for (auto it : _light3DComponents) {
-        it.second->update( delta );
-    }
-    for (auto it : _particleComponents) {
-        it.second->update( delta );
-    }
-    for (auto it : _explosiveComponents) {
-        it.second->update( delta );
-    }
-    for (auto it : _cubeComponents) {
-        it.second->update( delta );
-    }
-
-    for (auto it : _selfDestructComponents)
+    for (size_t i = 0; i < components.size(); i++)
     {
-        it.second->update(delta);
+        components.valueAt(i)->T::update(delta);
     }
+}
+
+// Families whose components only touch their own entity, split across the workers
+template<class T>
+static void addParallelFamily(SystemScheduler& scheduler, const char* name, const SystemResources reads, const SystemResources writes,
+    const DenseEntityMap<T>& components, const double& delta)
+{
+    scheduler.addParallelSystem(name, reads, writes, COMPONENT_SYSTEM_GRAIN_SIZE,
+        [&components]() { return components.size(); },
+        [&components, &delta](const size_t index) { components.valueAt(index)->T::update(delta); });
+}
+
+// Families that reach into other entities or the entity stores, run on the updating thread
+template<class T>
+static void addSerialFamily(SystemScheduler& scheduler, const char* name, const SystemResources reads, const SystemResources writes,
+    const DenseEntityMap<T>& components, const double& delta)
+{
+    scheduler.addSystem(name, reads, writes, [&components, &delta]() { updateComponents(components, delta); });
+}
+
+void EntityManager::addComponentSystems()
+{
+    // Added in the order the families used to update in, conflicting families still do
+    addParallelFamily(m_scheduler, "Physics", Resource_Entities,
+        Resource_Attributes | Resource_Physics, _physicsComponents, m_updateDelta);
+    // Shares the nearby query buffers and the global random seed
+    addSerialFamily(m_scheduler, "Actor", Resource_Entities,
+        Resource_Attributes, _actorComponents, m_updateDelta);
+    addSerialFamily(m_scheduler, "Health", 0,
+        Resource_Entities | Resource_Attributes | Resource_Health, _healthComponents, m_updateDelta);
+    addSerialFamily(m_scheduler, "Humanoid", 0,
+        Resource_Entities | Resource_Attributes | Resource_Physics | Resource_VoxelInstances | Resource_Health, _humanoidComponents, m_updateDelta);
+    addParallelFamily(m_scheduler, "Inventory", Resource_Entities,
+        0, _inventoryComponents, m_updateDelta);
+    addParallelFamily(m_scheduler, "Light3D", Resource_Entities,
+        Resource_Attributes | Resource_Lights, _light3DComponents, m_updateDelta);
+    addParallelFamily(m_scheduler, "Particle", Resource_Entities,
+        Resource_Attributes | Resource_Particles, _particleComponents, m_updateDelta);
+    addSerialFamily(m_scheduler, "Explosive", 0,
+        Resource_Entities | Resource_Attributes | Resource_Physics | Resource_Particles, _explosiveComponents, m_updateDelta);
+    addParallelFamily(m_scheduler, "Cube", Resource_Entities,
+        Resource_Attributes | Resource_VoxelInstances, _cubeComponents, m_updateDelta);
+    addSerialFamily(m_scheduler, "SelfDestruct", 0,
+        Resource_Entities | Resource_Attributes, _selfDestructComponents, m_updateDelta);
+    Log::Debug("[EntityManager] %zu component systems in %zu stages", m_scheduler.getNumSystems(), m_scheduler.getNumStages());
+}
+
+void EntityManager::update(const double delta)
+{
+    PROFILE_SCOPE("EntityManager::update");
+    m_updateDelta = delta;
+    m_scheduler.run();
+
     while (!eraseQueue.empty())
     {
         const EntityID eraseID = eraseQueue.front();
-        if (entityMap.find(eraseID) != entityMap.end())
+        if (entityMap.contains(eraseID))
         {
             removeEntity(eraseID);
         }
         eraseQueue.pop();
     }
-    for (auto it : entityMap)
+    for (float* lifeTime : _lifeTimes)
     {
-        Entity* owner = it.second;
-        float& lifeTime = owner->GetAttributeDataPtr<float>("lifeTime");
-        lifeTime += delta;
+        *lifeTime += delta;
     }
+    refreshSpatialGrid();
 }
 
 void EntityManager::draw()
 {
-	for (auto pair : _light3DComponents)
+	for (Light3DComponent* light3DComponent : _light3DComponents)
 	{
-		 m_renderer.queueLight(pair.second->getLight());
+		 m_renderer.queueLight(light3DComponent->getLight());
 	}
-    for (auto it : _renderComponents)
-    {
-        it.second->update(0.0);
-    }
+    updateComponents(_renderComponents, 0.0);
 }
 
 EntityID EntityManager::addEntity(const std::string& name)
 {
     Entity* newEntity = CUSTOM_NEW(Entity, m_allocator)(name);
-    EntityID newID = newEntity->GetID();
-    entityMap[newID] = newEntity;
+    EntityID newID = registerEntity(newEntity);
 	//Log::Debug("[EntityManager] Added entity %i, name %s", newID, name.c_str());
     return newID;
 }
@@ -135,157 +182,94 @@ EntityID EntityManager::addEntity(const std::string& filePath, const std::string
 {
 	//Log::Debug("[EntityManager] Loading entity file %s from %s", fileName.c_str(), filePath.c_str());
 
-    //  Load dictionary from data
-    const std::string dictPath = std::string(filePath).append(fileName);
-    
-    Dictionary dict;
-    if (!dict.loadRootSubDictFromFile(dictPath.c_str())) 
+    const EntityPrefab* prefab = getPrefab(std::string(filePath).append(fileName));
+    if (!prefab)
     {
         return 0;
     }
-    
+
     // Load attributes first
-    dict.stepIntoSubDictWithKey("Attributes");
-    std::string name = dict.getStringForKey("sname");
+    std::string name = prefab->getName();
     if ( name.empty() ) name = "Unnamed: " + fileName;
     Entity* newEntity = CUSTOM_NEW(Entity, m_allocator)(name);
-    EntityID newID = newEntity->GetID();
-    entityMap[newID] = newEntity;
+    EntityID newID = registerEntity(newEntity);
 	//Log::Debug("[EntityManager] Loaded entity %i, name %s", newID, name.c_str());
+    prefab->applyAttributes(*newEntity);
 
-    for (unsigned int i = 0; i < dict.getNumKeys(); i++)
-    {
-        const std::string name = dict.getKey(i);
-        if ( name.compare(0, 1,"b") == 0 ) {
-            bool data = dict.getBoolForKey(name.c_str());
-            newEntity->GetAttributeDataPtr<bool>(name.substr(1)) = data;
-        } else if ( name.compare(0, 1,"i") == 0 ) {
-            int data = dict.getIntegerForKey(name.c_str());
-            newEntity->GetAttributeDataPtr<int>(name.substr(1)) = data;
-        } else if ( name.compare(0, 1,"u") == 0 ) {
-            int data = dict.getIntegerForKey(name.c_str());
-            newEntity->GetAttributeDataPtr<unsigned int>(name.substr(1)) = data;
-        } else if ( name.compare(0, 1,"f") == 0 ) {
-            float data = dict.getFloatForKey(name.c_str());
-            newEntity->GetAttributeDataPtr<float>(name.substr(1)) = data;
-        } else if ( name.compare(0, 1,"d") == 0 ) {
-            float data = dict.getFloatForKey(name.c_str());
-            newEntity->GetAttributeDataPtr<double>(name.substr(1)) = data;
-        } else if ( name.compare(0, 1,"s") == 0 ) {
-            std::string data = dict.getStringForKey(name.c_str());
-            newEntity->GetAttributeDataPtr<std::string>(name.substr(1)) = data;
-        } else if ( name.compare(0, 2,"v2") == 0 ) {
-            float data = dict.getFloatForKey(name.c_str());
-            std::string attrName = name.substr(2, name.length()-3);
-            glm::vec2& attr = newEntity->GetAttributeDataPtr<glm::vec2>(attrName);
-            if ( name.compare(name.length()-1, 1, "X") == 0 ) { attr.x = data; }
-            else if ( name.compare(name.length()-1, 1, "Y") == 0 ) { attr.y = data; }
-        } else if ( name.compare(0, 2,"v3") == 0 ) {
-            float data = dict.getFloatForKey(name.c_str());
-            std::string attrName = name.substr(2, name.length()-3);
-            glm::vec3& attr = newEntity->GetAttributeDataPtr<glm::vec3>(attrName);
-            if ( name.compare(name.length()-1, 1, "X") == 0 ) { attr.x = data; }
-            else if ( name.compare(name.length()-1, 1, "Y") == 0 ) { attr.y = data; }
-            else if ( name.compare(name.length()-1, 1, "Z") == 0 ) { attr.z = data; }
-        } else if ( name.compare(0, 2,"v4") == 0 ) {
-            float data = dict.getFloatForKey(name.c_str());
-            std::string attrName = name.substr(2, name.length()-3);
-            glm::vec4& attr = newEntity->GetAttributeDataPtr<glm::vec4>(attrName);
-            if ( name.compare(name.length()-1, 1, "X") == 0 ) { attr.x = data; }
-            else if ( name.compare(name.length()-1, 1, "Y") == 0 ) { attr.y = data; }
-            else if ( name.compare(name.length()-1, 1, "Z") == 0 ) { attr.z = data; }
-            else if ( name.compare(name.length()-1, 1, "W") == 0 ) { attr.w = data; }
-        } else if ( name.compare(0, 2,"q4") == 0 ) {
-            float data = dict.getFloatForKey(name.c_str());
-            std::string attrName = name.substr(2, name.length()-3);
-            glm::quat& attr = newEntity->GetAttributeDataPtr<glm::quat>(attrName);
-            if ( name.compare(name.length()-1, 1, "X") == 0 ) { attr.x = data; }
-            else if ( name.compare(name.length()-1, 1, "Y") == 0 ) { attr.y = data; }
-            else if ( name.compare(name.length()-1, 1, "Z") == 0 ) { attr.z = data; }
-            else if ( name.compare(name.length()-1, 1, "W") == 0 ) { attr.w = data; }
-        } else {
-            Log::Error("[Entity] Error loading attribute %s, unknown type", name.c_str());
-        }
-    }
-    dict.stepBackToRootSubDict();
     // Load components
-    dict.stepIntoSubDictWithKey("Components");
-    for (unsigned int i = 0; i < dict.getNumKeys(); i++)
+    for (const PrefabComponent& component : prefab->getComponents())
     {
-        std::string name = dict.getKey(i);
-        addComponent(newID, name);
-        if ( name == "Light3D" )
+        addComponent(newID, component.family);
+        if (component.family == "Light3D" && component.hasOffset)
         {
-            Light3DComponent* light3DComponent = _light3DComponents.at(newID);
-
-            if (dict.stepIntoSubDictWithKey("Light3D"))
+            Light3DComponent* light3DComponent = _light3DComponents.get(newID);
+            if (light3DComponent)
             {
-                for (unsigned int j = 0; j < dict.getNumKeys(); j++)
-                {
-                    const std::string subName = dict.getKey(j);
-                    if (subName == "v3offsetX")
-                    {
-                        light3DComponent->offset.x = dict.getFloatForKey(subName.c_str());;
-                    }
-                    else if (subName == "v3offsetY")
-                    {
-                        light3DComponent->offset.y = dict.getFloatForKey(subName.c_str());
-                    }
-                    else if (subName == "v3offsetZ")
-                    {
-                        light3DComponent->offset.z = dict.getFloatForKey(subName.c_str());
-                    }
-                }
-                dict.stepOutOfSubDict();
+                light3DComponent->offset = component.offset;
             }
         }
     }
     return newID;
 }
 
+const EntityPrefab* EntityManager::getPrefab(const std::string& filePath)
+{
+    auto it = m_prefabs.find(filePath);
+    if (it != m_prefabs.end())
+    {
+        return &it->second;
+    }
+    EntityPrefab prefab;
+    if (!prefab.load(filePath))
+    {
+        return nullptr;
+    }
+    return &m_prefabs.emplace(filePath, std::move(prefab)).first->second;
+}
+
 void EntityManager::saveEntity( Entity* entity, const std::string& filePath, const std::string& fileName ) 
 {
     if ( entity == NULL ) return;
-    EntityID entityID = entity->GetAttributeDataPtr<int>("ID");
+    EntityID entityID = entity->GetAttributeData(ATTR_ID);
     //  Create new dictionary for data
     Dictionary dict;
     //  Save Component types
     dict.setSubDictForKey("Components");
     dict.stepIntoSubDictWithKey("Components");
-    if ( _actorComponents.find(entityID) != _actorComponents.end() ) {
+    if ( _actorComponents.contains(entityID) ) {
         dict.setStringForKey("Actor", "Actor");
     }
-    if ( _cubeComponents.find(entityID) != _cubeComponents.end() ) {
+    if ( _cubeComponents.contains(entityID) ) {
         dict.setStringForKey("Cube", "Cube");
     }
-    if ( _explosiveComponents.find(entityID) != _explosiveComponents.end() ) {
+    if ( _explosiveComponents.contains(entityID) ) {
         dict.setStringForKey("Explosive", "Explosive");
     }
-    if ( _healthComponents.find(entityID) != _healthComponents.end() ) {
+    if ( _healthComponents.contains(entityID) ) {
         dict.setStringForKey("Health", "Health");
     }
-    if ( _humanoidComponents.find(entityID) != _humanoidComponents.end() ) {
+    if ( _humanoidComponents.contains(entityID) ) {
         dict.setStringForKey("Humanoid", "Humanoid");
     }
-    if ( _inventoryComponents.find(entityID) != _inventoryComponents.end() ) {
+    if ( _inventoryComponents.contains(entityID) ) {
         dict.setStringForKey("Inventory", "Inventory");
     }
-    if ( _itemComponents.find(entityID) != _itemComponents.end() ) {
+    if ( _itemComponents.contains(entityID) ) {
         dict.setStringForKey("Item", "Item");
     }
-    if ( _light3DComponents.find(entityID) != _light3DComponents.end() ) {
+    if ( _light3DComponents.contains(entityID) ) {
         dict.setStringForKey("Light3D", "Light3D");
     }
-    if ( _particleComponents.find(entityID) != _particleComponents.end() ) {
+    if ( _particleComponents.contains(entityID) ) {
         dict.setStringForKey("Particle", "Particle");
     }
-    if ( _physicsComponents.find(entityID) != _physicsComponents.end() ) {
+    if ( _physicsComponents.contains(entityID) ) {
         dict.setStringForKey("Physics", "Physics");
     }
-    if (_selfDestructComponents.find(entityID) != _selfDestructComponents.end()) {
+    if (_selfDestructComponents.contains(entityID)) {
         dict.setStringForKey("SelfDestruct", "SelfDestruct");
     }
-    if (_selfDestructComponents.find(entityID) != _selfDestructComponents.end()) {
+    if (_selfDestructComponents.contains(entityID)) {
         dict.setStringForKey("Render", "Render");
     }
     dict.stepOutOfSubDict();
@@ -344,34 +328,36 @@ void EntityManager::saveEntity( Entity* entity, const std::string& filePath, con
     // Save file to disk
     std::string dictPath = std::string(filePath).append(fileName);
     dict.saveRootSubDictToFile(dictPath.c_str());
+    // Spawn the saved version from now on
+    m_prefabs.erase(dictPath);
 }
 void EntityManager::setComponent( const EntityID entityID, EntityComponent *component ) {
     const std::string family = component->getFamily();
     if ( family == "Actor" ) {
-        _actorComponents[entityID] = (ActorComponent*)component;
+        _actorComponents.set(entityID, (ActorComponent*)component);
     } else if ( family == "Cube" ) {
-        _cubeComponents[entityID] = (VoxelComponent*)component;
+        _cubeComponents.set(entityID, (VoxelComponent*)component);
     } else if ( family == "Explosive" ) {
-        _explosiveComponents[entityID] = (ExplosiveComponent*)component;
+        _explosiveComponents.set(entityID, (ExplosiveComponent*)component);
     } else if ( family == "Health" ) {
-        _healthComponents[entityID] = (HealthComponent*)component;
+        _healthComponents.set(entityID, (HealthComponent*)component);
     } else if ( family == "Humanoid" ) {
-        _humanoidComponents[entityID] = (HumanoidComponent*)component;
+        _humanoidComponents.set(entityID, (HumanoidComponent*)component);
     } else if ( family == "Inventory" ) {
-        _inventoryComponents[entityID] = (InventoryComponent*)component;
+        _inventoryComponents.set(entityID, (InventoryComponent*)component);
     } else if ( family == "Item" ) {
-        _itemComponents[entityID] = (ItemComponent*)component;
+        _itemComponents.set(entityID, (ItemComponent*)component);
     } else if ( family == "Light3D" ) {
-        _light3DComponents[entityID] = (Light3DComponent*)component;
+        _light3DComponents.set(entityID, (Light3DComponent*)component);
     } else if ( family == "Particle" ) {
-        if (_particleComponents.find(entityID) != _particleComponents.end()) Log::Debug("[EntityManager::setComponent] ADDING MULTIPLE PARTICLE SYSTEMS");
-        _particleComponents[entityID] = (ParticleComponent*)component;
+        if (_particleComponents.contains(entityID)) Log::Debug("[EntityManager::setComponent] ADDING MULTIPLE PARTICLE SYSTEMS");
+        _particleComponents.set(entityID, (ParticleComponent*)component);
     } else if ( family == "Physics" ) {
-        _physicsComponents[entityID] = (PhysicsComponent*)component;
+        _physicsComponents.set(entityID, (PhysicsComponent*)component);
     } else if (family == "SelfDestruct") {
-        _selfDestructComponents[entityID] = (SelfDestructComponent*)component;
+        _selfDestructComponents.set(entityID, (SelfDestructComponent*)component);
     } else if (family == "Render") {
-        _renderComponents[entityID] = (RenderComponent*)component;
+        _renderComponents.set(entityID, (RenderComponent*)component);
     } else {
         Log::Error("[EntityManager] ERROR: Setting unknown component type %s", family.c_str());
     }
@@ -379,30 +365,30 @@ void EntityManager::setComponent( const EntityID entityID, EntityComponent *comp
 EntityComponent* EntityManager::getComponent(const EntityID entityID,
                                              const std::string& componentFamily)
 {
-    if ( componentFamily == "Actor" && _actorComponents.find(entityID) != _actorComponents.end() ) {
-        return _actorComponents[entityID];
-    } else if ( componentFamily == "Cube" && _cubeComponents.find(entityID) != _cubeComponents.end() ) {
-        return _cubeComponents[entityID];
-    } else if ( componentFamily == "Explosive" && _explosiveComponents.find(entityID) != _explosiveComponents.end() ) {
-        return _explosiveComponents[entityID];
-    } else if ( componentFamily == "Health" && _healthComponents.find(entityID) != _healthComponents.end() ) {
-        return _healthComponents[entityID];
-    } else if ( componentFamily == "Humanoid" && _humanoidComponents.find(entityID) != _humanoidComponents.end() ) {
-        return _humanoidComponents[entityID];
-    } else if ( componentFamily == "Inventory" && _inventoryComponents.find(entityID) != _inventoryComponents.end() ) {
-        return _inventoryComponents[entityID];
-    } else if ( componentFamily == "Item" && _itemComponents.find(entityID) != _itemComponents.end() ) {
-        return _itemComponents[entityID];
-    } else if ( componentFamily == "Light3D" && _light3DComponents.find(entityID) != _light3DComponents.end() ) {
-        return _light3DComponents[entityID];
-    } else if ( componentFamily == "Particle" && _particleComponents.find(entityID) != _particleComponents.end() ) {
-        return _particleComponents[entityID];
-    } else if ( componentFamily == "Physics" && _physicsComponents.find(entityID) != _physicsComponents.end() ) {
-        return _physicsComponents[entityID];
-    } else if (componentFamily == "SelfDestruct" && _selfDestructComponents.find(entityID) != _selfDestructComponents.end()) {
-        return _selfDestructComponents[entityID];
-    } else if (componentFamily == "Render" && _renderComponents.find(entityID) != _renderComponents.end()) {
-        return _renderComponents[entityID];
+    if ( componentFamily == "Actor" && _actorComponents.contains(entityID) ) {
+        return _actorComponents.get(entityID);
+    } else if ( componentFamily == "Cube" && _cubeComponents.contains(entityID) ) {
+        return _cubeComponents.get(entityID);
+    } else if ( componentFamily == "Explosive" && _explosiveComponents.contains(entityID) ) {
+        return _explosiveComponents.get(entityID);
+    } else if ( componentFamily == "Health" && _healthComponents.contains(entityID) ) {
+        return _healthComponents.get(entityID);
+    } else if ( componentFamily == "Humanoid" && _humanoidComponents.contains(entityID) ) {
+        return _humanoidComponents.get(entityID);
+    } else if ( componentFamily == "Inventory" && _inventoryComponents.contains(entityID) ) {
+        return _inventoryComponents.get(entityID);
+    } else if ( componentFamily == "Item" && _itemComponents.contains(entityID) ) {
+        return _itemComponents.get(entityID);
+    } else if ( componentFamily == "Light3D" && _light3DComponents.contains(entityID) ) {
+        return _light3DComponents.get(entityID);
+    } else if ( componentFamily == "Particle" && _particleComponents.contains(entityID) ) {
+        return _particleComponents.get(entityID);
+    } else if ( componentFamily == "Physics" && _physicsComponents.contains(entityID) ) {
+        return _physicsComponents.get(entityID);
+    } else if (componentFamily == "SelfDestruct" && _selfDestructComponents.contains(entityID)) {
+        return _selfDestructComponents.get(entityID);
+    } else if (componentFamily == "Render" && _renderComponents.contains(entityID)) {
+        return _renderComponents.get(entityID);
     } else {
         Log::Error("[EntityManager] ERROR: Getting unknown component type %s for %i", componentFamily.c_str(), entityID);
     }
@@ -416,7 +402,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
         ActorComponent* actorComponent = CUSTOM_NEW(ActorComponent, m_allocator)(
             entityID,
             *this);
-        _actorComponents[entityID] = actorComponent;
+        _actorComponents.set(entityID, actorComponent);
         return actorComponent;
     }
     else if (componentFamily == "Cube") 
@@ -426,7 +412,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
             "",
             *this,
             m_voxelFactory);
-        _cubeComponents[entityID] = cubeComponent;
+        _cubeComponents.set(entityID, cubeComponent);
         return cubeComponent;
     }
     else if (componentFamily == "Explosive") 
@@ -435,7 +421,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
             entityID,
             *this,
             m_particles);
-        _explosiveComponents[entityID] = explosiveComponent;
+        _explosiveComponents.set(entityID, explosiveComponent);
         return explosiveComponent;
     }
     else if (componentFamily == "Health")
@@ -443,7 +429,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
         HealthComponent* healthComponent = CUSTOM_NEW(HealthComponent, m_allocator)(
             entityID,
             *this);
-        _healthComponents[entityID] = healthComponent;
+        _healthComponents.set(entityID, healthComponent);
         return healthComponent;
     }
     else if (componentFamily == "Humanoid") 
@@ -453,7 +439,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
             *this,
             m_physics,
             m_voxelFactory);
-        _humanoidComponents[entityID] = humanoidComponent;
+        _humanoidComponents.set(entityID, humanoidComponent);
         return humanoidComponent;
     }
     else if (componentFamily == "Inventory") 
@@ -461,7 +447,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
         InventoryComponent* inventoryComponent = CUSTOM_NEW(InventoryComponent, m_allocator)(
             entityID,
             *this);
-        _inventoryComponents[entityID] = inventoryComponent;
+        _inventoryComponents.set(entityID, inventoryComponent);
         return inventoryComponent;
     }
     else if (componentFamily == "Item")
@@ -470,7 +456,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
             entityID,
             *this,
             m_particles);
-        _itemComponents[entityID] = itemComponent;
+        _itemComponents.set(entityID, itemComponent);
         return itemComponent;
     }
     else if (componentFamily == "Light3D")
@@ -478,7 +464,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
         Light3DComponent* light3DComponent = CUSTOM_NEW(Light3DComponent, m_allocator)(
             entityID,
             *this);
-        _light3DComponents[entityID] = light3DComponent;
+        _light3DComponents.set(entityID, light3DComponent);
         return light3DComponent;
     }
     else if (componentFamily == "Particle")
@@ -488,7 +474,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
             "",
             *this,
             m_particles);
-        _particleComponents[entityID] = particleComponent;
+        _particleComponents.set(entityID, particleComponent);
         return particleComponent;
     }
     else if (componentFamily == "Physics")
@@ -498,7 +484,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
             *this,
             m_physics,
             m_voxelFactory);
-        _physicsComponents[entityID] = physicsComponent;
+        _physicsComponents.set(entityID, physicsComponent);
         return physicsComponent;
     }
     else if (componentFamily == "SelfDestruct")
@@ -506,7 +492,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
         SelfDestructComponent* selfDestructComponent = CUSTOM_NEW(SelfDestructComponent, m_allocator)(
             entityID,
             *this);
-        _selfDestructComponents[entityID] = selfDestructComponent;
+        _selfDestructComponents.set(entityID, selfDestructComponent);
         return selfDestructComponent;
     }
     else if (componentFamily == "Render")
@@ -515,7 +501,7 @@ EntityComponent* EntityManager::addComponent(const EntityID entityID, const std:
             entityID,
             *this,
             m_renderer);
-        _renderComponents[entityID] = renderComponent;
+        _renderComponents.set(entityID, renderComponent);
         return renderComponent;
     }
     else
@@ -529,30 +515,30 @@ void EntityManager::removeComponent(const EntityID entityID,
                                     EntityComponent* component)
 {
     const std::string componentFamily = component->getFamily();
-    if ( componentFamily == "Actor" && _actorComponents.find(entityID) != _actorComponents.end() ) {
-        _actorComponents.erase(entityID);
-    } else if ( componentFamily == "Cube" && _cubeComponents.find(entityID) != _cubeComponents.end() ) {
-        _cubeComponents.erase(entityID);
-    } else if ( componentFamily == "Explosive" && _explosiveComponents.find(entityID) != _explosiveComponents.end() ) {
-        _explosiveComponents.erase(entityID);
-    } else if ( componentFamily == "Health" && _healthComponents.find(entityID) != _healthComponents.end() ) {
-        _healthComponents.erase(entityID);
-    } else if ( componentFamily == "Humanoid" && _humanoidComponents.find(entityID) != _humanoidComponents.end() ) {
-        _humanoidComponents.erase(entityID);
-    } else if ( componentFamily == "Inventory" && _inventoryComponents.find(entityID) != _inventoryComponents.end() ) {
-        _inventoryComponents.erase(entityID);
-    } else if ( componentFamily == "Item" && _itemComponents.find(entityID) != _itemComponents.end() ) {
-        _itemComponents.erase(entityID);
-    } else if ( componentFamily == "Light3D" && _light3DComponents.find(entityID) != _light3DComponents.end() ) {
-        _light3DComponents.erase(entityID);
-    } else if ( componentFamily == "Particle" && _particleComponents.find(entityID) != _particleComponents.end() ) {
-        _particleComponents.erase(entityID);
-    } else if ( componentFamily == "Physics" && _physicsComponents.find(entityID) != _physicsComponents.end() ) {
-        _physicsComponents.erase(entityID);
-    } else if (componentFamily == "SelfDestruct" && _selfDestructComponents.find(entityID) != _selfDestructComponents.end()) {
-        _selfDestructComponents.erase(entityID);
-    } else if (componentFamily == "Render" && _renderComponents.find(entityID) != _renderComponents.end()) {
-        _renderComponents.erase(entityID);
+    if ( componentFamily == "Actor" && _actorComponents.contains(entityID) ) {
+        _actorComponents.remove(entityID);
+    } else if ( componentFamily == "Cube" && _cubeComponents.contains(entityID) ) {
+        _cubeComponents.remove(entityID);
+    } else if ( componentFamily == "Explosive" && _explosiveComponents.contains(entityID) ) {
+        _explosiveComponents.remove(entityID);
+    } else if ( componentFamily == "Health" && _healthComponents.contains(entityID) ) {
+        _healthComponents.remove(entityID);
+    } else if ( componentFamily == "Humanoid" && _humanoidComponents.contains(entityID) ) {
+        _humanoidComponents.remove(entityID);
+    } else if ( componentFamily == "Inventory" && _inventoryComponents.contains(entityID) ) {
+        _inventoryComponents.remove(entityID);
+    } else if ( componentFamily == "Item" && _itemComponents.contains(entityID) ) {
+        _itemComponents.remove(entityID);
+    } else if ( componentFamily == "Light3D" && _light3DComponents.contains(entityID) ) {
+        _light3DComponents.remove(entityID);
+    } else if ( componentFamily == "Particle" && _particleComponents.contains(entityID) ) {
+        _particleComponents.remove(entityID);
+    } else if ( componentFamily == "Physics" && _physicsComponents.contains(entityID) ) {
+        _physicsComponents.remove(entityID);
+    } else if (componentFamily == "SelfDestruct" && _selfDestructComponents.contains(entityID)) {
+        _selfDestructComponents.remove(entityID);
+    } else if (componentFamily == "Render" && _renderComponents.contains(entityID)) {
+        _renderComponents.remove(entityID);
     } else {
         Log::Error("[EntityManager] ERROR: Erasing unknown component type %s for %i", componentFamily.c_str(), entityID);
     }
@@ -561,122 +547,122 @@ void EntityManager::removeComponent(const EntityID entityID,
 std::vector<EntityComponent*> EntityManager::getAllComponents(const EntityID entityID)
 {
     std::vector<EntityComponent*> components;
-    if (_actorComponents.find(entityID) != _actorComponents.end())
+    if (_actorComponents.contains(entityID))
     {
-        components.push_back(_actorComponents.at(entityID));
+        components.push_back(_actorComponents.get(entityID));
     }
-    if (_cubeComponents.find(entityID) != _cubeComponents.end())
+    if (_cubeComponents.contains(entityID))
     {
-        components.push_back(_cubeComponents.at(entityID));
+        components.push_back(_cubeComponents.get(entityID));
     }
-    if (_explosiveComponents.find(entityID) != _explosiveComponents.end())
+    if (_explosiveComponents.contains(entityID))
     {
-        components.push_back(_explosiveComponents.at(entityID));
+        components.push_back(_explosiveComponents.get(entityID));
     }
-    if (_healthComponents.find(entityID) != _healthComponents.end())
+    if (_healthComponents.contains(entityID))
     {
-        components.push_back(_healthComponents.at(entityID));
+        components.push_back(_healthComponents.get(entityID));
     }
-    if (_humanoidComponents.find(entityID) != _humanoidComponents.end())
+    if (_humanoidComponents.contains(entityID))
     {
-        components.push_back(_humanoidComponents.at(entityID));
+        components.push_back(_humanoidComponents.get(entityID));
     }
-    if (_inventoryComponents.find(entityID) != _inventoryComponents.end())
+    if (_inventoryComponents.contains(entityID))
     {
-        components.push_back(_inventoryComponents.at(entityID));
+        components.push_back(_inventoryComponents.get(entityID));
     }
-    if (_itemComponents.find(entityID) != _itemComponents.end())
+    if (_itemComponents.contains(entityID))
     {
-        components.push_back(_itemComponents.at(entityID));
+        components.push_back(_itemComponents.get(entityID));
     }
-    if (_light3DComponents.find(entityID) != _light3DComponents.end())
+    if (_light3DComponents.contains(entityID))
     {
-        components.push_back(_light3DComponents.at(entityID));
+        components.push_back(_light3DComponents.get(entityID));
     }
-    if (_particleComponents.find(entityID) != _particleComponents.end())
+    if (_particleComponents.contains(entityID))
     {
-        components.push_back(_particleComponents.at(entityID));
+        components.push_back(_particleComponents.get(entityID));
     }
-    if (_physicsComponents.find(entityID) != _physicsComponents.end())
+    if (_physicsComponents.contains(entityID))
     {
-        components.push_back(_physicsComponents.at(entityID));
+        components.push_back(_physicsComponents.get(entityID));
     }
-    if (_selfDestructComponents.find(entityID) != _selfDestructComponents.end())
+    if (_selfDestructComponents.contains(entityID))
     {
-        components.push_back(_selfDestructComponents.at(entityID));
+        components.push_back(_selfDestructComponents.get(entityID));
     }
-    if (_renderComponents.find(entityID) != _renderComponents.end())
+    if (_renderComponents.contains(entityID))
     {
-        components.push_back(_renderComponents.at(entityID));
+        components.push_back(_renderComponents.get(entityID));
     }
     return components;
 }
 
 void EntityManager::removeEntity(const EntityID entityID)
 {
-    std::map<EntityID, Entity*>::iterator it = entityMap.find(entityID);
-    if (it == entityMap.end())
+    Entity* entity = entityMap.remove(entityID);
+    if (!entity)
     {
         Log::Error("[EntityManager] tried to remove non-existant entity %i", entityID);
         return;
     }
+    _lifeTimes.remove(entityID);
+    m_spatialGrid.remove(entityID);
 
     // Clear out components first
-    if (_actorComponents.find(entityID) != _actorComponents.end()) {
-        CUSTOM_DELETE(_actorComponents[entityID], m_allocator);
-        _actorComponents.erase(entityID);
+    if (HumanoidComponent* humanoid = _humanoidComponents.get(entityID)) {
+        humanoid->Die();
     }
-    if (_cubeComponents.find(entityID) != _cubeComponents.end()) {
-        CUSTOM_DELETE(_cubeComponents[entityID], m_allocator);
-        _cubeComponents.erase(entityID);
+    if (EntityComponent* component = _actorComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_explosiveComponents.find(entityID) != _explosiveComponents.end()) {
-        CUSTOM_DELETE(_explosiveComponents[entityID], m_allocator);
-        _explosiveComponents.erase(entityID);
+    if (EntityComponent* component = _cubeComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_healthComponents.find(entityID) != _healthComponents.end()) {
-        CUSTOM_DELETE(_healthComponents[entityID], m_allocator);
-        _healthComponents.erase(entityID);
+    if (EntityComponent* component = _explosiveComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_humanoidComponents.find(entityID) != _humanoidComponents.end()) {
-        _humanoidComponents[entityID]->Die();
-        CUSTOM_DELETE(_humanoidComponents[entityID], m_allocator);
-        _humanoidComponents.erase(entityID);
+    if (EntityComponent* component = _healthComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_inventoryComponents.find(entityID) != _inventoryComponents.end()) {
-        CUSTOM_DELETE(_inventoryComponents[entityID], m_allocator);
-        _inventoryComponents.erase(entityID);
+    if (EntityComponent* component = _humanoidComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_itemComponents.find(entityID) != _itemComponents.end()) {
-        CUSTOM_DELETE(_itemComponents[entityID], m_allocator);
-        _itemComponents.erase(entityID);
+    if (EntityComponent* component = _inventoryComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_light3DComponents.find(entityID) != _light3DComponents.end()) {
-        CUSTOM_DELETE(_light3DComponents[entityID], m_allocator);
-        _light3DComponents.erase(entityID);
+    if (EntityComponent* component = _itemComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_particleComponents.find(entityID) != _particleComponents.end()) {
-        CUSTOM_DELETE(_particleComponents[entityID], m_allocator);
-        _particleComponents.erase(entityID);
+    if (EntityComponent* component = _light3DComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_physicsComponents.find(entityID) != _physicsComponents.end()) {
-        CUSTOM_DELETE(_physicsComponents[entityID], m_allocator);
-        _physicsComponents.erase(entityID);
+    if (EntityComponent* component = _particleComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_selfDestructComponents.find(entityID) != _selfDestructComponents.end()) {
-        CUSTOM_DELETE(_selfDestructComponents[entityID], m_allocator);
-        _selfDestructComponents.erase(entityID);
+    if (EntityComponent* component = _physicsComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    if (_renderComponents.find(entityID) != _renderComponents.end()) {
-        CUSTOM_DELETE(_renderComponents[entityID], m_allocator);
-        _renderComponents.erase(entityID);
+    if (EntityComponent* component = _selfDestructComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
     }
-    CUSTOM_DELETE(it->second, m_allocator);
-    entityMap.erase(it);
+    if (EntityComponent* component = _renderComponents.remove(entityID)) {
+        CUSTOM_DELETE(component, m_allocator);
+    }
+    CUSTOM_DELETE(entity, m_allocator);
 
     //Log::Debug("[EntityManager] Removed entity %i", entityID);
 }
 
+EntityID EntityManager::registerEntity(Entity* entity)
+{
+    const EntityID entityID = entity->GetID();
+    entityMap.set(entityID, entity);
+    // Attributes are never removed while the entity lives, so the lifeTime data stays put
+    _lifeTimes.set(entityID, &entity->GetAttributeData(ATTR_LIFE_TIME));
+    return entityID;
+}
+
 void EntityManager::destroyEntity(const EntityID entityID)
 {
     eraseQueue.push(entityID);
@@ -684,12 +670,7 @@ void EntityManager::destroyEntity(const EntityID entityID)
 
 Entity* EntityManager::getEntity(const EntityID entityID)
 {
-    std::map<EntityID, Entity*>::iterator it;
-    it = entityMap.find(entityID);
-    if ( it != entityMap.end() ) {
-        return it->second;
-    }
-    return NULL;
+    return entityMap.get(entityID);
 }
 
 Entity* EntityManager::getNearestEntity(const glm::vec3 position,
@@ -697,49 +678,96 @@ Entity* EntityManager::getNearestEntity(const glm::vec3 position,
                                         const EntityType filterType,
                                         const float radius)
 {
-    float nearestDist = radius;
+    queryNearby(position, ignoreID, filterType, radius);
     Entity* nearestEnt = NULL;
-    std::map<EntityID, Entity*>::iterator it;
-    for (it=entityMap.begin(); it != entityMap.end(); it++) {
-        Entity* ent = it->second;
-        if (ignoreID != ENTITY_NONE &&
-            (ent->GetID() == ignoreID ||
-            ent->GetAttributeDataPtr<int>("ownerID") == ignoreID)) continue;
-        if (filterType != ENTITY_NONE &&
-            ent->GetAttributeDataPtr<int>("type") != filterType) continue;
-        if (ent->HasAttribute("position")) {
-            glm::vec3 entPos = ent->GetAttributeDataPtr<glm::vec3>("position");
-            float dist = glm::distance(position, entPos);
-            if (dist <= nearestDist) {
-                nearestDist = dist;
-                nearestEnt = ent;
-            }
+    float nearestDist2 = radius * radius;
+    for (const auto& hit : m_gridQueryHits) {
+        if (hit.first <= nearestDist2) {
+            nearestDist2 = hit.first;
+            nearestEnt = hit.second;
         }
     }
     return nearestEnt;
 }
 
-std::map<EntityID, Entity*> EntityManager::getNearbyEntities(const glm::vec3 position,
-                                                        const EntityID ignoreID,
-                                                        const EntityType filterType,
-                                                        const float radius)
+size_t EntityManager::getNearbyEntities(const glm::vec3 position,
+                                        std::vector<Entity*>& result,
+                                        const EntityID ignoreID,
+                                        const EntityType filterType,
+                                        const float radius)
+{
+    queryNearby(position, ignoreID, filterType, radius);
+    for (const auto& hit : m_gridQueryHits) {
+        result.push_back(hit.second);
+    }
+    return m_gridQueryHits.size();
+}
+
+size_t EntityManager::getNearestEntities(const glm::vec3 position,
+                                         const size_t count,
+                                         std::vector<Entity*>& result,
+                                         const EntityID ignoreID,
+                                         const EntityType filterType,
+                                         const float radius)
+{
+    queryNearby(position, ignoreID, filterType, radius);
+    const size_t numResults = std::min(count, m_gridQueryHits.size());
+    std::partial_sort(m_gridQueryHits.begin(), m_gridQueryHits.begin() + numResults, m_gridQueryHits.end(),
+        [](const std::pair<float, Entity*>& a, const std::pair<float, Entity*>& b) { return a.first < b.first; });
+    for (size_t i = 0; i < numResults; i++) {
+        result.push_back(m_gridQueryHits[i].second);
+    }
+    return numResults;
+}
+
+void EntityManager::refreshSpatialGrid()
 {
-    std::map<EntityID, Entity*> nearbyEnts;
-    std::map<EntityID, Entity*>::iterator it;
-    for (it=entityMap.begin(); it != entityMap.end(); it++) {
-        Entity* ent = it->second;
+    for (size_t i = 0; i < entityMap.size(); i++) {
+        Entity* ent = entityMap.valueAt(i);
+        if (ent->HasAttribute(ATTR_POSITION)) {
+            m_spatialGrid.update(entityMap.idAt(i), ent->GetAttributeData(ATTR_POSITION));
+        } else {
+            m_spatialGrid.remove(entityMap.idAt(i));
+        }
+    }
+}
+
+// Collects the matching entities within radius into m_gridQueryHits with their squared distance.
+// The grid is as of the last update, the distance is checked against the current position
+void EntityManager::queryNearby(const glm::vec3& position,
+                                const EntityID ignoreID,
+                                const EntityType filterType,
+                                const float radius)
+{
+    m_gridQueryIDs.clear();
+    m_gridQueryHits.clear();
+    m_spatialGrid.query(position, radius, m_gridQueryIDs);
+    const float radius2 = radius * radius;
+    for (const EntityID entityID : m_gridQueryIDs) {
+        Entity* ent = entityMap.get(entityID);
+        if (!ent) continue;
         if (ignoreID != ENTITY_NONE &&
-            (ent->GetID() == ignoreID ||
-             ent->GetAttributeDataPtr<int>("ownerID") == ignoreID)) continue;
+            (entityID == ignoreID ||
+             ent->GetAttributeData(ATTR_OWNER_ID) == ignoreID)) continue;
         if (filterType != ENTITY_NONE &&
-            ent->GetAttributeDataPtr<int>("type") != filterType) continue;
-        if ( ent->HasAttribute("position") ) {
-            glm::vec3 entPos = ent->GetAttributeDataPtr<glm::vec3>("position");
-            float dist = glm::distance(position, entPos);
-            if ( dist <= radius ) {
-                nearbyEnts[it->first] = ent;
-            }
+            ent->GetAttributeData(ATTR_TYPE) != filterType) continue;
+        const glm::vec3 offset = ent->GetAttributeData(ATTR_POSITION) - position;
+        const float dist2 = glm::dot(offset, offset);
+        if (dist2 <= radius2) {
+            m_gridQueryHits.push_back(std::make_pair(dist2, ent));
         }
     }
-    return nearbyEnts;
 }
+
+template<> const DenseEntityMap<ActorComponent>& EntityManager::getComponents<ActorComponent>() const { return _actorComponents; }
+template<> const DenseEntityMap<VoxelComponent>& EntityManager::getComponents<VoxelComponent>() const { return _cubeComponents; }
+template<> const DenseEntityMap<ExplosiveComponent>& EntityManager::getComponents<ExplosiveComponent>() const { return _explosiveComponents; }
+template<> const DenseEntityMap<HealthComponent>& EntityManager::getComponents<HealthComponent>() const { return _healthComponents; }
+template<> const DenseEntityMap<HumanoidComponent>& EntityManager::getComponents<HumanoidComponent>() const { return _humanoidComponents; }
+template<> const DenseEntityMap<InventoryComponent>& EntityManager::getComponents<InventoryComponent>() const { return _inventoryComponents; }
+template<> const DenseEntityMap<ItemComponent>& EntityManager::getComponents<ItemComponent>() const { return _itemComponents; }
+template<> const DenseEntityMap<Light3DComponent>& EntityManager::getComponents<Light3DComponent>() const { return _light3DComponents; }
+template<> const DenseEntityMap<ParticleComponent>& EntityManager::getComponents<ParticleComponent>() const { return _particleComponents; }
+template<> const DenseEntityMap<PhysicsComponent>& EntityManager::getComponents<PhysicsComponent>() const { return _physicsComponents; }
+template<> const DenseEntityMap<RenderComponent>& EntityManager::getComponents<RenderComponent>() const { return _renderComponents; }
+template<> const DenseEntityMap<SelfDestructComponent>& EntityManager::getComponents<SelfDestructComponent>() const { return _selfDestructComponents; }
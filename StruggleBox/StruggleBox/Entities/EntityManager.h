@@ -1,13 +1,21 @@
 #pragma once
 
+#include "DenseEntityMap.h"
 #include "Entity.h"
+#include "EntityPrefab.h"
 #include "GFXDefines.h"
+#include "SpatialHashGrid.h"
+#include "SystemScheduler.h"
+#include "TaggedAllocator.h"
 #include <map>
 #include <queue>
+#include <unordered_map>
 
 const float ENTITY_SEARCH_RADIUS = 8.0f;
+const float ENTITY_GRID_CELL_SIZE = ENTITY_SEARCH_RADIUS; // Default radius queries touch at most 3x3x3 cells
 
 class Allocator;
+class JobSystem;
 class VoxelRenderer;
 class VoxelCache;
 class Particles;
@@ -47,7 +55,7 @@ class EntityManager
 public:
 	static const std::vector<std::string> ENTITY_COMPONENT_FAMILY_NAMES;
 
-	EntityManager(Allocator& allocator, VoxelRenderer& renderer, VoxelCache& voxelCache, Particles& particles, Physics& physics);
+	EntityManager(Allocator& allocator, JobSystem& jobSystem, VoxelRenderer& renderer, VoxelCache& voxelCache, Particles& particles, Physics& physics);
 	~EntityManager();
 
 	void update(const double delta);
@@ -92,36 +100,81 @@ public:
 		const EntityType filterType = ENTITY_NONE,
 		const float radius = ENTITY_SEARCH_RADIUS);
 
-	std::map<EntityID, Entity*> getNearbyEntities(const glm::vec3 position,
+	// Appends the matching entities within radius to result, returns how many were added
+	size_t getNearbyEntities(const glm::vec3 position,
+		std::vector<Entity*>& result,
 		const EntityID ignoreID = ENTITY_NONE,
 		const EntityType filterType = ENTITY_NONE,
 		const float radius = ENTITY_SEARCH_RADIUS);
 
-	std::map<EntityID, Entity*>& GetEntities() { return entityMap; };
+	// Appends up to count matching entities within radius to result, nearest first
+	size_t getNearestEntities(const glm::vec3 position,
+		const size_t count,
+		std::vector<Entity*>& result,
+		const EntityID ignoreID = ENTITY_NONE,
+		const EntityType filterType = ENTITY_NONE,
+		const float radius = ENTITY_SEARCH_RADIUS);
+
+	const DenseEntityMap<Entity>& GetEntities() const { return entityMap; };
+
+	// Typed access to the packed components of one family
+	template<class T> const DenseEntityMap<T>& getComponents() const;
+	template<class T> T* getComponent(const EntityID entityID) const { return getComponents<T>().get(entityID); }
 
 	Allocator& getAllocator() { return m_allocator; }
 
 private:
-	Allocator& m_allocator;
+	TaggedAllocator m_allocator;
 	VoxelRenderer& m_renderer;
 	VoxelCache& m_voxelFactory;
 	Particles& m_particles;
 	Physics& m_physics;
 
-	std::map<EntityID, Entity*> entityMap;   // EntityID, pointer to Entity
+	DenseEntityMap<Entity> entityMap;        // EntityID, pointer to Entity
+	DenseEntityMap<float> _lifeTimes;        // Each entity's lifeTime attribute, looked up once when added
 	std::queue<EntityID> eraseQueue;         // EntityIDs to remove after update
-	std::map<EntityID, ActorComponent*>      _actorComponents;
-	std::map<EntityID, VoxelComponent*>       _cubeComponents;
-	std::map<EntityID, ExplosiveComponent*>  _explosiveComponents;
-	std::map<EntityID, HealthComponent*>     _healthComponents;
-	std::map<EntityID, HumanoidComponent*>   _humanoidComponents;
-	std::map<EntityID, InventoryComponent*>  _inventoryComponents;
-	std::map<EntityID, ItemComponent*>       _itemComponents;
-	std::map<EntityID, Light3DComponent*>    _light3DComponents;
-	std::map<EntityID, ParticleComponent*>   _particleComponents;
-	std::map<EntityID, PhysicsComponent*>    _physicsComponents;
-	std::map<EntityID, RenderComponent*>	_renderComponents;
-	std::map<EntityID, SelfDestructComponent*> _selfDestructComponents;
-
+	DenseEntityMap<ActorComponent>        _actorComponents;
+	DenseEntityMap<VoxelComponent>        _cubeComponents;
+	DenseEntityMap<ExplosiveComponent>    _explosiveComponents;
+	DenseEntityMap<HealthComponent>       _healthComponents;
+	DenseEntityMap<HumanoidComponent>     _humanoidComponents;
+	DenseEntityMap<InventoryComponent>    _inventoryComponents;
+	DenseEntityMap<ItemComponent>         _itemComponents;
+	DenseEntityMap<Light3DComponent>      _light3DComponents;
+	DenseEntityMap<ParticleComponent>     _particleComponents;
+	DenseEntityMap<PhysicsComponent>      _physicsComponents;
+	DenseEntityMap<RenderComponent>       _renderComponents;
+	DenseEntityMap<SelfDestructComponent> _selfDestructComponents;
+
+	// Entity files by path, compiled on their first spawn
+	std::unordered_map<std::string, EntityPrefab> m_prefabs;
+
+	// Runs the component updates, families that don't share data run side by side
+	SystemScheduler m_scheduler;
+	double m_updateDelta;
+
+	// Entities with a position, refreshed at the end of every update
+	SpatialHashGrid m_spatialGrid;
+	std::vector<EntityID> m_gridQueryIDs;
+	std::vector<std::pair<float, Entity*>> m_gridQueryHits;
+
+	const EntityPrefab* getPrefab(const std::string& filePath);
+	void addComponentSystems();
+	void refreshSpatialGrid();
+	void queryNearby(const glm::vec3& position, const EntityID ignoreID, const EntityType filterType, const float radius);
+	EntityID registerEntity(Entity* entity);
 	void removeEntity(const EntityID entityID);
 };
+
+template<> const DenseEntityMap<ActorComponent>& EntityManager::getComponents<ActorComponent>() const;
+template<> const DenseEntityMap<VoxelComponent>& EntityManager::getComponents<VoxelComponent>() const;
+template<> const DenseEntityMap<ExplosiveComponent>& EntityManager::getComponents<ExplosiveComponent>() const;
+template<> const DenseEntityMap<HealthComponent>& EntityManager::getComponents<HealthComponent>() const;
+template<> const DenseEntityMap<HumanoidComponent>& EntityManager::getComponents<HumanoidComponent>() const;
+template<> const DenseEntityMap<InventoryComponent>& EntityManager::getComponents<InventoryComponent>() const;
+template<> const DenseEntityMap<ItemComponent>& EntityManager::getComponents<ItemComponent>() const;
+template<> const DenseEntityMap<Light3DComponent>& EntityManager::getComponents<Light3DComponent>() const;
+template<> const DenseEntityMap<ParticleComponent>& EntityManager::getComponents<ParticleComponent>() const;
+template<> const DenseEntityMap<PhysicsComponent>& EntityManager::getComponents<PhysicsComponent>() const;
+template<> const DenseEntityMap<RenderComponent>& EntityManager::getComponents<RenderComponent>() const;
+template<> const DenseEntityMap<SelfDestructComponent>& EntityManager::getComponents<SelfDestructComponent>() const;
@@ -0,0 +1,200 @@
+#include "EntityPrefab.h"
+#include "Entity.h"
+#include "Dictionary.h"
+#include "Log.h"
+#include <cstring>
+
+EntityPrefab::EntityPrefab()
+{
+}
+
+bool EntityPrefab::load(const std::string& filePath)
+{
+	Dictionary dict;
+	if (!dict.loadRootSubDictFromFile(filePath.c_str()))
+	{
+		return false;
+	}
+
+	dict.stepIntoSubDictWithKey("Attributes");
+	m_name = dict.getStringForKey("sname");
+	for (unsigned int i = 0; i < dict.getNumKeys(); i++)
+	{
+		const std::string key = dict.getKey(i);
+		if (key.compare(0, 1, "b") == 0) {
+			setValue<bool>(key.substr(1), PrefabAttributeType::Bool, dict.getBoolForKey(key.c_str()));
+		} else if (key.compare(0, 1, "i") == 0) {
+			setValue<int>(key.substr(1), PrefabAttributeType::Int, dict.getIntegerForKey(key.c_str()));
+		} else if (key.compare(0, 1, "u") == 0) {
+			setValue<unsigned int>(key.substr(1), PrefabAttributeType::UInt, dict.getIntegerForKey(key.c_str()));
+		} else if (key.compare(0, 1, "f") == 0) {
+			setValue<float>(key.substr(1), PrefabAttributeType::Float, dict.getFloatForKey(key.c_str()));
+		} else if (key.compare(0, 1, "d") == 0) {
+			setValue<double>(key.substr(1), PrefabAttributeType::Double, dict.getFloatForKey(key.c_str()));
+		} else if (key.compare(0, 1, "s") == 0) {
+			setString(key.substr(1), dict.getStringForKey(key.c_str()));
+		} else if (key.compare(0, 2, "v2") == 0) {
+			setVectorAxis<glm::vec2>(key, PrefabAttributeType::Vec2, dict.getFloatForKey(key.c_str()));
+		} else if (key.compare(0, 2, "v3") == 0) {
+			setVectorAxis<glm::vec3>(key, PrefabAttributeType::Vec3, dict.getFloatForKey(key.c_str()));
+		} else if (key.compare(0, 2, "v4") == 0) {
+			setVectorAxis<glm::vec4>(key, PrefabAttributeType::Vec4, dict.getFloatForKey(key.c_str()));
+		} else if (key.compare(0, 2, "q4") == 0) {
+			setVectorAxis<glm::quat>(key, PrefabAttributeType::Quat, dict.getFloatForKey(key.c_str()));
+		} else {
+			Log::Error("[EntityPrefab] Error loading attribute %s from %s, unknown type", key.c_str(), filePath.c_str());
+		}
+	}
+	dict.stepBackToRootSubDict();
+
+	dict.stepIntoSubDictWithKey("Components");
+	for (unsigned int i = 0; i < dict.getNumKeys(); i++)
+	{
+		PrefabComponent component = { dict.getKey(i), false, glm::vec3() };
+		if (component.family == "Light3D" && dict.stepIntoSubDictWithKey("Light3D"))
+		{
+			for (unsigned int j = 0; j < dict.getNumKeys(); j++)
+			{
+				const std::string subKey = dict.getKey(j);
+				if (subKey == "v3offsetX") {
+					component.offset.x = dict.getFloatForKey(subKey.c_str());
+				} else if (subKey == "v3offsetY") {
+					component.offset.y = dict.getFloatForKey(subKey.c_str());
+				} else if (subKey == "v3offsetZ") {
+					component.offset.z = dict.getFloatForKey(subKey.c_str());
+				}
+			}
+			component.hasOffset = true;
+			dict.stepOutOfSubDict();
+		}
+		m_components.push_back(component);
+	}
+	return true;
+}
+
+void EntityPrefab::applyAttributes(Entity& entity) const
+{
+	for (const PrefabAttribute& attribute : m_attributes)
+	{
+		switch (attribute.type)
+		{
+		case PrefabAttributeType::Bool:
+			entity.GetAttributeData<bool>(attribute.attributeID, attribute.name) = getValue<bool>(attribute.offset);
+			break;
+		case PrefabAttributeType::Int:
+			entity.GetAttributeData<int>(attribute.attributeID, attribute.name) = getValue<int>(attribute.offset);
+			break;
+		case PrefabAttributeType::UInt:
+			entity.GetAttributeData<unsigned int>(attribute.attributeID, attribute.name) = getValue<unsigned int>(attribute.offset);
+			break;
+		case PrefabAttributeType::Float:
+			entity.GetAttributeData<float>(attribute.attributeID, attribute.name) = getValue<float>(attribute.offset);
+			break;
+		case PrefabAttributeType::Double:
+			entity.GetAttributeData<double>(attribute.attributeID, attribute.name) = getValue<double>(attribute.offset);
+			break;
+		case PrefabAttributeType::String:
+			entity.GetAttributeData<std::string>(attribute.attributeID, attribute.name) = m_strings[attribute.offset];
+			break;
+		case PrefabAttributeType::Vec2:
+			entity.GetAttributeData<glm::vec2>(attribute.attributeID, attribute.name) = getValue<glm::vec2>(attribute.offset);
+			break;
+		case PrefabAttributeType::Vec3:
+			entity.GetAttributeData<glm::vec3>(attribute.attributeID, attribute.name) = getValue<glm::vec3>(attribute.offset);
+			break;
+		case PrefabAttributeType::Vec4:
+			entity.GetAttributeData<glm::vec4>(attribute.attributeID, attribute.name) = getValue<glm::vec4>(attribute.offset);
+			break;
+		case PrefabAttributeType::Quat:
+			entity.GetAttributeData<glm::quat>(attribute.attributeID, attribute.name) = getValue<glm::quat>(attribute.offset);
+			break;
+		}
+	}
+}
+
+static void setAxis(glm::vec2& vector, const char axis, const float value)
+{
+	if (axis == 'X') { vector.x = value; }
+	else if (axis == 'Y') { vector.y = value; }
+}
+
+static void setAxis(glm::vec3& vector, const char axis, const float value)
+{
+	if (axis == 'X') { vector.x = value; }
+	else if (axis == 'Y') { vector.y = value; }
+	else if (axis == 'Z') { vector.z = value; }
+}
+
+static void setAxis(glm::vec4& vector, const char axis, const float value)
+{
+	if (axis == 'X') { vector.x = value; }
+	else if (axis == 'Y') { vector.y = value; }
+	else if (axis == 'Z') { vector.z = value; }
+	else if (axis == 'W') { vector.w = value; }
+}
+
+static void setAxis(glm::quat& quat, const char axis, const float value)
+{
+	if (axis == 'X') { quat.x = value; }
+	else if (axis == 'Y') { quat.y = value; }
+	else if (axis == 'Z') { quat.z = value; }
+	else if (axis == 'W') { quat.w = value; }
+}
+
+template<typename T>
+void EntityPrefab::setValue(const std::string& name, const PrefabAttributeType type, const T& value)
+{
+	const T defaultValue = T();
+	const uint32_t offset = findOrAddValue(name, type, &defaultValue, sizeof(T));
+	memcpy(&m_data[offset], &value, sizeof(T));
+}
+
+void EntityPrefab::setString(const std::string& name, const std::string& value)
+{
+	for (const PrefabAttribute& attribute : m_attributes)
+	{
+		if (attribute.name == name && attribute.type == PrefabAttributeType::String)
+		{
+			m_strings[attribute.offset] = value;
+			return;
+		}
+	}
+	m_attributes.push_back({ name, AttributeRegistry::intern(name), PrefabAttributeType::String, (uint32_t)m_strings.size() });
+	m_strings.push_back(value);
+}
+
+// Vector attributes are stored one axis per key, named by type prefix, attribute name and axis
+template<typename T>
+void EntityPrefab::setVectorAxis(const std::string& key, const PrefabAttributeType type, const float value)
+{
+	const std::string name = key.substr(2, key.length() - 3);
+	const T defaultValue = T();
+	const uint32_t offset = findOrAddValue(name, type, &defaultValue, sizeof(T));
+	T vector = getValue<T>(offset);
+	setAxis(vector, key.back(), value);
+	memcpy(&m_data[offset], &vector, sizeof(T));
+}
+
+template<typename T>
+T EntityPrefab::getValue(const uint32_t offset) const
+{
+	T value;
+	memcpy(&value, &m_data[offset], sizeof(T));
+	return value;
+}
+
+uint32_t EntityPrefab::findOrAddValue(const std::string& name, const PrefabAttributeType type, const void* defaultValue, const size_t size)
+{
+	for (const PrefabAttribute& attribute : m_attributes)
+	{
+		if (attribute.name == name && attribute.type == type)
+		{
+			return attribute.offset;
+		}
+	}
+	const uint32_t offset = (uint32_t)m_data.size();
+	m_data.resize(m_data.size() + size);
+	memcpy(&m_data[offset], defaultValue, size);
+	m_attributes.push_back({ name, AttributeRegistry::intern(name), type, offset });
+	return offset;
+}
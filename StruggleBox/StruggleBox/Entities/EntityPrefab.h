@@ -0,0 +1,65 @@
+#pragma once
+
+#include "AttributeKey.h"
+#include "GFXDefines.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Entity;
+
+enum class PrefabAttributeType : uint8_t {
+	Bool,
+	Int,
+	UInt,
+	Float,
+	Double,
+	String,
+	Vec2,
+	Vec3,
+	Vec4,
+	Quat,
+};
+
+struct PrefabAttribute {
+	std::string name;
+	AttributeID attributeID;    // Interned when the file is loaded, spawns write through it
+	PrefabAttributeType type;
+	uint32_t offset;            // Into the value blob, or the string table for strings
+};
+
+struct PrefabComponent {
+	std::string family;
+	bool hasOffset;             // Light3D offset given in the file
+	glm::vec3 offset;
+};
+
+// An entity file compiled once into packed attribute values and a component
+// list, so spawning the same file again skips reading and parsing the plist
+class EntityPrefab
+{
+public:
+	EntityPrefab();
+
+	// Parses the plist, infers every attribute type from its key prefix
+	bool load(const std::string& filePath);
+
+	// Adds the attributes to the entity, or overwrites the ones it already has
+	void applyAttributes(Entity& entity) const;
+
+	const std::string& getName() const { return m_name; }
+	const std::vector<PrefabComponent>& getComponents() const { return m_components; }
+
+private:
+	std::string m_name;
+	std::vector<PrefabAttribute> m_attributes;      // In the order the file lists them
+	std::vector<unsigned char> m_data;              // Values of every non string attribute, back to back
+	std::vector<std::string> m_strings;
+	std::vector<PrefabComponent> m_components;
+
+	template<typename T> void setValue(const std::string& name, const PrefabAttributeType type, const T& value);
+	void setString(const std::string& name, const std::string& value);
+	template<typename T> void setVectorAxis(const std::string& key, const PrefabAttributeType type, const float value);
+	template<typename T> T getValue(const uint32_t offset) const;
+	uint32_t findOrAddValue(const std::string& name, const PrefabAttributeType type, const void* defaultValue, const size_t size);
+};
@@ -1,4 +1,5 @@
 #include "ExplosiveComponent.h"
+#include "EntityAttributes.h"
 #include "EntityManager.h"
 #include "ParticleComponent.h"
 #include "PhysicsComponent.h"
@@ -26,28 +27,28 @@ void ExplosiveComponent::update(const double delta)
         if ( _timer <= 0.0 )
 		{ // EXPLODED
             Entity* _owner = _manager.getEntity(_ownerID);
-            glm::vec3 pos = _owner->GetAttributeDataPtr<glm::vec3>("position");
-            float explosionRadius = _owner->GetAttributeDataPtr<float>("explosionRadius");
-            float explosionForce = _owner->GetAttributeDataPtr<float>("explosionForce");
+            glm::vec3 pos = _owner->GetAttributeData(ATTR_POSITION);
+            float explosionRadius = _owner->GetAttributeData(ATTR_EXPLOSION_RADIUS);
+            float explosionForce = _owner->GetAttributeData(ATTR_EXPLOSION_FORCE);
             if ( explosionForce > 0.0f ) {
                 //_world.Explosion(pos, explosionRadius, explosionForce); // TODO: Dispatch event for this
                 _manager.destroyEntity(_ownerID);
             } else { // Imploder
 				// TODO: All these particles and shit should move to the world
-                float implosionDuration = _owner->GetAttributeDataPtr<float>("implosionDuration");
+                float implosionDuration = _owner->GetAttributeData(ATTR_IMPLOSION_DURATION);
                 if ( implosionDuration >= 0.0f ) {
-                    ParticleComponent* particleComp = (ParticleComponent*)_manager.getComponent(_ownerID, "Particle");
+                    ParticleComponent* particleComp = _manager.getComponent<ParticleComponent>(_ownerID);
                     if ( !particleComp ) {
                         particleComp = new ParticleComponent(_ownerID, "BlackHole3D.plist", _manager, _particles);
                         _manager.setComponent(_ownerID, particleComp);
                         printf("Particle sys added to %i\n", _ownerID);
                     }
-                    PhysicsComponent* pComp = (PhysicsComponent*)_manager.getComponent(_ownerID, "Physics");
+                    PhysicsComponent* pComp = _manager.getComponent<PhysicsComponent>(_ownerID);
                     if ( pComp ) { _manager.removeComponent(_ownerID, pComp); }
 
                     if ( implosionDuration > 0.0f ) {
                         implosionDuration -= delta;
-                        _owner->GetAttributeDataPtr<float>("implosionDuration") = implosionDuration;
+                        _owner->GetAttributeData(ATTR_IMPLOSION_DURATION) = implosionDuration;
                     }
                     //_locator.Get<Physics>()->Explosion(btVector3(pos.x,pos.y,pos.z), explosionRadius, explosionForce);
                 } else if ( implosionDuration < 0.0f ) {
@@ -56,9 +57,9 @@ void ExplosiveComponent::update(const double delta)
             }
         } else if ( std::abs(_timer - 0.2) < 0.05f ) {
             Entity* _owner = _manager.getEntity(_ownerID);
-            float explosionForce = _owner->GetAttributeDataPtr<float>("explosionForce");
+            float explosionForce = _owner->GetAttributeData(ATTR_EXPLOSION_FORCE);
             if ( explosionForce < 0.0f ) { // Imploder hop up before detonating
-                PhysicsComponent* pComp = (PhysicsComponent*)_manager.getComponent(_ownerID, "Physics");
+                PhysicsComponent* pComp = _manager.getComponent<PhysicsComponent>(_ownerID);
                 if ( pComp ) pComp->getRigidBody()->applyCentralImpulse(btVector3(0.0f,0.5f,0.0f));
             }
         }
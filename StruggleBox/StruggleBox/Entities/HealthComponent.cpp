@@ -1,4 +1,5 @@
 #include "HealthComponent.h"
+#include "EntityAttributes.h"
 #include "EntityManager.h"
 #include "World3D.h"
 #include "Log.h"
@@ -10,9 +11,9 @@ EntityComponent(ownerID, "Health"),
 _manager(manager)
 {
     Entity* _owner = _manager.getEntity(_ownerID);
-    bool setDefaults = !_owner->HasAttribute("maxHealth");
-    health = &_owner->GetAttributeDataPtr<int>("health");
-    maxHealth = &_owner->GetAttributeDataPtr<int>("maxHealth");
+    bool setDefaults = !_owner->HasAttribute(ATTR_MAX_HEALTH);
+    health = &_owner->GetAttributeData(ATTR_HEALTH);
+    maxHealth = &_owner->GetAttributeData(ATTR_MAX_HEALTH);
     if ( setDefaults ) {
         *health = 100;
         *maxHealth = 100;
@@ -30,7 +31,7 @@ void HealthComponent::update(const double delta)
 		Entity* _owner = _manager.getEntity(_ownerID);
         Log::Debug("[HealthComponent] Entity %i (%s) health reached zero, died",
 			_ownerID,
-			_owner->GetAttributeDataPtr<std::string>("name"));
+			_owner->GetAttributeData(ATTR_NAME));
 		_manager.destroyEntity(_ownerID);
     }
     if ( damageTimer != 0.0 )
@@ -47,7 +48,7 @@ void HealthComponent::addHealth(
     Entity* _owner = _manager.getEntity(_ownerID);
     Log::Debug("[HealthComponent] Entity %i (%s) healed by %i points\n",
 		_ownerID,
-		_owner->GetAttributeDataPtr<std::string>("name").c_str(),
+		_owner->GetAttributeData(ATTR_NAME).c_str(),
 		newHealth);
     health += newHealth;
     if ( health < maxHealth ) health = maxHealth;
@@ -62,22 +63,22 @@ void HealthComponent::takeDamage(
         Entity* _owner = _manager.getEntity(_ownerID);
 		Log::Debug("[HealthComponent] Entity %i (%s) took %i damage",
 			_ownerID,
-			_owner->GetAttributeDataPtr<std::string>("name").c_str(),
+			_owner->GetAttributeData(ATTR_NAME).c_str(),
 			damage);
         if (damager)
 		{
 			const int damagerID = damager->GetID();
-			const int damageOwnerID = damager->GetAttributeDataPtr<int>("ownerID");			
+			const int damageOwnerID = damager->GetAttributeData(ATTR_OWNER_ID);			
 			Log::Debug("[HealthComponent] Damage inflicted by %i (%s)",
 				damagerID,
-				damager->GetAttributeDataPtr<std::string>("name").c_str());
+				damager->GetAttributeData(ATTR_NAME).c_str());
             if ( damageOwnerID != -1 ) {
                 Entity* damageOwner = _manager.getEntity(damageOwnerID);
                 if (damageOwner)
 				{
 					Log::Debug("[HealthComponent] Entity to blame is %i (%s)",
 						damageOwnerID,
-						damageOwner->GetAttributeDataPtr<std::string>("name").c_str());
+						damageOwner->GetAttributeData(ATTR_NAME).c_str());
                 }
             }
         } else {
@@ -90,7 +91,7 @@ void HealthComponent::takeDamage(
 		{
 			Log::Debug("[HealthComponent] The damage resulted in death for %i (%s)",
 				_ownerID,
-				_owner->GetAttributeDataPtr<std::string>("name").c_str());
+				_owner->GetAttributeData(ATTR_NAME).c_str());
 		}
 		else
 		{
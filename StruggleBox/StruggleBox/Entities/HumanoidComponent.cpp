@@ -1,4 +1,5 @@
 #include "HumanoidComponent.h"
+#include "EntityAttributes.h"
 
 #include "Allocator.h"
 #include "ArenaOperators.h"
@@ -53,7 +54,7 @@ HumanoidComponent::HumanoidComponent(
 
     btTransform startTransform;
 	startTransform.setIdentity ();
-    const glm::vec3 position = m_owner->GetAttributeDataPtr<glm::vec3>("position");
+    const glm::vec3 position = m_owner->GetAttributeData(ATTR_POSITION);
 	startTransform.setOrigin (btVector3(position.x, position.y, position.z));
     
     ghostObject = _physics.createGhostObject();
@@ -87,18 +88,18 @@ HumanoidComponent::HumanoidComponent(
 	physicsWorld->addAction(character);
     
     // Variables
-    glm::quat rotation = m_owner->GetAttributeDataPtr<glm::quat>("rotation");
+    glm::quat rotation = m_owner->GetAttributeData(ATTR_ROTATION);
     Rotate(rotation);
     // Load player model files
-    const int charType = m_owner->GetAttributeDataPtr<int>("type");
+    const int charType = m_owner->GetAttributeData(ATTR_TYPE);
     setCharacterType(charType);
     
-    m_owner->GetAttributeDataPtr<int>("backpackItemID") = 0;
-    m_owner->GetAttributeDataPtr<int>("rightHandItemID") = 0;
-    m_owner->GetAttributeDataPtr<int>("leftHandItemID") = 0;
-    m_owner->GetAttributeDataPtr<int>("ownerID") = 0;
+    m_owner->GetAttributeData(ATTR_BACKPACK_ITEM_ID) = 0;
+    m_owner->GetAttributeData(ATTR_RIGHT_HAND_ITEM_ID) = 0;
+    m_owner->GetAttributeData(ATTR_LEFT_HAND_ITEM_ID) = 0;
+    m_owner->GetAttributeData(ATTR_OWNER_ID) = 0;
 
-    glm::vec3& bb = m_owner->GetAttributeDataPtr<glm::vec3>("bb");
+    glm::vec3& bb = m_owner->GetAttributeData(ATTR_BB);
     bb = glm::vec3(characterRadius, characterHeight, characterRadius);
     
     leftArmAnimState = ArmState::Arm_Idle;
@@ -110,9 +111,9 @@ HumanoidComponent::HumanoidComponent(
     torsoLeanAngle = 0.0f;
     torsoBobAmount = 0.0f;
     
-    if (!m_owner->HasAttribute("health"))
+    if (!m_owner->HasAttribute(ATTR_HEALTH))
     {
-        m_owner->GetAttributeDataPtr<int>("health") = 100;
+        m_owner->GetAttributeData(ATTR_HEALTH) = 100;
     }
 }
 
@@ -135,19 +136,19 @@ void HumanoidComponent::setCharacterType( const int newType )
     const glm::vec3 handLPos  = glm::vec3( 14*scaleCube, 0.0f, 0.0f );
     const glm::vec3 handRPos  = glm::vec3(-14*scaleCube, 0.0f, 0.0f );
 
-    int& torsoID = m_owner->GetAttributeDataPtr<int>("torsoID");
-    int& headID = m_owner->GetAttributeDataPtr<int>("headID");
-    int& leftFootID = m_owner->GetAttributeDataPtr<int>("leftFootID");
-    int& rightFootID = m_owner->GetAttributeDataPtr<int>("rightFootID");
-    int& leftArmID = m_owner->GetAttributeDataPtr<int>("leftArmID");
-    int& rightArmID = m_owner->GetAttributeDataPtr<int>("rightArmID");
+    int& torsoID = m_owner->GetAttributeData(ATTR_TORSO_ID);
+    int& headID = m_owner->GetAttributeData(ATTR_HEAD_ID);
+    int& leftFootID = m_owner->GetAttributeData(ATTR_LEFT_FOOT_ID);
+    int& rightFootID = m_owner->GetAttributeData(ATTR_RIGHT_FOOT_ID);
+    int& leftArmID = m_owner->GetAttributeData(ATTR_LEFT_ARM_ID);
+    int& rightArmID = m_owner->GetAttributeData(ATTR_RIGHT_ARM_ID);
 
-    const std::string& torsoObject = m_owner->GetAttributeDataPtr<std::string>("torsoObject");
-    const std::string& headObject = m_owner->GetAttributeDataPtr<std::string>("headObject");
-    const std::string& leftFootObject = m_owner->GetAttributeDataPtr<std::string>("leftFootObject");
-    const std::string& rightFootObject = m_owner->GetAttributeDataPtr<std::string>("rightFootObject");
-    const std::string& leftArmObject = m_owner->GetAttributeDataPtr<std::string>("leftArmObject");
-    const std::string& rightArmObject = m_owner->GetAttributeDataPtr<std::string>("rightArmObject");
+    const std::string& torsoObject = m_owner->GetAttributeData(ATTR_TORSO_OBJECT);
+    const std::string& headObject = m_owner->GetAttributeData(ATTR_HEAD_OBJECT);
+    const std::string& leftFootObject = m_owner->GetAttributeData(ATTR_LEFT_FOOT_OBJECT);
+    const std::string& rightFootObject = m_owner->GetAttributeData(ATTR_RIGHT_FOOT_OBJECT);
+    const std::string& leftArmObject = m_owner->GetAttributeData(ATTR_LEFT_ARM_OBJECT);
+    const std::string& rightArmObject = m_owner->GetAttributeData(ATTR_RIGHT_ARM_OBJECT);
 
 	// Load the object instances
 	torsoID = _voxels.addInstance(torsoObject, torsoPos, scale, glm::quat(), COLOR_WHITE);
@@ -162,12 +163,12 @@ void HumanoidComponent::setCharacterType( const int newType )
 void HumanoidComponent::update(const double delta)
 {
     Entity* m_owner = _entityManager.getEntity(_ownerID);
-    const bool& jumping = m_owner->GetAttributeDataPtr<bool>("jumping");
-    const bool& running = m_owner->GetAttributeDataPtr<bool>("running");
-    const bool& sneaking = m_owner->GetAttributeDataPtr<bool>("sneaking");
-    const bool& blocking = m_owner->GetAttributeDataPtr<bool>("blocking");
-    const glm::vec3& moveInput = m_owner->GetAttributeDataPtr<glm::vec3>("moveInput");        // First person movement input
-    const glm::vec3& direction = m_owner->GetAttributeDataPtr<glm::vec3>("direction");        // Third person movement input
+    const bool& jumping = m_owner->GetAttributeData(ATTR_JUMPING);
+    const bool& running = m_owner->GetAttributeData(ATTR_RUNNING);
+    const bool& sneaking = m_owner->GetAttributeData(ATTR_SNEAKING);
+    const bool& blocking = m_owner->GetAttributeData(ATTR_BLOCKING);
+    const glm::vec3& moveInput = m_owner->GetAttributeData(ATTR_MOVE_INPUT);        // First person movement input
+    const glm::vec3& direction = m_owner->GetAttributeData(ATTR_DIRECTION);        // Third person movement input
  
     btScalar walkFactor = 1.0f;
     if (running && sneaking) walkFactor *= 0.25f;
@@ -262,21 +263,21 @@ void HumanoidComponent::update(const double delta)
 
             // Update object positions and rotations based on physics transform
             const btTransform trans = ghostObject->getWorldTransform();
-            m_owner->GetAttributeDataPtr<glm::vec3>("position") = glm::vec3(trans.getOrigin().x(), trans.getOrigin().y(), trans.getOrigin().z());
-            m_owner->GetAttributeDataPtr<glm::quat>("rotation") = glm::quat(trans.getRotation().w(), trans.getRotation().x(), trans.getRotation().y(), trans.getRotation().z());
+            m_owner->GetAttributeData(ATTR_POSITION) = glm::vec3(trans.getOrigin().x(), trans.getOrigin().y(), trans.getOrigin().z());
+            m_owner->GetAttributeData(ATTR_ROTATION) = glm::quat(trans.getRotation().w(), trans.getRotation().x(), trans.getRotation().y(), trans.getRotation().z());
         }
         else 
         {    
             // Game is paused, force move player instead of letting physics do the moving
             const btVector3 playerPosition = trans.getOrigin();
             const float epsilon = 0.00001f;
-            const glm::vec3 position = m_owner->GetAttributeDataPtr<glm::vec3>("position");
+            const glm::vec3 position = m_owner->GetAttributeData(ATTR_POSITION);
             if ( fabsf(position.x - playerPosition.x()) > epsilon ||
                  fabsf(position.y - playerPosition.y()) > epsilon ||
                  fabsf(position.z - playerPosition.z()) > epsilon ) {
                 character->warp(btVector3(position.x, position.y, position.z));
             }
-            const glm::quat rotation = m_owner->GetAttributeDataPtr<glm::quat>("rotation");
+            const glm::quat rotation = m_owner->GetAttributeData(ATTR_ROTATION);
             if ( fabsf( rotation.x - playerRotation.w() ) > epsilon ||
                  fabsf( rotation.y - playerRotation.x() ) > epsilon ||
                  fabsf( rotation.z - playerRotation.y() ) > epsilon ||
@@ -294,26 +295,26 @@ void HumanoidComponent::update(const double delta)
 void HumanoidComponent::updateAnimations(double delta)
 {
     Entity* m_owner = _entityManager.getEntity(_ownerID);
-    const int torsoID = m_owner->GetAttributeDataPtr<int>("torsoID");
-    const int headID = m_owner->GetAttributeDataPtr<int>("headID");
-    const int leftFootID = m_owner->GetAttributeDataPtr<int>("leftFootID");
-    const int rightFootID = m_owner->GetAttributeDataPtr<int>("rightFootID");
-    const int leftHandID = m_owner->GetAttributeDataPtr<int>("leftArmID");
-    const int rightHandID = m_owner->GetAttributeDataPtr<int>("rightArmID");
-    const std::string torsoObject = m_owner->GetAttributeDataPtr<std::string>("torsoObject");
-    const std::string headObject = m_owner->GetAttributeDataPtr<std::string>("headObject");
-    const std::string leftFootObject = m_owner->GetAttributeDataPtr<std::string>("leftFootObject");
-    const std::string rightFootObject = m_owner->GetAttributeDataPtr<std::string>("rightFootObject");
-    const std::string leftHandObject = m_owner->GetAttributeDataPtr<std::string>("leftArmObject");
-    const std::string rightHandObject = m_owner->GetAttributeDataPtr<std::string>("rightArmObject");
-    const float lifeTime = m_owner->GetAttributeDataPtr<float>("lifeTime");
-    const bool blocking = m_owner->GetAttributeDataPtr<bool>("blocking");
+    const int torsoID = m_owner->GetAttributeData(ATTR_TORSO_ID);
+    const int headID = m_owner->GetAttributeData(ATTR_HEAD_ID);
+    const int leftFootID = m_owner->GetAttributeData(ATTR_LEFT_FOOT_ID);
+    const int rightFootID = m_owner->GetAttributeData(ATTR_RIGHT_FOOT_ID);
+    const int leftHandID = m_owner->GetAttributeData(ATTR_LEFT_ARM_ID);
+    const int rightHandID = m_owner->GetAttributeData(ATTR_RIGHT_ARM_ID);
+    const std::string torsoObject = m_owner->GetAttributeData(ATTR_TORSO_OBJECT);
+    const std::string headObject = m_owner->GetAttributeData(ATTR_HEAD_OBJECT);
+    const std::string leftFootObject = m_owner->GetAttributeData(ATTR_LEFT_FOOT_OBJECT);
+    const std::string rightFootObject = m_owner->GetAttributeData(ATTR_RIGHT_FOOT_OBJECT);
+    const std::string leftHandObject = m_owner->GetAttributeData(ATTR_LEFT_ARM_OBJECT);
+    const std::string rightHandObject = m_owner->GetAttributeData(ATTR_RIGHT_ARM_OBJECT);
+    const float lifeTime = m_owner->GetAttributeData(ATTR_LIFE_TIME);
+    const bool blocking = m_owner->GetAttributeData(ATTR_BLOCKING);
 
     const float animationSpeed = 20.0f;
     const float scaleCube = DEFAULT_VOXEL_MESHING_WIDTH*sizeScale;
 
-    const glm::vec3 playerPosition = m_owner->GetAttributeDataPtr<glm::vec3>("position");
-    glm::quat torsoRotation = m_owner->GetAttributeDataPtr<glm::quat>("rotation");
+    const glm::vec3 playerPosition = m_owner->GetAttributeData(ATTR_POSITION);
+    glm::quat torsoRotation = m_owner->GetAttributeData(ATTR_ROTATION);
 
     // Walkangles
     float leftFootAngle = std::sin(lifeTime * animationSpeed);
@@ -374,7 +375,7 @@ void HumanoidComponent::updateAnimations(double delta)
     // Now find parameters for the arms
     if (leftArmAnimState == ArmState::Arm_Idle)
     {
-        const bool& running = m_owner->GetAttributeDataPtr<bool>("running");
+        const bool& running = m_owner->GetAttributeData(ATTR_RUNNING);
         if (running)
         {
             leftHandSlerp = 0.3f;
@@ -406,7 +407,7 @@ void HumanoidComponent::updateAnimations(double delta)
     
     if (rightArmAnimState == ArmState::Arm_Idle)
     {
-        const bool& running = m_owner->GetAttributeDataPtr<bool>("running");
+        const bool& running = m_owner->GetAttributeData(ATTR_RUNNING);
         if (running)
         {
             rightHandSlerp = 0.3f;
@@ -427,12 +428,12 @@ void HumanoidComponent::updateAnimations(double delta)
             rHandTimer = 0.0f;
             if (m_rightHandItem)
             {
-                if ( m_rightHandItem->GetAttributeDataPtr<int>("itemType") == Item_Potion_Health )
+                if ( m_rightHandItem->GetAttributeData(ATTR_ITEM_TYPE) == Item_Potion_Health )
                 {
                     // Use potion and delete it from inventory
-                    int potionID = m_rightHandItem->GetAttributeDataPtr<int>("ID");
-                    int health = m_rightHandItem->GetAttributeDataPtr<int>("health");
-                    HealthComponent* hc = (HealthComponent*)_entityManager.getComponent(potionID, "Health");
+                    int potionID = m_rightHandItem->GetAttributeData(ATTR_ID);
+                    int health = m_rightHandItem->GetAttributeData(ATTR_HEALTH);
+                    HealthComponent* hc = _entityManager.getComponent<HealthComponent>(potionID);
                     if ( hc ) hc->addHealth( health );
                     _entityManager.destroyEntity(potionID);
                     m_rightHandItem = NULL;
@@ -460,8 +461,8 @@ void HumanoidComponent::updateAnimations(double delta)
             rHandTimer = 0.0f;
             if (m_rightHandItem)
             {
-                m_rightHandItem->GetAttributeDataPtr<glm::vec3>("velocity") = glm::vec3(0.0f,0.0f,0.0f);
-                m_rightHandItem->GetAttributeDataPtr<bool>("generateCollisions") = false;
+                m_rightHandItem->GetAttributeData(ATTR_VELOCITY) = glm::vec3(0.0f,0.0f,0.0f);
+                m_rightHandItem->GetAttributeData(ATTR_GENERATE_COLLISIONS) = false;
             }
         }
         else
@@ -516,43 +517,43 @@ void HumanoidComponent::updateAnimations(double delta)
 	_voxels.getInstance(rightHandObject, rightHandID)->position = (centerPos + handRPos);
     if (m_rightHandItem)
     {
-        const glm::vec3 gripOffset = m_rightHandItem->GetAttributeDataPtr<glm::vec3>("gripOffset");
+        const glm::vec3 gripOffset = m_rightHandItem->GetAttributeData(ATTR_GRIP_OFFSET);
         glm::vec3 rHandItemPos = glm::vec3( -14*scaleCube, torsoBobAmount, 0.0f ); // torso width and bob
         rHandItemPos += glm::vec3( -2*scaleCube, -12*scaleCube, 22*scaleCube ) + gripOffset;
         rHandItemPos = rightHandRot*rHandItemPos;
-        m_rightHandItem->GetAttributeDataPtr<glm::vec3>("position") = glm::vec3(centerPos+rHandItemPos);
+        m_rightHandItem->GetAttributeData(ATTR_POSITION) = glm::vec3(centerPos+rHandItemPos);
         glm::quat itemrot = glm::angleAxis(toRads(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        m_rightHandItem->GetAttributeDataPtr<glm::quat>("rotation") = rightHandRot*itemrot;
+        m_rightHandItem->GetAttributeData(ATTR_ROTATION) = rightHandRot*itemrot;
     }
     if (m_leftHandItem)
     {
-        const glm::vec3 gripOffset = m_leftHandItem->GetAttributeDataPtr<glm::vec3>("gripOffset");
+        const glm::vec3 gripOffset = m_leftHandItem->GetAttributeData(ATTR_GRIP_OFFSET);
 
         glm::vec3 lHandItemPos = glm::vec3(14 * scaleCube, torsoBobAmount, 0.0f); // torso width and bob
         lHandItemPos += glm::vec3(2 * scaleCube, -12 * scaleCube, 22 * scaleCube) + gripOffset;
         lHandItemPos = leftHandRot * lHandItemPos;
-        m_leftHandItem->GetAttributeDataPtr<glm::vec3>("position") = glm::vec3(centerPos + lHandItemPos);
+        m_leftHandItem->GetAttributeData(ATTR_POSITION) = glm::vec3(centerPos + lHandItemPos);
         glm::quat itemrot = glm::angleAxis(toRads(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         if (blocking)
         {
             itemrot = itemrot * glm::angleAxis(toRads(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         }
-        m_leftHandItem->GetAttributeDataPtr<glm::quat>("rotation") = leftHandRot * itemrot;
+        m_leftHandItem->GetAttributeData(ATTR_ROTATION) = leftHandRot * itemrot;
     }
     // Head looking (slightly) in camera direction
 	_voxels.getInstance(headObject, headID)->rotation = torsoRotation;
     
     if (m_backpack != nullptr)
     {
-        m_backpack->GetAttributeDataPtr<glm::quat>("rotation") = torsoRotation * hipRot * tiltRot;
-        m_backpack->GetAttributeDataPtr<glm::vec3>("position") = glm::vec3(centerPos+torsoPos);
+        m_backpack->GetAttributeData(ATTR_ROTATION) = torsoRotation * hipRot * tiltRot;
+        m_backpack->GetAttributeData(ATTR_POSITION) = glm::vec3(centerPos+torsoPos);
     }
 }
 
 const void HumanoidComponent::Rotate(const float rotX, const float rotY)
 {
     Entity* m_owner = _entityManager.getEntity(_ownerID);
-    glm::quat& rotation = m_owner->GetAttributeDataPtr<glm::quat>("rotation");
+    glm::quat& rotation = m_owner->GetAttributeData(ATTR_ROTATION);
     glm::quat xRot = glm::angleAxis(rotX, glm::vec3(1.0f, 0.0f, 0.0f));
     glm::quat yRot = glm::angleAxis(rotY, glm::vec3(0.0f, 1.0f, 0.0f));
     rotation = rotation*xRot;
@@ -566,7 +567,7 @@ void HumanoidComponent::Rotate(glm::quat orientation)
     ghostObject->getWorldTransform().setRotation(rotation);
 
     Entity* m_owner = _entityManager.getEntity(_ownerID);
-    m_owner->GetAttributeDataPtr<glm::quat>("rotation") = orientation;
+    m_owner->GetAttributeData(ATTR_ROTATION) = orientation;
 }
 
 void HumanoidComponent::Warp( glm::vec3 position )
@@ -583,18 +584,18 @@ void HumanoidComponent::Grab(Entity* grabbedObject)
     }
     // Check for known types of items to grab
     // TODO: EXTEND TO PERHAPS ALLOW GRABBING PROJECTILES FROM MID-AIR :D
-    if (grabbedObject->GetAttributeDataPtr<int>("type") != ENTITY_ITEM)
+    if (grabbedObject->GetAttributeData(ATTR_TYPE) != ENTITY_ITEM)
     {
         return;
     }
-    const ItemType itemType = (ItemType)grabbedObject->GetAttributeDataPtr<int>("itemType");
+    const ItemType itemType = (ItemType)grabbedObject->GetAttributeData(ATTR_ITEM_TYPE);
     if (itemType == Item_Backpack && m_backpack == nullptr)
     {
         m_backpack = grabbedObject;
-        const EntityID backPackID = (EntityID)m_backpack->GetAttributeDataPtr<int>("ID");
-        owner->GetAttributeDataPtr<int>("backpackItemID") = backPackID;
-        m_backpack->GetAttributeDataPtr<int>("ownerID") = _ownerID;
-        if (PhysicsComponent* pComp = (PhysicsComponent*)_entityManager.getComponent(backPackID, "Physics"))
+        const EntityID backPackID = (EntityID)m_backpack->GetAttributeData(ATTR_ID);
+        owner->GetAttributeData(ATTR_BACKPACK_ITEM_ID) = backPackID;
+        m_backpack->GetAttributeData(ATTR_OWNER_ID) = _ownerID;
+        if (PhysicsComponent* pComp = _entityManager.getComponent<PhysicsComponent>(backPackID))
         { 
             pComp->setPhysicsMode(PhysicsMode::Physics_Off, false, false);
         }
@@ -613,24 +614,24 @@ void HumanoidComponent::Store(Entity *storedObject)
         return;
     }
     // Put item in backpack
-    const EntityID backPackID = m_backpack->GetAttributeDataPtr<int>("ID");
-    if (InventoryComponent* inventoryC = (InventoryComponent*)_entityManager.getComponent(backPackID, "Inventory"))
+    const EntityID backPackID = m_backpack->GetAttributeData(ATTR_ID);
+    if (InventoryComponent* inventoryC = _entityManager.getComponent<InventoryComponent>(backPackID))
     {
-        storedObject->GetAttributeDataPtr<int>("ownerID") = _ownerID;
-        const EntityID objectID = storedObject->GetAttributeDataPtr<int>("ID");
-        if (PhysicsComponent* pComp = (PhysicsComponent*)_entityManager.getComponent(objectID, "Physics"))
+        storedObject->GetAttributeData(ATTR_OWNER_ID) = _ownerID;
+        const EntityID objectID = storedObject->GetAttributeData(ATTR_ID);
+        if (PhysicsComponent* pComp = _entityManager.getComponent<PhysicsComponent>(objectID))
         {
             pComp->setPhysicsMode(PhysicsMode::Physics_Off, false, false);
         }
-        if (VoxelComponent* cubeComp = (VoxelComponent*)_entityManager.getComponent(objectID, "Cube"))
+        if (VoxelComponent* cubeComp = _entityManager.getComponent<VoxelComponent>(objectID))
         {
             cubeComp->unloadObject();
         }
-        if (ParticleComponent* particleComp = (ParticleComponent*)_entityManager.getComponent(objectID, "Particle"))
+        if (ParticleComponent* particleComp = _entityManager.getComponent<ParticleComponent>(objectID))
         {
             particleComp->deActivate();
         }
-        if (Light3DComponent* light3DComp = (Light3DComponent*)_entityManager.getComponent(objectID, "Light3D"))
+        if (Light3DComponent* light3DComp = _entityManager.getComponent<Light3DComponent>(objectID))
         {
             light3DComp->deActivate();
         }
@@ -642,13 +643,13 @@ void HumanoidComponent::Store(Entity *storedObject)
 void HumanoidComponent::Drop(Entity* droppedObject)
 {
     Entity* m_owner = _entityManager.getEntity(_ownerID);
-    const glm::vec3 humanPos = m_owner->GetAttributeDataPtr<glm::vec3>("position");
-    const glm::vec3 objPos = droppedObject->GetAttributeDataPtr<glm::vec3>("position");
+    const glm::vec3 humanPos = m_owner->GetAttributeData(ATTR_POSITION);
+    const glm::vec3 objPos = droppedObject->GetAttributeData(ATTR_POSITION);
     const glm::vec3 dir = objPos - humanPos;
     const glm::vec3 vel = glm::normalize(dir);
 
-    const int objectID = droppedObject->GetAttributeDataPtr<int>("ID");
-    PhysicsComponent* itemPhysComp = (PhysicsComponent*)_entityManager.getComponent(objectID, "Physics");
+    const int objectID = droppedObject->GetAttributeData(ATTR_ID);
+    PhysicsComponent* itemPhysComp = _entityManager.getComponent<PhysicsComponent>(objectID);
     if (itemPhysComp)
     {
         const btVector3 newVel = btVector3(vel.x, vel.y, vel.z);
@@ -656,9 +657,9 @@ void HumanoidComponent::Drop(Entity* droppedObject)
         itemPhysComp->setLinearVelocity(&newVel);
     }
 
-    droppedObject->GetAttributeDataPtr<glm::vec3>("velocity") = vel;
-    droppedObject->GetAttributeDataPtr<bool>("generateCollisions") = true;
-    droppedObject->GetAttributeDataPtr<int>("ownerID") = 0;
+    droppedObject->GetAttributeData(ATTR_VELOCITY) = vel;
+    droppedObject->GetAttributeData(ATTR_GENERATE_COLLISIONS) = true;
+    droppedObject->GetAttributeData(ATTR_OWNER_ID) = 0;
 
     Log::Debug("Player %i dropped object %i", _ownerID, objectID);
 }
@@ -671,16 +672,16 @@ void HumanoidComponent::Wield(Entity* entityToWield)
         return; // Can't grab yourself
     }
 
-    const ItemType itemType = (ItemType)entityToWield->GetAttributeDataPtr<int>("itemType");
+    const ItemType itemType = (ItemType)entityToWield->GetAttributeData(ATTR_ITEM_TYPE);
     if (itemType == Item_Shield_Wood)
     {
         // Item goes in left hand
         if (!m_leftHandItem)
         {
             m_leftHandItem = entityToWield;
-            const int itemID = m_leftHandItem->GetAttributeDataPtr<int>("ID");
-            m_leftHandItem->GetAttributeDataPtr<int>("ownerID") = _ownerID;
-            owner->GetAttributeDataPtr<int>("leftHandItemID") = itemID;
+            const int itemID = m_leftHandItem->GetAttributeData(ATTR_ID);
+            m_leftHandItem->GetAttributeData(ATTR_OWNER_ID) = _ownerID;
+            owner->GetAttributeData(ATTR_LEFT_HAND_ITEM_ID) = itemID;
         }
         else
         {
@@ -702,12 +703,12 @@ void HumanoidComponent::Wield(Entity* entityToWield)
         }
 
         m_rightHandItem = entityToWield;
-        const int itemID = m_rightHandItem->GetAttributeDataPtr<int>("ID");
-        m_rightHandItem->GetAttributeDataPtr<int>("ownerID") = _ownerID;
-        owner->GetAttributeDataPtr<int>("rightHandItemID") = itemID;
+        const int itemID = m_rightHandItem->GetAttributeData(ATTR_ID);
+        m_rightHandItem->GetAttributeData(ATTR_OWNER_ID) = _ownerID;
+        owner->GetAttributeData(ATTR_RIGHT_HAND_ITEM_ID) = itemID;
     }
 
-    const int entityToWieldID = entityToWield->GetAttributeDataPtr<int>("ID");
+    const int entityToWieldID = entityToWield->GetAttributeData(ATTR_ID);
     std::vector<EntityComponent*> components = _entityManager.getAllComponents(entityToWieldID);
     for (EntityComponent* component : components)
     {
@@ -739,7 +740,7 @@ void HumanoidComponent::ThrowStart()
     //    return;
     //}
     Entity* m_owner = _entityManager.getEntity(_ownerID);
-    rHandTimer = m_owner->GetAttributeDataPtr<float>("lifeTime");
+    rHandTimer = m_owner->GetAttributeData(ATTR_LIFE_TIME);
     rightArmAnimState = ArmState::Arm_Throwing;
 }
 
@@ -759,10 +760,10 @@ void HumanoidComponent::ThrowItem( const glm::vec3 targetPos )
         return;
     }
     Entity* m_owner = _entityManager.getEntity(_ownerID);
-    const double timeNow = m_owner->GetAttributeDataPtr<float>("lifeTime");
+    const double timeNow = m_owner->GetAttributeData(ATTR_LIFE_TIME);
     const float strength = fminf(timeNow- throwTime, 1.0f)*10.0f;
-    const int rightHandID = m_owner->GetAttributeDataPtr<int>("rightArmID");
-    const std::string rightHandObject = m_owner->GetAttributeDataPtr<std::string>("rightArmObject");
+    const int rightHandID = m_owner->GetAttributeData(ATTR_RIGHT_ARM_ID);
+    const std::string rightHandObject = m_owner->GetAttributeData(ATTR_RIGHT_ARM_OBJECT);
     const glm::vec3 pos = _voxels.getInstance(rightHandObject, rightHandID)->position;
     
     glm::vec3 dir = targetPos-pos;
@@ -770,30 +771,30 @@ void HumanoidComponent::ThrowItem( const glm::vec3 targetPos )
     btVector3 newVel = btVector3(vel.x,vel.y,vel.z);
     btVector3 newPos = btVector3(pos.x,pos.y,pos.z);
 
-    m_rightHandItem->GetAttributeDataPtr<glm::vec3>("position") = glm::vec3(newPos.x(), newPos.y(), newPos.z());
-    const int rhiID = m_rightHandItem->GetAttributeDataPtr<int>("ID");
-    PhysicsComponent* itemPhysComp = (PhysicsComponent*)_entityManager.getComponent(rhiID, "Physics");
+    m_rightHandItem->GetAttributeData(ATTR_POSITION) = glm::vec3(newPos.x(), newPos.y(), newPos.z());
+    const int rhiID = m_rightHandItem->GetAttributeData(ATTR_ID);
+    PhysicsComponent* itemPhysComp = _entityManager.getComponent<PhysicsComponent>(rhiID);
     if (itemPhysComp) 
     {
         itemPhysComp->setPhysicsMode(PhysicsMode::Physics_Cube_AABBs, false, false);
         itemPhysComp->setLinearVelocity(&newVel);
     }
     // If weapon type is axe or knife, add rotation
-    if (m_rightHandItem->GetAttributeDataPtr<int>("itemType") == Item_Weapon_Axe)
+    if (m_rightHandItem->GetAttributeData(ATTR_ITEM_TYPE) == Item_Weapon_Axe)
     {
         btVector3 angVel = btVector3(strength, 0.0f, 0.0f) * strength;
         if (itemPhysComp) itemPhysComp->setAngularVelocity(&angVel);
     }
-    else if (m_rightHandItem->GetAttributeDataPtr<int>("itemType") == Item_Grenade)
+    else if (m_rightHandItem->GetAttributeData(ATTR_ITEM_TYPE) == Item_Grenade)
     {
-        ExplosiveComponent* explosive = (ExplosiveComponent*)_entityManager.getComponent(rhiID, "Explosive");
+        ExplosiveComponent* explosive = _entityManager.getComponent<ExplosiveComponent>(rhiID);
         if (explosive) explosive->activate();
     }
-    m_rightHandItem->GetAttributeDataPtr<glm::vec3>("velocity") = glm::vec3(0, 0, 0);
-    m_rightHandItem->GetAttributeDataPtr<bool>("generateCollisions") = true;
-    m_rightHandItem->GetAttributeDataPtr<int>("ownerID") = 0;
+    m_rightHandItem->GetAttributeData(ATTR_VELOCITY) = glm::vec3(0, 0, 0);
+    m_rightHandItem->GetAttributeData(ATTR_GENERATE_COLLISIONS) = true;
+    m_rightHandItem->GetAttributeData(ATTR_OWNER_ID) = 0;
     m_rightHandItem = nullptr;
-    m_owner->GetAttributeDataPtr<int>("rightHandItemID") = 0;
+    m_owner->GetAttributeData(ATTR_RIGHT_HAND_ITEM_ID) = 0;
 
     Log::Debug("Player %i threw object %i", _ownerID, rhiID);
 
@@ -803,21 +804,21 @@ void HumanoidComponent::ThrowItem( const glm::vec3 targetPos )
 void HumanoidComponent::UseRightHand()
 {
     Entity* m_owner = _entityManager.getEntity(_ownerID);
-    rHandTimer = m_owner->GetAttributeDataPtr<float>("lifeTime");
+    rHandTimer = m_owner->GetAttributeData(ATTR_LIFE_TIME);
 
     if (!m_rightHandItem)
     {
         return;
     }
-    if (m_rightHandItem->GetAttributeDataPtr<int>("itemType") == Item_Potion_Health)
+    if (m_rightHandItem->GetAttributeData(ATTR_ITEM_TYPE) == Item_Potion_Health)
     {
         rightArmAnimState = ArmState::Arm_Holding;
     }
     else
     {
         rightArmAnimState = ArmState::Arm_Swinging;
-        m_rightHandItem->GetAttributeDataPtr<glm::vec3>("velocity") = glm::vec3(0, 10.0f, 0);
-        m_rightHandItem->GetAttributeDataPtr<bool>("generateCollisions") = true;
+        m_rightHandItem->GetAttributeData(ATTR_VELOCITY) = glm::vec3(0, 10.0f, 0);
+        m_rightHandItem->GetAttributeData(ATTR_GENERATE_COLLISIONS) = true;
     }
 }
 
@@ -828,8 +829,8 @@ void HumanoidComponent::WieldNextItemFromBackpack()
         return;
     }
 
-    const int backPackID = m_backpack->GetAttributeDataPtr<int>("ID");
-    if (InventoryComponent* inventoryC = (InventoryComponent*)_entityManager.getComponent(backPackID, "Inventory"))
+    const int backPackID = m_backpack->GetAttributeData(ATTR_ID);
+    if (InventoryComponent* inventoryC = _entityManager.getComponent<InventoryComponent>(backPackID))
     {
         const std::vector<Entity*> items = inventoryC->getInventory();
         if (items.empty())
@@ -863,12 +864,12 @@ void HumanoidComponent::Die()
         {
             continue;
         }
-        const EntityID itemID = (EntityID)item->GetAttributeDataPtr<int>("ID");
-        if (PhysicsComponent* pComp = (PhysicsComponent*)_entityManager.getComponent(itemID, "Physics"))
+        const EntityID itemID = (EntityID)item->GetAttributeData(ATTR_ID);
+        if (PhysicsComponent* pComp = _entityManager.getComponent<PhysicsComponent>(itemID))
         {
             pComp->setPhysicsMode(PhysicsMode::Physics_Cube_AABBs, false, false);
         }
-        item->GetAttributeDataPtr<int>("ownerID") = 0;
+        item->GetAttributeData(ATTR_OWNER_ID) = 0;
     }
 
     //cleanup in the reverse order of creation/initialization
@@ -881,17 +882,26 @@ void HumanoidComponent::Die()
 
 void HumanoidComponent::removeAllVoxelMeshInstances(bool spawnAsDebris)
 {
-    static std::vector<std::string> PART_NAMES = {
-        "torso", "head", "leftFoot", "rightFoot", "leftArm", "rightArm"
+    struct PartKeys {
+        const AttributeKey<int>& id;
+        const AttributeKey<std::string>& object;
+    };
+    static const PartKeys PARTS[] = {
+        { ATTR_TORSO_ID, ATTR_TORSO_OBJECT },
+        { ATTR_HEAD_ID, ATTR_HEAD_OBJECT },
+        { ATTR_LEFT_FOOT_ID, ATTR_LEFT_FOOT_OBJECT },
+        { ATTR_RIGHT_FOOT_ID, ATTR_RIGHT_FOOT_OBJECT },
+        { ATTR_LEFT_ARM_ID, ATTR_LEFT_ARM_OBJECT },
+        { ATTR_RIGHT_ARM_ID, ATTR_RIGHT_ARM_OBJECT },
     };
 
     Entity* owner = _entityManager.getEntity(_ownerID);
-    for (const auto& partName : PART_NAMES)
+    for (const PartKeys& part : PARTS)
     {
-        const int partID = owner->GetAttributeDataPtr<int>(partName + "ID");
+        const int partID = owner->GetAttributeData(part.id);
         if (partID > 0)
         {
-            const std::string object = owner->GetAttributeDataPtr<std::string>(partName + "Object");
+            const std::string object = owner->GetAttributeData(part.object);
             if (spawnAsDebris)
             {
                 const glm::vec3 pos = _voxels.getInstance(object, partID)->position;
@@ -899,11 +909,11 @@ void HumanoidComponent::removeAllVoxelMeshInstances(bool spawnAsDebris)
                 const std::string newName = "Debris_" + intToString(Entity::GetNextEntityID());
                 const EntityID newEntID = _entityManager.addEntity(newName);
                 Entity* newEnt = _entityManager.getEntity(newEntID);
-                newEnt->GetAttributeDataPtr<int>("ownerID") = 0;
-                newEnt->GetAttributeDataPtr<int>("type") = ENTITY_DEBRIS;
-                newEnt->GetAttributeDataPtr<glm::vec3>("position") = pos;
-                newEnt->GetAttributeDataPtr<glm::quat>("rotation") = rot;
-                newEnt->GetAttributeDataPtr<std::string>("objectFile") = object;
+                newEnt->GetAttributeData(ATTR_OWNER_ID) = 0;
+                newEnt->GetAttributeData(ATTR_TYPE) = ENTITY_DEBRIS;
+                newEnt->GetAttributeData(ATTR_POSITION) = pos;
+                newEnt->GetAttributeData(ATTR_ROTATION) = rot;
+                newEnt->GetAttributeData(ATTR_OBJECT_FILE) = object;
                 PhysicsComponent* physComponent = CUSTOM_NEW(PhysicsComponent, _entityManager.getAllocator())(newEntID, _entityManager, _physics, _voxels);
                 _entityManager.setComponent(newEntID, physComponent);
                 physComponent->setPhysicsMode(PhysicsMode::Physics_Cube_AABBs, false, false);
@@ -1,4 +1,5 @@
 #include "ItemComponent.h"
+#include "EntityAttributes.h"
 
 #include "EntityManager.h"
 #include "HealthComponent.h"
@@ -20,19 +21,19 @@ _particles(particles)
 {
     Entity* _owner = _entityManager.getEntity(_ownerID);
     
-    _owner->GetAttributeDataPtr<int>("type") = ENTITY_ITEM;
+    _owner->GetAttributeData(ATTR_TYPE) = ENTITY_ITEM;
 
-    if ( !_owner->HasAttribute("ownerID") ) {
-        _owner->GetAttributeDataPtr<int>("ownerID") = 0;
+    if ( !_owner->HasAttribute(ATTR_OWNER_ID) ) {
+        _owner->GetAttributeData(ATTR_OWNER_ID) = 0;
     }
-    if ( !_owner->HasAttribute("itemType") ) {
-        _owner->GetAttributeDataPtr<int>("itemType") = Item_None;
+    if ( !_owner->HasAttribute(ATTR_ITEM_TYPE) ) {
+        _owner->GetAttributeData(ATTR_ITEM_TYPE) = Item_None;
     }
-    if ( !_owner->HasAttribute("damage") ) {
-        _owner->GetAttributeDataPtr<int>("damage") = 0;
+    if ( !_owner->HasAttribute(ATTR_DAMAGE) ) {
+        _owner->GetAttributeData(ATTR_DAMAGE) = 0;
     }
-    if ( !_owner->HasAttribute("healing") ) {
-        _owner->GetAttributeDataPtr<int>("healing") = 0;
+    if ( !_owner->HasAttribute(ATTR_HEALING) ) {
+        _owner->GetAttributeData(ATTR_HEALING) = 0;
     }
 }
 
@@ -47,9 +48,9 @@ void ItemComponent::hitEntity(Entity* entityB,
                               glm::vec3 position)
 {
     Entity* m_owner = _entityManager.getEntity(_ownerID);
-    int ownerIDA = m_owner->GetAttributeDataPtr<int>("ownerID");
-    int ownerIDB = entityB->GetAttributeDataPtr<int>("ownerID");
-    int IDB = entityB->GetAttributeDataPtr<int>("ID");
+    int ownerIDA = m_owner->GetAttributeData(ATTR_OWNER_ID);
+    int ownerIDB = entityB->GetAttributeData(ATTR_OWNER_ID);
+    int IDB = entityB->GetAttributeData(ATTR_ID);
 
     if ( ownerIDA == ownerIDB ||
         ownerIDA == IDB ) {  // Same owner, cancel?
@@ -61,23 +62,23 @@ void ItemComponent::hitEntity(Entity* entityB,
         Log::Debug("[ItemComponent] (entity %i, owner %i) hit %i, owned by %i", _ownerID, ownerIDA, IDB, ownerIDB);
     }
     
-    int aDamage = m_owner->GetAttributeDataPtr<int>("damage");  // Check if item does damage
+    int aDamage = m_owner->GetAttributeData(ATTR_DAMAGE);  // Check if item does damage
     if ( aDamage != 0 ) 
     {   // Calculate damage from velocity
         float velDamage = velocity.length();
         if ( velDamage > 1.0f ) 
         {
             velDamage = velDamage * 2.0f;
-            HealthComponent* healthB = (HealthComponent*)_entityManager.getComponent(ownerIDB, "Health");
+            HealthComponent* healthB = _entityManager.getComponent<HealthComponent>(ownerIDB);
             if ( healthB ) 
             {
                 healthB->takeDamage(aDamage*velDamage, m_owner);
                 std::string dmgText = intToString(aDamage*velDamage);
-                glm::vec3 bPos = entityB->GetAttributeDataPtr<glm::vec3>("position")+glm::vec3(0.0f,1.0f,0.0f);
+                glm::vec3 bPos = entityB->GetAttributeData(ATTR_POSITION)+glm::vec3(0.0f,1.0f,0.0f);
                 //_text->AddText(dmgText, bPos, false, 40, FONT_PIXEL, 2.0f, COLOR_RED);
                 // TODO: ADD TEXT ANIMATION ( FLOAT UP AND FAED OUT )
             }
-            int bType = entityB->GetAttributeDataPtr<int>("type");
+            int bType = entityB->GetAttributeData(ATTR_TYPE);
             if ( bType == ENTITY_ITEM )
             {   // Item collided with another item
                 // Item on item collision, throw sparks!
@@ -103,14 +104,13 @@ void ItemComponent::hitEntity(Entity* entityB,
         }   // entity has velocity over threshold
     }   // entity does damage
     
-    int aHealth = m_owner->GetAttributeDataPtr<int>("health");  // Check if item does health
+    int aHealth = m_owner->GetAttributeData(ATTR_HEALTH);  // Check if item does health
     if ( aHealth != 0 ) {   // Add health
-        HealthComponent* healthB = (HealthComponent*)_entityManager.getComponent(ownerIDB,
-                                                                                                 "Health");
+        HealthComponent* healthB = _entityManager.getComponent<HealthComponent>(ownerIDB);
         if ( healthB ) {
             healthB->addHealth(aHealth, m_owner);
             std::string healthText = intToString(aHealth);
-            glm::vec3 bPos = entityB->GetAttributeDataPtr<glm::vec3>("position");
+            glm::vec3 bPos = entityB->GetAttributeData(ATTR_POSITION);
             //_text->AddText(healthText,
             //                                     bPos + glm::vec3(0.0f,1.0f,0.0f),
             //                                     false,
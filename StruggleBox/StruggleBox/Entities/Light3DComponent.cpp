@@ -2,6 +2,7 @@
 
 #include "EntityManager.h"
 #include "Entity.h"
+#include "EntityAttributes.h"
 #include "VoxelRenderer.h"
 
 Light3DComponent::Light3DComponent(
@@ -26,8 +27,8 @@ Light3DComponent::~Light3DComponent()
 void Light3DComponent::update(const double delta)
 {
 	Entity* m_owner = _entityManager.getEntity(_ownerID);
-	glm::vec3 ownerPos = m_owner->GetAttributeDataPtr<glm::vec3>("position");
-	glm::quat ownerRot = m_owner->GetAttributeDataPtr<glm::quat>("rotation");
+	glm::vec3 ownerPos = m_owner->GetAttributeData(ATTR_POSITION);
+	glm::quat ownerRot = m_owner->GetAttributeData(ATTR_ROTATION);
 	glm::vec3 lightPos = ownerPos + (ownerRot*offset);
 	_light.position.x = lightPos.x;
 	_light.position.y = lightPos.y;
@@ -4,6 +4,7 @@
 #include "ParticleSystem.h"
 #include "World3D.h"
 #include "Entity.h"
+#include "EntityAttributes.h"
 
 ParticleComponent::ParticleComponent(
 	const int ownerID,
@@ -22,15 +23,15 @@ ParticleComponent::ParticleComponent(
 		_particleSys = _particles.getSystemByID(m_particleSystemID);
 		offset = glm::vec3();
 		Entity* m_owner = _entityManager.getEntity(_ownerID);
-		m_owner->GetAttributeDataPtr<std::string>("particleFile") = fileName;
+		m_owner->GetAttributeData(ATTR_PARTICLE_FILE) = fileName;
 	}
 	else
 	{    // No filename given, load from attributes
 		Entity* m_owner = _entityManager.getEntity(_ownerID);
-		std::string particleFile = m_owner->GetAttributeDataPtr<std::string>("particleFile");
+		std::string particleFile = m_owner->GetAttributeData(ATTR_PARTICLE_FILE);
 		m_particleSystemID = _particles.create(FileUtil::GetPath().append("Data/Particles/"), particleFile);
 		_particleSys = _particles.getSystemByID(m_particleSystemID);
-		offset = m_owner->GetAttributeDataPtr<glm::vec3>("particleOffset");
+		offset = m_owner->GetAttributeData(ATTR_PARTICLE_OFFSET);
 	}
 }
 
@@ -50,8 +51,8 @@ void ParticleComponent::update(const double delta)
 		return;
 	}
 	Entity* m_owner = _entityManager.getEntity(_ownerID);
-	glm::vec3 ownerPos = m_owner->GetAttributeDataPtr<glm::vec3>("position");
-	glm::quat ownerRot = m_owner->GetAttributeDataPtr<glm::quat>("rotation");
+	glm::vec3 ownerPos = m_owner->GetAttributeData(ATTR_POSITION);
+	glm::quat ownerRot = m_owner->GetAttributeData(ATTR_ROTATION);
 	_particleSys->setPosition(ownerPos + (ownerRot * offset));
 }
 
@@ -1,4 +1,5 @@
 #include "PhysicsComponent.h"
+#include "EntityAttributes.h"
 
 #include "VoxelCache.h"
 #include "EntityManager.h"
@@ -64,9 +65,9 @@ struct ContactSensorCallback : public btCollisionWorld::ContactResultCallback {
 		}
 
 		if (entityA != NULL && entityB != NULL) {
-			//      std::string aName = entityA->GetAttributeDataPtr<std::string>("name");
-			//      std::string bName = entityB->GetAttributeDataPtr<std::string>("name");
-			int aType = entityA->GetAttributeDataPtr<int>("type");
+			//      std::string aName = entityA->GetAttributeData(ATTR_NAME);
+			//      std::string bName = entityB->GetAttributeData(ATTR_NAME);
+			int aType = entityA->GetAttributeData(ATTR_TYPE);
 			if (aType == ENTITY_ITEM) {   // Item collided with entity
 				btVector3 velA = colObj0->m_collisionObject->getInterpolationLinearVelocity();
 				const float velFactor = velA.length();
@@ -108,20 +109,20 @@ PhysicsComponent::PhysicsComponent(
 	, m_timeAccumulator(0.0)
 {
 	Entity* m_owner = _manager.getEntity(_ownerID);
-	if (!m_owner->HasAttribute("scale"))
+	if (!m_owner->HasAttribute(ATTR_SCALE))
 	{
-		glm::vec3& scale = m_owner->GetAttributeDataPtr<glm::vec3>("scale");
+		glm::vec3& scale = m_owner->GetAttributeData(ATTR_SCALE);
 		scale = glm::vec3(0.1f);
 	}
-	//if (m_owner->HasAttribute("physics"))
+	//if (m_owner->HasAttribute(ATTR_PHYSICS))
 	//{
-	//	int& pMode = m_owner->GetAttributeDataPtr<int>("physics");
+	//	int& pMode = m_owner->GetAttributeData(ATTR_PHYSICS);
 		//Log::Debug("[PhysComponent] had physics type %i, owner: %i", pMode, _ownerID);
 		//setPhysicsMode(pMode, false, false);
 		//pMode = (int)PhysicsMode::Physics_Off;
 	//}
 
-	m_owner->GetAttributeDataPtr<int>("physics") = (int)PhysicsMode::Physics_Off;
+	m_owner->GetAttributeData(ATTR_PHYSICS) = (int)PhysicsMode::Physics_Off;
 }
 
 PhysicsComponent::~PhysicsComponent()
@@ -131,12 +132,7 @@ PhysicsComponent::~PhysicsComponent()
 
 void PhysicsComponent::clearPhysics()
 {
-	if (m_shapeID)
-	{
-		m_physics.removeShape(m_shapeID);
-		m_shapeID = 0;
-		m_shape = nullptr;
-	}
+	// The body goes first, it points to the shape until it's deleted
 	if (m_bodyID)
 	{
 		m_physics.removeBodyFromWorld(m_body);
@@ -144,13 +140,19 @@ void PhysicsComponent::clearPhysics()
 		m_bodyID = 0;
 		m_body = nullptr;
 	}
+	if (m_shapeID)
+	{
+		m_physics.removeShape(m_shapeID);
+		m_shapeID = 0;
+		m_shape = nullptr;
+	}
 	Log::Debug("PhysicsComponent::clearPhysics cleared for entity %i", _ownerID);
 }
 
 void PhysicsComponent::setPhysicsMode(PhysicsMode newMode, bool isStatic, bool trigger)
 {
 	Entity* owner = _manager.getEntity(_ownerID);
-	const PhysicsMode oldMode = (PhysicsMode)owner->GetAttributeDataPtr<int>("physics");
+	const PhysicsMode oldMode = (PhysicsMode)owner->GetAttributeData(ATTR_PHYSICS);
 
 	if (oldMode == newMode)
 	{
@@ -182,16 +184,16 @@ void PhysicsComponent::setPhysicsMode(PhysicsMode newMode, bool isStatic, bool t
 
 	if (newMode == PhysicsMode::Physics_Off)
 	{
-		owner->GetAttributeDataPtr<int>("physics") = (int)PhysicsMode::Physics_Off;
+		owner->GetAttributeData(ATTR_PHYSICS) = (int)PhysicsMode::Physics_Off;
 		return;
 	}
 
 	const bool requiresObjectFile = requiresVoxelFile(newMode);
 
-	if (requiresObjectFile && !owner->HasAttribute("objectFile"))
+	if (requiresObjectFile && !owner->HasAttribute(ATTR_OBJECT_FILE))
 	{
 		Log::Error("[PhysicsComponent] no object file for physics, owner %i", _ownerID);
-		owner->GetAttributeDataPtr<int>("physics") = (int)PhysicsMode::Physics_Off;
+		owner->GetAttributeData(ATTR_PHYSICS) = (int)PhysicsMode::Physics_Off;
 		return;
 	}
 
@@ -205,46 +207,46 @@ void PhysicsComponent::setPhysicsMode(PhysicsMode newMode, bool isStatic, bool t
 			m_body->setCollisionFlags(m_body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
 		}
 
-		owner->GetAttributeDataPtr<int>("physics") = (int)newMode;
+		owner->GetAttributeData(ATTR_PHYSICS) = (int)newMode;
 	}
 	else
 	{
-		owner->GetAttributeDataPtr<int>("physics") = (int)PhysicsMode::Physics_Off;
+		owner->GetAttributeData(ATTR_PHYSICS) = (int)PhysicsMode::Physics_Off;
 	}
 
-	Log::Debug("PhysicsComponent::setPhysicsMode mode %i set for entity %i", owner->GetAttributeDataPtr<int>("physics"), _ownerID);
+	Log::Debug("PhysicsComponent::setPhysicsMode mode %i set for entity %i", owner->GetAttributeData(ATTR_PHYSICS), _ownerID);
 }
 
 void PhysicsComponent::update(const double deltaTime)
 {
 	Entity* owner = _manager.getEntity(_ownerID);
-	const PhysicsMode physicsMode = (PhysicsMode)owner->GetAttributeDataPtr<int>("physics");
+	const PhysicsMode physicsMode = (PhysicsMode)owner->GetAttributeData(ATTR_PHYSICS);
 	if (physicsMode == PhysicsMode::Physics_Off || !m_body)
 	{
 		return;
 	}
 	btTransform& trans = m_body->getWorldTransform();
-	const bool updatePhysics = owner->GetAttributeDataPtr<int>("ownerID") == 0 && deltaTime != 0.0;
+	const bool updatePhysics = owner->GetAttributeData(ATTR_OWNER_ID) == 0 && deltaTime != 0.0;
 	if (updatePhysics)
 	{
 		// Move entity to physics object position
 		btVector3 physPos = trans.getOrigin();
 		btQuaternion physRot = trans.getRotation();
-		owner->GetAttributeDataPtr<glm::vec3>("position") = glm::vec3(physPos.x(), physPos.y(), physPos.z());
+		owner->GetAttributeData(ATTR_POSITION) = glm::vec3(physPos.x(), physPos.y(), physPos.z());
 		// Swizzle rotation as Bullet stores it in YZWX order (get WXYZ to restore XYZW order)
-		owner->GetAttributeDataPtr<glm::quat>("rotation") = glm::quat(physRot.w(), physRot.x(), physRot.y(), physRot.z());
+		owner->GetAttributeData(ATTR_ROTATION) = glm::quat(physRot.w(), physRot.x(), physRot.y(), physRot.z());
 	}
 	else if (m_body)
 	{
 		// Force positions of physics object
-		const glm::vec3 position = owner->GetAttributeDataPtr<glm::vec3>("position");
+		const glm::vec3 position = owner->GetAttributeData(ATTR_POSITION);
 		setPosition(position);
-		const glm::quat rotation = owner->GetAttributeDataPtr<glm::quat>("rotation");
+		const glm::quat rotation = owner->GetAttributeData(ATTR_ROTATION);
 		setRotation(rotation);
-		const glm::vec3 velocity = owner->GetAttributeDataPtr<glm::vec3>("velocity");
+		const glm::vec3 velocity = owner->GetAttributeData(ATTR_VELOCITY);
 		m_body->setLinearVelocity(btVector3(velocity.x, velocity.y, velocity.z));
 	}
-	if (m_body && owner->GetAttributeDataPtr<bool>("generateCollisions"))
+	if (m_body && owner->GetAttributeData(ATTR_GENERATE_COLLISIONS))
 	{
 		m_timeAccumulator += deltaTime;
 		if (m_timeAccumulator > contactResponseFrequency)
@@ -328,8 +330,8 @@ void PhysicsComponent::addContactToFilter(Entity*newContact)
 void PhysicsComponent::createShape(const PhysicsMode mode)
 {
 	Entity* owner = _manager.getEntity(_ownerID);
-	const std::string& objectFileName = owner->GetAttributeDataPtr<std::string>("objectFile");
-	const glm::vec3 scale = owner->GetAttributeDataPtr<glm::vec3>("scale");
+	const std::string& objectFileName = owner->GetAttributeData(ATTR_OBJECT_FILE);
+	const glm::vec3 scale = owner->GetAttributeData(ATTR_SCALE);
 
 	if (mode == PhysicsMode::Physics_Cube_Mesh)
 	{
@@ -365,7 +367,7 @@ void PhysicsComponent::createShape(const PhysicsMode mode)
 	}
 	else if (mode == PhysicsMode::Physics_Sphere)
 	{
-		const float radius = owner->GetAttributeDataPtr<float>("sphereRadius");
+		const float radius = owner->GetAttributeData(ATTR_SPHERE_RADIUS);
 		m_shapeID = m_physics.createSphere(radius);
 	}
 	m_shape = m_physics.getShapeForID(m_shapeID);
@@ -374,8 +376,8 @@ void PhysicsComponent::createShape(const PhysicsMode mode)
 void PhysicsComponent::createBody(const bool isStatic)
 {
 	Entity* owner = _manager.getEntity(_ownerID);
-	const glm::vec3 position = owner->GetAttributeDataPtr<glm::vec3>("position");
-	const glm::quat rotation = owner->GetAttributeDataPtr<glm::quat>("rotation");
+	const glm::vec3 position = owner->GetAttributeData(ATTR_POSITION);
+	const glm::quat rotation = owner->GetAttributeData(ATTR_ROTATION);
 	const float mass = isStatic ? 0.f : 1.f;
 	const float restitution = 0.25f;
 	const float friction = 0.75f;
@@ -2,6 +2,7 @@
 
 #include "EntityManager.h"
 #include "Entity.h"
+#include "EntityAttributes.h"
 #include "VoxelRenderer.h"
 
 RenderComponent::RenderComponent(
@@ -28,7 +29,7 @@ void RenderComponent::update(const double delta)
 		return;
 	}
 	Entity* owner = m_entityManager.getEntity(_ownerID);
-	const glm::vec3 pos = owner->GetAttributeDataPtr<glm::vec3>("position");
+	const glm::vec3 pos = owner->GetAttributeData(ATTR_POSITION);
 
 	//if (m_type == RenderComponentType::Type_Sprite_Sphere)
 	//{
@@ -39,8 +40,8 @@ void RenderComponent::update(const double delta)
 	//}
 	//else if (m_type == RenderComponentType::Type_Sprite_Fireball)
 	//{
-	//	const float radius = owner->GetAttributeDataPtr<float>("sphereRadius");
-	//	const float lifeTime = owner->GetAttributeDataPtr<float>("lifeTime");
+	//	const float radius = owner->GetAttributeData(ATTR_SPHERE_RADIUS);
+	//	const float lifeTime = owner->GetAttributeData(ATTR_LIFE_TIME);
 	//	SphereVertexData sphere = { pos.x, pos.y, pos.z, radius * 2.f,
 	//		lifeTime * 2.f, 0.f
 	//	};
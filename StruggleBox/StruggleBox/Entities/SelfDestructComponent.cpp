@@ -2,6 +2,7 @@
 
 #include "EntityManager.h"
 #include "Entity.h"
+#include "EntityAttributes.h"
 
 SelfDestructComponent::SelfDestructComponent(
 	const int ownerID,
@@ -19,7 +20,7 @@ SelfDestructComponent::~SelfDestructComponent()
 void SelfDestructComponent::update(const double delta)
 {
 	Entity* owner = _entityManager.getEntity(_ownerID);
-	const float lifeTime = owner->GetAttributeDataPtr<float>("lifeTime");
+	const float lifeTime = owner->GetAttributeData(ATTR_LIFE_TIME);
 
 	if (m_timeToDestruct != 0.f && lifeTime >= m_timeToDestruct)
 	{
@@ -0,0 +1,118 @@
+#include "SpatialHashGrid.h"
+#include <cmath>
+
+const int CELL_KEY_BITS = 21;       // Per axis, three of them fit a 64 bit key
+const uint64_t CELL_KEY_MASK = (1ull << CELL_KEY_BITS) - 1;
+
+SpatialHashGrid::SpatialHashGrid(const float cellSize)
+	: m_cellSize(cellSize)
+	, m_invCellSize(1.f / cellSize)
+{
+}
+
+void SpatialHashGrid::update(const EntityID entityID, const glm::vec3& position)
+{
+	const uint64_t cellKey = getCellKey(toCell(position.x), toCell(position.y), toCell(position.z));
+	if (entityID >= m_entries.size())
+	{
+		m_entries.resize(entityID + 1, Entry{ 0, 0, false });
+	}
+	Entry& entry = m_entries[entityID];
+	if (entry.inGrid)
+	{
+		if (entry.cellKey == cellKey)
+		{
+			return;
+		}
+		remove(entityID);
+	}
+	std::vector<EntityID>& cell = m_cells[cellKey];
+	entry.cellKey = cellKey;
+	entry.indexInCell = (uint32_t)cell.size();
+	entry.inGrid = true;
+	cell.push_back(entityID);
+}
+
+void SpatialHashGrid::remove(const EntityID entityID)
+{
+	if (!contains(entityID))
+	{
+		return;
+	}
+	Entry& entry = m_entries[entityID];
+	auto cellIt = m_cells.find(entry.cellKey);
+	std::vector<EntityID>& cell = cellIt->second;
+	// Swap the last entity of the cell into the freed spot
+	const EntityID lastID = cell.back();
+	cell[entry.indexInCell] = lastID;
+	m_entries[lastID].indexInCell = entry.indexInCell;
+	cell.pop_back();
+	if (cell.empty())
+	{
+		m_cells.erase(cellIt);
+	}
+	entry.inGrid = false;
+}
+
+void SpatialHashGrid::clear()
+{
+	m_cells.clear();
+	m_entries.clear();
+}
+
+bool SpatialHashGrid::contains(const EntityID entityID) const
+{
+	return entityID < m_entries.size() && m_entries[entityID].inGrid;
+}
+
+size_t SpatialHashGrid::query(const glm::vec3& center, const float radius, std::vector<EntityID>& result) const
+{
+	const size_t startSize = result.size();
+	const int minX = toCell(center.x - radius), maxX = toCell(center.x + radius);
+	const int minY = toCell(center.y - radius), maxY = toCell(center.y + radius);
+	const int minZ = toCell(center.z - radius), maxZ = toCell(center.z + radius);
+	const size_t numCells = (size_t)(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+	if (numCells > m_cells.size())
+	{
+		// Huge radius, walking the occupied cells is cheaper than probing empty ones
+		for (const auto& pair : m_cells)
+		{
+			const int x = (int)((int64_t)(pair.first << (64 - CELL_KEY_BITS * 3)) >> (64 - CELL_KEY_BITS));
+			const int y = (int)((int64_t)(pair.first << (64 - CELL_KEY_BITS * 2)) >> (64 - CELL_KEY_BITS));
+			const int z = (int)((int64_t)(pair.first << (64 - CELL_KEY_BITS)) >> (64 - CELL_KEY_BITS));
+			if (x >= minX && x <= maxX && y >= minY && y <= maxY && z >= minZ && z <= maxZ)
+			{
+				result.insert(result.end(), pair.second.begin(), pair.second.end());
+			}
+		}
+		return result.size() - startSize;
+	}
+	for (int x = minX; x <= maxX; x++)
+	{
+		for (int y = minY; y <= maxY; y++)
+		{
+			for (int z = minZ; z <= maxZ; z++)
+			{
+				auto it = m_cells.find(getCellKey(x, y, z));
+				if (it != m_cells.end())
+				{
+					result.insert(result.end(), it->second.begin(), it->second.end());
+				}
+			}
+		}
+	}
+	return result.size() - startSize;
+}
+
+int SpatialHashGrid::toCell(const float coord) const
+{
+	return (int)std::floor(coord * m_invCellSize);
+}
+
+uint64_t SpatialHashGrid::getCellKey(const int x, const int y, const int z)
+{
+	// x in the high bits, z in the low bits, each as 21 bit two's complement
+	return (((uint64_t)x & CELL_KEY_MASK) << (CELL_KEY_BITS * 2)) |
+		(((uint64_t)y & CELL_KEY_MASK) << CELL_KEY_BITS) |
+		((uint64_t)z & CELL_KEY_MASK);
+}
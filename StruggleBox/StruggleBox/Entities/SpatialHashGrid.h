@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Entity.h"
+#include "GFXDefines.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Buckets EntityIDs by the grid cell their position falls in, cells live in
+// a hash map so the grid has no bounds and empty space costs nothing.
+// Queries return every entity in the cells a sphere overlaps, callers check
+// the exact distance against the entity's current position.
+class SpatialHashGrid
+{
+public:
+	SpatialHashGrid(const float cellSize);
+
+	// Inserts the entity or moves it to the cell of its new position
+	void update(const EntityID entityID, const glm::vec3& position);
+	void remove(const EntityID entityID);
+	void clear();
+
+	bool contains(const EntityID entityID) const;
+
+	// Appends the entities in all cells overlapping the sphere, returns how many were added
+	size_t query(const glm::vec3& center, const float radius, std::vector<EntityID>& result) const;
+
+	float getCellSize() const { return m_cellSize; }
+
+private:
+	struct Entry {
+		uint64_t cellKey;
+		uint32_t indexInCell;
+		bool inGrid;
+	};
+
+	const float m_cellSize;
+	const float m_invCellSize;
+	std::unordered_map<uint64_t, std::vector<EntityID>> m_cells;
+	std::vector<Entry> m_entries;       // By EntityID
+
+	int toCell(const float coord) const;
+	static uint64_t getCellKey(const int x, const int y, const int z);
+};
@@ -3,6 +3,7 @@
 //#include "InstancedTriangleMesh.h"
 #include "EntityManager.h"
 #include "Entity.h"
+#include "EntityAttributes.h"
 #include "Log.h"
 
 VoxelComponent::VoxelComponent(const int ownerID, const std::string& objectName, EntityManager& manager, VoxelCache& voxels)
@@ -13,18 +14,18 @@ VoxelComponent::VoxelComponent(const int ownerID, const std::string& objectName,
 {
 	Log::Debug("[VoxelComponent] constructor, instance at: %p", this);
     Entity* _owner = _manager.getEntity(_ownerID);
-    if ( !_owner->HasAttribute("objectFile") ) 
+    if ( !_owner->HasAttribute(ATTR_OBJECT_FILE) ) 
 	{
         if ( objectName.empty() ) 
 		{
-			_owner->GetAttributeDataPtr<std::string>("objectFile") = "UnknownObject";
+			_owner->GetAttributeData(ATTR_OBJECT_FILE) = "UnknownObject";
         }
 		else 
 		{
 			// Save the filename into an entity attribute
-            _owner->GetAttributeDataPtr<std::string>("objectFile") = objectName;
+            _owner->GetAttributeData(ATTR_OBJECT_FILE) = objectName;
         }
-        _owner->GetAttributeDataPtr<glm::vec3>("scale") = glm::vec3(0.1f);
+        _owner->GetAttributeData(ATTR_SCALE) = glm::vec3(0.1f);
     }
     loadObject();
 }
@@ -42,22 +43,22 @@ void VoxelComponent::loadObject()
 		return;
 	}
 	Entity* _owner = _manager.getEntity(_ownerID);
-	if (!_owner->HasAttribute("objectFile"))
+	if (!_owner->HasAttribute(ATTR_OBJECT_FILE))
 	{
 		Log::Error("[VoxelComponent] cant load object for owner %i, no object file attribute", _ownerID);
 		return;
 	}
-	const std::string objFileName = _owner->GetAttributeDataPtr<std::string>("objectFile");
+	const std::string objFileName = _owner->GetAttributeData(ATTR_OBJECT_FILE);
 
 	if (_instanceID == 0)
 	{
-		glm::vec3 position = _owner->GetAttributeDataPtr<glm::vec3>("position");
+		glm::vec3 position = _owner->GetAttributeData(ATTR_POSITION);
 		_instanceID = _voxels.addInstance(objFileName);
-		_owner->GetAttributeDataPtr<int>("instanceID") = _instanceID;
+		_owner->GetAttributeData(ATTR_INSTANCE_ID) = _instanceID;
 		Log::Debug("[VoxelComponent] new voxel instance, id %i for file %s", _instanceID, objFileName.c_str());
 
 		// Bounding box
-		glm::vec3& bb = _owner->GetAttributeDataPtr<glm::vec3>("bb");
+		glm::vec3& bb = _owner->GetAttributeData(ATTR_BB);
 		bb = _voxels.getVoxelData(objFileName)->getVolume(DEFAULT_VOXEL_MESHING_WIDTH);
 	}
 }
@@ -68,9 +69,9 @@ void VoxelComponent::unloadObject()
 		return;
 
 	Entity* _owner = _manager.getEntity(_ownerID);
-	const std::string objFileName = _owner->GetAttributeDataPtr<std::string>("objectFile");
+	const std::string objFileName = _owner->GetAttributeData(ATTR_OBJECT_FILE);
 	_voxels.removeInstance(objFileName, _instanceID);
-	_owner->GetAttributeDataPtr<int>("instanceID") = 0;
+	_owner->GetAttributeData(ATTR_INSTANCE_ID) = 0;
 	_instanceID = 0;
 }
 
@@ -79,11 +80,11 @@ void VoxelComponent::update(const double delta )
     if (_instanceID != 0)
 	{
         Entity* _owner = _manager.getEntity(_ownerID);
-		const std::string objFileName = _owner->GetAttributeDataPtr<std::string>("objectFile");
+		const std::string objFileName = _owner->GetAttributeData(ATTR_OBJECT_FILE);
 		ColoredInstanceTransform3DData* instance = _voxels.getInstance(objFileName, _instanceID);
-        instance->position = _owner->GetAttributeDataPtr<glm::vec3>("position");
-        instance->rotation = _owner->GetAttributeDataPtr<glm::quat>("rotation");
-        instance->scale = _owner->GetAttributeDataPtr<glm::vec3>("scale");
+        instance->position = _owner->GetAttributeData(ATTR_POSITION);
+        instance->rotation = _owner->GetAttributeData(ATTR_ROTATION);
+        instance->scale = _owner->GetAttributeData(ATTR_SCALE);
     }
 }
 
@@ -61,18 +61,17 @@ void ChunkTest::Initialize()
 	const size_t chunkSize = 16;
 	for (int i = 0; i < 2; i++)
 	{
-		const glm::vec3 offset = glm::vec3(i * 16, 0, 0);
 		Coord3D coord = Coord3D(i, 0, 0);
 		VoxelData* voxels = CUSTOM_NEW(VoxelData, m_allocator)(chunkSize, chunkSize, chunkSize, m_allocator);
 		voxels->generateFlatLand(coord);
 		if (!voxels->isEmpty())
 		{
 			const size_t numVoxels = chunkSize * chunkSize * chunkSize;
-			VoxelMeshPBRVertexData* tempVerts = (VoxelMeshPBRVertexData*)m_allocator.allocate(sizeof(VoxelMeshPBRVertexData) * numVoxels * 36);
+			VoxelChunkVertexData* tempVerts = (VoxelChunkVertexData*)m_allocator.allocate(sizeof(VoxelChunkVertexData) * numVoxels * 36);
 			size_t vertexCount = 0;
-			voxels->createTriangleMeshReduced(tempVerts, vertexCount, 0.5f, offset);
-			VoxelMeshPBRVertexData* verts = m_renderer.bufferVoxelChunkVerts(vertexCount, m_voxelMeshDrawDataIDs[0]);
-			memcpy(verts, tempVerts, sizeof(VoxelMeshPBRVertexData) * vertexCount);
+			voxels->createTriangleMeshPacked(tempVerts, vertexCount);
+			VoxelChunkVertexData* verts = m_renderer.bufferVoxelChunkVerts(vertexCount, m_voxelMeshDrawDataIDs[i]);
+			memcpy(verts, tempVerts, sizeof(VoxelChunkVertexData) * vertexCount);
 			m_allocator.deallocate(tempVerts);
 		}
 	}
@@ -122,9 +121,10 @@ void ChunkTest::Update(const double deltaTime)
 
 void ChunkTest::Draw()
 {
-	for (DrawDataID drawDataID : m_voxelMeshDrawDataIDs)
+	for (size_t i = 0; i < m_voxelMeshDrawDataIDs.size(); i++)
 	{
-		m_renderer.queueVoxelChunk(drawDataID);
+		const glm::vec3 origin = glm::vec3(i * 16.f, 0.f, 0.f) - glm::vec3(8.f);
+		m_renderer.queueVoxelChunk(m_voxelMeshDrawDataIDs[i], origin, 1.f);
 	}
 
 	m_renderer.flush();
@@ -167,6 +167,11 @@ bool ChunkTest::OnMouse(const glm::ivec2& coord)
 void ChunkTest::loadMaterials(const std::string& fileName)
 {
 	m_materialData.load(fileName);
+	for (uint32_t materialID = 1; materialID < 256; materialID++)
+	{
+		const MaterialDef& material = m_materialData[materialID];
+		m_renderer.setChunkMaterial(materialID, material.albedo, glm::vec3(material.roughness, material.metalness, 0.f));
+	}
 }
 
 void ChunkTest::saveMaterials(const std::string& fileName)
@@ -1,4 +1,5 @@
 #include "LocalGame.h"
+#include "EntityAttributes.h"
 
 #include "Allocator.h"
 #include "Camera3D.h"
@@ -135,8 +136,8 @@ void LocalGame::Update(const double delta)
     Entity* player = m_entityManager.getEntity(m_world.m_playerID);
     if (player)
     {
-        const glm::vec3& pPos = player->GetAttributeDataPtr<glm::vec3>("position");
-        const glm::quat& pRot = player->GetAttributeDataPtr<glm::quat>("rotation");
+        const glm::vec3& pPos = player->GetAttributeData(ATTR_POSITION);
+        const glm::quat& pRot = player->GetAttributeData(ATTR_ROTATION);
 
         const bool OVER_THE_SHOULDER_CAMERA = true;
         if (OVER_THE_SHOULDER_CAMERA)
@@ -168,10 +169,10 @@ void LocalGame::Draw()
     //Entity* player = _entityManager.getEntity(_world.playerID);
     //if (player)
     //{
-    //    const glm::vec3 pos = player->GetAttributeDataPtr<glm::vec3>("position");
+    //    const glm::vec3 pos = player->GetAttributeData(ATTR_POSITION);
         //m_renderer.getPlugin3D().bufferEmissive3DLine(pos, cursorWorldPos, COLOR_WHITE, COLOR_RED);
-			//glm::quat rot = player->GetAttributeDataPtr<glm::quat>("rotation");
-   //         int playerHealth = player->GetAttributeDataPtr<int>("health");
+			//glm::quat rot = player->GetAttributeData(ATTR_ROTATION);
+   //         int playerHealth = player->GetAttributeData(ATTR_HEALTH);
    //         _renderer.Draw2DProgressBar(pos+glm::vec3(0.0f,1.5f,0.0f), 100, 16, playerHealth/100.0f, COLOR_GREY, COLOR_GREEN);
    //}
 
@@ -208,14 +209,14 @@ bool LocalGame::OnEvent(const InputEvent event, const float amount)
         {
             if (Entity* player = m_entityManager.getEntity(m_world.m_playerID))
             {
-                HumanoidComponent* human = (HumanoidComponent*)m_entityManager.getComponent(m_world.m_playerID, "Humanoid");
+                HumanoidComponent* human = m_entityManager.getComponent<HumanoidComponent>(m_world.m_playerID);
                 if (human)
                 {
                     human->UseRightHand();
                 }
                 if (m_aiming)
                 {
-                    const glm::vec3 playerPos = player->GetAttributeDataPtr<glm::vec3>("position");
+                    const glm::vec3 playerPos = player->GetAttributeData(ATTR_POSITION);
                     const glm::vec3 vel = glm::normalize(cursorWorldPos - playerPos);
                     const uint32_t fireballID = m_world.createFireball(playerPos + (vel * 2.f), vel * 60.f, 0.5f);
                 }
@@ -224,7 +225,7 @@ bool LocalGame::OnEvent(const InputEvent event, const float amount)
         else if (event == InputEvent::Aim)
         {
             m_aiming = true;
-            if (HumanoidComponent* human = (HumanoidComponent*)m_entityManager.getComponent(m_world.m_playerID, "Humanoid"))
+            if (HumanoidComponent* human = m_entityManager.getComponent<HumanoidComponent>(m_world.m_playerID))
             {
                 human->ThrowStart();
             }
@@ -233,7 +234,7 @@ bool LocalGame::OnEvent(const InputEvent event, const float amount)
         {
             if (Entity* player = m_entityManager.getEntity(m_world.m_playerID))
             {
-                player->GetAttributeDataPtr<bool>("blocking") = true;
+                player->GetAttributeData(ATTR_BLOCKING) = true;
             }
         }
         else if (event == InputEvent::Pause)
@@ -244,14 +245,14 @@ bool LocalGame::OnEvent(const InputEvent event, const float amount)
         {
             if (Entity* player = m_entityManager.getEntity(m_world.m_playerID)) 
             {
-                player->GetAttributeDataPtr<bool>("running") = true;
+                player->GetAttributeData(ATTR_RUNNING) = true;
             } 
         }
         else if (event == InputEvent::Sneak)
         {
             if (Entity* player = m_entityManager.getEntity(m_world.m_playerID))
             {
-                player->GetAttributeDataPtr<bool>("sneaking") = true;
+                player->GetAttributeData(ATTR_SNEAKING) = true;
             }
         }
     }
@@ -260,7 +261,7 @@ bool LocalGame::OnEvent(const InputEvent event, const float amount)
         if (event == InputEvent::Aim)
         {
             m_aiming = false;
-            HumanoidComponent* human = (HumanoidComponent*)m_entityManager.getComponent(m_world.m_playerID, "Humanoid");
+            HumanoidComponent* human = m_entityManager.getComponent<HumanoidComponent>(m_world.m_playerID);
             if (human)
             {
                 human->ThrowItem(cursorWorldPos);
@@ -270,14 +271,14 @@ bool LocalGame::OnEvent(const InputEvent event, const float amount)
         {
             if (Entity* player = m_entityManager.getEntity(m_world.m_playerID))
             {
-                player->GetAttributeDataPtr<bool>("blocking") = false;
+                player->GetAttributeData(ATTR_BLOCKING) = false;
             }
         }
         else if (event == InputEvent::Run)
         {
             if (Entity* player = m_entityManager.getEntity(m_world.m_playerID))
             {
-                player->GetAttributeDataPtr<bool>("running") = false;
+                player->GetAttributeData(ATTR_RUNNING) = false;
             }
         }
         else if (event == InputEvent::Sneak)
@@ -285,7 +286,7 @@ bool LocalGame::OnEvent(const InputEvent event, const float amount)
             if (m_world.m_playerID && !m_world.paused )
             {
                 Entity* player = m_entityManager.getEntity(m_world.m_playerID);
-                player->GetAttributeDataPtr<bool>("sneaking")  = false;
+                player->GetAttributeData(ATTR_SNEAKING)  = false;
             }
         }
         else if (event == InputEvent::Inventory)
@@ -323,9 +324,9 @@ bool LocalGame::OnEvent(const InputEvent event, const float amount)
         {
             // Grab nearest item
             Entity* player = m_entityManager.getEntity(m_world.m_playerID);
-            HumanoidComponent* human = (HumanoidComponent*)m_entityManager.getComponent(m_world.m_playerID, "Humanoid");
+            HumanoidComponent* human = m_entityManager.getComponent<HumanoidComponent>(m_world.m_playerID);
             Entity* grabEntity = m_entityManager.getNearestEntity(
-                player->GetAttributeDataPtr<glm::vec3>("position"),
+                player->GetAttributeData(ATTR_POSITION),
                 m_world.m_playerID,
                 ENTITY_ITEM);
             if (grabEntity) {
@@ -362,7 +363,7 @@ bool LocalGame::OnEvent(const InputEvent event, const float amount)
     {
         if (Entity* player = m_entityManager.getEntity(m_world.m_playerID)) 
         {
-            player->GetAttributeDataPtr<bool>("jumping") = (amount > 0.5f);
+            player->GetAttributeData(ATTR_JUMPING) = (amount > 0.5f);
         }
     }
     //else if (event == InputEvent::Look_Down) 
@@ -402,7 +403,7 @@ bool LocalGame::OnMouse(const glm::ivec2 &coord)
             rotationY *= -1.0f;
         }
 
-        HumanoidComponent* human = (HumanoidComponent*)m_entityManager.getComponent(m_world.m_playerID, "Humanoid");
+        HumanoidComponent* human = m_entityManager.getComponent<HumanoidComponent>(m_world.m_playerID);
         if (human && !m_renderer.getDefaultCamera().getThirdPerson())
         {
             human->Rotate(rotationX, rotationY);
@@ -473,32 +474,39 @@ void LocalGame::UpdateMovement()
         if (m_renderer.getDefaultCamera().getThirdPerson())
         {
             const glm::vec3 direction = glm::rotateY(glm::vec3(joyMoveInput.x, 0.0f, joyMoveInput.y), m_renderer.getDefaultCamera().getRotation().y);
-            player->GetAttributeDataPtr<glm::vec3>("direction") = direction;
+            player->GetAttributeData(ATTR_DIRECTION) = direction;
             if (m_aiming)
             {
-                HumanoidComponent* human = (HumanoidComponent*)m_entityManager.getComponent(m_world.m_playerID, "Humanoid");
+                HumanoidComponent* human = m_entityManager.getComponent<HumanoidComponent>(m_world.m_playerID);
                 human->Rotate(glm::quat(glm::vec3(0.f, m_renderer.getDefaultCamera().getRotation().y - M_PI, 0.f)));
             }
         }
         else 
         {
-            glm::vec3& moveInput = player->GetAttributeDataPtr<glm::vec3>("moveInput");
+            glm::vec3& moveInput = player->GetAttributeData(ATTR_MOVE_INPUT);
             moveInput.x = joyMoveInput.x;
             moveInput.y = joyMoveInput.y;
         }
 
         Entity* player = m_entityManager.getEntity(m_world.m_playerID);
-        glm::vec3& lookDir = player->GetAttributeDataPtr<glm::vec3>("lookDirection");
+        glm::vec3& lookDir = player->GetAttributeData(ATTR_LOOK_DIRECTION);
         lookDir = m_renderer.getDefaultCamera().getRotation();
     }
 }
 
 void LocalGame::SaveWorld(const std::string fileName)
 {
+    // Chunks stream to the region files of the loaded world, it can only be saved in place
+    if (!fileName.empty() && fileName != m_world.worldName)
+    {
+        Log::Warn("[LocalGame] Can't save world %s as %s, saving in place", m_world.worldName.c_str(), fileName.c_str());
+    }
+    m_world.saveWorld();
 }
 
 void LocalGame::LoadWorld(const std::string fileName)
 {
+    m_world.loadWorld(fileName);
 }
 
 void LocalGame::onCollision(void* entityA, void* entityB, const glm::vec3& pos, float force)
@@ -523,7 +531,7 @@ void LocalGame::onEntityWorldCollision(Entity* entity, const glm::vec3& pos, flo
     {
         return;
     }
-    if (entity->GetAttributeDataPtr<int>("type") == ENTITY_PROJECTILE)
+    if (entity->GetAttributeData(ATTR_TYPE) == ENTITY_PROJECTILE)
     {
         //_world.AddParticleEntity("Sparks3D.plist", pos);
         const size_t randomAmount = /*(1.0 + Random::RandomDouble()) **/ (size_t)std::min<float>(32.f, force);
@@ -543,8 +551,8 @@ void LocalGame::onEntityWorldCollision(Entity* entity, const glm::vec3& pos, flo
 
 void LocalGame::onEntityEntityCollision(Entity* entityA, Entity* entityB, const glm::vec3& pos, float force)
 {
-    const int typeA = entityA->GetAttributeDataPtr<int>("type");
-    const int typeB = entityB->GetAttributeDataPtr<int>("type");
+    const int typeA = entityA->GetAttributeData(ATTR_TYPE);
+    const int typeB = entityB->GetAttributeData(ATTR_TYPE);
     if (typeA == ENTITY_PROJECTILE)
     {
         onProjectileImpact(entityA, entityB, pos, force);
@@ -557,15 +565,15 @@ void LocalGame::onEntityEntityCollision(Entity* entityA, Entity* entityB, const
 
 void LocalGame::onProjectileImpact(Entity* projectile, Entity* hitEntity, const glm::vec3& pos, float force)
 {
-    if (projectile->HasAttribute("done") &&
-        projectile->GetAttributeDataPtr<bool>("done"))
+    if (projectile->HasAttribute(ATTR_DONE) &&
+        projectile->GetAttributeData(ATTR_DONE))
     {
         return;
     }
     m_entityManager.destroyEntity(projectile->GetID());
-    projectile->GetAttributeDataPtr<bool>("done") = true;
+    projectile->GetAttributeData(ATTR_DONE) = true;
 
-    const glm::vec3 projectilePos = projectile->GetAttributeDataPtr<glm::vec3>("position");
+    const glm::vec3 projectilePos = projectile->GetAttributeData(ATTR_POSITION);
     const size_t randomAmount = /*(1.0 + Random::RandomDouble()) **/ (size_t)std::min<float>(64.f, (2.f + force) * 20.f);
     const float CUBE_SIZE = 0.025f;
     for (size_t i = 0; i < randomAmount; i++)
@@ -581,7 +589,7 @@ void LocalGame::onProjectileImpact(Entity* projectile, Entity* hitEntity, const
 
     m_world.Explosion(projectilePos, 2.f, 30.f);
 
-    const int hitType = hitEntity->GetAttributeDataPtr<int>("type");
+    const int hitType = hitEntity->GetAttributeData(ATTR_TYPE);
     if (hitType == ENTITY_PROJECTILE)
     {
         m_entityManager.destroyEntity(hitEntity->GetID());
@@ -591,7 +599,7 @@ void LocalGame::onProjectileImpact(Entity* projectile, Entity* hitEntity, const
     if (hitType == ENTITY_SKELETON || hitType == ENTITY_HUMANOID)
     {
         m_world.AddParticleEntity("Blood3D.plist", pos);
-        if (HealthComponent* healthB = (HealthComponent*)m_entityManager.getComponent(hitEntity->GetID(), "Health"))
+        if (HealthComponent* healthB = m_entityManager.getComponent<HealthComponent>(hitEntity->GetID()))
         {
             healthB->takeDamage(150);
         }
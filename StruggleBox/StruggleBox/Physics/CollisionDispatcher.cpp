@@ -1,5 +1,6 @@
 #include "CollisionDispatcher.h"
 #include "Entity.h"
+#include "EntityAttributes.h"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
 #include "BulletCollision/BroadphaseCollision/btDispatcher.h"
 
@@ -22,14 +23,14 @@ bool CollisionDispatcher::needsCollision(
     Entity* ownerA = (Entity*)body0->getUserPointer();
     Entity* ownerB = (Entity*)body1->getUserPointer();
     if ( ownerA && ownerB ) {
-        int IDA = ownerA->GetAttributeDataPtr<int>("ID");
-        int ownerIDB = ownerB->GetAttributeDataPtr<int>("ownerID");
+        int IDA = ownerA->GetAttributeData(ATTR_ID);
+        int ownerIDB = ownerB->GetAttributeData(ATTR_OWNER_ID);
         if ( IDA == ownerIDB ) {
             return false;
         }
 
-        int IDB = ownerB->GetAttributeDataPtr<int>("ID");
-        int ownerIDA = ownerA->GetAttributeDataPtr<int>("ownerID");
+        int IDB = ownerB->GetAttributeData(ATTR_ID);
+        int ownerIDA = ownerA->GetAttributeData(ATTR_OWNER_ID);
         if ( IDB == ownerIDA ) {
             return false;
         }
@@ -51,14 +52,14 @@ bool CollisionDispatcher::needsResponse(
     Entity* ownerA = (Entity*)body0->getUserPointer();
     Entity* ownerB = (Entity*)body1->getUserPointer();
     if ( ownerA && ownerB ) {
-        int IDA = ownerA->GetAttributeDataPtr<int>("ID");
-        int ownerIDB = ownerB->GetAttributeDataPtr<int>("ownerID");
+        int IDA = ownerA->GetAttributeData(ATTR_ID);
+        int ownerIDB = ownerB->GetAttributeData(ATTR_OWNER_ID);
         if ( IDA == ownerIDB ) {
             return false;
         }
         
-        int IDB = ownerB->GetAttributeDataPtr<int>("ID");
-        int ownerIDA = ownerA->GetAttributeDataPtr<int>("ownerID");
+        int IDB = ownerB->GetAttributeData(ATTR_ID);
+        int ownerIDA = ownerA->GetAttributeData(ATTR_OWNER_ID);
         if ( IDB == ownerIDA ) {
             return false;
         }
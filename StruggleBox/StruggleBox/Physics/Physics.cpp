@@ -5,6 +5,7 @@
 #include "CollisionDispatcher.h"
 #include "Log.h"
 #include "PhysicsCube.h"
+#include "Profiler.h"
 
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
 #include <iostream>
@@ -12,7 +13,7 @@
 Physics* Physics::s_instance = nullptr;
 
 Physics::Physics(Allocator& allocator)
-    : m_allocator(allocator)
+    : m_allocator(allocator, MemoryTag::Physics)
     , m_broadphase(nullptr)
     , m_collisionConfiguration(nullptr)
     , m_dispatcher(nullptr)
@@ -52,6 +53,7 @@ Physics::~Physics()
 
 void Physics::Update(double delta) 
 {
+    PROFILE_SCOPE("Physics::Update");
     if (!m_dynamicsWorld)
     {
         return;
@@ -182,6 +184,24 @@ uint32_t Physics::createCompountShape()
     return m_nextShapeID;
 }
 
+void Physics::addChildShape(uint32_t compoundID, uint32_t childID, const btTransform& transform)
+{
+    btCompoundShape* compound = (btCompoundShape*)getShapeForID(compoundID);
+    btCollisionShape* child = getShapeForID(childID);
+    if (!compound || !compound->isCompound() || !child)
+    {
+        Log::Error("[Physics] can't add shape %u to compound %u", childID, compoundID);
+        return;
+    }
+    compound->addChildShape(transform, child);
+    // A child shared by several transforms is usually added in a row, it only needs recording once
+    std::vector<uint32_t>& children = m_compoundChildren[compoundID];
+    if (children.empty() || children.back() != childID)
+    {
+        children.push_back(childID);
+    }
+}
+
 uint32_t Physics::createTriangleMeshShape(btTriangleMesh* mesh, bool useQuantizedAABBs)
 {
     btBvhTriangleMeshShape* shape = CUSTOM_NEW(btBvhTriangleMeshShape, m_allocator)(mesh, useQuantizedAABBs);
@@ -273,11 +293,37 @@ void Physics::removeShape(uint32_t shapeID)
     auto it = m_shapes.find(shapeID);
     if (it == m_shapes.end())
     {
-        btCollisionShape* shape = it->second;
-        CUSTOM_DELETE(shape, m_allocator);
         return;
     }
+    btCollisionShape* shape = it->second;
     m_shapes.erase(it);
+
+    // Children added through addChildShape go with their compound, the rest of the shapes are left alone
+    auto childrenIt = m_compoundChildren.find(shapeID);
+    if (childrenIt != m_compoundChildren.end())
+    {
+        for (const uint32_t childID : childrenIt->second)
+        {
+            auto childIt = m_shapes.find(childID);
+            if (childIt != m_shapes.end())
+            {
+                CUSTOM_DELETE(childIt->second, m_allocator);
+                m_shapes.erase(childIt);
+            }
+        }
+        m_compoundChildren.erase(childrenIt);
+    }
+    // Triangle mesh shapes own the mesh they were made from, it goes with them
+    btTriangleMesh* mesh = nullptr;
+    if (shape->getShapeType() == TRIANGLE_MESH_SHAPE_PROXYTYPE)
+    {
+        mesh = (btTriangleMesh*)((btBvhTriangleMeshShape*)shape)->getMeshInterface();
+    }
+    CUSTOM_DELETE(shape, m_allocator);
+    if (mesh)
+    {
+        destroyTriangleMesh(mesh);
+    }
 }
 
 void Physics::removeBody(uint32_t bodyID)
@@ -285,15 +331,15 @@ void Physics::removeBody(uint32_t bodyID)
     auto it = m_bodies.find(bodyID);
     if (it == m_bodies.end())
     {
-        btRigidBody* body = it->second;
-        if (body->getMotionState())
-        {
-            CUSTOM_DELETE(body->getMotionState(), m_allocator);
-        }
-        CUSTOM_DELETE(body, m_allocator);
         return;
     }
+    btRigidBody* body = it->second;
     m_bodies.erase(it);
+    if (body->getMotionState())
+    {
+        CUSTOM_DELETE(body->getMotionState(), m_allocator);
+    }
+    CUSTOM_DELETE(body, m_allocator);
 }
 
 glm::vec3 Physics::cameraCollision(const glm::vec3& fromPos, const glm::vec3& toPos)
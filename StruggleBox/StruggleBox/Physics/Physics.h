@@ -2,6 +2,7 @@
 
 #include "btBulletDynamicsCommon.h"
 #include "PhysicsDebug.h"
+#include "TaggedAllocator.h"
 #include "BulletDynamics/Character/btKinematicCharacterController.h"
 #include <glm/glm.hpp>
 #include <vector>
@@ -38,6 +39,9 @@ public:
     uint32_t createSphere(const float size);
     uint32_t createCapsule(const float radius, const float height);
     uint32_t createCompountShape();
+    // The compound owns the child from here on, removeShape destroys it with the compound
+    void addChildShape(uint32_t compoundID, uint32_t childID, const btTransform& transform);
+    // The shape takes the mesh, it is destroyed by removeShape
     uint32_t createTriangleMeshShape(btTriangleMesh* mesh, bool useQuantizedAABBs);
     uint32_t createConvexHullShape();
 
@@ -71,7 +75,7 @@ public:
     void setCollisionCB(const std::function<void(void*, void*, const glm::vec3&, float)>& cb) { m_collisionCallback = cb; }
 
 private:
-    Allocator& m_allocator;
+    TaggedAllocator m_allocator;
     static Physics* s_instance;
 
     btBroadphaseInterface* m_broadphase;
@@ -91,6 +95,7 @@ private:
     uint32_t m_nextBodyID;
 
     std::map<uint32_t, btCollisionShape*> m_shapes;
+    std::map<uint32_t, std::vector<uint32_t>> m_compoundChildren;  // Child shape IDs owned by each compound
     std::map<uint32_t, btRigidBody*> m_bodies;
     //std::vector<btPairCachingGhostObject*> m_explosions;
 
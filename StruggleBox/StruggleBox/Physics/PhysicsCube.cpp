@@ -66,9 +66,9 @@ PhysicsCube::PhysicsCube(
 
 PhysicsCube::~PhysicsCube()
 {
-	m_physics.removeBodyFromWorld(m_body);
-    m_physics.removeShape(m_shapeID);
+    m_physics.removeBodyFromWorld(m_body);
     m_physics.removeBody(m_bodyID);
+    m_physics.removeShape(m_shapeID);
 }
 
 //CubeInstance PhysicsCube::getRenderInstance() const
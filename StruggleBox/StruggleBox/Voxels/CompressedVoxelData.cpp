@@ -0,0 +1,149 @@
+#include "CompressedVoxelData.h"
+
+#include "Allocator.h"
+#include "Log.h"
+#include <cstring>
+
+CompressedVoxelData::CompressedVoxelData(Allocator& allocator)
+	: m_allocator(allocator)
+	, m_sizeX(0)
+	, m_sizeY(0)
+	, m_sizeZ(0)
+	, m_bitsPerVoxel(0)
+	, m_uniformType(EMPTY_VOXEL)
+	, m_paletteSize(1)
+	, m_indices(nullptr)
+	, m_palette(nullptr)
+	, m_dataSize(0)
+{
+}
+
+CompressedVoxelData::~CompressedVoxelData()
+{
+	release();
+}
+
+void CompressedVoxelData::compress(const VoxelData& voxels)
+{
+	release();
+	m_sizeX = voxels.getSizeX();
+	m_sizeY = voxels.getSizeY();
+	m_sizeZ = voxels.getSizeZ();
+
+	const uint8_t* data = voxels.getData();
+	const size_t numVoxels = voxels.getMemoryUsage();
+
+	// Palette indices in order of first appearance
+	uint8_t paletteIndex[256];
+	uint8_t palette[256];
+	bool used[256] = {};
+	m_paletteSize = 0;
+	for (size_t index = 0; index < numVoxels; index++)
+	{
+		const uint8_t type = data[index];
+		if (!used[type])
+		{
+			used[type] = true;
+			paletteIndex[type] = (uint8_t)m_paletteSize;
+			palette[m_paletteSize++] = type;
+		}
+	}
+
+	m_uniformType = numVoxels ? palette[0] : EMPTY_VOXEL;
+	if (m_paletteSize <= 1)
+	{
+		m_paletteSize = 1;
+		m_bitsPerVoxel = 0;
+		return;
+	}
+
+	if (m_paletteSize <= 2) { m_bitsPerVoxel = 1; }
+	else if (m_paletteSize <= 4) { m_bitsPerVoxel = 2; }
+	else if (m_paletteSize <= 16) { m_bitsPerVoxel = 4; }
+	else { m_bitsPerVoxel = 8; }
+
+	const size_t voxelsPerWord = 64 / m_bitsPerVoxel;
+	const size_t numWords = (numVoxels + voxelsPerWord - 1) / voxelsPerWord;
+	m_dataSize = numWords * sizeof(uint64_t) + m_paletteSize;
+	m_indices = (uint64_t*)m_allocator.allocate(m_dataSize, __alignof(uint64_t));
+	m_palette = (uint8_t*)(m_indices + numWords);
+	memcpy(m_palette, palette, m_paletteSize);
+
+	size_t index = 0;
+	for (size_t word = 0; word < numWords; word++)
+	{
+		uint64_t bits = 0;
+		for (size_t slot = 0; slot < voxelsPerWord && index < numVoxels; slot++, index++)
+		{
+			bits |= (uint64_t)paletteIndex[data[index]] << (slot * m_bitsPerVoxel);
+		}
+		m_indices[word] = bits;
+	}
+}
+
+void CompressedVoxelData::decompress(VoxelData& voxels) const
+{
+	if (voxels.getSizeX() != m_sizeX ||
+		voxels.getSizeY() != m_sizeY ||
+		voxels.getSizeZ() != m_sizeZ)
+	{
+		Log::Error("[CompressedVoxelData] can't decompress %ix%ix%i voxels into %ix%ix%i",
+			m_sizeX, m_sizeY, m_sizeZ, voxels.getSizeX(), voxels.getSizeY(), voxels.getSizeZ());
+		return;
+	}
+	voxels.markAllDirty();
+
+	uint8_t* data = voxels.getData();
+	const size_t numVoxels = voxels.getMemoryUsage();
+	if (isUniform())
+	{
+		memset(data, m_uniformType, numVoxels);
+		return;
+	}
+
+	const size_t voxelsPerWord = 64 / m_bitsPerVoxel;
+	const uint64_t mask = (1ull << m_bitsPerVoxel) - 1;
+	const size_t numFullWords = numVoxels / voxelsPerWord;
+	size_t index = 0;
+	for (size_t word = 0; word < numFullWords; word++)
+	{
+		uint64_t bits = m_indices[word];
+		for (size_t slot = 0; slot < voxelsPerWord; slot++)
+		{
+			data[index++] = m_palette[bits & mask];
+			bits >>= m_bitsPerVoxel;
+		}
+	}
+	uint64_t bits = index < numVoxels ? m_indices[numFullWords] : 0;
+	while (index < numVoxels)
+	{
+		data[index++] = m_palette[bits & mask];
+		bits >>= m_bitsPerVoxel;
+	}
+}
+
+uint8_t CompressedVoxelData::getVoxel(const int x, const int y, const int z) const
+{
+	if (isUniform())
+	{
+		return m_uniformType;
+	}
+	const size_t index = (size_t)x + (size_t)y * m_sizeX + (size_t)z * m_sizeX * m_sizeY;
+	const size_t voxelsPerWord = 64 / m_bitsPerVoxel;
+	const uint64_t mask = (1ull << m_bitsPerVoxel) - 1;
+	const uint64_t bits = m_indices[index / voxelsPerWord] >> ((index % voxelsPerWord) * m_bitsPerVoxel);
+	return m_palette[bits & mask];
+}
+
+void CompressedVoxelData::release()
+{
+	if (m_indices)
+	{
+		m_allocator.deallocate(m_indices);
+		m_indices = nullptr;
+		m_palette = nullptr;
+	}
+	m_dataSize = 0;
+	m_bitsPerVoxel = 0;
+	m_paletteSize = 1;
+}
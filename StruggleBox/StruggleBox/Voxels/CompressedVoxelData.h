@@ -0,0 +1,49 @@
+#pragma once
+
+#include "VoxelData.h"
+#include <cstdint>
+
+class Allocator;
+
+// Palette compressed copy of a VoxelData, for volumes that are kept around but not meshed.
+// Each voxel is an index into a palette of the types it uses, packed at 1, 2, 4 or 8 bits.
+// A volume of a single type stores no indices and answers isUniform() without a scan.
+class CompressedVoxelData
+{
+public:
+	CompressedVoxelData(Allocator& allocator);
+	~CompressedVoxelData();
+
+	void compress(const VoxelData& voxels);
+	// Bulk decode into the one byte per voxel layout the mesher uses, marks all voxels dirty
+	void decompress(VoxelData& voxels) const;
+
+	uint8_t getVoxel(const int x, const int y, const int z) const;
+
+	bool isUniform() const { return m_bitsPerVoxel == 0; }
+	bool isEmpty() const { return isUniform() && m_uniformType == EMPTY_VOXEL; }
+	uint8_t getUniformType() const { return m_uniformType; }
+	uint8_t getBitsPerVoxel() const { return m_bitsPerVoxel; }
+	uint16_t getPaletteSize() const { return m_paletteSize; }
+
+	const uint16_t getSizeX() const { return m_sizeX; }
+	const uint16_t getSizeY() const { return m_sizeY; }
+	const uint16_t getSizeZ() const { return m_sizeZ; }
+
+	const size_t getMemoryUsage() const { return sizeof(CompressedVoxelData) + m_dataSize; }
+
+private:
+	void release();
+
+	Allocator& m_allocator;
+	uint16_t m_sizeX, m_sizeY, m_sizeZ;
+
+	uint8_t m_bitsPerVoxel; // 0 when uniform
+	uint8_t m_uniformType;
+	uint16_t m_paletteSize;
+
+	// Indices fill whole 64-bit words, voxel i is in word i / (64 / bits) so none straddle words
+	uint64_t* m_indices;
+	uint8_t* m_palette; // Stored after the indices in the same allocation
+	size_t m_dataSize;
+};
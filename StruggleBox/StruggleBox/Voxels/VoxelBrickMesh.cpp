@@ -0,0 +1,95 @@
+#include "VoxelBrickMesh.h"
+
+#include "Allocator.h"
+
+VoxelBrickMesh::VoxelBrickMesh(Allocator& allocator)
+	: m_allocator(allocator)
+	, m_bricks()
+	, m_vertexCount(0)
+	, m_radius(0.f)
+	, m_offset()
+{
+}
+
+VoxelBrickMesh::~VoxelBrickMesh()
+{
+	clear();
+}
+
+bool VoxelBrickMesh::update(VoxelData& voxels, const float radius, const glm::vec3& offset)
+{
+	const size_t numBricks = voxels.getNumBricks();
+	// A different layout or mesh transform invalidates every brick
+	if (m_bricks.size() != numBricks ||
+		m_radius != radius ||
+		m_offset != offset)
+	{
+		clear();
+		m_bricks.resize(numBricks, { nullptr, 0 });
+		m_radius = radius;
+		m_offset = offset;
+		voxels.markAllDirty();
+	}
+	if (!voxels.hasDirtyBricks())
+	{
+		return false;
+	}
+
+	// Worst case is a checkerboard, half the voxels solid with all six faces visible
+	const size_t maxVerts = VOXEL_BRICK_SIZE * VOXEL_BRICK_SIZE * VOXEL_BRICK_SIZE * 18;
+	VoxelMeshPBRVertexData* tempVerts = (VoxelMeshPBRVertexData*)m_allocator.allocate(sizeof(VoxelMeshPBRVertexData) * maxVerts);
+	for (int brick = 0; brick < (int)numBricks; brick++)
+	{
+		if (!voxels.isBrickDirty(brick))
+		{
+			continue;
+		}
+		BrickMesh& mesh = m_bricks[brick];
+		m_vertexCount -= mesh.vertexCount;
+		if (mesh.verts)
+		{
+			m_allocator.deallocate(mesh.verts);
+			mesh.verts = nullptr;
+		}
+
+		glm::ivec3 brickMin, brickMax;
+		voxels.getBrickBounds(brick, brickMin, brickMax);
+		mesh.vertexCount = 0;
+		voxels.createTriangleMeshBinary(tempVerts, mesh.vertexCount, radius, offset, brickMin, brickMax);
+		if (mesh.vertexCount)
+		{
+			mesh.verts = (VoxelMeshPBRVertexData*)m_allocator.allocate(sizeof(VoxelMeshPBRVertexData) * mesh.vertexCount);
+			memcpy(mesh.verts, tempVerts, sizeof(VoxelMeshPBRVertexData) * mesh.vertexCount);
+		}
+		m_vertexCount += mesh.vertexCount;
+	}
+	m_allocator.deallocate(tempVerts);
+	voxels.clearDirtyBricks();
+	return true;
+}
+
+void VoxelBrickMesh::clear()
+{
+	for (BrickMesh& mesh : m_bricks)
+	{
+		if (mesh.verts)
+		{
+			m_allocator.deallocate(mesh.verts);
+		}
+	}
+	m_bricks.clear();
+	m_vertexCount = 0;
+}
+
+void VoxelBrickMesh::copyVerts(VoxelMeshPBRVertexData* verts) const
+{
+	size_t vertexCount = 0;
+	for (const BrickMesh& mesh : m_bricks)
+	{
+		if (mesh.vertexCount)
+		{
+			memcpy(&verts[vertexCount], mesh.verts, sizeof(VoxelMeshPBRVertexData) * mesh.vertexCount);
+			vertexCount += mesh.vertexCount;
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "VoxelData.h"
+#include <vector>
+
+// Keeps one sub-mesh per brick of a VoxelData, so after an edit only the bricks
+// the edit marked dirty are meshed again and the rest are copied as they are
+class VoxelBrickMesh
+{
+public:
+	VoxelBrickMesh(Allocator& allocator);
+	~VoxelBrickMesh();
+
+	// Re-meshes the dirty bricks and clears their flags, returns false if nothing changed
+	bool update(VoxelData& voxels, const float radius, const glm::vec3& offset);
+	void clear();
+
+	// Splices the brick meshes together, verts must hold getVertexCount() vertices
+	void copyVerts(VoxelMeshPBRVertexData* verts) const;
+	size_t getVertexCount() const { return m_vertexCount; }
+
+private:
+	struct BrickMesh {
+		VoxelMeshPBRVertexData* verts;
+		size_t vertexCount;
+	};
+
+	Allocator& m_allocator;
+	std::vector<BrickMesh> m_bricks;
+	size_t m_vertexCount;
+	float m_radius;
+	glm::vec3 m_offset;
+};
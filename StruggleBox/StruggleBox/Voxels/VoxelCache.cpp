@@ -1,26 +1,63 @@
 #include "VoxelCache.h"
 
 #include "Allocator.h"
+#include "Frustum.h"
 #include "VoxelLoader.h"
 #include "VoxelRenderer.h"
+#include <algorithm>
 
 VoxelCache::VoxelCache(VoxelRenderer& renderer, Allocator& allocator)
 	: m_renderer(renderer)
-	, m_allocator(allocator)
+	, m_allocator(allocator, MemoryTag::Voxels)
 {
 }
 
-void VoxelCache::draw()
+void VoxelCache::draw(const Frustum& frustum)
 {
 	for (const auto& pair : m_data)
 	{
 		const VoxelCacheData& data = pair.second;
-		ColoredInstanceTransform3DData* instances = m_renderer.bufferVoxelMeshInstances(data.instances.size(), data.drawDataID);
+		const size_t count = data.instances.size();
+		if (count == 0)
+		{
+			continue;
+		}
+		const glm::vec3 localCenter = glm::vec3(data.bounds);
+		const float localRadius = data.bounds.w;
+
+		// Instance rotations are unit quaternions, so only the scale grows the bounds
+		m_cullSpheres.clear();
+		m_cullInstances.clear();
 		for (const auto& instancePair : data.instances)
 		{
-			const VoxelInstanceID instanceID = instancePair.first;
 			const ColoredInstanceTransform3DData& instance = instancePair.second;
-			memcpy(&instances[instanceID], &instance, sizeof(InstanceTransformData3D));
+			const glm::vec3 center = instance.position + instance.rotation * (instance.scale * localCenter);
+			const glm::vec3 scale = glm::abs(instance.scale);
+			const float radius = localRadius * std::max(scale.x, std::max(scale.y, scale.z));
+			m_cullSpheres.push_back(glm::vec4(center, radius));
+			m_cullInstances.push_back(&instance);
+		}
+		m_cullVisibility.assign(count, 0);
+		frustum.cullSpheres(m_cullSpheres.data(), count, m_cullVisibility.data(), 1);
+
+		size_t visibleCount = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			visibleCount += m_cullVisibility[i] != 0;
+		}
+		if (visibleCount == 0)
+		{
+			continue;
+		}
+
+		ColoredInstanceTransform3DData* instances = m_renderer.bufferVoxelMeshInstances(visibleCount, data.drawDataID);
+		size_t instanceIndex = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (m_cullVisibility[i] != 0)
+			{
+				memcpy(&instances[instanceIndex++], m_cullInstances[i], sizeof(ColoredInstanceTransform3DData));
+			}
 		}
 	}
 }
@@ -70,12 +107,13 @@ ColoredInstanceTransform3DData* VoxelCache::getInstance(const std::string& fileN
 	{
 		return nullptr;
 	}
-	VoxelCacheData& data = m_data[fileName];
-	if (data.instances.find(instanceID) == data.instances.end())
+	// Lookups only, entity updates on several threads share the cache
+	auto instanceIt = it->second.instances.find(instanceID);
+	if (instanceIt == it->second.instances.end())
 	{
 		return nullptr;
 	}
-	return &data.instances[instanceID];
+	return &instanceIt->second;
 }
 
 const VoxelData* VoxelCache::getVoxelData(const std::string& fileName)
@@ -96,9 +134,18 @@ void VoxelCache::load(const std::string& fileName)
 	const size_t numVoxels = voxelData->getSizeX() * voxelData->getSizeY() * voxelData->getSizeZ();
 	VoxelMeshPBRVertexData* tempVerts = (VoxelMeshPBRVertexData*)m_allocator.allocate(sizeof(VoxelMeshPBRVertexData) * numVoxels * 36);
 	size_t vertexCount = 0;
-	voxelData->createTriangleMeshReduced(tempVerts, vertexCount, DEFAULT_VOXEL_MESHING_WIDTH, glm::vec3());
+	voxelData->createTriangleMeshBinary(tempVerts, vertexCount, DEFAULT_VOXEL_MESHING_WIDTH, glm::vec3());
+	glm::vec3 boundsMin = glm::vec3(0.f);
+	glm::vec3 boundsMax = glm::vec3(0.f);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		boundsMin = i == 0 ? tempVerts[i].pos : glm::min(boundsMin, tempVerts[i].pos);
+		boundsMax = i == 0 ? tempVerts[i].pos : glm::max(boundsMax, tempVerts[i].pos);
+	}
+	const glm::vec3 boundsCenter = (boundsMin + boundsMax) * 0.5f;
+	const glm::vec4 bounds = glm::vec4(boundsCenter, glm::length(boundsMax - boundsCenter));
 	VoxelMeshPBRVertexData* verts = m_renderer.bufferVoxelMeshVerts(vertexCount, drawDataID);
 	memcpy(verts, tempVerts, sizeof(VoxelMeshPBRVertexData) * vertexCount);
 	m_allocator.deallocate(tempVerts);
-	m_data[fileName] = {drawDataID, voxelData, 0, {}};
+	m_data[fileName] = {drawDataID, voxelData, bounds, 0, {}};
 }
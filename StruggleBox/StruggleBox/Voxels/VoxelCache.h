@@ -1,9 +1,12 @@
 #pragma once
 
 #include "VoxelData.h"
+#include "TaggedAllocator.h"
 #include <map>
 #include <string>
+#include <vector>
 
+class Frustum;
 class VoxelRenderer;
 
 const float DEFAULT_VOXEL_MESHING_WIDTH = 0.25;
@@ -14,6 +17,7 @@ struct VoxelCacheData
 {
 	DrawDataID drawDataID;
 	VoxelData* voxelData;
+	glm::vec4 bounds;			// Mesh bounding sphere in model space, xyz center and w radius
 	VoxelInstanceID nextInstanceID;
 	std::map<VoxelInstanceID, ColoredInstanceTransform3DData> instances;
 };
@@ -23,7 +27,8 @@ class VoxelCache
 public:
 	VoxelCache(VoxelRenderer& renderer, Allocator& allocator);
 
-	void draw();
+	// Buffers the instances which touch the frustum
+	void draw(const Frustum& frustum);
 
 	const VoxelInstanceID addInstance(const std::string& fileName);
 	const VoxelInstanceID addInstance(const std::string& fileName, const glm::vec3& pos, const glm::vec3& scale, const glm::quat& rot, const Color& color);
@@ -36,7 +41,12 @@ private:
 	void load(const std::string& fileName);
 
 	VoxelRenderer& m_renderer;
-	Allocator& m_allocator;
+	TaggedAllocator m_allocator;
 	std::map<std::string, VoxelCacheData> m_data;
+
+	// Reused by draw() every frame
+	std::vector<glm::vec4> m_cullSpheres;
+	std::vector<uint32_t> m_cullVisibility;
+	std::vector<const ColoredInstanceTransform3DData*> m_cullInstances;
 };
 
@@ -8,9 +8,11 @@
 #include "Serialise.h"
 #include "CubeConstants.h"
 #include "Log.h"
+#include "MathUtils.h"
 #include "Physics.h"
 #include "VoxelAABB.h"
 #include "VoxelRenderer.h"
+#include <algorithm>
 #include <cstdlib>
 #include <iterator>
 
@@ -21,7 +23,13 @@ VoxelData::VoxelData(uint16_t sizeX, uint16_t sizeY, uint16_t sizeZ, Allocator&
 	, _sizeZ(sizeZ)
 	, _scale(1.f)
 	, _data(nullptr)
+	, _bricksX((sizeX + VOXEL_BRICK_SIZE - 1) / VOXEL_BRICK_SIZE)
+	, _bricksY((sizeY + VOXEL_BRICK_SIZE - 1) / VOXEL_BRICK_SIZE)
+	, _bricksZ((sizeZ + VOXEL_BRICK_SIZE - 1) / VOXEL_BRICK_SIZE)
+	, _dirtyBricks()
+	, _dirtyBrickCount(0)
 {
+	_dirtyBricks.resize(getNumBricks(), false);
 	const size_t dataSize = (size_t)_sizeX * (size_t)_sizeY * (size_t)_sizeZ;
 	_data = CUSTOM_NEW_ARRAY(uint8_t, dataSize, allocator);
 	clear();
@@ -34,6 +42,7 @@ VoxelData::~VoxelData()
 
 void VoxelData::setData(const uint8_t * data, const size_t size)
 {
+	markAllDirty();
 	const size_t dataSize = (size_t)_sizeX * (size_t)_sizeY * (size_t)_sizeZ;
 	if (size > dataSize)
 	{
@@ -46,18 +55,21 @@ void VoxelData::setData(const uint8_t * data, const size_t size)
 
 void VoxelData::clear()
 {
+	markAllDirty();
 	const size_t dataSize = (size_t)_sizeX * (size_t)_sizeY * (size_t)_sizeZ;
 	memset(_data, 0, dataSize);
 }
 
 void VoxelData::fill(const uint8_t type)
 {
+	markAllDirty();
 	const size_t dataSize = (size_t)_sizeX * (size_t)_sizeY * (size_t)_sizeZ;
 	memset(_data, type, dataSize);
 }
 
 void VoxelData::replaceType(const uint8_t oldType, const uint8_t newType)
 {
+	markAllDirty();
 	const int numVoxels = _sizeX*_sizeY*_sizeZ;
 	int numVerts = 0;
 	for (int i = 0; i < numVoxels; i++)
@@ -70,6 +82,7 @@ void VoxelData::replaceType(const uint8_t oldType, const uint8_t newType)
 
 void VoxelData::rotateY(const bool ccw)
 {
+	markAllDirty();
 	const int numVoxels = _sizeX*_sizeY*_sizeZ;
 	uint8_t* tempBlocks = CUSTOM_NEW_ARRAY(uint8_t, numVoxels, m_allocator);
 
@@ -92,6 +105,81 @@ void VoxelData::rotateY(const bool ccw)
 	CUSTOM_DELETE_ARRAY(tempBlocks, m_allocator);
 }
 
+void VoxelData::setVoxel(const int x, const int y, const int z, const uint8_t type)
+{
+	uint8_t& voxel = _data[getIndex(x, y, z)];
+	if (voxel == type)
+	{
+		return;
+	}
+	voxel = type;
+	markDirty(x, y, z);
+}
+
+void VoxelData::markDirty(const int x, const int y, const int z)
+{
+	// A voxel on a brick border also changes which faces of the neighbouring brick are visible
+	const glm::ivec3 brick = glm::ivec3(x, y, z) / VOXEL_BRICK_SIZE;
+	const glm::ivec3 inBrick = glm::ivec3(x, y, z) % VOXEL_BRICK_SIZE;
+	const glm::ivec3 brickCount = glm::ivec3(_bricksX, _bricksY, _bricksZ);
+	glm::ivec3 minBrick = brick;
+	glm::ivec3 maxBrick = brick;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (inBrick[axis] == 0 && brick[axis] > 0)
+		{
+			minBrick[axis]--;
+		}
+		else if (inBrick[axis] == VOXEL_BRICK_SIZE - 1 && brick[axis] < brickCount[axis] - 1)
+		{
+			maxBrick[axis]++;
+		}
+	}
+	for (int bz = minBrick.z; bz <= maxBrick.z; bz++)
+	{
+		for (int by = minBrick.y; by <= maxBrick.y; by++)
+		{
+			for (int bx = minBrick.x; bx <= maxBrick.x; bx++)
+			{
+				// Only bricks sharing a face with the voxel need it, skip the diagonals
+				const int neighbourAxes = (bx != brick.x) + (by != brick.y) + (bz != brick.z);
+				if (neighbourAxes > 1)
+				{
+					continue;
+				}
+				const int brickIndex = bx + by * _bricksX + bz * _bricksX * _bricksY;
+				if (!_dirtyBricks[brickIndex])
+				{
+					_dirtyBricks[brickIndex] = true;
+					_dirtyBrickCount++;
+				}
+			}
+		}
+	}
+}
+
+void VoxelData::markAllDirty()
+{
+	std::fill(_dirtyBricks.begin(), _dirtyBricks.end(), true);
+	_dirtyBrickCount = (int)getNumBricks();
+}
+
+void VoxelData::clearDirtyBricks()
+{
+	std::fill(_dirtyBricks.begin(), _dirtyBricks.end(), false);
+	_dirtyBrickCount = 0;
+}
+
+void VoxelData::getBrickBounds(const int brick, glm::ivec3& min, glm::ivec3& max) const
+{
+	const glm::ivec3 brickCoord = glm::ivec3(
+		brick % _bricksX,
+		(brick / _bricksX) % _bricksY,
+		brick / (_bricksX * _bricksY));
+	min = brickCoord * VOXEL_BRICK_SIZE;
+	max = glm::min(min + glm::ivec3(VOXEL_BRICK_SIZE), glm::ivec3(_sizeX, _sizeY, _sizeZ));
+}
+
 bool VoxelData::isEmpty() const
 {
 	const int numVoxels = _sizeX * _sizeY * _sizeZ;
@@ -112,6 +200,7 @@ void VoxelData::generateTree(
 	const glm::vec3 treePos,
 	const int seed)
 {
+	markAllDirty();
 	Random::RandomSeed(seed);
 
 	const bool wobblyTrunk = false;
@@ -295,6 +384,7 @@ void VoxelData::generateTree(
 #include <glm/gtc/noise.hpp> // glm::simplex
 void VoxelData::generateGrass(const int seed)
 {
+	markAllDirty();
 	for (int x = 0; x < _sizeX; x++) {
 		for (int z = 0; z < _sizeZ; z++) {
 			float threshold = glm::simplex(glm::vec3(x*0.5f, seed, z*0.5f));
@@ -313,6 +403,7 @@ void VoxelData::generateGrass(const int seed)
 
 void VoxelData::generateTowerChunk(const Coord3D& coord)
 {
+	markAllDirty();
 	bool isEmpty = true;
 	const glm::vec3 chunkPos = glm::vec3(coord.x * 16, coord.y * 16, coord.z * 16);
 	for (int x = 0; x < _sizeX; x++)
@@ -347,6 +438,7 @@ void VoxelData::generateTowerChunk(const Coord3D& coord)
 
 void VoxelData::generateFlatLand(const Coord3D& coord)
 {
+	markAllDirty();
 	const size_t dataSize = (size_t)_sizeX * (size_t)_sizeY * (size_t)_sizeZ;
 	const uint8_t value = coord.y > 0 ? 0 : 1;
 	memset(_data, value, dataSize);
@@ -671,6 +763,264 @@ void VoxelData::createTriangleMeshReduced(VoxelMeshPBRVertexData* verts, size_t&
 	}
 }
 
+template <typename FaceFunc>
+void VoxelData::createFacesBinary(const glm::ivec3& regionMin, const glm::ivec3& regionMax, const FaceFunc& createFace) const
+{
+	const glm::ivec3 size = regionMax - regionMin;
+	const int paddedX = size.x + 2;
+	const int paddedY = size.y + 2;
+	const int paddedZ = size.z + 2;
+
+	// One bit per voxel for every column along Z (indexed x + y * paddedX) and along X (indexed y + z * paddedY)
+	// The same-type masks have bit i set when voxel i has the same type as voxel i - 1 in that column
+	// Columns are padded by one on the sides faces are culled against, so voxels just outside the region hide faces too
+	const size_t numColumnsZ = paddedX * size.y;
+	const size_t numColumnsX = paddedY * paddedZ;
+	uint64_t* masks = CUSTOM_NEW_ARRAY(uint64_t, (numColumnsZ + numColumnsX) * 2, m_allocator);
+	memset(masks, 0, sizeof(uint64_t) * (numColumnsZ + numColumnsX) * 2);
+	uint64_t* occupancyZ = masks;
+	uint64_t* sameTypeZ = occupancyZ + numColumnsZ;
+	uint64_t* occupancyX = sameTypeZ + numColumnsZ;
+	uint64_t* sameTypeX = occupancyX + numColumnsX;
+
+	const int sliceSize = _sizeX * _sizeY;
+	for (int z = regionMin.z - 1; z <= regionMax.z; z++)
+	{
+		for (int y = regionMin.y - 1; y <= regionMax.y; y++)
+		{
+			for (int x = regionMin.x - 1; x <= regionMax.x; x++)
+			{
+				if (!contains(x, y, z))
+				{
+					continue;
+				}
+				const int index = linearIndexFromCoordinate(x, y, z, _sizeX, _sizeY);
+				const uint8_t voxel = _data[index];
+				if (voxel == EMPTY_VOXEL)
+				{
+					continue;
+				}
+				const glm::ivec3 local = glm::ivec3(x, y, z) - regionMin;
+				const bool insideX = local.x >= 0 && local.x < size.x;
+				const bool insideY = local.y >= 0 && local.y < size.y;
+				const bool insideZ = local.z >= 0 && local.z < size.z;
+				if (insideY && insideZ)
+				{
+					const int columnZ = (local.x + 1) + local.y * paddedX;
+					occupancyZ[columnZ] |= 1ull << local.z;
+					if (local.z > 0 && _data[index - sliceSize] == voxel)
+					{
+						sameTypeZ[columnZ] |= 1ull << local.z;
+					}
+				}
+				if (insideX)
+				{
+					const int columnX = (local.y + 1) + (local.z + 1) * paddedY;
+					occupancyX[columnX] |= 1ull << local.x;
+					if (local.x > 0 && _data[index - 1] == voxel)
+					{
+						sameTypeX[columnX] |= 1ull << local.x;
+					}
+				}
+			}
+		}
+	}
+
+	// Every row holds at most one rect per voxel so this covers the largest slice of any axis
+	const size_t maxRectsPerSlice = (std::max)((std::max)(size.y * size.z, size.z * size.x), size.y * size.x);
+	SurfaceRect* rects = CUSTOM_NEW_ARRAY(SurfaceRect, maxRectsPerSlice * 2, m_allocator);
+	SurfaceRect* rectsBack = rects;
+	SurfaceRect* rectsFront = rects + maxRectsPerSlice;
+
+	const int voxelBaseIndex = linearIndexFromCoordinate(regionMin.x, regionMin.y, regionMin.z, _sizeX, _sizeY);
+	const int firstColumnX = 1 + paddedY;
+	// Z-Faces: slices along X, rows along Y, runs along Z
+	createSliceFacesBinary(occupancyZ + 1, sameTypeZ + 1, size.x, size.y, 1, paddedX,
+		1, _sizeX, voxelBaseIndex, sliceSize, regionMin.x, glm::ivec2(regionMin.z, regionMin.y), 0, rectsBack, rectsFront, createFace);
+	// Y Faces: slices along Y, rows along Z, runs along X
+	createSliceFacesBinary(occupancyX + firstColumnX, sameTypeX + firstColumnX, size.y, size.z, 1, paddedY,
+		_sizeX, sliceSize, voxelBaseIndex, 1, regionMin.y, glm::ivec2(regionMin.x, regionMin.z), 2, rectsBack, rectsFront, createFace);
+	// X Faces: slices along Z, rows along Y, runs along X
+	createSliceFacesBinary(occupancyX + firstColumnX, sameTypeX + firstColumnX, size.z, size.y, paddedY, 1,
+		sliceSize, _sizeX, voxelBaseIndex, 1, regionMin.z, glm::ivec2(regionMin.x, regionMin.y), 4, rectsBack, rectsFront, createFace);
+
+	CUSTOM_DELETE_ARRAY(rects, m_allocator);
+	CUSTOM_DELETE_ARRAY(masks, m_allocator);
+}
+
+template <typename FaceFunc>
+void VoxelData::createSliceFacesBinary(
+	const uint64_t* occupancy,
+	const uint64_t* sameType,
+	const int numSlices,
+	const int numRows,
+	const int maskSliceStride,
+	const int maskRowStride,
+	const int voxelSliceStride,
+	const int voxelRowStride,
+	const int voxelBaseIndex,
+	const int voxelBitStride,
+	const int sliceOffset,
+	const glm::ivec2& originOffset,
+	const int axis,
+	SurfaceRect* rectsBack,
+	SurfaceRect* rectsFront,
+	const FaceFunc& createFace) const
+{
+	// Rect index for each run start in the previous and current row, swapped after every row
+	uint16_t rowRectsBack[2][64];
+	uint16_t rowRectsFront[2][64];
+	for (int slice = 0; slice < numSlices; slice++)
+	{
+		size_t rectCountBack = 0;
+		size_t rectCountFront = 0;
+		uint64_t previousStartsBack = 0;
+		uint64_t previousStartsFront = 0;
+		int current = 0;
+		for (int row = 0; row < numRows; row++)
+		{
+			// The masks are padded so the neighbouring slices always exist, zero outside the volume
+			const int maskIndex = slice * maskSliceStride + row * maskRowStride;
+			const uint64_t solid = occupancy[maskIndex];
+			const uint64_t behind = occupancy[maskIndex - maskSliceStride];
+			const uint64_t inFront = occupancy[maskIndex + maskSliceStride];
+			const int voxelRowIndex = voxelBaseIndex + slice * voxelSliceStride + row * voxelRowStride;
+			previousStartsBack = extractRowRectsBinary(
+				solid & ~behind, sameType[maskIndex], row, originOffset, voxelRowIndex, voxelBitStride,
+				previousStartsBack, rowRectsBack[current ^ 1], rowRectsBack[current], rectsBack, rectCountBack);
+			previousStartsFront = extractRowRectsBinary(
+				solid & ~inFront, sameType[maskIndex], row, originOffset, voxelRowIndex, voxelBitStride,
+				previousStartsFront, rowRectsFront[current ^ 1], rowRectsFront[current], rectsFront, rectCountFront);
+			current ^= 1;
+		}
+		for (size_t i = 0; i < rectCountBack; i++)
+		{
+			createFace(rectsBack[i], slice + sliceOffset, axis);
+		}
+		for (size_t i = 0; i < rectCountFront; i++)
+		{
+			createFace(rectsFront[i], slice + sliceOffset, axis + 1);
+		}
+	}
+}
+
+void VoxelData::createTriangleMeshBinary(VoxelMeshPBRVertexData* verts, size_t& vertexCount, const float radius, const glm::vec3& offset) const
+{
+	if (_sizeX > 64 || _sizeY > 64 || _sizeZ > 64)
+	{
+		createTriangleMeshReduced(verts, vertexCount, radius, offset);
+		return;
+	}
+	createTriangleMeshBinary(verts, vertexCount, radius, offset, glm::ivec3(0), glm::ivec3(_sizeX, _sizeY, _sizeZ));
+}
+
+void VoxelData::createTriangleMeshBinary(
+	VoxelMeshPBRVertexData* verts,
+	size_t& vertexCount,
+	const float radius,
+	const glm::vec3& offset,
+	const glm::ivec3& regionMin,
+	const glm::ivec3& regionMax) const
+{
+	const glm::ivec3 size = regionMax - regionMin;
+	if (size.x > 64 || size.y > 64 || size.z > 64)
+	{
+		Log::Error("[VoxelData::createTriangleMeshBinary] region %i, %i, %i too large, max 64 per side", size.x, size.y, size.z);
+		return;
+	}
+	createFacesBinary(regionMin, regionMax, [&](const SurfaceRect& rect, const int slice, const int axis) {
+		createFaceVerts(rect, slice, axis, radius, offset, verts, vertexCount);
+	});
+}
+
+void VoxelData::createTriangleMeshPacked(VoxelChunkVertexData* verts, size_t& vertexCount) const
+{
+	if (_sizeX > 64 || _sizeY > 64 || _sizeZ > 64)
+	{
+		Log::Error("[VoxelData::createTriangleMeshPacked] size %i, %i, %i too large, max 64 per side", _sizeX, _sizeY, _sizeZ);
+		return;
+	}
+	createFacesBinary(glm::ivec3(0), glm::ivec3(_sizeX, _sizeY, _sizeZ), [&](const SurfaceRect& rect, const int slice, const int axis) {
+		createFaceVertsPacked(rect, slice, axis, verts, vertexCount);
+	});
+}
+
+void VoxelData::createFaceVertsPacked(
+	const SurfaceRect& rect,
+	const int slice,
+	const int axis,
+	VoxelChunkVertexData* verts,
+	size_t& vertCount) const
+{
+	const glm::ivec3 cornerLBR = glm::ivec3(voxelCoordForAxis(rect, axis, slice));
+	const glm::ivec3 cornerRTF = cornerLBR + glm::ivec3(voxelCornerForAxis(rect, axis));
+
+	const glm::ivec3 corners[8] = {
+		glm::ivec3(cornerLBR.x, cornerLBR.y, cornerLBR.z), // 0 left-bottom-rear
+		glm::ivec3(cornerRTF.x, cornerLBR.y, cornerLBR.z), // 1 right-bottom-rear
+		glm::ivec3(cornerLBR.x, cornerRTF.y, cornerLBR.z), // 2 left-top-rear
+		glm::ivec3(cornerRTF.x, cornerRTF.y, cornerLBR.z), // 3 right-top-rear
+		glm::ivec3(cornerLBR.x, cornerLBR.y, cornerRTF.z), // 4 left-bottom-front
+		glm::ivec3(cornerRTF.x, cornerLBR.y, cornerRTF.z), // 5 right-bottom-front
+		glm::ivec3(cornerLBR.x, cornerRTF.y, cornerRTF.z), // 6 left-top-front
+		glm::ivec3(cornerRTF.x, cornerRTF.y, cornerRTF.z), // 7 right-top-front
+	};
+
+	const int startIndex = axis * 6;
+	const int endIndex = startIndex + 6;
+	for (int index = startIndex; index < endIndex; index++)
+	{
+		const int index_vertex = CubeConstants::cube_indices[index];
+		verts[vertCount++] = VoxelChunkVertex::pack(corners[index_vertex], axis, rect.voxel, 0);
+	}
+}
+
+uint64_t VoxelData::extractRowRectsBinary(
+	const uint64_t visible,
+	const uint64_t sameType,
+	const int row,
+	const glm::ivec2& originOffset,
+	const int voxelRowIndex,
+	const int voxelBitStride,
+	const uint64_t previousStarts,
+	const uint16_t* previousRects,
+	uint16_t* rowRects,
+	SurfaceRect* rects,
+	size_t& rectCount) const
+{
+	// A visible face continues the run when the one before it is visible and of the same type
+	const uint64_t continued = visible & (visible << 1) & sameType;
+	const uint64_t starts = visible & ~continued;
+	uint64_t remaining = starts;
+	while (remaining)
+	{
+		const int start = MathUtils::CountTrailingZeros(remaining);
+		remaining &= remaining - 1;
+		const uint64_t tail = start < 63 ? continued >> (start + 1) : 0;
+		const int length = MathUtils::CountTrailingZeros(~tail) + 1;
+		const uint8_t voxel = _data[voxelRowIndex + start * voxelBitStride];
+
+		// Merge with the rect that ended on the previous row at the same position
+		if (previousStarts & (1ull << start))
+		{
+			SurfaceRect& previousRect = rects[previousRects[start]];
+			if (previousRect.voxel == voxel && previousRect.size.x == length)
+			{
+				previousRect.size.y += 1;
+				rowRects[start] = previousRects[start];
+				continue;
+			}
+		}
+		rects[rectCount] = {
+			voxel,
+			glm::ivec2(start, row) + originOffset,
+			glm::ivec2(length, 1)
+		};
+		rowRects[start] = (uint16_t)rectCount++;
+	}
+	return starts;
+}
+
 const uint32_t VoxelData::getPhysicsReduced(Physics& physics, float radius) const
 {
 	btTriangleMesh* triangleMesh = physics.createTriangleMesh();
@@ -910,9 +1260,7 @@ const uint32_t VoxelData::getPhysicsReduced(Physics& physics, float radius) cons
 const uint32_t VoxelData::getPhysicsCubes(Physics& physics, const float radius) const
 {
 	uint32_t shapeID = physics.createCompountShape();
-	btCompoundShape* shape = (btCompoundShape*)physics.getShapeForID(shapeID);
 	const uint32_t cubeShapeID = physics.createCube(radius);
-	btBoxShape* cube = (btBoxShape*)physics.getShapeForID(cubeShapeID);
  
 	const float r2 = radius * 2.0f;
 	const glm::vec3 voxelOffset = glm::vec3(radius, radius, radius) - glm::vec3(_sizeX * radius, _sizeY * radius, _sizeZ * radius);
@@ -942,7 +1290,7 @@ const uint32_t VoxelData::getPhysicsCubes(Physics& physics, const float radius)
 		btTransform trans = btTransform();
 		trans.setIdentity();
 		trans.setOrigin(btVector3(pos.x, pos.y, pos.z));
-		shape->addChildShape(trans, cube);
+		physics.addChildShape(shapeID, cubeShapeID, trans);
 	}
 	return shapeID;
 }
@@ -999,10 +1347,13 @@ const uint32_t VoxelData::getPhysicsHull(Physics& physics, const float radius) c
 
 const uint32_t VoxelData::getPhysicsAABBs(Physics& physics, const glm::vec3& radius) const
 {
-	uint32_t shapeID = physics.createCompountShape();
-	btCompoundShape* shape = (btCompoundShape*)physics.getShapeForID(shapeID);
+	std::vector<VoxelAABB> aabbVect;
+	getAABBs(aabbVect, radius);
+	return createPhysicsAABBs(physics, aabbVect);
+}
 
-	std::vector<VoxelAABB> aabbVect;       // Final AABBs
+void VoxelData::getAABBs(std::vector<VoxelAABB>& aabbVect, const glm::vec3& radius) const
+{
 	std::vector<VoxelAABB> aabbVectXPrev;  // Previous pass of X AABBs
 	float minRadius = radius.x < radius.y ? radius.x : radius.y;
 	minRadius = radius.z < minRadius ? radius.z : minRadius;
@@ -1126,6 +1477,12 @@ const uint32_t VoxelData::getPhysicsAABBs(Physics& physics, const glm::vec3& rad
 		}
 	}   // For each x
 
+}
+
+const uint32_t VoxelData::createPhysicsAABBs(Physics& physics, const std::vector<VoxelAABB>& aabbVect)
+{
+	uint32_t shapeID = physics.createCompountShape();
+
 	// Create physics shapes from AABBs
 	Log::Debug("[VoxelData] meshed %i physics AABBs", aabbVect.size());
 	for (const VoxelAABB& aabb : aabbVect)
@@ -1133,11 +1490,10 @@ const uint32_t VoxelData::getPhysicsAABBs(Physics& physics, const glm::vec3& rad
 		const glm::vec3 aaBBSize_2 = (aabb.m_max - aabb.m_min) * 0.5f;
 		const glm::vec3 pos = aabb.m_min + aaBBSize_2;
 		const uint32_t boxID = physics.createBox(aaBBSize_2.x, aaBBSize_2.y, aaBBSize_2.z);
-		btBoxShape* box = (btBoxShape*)physics.getShapeForID(boxID);
 		btTransform trans = btTransform();
 		trans.setIdentity();
 		trans.setOrigin(btVector3(pos.x, pos.y, pos.z));
-		shape->addChildShape(trans, box);
+		physics.addChildShape(shapeID, boxID, trans);
 	}
 
 	return shapeID;
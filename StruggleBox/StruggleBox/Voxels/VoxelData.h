@@ -1,7 +1,8 @@
 #pragma once
 
 #define VOXELDATA_HEADER "VxlDt"
-#define VOXELDATA_VERSION "0.1"
+#define VOXELDATA_VERSION "0.2"
+#define VOXELDATA_VERSION_RAW "0.1" // Uncompressed, still loaded
 
 #include "GFXDefines.h"
 #include "VoxelRenderer.h"
@@ -12,9 +13,11 @@
 class Allocator;
 class Physics;
 //class VoxelRenderer;
+class VoxelAABB;
 struct Coord3D;
 
 const uint8_t EMPTY_VOXEL = 0;
+const int VOXEL_BRICK_SIZE = 16; // Edge length of the regions edits are tracked and re-meshed in
 
 class VoxelData
 {
@@ -26,9 +29,19 @@ public:
 	uint8_t* getData() { return _data; }
 	const uint8_t* getData() const { return _data; }
 	
+	// Writes through these are not tracked, use setVoxel or call markDirty afterwards
 	uint8_t& operator[] (int index) { return _data[index]; }
 	uint8_t& operator() (int x, int y, int z) { return _data[getIndex(x,y,z)]; }
 
+	void setVoxel(const int x, const int y, const int z, const uint8_t type);
+	void markDirty(const int x, const int y, const int z);
+	void markAllDirty();
+	void clearDirtyBricks();
+	bool hasDirtyBricks() const { return _dirtyBrickCount > 0; }
+	bool isBrickDirty(const int brick) const { return _dirtyBricks[brick]; }
+	size_t getNumBricks() const { return (size_t)_bricksX * _bricksY * _bricksZ; }
+	void getBrickBounds(const int brick, glm::ivec3& min, glm::ivec3& max) const;
+
 	void setScale(float scale) { _scale = scale; }
 	float getScale() const { return _scale; }
 
@@ -47,6 +60,21 @@ public:
 
 	void createTriangleMesh(VoxelMeshPBRVertexData* verts, size_t& vertexCount, const float radius, const glm::vec3& offset) const;
 	void createTriangleMeshReduced(VoxelMeshPBRVertexData* verts, size_t& vertexCount, const float radius, const glm::vec3& offset) const;
+	// Same output as createTriangleMeshReduced, built from 64-bit column masks
+	// Falls back to createTriangleMeshReduced when any side is longer than 64 voxels
+	void createTriangleMeshBinary(VoxelMeshPBRVertexData* verts, size_t& vertexCount, const float radius, const glm::vec3& offset) const;
+	// Meshes only the voxels from regionMin up to regionMax, max 64 per side. Faces against
+	// voxels outside the region are still culled, so region meshes can be drawn side by side
+	void createTriangleMeshBinary(
+		VoxelMeshPBRVertexData* verts,
+		size_t& vertexCount,
+		const float radius,
+		const glm::vec3& offset,
+		const glm::ivec3& regionMin,
+		const glm::ivec3& regionMax) const;
+	// Same faces as createTriangleMeshBinary in the packed chunk format, positions are
+	// voxel corners relative to getMeshOrigin(), max 64 voxels per side
+	void createTriangleMeshPacked(VoxelChunkVertexData* verts, size_t& vertexCount) const;
 	//TexturedPBRVertexData* createTriangleMeshReduced(Renderer3DDeferred& renderer, uint32_t& vertexCount, const float radius) const;
 	//void getMeshLinear(Mesh& mesh, float radius);
 	//void getMeshLinearWithVertexAO(Mesh& mesh, float radius);
@@ -56,6 +84,10 @@ public:
 	const uint32_t getPhysicsCubes(Physics& physics, float radius) const;
 	const uint32_t getPhysicsHull(Physics& physics, const float radius) const;
 	const uint32_t getPhysicsAABBs(Physics& physics, const glm::vec3& radius) const;
+	// Split version of getPhysicsAABBs: merging the AABBs only reads the voxel data so it
+	// can run on a worker thread, creating the shapes touches Physics and must not
+	void getAABBs(std::vector<VoxelAABB>& aabbs, const glm::vec3& radius) const;
+	static const uint32_t createPhysicsAABBs(Physics& physics, const std::vector<VoxelAABB>& aabbs);
 
 	bool contains(const int x, const int y, const int z) const
 	{
@@ -72,6 +104,9 @@ public:
 	const int getIndex(const int x, const int y, const int z) const { return linearIndexFromCoordinate(x, y, z, _sizeX, _sizeY); }
 
 	const glm::vec3 getVolume(const float radius) const { return glm::vec3(_sizeX, _sizeY, _sizeZ) * radius * 2.0f; }
+	// World position of voxel corner (0,0,0) in meshes built with this radius and offset
+	const glm::vec3 getMeshOrigin(const float radius, const glm::vec3& offset) const { return offset - glm::vec3(_sizeX, _sizeY, _sizeZ) * radius; }
+	const size_t getMemoryUsage() const { return (size_t)_sizeX * (size_t)_sizeY * (size_t)_sizeZ; }
 
 private:
 	enum Axis
@@ -103,6 +138,44 @@ private:
 		const glm::vec3& offset,
 		VoxelMeshPBRVertexData* verts,
 		size_t& vertCount) const;
+	void createFaceVertsPacked(
+		const SurfaceRect& rect,
+		const int slice,
+		const int axis,
+		VoxelChunkVertexData* verts,
+		size_t& vertCount) const;
+	template <typename FaceFunc>
+	void createFacesBinary(const glm::ivec3& regionMin, const glm::ivec3& regionMax, const FaceFunc& createFace) const;
+	template <typename FaceFunc>
+	void createSliceFacesBinary(
+		const uint64_t* occupancy,
+		const uint64_t* sameType,
+		const int numSlices,
+		const int numRows,
+		const int maskSliceStride,
+		const int maskRowStride,
+		const int voxelSliceStride,
+		const int voxelRowStride,
+		const int voxelBaseIndex,
+		const int voxelBitStride,
+		const int sliceOffset,
+		const glm::ivec2& originOffset,
+		const int axis,
+		SurfaceRect* rectsBack,
+		SurfaceRect* rectsFront,
+		const FaceFunc& createFace) const;
+	uint64_t extractRowRectsBinary(
+		const uint64_t visible,
+		const uint64_t sameType,
+		const int row,
+		const glm::ivec2& originOffset,
+		const int voxelRowIndex,
+		const int voxelBitStride,
+		const uint64_t previousStarts,
+		const uint16_t* previousRects,
+		uint16_t* rowRects,
+		SurfaceRect* rects,
+		size_t& rectCount) const;
 
 
 	Allocator& m_allocator;
@@ -111,6 +184,10 @@ private:
 	uint8_t* _data; // Raw voxel data, each byte is one voxel type ID
 	float _scale; // Object scale - 1.0 = one world-sized block (256px per side)
 
+	uint16_t _bricksX, _bricksY, _bricksZ;
+	std::vector<bool> _dirtyBricks; // Bricks edited since the last clearDirtyBricks
+	int _dirtyBrickCount;
+
 	static int linearIndexFromCoordinate(
 		const int x,
 		const int y,
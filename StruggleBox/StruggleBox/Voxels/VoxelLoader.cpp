@@ -7,10 +7,18 @@
 #include "PathUtil.h"
 #include "Serialise.h"
 #include "Log.h"
+#include "zlib.h"
 
 #define OLD_CUBESET_HEADER "BWOCB"  // Must be 5 characters
 #define OLD_CUBESET_VERSION "1.0"   // Must be 3 characters
 
+// Version 0.2 layout, integers are big endian:
+// "VxlDt0.2", size x, size y, size z, compressed size, CRC32 of the voxels, zlib stream
+const int VOXELDATA_TAG_SIZE = 8;
+const int VOXELDATA_RAW_HEADER_SIZE = VOXELDATA_TAG_SIZE + (SERIALISED_INT_SIZE * 3);
+const int VOXELDATA_HEADER_SIZE = VOXELDATA_RAW_HEADER_SIZE + (SERIALISED_INT_SIZE * 2);
+const int VOXELDATA_STREAM_CHUNK_SIZE = 16 * 1024;
+
 bool checkHeaderTag(const unsigned char* buffer)
 {
 	return strncmp((const char*)buffer, VOXELDATA_HEADER, 5) == 0;
@@ -19,6 +27,10 @@ bool checkHeaderVersion(const unsigned char* buffer)
 {
 	return strncmp((const char*)buffer, VOXELDATA_VERSION, 3) == 0;
 }
+bool checkHeaderVersionRaw(const unsigned char* buffer)
+{
+	return strncmp((const char*)buffer, VOXELDATA_VERSION_RAW, 3) == 0;
+}
 bool checkHeaderTagOld(const unsigned char* buffer)
 {
 	return strncmp((const char*)buffer, OLD_CUBESET_HEADER, 5) == 0;
@@ -35,90 +47,167 @@ static inline glm::ivec3 getOldIndexPos(int index, const int width_bits, const i
     return glm::ivec3(x,y,z);
 };
 
+// Inflates the zlib stream a chunk at a time straight into the voxel data
+static VoxelData* loadCompressed(std::ifstream& file, const std::string& fileName, Allocator& allocator)
+{
+	unsigned char header[VOXELDATA_HEADER_SIZE - VOXELDATA_TAG_SIZE];
+	if (!file.read((char*)header, sizeof(header)))
+	{
+		Log::Error("[VoxelLoader] Truncated header in %s", fileName.c_str());
+		return nullptr;
+	}
+	const int sizeX = Serialise::deserialiseInt(header);
+	const int sizeY = Serialise::deserialiseInt(header + SERIALISED_INT_SIZE);
+	const int sizeZ = Serialise::deserialiseInt(header + SERIALISED_INT_SIZE * 2);
+	unsigned int compressedSize = Serialise::deserialiseInt(header + SERIALISED_INT_SIZE * 3);
+	const unsigned int checksum = Serialise::deserialiseInt(header + SERIALISED_INT_SIZE * 4);
+
+	VoxelData* data = CUSTOM_NEW(VoxelData, allocator)(sizeX, sizeY, sizeZ, allocator);
+	const size_t numVoxels = data->getMemoryUsage();
+
+	z_stream stream = {};
+	if (inflateInit(&stream) != Z_OK)
+	{
+		Log::Error("[VoxelLoader] Failed to initialize zlib for %s", fileName.c_str());
+		CUSTOM_DELETE(data, allocator);
+		return nullptr;
+	}
+	stream.next_out = data->getData();
+	stream.avail_out = (uInt)numVoxels;
+
+	unsigned char input[VOXELDATA_STREAM_CHUNK_SIZE];
+	int result = Z_OK;
+	while (result == Z_OK && compressedSize > 0)
+	{
+		const unsigned int readSize = std::min<unsigned int>(compressedSize, VOXELDATA_STREAM_CHUNK_SIZE);
+		file.read((char*)input, readSize);
+		if ((unsigned int)file.gcount() != readSize)
+		{
+			break;
+		}
+		compressedSize -= readSize;
+		stream.next_in = input;
+		stream.avail_in = readSize;
+		result = inflate(&stream, Z_NO_FLUSH);
+	}
+	const size_t decodedSize = stream.total_out;
+	inflateEnd(&stream);
+
+	if (result != Z_STREAM_END || decodedSize != numVoxels)
+	{
+		Log::Error("[VoxelLoader] Bad compressed voxel data in %s, decoded %i of %i voxels (%i)",
+			fileName.c_str(), (int)decodedSize, (int)numVoxels, result);
+		CUSTOM_DELETE(data, allocator);
+		return nullptr;
+	}
+	if (crc32(0L, data->getData(), (uInt)numVoxels) != checksum)
+	{
+		Log::Error("[VoxelLoader] Checksum mismatch in %s", fileName.c_str());
+		CUSTOM_DELETE(data, allocator);
+		return nullptr;
+	}
+	return data;
+}
+
+static VoxelData* loadRaw(std::ifstream& file, const std::string& fileName, Allocator& allocator)
+{
+	unsigned char header[VOXELDATA_RAW_HEADER_SIZE - VOXELDATA_TAG_SIZE];
+	if (!file.read((char*)header, sizeof(header)))
+	{
+		Log::Error("[VoxelLoader] Truncated header in %s", fileName.c_str());
+		return nullptr;
+	}
+	const int sizeX = Serialise::deserialiseInt(header);
+	const int sizeY = Serialise::deserialiseInt(header + SERIALISED_INT_SIZE);
+	const int sizeZ = Serialise::deserialiseInt(header + SERIALISED_INT_SIZE * 2);
+
+	VoxelData* data = CUSTOM_NEW(VoxelData, allocator)(sizeX, sizeY, sizeZ, allocator);
+	const size_t numCubes = data->getMemoryUsage();
+	file.read((char*)data->getData(), numCubes);
+	if ((size_t)file.gcount() != numCubes)
+	{
+		Log::Error("[VoxelLoader] Bad voxel data, cubes: %i, read: %i", (int)numCubes, (int)file.gcount());
+		data->clear();
+	}
+	return data;
+}
+
+static VoxelData* loadOld(std::ifstream& file, Allocator& allocator)
+{
+	// Old object data type, try to deserialize
+	const std::ifstream::pos_type dataStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	const int fileSize = (int)(file.tellg() - dataStart);
+	file.seekg(dataStart);
+	unsigned char* buffer = CUSTOM_NEW_ARRAY(unsigned char, fileSize, allocator);
+	file.read((char*)buffer, fileSize);
+
+	unsigned int readBytes = 0;
+	// Load width and height of object
+	const int width_bits = Serialise::deserialiseInt(buffer + readBytes);
+	readBytes += SERIALISED_INT_SIZE;
+	const int height_bits = Serialise::deserialiseInt(buffer + readBytes);
+	readBytes += SERIALISED_INT_SIZE;
+	// Load number of cubes
+	unsigned int numCubes = Serialise::deserialiseInt(buffer + readBytes);
+	readBytes += SERIALISED_INT_SIZE;
+	// Prepare block storage
+	VoxelData* data = CUSTOM_NEW(VoxelData, allocator)(pow(2.0,width_bits), pow(2.0, height_bits), pow(2.0, width_bits), allocator);
+
+	// Load block data
+	for (unsigned int i = 0; i<numCubes; i++) 
+	{
+		const glm::ivec3 oldCoord = getOldIndexPos(i, width_bits, height_bits);
+		unsigned int block = Serialise::deserialiseInt(buffer + readBytes);
+		(*data)(oldCoord.x, oldCoord.y, oldCoord.z) = block;
+		readBytes += SERIALISED_INT_SIZE;
+		// Skip unused color data
+		readBytes += SERIALISED_FLOAT_SIZE;
+		readBytes += SERIALISED_FLOAT_SIZE;
+		readBytes += SERIALISED_FLOAT_SIZE;
+		readBytes += SERIALISED_FLOAT_SIZE;
+	}
+	CUSTOM_DELETE_ARRAY(buffer, allocator);
+	return data;
+}
+
 VoxelData* VoxelLoader::load(const std::string& fileName, Allocator& allocator)
 {
 	const std::string absolutePath = PathUtil::getObjectPath(fileName);
 
 	VoxelData* data = nullptr;
-	std::ifstream::int_type fileSize;
-	unsigned char* buffer = NULL;
-	std::ifstream file(absolutePath.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+	std::ifstream file(absolutePath.c_str(), std::ios::in | std::ios::binary);
 
 	if (file && file.is_open())
 	{
-		fileSize = (int)file.tellg();
-		buffer = CUSTOM_NEW_ARRAY(unsigned char, fileSize, allocator);
-		file.seekg(0, std::ios::beg);
-		file.read((char*)buffer, fileSize);
-		file.close();
-
-		Log::Debug("[VoxelLoader] Loaded voxel data file %s", fileName.c_str());
-
-		unsigned int readBytes = 0;
-		// Read header and version number
-		if (checkHeaderTag(buffer) &&
-			checkHeaderVersion(buffer + 5))
+		// Read header and version number, the rest is streamed by the loader for that version
+		unsigned char tag[VOXELDATA_TAG_SIZE] = {};
+		file.read((char*)tag, VOXELDATA_TAG_SIZE);
+		if (checkHeaderTag(tag) &&
+			checkHeaderVersion(tag + 5))
 		{
-			readBytes = 8;
-			// Load width and height of object
-			const int sizeX = Serialise::deserialiseInt(buffer + readBytes);
-			readBytes += SERIALISED_INT_SIZE;
-			const int sizeY = Serialise::deserialiseInt(buffer + readBytes);
-			readBytes += SERIALISED_INT_SIZE;
-			const int sizeZ = Serialise::deserialiseInt(buffer + readBytes);
-			readBytes += SERIALISED_INT_SIZE;
-
-			// Prepare block storage
-			data = CUSTOM_NEW(VoxelData, allocator)(sizeX, sizeY, sizeZ, allocator);
-			// Load number of cubes
-			unsigned int numCubes = sizeX*sizeY*sizeZ;
-
-			if (numCubes <= fileSize - readBytes)
-			{
-				data->setData(buffer + readBytes, numCubes);
-			}
-			else
-			{
-				Log::Error("[VoxelLoader] Bad voxel data, cubes: %i, file: %i, header: %i",
-					numCubes, fileSize, readBytes);
-			}
+			data = loadCompressed(file, fileName, allocator);
 		}
-		else if (checkHeaderTagOld(buffer) &&
-			checkHeaderVersionOld(buffer + 5))
+		else if (checkHeaderTag(tag) &&
+			checkHeaderVersionRaw(tag + 5))
 		{
-			// Old object data type, try to deserialize
-
-			readBytes = 8;
-			// Load width and height of object
-			const int width_bits = Serialise::deserialiseInt(buffer + readBytes);
-			readBytes += SERIALISED_INT_SIZE;
-			const int height_bits = Serialise::deserialiseInt(buffer + readBytes);
-			readBytes += SERIALISED_INT_SIZE;
-			// Load number of cubes
-			unsigned int numCubes = Serialise::deserialiseInt(buffer + readBytes);
-			readBytes += SERIALISED_INT_SIZE;
-			// Prepare block storage
-			data = CUSTOM_NEW(VoxelData, allocator)(pow(2.0,width_bits), pow(2.0, height_bits), pow(2.0, width_bits), allocator);
-
-			// Load block data
-			for (unsigned int i = 0; i<numCubes; i++) 
-			{
-				const glm::ivec3 oldCoord = getOldIndexPos(i, width_bits, height_bits);
-				unsigned int block = Serialise::deserialiseInt(buffer + readBytes);
-				(*data)(oldCoord.x, oldCoord.y, oldCoord.z) = block;
-				readBytes += SERIALISED_INT_SIZE;
-				// Skip unused color data
-				readBytes += SERIALISED_FLOAT_SIZE;
-				readBytes += SERIALISED_FLOAT_SIZE;
-				readBytes += SERIALISED_FLOAT_SIZE;
-				readBytes += SERIALISED_FLOAT_SIZE;
-			}
+			data = loadRaw(file, fileName, allocator);
+		}
+		else if (checkHeaderTagOld(tag) &&
+			checkHeaderVersionOld(tag + 5))
+		{
+			data = loadOld(file, allocator);
 		}
 		else
 		{
 			Log::Error("[VoxelLoader] Object header fail!");
 		}
-		CUSTOM_DELETE_ARRAY(buffer, allocator);
+		file.close();
+
+		if (data)
+		{
+			Log::Debug("[VoxelLoader] Loaded voxel data file %s", fileName.c_str());
+		}
 	}
 	else
 	{
@@ -131,26 +220,34 @@ void VoxelLoader::save(const std::string& fileName, const VoxelData* data, Alloc
 {
 	const std::string absolutePath = PathUtil::getObjectPath(fileName);
 
-	const int headerSize = 8 + (SERIALISED_INT_SIZE * 3);
-	const int requiredSize = data->getSizeX()*data->getSizeY()*data->getSizeZ() + headerSize;
+	const size_t voxelDataSize = data->getMemoryUsage();
+	const uLong maxCompressedSize = compressBound((uLong)voxelDataSize);
+	const int requiredSize = VOXELDATA_HEADER_SIZE + maxCompressedSize;
 	int dataSize = 0;
 	unsigned char* buffer = CUSTOM_NEW_ARRAY(unsigned char, requiredSize, allocator);
 
 	// Save 5 byte header and 3 byte version
 	memcpy(buffer, VOXELDATA_HEADER, 5);
 	memcpy(buffer + 5, VOXELDATA_VERSION, 3);
-	dataSize += 8;
+	dataSize += VOXELDATA_TAG_SIZE;
 
 	// Save width and height of object
 	dataSize += Serialise::serialise((unsigned int)data->getSizeX(), buffer + dataSize);
 	dataSize += Serialise::serialise((unsigned int)data->getSizeY(), buffer + dataSize);
 	dataSize += Serialise::serialise((unsigned int)data->getSizeZ(), buffer + dataSize);
 
-	// Save cube data
-	const size_t voxelDataSize = data->getSizeX()*data->getSizeY()*data->getSizeZ();
-	memcpy(buffer + dataSize, data->getData(), voxelDataSize);
-	dataSize += voxelDataSize;
-	Log::Debug("[VoxelLoader] Saved data %i, predicted: %i", dataSize, requiredSize);
+	// Compress cube data, the compressed size is filled in once known
+	uLongf compressedSize = maxCompressedSize;
+	if (compress2(buffer + VOXELDATA_HEADER_SIZE, &compressedSize, data->getData(), (uLong)voxelDataSize, Z_BEST_COMPRESSION) != Z_OK)
+	{
+		Log::Error("[VoxelLoader] Failed to compress voxel data for %s", absolutePath.c_str());
+		CUSTOM_DELETE_ARRAY(buffer, allocator);
+		return;
+	}
+	dataSize += Serialise::serialise((unsigned int)compressedSize, buffer + dataSize);
+	dataSize += Serialise::serialise((unsigned int)crc32(0L, data->getData(), (uInt)voxelDataSize), buffer + dataSize);
+	dataSize += compressedSize;
+	Log::Debug("[VoxelLoader] Saved data %i, uncompressed: %i", dataSize, VOXELDATA_RAW_HEADER_SIZE + (int)voxelDataSize);
 
 	std::ofstream file(absolutePath.c_str(), std::ios::out | std::ios::binary | std::ios::ate);
 	if (!file || (file.rdstate() & std::ifstream::failbit ) != 0 )
@@ -0,0 +1,386 @@
+#include "ChunkStreamer.h"
+
+#include "Allocator.h"
+#include "ArenaOperators.h"
+#include "CompressedVoxelData.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "RegionStore.h"
+#include "Timer.h"
+#include "VoxelData.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+ChunkStreamer::ChunkStreamer(
+    Allocator& allocator,
+    JobSystem& jobSystem,
+    RegionStore& regionStore,
+    ChunkUploadHandler& uploadHandler)
+    : m_allocator(allocator)
+    , m_jobSystem(jobSystem)
+    , m_regionStore(regionStore)
+    , m_uploadHandler(uploadHandler)
+    , m_cachedChunkBytes(0)
+{
+}
+
+ChunkStreamer::~ChunkStreamer()
+{
+    releaseAll();
+}
+
+ChunkStreamStats ChunkStreamer::update(
+    const Coord3D& center,
+    const int radius,
+    const int unloadRadius,
+    const size_t maxCachedBytes,
+    const double uploadBudgetMS)
+{
+    PROFILE_SCOPE("ChunkStreamer::update");
+    ChunkStreamStats stats = { 0, 0, 0 };
+
+    // The chunk at the center and the ones sharing a face with it
+    // get generated and meshed before the ones further out
+    auto priorityForCoord = [&center](const Coord3D& coord) {
+        const int distance = abs(coord.x - center.x) + abs(coord.y - center.y) + abs(coord.z - center.z);
+        return distance <= 1 ? JobPriority::High : JobPriority::Normal;
+    };
+
+    // Unload chunks that are out of range, their voxels move to the cache.
+    // Chunks which are still being worked on are left alone until they finish
+    for (auto it = m_chunks.begin(); it != m_chunks.end(); /*it++*/)
+    {
+        const Coord3D& coord = it->first;
+        const int distance = std::max(abs(coord.x - center.x), std::max(abs(coord.y - center.y), abs(coord.z - center.z)));
+        if (distance <= unloadRadius ||
+            it->second.state != ChunkState::Loaded)
+        {
+            ++it;
+            continue;
+        }
+        unloadChunk(it->second);
+        it = m_chunks.erase(it);
+        stats.chunksEvicted++;
+    }
+    trimChunkCache(maxCachedBytes);
+
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int y = -radius; y <= radius; y++)
+        {
+            for (int z = -radius; z <= radius; z++)
+            {
+                const Coord3D coord = Coord3D(center.x + x, center.y + y, center.z + z);
+                if (m_chunks.find(coord) != m_chunks.end())
+                {
+                    continue;
+                }
+                // Map nodes are never moved so the jobs can safely hold on to the chunk
+                TerrainChunk& chunk = m_chunks[coord];
+                chunk.coord = coord;
+
+                auto cached = m_cachedChunks.find(coord);
+                if (cached != m_cachedChunks.end())
+                {
+                    chunk.compressed = cached->second.voxels;
+                    m_cachedChunkBytes -= chunk.compressed->getMemoryUsage();
+                    m_cachedChunkLRU.erase(cached->second.lruIt);
+                    m_cachedChunks.erase(cached);
+                    startChunkMeshing(chunk, priorityForCoord(coord));
+                    continue;
+                }
+                chunk.state = ChunkState::Generating;
+                TerrainChunk* chunkPtr = &chunk;
+                Allocator* allocator = &m_allocator;
+                RegionStore* regionStore = &m_regionStore;
+                m_jobSystem.addJob(priorityForCoord(coord), &chunk.generateJob, [chunkPtr, allocator, regionStore]() {
+                    GenerateChunkInThread(chunkPtr, allocator, regionStore);
+                });
+            }
+        }
+    }
+
+    const double uploadStartTime = Timer::Milliseconds();
+    for (auto& pair : m_chunks)
+    {
+        TerrainChunk& chunk = pair.second;
+        if (chunk.state == ChunkState::Generating && chunk.generateJob.isDone())
+        {
+            startChunkMeshing(chunk, priorityForCoord(chunk.coord));
+        }
+        else if (chunk.state == ChunkState::Loaded &&
+            chunk.voxels &&
+            chunk.voxels->hasDirtyBricks())
+        {
+            // Edited chunks jump the queue, the old mesh keeps drawing until the new one is uploaded.
+            // Only the compressed copy is updated here, the region file is written on save and unload
+            chunk.compressed->compress(*chunk.voxels);
+            chunk.edited = true;
+            startChunkMeshing(chunk, JobPriority::High);
+        }
+        else if (chunk.state == ChunkState::Meshing &&
+            chunk.meshJob.isDone() &&
+            chunk.shapeJob.isDone())
+        {
+            chunk.state = ChunkState::Uploading;
+        }
+
+        if (chunk.state == ChunkState::Uploading)
+        {
+            // Always upload at least one chunk per update so we can't stall completely
+            if (stats.chunksUploaded == 0 ||
+                Timer::Milliseconds() - uploadStartTime < uploadBudgetMS)
+            {
+                uploadChunk(chunk);
+                stats.chunksUploaded++;
+            }
+        }
+
+        // Generate jobs allocate and free the voxels of their chunk, only count chunks no job is working on
+        if (chunk.state == ChunkState::Generating ||
+            chunk.state == ChunkState::Meshing)
+        {
+            continue;
+        }
+        if (chunk.voxels)
+        {
+            stats.loadedBytes += chunk.voxels->getMemoryUsage();
+        }
+        if (chunk.compressed)
+        {
+            stats.loadedBytes += chunk.compressed->getMemoryUsage();
+        }
+        stats.loadedBytes += chunk.vertexCount * sizeof(VoxelChunkVertexData);
+    }
+    return stats;
+}
+
+bool ChunkStreamer::setVoxel(const Coord3D& coord, const int x, const int y, const int z, const uint8_t type)
+{
+    auto it = m_chunks.find(coord);
+    if (it == m_chunks.end() ||
+        it->second.state != ChunkState::Loaded)
+    {
+        return false;
+    }
+    TerrainChunk& chunk = it->second;
+    if (!chunk.voxels)
+    {
+        if (chunk.compressed->getVoxel(x, y, z) == type)
+        {
+            return true;
+        }
+        chunk.voxels = CUSTOM_NEW(VoxelData, m_allocator)(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, m_allocator);
+        chunk.compressed->decompress(*chunk.voxels);
+        chunk.voxels->clearDirtyBricks();
+    }
+    chunk.voxels->setVoxel(x, y, z, type);
+    return true;
+}
+
+void ChunkStreamer::storeEditedChunks()
+{
+    for (auto& pair : m_chunks)
+    {
+        // Edited chunks can be re-meshing, their voxels are only read meanwhile
+        if (pair.second.state != ChunkState::Generating)
+        {
+            storeEditedChunk(pair.second);
+        }
+    }
+}
+
+void ChunkStreamer::releaseAll()
+{
+    for (auto& pair : m_chunks)
+    {
+        TerrainChunk& chunk = pair.second;
+        waitForChunkJobs(chunk);
+        if (chunk.pendingVerts)
+        {
+            m_allocator.deallocate(chunk.pendingVerts);
+            chunk.pendingVerts = nullptr;
+        }
+        if (chunk.state != ChunkState::Generating)
+        {
+            storeEditedChunk(chunk);
+        }
+        releaseChunkUpload(chunk);
+        releaseChunkVoxels(chunk);
+        if (chunk.compressed)
+        {
+            CUSTOM_DELETE(chunk.compressed, m_allocator);
+        }
+    }
+    m_chunks.clear();
+    trimChunkCache(0);
+}
+
+const TerrainChunk* ChunkStreamer::getChunk(const Coord3D& coord) const
+{
+    auto it = m_chunks.find(coord);
+    return it != m_chunks.end() ? &it->second : nullptr;
+}
+
+const CompressedVoxelData* ChunkStreamer::getCachedChunk(const Coord3D& coord) const
+{
+    auto it = m_cachedChunks.find(coord);
+    return it != m_cachedChunks.end() ? it->second.voxels : nullptr;
+}
+
+void ChunkStreamer::startChunkMeshing(TerrainChunk& chunk, const JobPriority priority)
+{
+    // Empty chunks are known from the palette alone, they never get decoded or meshed
+    if (chunk.compressed->isEmpty())
+    {
+        releaseChunkUpload(chunk);
+        releaseChunkVoxels(chunk);
+        chunk.state = ChunkState::Loaded;
+        Log::Debug("Loading empty chunk data at coord: %i, %i, %i", chunk.coord.x, chunk.coord.y, chunk.coord.z);
+        return;
+    }
+    if (!chunk.voxels)
+    {
+        chunk.voxels = CUSTOM_NEW(VoxelData, m_allocator)(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, m_allocator);
+        chunk.compressed->decompress(*chunk.voxels);
+    }
+    // Chunks are a single brick, the whole chunk gets meshed so its dirty flags can go
+    chunk.voxels->clearDirtyBricks();
+
+    // Meshing and collision shape building only read the voxels, let them run side by side
+    chunk.state = ChunkState::Meshing;
+    TerrainChunk* chunkPtr = &chunk;
+    Allocator* allocator = &m_allocator;
+    m_jobSystem.addJob(priority, &chunk.meshJob, [chunkPtr, allocator]() { MeshChunkInThread(chunkPtr, allocator); });
+    m_jobSystem.addJob(priority, &chunk.shapeJob, [chunkPtr]() { BuildChunkShapeInThread(chunkPtr); });
+}
+
+void ChunkStreamer::uploadChunk(TerrainChunk& chunk)
+{
+    m_uploadHandler.uploadChunk(chunk);
+    chunk.vertexCount = chunk.pendingVertexCount;
+    m_allocator.deallocate(chunk.pendingVerts);
+    chunk.pendingVerts = nullptr;
+    chunk.pendingVertexCount = 0;
+    std::vector<VoxelAABB>().swap(chunk.aabbs);
+
+    // The compressed copy is current, the plain voxels are only needed again if the chunk gets edited
+    releaseChunkVoxels(chunk);
+    chunk.state = ChunkState::Loaded;
+    Log::Debug("Loading chunk data at coord: %i, %i, %i - verts %zu", chunk.coord.x, chunk.coord.y, chunk.coord.z, chunk.vertexCount);
+}
+
+void ChunkStreamer::unloadChunk(TerrainChunk& chunk)
+{
+    releaseChunkUpload(chunk);
+    storeEditedChunk(chunk);
+    releaseChunkVoxels(chunk);
+    if (chunk.compressed)
+    {
+        m_cachedChunkLRU.push_front(chunk.coord);
+        m_cachedChunks[chunk.coord] = { chunk.compressed, m_cachedChunkLRU.begin() };
+        m_cachedChunkBytes += chunk.compressed->getMemoryUsage();
+        chunk.compressed = nullptr;
+    }
+    Log::Debug("Unloaded chunk at coord: %i, %i, %i", chunk.coord.x, chunk.coord.y, chunk.coord.z);
+}
+
+void ChunkStreamer::releaseChunkUpload(TerrainChunk& chunk)
+{
+    m_uploadHandler.releaseChunk(chunk);
+    chunk.vertexCount = 0;
+}
+
+void ChunkStreamer::releaseChunkVoxels(TerrainChunk& chunk)
+{
+    if (chunk.voxels)
+    {
+        CUSTOM_DELETE(chunk.voxels, m_allocator);
+        chunk.voxels = nullptr;
+    }
+}
+
+void ChunkStreamer::storeEditedChunk(TerrainChunk& chunk)
+{
+    // Edits that haven't been re-meshed yet only live in the plain voxels
+    if (chunk.voxels && chunk.voxels->hasDirtyBricks())
+    {
+        chunk.compressed->compress(*chunk.voxels);
+        chunk.edited = true;
+    }
+    if (!chunk.edited)
+    {
+        return;
+    }
+    // Plain voxels are released once a chunk is uploaded, the compressed copy is always current
+    if (chunk.voxels)
+    {
+        m_regionStore.storeChunk(chunk.coord, *chunk.voxels);
+    }
+    else
+    {
+        VoxelData voxels(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, m_allocator);
+        chunk.compressed->decompress(voxels);
+        m_regionStore.storeChunk(chunk.coord, voxels);
+    }
+    chunk.edited = false;
+}
+
+void ChunkStreamer::trimChunkCache(const size_t maxBytes)
+{
+    while (m_cachedChunkBytes > maxBytes && !m_cachedChunkLRU.empty())
+    {
+        auto it = m_cachedChunks.find(m_cachedChunkLRU.back());
+        m_cachedChunkBytes -= it->second.voxels->getMemoryUsage();
+        CUSTOM_DELETE(it->second.voxels, m_allocator);
+        m_cachedChunks.erase(it);
+        m_cachedChunkLRU.pop_back();
+    }
+}
+
+void ChunkStreamer::waitForChunkJobs(TerrainChunk& chunk)
+{
+    // Helps out with queued jobs instead of blocking
+    m_jobSystem.wait(chunk.generateJob);
+    m_jobSystem.wait(chunk.meshJob);
+    m_jobSystem.wait(chunk.shapeJob);
+}
+
+void ChunkStreamer::GenerateChunkInThread(TerrainChunk* chunk, Allocator* allocator, RegionStore* regionStore)
+{
+    PROFILE_SCOPE("Chunk Generate");
+    chunk->voxels = CUSTOM_NEW(VoxelData, (*allocator))(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, *allocator);
+    // Stored chunks load on the same job, only new ones get generated and then stored
+    if (!regionStore->loadChunk(chunk->coord, *chunk->voxels))
+    {
+        //chunk->voxels->generateTowerChunk(chunk->coord);
+        chunk->voxels->generateFlatLand(chunk->coord);
+        regionStore->storeChunk(chunk->coord, *chunk->voxels);
+    }
+
+    chunk->compressed = CUSTOM_NEW(CompressedVoxelData, (*allocator))(*allocator);
+    chunk->compressed->compress(*chunk->voxels);
+    if (chunk->compressed->isEmpty())
+    {
+        CUSTOM_DELETE(chunk->voxels, (*allocator));
+        chunk->voxels = nullptr;
+    }
+}
+
+void ChunkStreamer::MeshChunkInThread(TerrainChunk* chunk, Allocator* allocator)
+{
+    PROFILE_SCOPE("Chunk Mesh");
+    // Worst case is a checkerboard, half the voxels solid with all six faces visible
+    const size_t maxVerts = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 18;
+    // Edited chunks are still drawn and counted from vertexCount meanwhile, so the new mesh stays in the pending fields
+    chunk->pendingVerts = (VoxelChunkVertexData*)allocator->allocate(sizeof(VoxelChunkVertexData) * maxVerts);
+    chunk->pendingVertexCount = 0;
+    chunk->voxels->createTriangleMeshPacked(chunk->pendingVerts, chunk->pendingVertexCount);
+}
+
+void ChunkStreamer::BuildChunkShapeInThread(TerrainChunk* chunk)
+{
+    PROFILE_SCOPE("Chunk Physics Shape");
+    chunk->voxels->getAABBs(chunk->aabbs, glm::vec3(0.5f));
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Coord.h"
+#include "JobSystem.h"
+#include "RendererDefines.h"
+#include "VoxelAABB.h"
+#include "VoxelChunkVertex.h"
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
+
+class Allocator;
+class CompressedVoxelData;
+class RegionStore;
+class VoxelData;
+
+const int CHUNK_SIZE = 16;
+
+// Chunks move through these stages, everything up to Uploading runs as
+// jobs on the thread pool, the upload itself happens on the main thread
+enum class ChunkState {
+    Generating,
+    Meshing,
+    Uploading,
+    Loaded
+};
+
+struct TerrainChunk {
+    ChunkState state;
+    Coord3D coord;
+    CompressedVoxelData* compressed;        // Always up to date unless voxels have dirty bricks
+    VoxelData* voxels;                      // Only kept while the chunk is meshed or edited
+    VoxelChunkVertexData* pendingVerts;     // Written by the mesh job, only handed over by the upload
+    size_t pendingVertexCount;
+    std::vector<VoxelAABB> aabbs;
+    DrawDataID drawDataID;
+    size_t vertexCount;                     // Of the uploaded mesh, main thread only
+    uint32_t physicsShapeID;
+    uint32_t physicsBodyID;
+    bool edited;                            // Has edits the region store hasn't been given yet
+    JobCounter generateJob;
+    JobCounter meshJob;
+    JobCounter shapeJob;
+};
+
+// Main thread side of the chunks, gives their meshes and collision boxes to the renderer and physics
+class ChunkUploadHandler
+{
+public:
+    virtual ~ChunkUploadHandler() {}
+
+    // The chunk's pendingVerts and aabbs hold the new mesh, they are released after the call
+    // Re-meshed chunks still have their draw data and collision body from the last upload
+    virtual void uploadChunk(TerrainChunk& chunk) = 0;
+    // Drops the chunk's draw data and collision body, if it has any
+    virtual void releaseChunk(TerrainChunk& chunk) = 0;
+};
+
+struct ChunkStreamStats {
+    int32_t chunksEvicted;
+    size_t chunksUploaded;
+    size_t loadedBytes;                     // Voxels and meshes of chunks no job is working on
+};
+
+// Streams the terrain chunks around a center coordinate.
+// Missing chunks are loaded from the region store or generated, then meshed, on the job system.
+// Chunks out of range give their voxels to a cache of compressed chunks so coming back skips
+// generation, edited ones are written to the region store first.
+class ChunkStreamer
+{
+public:
+    ChunkStreamer(
+        Allocator& allocator,
+        JobSystem& jobSystem,
+        RegionStore& regionStore,
+        ChunkUploadHandler& uploadHandler);
+    ~ChunkStreamer();
+
+    // Unloads chunks further than unloadRadius from the center, starts the missing ones within radius
+    // and moves the others along, uploading for up to uploadBudgetMS but at least one chunk
+    ChunkStreamStats update(
+        const Coord3D& center,
+        const int radius,
+        const int unloadRadius,
+        const size_t maxCachedBytes,
+        const double uploadBudgetMS);
+
+    // Changes one voxel of a loaded chunk, it gets re-meshed by the next update
+    bool setVoxel(const Coord3D& coord, const int x, const int y, const int z, const uint8_t type);
+
+    // Hands every edited chunk to the region store
+    void storeEditedChunks();
+    // Waits for the jobs and drops every chunk, edited ones are stored first
+    void releaseAll();
+
+    const std::map<Coord3D, TerrainChunk>& getChunks() const { return m_chunks; }
+    const TerrainChunk* getChunk(const Coord3D& coord) const;
+    const CompressedVoxelData* getCachedChunk(const Coord3D& coord) const;
+    size_t getNumCachedChunks() const { return m_cachedChunks.size(); }
+    size_t getCachedBytes() const { return m_cachedChunkBytes; }
+
+private:
+    Allocator& m_allocator;
+    JobSystem& m_jobSystem;
+    RegionStore& m_regionStore;
+    ChunkUploadHandler& m_uploadHandler;
+
+    std::map<Coord3D, TerrainChunk> m_chunks;
+
+    // Voxels of recently unloaded chunks, kept so revisiting them skips generation
+    struct CachedChunk {
+        CompressedVoxelData* voxels;
+        std::list<Coord3D>::iterator lruIt;
+    };
+
+    std::map<Coord3D, CachedChunk> m_cachedChunks;
+    std::list<Coord3D> m_cachedChunkLRU;        // Most recently unloaded at the front
+    size_t m_cachedChunkBytes;
+
+    void startChunkMeshing(TerrainChunk& chunk, const JobPriority priority);
+    void uploadChunk(TerrainChunk& chunk);
+    void unloadChunk(TerrainChunk& chunk);
+    void releaseChunkUpload(TerrainChunk& chunk);
+    void releaseChunkVoxels(TerrainChunk& chunk);
+    void storeEditedChunk(TerrainChunk& chunk);
+    void trimChunkCache(const size_t maxBytes);
+    void waitForChunkJobs(TerrainChunk& chunk);
+
+    static void GenerateChunkInThread(TerrainChunk* chunk, Allocator* allocator, RegionStore* regionStore);
+    static void MeshChunkInThread(TerrainChunk* chunk, Allocator* allocator);
+    static void BuildChunkShapeInThread(TerrainChunk* chunk);
+};
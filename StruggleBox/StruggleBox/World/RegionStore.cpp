@@ -0,0 +1,291 @@
+#include "RegionStore.h"
+
+#include "Allocator.h"
+#include "ArenaOperators.h"
+#include "FileUtil.h"
+#include "Log.h"
+#include "Serialise.h"
+#include "VoxelData.h"
+#include "zlib.h"
+#include <cstring>
+
+#define REGION_HEADER "SBRgn"   // Must be 5 characters
+#define REGION_VERSION "0.2"    // Must be 3 characters
+
+RegionStore::RegionStore(Allocator& allocator, JobSystem& jobSystem)
+	: m_allocator(allocator)
+	, m_jobSystem(jobSystem)
+	, m_writeJobQueued(false)
+{
+}
+
+RegionStore::~RegionStore()
+{
+	close();
+}
+
+void RegionStore::open(const std::string& path)
+{
+	close();
+	m_path = path;
+	if (!FileUtil::DoesFolderExist(m_path))
+	{
+		FileUtil::CreateFolder(m_path);
+	}
+}
+
+void RegionStore::close()
+{
+	flush();
+	std::lock_guard<std::mutex> lock(m_fileMutex);
+	closeRegions();
+	m_path.clear();
+}
+
+void RegionStore::flush()
+{
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_pendingMutex);
+			if (!m_writeJobQueued)
+			{
+				return;
+			}
+		}
+		// The job only finishes once nothing is pending, a new one may have started since
+		m_jobSystem.wait(m_writeJob);
+	}
+}
+
+void RegionStore::storeChunk(const Coord3D& coord, const VoxelData& voxels)
+{
+	const uLong numVoxels = (uLong)voxels.getMemoryUsage();
+	std::vector<unsigned char> record(REGION_RECORD_HEADER_SIZE + compressBound(numVoxels));
+	uLongf compressedSize = compressBound(numVoxels);
+	if (compress2(record.data() + REGION_RECORD_HEADER_SIZE, &compressedSize, voxels.getData(), numVoxels, Z_BEST_SPEED) != Z_OK)
+	{
+		Log::Error("[RegionStore] Failed to compress chunk %i, %i, %i", coord.x, coord.y, coord.z);
+		return;
+	}
+	Serialise::serialise((unsigned int)numVoxels, record.data());
+	Serialise::serialise((unsigned int)crc32(0L, voxels.getData(), (uInt)numVoxels), record.data() + SERIALISED_INT_SIZE);
+	record.resize(REGION_RECORD_HEADER_SIZE + compressedSize);
+
+	bool queueWriteJob = false;
+	{
+		std::lock_guard<std::mutex> lock(m_pendingMutex);
+		m_pending[coord].swap(record);
+		queueWriteJob = !m_writeJobQueued;
+		m_writeJobQueued = true;
+	}
+	// Added outside the lock, without workers the job runs right here and takes it itself
+	if (queueWriteJob)
+	{
+		RegionStore* store = this;
+		m_jobSystem.addJob(JobPriority::Low, &m_writeJob, [store]() { store->writePending(); });
+	}
+}
+
+bool RegionStore::loadChunk(const Coord3D& coord, VoxelData& voxels)
+{
+	std::vector<unsigned char> record;
+	{
+		std::lock_guard<std::mutex> lock(m_pendingMutex);
+		auto it = m_pending.find(coord);
+		if (it != m_pending.end())
+		{
+			record = it->second;
+		}
+	}
+	if (record.empty())
+	{
+		std::lock_guard<std::mutex> lock(m_fileMutex);
+		Region* region = getRegion(getRegionCoord(coord), false);
+		if (!region)
+		{
+			return false;
+		}
+		const int index = getRegionIndex(coord);
+		if (region->sizes[index] == 0)
+		{
+			return false;
+		}
+		record.resize(region->sizes[index]);
+		region->file.seekg(region->offsets[index]);
+		region->file.read((char*)record.data(), record.size());
+		if ((size_t)region->file.gcount() != record.size())
+		{
+			region->file.clear();
+			Log::Error("[RegionStore] Truncated record for chunk %i, %i, %i", coord.x, coord.y, coord.z);
+			return false;
+		}
+	}
+
+	// Decompress outside of the locks so loads can run side by side
+	const uLong numVoxels = (uLong)voxels.getMemoryUsage();
+	if (record.size() < REGION_RECORD_HEADER_SIZE ||
+		Serialise::deserialiseInt(record.data()) != numVoxels)
+	{
+		Log::Error("[RegionStore] Bad record for chunk %i, %i, %i", coord.x, coord.y, coord.z);
+		return false;
+	}
+	uLongf decodedSize = numVoxels;
+	if (uncompress(voxels.getData(), &decodedSize, record.data() + REGION_RECORD_HEADER_SIZE, (uLong)record.size() - REGION_RECORD_HEADER_SIZE) != Z_OK ||
+		decodedSize != numVoxels ||
+		crc32(0L, voxels.getData(), (uInt)numVoxels) != Serialise::deserialiseInt(record.data() + SERIALISED_INT_SIZE))
+	{
+		Log::Error("[RegionStore] Damaged record for chunk %i, %i, %i", coord.x, coord.y, coord.z);
+		voxels.clear();
+		return false;
+	}
+	voxels.markAllDirty();
+	return true;
+}
+
+void RegionStore::writePending()
+{
+	while (true)
+	{
+		// Taking the file lock first keeps loads from missing records between the two maps
+		std::lock_guard<std::mutex> fileLock(m_fileMutex);
+		std::map<Coord3D, std::vector<unsigned char>> records;
+		{
+			std::lock_guard<std::mutex> lock(m_pendingMutex);
+			if (m_pending.empty())
+			{
+				m_writeJobQueued = false;
+				return;
+			}
+			records.swap(m_pending);
+		}
+
+		for (const auto& pair : records)
+		{
+			const Coord3D& coord = pair.first;
+			const std::vector<unsigned char>& record = pair.second;
+			Region* region = getRegion(getRegionCoord(coord), true);
+			if (!region)
+			{
+				continue;
+			}
+			// A record that fits replaces the chunk's old one in place, larger ones are appended
+			const int index = getRegionIndex(coord);
+			const bool reuseSlot = region->sizes[index] != 0 && record.size() <= region->capacities[index];
+			if (!reuseSlot && (uint64_t)region->fileSize + record.size() > UINT32_MAX)
+			{
+				Log::Error("[RegionStore] Region file full, chunk %i, %i, %i not stored", coord.x, coord.y, coord.z);
+				continue;
+			}
+			const uint32_t offset = reuseSlot ? region->offsets[index] : region->fileSize;
+			region->file.seekp(offset);
+			region->file.write((const char*)record.data(), record.size());
+
+			unsigned char entry[REGION_TABLE_ENTRY_SIZE];
+			Serialise::serialise((unsigned int)offset, entry);
+			Serialise::serialise((unsigned int)record.size(), entry + SERIALISED_INT_SIZE);
+			Serialise::serialise((unsigned int)(reuseSlot ? region->capacities[index] : record.size()), entry + SERIALISED_INT_SIZE * 2);
+			region->file.seekp(REGION_TAG_SIZE + index * REGION_TABLE_ENTRY_SIZE);
+			region->file.write((const char*)entry, REGION_TABLE_ENTRY_SIZE);
+
+			region->offsets[index] = offset;
+			region->sizes[index] = (uint32_t)record.size();
+			if (!reuseSlot)
+			{
+				region->capacities[index] = (uint32_t)record.size();
+				region->fileSize += (uint32_t)record.size();
+			}
+		}
+		for (auto& pair : m_regions)
+		{
+			pair.second->file.flush();
+		}
+	}
+}
+
+RegionStore::Region* RegionStore::getRegion(const Coord3D& regionCoord, const bool create)
+{
+	auto it = m_regions.find(regionCoord);
+	if (it != m_regions.end())
+	{
+		return it->second;
+	}
+	if (m_path.empty())
+	{
+		return nullptr;
+	}
+
+	const std::string fileName = getRegionFileName(regionCoord);
+	const bool exists = FileUtil::DoesFileExist(m_path, fileName);
+	if (!exists && !create)
+	{
+		return nullptr;
+	}
+	const std::string absolutePath = m_path + fileName;
+	if (!exists)
+	{
+		// Write the tag and an empty table so the file can be opened for updating
+		std::ofstream newFile(absolutePath.c_str(), std::ios::out | std::ios::binary);
+		std::vector<unsigned char> header(REGION_HEADER_SIZE, 0);
+		memcpy(header.data(), REGION_HEADER, 5);
+		memcpy(header.data() + 5, REGION_VERSION, 3);
+		newFile.write((const char*)header.data(), header.size());
+	}
+
+	Region* region = CUSTOM_NEW(Region, m_allocator)();
+	region->file.open(absolutePath.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+	std::vector<unsigned char> header(REGION_HEADER_SIZE);
+	region->file.read((char*)header.data(), header.size());
+	if (!region->file ||
+		strncmp((const char*)header.data(), REGION_HEADER, 5) != 0 ||
+		strncmp((const char*)header.data() + 5, REGION_VERSION, 3) != 0)
+	{
+		Log::Error("[RegionStore] Bad region file %s", absolutePath.c_str());
+		CUSTOM_DELETE(region, m_allocator);
+		return nullptr;
+	}
+	for (int index = 0; index < REGION_NUM_CHUNKS; index++)
+	{
+		const unsigned char* entry = header.data() + REGION_TAG_SIZE + index * REGION_TABLE_ENTRY_SIZE;
+		region->offsets[index] = Serialise::deserialiseInt(entry);
+		region->sizes[index] = Serialise::deserialiseInt(entry + SERIALISED_INT_SIZE);
+		region->capacities[index] = Serialise::deserialiseInt(entry + SERIALISED_INT_SIZE * 2);
+	}
+	region->file.seekg(0, std::ios::end);
+	region->fileSize = (uint32_t)region->file.tellg();
+	m_regions[regionCoord] = region;
+	return region;
+}
+
+void RegionStore::closeRegions()
+{
+	for (auto& pair : m_regions)
+	{
+		pair.second->file.close();
+		CUSTOM_DELETE(pair.second, m_allocator);
+	}
+	m_regions.clear();
+}
+
+Coord3D RegionStore::getRegionCoord(const Coord3D& coord)
+{
+	// Round towards negative infinity so negative chunks don't share region 0
+	auto regionFor = [](const int chunk) {
+		return chunk >= 0 ? chunk / REGION_SIZE : (chunk + 1) / REGION_SIZE - 1;
+	};
+	return Coord3D(regionFor(coord.x), regionFor(coord.y), regionFor(coord.z));
+}
+
+int RegionStore::getRegionIndex(const Coord3D& coord)
+{
+	const Coord3D regionCoord = getRegionCoord(coord);
+	const int x = coord.x - regionCoord.x * REGION_SIZE;
+	const int y = coord.y - regionCoord.y * REGION_SIZE;
+	const int z = coord.z - regionCoord.z * REGION_SIZE;
+	return x + (y * REGION_SIZE) + (z * REGION_SIZE * REGION_SIZE);
+}
+
+std::string RegionStore::getRegionFileName(const Coord3D& regionCoord) const
+{
+	return "r." + std::to_string(regionCoord.x) + "." + std::to_string(regionCoord.y) + "." + std::to_string(regionCoord.z) + ".region";
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Coord.h"
+#include "JobSystem.h"
+#include "Serialise.h"
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Allocator;
+class VoxelData;
+
+const int REGION_SIZE = 16; // Chunks per region side
+const int REGION_NUM_CHUNKS = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+
+// File layout, integers are big endian:
+// "SBRgn0.2", REGION_NUM_CHUNKS table entries of record offset, size and slot capacity, records
+// Record: voxel count, CRC32 of the voxels, zlib stream
+// A chunk's slot can be larger than its record when a smaller one replaced it
+const int REGION_TAG_SIZE = 8;
+const int REGION_TABLE_ENTRY_SIZE = SERIALISED_INT_SIZE * 3;
+const int REGION_HEADER_SIZE = REGION_TAG_SIZE + REGION_NUM_CHUNKS * REGION_TABLE_ENTRY_SIZE;
+const int REGION_RECORD_HEADER_SIZE = SERIALISED_INT_SIZE * 2;
+
+// Persists terrain chunks in region files, each holding up to REGION_SIZE^3 chunks.
+// A region file starts with an offset table and holds chunks as zlib compressed records.
+// A stored chunk overwrites its old record when it fits the slot, otherwise it gets appended
+// and the table entry is pointed at the new record. Slot capacities are kept in the table so
+// records can shrink and grow again across sessions without wasting space.
+// Stored chunks are compressed on the calling thread and written by a low priority job,
+// loads are thread safe and see chunks that are still waiting to be written.
+class RegionStore
+{
+public:
+	RegionStore(Allocator& allocator, JobSystem& jobSystem);
+	~RegionStore();
+
+	// Folder the region files live in, closes the previous one
+	void open(const std::string& path);
+	void close();
+	// Blocks until every stored chunk has been written
+	void flush();
+
+	void storeChunk(const Coord3D& coord, const VoxelData& voxels);
+	// Returns false if the chunk was never stored or its record is damaged
+	bool loadChunk(const Coord3D& coord, VoxelData& voxels);
+
+	const std::string& getPath() const { return m_path; }
+
+private:
+	struct Region {
+		std::fstream file;
+		uint32_t offsets[REGION_NUM_CHUNKS];
+		uint32_t sizes[REGION_NUM_CHUNKS];
+		uint32_t capacities[REGION_NUM_CHUNKS];    // Bytes the record slot can hold
+		uint32_t fileSize;
+	};
+
+	Allocator& m_allocator;
+	JobSystem& m_jobSystem;
+	std::string m_path;
+
+	// Compressed records waiting for the write job, newest per chunk
+	std::map<Coord3D, std::vector<unsigned char>> m_pending;
+	std::mutex m_pendingMutex;
+	JobCounter m_writeJob;
+	bool m_writeJobQueued;
+
+	// Guards the regions and their files
+	std::map<Coord3D, Region*> m_regions;
+	std::mutex m_fileMutex;
+
+	void writePending();
+	Region* getRegion(const Coord3D& regionCoord, const bool create);
+	void closeRegions();
+
+	static Coord3D getRegionCoord(const Coord3D& coord);
+	static int getRegionIndex(const Coord3D& coord);
+	std::string getRegionFileName(const Coord3D& regionCoord) const;
+};
@@ -4,8 +4,8 @@
 #include "ArenaOperators.h"
 #include "CoreIncludes.h"
 #include "CommandProcessor.h"
+#include "Injector.h"
 #include "Options.h"
-#include "Frustum.h"            // Frustum culling of chunks
 #include "VoxelRenderer.h"
 #include "Shader.h"
 #include "Camera3D.h"
@@ -13,6 +13,7 @@
 #include "FileUtil.h"
 #include "Timer.h"
 #include "Random.h"
+#include "JobSystem.h"
 
 #include "Particles.h"
 #include "ParticleSystem.h"
@@ -20,6 +21,7 @@
 #include "Serialise.h"
 #include "EntityManager.h"
 #include "Entity.h"
+#include "EntityAttributes.h"
 #include "VoxelComponent.h"
 #include "ExplosiveComponent.h"
 #include "HumanoidComponent.h"
@@ -32,11 +34,16 @@
 #include "Light3DComponent.h"
 #include "RenderComponent.h"
 #include "SelfDestructComponent.h"
+#include "Profiler.h"
 
 #include <fstream>              // file streams
 #include <glm/gtc/matrix_transform.hpp>     // glm::translate, glm::rotate, glm::scale
 #include <glm/gtc/noise.hpp>    // glm::simplex
 
+const int CHUNK_RADIUS = 1;
+const int CHUNK_UNLOAD_RADIUS = CHUNK_RADIUS + 1; // Slack so crossing a border back and forth doesn't thrash
+const double CHUNK_UPLOAD_BUDGET_MS = 2.0;  // Main thread time allowed for chunk uploads per frame
+
 // World globals
 float World3D::worldTimeScale = 1.0f;
 bool World3D::physicsEnabled = true;
@@ -47,17 +54,22 @@ World3D::World3D(
     Injector& injector,
     VoxelRenderer& renderer,
 	Options& options) 
-    : m_allocator(allocator)
+    : m_allocator(allocator, MemoryTag::Voxels)
     , m_renderer(renderer)
     , m_options(options)
+    , m_jobSystem(injector.getInstance<JobSystem>())
+    , m_statTracker(injector.getInstance<StatTracker>())
     , m_particles(allocator, injector)
     , m_physics(allocator)
     , m_voxelCache(renderer, allocator)
-    , m_entityMan(allocator, renderer, m_voxelCache, m_particles, m_physics)
+    , m_entityMan(allocator, m_jobSystem, renderer, m_voxelCache, m_particles, m_physics)
+    , m_regionStore(m_allocator, m_jobSystem)
     , m_refreshPhysics(false)
     , m_gameTime(0.0)
     , m_voxelInstancesShaderID(0)
+    , m_materialData()
     , m_playerID(0)
+    , m_chunkStreamer(m_allocator, m_jobSystem, m_regionStore, *this)
 {
 	Log::Info("[World3D] Constructor, instance at %p", this);
 }
@@ -77,6 +89,14 @@ void World3D::Initialize()
 
     m_voxelInstancesShaderID = m_renderer.getRenderCore().getShaderID("d_cube_instance_fancy.vsh", "d_cube_instance_fancy.fsh");
 
+    // Terrain chunk vertices only carry a material ID, the renderer looks the rest up
+    m_materialData.load(FileUtil::GetPath() + "Data/Materials/default.plist");
+    for (uint32_t materialID = 1; materialID < 256; materialID++)
+    {
+        const MaterialDef& material = m_materialData[materialID];
+        m_renderer.setChunkMaterial(materialID, material.albedo, glm::vec3(material.roughness, material.metalness, 0.f));
+    }
+
     m_renderer.getDefaultCamera().setPhysicsCallback(std::bind(&Physics::cameraCollision, &m_physics, std::placeholders::_1, std::placeholders::_2));
         
     std::string dirName = FileUtil::GetPath().append("Worlds3D/");
@@ -86,6 +106,7 @@ void World3D::Initialize()
     if (!FileUtil::DoesFolderExist(dirName + worldName + "/")) {
         FileUtil::CreateFolder(dirName + worldName + "/");
     }
+    m_regionStore.open(dirName + worldName + "/");
 
 	const float lightAmb = 0.0;
 	const float lightRadius = roomWidth;
@@ -125,7 +146,7 @@ void World3D::Initialize()
     m_playerID = Spawn(FileUtil::GetPath().append("Data/Entities/"), "Player.plist");
     Entity* player = m_entityMan.getEntity(m_playerID);    // Temporary stuff, we shouldn't hold pointers to entities just int ID
     
-    glm::vec3& playerPos = player->GetAttributeDataPtr<glm::vec3>("position");
+    glm::vec3& playerPos = player->GetAttributeData(ATTR_POSITION);
     
     const float floorPos = -((roomWidth * 0.5f) - (floorTileWidth));
 
@@ -153,9 +174,9 @@ void World3D::Initialize()
         objPos.z -= objectDistance;
         const EntityID entityID = Spawn(FileUtil::GetPath().append("Data/Entities/"), itemFile);
         Entity* entity = m_entityMan.getEntity(entityID);
-        entity->GetAttributeDataPtr<glm::vec3>("position") = objPos + glm::vec3(0.f, 2.0f, 0.f);
+        entity->GetAttributeData(ATTR_POSITION) = objPos + glm::vec3(0.f, 2.0f, 0.f);
 
-        PhysicsComponent* physComponent = (PhysicsComponent*)m_entityMan.getComponent(entityID, "Physics");
+        PhysicsComponent* physComponent = m_entityMan.getComponent<PhysicsComponent>(entityID);
         if (physComponent)
         {
             physComponent->setPhysicsMode(PhysicsMode::Physics_Cube_AABBs, false, false);
@@ -173,7 +194,7 @@ World3D::~World3D()
 {
     if (m_playerID)
     {
-//        int playerID = player->GetAttributeDataPtr<int>("ID");
+//        int playerID = player->GetAttributeData(ATTR_ID);
 //        entityMan->removeEntity(playerID);
         m_playerID = 0;
     }
@@ -189,6 +210,9 @@ World3D::~World3D()
         CUSTOM_DELETE(cube, m_allocator);
     }
     staticCubes.clear();
+
+    m_chunkStreamer.releaseAll();
+    m_regionStore.close();
 }
 
 const int World3D::Spawn(std::string filePath, std::string fileName) {
@@ -208,10 +232,10 @@ const int World3D::SpawnItem(const ItemType type,
     Entity* newEnt = m_entityMan.getEntity(newEntID);
     ItemComponent* itemComponent = new ItemComponent(newEntID, m_entityMan, m_particles);
     m_entityMan.setComponent(newEntID, itemComponent);
-    newEnt->GetAttributeDataPtr<int>("itemType") = type;
-    newEnt->GetAttributeDataPtr<glm::vec3>("position") = pos;
-    newEnt->GetAttributeDataPtr<glm::quat>("rotation") = rot;
-    newEnt->GetAttributeDataPtr<std::string>("objectFile") = object;
+    newEnt->GetAttributeData(ATTR_ITEM_TYPE) = type;
+    newEnt->GetAttributeData(ATTR_POSITION) = pos;
+    newEnt->GetAttributeData(ATTR_ROTATION) = rot;
+    newEnt->GetAttributeData(ATTR_OBJECT_FILE) = object;
     PhysicsComponent* physComponent = new PhysicsComponent(
 		newEntID,
 		m_entityMan,
@@ -232,7 +256,7 @@ const int World3D::SpawnItem(const ItemType type,
 const int World3D::AddPlayer(const glm::vec3 pos)
 {
     int newEntID = Spawn(FileUtil::GetPath().append("Data/Entities/"), "Player.plist");
-    HumanoidComponent* humanoid = (HumanoidComponent*)m_entityMan.getComponent(newEntID, "Humanoid");
+    HumanoidComponent* humanoid = m_entityMan.getComponent<HumanoidComponent>(newEntID);
     humanoid->Warp(pos);
     return newEntID;
 }
@@ -240,7 +264,7 @@ const int World3D::AddPlayer(const glm::vec3 pos)
 const int World3D::AddSkeleton(const glm::vec3 pos)
 {
     int newEntID = Spawn(FileUtil::GetPath().append("Data/Entities/"), "Skeleton.plist");
-    HumanoidComponent* humanoid = (HumanoidComponent*)m_entityMan.getComponent(newEntID, "Humanoid");
+    HumanoidComponent* humanoid = m_entityMan.getComponent<HumanoidComponent>(newEntID);
     humanoid->Warp(pos);
     return newEntID;
 }
@@ -248,7 +272,7 @@ const int World3D::AddSkeleton(const glm::vec3 pos)
 const int World3D::AddHuman(const glm::vec3 pos)
 {
     int newEntID = Spawn(FileUtil::GetPath().append("Data/Entities/"), "Player.plist");
-    HumanoidComponent* humanoid = (HumanoidComponent*)m_entityMan.getComponent(newEntID, "Humanoid");
+    HumanoidComponent* humanoid = m_entityMan.getComponent<HumanoidComponent>(newEntID);
     humanoid->Warp(pos);
     return newEntID;
 }
@@ -259,10 +283,10 @@ void World3D::AddDecor(const std::string& object, const glm::vec3 pos, const glm
     newName.append(intToString(Entity::GetNextEntityID()));
     int newEntID = m_entityMan.addEntity(newName);
     Entity* newEnt = m_entityMan.getEntity(newEntID);
-    newEnt->GetAttributeDataPtr<int>("ownerID") = -1;
-    newEnt->GetAttributeDataPtr<int>("type") = ENTITY_DECOR;
-    newEnt->GetAttributeDataPtr<glm::vec3>("position") = pos;
-    newEnt->GetAttributeDataPtr<std::string>("objectFile") = object;
+    newEnt->GetAttributeData(ATTR_OWNER_ID) = -1;
+    newEnt->GetAttributeData(ATTR_TYPE) = ENTITY_DECOR;
+    newEnt->GetAttributeData(ATTR_POSITION) = pos;
+    newEnt->GetAttributeData(ATTR_OBJECT_FILE) = object;
     PhysicsComponent* physComponent = CUSTOM_NEW(PhysicsComponent, m_allocator)(newEntID, m_entityMan, m_physics, m_voxelCache);
     m_entityMan.setComponent(newEntID, physComponent);
     physComponent->setPhysicsMode(PhysicsMode::Physics_Cube_AABBs, false, false);
@@ -276,9 +300,9 @@ void World3D::AddParticleEntity(const std::string& fileName, const glm::vec3 pos
     newName.append(intToString(Entity::GetNextEntityID()));
     int newEntID = m_entityMan.addEntity(newName);
     Entity* newEnt = m_entityMan.getEntity(newEntID);
-    newEnt->GetAttributeDataPtr<int>("ownerID") = -1;
-    newEnt->GetAttributeDataPtr<int>("type") = ENTITY_DEBRIS;
-    newEnt->GetAttributeDataPtr<glm::vec3>("position") = pos;
+    newEnt->GetAttributeData(ATTR_OWNER_ID) = -1;
+    newEnt->GetAttributeData(ATTR_TYPE) = ENTITY_DEBRIS;
+    newEnt->GetAttributeData(ATTR_POSITION) = pos;
     ParticleComponent* particleComponent = CUSTOM_NEW(ParticleComponent, m_allocator)(newEntID, fileName, m_entityMan, m_particles);
     particleComponent->activate();
     m_entityMan.setComponent(newEntID, particleComponent);
@@ -296,11 +320,11 @@ const EntityID World3D::createFireball(const glm::vec3& pos, const glm::vec3& ve
     const std::string newName = "Particle_" + intToString(Entity::GetNextEntityID());
     const EntityID newEntID = m_entityMan.addEntity(newName);
     Entity* newEnt = m_entityMan.getEntity(newEntID);
-    newEnt->GetAttributeDataPtr<int>("ownerID") = -1;
-    newEnt->GetAttributeDataPtr<int>("type") = ENTITY_PROJECTILE;
-    newEnt->GetAttributeDataPtr<glm::vec3>("position") = pos;
-    newEnt->GetAttributeDataPtr<float>("sphereRadius") = size;
-    newEnt->GetAttributeDataPtr<int>("ownerID") = 0;
+    newEnt->GetAttributeData(ATTR_OWNER_ID) = -1;
+    newEnt->GetAttributeData(ATTR_TYPE) = ENTITY_PROJECTILE;
+    newEnt->GetAttributeData(ATTR_POSITION) = pos;
+    newEnt->GetAttributeData(ATTR_SPHERE_RADIUS) = size;
+    newEnt->GetAttributeData(ATTR_OWNER_ID) = 0;
     PhysicsComponent* physComponent = (PhysicsComponent*)m_entityMan.addComponent(newEntID, "Physics");
     m_entityMan.setComponent(newEntID, physComponent);
     physComponent->setPhysicsMode(PhysicsMode::Physics_Sphere, false, false);
@@ -326,6 +350,7 @@ const EntityID World3D::createFireball(const glm::vec3& pos, const glm::vec3& ve
 
 void World3D::Update(const double delta)
 {
+    PROFILE_SCOPE("World3D::Update");
     if (paused)
     {
         m_entityMan.update(0.0);
@@ -336,9 +361,9 @@ void World3D::Update(const double delta)
 
     if (Entity* player = m_entityMan.getEntity(m_playerID))
     {
-        playerLight.position.x = player->GetAttributeDataPtr<glm::vec3>("position").x;
-        playerLight.position.y = player->GetAttributeDataPtr<glm::vec3>("position").y + 2.0f;
-        playerLight.position.z = player->GetAttributeDataPtr<glm::vec3>("position").z;
+        playerLight.position.x = player->GetAttributeData(ATTR_POSITION).x;
+        playerLight.position.y = player->GetAttributeData(ATTR_POSITION).y + 2.0f;
+        playerLight.position.z = player->GetAttributeData(ATTR_POSITION).z;
     }
 
     updateChunks();
@@ -393,22 +418,22 @@ void World3D::UpdateLabels()
     {
         int numLabel = 0;
         Entity* player = m_entityMan.getEntity(m_playerID);
-        glm::vec3 playerPos = player->GetAttributeDataPtr<glm::vec3>("position");
+        glm::vec3 playerPos = player->GetAttributeData(ATTR_POSITION);
         Entity* nearestEntity = m_entityMan.getNearestEntity(playerPos, m_playerID, ENTITY_ITEM);
-        std::map<EntityID, Entity*> nearbyEnts = m_entityMan.getNearbyEntities(playerPos, m_playerID, ENTITY_ITEM);
-        std::map<EntityID, Entity*>::iterator it = nearbyEnts.begin();
-        
-        while (it != nearbyEnts.end())
+        m_nearbyEntities.clear();
+        m_entityMan.getNearbyEntities(playerPos, m_nearbyEntities, m_playerID, ENTITY_ITEM);
+
+        for (Entity* nearbyEntity : m_nearbyEntities)
         {
-            const int instIDAttr = it->second->GetAttributeDataPtr<int>("instanceID");
+            const int instIDAttr = nearbyEntity->GetAttributeData(ATTR_INSTANCE_ID);
             if (instIDAttr != -1)
             {
                 Color textColor = COLOR_WHITE;
-                if (it->second == nearestEntity) {
+                if (nearbyEntity == nearestEntity) {
                     textColor = COLOR_GREEN;
                 }
-                std::string entityName = it->second->GetAttributeDataPtr<std::string>("name");
-                glm::vec3 entityPos = it->second->GetAttributeDataPtr<glm::vec3>("position");
+                std::string entityName = nearbyEntity->GetAttributeData(ATTR_NAME);
+                glm::vec3 entityPos = nearbyEntity->GetAttributeData(ATTR_POSITION);
                 
                 if ( numLabel < objectLabels.size() ) {
                     //_text->UpdateText(objectLabels[numLabel], entityName);
@@ -428,19 +453,13 @@ void World3D::UpdateLabels()
                 }
                 numLabel++;
             }
-            else
-            {
-                nearbyEnts.erase(it++);
-                continue;
-            }
-            it++;
         }
         // Erase unnecessary labels
-        if ( nearbyEnts.size() < objectLabels.size() ) {
-            //for (size_t i=nearbyEnts.size(); i<objectLabels.size(); i++) {
+        if ( numLabel < objectLabels.size() ) {
+            //for (size_t i=numLabel; i<objectLabels.size(); i++) {
             //    _text->RemoveText( objectLabels[i] );
             //}
-            //objectLabels.erase(objectLabels.begin()+nearbyEnts.size(),
+            //objectLabels.erase(objectLabels.begin()+numLabel,
             //                   objectLabels.end());
         }
     }
@@ -459,7 +478,10 @@ void World3D::ClearLabels()
 
 void World3D::Draw()
 {
-    DrawObjects();
+    PROFILE_SCOPE("World3D::Draw");
+    const Camera3D& camera = m_renderer.getDefaultCamera();
+    const Frustum frustum(camera.getProjectionMatrix() * camera.getViewMatrix());
+    DrawObjects(frustum);
 
     // Draw debug physics
     if (physicsEnabled &&
@@ -478,20 +500,41 @@ void World3D::Draw()
 
     m_particles.draw();
 
-    for (const auto& pair : m_chunks)
+    // Chunk voxels are centered on coord * CHUNK_SIZE
+    const glm::vec3 chunkExtents = glm::vec3(CHUNK_SIZE * 0.5f);
+    m_chunkBounds.clear();
+    m_chunkDrawList.clear();
+    for (const auto& pair : m_chunkStreamer.getChunks())
     {
         const TerrainChunk& chunk = pair.second;
         if (chunk.drawDataID == 0)
         {
             continue;
         }
-        m_renderer.queueVoxelChunk(chunk.drawDataID);
+        const glm::vec3 offset = glm::vec3(chunk.coord.x * CHUNK_SIZE, chunk.coord.y * CHUNK_SIZE, chunk.coord.z * CHUNK_SIZE);
+        m_chunkBounds.push_back({ offset, chunkExtents });
+        m_chunkDrawList.push_back(&chunk);
     }
+    m_chunkVisibility.assign(m_chunkBounds.size(), 0);
+    frustum.cullBoxes(m_chunkBounds.data(), m_chunkBounds.size(), m_chunkVisibility.data(), 1);
+
+    int32_t chunksCulled = 0;
+    for (size_t i = 0; i < m_chunkDrawList.size(); i++)
+    {
+        if (m_chunkVisibility[i] == 0)
+        {
+            chunksCulled++;
+            continue;
+        }
+        const TerrainChunk& chunk = *m_chunkDrawList[i];
+        m_renderer.queueVoxelChunk(chunk.drawDataID, m_chunkBounds[i].center - chunkExtents, 1.f);
+    }
+    m_statTracker.trackIntValue(chunksCulled, "Chunks Culled");
 }
 
-void World3D::DrawObjects()
+void World3D::DrawObjects(const Frustum& frustum)
 {
-    m_voxelCache.draw();
+    m_voxelCache.draw(frustum);
 
     for (const PhysicsCube* cube : staticCubes)
     {
@@ -574,68 +617,103 @@ void World3D::Explosion(const glm::vec3 position,
     //}
 }
 
+bool World3D::setTerrainVoxel(const glm::vec3& position, const uint8_t type)
+{
+    // Chunk voxels are centered on coord * CHUNK_SIZE, see Draw()
+    const float halfChunk = CHUNK_SIZE * 0.5f;
+    const Coord3D coord = Coord3D(
+        (int)floor((position.x + halfChunk) / CHUNK_SIZE),
+        (int)floor((position.y + halfChunk) / CHUNK_SIZE),
+        (int)floor((position.z + halfChunk) / CHUNK_SIZE));
+    const glm::vec3 chunkMin = glm::vec3(coord.x * CHUNK_SIZE, coord.y * CHUNK_SIZE, coord.z * CHUNK_SIZE) - halfChunk;
+    const glm::ivec3 local = glm::clamp(glm::ivec3(glm::floor(position - chunkMin)), glm::ivec3(0), glm::ivec3(CHUNK_SIZE - 1));
+    // The chunk gets re-meshed on the next updateChunks()
+    return m_chunkStreamer.setVoxel(coord, local.x, local.y, local.z, type);
+}
+
 void World3D::updateChunks()
 {
-    const int CHUNK_RADIUS = 1;
+    PROFILE_SCOPE("World3D::updateChunks");
     glm::vec3 playerPosition;
     if (Entity* player = m_entityMan.getEntity(m_playerID))
     {
-        playerPosition = player->GetAttributeDataPtr<glm::vec3>("position");
+        playerPosition = player->GetAttributeData(ATTR_POSITION);
     }
-    const Coord3D playerWorldCoord = Coord3D(playerPosition.x / 16.f, playerPosition.y / 16.f, playerPosition.z / 16.f);
+    const Coord3D playerWorldCoord = Coord3D(playerPosition.x / CHUNK_SIZE, playerPosition.y / CHUNK_SIZE, playerPosition.z / CHUNK_SIZE);
     //Log::Debug("Player at coord: %i(%f), %i(%f), %i(%f)", playerWorldCoord.x, playerPosition.x, playerWorldCoord.y, playerPosition.y, playerWorldCoord.z, playerPosition.z);
 
-    std::vector<Coord3D> surroundingChunks;
-    for (int x = -CHUNK_RADIUS; x <= CHUNK_RADIUS; x++)
+    const int cacheSizeMB = std::max(m_options.getOption<int>("w_chunkCacheMB"), 0);
+    const ChunkStreamStats stats = m_chunkStreamer.update(
+        playerWorldCoord,
+        CHUNK_RADIUS,
+        CHUNK_UNLOAD_RADIUS,
+        (size_t)cacheSizeMB * 1024 * 1024,
+        CHUNK_UPLOAD_BUDGET_MS);
+
+    m_statTracker.trackIntValue((int32_t)m_chunkStreamer.getChunks().size(), "Chunks Loaded");
+    m_statTracker.trackIntValue((int32_t)m_chunkStreamer.getNumCachedChunks(), "Chunks Cached");
+    m_statTracker.trackIntValue(stats.chunksEvicted, "Chunks Evicted");
+    m_statTracker.trackIntValue((int32_t)stats.loadedBytes, "Chunk Bytes Loaded");
+    m_statTracker.trackIntValue((int32_t)m_chunkStreamer.getCachedBytes(), "Chunk Bytes Cached");
+}
+
+void World3D::uploadChunk(TerrainChunk& chunk)
+{
+    // Re-meshed chunks keep their draw data, only the collision body of this chunk is replaced
+    if (chunk.drawDataID == 0)
     {
-        for (int y = -CHUNK_RADIUS; y <= CHUNK_RADIUS; y++)
-        {
-            for (int z = -CHUNK_RADIUS; z <= CHUNK_RADIUS; z++)
-            {
-                surroundingChunks.push_back(Coord3D(playerWorldCoord.x + x, playerWorldCoord.y + y, playerWorldCoord.z + z));
-            }
-        }
+        chunk.drawDataID = m_renderer.createVoxelChunkDrawData();
     }
-    for (const Coord3D& coord : surroundingChunks)
+    releaseChunkPhysics(chunk);
+    VoxelChunkVertexData* verts = m_renderer.bufferVoxelChunkVerts(chunk.pendingVertexCount, chunk.drawDataID);
+    memcpy(verts, chunk.pendingVerts, sizeof(VoxelChunkVertexData) * chunk.pendingVertexCount);
+
+    chunk.physicsShapeID = VoxelData::createPhysicsAABBs(m_physics, chunk.aabbs);
+    btCollisionShape* shape = m_physics.getShapeForID(chunk.physicsShapeID);
+    chunk.physicsBodyID = m_physics.createBody(0.f, shape, btVector3(0,0,0));
+    btRigidBody* body = m_physics.getBodyForID(chunk.physicsBodyID);
+    btTransform& trans = body->getWorldTransform();
+
+    const glm::vec3 chunkPosition = glm::vec3(chunk.coord.x * CHUNK_SIZE, chunk.coord.y * CHUNK_SIZE, chunk.coord.z * CHUNK_SIZE);
+    trans.setOrigin(btVector3(chunkPosition.x, chunkPosition.y, chunkPosition.z));
+    m_physics.addBodyToWorld(body, CollisionType::Group_Terrain, CollisionType::Filter_Everything);
+}
+
+void World3D::releaseChunk(TerrainChunk& chunk)
+{
+    releaseChunkPhysics(chunk);
+    if (chunk.drawDataID)
     {
-        if (m_chunks.find(coord) == m_chunks.end())
-        {
-            const glm::vec3 offset = glm::vec3(coord.x * 16, coord.y * 16, coord.z * 16);
+        m_renderer.destroyVoxelChunkDrawData(chunk.drawDataID);
+        chunk.drawDataID = 0;
+    }
+}
 
-            TerrainChunk chunk = { nullptr, 0, 0, 0, 0 };
-            chunk.voxels = CUSTOM_NEW(VoxelData, m_allocator)(16, 16, 16, m_allocator);
-            //chunk.voxels->generateTowerChunk(coord);
-            chunk.voxels->generateFlatLand(coord);
-            if (!chunk.voxels->isEmpty())
-            {
-                const size_t numVoxels = 16 * 16 * 16;
-                VoxelMeshPBRVertexData* tempVerts = (VoxelMeshPBRVertexData*)m_allocator.allocate(sizeof(VoxelMeshPBRVertexData) * numVoxels);
-                chunk.vertexCount = 0;
-                chunk.drawDataID = m_renderer.createVoxelChunkDrawData();
-                chunk.voxels->createTriangleMeshReduced(tempVerts, chunk.vertexCount, 0.5f, offset);
-                VoxelMeshPBRVertexData* verts = m_renderer.bufferVoxelChunkVerts(chunk.vertexCount, chunk.drawDataID);
-                memcpy(verts, tempVerts, sizeof(VoxelMeshPBRVertexData) * chunk.vertexCount);
-                m_allocator.deallocate(tempVerts);
-                
-                chunk.physicsShapeID = chunk.voxels->getPhysicsAABBs(m_physics, glm::vec3(0.5f));
-                btCollisionShape* shape = m_physics.getShapeForID(chunk.physicsShapeID);
-                chunk.physicsBodyID = m_physics.createBody(0.f, shape, btVector3(0,0,0));
-                btRigidBody* body = m_physics.getBodyForID(chunk.physicsBodyID);
-                btTransform& trans = body->getWorldTransform();
-
-                const glm::vec3 chunkPosition = glm::vec3(coord.x * 16, coord.y * 16, coord.z * 16);
-                trans.setOrigin(btVector3(chunkPosition.x, chunkPosition.y, chunkPosition.z));
-                m_physics.addBodyToWorld(body, CollisionType::Group_Terrain, CollisionType::Filter_Everything);
-                Log::Debug("Loading chunk data at coord: %i, %i, %i - verts %i", coord.x, coord.y, coord.z, chunk.vertexCount);
-            }
-            else
-            {
-                Log::Debug("Loading empty chunk data at coord: %i, %i, %i", coord.x, coord.y, coord.z);
-            }
-            m_chunks[coord] = chunk;
-            return;
-        }
+void World3D::releaseChunkPhysics(TerrainChunk& chunk)
+{
+    if (chunk.physicsBodyID)
+    {
+        m_physics.removeBodyFromWorld(m_physics.getBodyForID(chunk.physicsBodyID));
+        m_physics.removeBody(chunk.physicsBodyID);
+        m_physics.removeShape(chunk.physicsShapeID);
+        chunk.physicsBodyID = 0;
+        chunk.physicsShapeID = 0;
     }
 }
 
+void World3D::saveWorld()
+{
+    m_chunkStreamer.storeEditedChunks();
+    m_regionStore.flush();
+    Log::Info("[World3D] Saved world %s", worldName.c_str());
+}
 
+void World3D::loadWorld(const std::string& name)
+{
+    m_chunkStreamer.releaseAll();
+    m_regionStore.close();
+    worldName = name;
+    m_regionStore.open(FileUtil::GetPath() + "Worlds3D/" + worldName + "/");
+    // updateChunks() streams the chunks around the player back in, from the region files where stored
+    Log::Info("[World3D] Loading world %s", worldName.c_str());
+}
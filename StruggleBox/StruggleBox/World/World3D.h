@@ -1,15 +1,22 @@
 #pragma once
 
+#include "ChunkStreamer.h"
 #include "Coord.h"
 #include "Entity.h"
 #include "EntityManager.h"
+#include "Frustum.h"
 #include "GFXHelpers.h"
 #include "ItemComponent.h"
+#include "JobSystem.h"
 #include "Physics.h"
 #include "PhysicsCube.h"
 #include "Particles.h"
 #include "VoxelCache.h"
 #include "Lighting3DDeferred.h"
+#include "MaterialData.h"
+#include "RegionStore.h"
+#include "TaggedAllocator.h"
+#include "VoxelAABB.h"
 #include <map>
 #include <queue>
 #include <string>
@@ -19,9 +26,10 @@
 class Allocator;
 class Options;
 class Shader;
+class StatTracker;
 class VoxelRenderer;
 
-class World3D
+class World3D : public ChunkUploadHandler
 {
 public:
     World3D(
@@ -38,7 +46,7 @@ public:
     void ClearLabels();
     
     void Draw();
-    void DrawObjects();
+    void DrawObjects(const Frustum& frustum);
     
     const int Spawn(std::string filePath, std::string fileName);
     const int SpawnItem(
@@ -62,11 +70,19 @@ public:
     void RemoveDynaCube( PhysicsCube* cube );
 
     void Explosion( const glm::vec3 position, const float radius, const float force );
+
+    // Changes one terrain voxel in a loaded chunk, only that chunk gets re-meshed
+    bool setTerrainVoxel(const glm::vec3& position, const uint8_t type);
     
     Physics& getPhysics() { return m_physics; }
     VoxelCache& getVoxelFactory() { return m_voxelCache; }
     EntityManager& getEntityManager() { return m_entityMan; }
 
+    // Writes every changed chunk to the region files of the current world
+    void saveWorld();
+    // Drops all chunks and streams them from the region files of another world
+    void loadWorld(const std::string& name);
+
     static bool paused;                         // Used to switch off physics updates and freeze world
     static bool physicsEnabled;                 // Enable bullet physics engine
     static float worldTimeScale;                // 1.0 for normal speed, smaller for slo-mo
@@ -83,20 +99,25 @@ public:
     EntityID m_playerID;
 
 private:
-    Allocator& m_allocator;
+    TaggedAllocator m_allocator;
     VoxelRenderer& m_renderer;
 	Options& m_options;
+    JobSystem& m_jobSystem;
+    StatTracker& m_statTracker;
 
 	Particles m_particles;
     Physics m_physics;
     VoxelCache m_voxelCache;
     EntityManager m_entityMan;
+    RegionStore m_regionStore;
 
     ShaderID m_voxelInstancesShaderID;
+    MaterialData m_materialData;
 
     std::vector<PhysicsCube*> dynamicCubes;        // Dynamic cubes with physics
     std::vector<PhysicsCube*> staticCubes;       // Static cubes with physics
     std::vector<int> objectLabels;              // Labeling of nearby objects
+    std::vector<Entity*> m_nearbyEntities;      // Reused for the label query every frame
 
     double m_gameTime;
 
@@ -104,16 +125,18 @@ private:
 
     //CubeInstanceColor* m_lightCubes;
 
-    struct TerrainChunk {
-        VoxelData* voxels;
-        DrawDataID drawDataID;
-        size_t vertexCount;
-        uint32_t physicsShapeID;
-        uint32_t physicsBodyID;
-    };
+    // After the region store, so it's destroyed first
+    ChunkStreamer m_chunkStreamer;
 
-    std::map<Coord3D, TerrainChunk> m_chunks;
+    // Reused by Draw() to cull the chunks every frame
+    std::vector<BoundingBox> m_chunkBounds;
+    std::vector<uint32_t> m_chunkVisibility;
+    std::vector<const TerrainChunk*> m_chunkDrawList;
 
     void updateChunks();
 
+    // ChunkUploadHandler
+    void uploadChunk(TerrainChunk& chunk) override;
+    void releaseChunk(TerrainChunk& chunk) override;
+    void releaseChunkPhysics(TerrainChunk& chunk);
 };
@@ -5,7 +5,7 @@
 #include "Options.h"
 #include "Injector.h"
 #include "SceneManager.h"
-#include "ThreadPool.h"
+#include "JobSystem.h"
 #include "ProxyAllocator.h"
 #include "EngineCore.h"
 #include "RenderCore.h"
@@ -13,14 +13,12 @@
 
 int main(int argc, const char* argv[])
 {
-	 unsigned char* heap = (unsigned char*)malloc(HEAP_SIZE); // This is the heap memory for the entire application
-
-	 EngineCore& core = EngineCore::create(argc, argv, heap);
+	 EngineCore& core = EngineCore::create(argc, argv);
 	 core.setTitle("StruggleBox");
 	 core.initialize();
 
 	 Options& options = core.getGlobalInjector().getInstance<Options>();
-	 ThreadPool& threadPool = core.getGlobalInjector().getInstance<ThreadPool>();
+	 JobSystem& jobSystem = core.getGlobalInjector().getInstance<JobSystem>();
 	 StatTracker& statTracker = core.getGlobalInjector().getInstance<StatTracker>();
 	 RenderCore& renderCore = core.getGlobalInjector().getInstance<RenderCore>();
 
@@ -49,8 +47,6 @@ int main(int argc, const char* argv[])
 	 int result = core.terminate();
 	 EngineCore::destroy(core);
 
-	 free(heap);
-
 	 return result;
 }
 